@@ -0,0 +1,1069 @@
+/*
+ *  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+ *  This file is part of GlusterFS.
+ *
+ *  This file is licensed to you under your choice of the GNU Lesser
+ *  General Public License, version 3 or any later version (LGPLv3 or
+ *  later), or the GNU General Public License, version 2 (GPLv2), in all
+ *  cases as published by the Free Software Foundation.
+ */
+
+/* Completion queue of asynchronous operations
+ *
+ * Every operation submitted to a queue is wound down the graph right away
+ * with the queue's op as cookie. Its callback fills in the completion of
+ * the op and moves the op to the completed list of the queue, from where
+ * glfs_cq_reap() copies the completions out. A pipe is written to when
+ * the completed list becomes non-empty and drained when it is emptied, so
+ * the read end of the pipe polls readable while there is something to
+ * reap.
+ *
+ * Reads hand the caller the iobufs the graph received the data in, held
+ * by the iobref of the reply until glfs_cq_release(). Writes are sent
+ * from iobufs handed out by glfs_buf_get(), referenced by the iobref of
+ * the write for as long as the graph holds on to it.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include "glfs-internal.h"
+#include "glfs-mem-types.h"
+#include "syncop.h"
+#include "glfs.h"
+#include "glfs-handles.h"
+#include "gfapi-messages.h"
+#include "syscall.h"
+
+#define GLFS_CQ_OP_POOL_SIZE    4096
+
+struct glfs_cq {
+        struct glfs             *fs;
+        struct mem_pool         *op_pool;
+
+        pthread_mutex_t          lock;
+        pthread_cond_t           cond;
+        struct list_head         completed;
+        int                      depth;
+        int                      inflight;
+        int                      ncompleted;
+
+        /* readable while there are completions to reap */
+        int                      notify[2];
+        gf_boolean_t             notified;
+};
+
+struct glfs_cq_req {
+        struct list_head         list;
+        struct glfs_cq          *cq;
+        xlator_t                *subvol;
+        struct glfs_fd          *glfd;
+        int                      flags;
+        loc_t                    loc;
+        char                    *name;
+        dict_t                  *xattr_req;
+        uuid_t                   gfid;      /* gfid-req of a lookup */
+        struct iovec             iov;
+        struct iobref           *iobref;
+        struct glfs_cqe          cqe;
+};
+
+
+glfs_cq_t *
+pub_glfs_cq_new (struct glfs *fs, int depth)
+{
+        struct glfs_cq          *cq = NULL;
+        int                      i = 0;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if (depth <= 0) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (fs, invalid_fs);
+
+        cq = GF_CALLOC (1, sizeof (*cq), glfs_mt_cq_t);
+        if (!cq) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        cq->fs = fs;
+        cq->depth = depth;
+        cq->notify[0] = cq->notify[1] = -1;
+        INIT_LIST_HEAD (&cq->completed);
+        pthread_mutex_init (&cq->lock, NULL);
+        pthread_cond_init (&cq->cond, NULL);
+
+        cq->op_pool = mem_pool_new (struct glfs_cq_req,
+                                    min (depth, GLFS_CQ_OP_POOL_SIZE));
+        if (!cq->op_pool) {
+                errno = ENOMEM;
+                goto err;
+        }
+
+        if (pipe (cq->notify))
+                goto err;
+
+        for (i = 0; i < 2; i++) {
+                if (fcntl (cq->notify[i], F_SETFL, O_NONBLOCK) ||
+                    fcntl (cq->notify[i], F_SETFD, FD_CLOEXEC))
+                        goto err;
+        }
+
+        goto out;
+err:
+        if (cq->notify[0] >= 0) {
+                sys_close (cq->notify[0]);
+                sys_close (cq->notify[1]);
+        }
+        if (cq->op_pool)
+                mem_pool_destroy (cq->op_pool);
+        pthread_mutex_destroy (&cq->lock);
+        pthread_cond_destroy (&cq->cond);
+        GF_FREE (cq);
+        cq = NULL;
+out:
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return cq;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_new, 4.0.0);
+
+
+int
+pub_glfs_cq_fd (struct glfs_cq *cq)
+{
+        if (!cq) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        return cq->notify[0];
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_fd, 4.0.0);
+
+
+void
+pub_glfs_cq_release (struct glfs_cqe *cqe)
+{
+        if (!cqe)
+                return;
+
+        GF_FREE (cqe->iov);
+        cqe->iov = NULL;
+        cqe->iovcnt = 0;
+
+        if (cqe->priv) {
+                iobref_unref (cqe->priv);
+                cqe->priv = NULL;
+        }
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_release, 4.0.0);
+
+
+/* Drops the completions nobody reaped */
+static void
+glfs_cq_op_discard (struct glfs_cq_req *op)
+{
+        if (op->cqe.object)
+                glfs_h_close (op->cqe.object);
+        if (op->cqe.fd)
+                glfs_close (op->cqe.fd);
+        pub_glfs_cq_release (&op->cqe);
+
+        mem_put (op);
+}
+
+
+int
+pub_glfs_cq_destroy (struct glfs_cq *cq)
+{
+        struct glfs_cq_req       *op = NULL;
+        struct glfs_cq_req       *tmp = NULL;
+        struct list_head         completed;
+
+        DECLARE_OLD_THIS;
+
+        if (!cq) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (cq->fs, invalid_fs);
+
+        INIT_LIST_HEAD (&completed);
+
+        pthread_mutex_lock (&cq->lock);
+        {
+                while (cq->inflight > 0)
+                        pthread_cond_wait (&cq->cond, &cq->lock);
+
+                list_splice_init (&cq->completed, &completed);
+                cq->ncompleted = 0;
+        }
+        pthread_mutex_unlock (&cq->lock);
+
+        list_for_each_entry_safe (op, tmp, &completed, list) {
+                list_del_init (&op->list);
+                glfs_cq_op_discard (op);
+        }
+
+        sys_close (cq->notify[0]);
+        sys_close (cq->notify[1]);
+        mem_pool_destroy (cq->op_pool);
+        pthread_mutex_destroy (&cq->lock);
+        pthread_cond_destroy (&cq->cond);
+        GF_FREE (cq);
+
+        __GLFS_EXIT_FS;
+
+        return 0;
+
+invalid_fs:
+        return -1;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_destroy, 4.0.0);
+
+
+int
+pub_glfs_cq_reap (struct glfs_cq *cq, struct glfs_cqe *cqes, int max,
+                  int min)
+{
+        struct glfs_cq_req       *op = NULL;
+        int                      count = 0;
+        char                     buf[64];
+
+        if (!cq || !cqes || max <= 0 || min > max) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        pthread_mutex_lock (&cq->lock);
+        {
+                /* Waiting for more than can ever complete would hang */
+                while (cq->ncompleted < min && cq->inflight > 0)
+                        pthread_cond_wait (&cq->cond, &cq->lock);
+
+                while (count < max && !list_empty (&cq->completed)) {
+                        op = list_entry (cq->completed.next,
+                                         struct glfs_cq_req, list);
+                        list_del_init (&op->list);
+                        cq->ncompleted--;
+
+                        cqes[count++] = op->cqe;
+                        mem_put (op);
+                }
+
+                if (cq->ncompleted == 0 && cq->notified) {
+                        while (sys_read (cq->notify[0], buf,
+                                         sizeof (buf)) > 0)
+                                ;
+                        cq->notified = _gf_false;
+                }
+
+                /* room for submissions again */
+                pthread_cond_broadcast (&cq->cond);
+        }
+        pthread_mutex_unlock (&cq->lock);
+
+        return count;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_reap, 4.0.0);
+
+
+/* Takes a slot of the queue for a new op, fails with EAGAIN when the queue
+ * already has @depth ops in flight or waiting to be reaped */
+static struct glfs_cq_req *
+glfs_cq_op_new (struct glfs_cq *cq, int fop, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        gf_boolean_t             full = _gf_false;
+
+        pthread_mutex_lock (&cq->lock);
+        {
+                if (cq->inflight + cq->ncompleted >= cq->depth)
+                        full = _gf_true;
+                else
+                        cq->inflight++;
+        }
+        pthread_mutex_unlock (&cq->lock);
+
+        if (full) {
+                errno = EAGAIN;
+                return NULL;
+        }
+
+        op = mem_get0 (cq->op_pool);
+        if (!op) {
+                pthread_mutex_lock (&cq->lock);
+                {
+                        cq->inflight--;
+                        pthread_cond_broadcast (&cq->cond);
+                }
+                pthread_mutex_unlock (&cq->lock);
+
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        INIT_LIST_HEAD (&op->list);
+        op->cq = cq;
+        op->cqe.op = fop;
+        op->cqe.data = data;
+
+        return op;
+}
+
+
+/* Releases what the op held while it was in flight */
+static void
+glfs_cq_op_cleanup (struct glfs_cq_req *op)
+{
+        loc_wipe (&op->loc);
+        GF_FREE (op->name);
+        op->name = NULL;
+
+        if (op->xattr_req) {
+                dict_unref (op->xattr_req);
+                op->xattr_req = NULL;
+        }
+
+        if (op->iobref) {
+                iobref_unref (op->iobref);
+                op->iobref = NULL;
+        }
+
+        if (op->glfd) {
+                GF_REF_PUT (op->glfd);
+                op->glfd = NULL;
+        }
+
+        if (op->subvol) {
+                glfs_subvol_done (op->cq->fs, op->subvol);
+                op->subvol = NULL;
+        }
+}
+
+
+/* Gives back the slot of an op that could not be submitted */
+static void
+glfs_cq_op_abort (struct glfs_cq_req *op)
+{
+        struct glfs_cq          *cq = op->cq;
+
+        glfs_cq_op_cleanup (op);
+        mem_put (op);
+
+        pthread_mutex_lock (&cq->lock);
+        {
+                cq->inflight--;
+                pthread_cond_broadcast (&cq->cond);
+        }
+        pthread_mutex_unlock (&cq->lock);
+}
+
+
+static void
+glfs_cq_op_done (call_frame_t *frame, struct glfs_cq_req *op, int op_ret,
+                 int op_errno)
+{
+        struct glfs_cq          *cq = op->cq;
+
+        op->cqe.ret = op_ret;
+        op->cqe.op_errno = (op_ret < 0) ? op_errno : 0;
+
+        STACK_DESTROY (frame->root);
+        glfs_cq_op_cleanup (op);
+
+        pthread_mutex_lock (&cq->lock);
+        {
+                list_add_tail (&op->list, &cq->completed);
+                cq->inflight--;
+                cq->ncompleted++;
+
+                if (!cq->notified) {
+                        if (sys_write (cq->notify[1], "", 1) == 1)
+                                cq->notified = _gf_true;
+                }
+
+                pthread_cond_broadcast (&cq->cond);
+        }
+        pthread_mutex_unlock (&cq->lock);
+}
+
+
+/* Resolves the fd of @glfd for an op, holding a ref on @glfd and the
+ * active subvol until the op completes */
+static fd_t *
+glfs_cq_op_resolve_fd (struct glfs_cq_req *op, struct glfs_fd *glfd)
+{
+        fd_t                    *fd = NULL;
+
+        if (glfd->fs != op->cq->fs) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        GF_REF_GET (glfd);
+        op->glfd = glfd;
+
+        op->subvol = glfs_active_subvol (glfd->fs);
+        if (!op->subvol) {
+                errno = EIO;
+                return NULL;
+        }
+
+        fd = glfs_resolve_fd (glfd->fs, op->subvol, glfd);
+        if (!fd)
+                errno = EBADFD;
+
+        return fd;
+}
+
+
+/* Resolves the inode of @object for an op in op->loc, holding the active
+ * subvol until the op completes */
+static int
+glfs_cq_op_resolve_inode (struct glfs_cq_req *op, struct glfs_object *object)
+{
+        inode_t                 *inode = NULL;
+        int                      ret = -1;
+
+        op->subvol = glfs_active_subvol (op->cq->fs);
+        if (!op->subvol) {
+                errno = EIO;
+                return -1;
+        }
+
+        /* get/refresh the in arg objects inode in correlation to the xlator */
+        inode = glfs_resolve_inode (op->cq->fs, op->subvol, object);
+        if (!inode) {
+                errno = ESTALE;
+                return -1;
+        }
+
+        /* populate loc */
+        GLFS_LOC_FILL_INODE (inode, op->loc, out);
+
+        ret = 0;
+out:
+        inode_unref (inode);
+
+        return ret;
+}
+
+
+/* glfd ops */
+
+static int
+glfs_cq_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int op_ret, int op_errno, struct iovec *iovec, int count,
+                   struct iatt *stbuf, struct iobref *iobref, dict_t *xdata)
+{
+        struct glfs_cq_req       *op = cookie;
+
+        if (op->glfd->state == GLFD_CLOSE) {
+                op_ret = -1;
+                op_errno = EBADF;
+        }
+
+        if (op_ret > 0) {
+                op->cqe.iov = iov_dup (iovec, count);
+                if (!op->cqe.iov) {
+                        op_ret = -1;
+                        op_errno = ENOMEM;
+                } else {
+                        op->cqe.iovcnt = count;
+                        op->cqe.priv = iobref_ref (iobref);
+                }
+        }
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_cq_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int op_ret, int op_errno, struct iatt *prebuf,
+                    struct iatt *postbuf, dict_t *xdata)
+{
+        struct glfs_cq_req       *op = cookie;
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_cq_fsync_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int op_ret, int op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf, dict_t *xdata)
+{
+        struct glfs_cq_req       *op = cookie;
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_cq_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int op_ret, int op_errno, struct iatt *iatt,
+                  dict_t *xdata)
+{
+        struct glfs_cq_req       *op = cookie;
+
+        if (op_ret == 0)
+                glfs_iatt_to_stat (op->cq->fs, iatt, &op->cqe.stat);
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+int
+pub_glfs_cq_pread (struct glfs_cq *cq, struct glfs_fd *glfd, size_t count,
+                   off_t offset, int flags, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        fd_t                    *fd = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        if (!cq) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FD (glfd, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_PREAD, data);
+        if (!op)
+                goto out;
+
+        fd = glfs_cq_op_resolve_fd (op, glfd);
+        if (!fd)
+                goto out;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_readv_cbk, op, op->subvol,
+                           op->subvol->fops->readv, fd, count, offset,
+                           flags, NULL);
+
+        ret = 0;
+out:
+        if (fd)
+                fd_unref (fd);
+
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_pread, 4.0.0);
+
+
+int
+pub_glfs_cq_pwrite (struct glfs_cq *cq, struct glfs_fd *glfd,
+                    struct glfs_buf *buf, size_t count, off_t offset,
+                    int flags, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        struct iobuf            *iobuf = (struct iobuf *)buf;
+        call_frame_t            *frame = NULL;
+        fd_t                    *fd = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        if (!cq || !buf || count > iobuf_pagesize (iobuf)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FD (glfd, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_PWRITE, data);
+        if (!op)
+                goto out;
+
+        fd = glfs_cq_op_resolve_fd (op, glfd);
+        if (!fd)
+                goto out;
+
+        op->iobref = iobref_new ();
+        if (!op->iobref) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        if (iobref_add (op->iobref, iobuf)) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        op->iov.iov_base = iobuf_ptr (iobuf);
+        op->iov.iov_len = count;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_writev_cbk, op, op->subvol,
+                           op->subvol->fops->writev, fd, &op->iov, 1, offset,
+                           flags, op->iobref, NULL);
+
+        ret = 0;
+out:
+        if (fd)
+                fd_unref (fd);
+
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_pwrite, 4.0.0);
+
+
+int
+pub_glfs_cq_fsync (struct glfs_cq *cq, struct glfs_fd *glfd, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        fd_t                    *fd = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        if (!cq) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FD (glfd, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_FSYNC, data);
+        if (!op)
+                goto out;
+
+        fd = glfs_cq_op_resolve_fd (op, glfd);
+        if (!fd)
+                goto out;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_fsync_cbk, op, op->subvol,
+                           op->subvol->fops->fsync, fd, 0, NULL);
+
+        ret = 0;
+out:
+        if (fd)
+                fd_unref (fd);
+
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_fsync, 4.0.0);
+
+
+int
+pub_glfs_cq_fstat (struct glfs_cq *cq, struct glfs_fd *glfd, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        fd_t                    *fd = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        if (!cq) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FD (glfd, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_FSTAT, data);
+        if (!op)
+                goto out;
+
+        fd = glfs_cq_op_resolve_fd (op, glfd);
+        if (!fd)
+                goto out;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_stat_cbk, op, op->subvol,
+                           op->subvol->fops->fstat, fd, NULL);
+
+        ret = 0;
+out:
+        if (fd)
+                fd_unref (fd);
+
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_fstat, 4.0.0);
+
+
+/* handle ops */
+
+static int
+glfs_cq_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int op_ret, int op_errno, inode_t *inode,
+                    struct iatt *iatt, dict_t *xdata, struct iatt *parent)
+{
+        struct glfs_cq_req       *op = cookie;
+
+        if (op_ret == 0) {
+                if (glfs_component_link (&op->loc, iatt, &op->cqe.object)) {
+                        op_ret = -1;
+                        op_errno = errno ? errno : EINVAL;
+                } else {
+                        glfs_iatt_to_stat (op->cq->fs, iatt, &op->cqe.stat);
+                }
+        }
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_cq_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int op_ret, int op_errno, fd_t *fd, dict_t *xdata)
+{
+        struct glfs_cq_req       *op = cookie;
+        struct glfs_fd          *glfd = op->glfd;
+
+        if (op_ret == 0) {
+                glfd->fd->flags = op->flags;
+                fd_bind (glfd->fd);
+                glfs_fd_bind (glfd);
+                glfd->state = GLFD_OPEN;
+
+                /* the ref of the new glfd is the caller's now */
+                op->cqe.fd = glfd;
+                op->glfd = NULL;
+        }
+
+        glfs_cq_op_done (frame, op, op_ret, op_errno);
+
+        return 0;
+}
+
+
+int
+pub_glfs_cq_h_lookupat (struct glfs_cq *cq, struct glfs_object *parent,
+                        const char *name, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        inode_t                 *pinode = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if (!cq || !parent || !name) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (cq->fs, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_H_LOOKUPAT, data);
+        if (!op)
+                goto out;
+
+        op->subvol = glfs_active_subvol (cq->fs);
+        if (!op->subvol) {
+                errno = EIO;
+                goto out;
+        }
+
+        /* get/refresh the in arg objects inode in correlation to the xlator */
+        pinode = glfs_resolve_inode (cq->fs, op->subvol, parent);
+        if (!pinode) {
+                errno = ESTALE;
+                goto out;
+        }
+
+        op->name = gf_strdup (name);
+        if (!op->name) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        /* A fresh inode is always looked up, the completion does not get
+         * to revalidate a stale dentry and retry */
+        if (glfs_component_loc_fill (pinode, op->name, _gf_false, &op->loc,
+                                     op->gfid, &op->xattr_req))
+                goto out;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_lookup_cbk, op, op->subvol,
+                           op->subvol->fops->lookup, &op->loc,
+                           op->xattr_req);
+
+        ret = 0;
+out:
+        if (pinode)
+                inode_unref (pinode);
+
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_lookupat, 4.0.0);
+
+
+int
+pub_glfs_cq_h_stat (struct glfs_cq *cq, struct glfs_object *object,
+                    void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if (!cq || !object) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (cq->fs, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_H_STAT, data);
+        if (!op)
+                goto out;
+
+        if (glfs_cq_op_resolve_inode (op, object))
+                goto out;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_stat_cbk, op, op->subvol,
+                           op->subvol->fops->stat, &op->loc, NULL);
+
+        ret = 0;
+out:
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_stat, 4.0.0);
+
+
+int
+pub_glfs_cq_h_open (struct glfs_cq *cq, struct glfs_object *object,
+                    int flags, void *data)
+{
+        struct glfs_cq_req       *op = NULL;
+        call_frame_t            *frame = NULL;
+        inode_t                 *inode = NULL;
+        int                      ret = -1;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if (!cq || !object) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (cq->fs, invalid_fs);
+
+        op = glfs_cq_op_new (cq, GLFS_CQ_OP_H_OPEN, data);
+        if (!op)
+                goto out;
+
+        if (glfs_cq_op_resolve_inode (op, object))
+                goto out;
+        inode = op->loc.inode;
+
+        /* check types to open */
+        if (IA_ISDIR (inode->ia_type)) {
+                errno = EISDIR;
+                goto out;
+        }
+
+        if (!IA_ISREG (inode->ia_type)) {
+                errno = EINVAL;
+                goto out;
+        }
+
+        op->glfd = glfs_fd_new (cq->fs);
+        if (!op->glfd) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        op->glfd->fd = fd_create (inode, getpid());
+        if (!op->glfd->fd) {
+                errno = ENOMEM;
+                goto out;
+        }
+        op->glfd->fd->flags = flags;
+        op->flags = flags;
+
+        frame = syncop_create_frame (THIS);
+        if (!frame) {
+                errno = ENOMEM;
+                goto out;
+        }
+
+        STACK_WIND_COOKIE (frame, glfs_cq_open_cbk, op, op->subvol,
+                           op->subvol->fops->open, &op->loc, flags,
+                           op->glfd->fd, NULL);
+
+        ret = 0;
+out:
+        if (ret && op)
+                glfs_cq_op_abort (op);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_open, 4.0.0);
+
+
+/* buffers to write from */
+
+struct glfs_buf *
+pub_glfs_buf_get (struct glfs *fs, size_t size)
+{
+        struct iobuf            *iobuf = NULL;
+
+        DECLARE_OLD_THIS;
+        __GLFS_ENTRY_VALIDATE_FS (fs, invalid_fs);
+
+        iobuf = iobuf_get2 (fs->ctx->iobuf_pool, size);
+        if (!iobuf)
+                errno = ENOMEM;
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return (struct glfs_buf *)iobuf;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_get, 4.0.0);
+
+
+void *
+pub_glfs_buf_ptr (struct glfs_buf *buf)
+{
+        struct iobuf            *iobuf = (struct iobuf *)buf;
+
+        if (!iobuf) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        return iobuf_ptr (iobuf);
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_ptr, 4.0.0);
+
+
+size_t
+pub_glfs_buf_size (struct glfs_buf *buf)
+{
+        struct iobuf            *iobuf = (struct iobuf *)buf;
+
+        if (!iobuf)
+                return 0;
+
+        return iobuf_pagesize (iobuf);
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_size, 4.0.0);
+
+
+void
+pub_glfs_buf_put (struct glfs_buf *buf)
+{
+        if (buf)
+                iobuf_unref ((struct iobuf *)buf);
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_put, 4.0.0);
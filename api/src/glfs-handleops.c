@@ -2267,3 +2267,592 @@ pub_glfs_h_anonymous_write (struct glfs *fs, struct glfs_object *object,
 }
 
 GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_h_anonymous_write, 3.7.0);
+
+/* Batched handle operations
+ *
+ * The entries of a batch are wound down the graph together, up to
+ * GLFS_BATCH_WINDOW of them at a time, and the caller waits on a barrier
+ * for all of them to unwind, so a batch costs about one round trip per
+ * window instead of one per entry.
+ */
+
+#define GLFS_BATCH_WINDOW       64
+
+struct glfs_batch_entry {
+        loc_t                    loc;
+        struct iatt              iatt;
+        dict_t                  *xattr;
+        dict_t                  *xattr_req;
+        uuid_t                   gfid;      /* gfid-req of a new inode */
+        gf_boolean_t             wind;
+        gf_boolean_t             reval;
+        gf_boolean_t             fallback;
+        int                      op_ret;
+        int                      op_errno;
+        syncbarrier_t           *barrier;
+};
+
+struct glfs_batch {
+        glusterfs_fop_t          fop;
+        const char              *name;
+        syncbarrier_t            barrier;
+        int                      count;
+        struct glfs_batch_entry *entries;
+};
+
+
+static struct glfs_batch *
+glfs_batch_new (glusterfs_fop_t fop, const char *name, int count)
+{
+        struct glfs_batch       *batch = NULL;
+        int                      i = 0;
+
+        batch = GF_CALLOC (1, sizeof (*batch) +
+                           count * sizeof (struct glfs_batch_entry),
+                           glfs_mt_batch_t);
+        if (!batch) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        if (syncbarrier_init (&batch->barrier)) {
+                GF_FREE (batch);
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        batch->fop = fop;
+        batch->name = name;
+        batch->count = count;
+        batch->entries = (struct glfs_batch_entry *)(batch + 1);
+
+        for (i = 0; i < count; i++)
+                batch->entries[i].barrier = &batch->barrier;
+
+        return batch;
+}
+
+
+static void
+glfs_batch_destroy (struct glfs_batch *batch)
+{
+        struct glfs_batch_entry *entry = NULL;
+        int                      i = 0;
+
+        if (!batch)
+                return;
+
+        for (i = 0; i < batch->count; i++) {
+                entry = &batch->entries[i];
+
+                loc_wipe (&entry->loc);
+                if (entry->xattr)
+                        dict_unref (entry->xattr);
+                if (entry->xattr_req)
+                        dict_unref (entry->xattr_req);
+        }
+
+        syncbarrier_destroy (&batch->barrier);
+        GF_FREE (batch);
+}
+
+
+static void
+glfs_batch_entry_fail (struct glfs_batch_entry *entry, int op_errno)
+{
+        entry->wind = _gf_false;
+        entry->op_ret = -1;
+        entry->op_errno = op_errno;
+}
+
+
+static void
+glfs_batch_entry_done (call_frame_t *frame, struct glfs_batch_entry *entry,
+                       int op_ret, int op_errno)
+{
+        entry->op_ret = op_ret;
+        entry->op_errno = (op_ret < 0) ? op_errno : 0;
+
+        STACK_DESTROY (frame->root);
+
+        syncbarrier_wake (entry->barrier);
+}
+
+
+static int
+glfs_batch_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int op_ret, int op_errno, inode_t *inode,
+                       struct iatt *iatt, dict_t *xdata, struct iatt *parent)
+{
+        struct glfs_batch_entry *entry = cookie;
+
+        if (op_ret == 0)
+                entry->iatt = *iatt;
+
+        glfs_batch_entry_done (frame, entry, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_batch_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int op_ret, int op_errno, struct iatt *iatt,
+                     dict_t *xdata)
+{
+        struct glfs_batch_entry *entry = cookie;
+
+        if (op_ret == 0)
+                entry->iatt = *iatt;
+
+        glfs_batch_entry_done (frame, entry, op_ret, op_errno);
+
+        return 0;
+}
+
+
+static int
+glfs_batch_getxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int op_ret, int op_errno, dict_t *dict,
+                         dict_t *xdata)
+{
+        struct glfs_batch_entry *entry = cookie;
+
+        if (op_ret >= 0 && dict)
+                entry->xattr = dict_ref (dict);
+
+        glfs_batch_entry_done (frame, entry, op_ret, op_errno);
+
+        return 0;
+}
+
+
+/* Winds the entries marked to be wound, a window at a time */
+static void
+glfs_batch_wind (xlator_t *subvol, struct glfs_batch *batch)
+{
+        struct glfs_batch_entry *entry = NULL;
+        call_frame_t            *frame = NULL;
+        int                      next = 0;
+        int                      wound = 0;
+
+        while (next < batch->count) {
+                wound = 0;
+
+                for (; next < batch->count && wound < GLFS_BATCH_WINDOW;
+                     next++) {
+                        entry = &batch->entries[next];
+                        if (!entry->wind)
+                                continue;
+
+                        frame = syncop_create_frame (THIS);
+                        if (!frame) {
+                                glfs_batch_entry_fail (entry, ENOMEM);
+                                continue;
+                        }
+
+                        wound++;
+
+                        switch (batch->fop) {
+                        case GF_FOP_LOOKUP:
+                                STACK_WIND_COOKIE (frame,
+                                                   glfs_batch_lookup_cbk,
+                                                   entry, subvol,
+                                                   subvol->fops->lookup,
+                                                   &entry->loc,
+                                                   entry->xattr_req);
+                                break;
+                        case GF_FOP_STAT:
+                                STACK_WIND_COOKIE (frame,
+                                                   glfs_batch_stat_cbk,
+                                                   entry, subvol,
+                                                   subvol->fops->stat,
+                                                   &entry->loc, NULL);
+                                break;
+                        case GF_FOP_GETXATTR:
+                                STACK_WIND_COOKIE (frame,
+                                                   glfs_batch_getxattr_cbk,
+                                                   entry, subvol,
+                                                   subvol->fops->getxattr,
+                                                   &entry->loc, batch->name,
+                                                   NULL);
+                                break;
+                        default:
+                                break;
+                        }
+                }
+
+                if (wound)
+                        syncbarrier_wait (&batch->barrier, wound);
+        }
+}
+
+
+/* Fills the loc of an entry on an object, as GLFS_LOC_FILL_INODE does */
+static void
+glfs_batch_entry_fill_inode (struct glfs *fs, xlator_t *subvol,
+                             struct glfs_batch_entry *entry,
+                             struct glfs_object *object)
+{
+        inode_t                 *inode = NULL;
+
+        if (!object) {
+                glfs_batch_entry_fail (entry, EINVAL);
+                return;
+        }
+
+        inode = glfs_resolve_inode (fs, subvol, object);
+        if (!inode) {
+                glfs_batch_entry_fail (entry, ESTALE);
+                return;
+        }
+
+        entry->loc.inode = inode;
+        gf_uuid_copy (entry->loc.gfid, inode->gfid);
+        if (glfs_loc_touchup (&entry->loc) != 0) {
+                glfs_batch_entry_fail (entry, EINVAL);
+                return;
+        }
+
+        entry->wind = _gf_true;
+}
+
+
+/* Fills @loc to look up @name in @parent, as glfs_resolve_component does.
+ * With @reval an inode already linked to the name is revalidated, else a
+ * new inode is looked up with a gfid-req in @xattr_req. The gfid-req is
+ * not copied into the dict, @gfid has to stay around until the lookup
+ * unwinds. Only a single component other than "." and ".." can be looked
+ * up this way, it fails with EINVAL for any other name. */
+int
+glfs_component_loc_fill (inode_t *parent, const char *name,
+                         gf_boolean_t reval, loc_t *loc, uuid_t gfid,
+                         dict_t **xattr_req)
+{
+        if (!parent || !name || *name == '\0' || strchr (name, '/') ||
+            strcmp (name, ".") == 0 || strcmp (name, "..") == 0) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        loc->name = name;
+        loc->parent = inode_ref (parent);
+        gf_uuid_copy (loc->pargfid, parent->gfid);
+
+        if (reval)
+                loc->inode = inode_grep (parent->table, parent, name);
+
+        if (loc->inode) {
+                gf_uuid_copy (loc->gfid, loc->inode->gfid);
+        } else {
+                loc->inode = inode_new (parent->table);
+                *xattr_req = dict_new ();
+                if (!loc->inode || !*xattr_req) {
+                        errno = ENOMEM;
+                        return -1;
+                }
+
+                gf_uuid_generate (gfid);
+                if (dict_set_static_bin (*xattr_req, "gfid-req", gfid, 16)) {
+                        errno = ENOMEM;
+                        return -1;
+                }
+        }
+
+        if (glfs_loc_touchup (loc) < 0) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        return 0;
+}
+
+
+/* Links the inode of @loc looked up by glfs_component_loc_fill and
+ * creates its object */
+int
+glfs_component_link (loc_t *loc, struct iatt *iatt,
+                     struct glfs_object **object)
+{
+        inode_t                 *inode = NULL;
+        uint64_t                 ctx_value = LOOKUP_NOT_NEEDED;
+
+        inode = inode_link (loc->inode, loc->parent, loc->name, iatt);
+        if (!inode) {
+                gf_msg (THIS->name, GF_LOG_WARNING, errno,
+                        API_MSG_INODE_LINK_FAILED,
+                        "inode linking of %s failed",
+                        uuid_utoa ((unsigned char *)&iatt->ia_gfid));
+                return -1;
+        }
+
+        if (inode == loc->inode)
+                inode_ctx_set (inode, THIS, &ctx_value);
+        inode_lookup (inode);
+
+        inode_unref (loc->inode);
+        loc->inode = inode;
+
+        return glfs_create_object (loc, object);
+}
+
+
+int
+pub_glfs_h_lookupat_batch (struct glfs *fs, struct glfs_object *parent,
+                           const char *names[], int count,
+                           struct glfs_object *objects[], struct stat *stats,
+                           int *errnos, int follow)
+{
+        int                      ret = -1;
+        int                      i = 0;
+        xlator_t                *subvol = NULL;
+        inode_t                 *pinode = NULL;
+        struct glfs_batch       *batch = NULL;
+        struct glfs_batch_entry *entry = NULL;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if ((names == NULL) || (objects == NULL) || (errnos == NULL) ||
+            (count < 0)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (fs, invalid_fs);
+
+        /* get the active volume */
+        subvol = glfs_active_subvol (fs);
+        if (!subvol) {
+                errno = EIO;
+                goto out;
+        }
+
+        /* get/refresh the in arg objects inode in correlation to the xlator */
+        if (parent) {
+                pinode = glfs_resolve_inode (fs, subvol, parent);
+                if (!pinode) {
+                        errno = ESTALE;
+                        goto out;
+                }
+        }
+
+        batch = glfs_batch_new (GF_FOP_LOOKUP, NULL, count);
+        if (!batch)
+                goto out;
+
+        /* Names which are not a single component are left to
+         * glfs_h_lookupat */
+        for (i = 0; i < count; i++) {
+                objects[i] = NULL;
+                entry = &batch->entries[i];
+
+                if (glfs_component_loc_fill (pinode, names[i], _gf_true,
+                                             &entry->loc, entry->gfid,
+                                             &entry->xattr_req)) {
+                        if (errno == EINVAL)
+                                entry->fallback = _gf_true;
+                        else
+                                glfs_batch_entry_fail (entry, errno);
+                        continue;
+                }
+
+                entry->reval = (entry->xattr_req == NULL);
+                entry->wind = _gf_true;
+        }
+
+        /* fop/op */
+        glfs_batch_wind (subvol, batch);
+
+        /* populate out args */
+        ret = 0;
+        for (i = 0; i < count; i++) {
+                entry = &batch->entries[i];
+
+                /* Names which are not a single component, a dentry gone
+                 * stale in the inode table and symlinks to be followed
+                 * are resolved one at a time */
+                if (entry->fallback ||
+                    (entry->op_ret < 0 && entry->reval) ||
+                    (entry->op_ret == 0 && follow &&
+                     entry->iatt.ia_type == IA_IFLNK)) {
+                        objects[i] = pub_glfs_h_lookupat (fs, parent,
+                                                          names[i],
+                                                          stats ?
+                                                          &stats[i] : NULL,
+                                                          follow);
+                        errnos[i] = objects[i] ? 0 : errno;
+                } else if (entry->op_ret < 0) {
+                        errnos[i] = entry->op_errno;
+                } else if (glfs_component_link (&entry->loc, &entry->iatt,
+                                                &objects[i])) {
+                        errnos[i] = errno ? errno : EINVAL;
+                } else {
+                        if (stats)
+                                glfs_iatt_to_stat (fs, &entry->iatt,
+                                                   &stats[i]);
+                        errnos[i] = 0;
+                }
+
+                if (!errnos[i])
+                        ret++;
+        }
+
+out:
+        glfs_batch_destroy (batch);
+
+        if (pinode)
+                inode_unref (pinode);
+
+        glfs_subvol_done (fs, subvol);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_h_lookupat_batch, 4.0.0);
+
+
+int
+pub_glfs_h_stat_batch (struct glfs *fs, struct glfs_object *objects[],
+                       int count, struct stat *stats, int *errnos)
+{
+        int                      ret = -1;
+        int                      i = 0;
+        xlator_t                *subvol = NULL;
+        struct glfs_batch       *batch = NULL;
+        struct glfs_batch_entry *entry = NULL;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if ((objects == NULL) || (errnos == NULL) || (count < 0)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (fs, invalid_fs);
+
+        /* get the active volume */
+        subvol = glfs_active_subvol (fs);
+        if (!subvol) {
+                errno = EIO;
+                goto out;
+        }
+
+        batch = glfs_batch_new (GF_FOP_STAT, NULL, count);
+        if (!batch)
+                goto out;
+
+        for (i = 0; i < count; i++)
+                glfs_batch_entry_fill_inode (fs, subvol, &batch->entries[i],
+                                             objects[i]);
+
+        /* fop/op */
+        glfs_batch_wind (subvol, batch);
+
+        /* populate out args */
+        ret = 0;
+        for (i = 0; i < count; i++) {
+                entry = &batch->entries[i];
+
+                errnos[i] = (entry->op_ret < 0) ? entry->op_errno : 0;
+                if (errnos[i])
+                        continue;
+
+                if (stats)
+                        glfs_iatt_to_stat (fs, &entry->iatt, &stats[i]);
+                ret++;
+        }
+
+out:
+        glfs_batch_destroy (batch);
+
+        glfs_subvol_done (fs, subvol);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_h_stat_batch, 4.0.0);
+
+
+int
+pub_glfs_h_getxattrs_batch (struct glfs *fs, struct glfs_object *objects[],
+                            int count, const char *name, void *values[],
+                            size_t size, ssize_t *lens, int *errnos)
+{
+        int                      ret = -1;
+        int                      i = 0;
+        xlator_t                *subvol = NULL;
+        struct glfs_batch       *batch = NULL;
+        struct glfs_batch_entry *entry = NULL;
+
+        DECLARE_OLD_THIS;
+
+        /* validate in args */
+        if ((objects == NULL) || (values == NULL) || (lens == NULL) ||
+            (errnos == NULL) || (count < 0) || !name || *name == '\0') {
+                errno = EINVAL;
+                return -1;
+        }
+
+        if (strlen (name) > GF_XATTR_NAME_MAX) {
+                errno = ENAMETOOLONG;
+                return -1;
+        }
+
+        __GLFS_ENTRY_VALIDATE_FS (fs, invalid_fs);
+
+        /* get the active volume */
+        subvol = glfs_active_subvol (fs);
+        if (!subvol) {
+                errno = EIO;
+                goto out;
+        }
+
+        batch = glfs_batch_new (GF_FOP_GETXATTR, name, count);
+        if (!batch)
+                goto out;
+
+        for (i = 0; i < count; i++)
+                glfs_batch_entry_fill_inode (fs, subvol, &batch->entries[i],
+                                             objects[i]);
+
+        /* fop/op */
+        glfs_batch_wind (subvol, batch);
+
+        /* populate out args */
+        ret = 0;
+        for (i = 0; i < count; i++) {
+                entry = &batch->entries[i];
+                lens[i] = -1;
+
+                if (entry->op_ret < 0) {
+                        errnos[i] = entry->op_errno;
+                        continue;
+                }
+
+                lens[i] = glfs_getxattr_process (values[i], size,
+                                                 entry->xattr, name);
+                errnos[i] = (lens[i] < 0) ? errno : 0;
+                if (!errnos[i])
+                        ret++;
+        }
+
+out:
+        glfs_batch_destroy (batch);
+
+        glfs_subvol_done (fs, subvol);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_h_getxattrs_batch, 4.0.0);
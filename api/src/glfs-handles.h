@@ -320,6 +320,73 @@ glfs_h_anonymous_read (struct glfs *fs, struct glfs_object *object,
                       const void *buf, size_t count, off_t offset) __THROW
         GFAPI_PUBLIC(glfs_h_anonymous_read, 3.7.0);
 
+/*
+  SYNOPSIS
+
+  glfs_h_lookupat_batch, glfs_h_stat_batch, glfs_h_getxattrs_batch:
+  Batched variants of glfs_h_lookupat, glfs_h_stat and glfs_h_getxattrs.
+
+  DESCRIPTION
+
+  These APIs do the same as their single object counterparts for @count
+  names or objects at once. The operations on the entries are sent down
+  the graph concurrently, so a batch costs about one round trip instead
+  of @count of them. Every entry gets its own result.
+
+  glfs_h_lookupat_batch looks up each of @names in @parent, and returns the
+  handle of each in @objects and, if @stats is not NULL, its attributes
+  in @stats. Names of more than one component are resolved one at a time.
+
+  glfs_h_getxattrs_batch gets the xattr @name of each of @objects in the
+  buffer of @size bytes at @values[i], and its length in @lens[i].
+
+  PARAMETERS
+
+  @errnos: Array of @count, set to 0 for the entries that succeeded, or to
+           the errno the entry failed with.
+
+  RETURN VALUES
+
+  >= 0 : Number of entries that succeeded.
+  -1   : The batch could not be issued, errno is set.
+
+*/
+
+int
+glfs_h_lookupat_batch (struct glfs *fs, struct glfs_object *parent,
+                       const char *names[], int count,
+                       struct glfs_object *objects[], struct stat *stats,
+                       int *errnos, int follow) __THROW
+        GFAPI_PUBLIC(glfs_h_lookupat_batch, 4.0.0);
+
+int
+glfs_h_stat_batch (struct glfs *fs, struct glfs_object *objects[],
+                   int count, struct stat *stats, int *errnos) __THROW
+        GFAPI_PUBLIC(glfs_h_stat_batch, 4.0.0);
+
+int
+glfs_h_getxattrs_batch (struct glfs *fs, struct glfs_object *objects[],
+                        int count, const char *name, void *values[],
+                        size_t size, ssize_t *lens, int *errnos) __THROW
+        GFAPI_PUBLIC(glfs_h_getxattrs_batch, 4.0.0);
+
+/* Completion queue submissions of handle operations, see glfs_cq_new() in
+ * glfs.h. glfs_cq_h_lookupat only looks up a single component @name. */
+int
+glfs_cq_h_lookupat (glfs_cq_t *cq, struct glfs_object *parent,
+                    const char *name, void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_h_lookupat, 4.0.0);
+
+int
+glfs_cq_h_stat (glfs_cq_t *cq, struct glfs_object *object,
+                void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_h_stat, 4.0.0);
+
+int
+glfs_cq_h_open (glfs_cq_t *cq, struct glfs_object *object, int flags,
+                void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_h_open, 4.0.0);
+
 __END_DECLS
 
 #endif /* !_GLFS_HANDLES_H */
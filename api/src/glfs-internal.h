@@ -353,6 +353,11 @@ int glfs_loc_unlink (loc_t *loc);
 dict_t *dict_for_key_value (const char *name, const char *value, size_t size);
 int glfs_getxattr_process (void *value, size_t size, dict_t *xattr,
 			   const char *name);
+int glfs_component_loc_fill (inode_t *parent, const char *name,
+                             gf_boolean_t reval, loc_t *loc, uuid_t gfid,
+                             dict_t **xattr_req);
+int glfs_component_link (loc_t *loc, struct iatt *iatt,
+                         struct glfs_object **object);
 
 /* Sends RPC call to glusterd to fetch required volume info */
 int glfs_get_volume_info (struct glfs *fs);
@@ -27,6 +27,8 @@ enum glfs_mem_types_ {
 	glfs_mt_readdirbuf_t,
         glfs_mt_upcall_entry_t,
 	glfs_mt_acl_t,
+        glfs_mt_batch_t,
+        glfs_mt_cq_t,
 	glfs_mt_end
 };
 #endif
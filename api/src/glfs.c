@@ -40,6 +40,7 @@
 #include "common-utils.h"
 #include "syncop.h"
 #include "call-stub.h"
+#include "cache-budget.h"
 #include "gfapi-messages.h"
 
 #include "glfs.h"
@@ -1066,6 +1067,9 @@ glusterfs_ctx_destroy (glusterfs_ctx_t *ctx)
         if (ctx->cmd_args.curr_server)
                 glfs_free_volfile_servers (&ctx->cmd_args);
 
+        /* stop the cache reclaimer before the xlators go away */
+        gf_cache_budget_destroy (ctx);
+
         /* For all the graphs, crawl through the xlator_t structs and free
          * all its members except for the mem_acct member,
          * as GF_FREE will be referencing it.
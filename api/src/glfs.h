@@ -773,6 +773,121 @@ glfs_fd_t *glfs_dup (glfs_fd_t *fd) __THROW
 int glfs_ipc (glfs_fd_t *fd, int cmd,  void *xd_in, void **xd_out) __THROW
         GFAPI_PUBLIC(glfs_ipc, 4.0.0);
 
+/*
+  SYNOPSIS
+
+  glfs_cq_*: Completion queue of asynchronous operations.
+
+  DESCRIPTION
+
+  A completion queue lets the caller keep many operations in flight without
+  a callback per operation. Operations are submitted to the queue with the
+  glfs_cq_*() calls below, and glfs_cq_h_*() in glfs-handles.h, which return
+  as soon as the operation is sent down the graph. Their completions are
+  collected with glfs_cq_reap(). The descriptor returned by glfs_cq_fd()
+  polls readable while there are completions to reap, and must not be read
+  or closed by the caller.
+
+  Up to @depth operations can be in flight or waiting to be reaped, a
+  submission beyond that fails with EAGAIN.
+
+  Reads complete without a copy: @iov of the completion points at the
+  buffers the data was received in, which stay valid until
+  glfs_cq_release() is called on the completion. Writes are sent without a
+  copy from a buffer got with glfs_buf_get(). Once submitted, a buffer
+  must never be changed again, not even after the write completes: write
+  caching in the graph may complete the write and send the same buffer to
+  the bricks later. It can only be put back with glfs_buf_put(), right
+  after the submission or later, and new data is written from a new
+  buffer.
+
+  glfs_cq_destroy() waits for the operations in flight, and releases the
+  completions, handles and fds that were not reaped.
+
+  RETURN VALUES
+
+  glfs_cq_reap() waits for at least @min completions, or for all the
+  operations in flight if fewer, and returns the number of completions
+  copied to @cqes, up to @max. The submissions return 0, or -1 with errno
+  set if the operation could not be submitted.
+
+*/
+
+struct glfs_cq;
+typedef struct glfs_cq glfs_cq_t;
+
+/* Buffer to write from without a copy */
+struct glfs_buf;
+typedef struct glfs_buf glfs_buf_t;
+
+struct glfs_object;
+
+enum glfs_cq_op {
+        GLFS_CQ_OP_PREAD = 1,
+        GLFS_CQ_OP_PWRITE,
+        GLFS_CQ_OP_FSYNC,
+        GLFS_CQ_OP_FSTAT,
+        GLFS_CQ_OP_H_LOOKUPAT,
+        GLFS_CQ_OP_H_STAT,
+        GLFS_CQ_OP_H_OPEN,
+};
+
+struct glfs_cqe {
+        void                    *data;     /* as passed to the submission */
+        int                      op;       /* GLFS_CQ_OP_* */
+        ssize_t                  ret;      /* as of the synchronous call */
+        int                      op_errno; /* errno of the op if @ret is -1 */
+        struct stat              stat;     /* fstat, h_lookupat, h_stat */
+        struct iovec            *iov;      /* pread, till glfs_cq_release */
+        int                      iovcnt;
+        struct glfs_object      *object;   /* h_lookupat */
+        glfs_fd_t               *fd;       /* h_open */
+        void                    *priv;     /* do not touch */
+};
+
+glfs_cq_t *glfs_cq_new (glfs_t *fs, int depth) __THROW
+        GFAPI_PUBLIC(glfs_cq_new, 4.0.0);
+
+int glfs_cq_destroy (glfs_cq_t *cq) __THROW
+        GFAPI_PUBLIC(glfs_cq_destroy, 4.0.0);
+
+int glfs_cq_fd (glfs_cq_t *cq) __THROW
+        GFAPI_PUBLIC(glfs_cq_fd, 4.0.0);
+
+int glfs_cq_reap (glfs_cq_t *cq, struct glfs_cqe *cqes, int max,
+                  int min) __THROW
+        GFAPI_PUBLIC(glfs_cq_reap, 4.0.0);
+
+void glfs_cq_release (struct glfs_cqe *cqe) __THROW
+        GFAPI_PUBLIC(glfs_cq_release, 4.0.0);
+
+int glfs_cq_pread (glfs_cq_t *cq, glfs_fd_t *fd, size_t count, off_t offset,
+                   int flags, void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_pread, 4.0.0);
+
+int glfs_cq_pwrite (glfs_cq_t *cq, glfs_fd_t *fd, glfs_buf_t *buf,
+                    size_t count, off_t offset, int flags,
+                    void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_pwrite, 4.0.0);
+
+int glfs_cq_fsync (glfs_cq_t *cq, glfs_fd_t *fd, void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_fsync, 4.0.0);
+
+int glfs_cq_fstat (glfs_cq_t *cq, glfs_fd_t *fd, void *data) __THROW
+        GFAPI_PUBLIC(glfs_cq_fstat, 4.0.0);
+
+glfs_buf_t *glfs_buf_get (glfs_t *fs, size_t size) __THROW
+        GFAPI_PUBLIC(glfs_buf_get, 4.0.0);
+
+void *glfs_buf_ptr (glfs_buf_t *buf) __THROW
+        GFAPI_PUBLIC(glfs_buf_ptr, 4.0.0);
+
+size_t glfs_buf_size (glfs_buf_t *buf) __THROW
+        GFAPI_PUBLIC(glfs_buf_size, 4.0.0);
+
+void glfs_buf_put (glfs_buf_t *buf) __THROW
+        GFAPI_PUBLIC(glfs_buf_put, 4.0.0);
+
 __END_DECLS
 
 #endif /* !_GLFS_H */
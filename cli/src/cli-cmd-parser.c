@@ -5175,7 +5175,8 @@ cli_cmd_bitrot_parse (const char **words, int wordcount, dict_t **options)
         char               *opwords[]             = {"enable", "disable",
                                                      "scrub-throttle",
                                                      "scrub-frequency", "scrub",
-                                                     "signing-time", NULL};
+                                                     "signing-time",
+                                                     "scrub-rate", NULL};
         char               *scrub_throt_values[]  = {"lazy", "normal",
                                                      "aggressive", NULL};
         char               *scrub_freq_values[]   = {"hourly",
@@ -5187,6 +5188,7 @@ cli_cmd_bitrot_parse (const char **words, int wordcount, dict_t **options)
         dict_t             *dict                  = NULL;
         gf_bitrot_type     type                   = GF_BITROT_OPTION_TYPE_NONE;
         int32_t            expiry_time            = 0;
+        uint64_t           scrub_rate             = 0;
 
         GF_ASSERT (words);
         GF_ASSERT (options);
@@ -5330,6 +5332,31 @@ cli_cmd_bitrot_parse (const char **words, int wordcount, dict_t **options)
                 }
         }
 
+        if (!strcmp (words[3], "scrub-rate")) {
+                if (!words[4]) {
+                        cli_err ("Missing scrub-rate value for bitrot option");
+                        ret = -1;
+                        goto out;
+                }
+
+                if (gf_string2bytesize_uint64 (words[4], &scrub_rate)) {
+                        cli_err ("Invalid scrub-rate value %s for bitrot, "
+                                 "expected bytes per second (0 for no limit)",
+                                 words[4]);
+                        ret = -1;
+                        goto out;
+                }
+
+                type = GF_BITROT_OPTION_TYPE_SCRUB_RATE;
+                ret = dict_set_str (dict, "scrub-rate-value",
+                                    (char *) words[4]);
+                if (ret) {
+                        cli_out ("Failed to set dict for bitrot");
+                        goto out;
+                }
+                goto set_type;
+        }
+
         if (!strcmp (words[3], "signing-time")) {
                 if (!words[4]) {
                         cli_err ("Missing signing-time value for bitrot "
@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# changelog-bm: rate of file creates on a volume with changelog off and on
+#
+# A number of processes create empty files in a directory of their own on a
+# mount of the volume, first with changelog off and then with it on. The
+# creates/sec of both runs are reported, and changelog is set back to what
+# it was. The gluster command can be overridden with $GLUSTER.
+
+GLUSTER=${GLUSTER:-gluster}
+
+procs=8
+files=2000
+
+function usage () {
+        echo "usage: $0 [-p procs] [-n files-per-proc] <volume> <mountpoint>" >&2
+        exit 1
+}
+
+while getopts "p:n:" opt; do
+        case $opt in
+        p) procs=$OPTARG ;;
+        n) files=$OPTARG ;;
+        *) usage ;;
+        esac
+done
+shift $((OPTIND - 1))
+
+[ $# -eq 2 ] || usage
+volume=$1
+mountpoint=$2
+
+function create_files () {
+        local dir=$1
+        local i
+
+        mkdir -p $dir
+        for i in $(seq 1 $files); do
+                : > $dir/f$i || return 1
+        done
+}
+
+function run () {
+        local state=$1
+        local dir=$mountpoint/changelog-bm.$state
+        local pids=""
+        local failed=0
+        local start end p
+
+        $GLUSTER volume set $volume changelog.changelog $state > /dev/null ||
+                return 1
+
+        mkdir -p $dir
+        start=$(date +%s.%N)
+        for p in $(seq 1 $procs); do
+                create_files $dir/p$p &
+                pids="$pids $!"
+        done
+        for p in $pids; do
+                wait $p || failed=1
+        done
+        end=$(date +%s.%N)
+
+        rm -rf $dir
+        [ $failed -eq 0 ] || return 1
+
+        awk -v n=$((procs * files)) -v s=$start -v e=$end -v state=$state \
+            'BEGIN { printf "changelog %s: %.0f creates/sec\n", state,
+                     n / (e - s) }'
+}
+
+saved=$($GLUSTER volume get $volume changelog.changelog |
+        awk '$1 == "changelog.changelog" { print $2 }')
+
+run off && run on
+ret=$?
+
+[ -n "$saved" ] &&
+        $GLUSTER volume set $volume changelog.changelog $saved > /dev/null
+
+exit $ret
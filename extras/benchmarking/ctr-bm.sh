@@ -0,0 +1,90 @@
+#!/bin/bash
+
+# ctr-bm: rate of small writes and reads on a volume with CTR off and on
+#
+# A number of processes each write a file of their own on a mount of the
+# volume in 4KB blocks and read it back, first with CTR off, then with CTR
+# recording every fop in its database (features.ctr-db-sync sync) and then
+# with CTR gathering the heat in memory (features.ctr-db-sync async). The
+# fops/sec of the three runs are reported, and the options are set back to
+# what they were. Turn performance.write-behind and the read caches off for
+# every block to be a fop on the bricks. The gluster command can be
+# overridden with $GLUSTER.
+
+GLUSTER=${GLUSTER:-gluster}
+
+procs=8
+blocks=10000
+
+function usage () {
+        echo "usage: $0 [-p procs] [-n blocks-per-proc] <volume> <mountpoint>" >&2
+        exit 1
+}
+
+while getopts "p:n:" opt; do
+        case $opt in
+        p) procs=$OPTARG ;;
+        n) blocks=$OPTARG ;;
+        *) usage ;;
+        esac
+done
+shift $((OPTIND - 1))
+
+[ $# -eq 2 ] || usage
+volume=$1
+mountpoint=$2
+
+function volume_get () {
+        $GLUSTER volume get $volume $1 | awk -v key=$1 '$1 == key { print $2 }'
+}
+
+function write_read () {
+        local file=$1
+
+        dd if=/dev/zero of=$file bs=4k count=$blocks 2> /dev/null &&
+        dd if=$file of=/dev/null bs=4k 2> /dev/null
+}
+
+function run () {
+        local name=$1
+        local ctr=$2
+        local sync=$3
+        local dir=$mountpoint/ctr-bm.$name
+        local pids=""
+        local failed=0
+        local start end p
+
+        $GLUSTER volume set $volume features.ctr-enabled $ctr > /dev/null &&
+        $GLUSTER volume set $volume features.ctr-db-sync $sync > /dev/null ||
+                return 1
+
+        mkdir -p $dir
+        start=$(date +%s.%N)
+        for p in $(seq 1 $procs); do
+                write_read $dir/p$p &
+                pids="$pids $!"
+        done
+        for p in $pids; do
+                wait $p || failed=1
+        done
+        end=$(date +%s.%N)
+
+        rm -rf $dir
+        [ $failed -eq 0 ] || return 1
+
+        awk -v n=$((2 * procs * blocks)) -v s=$start -v e=$end -v name=$name \
+            'BEGIN { printf "ctr %s: %.0f fops/sec\n", name, n / (e - s) }'
+}
+
+saved_ctr=$(volume_get features.ctr-enabled)
+saved_sync=$(volume_get features.ctr-db-sync)
+
+run off off async && run sync on sync && run async on async
+ret=$?
+
+[ -n "$saved_ctr" ] &&
+        $GLUSTER volume set $volume features.ctr-enabled $saved_ctr > /dev/null
+[ -n "$saved_sync" ] &&
+        $GLUSTER volume set $volume features.ctr-db-sync $saved_sync > /dev/null
+
+exit $ret
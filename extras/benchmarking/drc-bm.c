@@ -0,0 +1,277 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+ * drc-bm: duplicate request cache benchmark
+ *
+ * A number of threads, each one posing as a different NFS client, run
+ * requests through the duplicate request cache of the RPC library the way
+ * the gNFS server does: a lookup which caches the request as in transit,
+ * followed by caching its reply. Every thread then retransmits all of its
+ * requests which are looked up again. The rates of both passes, and the
+ * number of retransmissions which found their reply, are reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "iobuf.h"
+#include "rpcsvc.h"
+#include "rpc-drc.h"
+
+struct drc_bm_config {
+        int       threads;
+        long      ops;
+        uint32_t  size;
+        char     *mem_limit;
+        size_t    reply_size;
+};
+
+struct drc_bm_thread {
+        pthread_t              tid;
+        int                    id;
+        struct drc_bm_config  *conf;
+        rpcsvc_t              *svc;
+        glusterfs_ctx_t       *ctx;
+        double                 insert_secs;
+        double                 lookup_secs;
+        long                   hits;
+        int                    failed;
+};
+
+static double
+drc_bm_now (void)
+{
+        struct timeval tv = {0, };
+
+        gettimeofday (&tv, NULL);
+
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void *
+drc_bm_run (void *data)
+{
+        struct drc_bm_thread  *thr       = data;
+        rpc_transport_t        trans     = {0, };
+        rpcsvc_request_t       req       = {0, };
+        drc_cached_op_t       *reply     = NULL;
+        struct iobref         *iobref    = NULL;
+        struct iobuf          *iobuf     = NULL;
+        struct iovec           hdr       = {0, };
+        struct sockaddr_in    *sin       = NULL;
+        char                   args[64]  = {0, };
+        long                   i         = 0;
+        double                 t0        = 0;
+
+        THIS->ctx = thr->ctx;
+
+        sin = (struct sockaddr_in *)&trans.peerinfo.sockaddr;
+        sin->sin_family = AF_INET;
+        sin->sin_addr.s_addr = htonl (INADDR_LOOPBACK + thr->id);
+        sin->sin_port = htons (800 + thr->id);
+
+        req.svc = thr->svc;
+        req.trans = &trans;
+        req.prognum = 100003;
+        req.progver = 3;
+        req.procnum = 7;
+        req.msg[0].iov_base = args;
+        req.msg[0].iov_len = sizeof (args);
+        req.count = 1;
+
+        t0 = drc_bm_now ();
+        for (i = 0; i < thr->conf->ops; i++) {
+                req.xid = i;
+                req.reply = NULL;
+                snprintf (args, sizeof (args), "%d:%ld", thr->id, i);
+
+                reply = rpcsvc_drc_lookup (&req);
+                if (reply) {
+                        rpcsvc_drc_op_unref (thr->svc->drc, reply);
+                        continue;
+                }
+                if (!req.reply) {
+                        thr->failed = 1;
+                        break;
+                }
+
+                iobref = iobref_new ();
+                iobuf = iobuf_get2 (thr->ctx->iobuf_pool,
+                                    thr->conf->reply_size);
+                if (!iobref || !iobuf) {
+                        thr->failed = 1;
+                        break;
+                }
+                iobref_add (iobref, iobuf);
+                hdr.iov_base = iobuf->ptr;
+                hdr.iov_len = thr->conf->reply_size;
+
+                rpcsvc_cache_reply (&req, iobref, &hdr, 1, NULL, 0, NULL, 0);
+
+                iobuf_unref (iobuf);
+                iobref_unref (iobref);
+        }
+        thr->insert_secs = drc_bm_now () - t0;
+
+        /* retransmissions, the latest ones are the most likely cached */
+        t0 = drc_bm_now ();
+        for (i = thr->conf->ops - 1; i >= 0 && !thr->failed; i--) {
+                req.xid = i;
+                req.reply = NULL;
+                snprintf (args, sizeof (args), "%d:%ld", thr->id, i);
+
+                reply = rpcsvc_drc_lookup (&req);
+                if (reply) {
+                        thr->hits++;
+                        rpcsvc_drc_op_unref (thr->svc->drc, reply);
+                } else if (req.reply) {
+                        /* evicted, it is cached as a new request */
+                        hdr.iov_base = args;
+                        hdr.iov_len = sizeof (args);
+                        iobref = iobref_new ();
+                        if (!iobref) {
+                                thr->failed = 1;
+                                break;
+                        }
+                        rpcsvc_cache_reply (&req, iobref, &hdr, 1, NULL, 0,
+                                            NULL, 0);
+                        iobref_unref (iobref);
+                }
+        }
+        thr->lookup_secs = drc_bm_now () - t0;
+
+        return NULL;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-t threads] [-n ops-per-thread] "
+                 "[-s drc-size] [-m drc-mem-limit] [-r reply-size]\n", prog);
+}
+
+int
+main (int argc, char *argv[])
+{
+        struct drc_bm_config   conf     = {0, };
+        struct drc_bm_thread  *thrs     = NULL;
+        glusterfs_ctx_t       *ctx      = NULL;
+        rpcsvc_t              *svc      = NULL;
+        dict_t                *options  = NULL;
+        double                 inserts  = 0;
+        double                 lookups  = 0;
+        long                   hits     = 0;
+        int                    opt      = 0;
+        int                    i        = 0;
+
+        conf.threads = 4;
+        conf.ops = 100000;
+        conf.size = 0x20000;
+        conf.mem_limit = "64MB";
+        conf.reply_size = 128;
+
+        while ((opt = getopt (argc, argv, "t:n:s:m:r:")) != -1) {
+                switch (opt) {
+                case 't':
+                        conf.threads = atoi (optarg);
+                        break;
+                case 'n':
+                        conf.ops = atol (optarg);
+                        break;
+                case 's':
+                        conf.size = strtoul (optarg, NULL, 0);
+                        break;
+                case 'm':
+                        conf.mem_limit = optarg;
+                        break;
+                case 'r':
+                        conf.reply_size = atol (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                        return 1;
+                }
+        }
+
+        if (optind != argc || conf.threads <= 0 || conf.ops <= 0 ||
+            conf.size == 0 || conf.reply_size == 0) {
+                usage (argv[0]);
+                return 1;
+        }
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+        gf_log_globals_init (ctx, GF_LOG_NONE);
+
+        ctx->iobuf_pool = iobuf_pool_new ();
+        svc = calloc (1, sizeof (*svc));
+        options = dict_new ();
+        thrs = calloc (conf.threads, sizeof (*thrs));
+        if (!ctx->iobuf_pool || !svc || !options || !thrs) {
+                fprintf (stderr, "out of memory\n");
+                return 1;
+        }
+
+        pthread_mutex_init (&svc->rpclock, NULL);
+        INIT_LIST_HEAD (&svc->notify);
+
+        if (dict_set_str (options, "nfs.drc", "on") ||
+            dict_set_uint32 (options, "nfs.drc-size", conf.size) ||
+            dict_set_str (options, "nfs.drc-mem-limit", conf.mem_limit) ||
+            rpcsvc_drc_init (svc, options) || !svc->drc) {
+                fprintf (stderr, "failed to initialize the drc\n");
+                return 1;
+        }
+
+        for (i = 0; i < conf.threads; i++) {
+                thrs[i].id = i;
+                thrs[i].conf = &conf;
+                thrs[i].svc = svc;
+                thrs[i].ctx = ctx;
+                if (pthread_create (&thrs[i].tid, NULL, drc_bm_run,
+                                    &thrs[i])) {
+                        perror ("pthread_create");
+                        return 1;
+                }
+        }
+
+        for (i = 0; i < conf.threads; i++) {
+                pthread_join (thrs[i].tid, NULL);
+                if (thrs[i].failed) {
+                        fprintf (stderr, "thread %d failed\n", i);
+                        return 1;
+                }
+
+                printf ("thread %d: %.0f inserts/sec, %.0f lookups/sec, "
+                        "%ld hits\n", i, conf.ops / thrs[i].insert_secs,
+                        conf.ops / thrs[i].lookup_secs, thrs[i].hits);
+                inserts += conf.ops / thrs[i].insert_secs;
+                lookups += conf.ops / thrs[i].lookup_secs;
+                hits += thrs[i].hits;
+        }
+
+        printf ("total: %.0f inserts/sec, %.0f lookups/sec, %ld of %ld "
+                "retransmissions hit, %"PRIu64" evictions\n", inserts,
+                lookups, hits, conf.threads * conf.ops, svc->drc->evictions);
+
+        return 0;
+}
@@ -0,0 +1,243 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+ * lock-bm: byte-range lock contention benchmark
+ *
+ * A number of processes open the same file. Every process first takes
+ * @held non-overlapping write locks of its own, which stay granted for the
+ * whole run the way the locks of a VM image or a database do, and then
+ * does @iters lock/unlock cycles with F_SETLKW on random ranges in a region
+ * shared by all the processes. The rate of the cycles and the longest
+ * time a lock request waited are reported per process and in total.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+struct lock_bm_config {
+        char *path;
+        int   procs;
+        long  held;
+        long  iters;
+        long  range;    /* size of every lock */
+        long  shared;   /* number of ranges in the contended region */
+};
+
+struct lock_bm_result {
+        double secs;
+        double max_wait;
+};
+
+static double
+lock_bm_now (void)
+{
+        struct timeval tv = {0, };
+
+        gettimeofday (&tv, NULL);
+
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int
+lock_bm_lk (int fd, int cmd, short type, off_t start, off_t len)
+{
+        struct flock fl = {0, };
+
+        fl.l_type   = type;
+        fl.l_whence = SEEK_SET;
+        fl.l_start  = start;
+        fl.l_len    = len;
+
+        return fcntl (fd, cmd, &fl);
+}
+
+static int
+lock_bm_run (struct lock_bm_config *conf, int id,
+             struct lock_bm_result *res)
+{
+        int    fd    = -1;
+        long   i     = 0;
+        off_t  base  = 0;
+        off_t  start = 0;
+        double t0    = 0;
+        double wait  = 0;
+
+        fd = open (conf->path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+                fprintf (stderr, "open (%s): %s\n", conf->path,
+                         strerror (errno));
+                return -1;
+        }
+
+        /* private ranges start after the shared region */
+        base = (conf->shared + (off_t)id * conf->held) * conf->range;
+        for (i = 0; i < conf->held; i++) {
+                if (lock_bm_lk (fd, F_SETLK, F_WRLCK,
+                                base + i * conf->range, conf->range)) {
+                        fprintf (stderr, "lock %ld of process %d: %s\n",
+                                 i, id, strerror (errno));
+                        goto err;
+                }
+        }
+
+        srandom (getpid ());
+        res->secs = lock_bm_now ();
+
+        for (i = 0; i < conf->iters; i++) {
+                start = (random () % conf->shared) * conf->range;
+
+                t0 = lock_bm_now ();
+                if (lock_bm_lk (fd, F_SETLKW, (i & 1) ? F_RDLCK : F_WRLCK,
+                                start, conf->range)) {
+                        fprintf (stderr, "lock of process %d: %s\n", id,
+                                 strerror (errno));
+                        goto err;
+                }
+                wait = lock_bm_now () - t0;
+                if (wait > res->max_wait)
+                        res->max_wait = wait;
+
+                lock_bm_lk (fd, F_SETLK, F_UNLCK, start, conf->range);
+        }
+
+        res->secs = lock_bm_now () - res->secs;
+        close (fd);
+
+        return 0;
+err:
+        close (fd);
+        return -1;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-p procs] [-l held-locks] "
+                 "[-i iterations] [-r range-size] [-s shared-ranges] "
+                 "<file>\n", prog);
+}
+
+int
+main (int argc, char *argv[])
+{
+        struct lock_bm_config  conf    = {0, };
+        struct lock_bm_result *results = NULL;
+        struct lock_bm_result  total   = {0, };
+        int                    pipes[2];
+        pid_t                  pid     = 0;
+        int                    opt     = 0;
+        int                    i       = 0;
+        int                    status  = 0;
+        int                    failed  = 0;
+
+        conf.procs  = 4;
+        conf.held   = 1000;
+        conf.iters  = 10000;
+        conf.range  = 4096;
+        conf.shared = 64;
+
+        while ((opt = getopt (argc, argv, "p:l:i:r:s:")) != -1) {
+                switch (opt) {
+                case 'p':
+                        conf.procs = atoi (optarg);
+                        break;
+                case 'l':
+                        conf.held = atol (optarg);
+                        break;
+                case 'i':
+                        conf.iters = atol (optarg);
+                        break;
+                case 'r':
+                        conf.range = atol (optarg);
+                        break;
+                case 's':
+                        conf.shared = atol (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                        return 1;
+                }
+        }
+
+        if ((optind != argc - 1) || (conf.procs <= 0) || (conf.held < 0) ||
+            (conf.iters <= 0) || (conf.range <= 0) || (conf.shared <= 0)) {
+                usage (argv[0]);
+                return 1;
+        }
+        conf.path = argv[optind];
+
+        results = calloc (conf.procs, sizeof (*results));
+        if (!results || pipe (pipes)) {
+                perror ("lock-bm");
+                return 1;
+        }
+
+        for (i = 0; i < conf.procs; i++) {
+                pid = fork ();
+                if (pid < 0) {
+                        perror ("fork");
+                        return 1;
+                }
+                if (pid == 0) {
+                        struct lock_bm_result res = {0, };
+
+                        close (pipes[0]);
+                        status = lock_bm_run (&conf, i, &res);
+                        if (write (pipes[1], &res, sizeof (res)) !=
+                            sizeof (res))
+                                status = -1;
+                        _exit (status ? 1 : 0);
+                }
+        }
+
+        close (pipes[1]);
+        for (i = 0; i < conf.procs; i++) {
+                if (read (pipes[0], &results[i], sizeof (results[i])) !=
+                    sizeof (results[i]))
+                        break;
+        }
+
+        for (i = 0; i < conf.procs; i++) {
+                wait (&status);
+                if (!WIFEXITED (status) || WEXITSTATUS (status))
+                        failed++;
+        }
+
+        if (failed) {
+                fprintf (stderr, "%d of %d processes failed\n", failed,
+                         conf.procs);
+                return 1;
+        }
+
+        for (i = 0; i < conf.procs; i++) {
+                printf ("process %d: %.0f locks/sec, longest wait %.6f "
+                        "sec\n", i, conf.iters / results[i].secs,
+                        results[i].max_wait);
+                total.secs += conf.iters / results[i].secs;
+                if (results[i].max_wait > total.max_wait)
+                        total.max_wait = results[i].max_wait;
+        }
+
+        printf ("total: %.0f locks/sec with %ld locks held, longest wait "
+                "%.6f sec\n", total.secs, conf.procs * conf.held,
+                total.max_wait);
+
+        free (results);
+
+        return 0;
+}
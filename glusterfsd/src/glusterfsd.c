@@ -213,6 +213,9 @@ static struct argp_option gf_options[] = {
          "Set oom_score_adj value for process"
          "[default: 0]"},
 #endif
+        {"cache-budget", ARGP_CACHE_BUDGET_KEY, "SIZE", 0,
+         "Limit the memory used by all caching translators together to SIZE "
+         "[default: 0 (no limit)]"},
         {"client-pid", ARGP_CLIENT_PID_KEY, "PID", OPTION_HIDDEN,
          "client will authenticate itself with process id PID to server"},
         {"no-root-squash", ARGP_FUSE_NO_ROOT_SQUASH_KEY, "BOOL",
@@ -1144,6 +1147,15 @@ parse_opts (int key, char *arg, struct argp_state *state)
                 break;
 #endif
 
+        case ARGP_CACHE_BUDGET_KEY:
+                if (gf_string2bytesize_uint64 (arg,
+                                               &cmd_args->cache_budget) == 0)
+                        break;
+
+                argp_failure (state, -1, 0,
+                              "unknown cache budget %s", arg);
+                break;
+
         case ARGP_FUSE_MOUNTOPTS_KEY:
                 cmd_args->fuse_mountopts = gf_strdup (arg);
                 break;
@@ -0,0 +1,529 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "common-utils.h"
+#include "statedump.h"
+#include "cache-budget.h"
+#include "libglusterfs-messages.h"
+
+#define GF_CACHE_BUDGET_MB      (1024ULL * 1024)
+
+/* cgroup v1 reports "no limit" as a page aligned LLONG_MAX */
+#define GF_CACHE_BUDGET_NO_LIMIT (1ULL << 62)
+
+
+static char *
+gf_cache_budget_cgroup_file (const char *dir, const char *path,
+                             const char *name)
+{
+        char *file = NULL;
+
+        if (gf_asprintf (&file, "%s%s/%s", dir,
+                         (strcmp (path, "/") == 0) ? "" : path, name) < 0)
+                return NULL;
+
+        if (access (file, R_OK) != 0) {
+                GF_FREE (file);
+                return NULL;
+        }
+
+        return file;
+}
+
+
+static gf_boolean_t
+gf_cache_budget_has_memory (char *controllers)
+{
+        char *tmp  = NULL;
+        char *name = NULL;
+
+        for (name = strtok_r (controllers, ",", &tmp); name;
+             name = strtok_r (NULL, ",", &tmp)) {
+                if (strcmp (name, "memory") == 0)
+                        return _gf_true;
+        }
+
+        return _gf_false;
+}
+
+
+/*
+ * Find the memory controller of the cgroup we run in. A cgroup v2 entry
+ * looks like "0::/path", a v1 one like "4:memory:/path".
+ */
+static void
+gf_cache_budget_cgroup_init (gf_cache_budget_t *budget)
+{
+        FILE    *fp      = NULL;
+        char     line[PATH_MAX + 64] = {0,};
+        char    *controllers = NULL;
+        char    *path    = NULL;
+        char    *usage   = NULL;
+        char    *limit   = NULL;
+
+        fp = fopen ("/proc/self/cgroup", "r");
+        if (!fp)
+                return;
+
+        while (fgets (line, sizeof (line), fp)) {
+                line[strcspn (line, "\n")] = '\0';
+
+                controllers = strchr (line, ':');
+                if (!controllers)
+                        continue;
+                controllers++;
+
+                path = strchr (controllers, ':');
+                if (!path)
+                        continue;
+                *path++ = '\0';
+
+                if (*controllers == '\0') {
+                        usage = gf_cache_budget_cgroup_file
+                                ("/sys/fs/cgroup", path, "memory.current");
+                        limit = gf_cache_budget_cgroup_file
+                                ("/sys/fs/cgroup", path, "memory.max");
+                } else if (gf_cache_budget_has_memory (controllers)) {
+                        usage = gf_cache_budget_cgroup_file
+                                ("/sys/fs/cgroup/memory", path,
+                                 "memory.usage_in_bytes");
+                        limit = gf_cache_budget_cgroup_file
+                                ("/sys/fs/cgroup/memory", path,
+                                 "memory.limit_in_bytes");
+                }
+
+                if (usage && limit)
+                        break;
+
+                GF_FREE (usage);
+                GF_FREE (limit);
+                usage = limit = NULL;
+        }
+
+        fclose (fp);
+
+        budget->cg_usage = usage;
+        budget->cg_limit = limit;
+}
+
+
+static int
+gf_cache_budget_read_u64 (const char *file, uint64_t *value)
+{
+        FILE *fp           = NULL;
+        char  buf[64]      = {0,};
+        int   ret          = -1;
+
+        fp = fopen (file, "r");
+        if (!fp)
+                goto out;
+
+        if (!fgets (buf, sizeof (buf), fp))
+                goto out;
+
+        buf[strcspn (buf, "\n")] = '\0';
+
+        /* cgroup v2 spells out an unlimited group */
+        if (strcmp (buf, "max") == 0) {
+                *value = 0;
+                ret = 0;
+                goto out;
+        }
+
+        ret = gf_string2uint64 (buf, value);
+out:
+        if (fp)
+                fclose (fp);
+
+        return ret;
+}
+
+
+static gf_boolean_t
+gf_cache_budget_cgroup_pressure (gf_cache_budget_t *budget, uint64_t *excess)
+{
+        uint64_t used = 0;
+        uint64_t max  = 0;
+
+        if (!budget->cg_usage || !budget->cg_limit)
+                return _gf_false;
+
+        if (gf_cache_budget_read_u64 (budget->cg_usage, &used) ||
+            gf_cache_budget_read_u64 (budget->cg_limit, &max))
+                return _gf_false;
+
+        if (max >= GF_CACHE_BUDGET_NO_LIMIT)
+                max = 0;
+
+        budget->cg_used = used;
+        budget->cg_max = max;
+
+        if (!max || (used / 100) < (max / 100) * GF_CACHE_BUDGET_CGROUP_HIGH)
+                return _gf_false;
+
+        *excess = used - (max / 100) * GF_CACHE_BUDGET_CGROUP_LOW;
+
+        return _gf_true;
+}
+
+
+/* hits per megabyte cached, the cheapest cache to shrink scores lowest */
+static uint64_t
+gf_cache_client_score (gf_cache_client_t *client)
+{
+        return ((client->heat + 1) * client->weight * 1024) /
+                ((client->used / GF_CACHE_BUDGET_MB) + 1);
+}
+
+
+static void
+__gf_cache_budget_shrink (gf_cache_budget_t *budget, uint64_t target)
+{
+        gf_cache_client_t *client = NULL;
+        gf_cache_client_t *victim = NULL;
+        uint64_t           bytes  = 0;
+        uint64_t           freed  = 0;
+
+        list_for_each_entry (client, &budget->clients, list)
+                client->picked = _gf_false;
+
+        while (target) {
+                victim = NULL;
+
+                list_for_each_entry (client, &budget->clients, list) {
+                        if (client->picked || !client->used)
+                                continue;
+
+                        if (!victim || (gf_cache_client_score (client) <
+                                        gf_cache_client_score (victim)))
+                                victim = client;
+                }
+
+                if (!victim)
+                        break;
+
+                victim->picked = _gf_true;
+
+                bytes = min (target, victim->used);
+                freed = victim->reclaim (victim->xl, bytes);
+                freed = min (freed, victim->used);
+
+                victim->used -= freed;
+                victim->reclaimed += freed;
+                victim->reclaims++;
+
+                budget->used -= min (freed, budget->used);
+                budget->reclaimed += freed;
+
+                gf_msg_debug ("cache-budget", 0, "%s gave back %"PRIu64
+                              " of %"PRIu64" bytes", victim->xl->name,
+                              freed, bytes);
+
+                target -= min (freed, target);
+        }
+}
+
+
+static void
+__gf_cache_budget_scan (gf_cache_budget_t *budget)
+{
+        gf_cache_client_t *client = NULL;
+        uint64_t           hits   = 0;
+        uint64_t           used   = 0;
+        uint64_t           target = 0;
+        uint64_t           excess = 0;
+
+        list_for_each_entry (client, &budget->clients, list) {
+                client->used = client->usage (client->xl);
+
+                hits = client->hits;
+                client->heat = (client->heat / 2) + (hits - client->hits_seen);
+                client->hits_seen = hits;
+
+                used += client->used;
+        }
+
+        budget->used = used;
+
+        if (budget->limit && (used > budget->limit)) {
+                target = used - budget->limit;
+                budget->over_budget++;
+        }
+
+        if (gf_cache_budget_cgroup_pressure (budget, &excess)) {
+                if (!budget->under_pressure)
+                        gf_msg ("cache-budget", GF_LOG_INFO, 0,
+                                LG_MSG_CACHE_BUDGET_PRESSURE,
+                                "cgroup memory usage %"PRIu64" is close to "
+                                "the limit %"PRIu64", shrinking caches",
+                                budget->cg_used, budget->cg_max);
+
+                budget->under_pressure = _gf_true;
+                budget->pressure_events++;
+                target = max (target, min (excess, used));
+        } else {
+                budget->under_pressure = _gf_false;
+        }
+
+        if (target)
+                __gf_cache_budget_shrink (budget, target);
+}
+
+
+static void *
+gf_cache_budget_reclaimer (void *data)
+{
+        gf_cache_budget_t *budget = data;
+        struct timespec    ts     = {0,};
+
+        gf_cache_budget_cgroup_init (budget);
+
+        pthread_mutex_lock (&budget->lock);
+        {
+                while (!budget->fini) {
+                        clock_gettime (CLOCK_REALTIME, &ts);
+                        ts.tv_sec += GF_CACHE_BUDGET_INTERVAL;
+
+                        (void) pthread_cond_timedwait (&budget->cond,
+                                                       &budget->lock, &ts);
+                        if (budget->fini)
+                                break;
+
+                        __gf_cache_budget_scan (budget);
+                }
+        }
+        pthread_mutex_unlock (&budget->lock);
+
+        return NULL;
+}
+
+
+static gf_cache_budget_t *
+gf_cache_budget_get (glusterfs_ctx_t *ctx)
+{
+        gf_cache_budget_t *budget = NULL;
+
+        LOCK (&ctx->lock);
+        {
+                budget = ctx->cache_budget;
+                if (budget)
+                        goto unlock;
+
+                /* not GF_CALLOC: the budget outlives the xlator which
+                 * happened to register first */
+                budget = CALLOC (1, sizeof (*budget));
+                if (!budget)
+                        goto unlock;
+
+                pthread_mutex_init (&budget->lock, NULL);
+                pthread_cond_init (&budget->cond, NULL);
+                INIT_LIST_HEAD (&budget->clients);
+                budget->limit = ctx->cmd_args.cache_budget;
+
+                ctx->cache_budget = budget;
+        }
+unlock:
+        UNLOCK (&ctx->lock);
+
+        return budget;
+}
+
+
+gf_cache_client_t *
+gf_cache_budget_register (xlator_t *this, uint32_t weight,
+                          gf_cache_usage_fn_t usage,
+                          gf_cache_reclaim_fn_t reclaim)
+{
+        gf_cache_budget_t *budget = NULL;
+        gf_cache_client_t *client = NULL;
+        int                ret    = -1;
+
+        GF_VALIDATE_OR_GOTO ("cache-budget", this, out);
+        GF_VALIDATE_OR_GOTO (this->name, usage, out);
+        GF_VALIDATE_OR_GOTO (this->name, reclaim, out);
+
+        budget = gf_cache_budget_get (this->ctx);
+        if (!budget)
+                goto out;
+
+        client = GF_CALLOC (1, sizeof (*client), gf_common_mt_cache_client_t);
+        if (!client)
+                goto out;
+
+        INIT_LIST_HEAD (&client->list);
+        client->xl = this;
+        client->weight = weight ? weight : 1;
+        client->usage = usage;
+        client->reclaim = reclaim;
+
+        pthread_mutex_lock (&budget->lock);
+        {
+                if (!budget->running) {
+                        ret = gf_thread_create (&budget->thread, NULL,
+                                                gf_cache_budget_reclaimer,
+                                                budget);
+                        if (ret) {
+                                gf_msg (this->name, GF_LOG_ERROR, ret,
+                                        LG_MSG_CACHE_BUDGET_FAILED,
+                                        "failed to start the cache "
+                                        "reclaimer");
+                                goto unlock;
+                        }
+                        budget->running = _gf_true;
+                }
+
+                list_add_tail (&client->list, &budget->clients);
+                budget->client_count++;
+                ret = 0;
+        }
+unlock:
+        pthread_mutex_unlock (&budget->lock);
+
+out:
+        if (ret && client) {
+                GF_FREE (client);
+                client = NULL;
+        }
+
+        return client;
+}
+
+
+/* once this returns the reclaimer is done with @client and its xlator */
+void
+gf_cache_budget_unregister (gf_cache_client_t *client)
+{
+        gf_cache_budget_t *budget = NULL;
+
+        if (!client)
+                return;
+
+        budget = client->xl->ctx->cache_budget;
+
+        pthread_mutex_lock (&budget->lock);
+        {
+                list_del_init (&client->list);
+                budget->client_count--;
+        }
+        pthread_mutex_unlock (&budget->lock);
+
+        GF_FREE (client);
+}
+
+
+void
+gf_cache_budget_set_limit (glusterfs_ctx_t *ctx, uint64_t limit)
+{
+        gf_cache_budget_t *budget = NULL;
+
+        ctx->cmd_args.cache_budget = limit;
+
+        budget = ctx->cache_budget;
+        if (!budget)
+                return;
+
+        pthread_mutex_lock (&budget->lock);
+        {
+                budget->limit = limit;
+                pthread_cond_signal (&budget->cond);
+        }
+        pthread_mutex_unlock (&budget->lock);
+}
+
+
+void
+gf_cache_budget_destroy (glusterfs_ctx_t *ctx)
+{
+        gf_cache_budget_t *budget = NULL;
+
+        budget = ctx->cache_budget;
+        if (!budget)
+                return;
+
+        pthread_mutex_lock (&budget->lock);
+        {
+                budget->fini = _gf_true;
+                pthread_cond_signal (&budget->cond);
+        }
+        pthread_mutex_unlock (&budget->lock);
+
+        if (budget->running)
+                pthread_join (budget->thread, NULL);
+
+        ctx->cache_budget = NULL;
+
+        GF_FREE (budget->cg_usage);
+        GF_FREE (budget->cg_limit);
+        pthread_cond_destroy (&budget->cond);
+        pthread_mutex_destroy (&budget->lock);
+        FREE (budget);
+}
+
+
+void
+gf_cache_budget_dump (glusterfs_ctx_t *ctx)
+{
+        gf_cache_budget_t *budget                   = NULL;
+        gf_cache_client_t *client                   = NULL;
+        char               key[GF_DUMP_MAX_BUF_LEN] = {0,};
+        int                i                        = 0;
+
+        budget = ctx->cache_budget;
+        if (!budget)
+                return;
+
+        gf_proc_dump_add_section ("cache-budget");
+
+        if (pthread_mutex_trylock (&budget->lock) != 0) {
+                gf_proc_dump_write ("Unable to dump the cache budget",
+                                    "(Lock acquisition failed)");
+                return;
+        }
+        {
+                gf_proc_dump_write ("limit", "%"PRIu64, budget->limit);
+                gf_proc_dump_write ("used", "%"PRIu64, budget->used);
+                gf_proc_dump_write ("reclaimed", "%"PRIu64,
+                                    budget->reclaimed);
+                gf_proc_dump_write ("over_budget", "%"PRIu64,
+                                    budget->over_budget);
+                gf_proc_dump_write ("cgroup_used", "%"PRIu64,
+                                    budget->cg_used);
+                gf_proc_dump_write ("cgroup_limit", "%"PRIu64,
+                                    budget->cg_max);
+                gf_proc_dump_write ("pressure_events", "%"PRIu64,
+                                    budget->pressure_events);
+                gf_proc_dump_write ("clients", "%u", budget->client_count);
+
+                list_for_each_entry (client, &budget->clients, list) {
+                        snprintf (key, sizeof (key), "client[%d].xlator", i);
+                        gf_proc_dump_write (key, "%s", client->xl->name);
+                        snprintf (key, sizeof (key), "client[%d].used", i);
+                        gf_proc_dump_write (key, "%"PRIu64, client->used);
+                        snprintf (key, sizeof (key), "client[%d].weight", i);
+                        gf_proc_dump_write (key, "%u", client->weight);
+                        snprintf (key, sizeof (key), "client[%d].hits", i);
+                        gf_proc_dump_write (key, "%"PRIu64, client->hits);
+                        snprintf (key, sizeof (key), "client[%d].score", i);
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            gf_cache_client_score (client));
+                        snprintf (key, sizeof (key), "client[%d].reclaimed",
+                                  i);
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            client->reclaimed);
+                        snprintf (key, sizeof (key), "client[%d].reclaims",
+                                  i);
+                        gf_proc_dump_write (key, "%"PRIu64, client->reclaims);
+                        i++;
+                }
+        }
+        pthread_mutex_unlock (&budget->lock);
+}
@@ -0,0 +1,110 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#ifndef __CACHE_BUDGET_H__
+#define __CACHE_BUDGET_H__
+
+#include "glusterfs.h"
+#include "list.h"
+
+/*
+ * Process wide accounting of the memory held by caching xlators.
+ *
+ * Every caching xlator registers itself with a usage callback and a
+ * reclaim callback. A single reclaimer thread per ctx sums the usage of
+ * all clients once per interval and, when the total is above the budget
+ * (--cache-budget) or the cgroup the process lives in is close to its
+ * memory limit, asks the least valuable clients to give memory back.
+ *
+ * The value of a client is its decayed hit rate per megabyte cached,
+ * scaled by the weight it registered with, so a cache that is large and
+ * cold is shrunk before a small and hot one.
+ */
+
+/* how often the reclaimer looks at the caches, in seconds */
+#define GF_CACHE_BUDGET_INTERVAL        1
+
+/* start shrinking when the cgroup is this full, and aim for the lower mark */
+#define GF_CACHE_BUDGET_CGROUP_HIGH     90
+#define GF_CACHE_BUDGET_CGROUP_LOW      80
+
+/* bytes currently cached by @this */
+typedef uint64_t (*gf_cache_usage_fn_t) (xlator_t *this);
+
+/* drop about @bytes from the cache of @this, returns the bytes freed.
+ * Called from the reclaimer thread, must not block on network I/O. */
+typedef uint64_t (*gf_cache_reclaim_fn_t) (xlator_t *this, uint64_t bytes);
+
+typedef struct gf_cache_client {
+        struct list_head       list;
+        xlator_t              *xl;
+        uint32_t               weight;
+        gf_cache_usage_fn_t    usage;
+        gf_cache_reclaim_fn_t  reclaim;
+
+        uint64_t               hits;       /* bumped without locks */
+
+        /* below are owned by the reclaimer, under the budget lock */
+        uint64_t               hits_seen;
+        uint64_t               heat;       /* hits, halved every interval */
+        uint64_t               used;       /* usage at the last scan */
+        uint64_t               reclaimed;  /* total bytes given back */
+        uint64_t               reclaims;   /* times asked to give back */
+        gf_boolean_t           picked;     /* already shrunk in this pass */
+} gf_cache_client_t;
+
+typedef struct gf_cache_budget {
+        pthread_mutex_t        lock;
+        pthread_cond_t         cond;
+        pthread_t              thread;
+        gf_boolean_t           running;
+        gf_boolean_t           fini;
+
+        struct list_head       clients;
+        uint32_t               client_count;
+
+        uint64_t               limit;      /* 0 means account only */
+        uint64_t               used;       /* sum of client usage */
+        uint64_t               reclaimed;
+        uint64_t               over_budget;
+
+        char                  *cg_usage;   /* cgroup memory usage file */
+        char                  *cg_limit;   /* cgroup memory limit file */
+        uint64_t               cg_used;
+        uint64_t               cg_max;
+        uint64_t               pressure_events;
+        gf_boolean_t           under_pressure;
+} gf_cache_budget_t;
+
+gf_cache_client_t *
+gf_cache_budget_register (xlator_t *this, uint32_t weight,
+                          gf_cache_usage_fn_t usage,
+                          gf_cache_reclaim_fn_t reclaim);
+
+void
+gf_cache_budget_unregister (gf_cache_client_t *client);
+
+void
+gf_cache_budget_set_limit (glusterfs_ctx_t *ctx, uint64_t limit);
+
+void
+gf_cache_budget_destroy (glusterfs_ctx_t *ctx);
+
+void
+gf_cache_budget_dump (glusterfs_ctx_t *ctx);
+
+static inline void
+gf_cache_budget_hit (gf_cache_client_t *client)
+{
+        if (client)
+                __sync_fetch_and_add (&client->hits, 1);
+}
+
+#endif /* __CACHE_BUDGET_H__ */
@@ -88,6 +88,35 @@ struct gf_brick_spec {
         void *ptr;
 };
 
+/**
+ * records of a changelog in the "indexed" encoding, read in place: the
+ * pointers refer to the mapped changelog and are valid until it is unmapped.
+ */
+#define GF_CHANGELOG_MAX_ENTRIES  2
+#define GF_CHANGELOG_MAX_UINT32   3
+
+typedef struct gf_changelog_map gf_changelog_map_t;
+
+struct gf_changelog_rec_entry {
+        const unsigned char *pargfid;
+        const char          *bname;
+        const char          *path;      /* "" unless captured for a delete */
+};
+
+typedef struct gf_changelog_record {
+        char                          type;     /* 'D', 'M' or 'E' */
+        int                           fop;
+        const unsigned char          *gfid;
+
+        /* mode, uid and gid of the created inodes */
+        int                           nr_uint32;
+        unsigned int                  uint32[GF_CHANGELOG_MAX_UINT32];
+
+        /* parent gfid and basename, old and new ones for renames */
+        int                           nr_entries;
+        struct gf_changelog_rec_entry entries[GF_CHANGELOG_MAX_ENTRIES];
+} gf_changelog_record_t;
+
 /* API set */
 
 int
@@ -105,6 +134,20 @@ gf_changelog_next_change (char *bufptr, size_t maxlen);
 int
 gf_changelog_done (char *file);
 
+/* reading indexed changelogs in place */
+gf_changelog_map_t *
+gf_changelog_map (char *file);
+
+ssize_t
+gf_changelog_map_count (gf_changelog_map_t *map);
+
+int
+gf_changelog_map_record (gf_changelog_map_t *map, size_t index,
+                         gf_changelog_record_t *rec);
+
+void
+gf_changelog_unmap (gf_changelog_map_t *map);
+
 /* newer flexible API */
 int
 gf_changelog_init (void *xl);
@@ -0,0 +1,324 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Low overhead fop tracing. When ctx->fop_trace is set, every frame
+ * unwound through STACK_UNWIND{_STRICT} records a fixed size binary event
+ * into a ring owned by the unwinding thread. Nothing is formatted on the
+ * I/O path; the rings are converted to Chrome trace-event JSON (loadable
+ * in chrome://tracing and perfetto) only when a statedump is taken.
+ */
+
+#include "glusterfs.h"
+#include "stack.h"
+#include "xlator.h"
+#include "common-utils.h"
+#include "fop-trace.h"
+#include "libglusterfs-messages.h"
+
+static pthread_once_t   gf_trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t    gf_trace_ring_key;
+static pthread_mutex_t  gf_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* all rings ever created, guarded by gf_trace_lock */
+static struct list_head gf_trace_rings = {&gf_trace_rings, &gf_trace_rings};
+static uint32_t         gf_trace_ring_count;
+
+/* xlator names indexed by xlator_t->trace_id. Names are copied so that
+ * events still resolve after an old graph is torn down. */
+static char            *gf_trace_xl_names[GF_TRACE_MAX_XLATORS];
+static uint16_t         gf_trace_xl_count;
+
+
+static void
+gf_trace_ring_release (void *ptr)
+{
+        gf_trace_ring_t *ring = ptr;
+
+        /* keep the events around for the next dump, the ring is handed
+         * to the next thread which starts tracing */
+        pthread_mutex_lock (&gf_trace_lock);
+        {
+                ring->orphan = _gf_true;
+        }
+        pthread_mutex_unlock (&gf_trace_lock);
+}
+
+
+static void
+gf_trace_key_init (void)
+{
+        (void) pthread_key_create (&gf_trace_ring_key, gf_trace_ring_release);
+}
+
+
+static gf_trace_ring_t *
+gf_trace_ring_get (void)
+{
+        gf_trace_ring_t *ring = NULL;
+        gf_trace_ring_t *tmp  = NULL;
+
+        (void) pthread_once (&gf_trace_once, gf_trace_key_init);
+
+        ring = pthread_getspecific (gf_trace_ring_key);
+        if (ring)
+                return ring;
+
+        pthread_mutex_lock (&gf_trace_lock);
+        {
+                list_for_each_entry (tmp, &gf_trace_rings, list) {
+                        if (tmp->orphan) {
+                                tmp->orphan = _gf_false;
+                                ring = tmp;
+                                break;
+                        }
+                }
+
+                if (!ring) {
+                        /* not GF_CALLOC: a ring outlives whichever xlator
+                         * happened to be THIS when it was created */
+                        ring = CALLOC (1, sizeof (*ring));
+                        if (ring) {
+                                ring->id = ++gf_trace_ring_count;
+                                list_add_tail (&ring->list, &gf_trace_rings);
+                        }
+                }
+        }
+        pthread_mutex_unlock (&gf_trace_lock);
+
+        if (ring)
+                (void) pthread_setspecific (gf_trace_ring_key, ring);
+
+        return ring;
+}
+
+
+static uint16_t
+gf_trace_xlator_id (xlator_t *xl)
+{
+        uint16_t id = 0;
+
+        if (xl->trace_id)
+                return xl->trace_id;
+
+        pthread_mutex_lock (&gf_trace_lock);
+        {
+                if (xl->trace_id) {
+                        id = xl->trace_id;
+                        goto unlock;
+                }
+
+                if (gf_trace_xl_count + 1 >= GF_TRACE_MAX_XLATORS)
+                        goto unlock;
+
+                id = gf_trace_xl_count + 1;
+                gf_trace_xl_names[id] = strdup (xl->name ? xl->name : "");
+                if (!gf_trace_xl_names[id]) {
+                        id = 0;
+                        goto unlock;
+                }
+
+                gf_trace_xl_count = id;
+                xl->trace_id = id;
+        }
+unlock:
+        pthread_mutex_unlock (&gf_trace_lock);
+
+        return id;
+}
+
+
+void
+gf_fop_trace_set_gfid (call_frame_t *frame, uuid_t gfid)
+{
+        if (!frame || !frame->root->ctx || !frame->root->ctx->fop_trace)
+                return;
+
+        gf_uuid_copy (frame->root->trace_gfid, gfid);
+}
+
+
+void
+gf_fop_trace_record (call_frame_t *frame, int32_t op_ret)
+{
+        gf_trace_ring_t  *ring    = NULL;
+        gf_trace_event_t *event   = NULL;
+        struct timeval   *begin   = NULL;
+        struct timeval    end     = {0,};
+        int64_t           elapsed = 0;
+
+        begin = &frame->begin;
+
+        /* tracing was switched on while this frame was in flight */
+        if (!begin->tv_sec)
+                return;
+
+        ring = gf_trace_ring_get ();
+        if (!ring)
+                return;
+
+        if (frame->this->ctx->measure_latency)
+                end = frame->end;
+        else
+                gettimeofday (&end, NULL);
+
+        elapsed = (end.tv_sec - begin->tv_sec) * 1000000
+                + (end.tv_usec - begin->tv_usec);
+        if (elapsed < 0)
+                elapsed = 0;
+
+        event = &ring->events[ring->head & (GF_TRACE_RING_SIZE - 1)];
+
+        event->begin = (uint64_t)begin->tv_sec * 1000000 + begin->tv_usec;
+        event->duration = (elapsed > UINT32_MAX) ? UINT32_MAX : elapsed;
+        event->xl_id = gf_trace_xlator_id (frame->this);
+        event->fop = ((frame->op > 0) && (frame->op < GF_FOP_MAXVALUE))
+                     ? frame->op : GF_TRACE_FOP_UNKNOWN;
+        event->flags = (op_ret < 0) ? GF_TRACE_FAILED : 0;
+        memcpy (event->gfid, frame->root->trace_gfid, sizeof (event->gfid));
+
+        /* publish the event before moving head for the dumper */
+        __sync_synchronize ();
+        ring->head++;
+}
+
+
+void
+gf_fop_trace_toggle (glusterfs_ctx_t *ctx, gf_boolean_t on)
+{
+        if (!ctx || (!!ctx->fop_trace == !!on))
+                return;
+
+        ctx->fop_trace = on;
+
+        gf_msg ("[core]", GF_LOG_INFO, 0, LG_MSG_FOP_TRACE_STATE,
+                "fop tracing turned %s", on ? "on" : "off");
+}
+
+
+/* Every xlator of the process which is configured to trace takes a ref,
+ * tracing is on while any of them holds one. Writing the meta toggle
+ * overrides it until the next ref or unref. */
+void
+gf_fop_trace_ref (glusterfs_ctx_t *ctx)
+{
+        if (!ctx)
+                return;
+
+        LOCK (&ctx->lock);
+        {
+                if (ctx->fop_trace_users++ == 0)
+                        gf_fop_trace_toggle (ctx, _gf_true);
+        }
+        UNLOCK (&ctx->lock);
+}
+
+
+void
+gf_fop_trace_unref (glusterfs_ctx_t *ctx)
+{
+        if (!ctx)
+                return;
+
+        LOCK (&ctx->lock);
+        {
+                if (ctx->fop_trace_users > 0 && --ctx->fop_trace_users == 0)
+                        gf_fop_trace_toggle (ctx, _gf_false);
+        }
+        UNLOCK (&ctx->lock);
+}
+
+
+static void
+gf_trace_ring_dump (FILE *fp, gf_trace_ring_t *ring, pid_t pid,
+                    gf_boolean_t *first)
+{
+        gf_trace_event_t  event  = {0,};
+        uint64_t          head   = 0;
+        uint64_t          start  = 0;
+        uint64_t          i      = 0;
+        const char       *fop    = NULL;
+        const char       *xlname = NULL;
+
+        head = ring->head;
+        __sync_synchronize ();
+
+        start = (head > GF_TRACE_RING_SIZE) ? head - GF_TRACE_RING_SIZE : 0;
+
+        for (i = start; i < head; i++) {
+                event = ring->events[i & (GF_TRACE_RING_SIZE - 1)];
+
+                if (event.fop == GF_TRACE_FOP_UNKNOWN)
+                        fop = "UNKNOWN";
+                else
+                        fop = gf_fop_list[event.fop];
+
+                xlname = NULL;
+                if (event.xl_id && (event.xl_id <= gf_trace_xl_count))
+                        xlname = gf_trace_xl_names[event.xl_id];
+
+                fprintf (fp, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                         "\"ts\":%"PRIu64",\"dur\":%"PRIu32",\"pid\":%d,"
+                         "\"tid\":%"PRIu32",\"args\":{\"gfid\":\"%s\","
+                         "\"failed\":%d}}", (*first) ? "" : ",", fop,
+                         xlname ? xlname : "unknown", event.begin,
+                         event.duration, pid, ring->id,
+                         uuid_utoa (event.gfid),
+                         !!(event.flags & GF_TRACE_FAILED));
+                *first = _gf_false;
+        }
+}
+
+
+int
+gf_fop_trace_dump (glusterfs_ctx_t *ctx, const char *path)
+{
+        FILE            *fp    = NULL;
+        gf_trace_ring_t *ring  = NULL;
+        gf_boolean_t     first = _gf_true;
+        pid_t            pid   = 0;
+        int              ret   = -1;
+
+        GF_VALIDATE_OR_GOTO ("fop-trace", path, out);
+
+        fp = fopen (path, "w");
+        if (!fp) {
+                gf_msg ("fop-trace", GF_LOG_ERROR, errno,
+                        LG_MSG_FOP_TRACE_DUMP_FAILED,
+                        "failed to open %s", path);
+                goto out;
+        }
+
+        pid = getpid ();
+
+        fprintf (fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+        /* rings are never freed, holding the lock only keeps the list
+         * stable against threads joining in */
+        pthread_mutex_lock (&gf_trace_lock);
+        {
+                list_for_each_entry (ring, &gf_trace_rings, list) {
+                        gf_trace_ring_dump (fp, ring, pid, &first);
+                }
+        }
+        pthread_mutex_unlock (&gf_trace_lock);
+
+        fprintf (fp, "\n]}\n");
+
+        ret = 0;
+        if (fclose (fp) != 0) {
+                gf_msg ("fop-trace", GF_LOG_ERROR, errno,
+                        LG_MSG_FOP_TRACE_DUMP_FAILED,
+                        "failed to write %s", path);
+                ret = -1;
+        }
+out:
+        return ret;
+}
@@ -0,0 +1,71 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#ifndef __FOP_TRACE_H__
+#define __FOP_TRACE_H__
+
+#include "glusterfs.h"
+#include "list.h"
+
+struct _call_frame_t;
+
+/* number of events kept per thread, must be a power of two */
+#define GF_TRACE_RING_SIZE      4096
+#define GF_TRACE_MAX_XLATORS    4096
+
+#define GF_TRACE_FOP_UNKNOWN    0xff
+
+/* event flags */
+#define GF_TRACE_FAILED         0x01
+
+/**
+ * One completed fop, as seen by the xlator it was wound to. Kept at
+ * 32 bytes so that a ring fits a handful of pages.
+ */
+typedef struct gf_trace_event {
+        uint64_t      begin;     /* wind time, usec since the epoch */
+        uint32_t      duration;  /* wind to unwind, usec            */
+        uint16_t      xl_id;     /* index into the xlator name table */
+        uint8_t       fop;       /* glusterfs_fop_t or FOP_UNKNOWN  */
+        uint8_t       flags;
+        unsigned char gfid[16];  /* gfid the request was resolved to */
+} gf_trace_event_t;
+
+/**
+ * Per-thread event ring. Only the owning thread writes to it; the dumper
+ * reads it without locking and tolerates the odd torn event.
+ */
+typedef struct gf_trace_ring {
+        struct list_head  list;
+        uint32_t          id;       /* reported as "tid" in the trace */
+        gf_boolean_t      orphan;   /* owner exited, ring can be reused */
+        uint64_t          head;     /* total events ever recorded */
+        gf_trace_event_t  events[GF_TRACE_RING_SIZE];
+} gf_trace_ring_t;
+
+void
+gf_fop_trace_record (struct _call_frame_t *frame, int32_t op_ret);
+
+void
+gf_fop_trace_set_gfid (struct _call_frame_t *frame, uuid_t gfid);
+
+void
+gf_fop_trace_toggle (glusterfs_ctx_t *ctx, gf_boolean_t on);
+
+void
+gf_fop_trace_ref (glusterfs_ctx_t *ctx);
+
+void
+gf_fop_trace_unref (glusterfs_ctx_t *ctx);
+
+int
+gf_fop_trace_dump (glusterfs_ctx_t *ctx, const char *path);
+
+#endif /* __FOP_TRACE_H__ */
@@ -436,6 +436,49 @@ delete_record (gfdb_conn_node_t *_conn_node,
 
 
 
+/*Libgfdb API Function: Used to update the heat of many inodes at once,
+ *                      the heat being accumulated in memory by the caller.
+ *                      The updates are applied in a single transaction.
+ *                      Only existing records are updated, use
+ *                      insert_record to create them.
+ *                      Refer CTR Xlator features/changetimerecorder for usage
+ * Arguments:
+ *      _conn_node     :  GFDB Connection node
+ *      heat_records   :  Array of heat records
+ *      count          :  Number of heat records
+ * Returns : if successful return 0 or
+ *          -ve value in case of failure*/
+int
+update_heat (gfdb_conn_node_t   *_conn_node,
+             gfdb_heat_record_t *heat_records,
+             int                count)
+{
+        int ret                                 = 0;
+        gfdb_db_operations_t *db_operations_t   = NULL;
+        void *gf_db_connection                  = NULL;
+
+        CHECK_CONN_NODE(_conn_node);
+
+        db_operations_t = &_conn_node->gfdb_connection.gfdb_db_operations;
+        gf_db_connection = _conn_node->gfdb_connection.gf_db_connection;
+
+        if (db_operations_t->update_heat_op) {
+
+                ret = db_operations_t->update_heat_op (gf_db_connection,
+                                                       heat_records, count);
+                if (ret) {
+                        gf_msg (GFDB_DATA_STORE, GF_LOG_ERROR, 0,
+                                LG_MSG_INSERT_OR_UPDATE_FAILED, "Update heat"
+                                " operation failed");
+                }
+        }
+
+        return ret;
+}
+
+
+
+
 
 /*Libgfdb API Function: Query all the records from the database
  * Arguments:
@@ -487,13 +530,16 @@ find_all (gfdb_conn_node_t      *_conn_node,
  *                                function query_callback
  *      for_time                : Time from where the file/s are not
  *                                changed/accessed
+ *      query_limit             : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int
 find_unchanged_for_time(gfdb_conn_node_t        *_conn_node,
                         gf_query_callback_t     query_callback,
                         void                    *_query_cbk_args,
-                        gfdb_time_t             *for_time)
+                        gfdb_time_t             *for_time,
+                        int                     query_limit)
 {
 
         int ret                                 = 0;
@@ -509,7 +555,7 @@ find_unchanged_for_time(gfdb_conn_node_t        *_conn_node,
 
                 ret = db_operations_t->find_unchanged_for_time_op
                                 (gf_db_connection, query_callback,
-                                _query_cbk_args, for_time);
+                                _query_cbk_args, for_time, query_limit);
                 if (ret) {
                         gf_msg (GFDB_DATA_STORE, GF_LOG_ERROR, 0,
                                 LG_MSG_FIND_OP_FAILED, "Find unchanged "
@@ -531,13 +577,16 @@ find_unchanged_for_time(gfdb_conn_node_t        *_conn_node,
  *                                function query_callback
  *      for_time                : Time from where the file/s are
  *                                changed/accessed
+ *      query_limit             : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int
 find_recently_changed_files(gfdb_conn_node_t    *_conn_node,
                             gf_query_callback_t query_callback,
                             void                *_query_cbk_args,
-                            gfdb_time_t         *from_time)
+                            gfdb_time_t         *from_time,
+                            int                 query_limit)
 {
 
         int ret                                 = 0;
@@ -553,7 +602,7 @@ find_recently_changed_files(gfdb_conn_node_t    *_conn_node,
 
                 ret =  db_operations_t->find_recently_changed_files_op (
                                 gf_db_connection, query_callback,
-                                _query_cbk_args, from_time);
+                                _query_cbk_args, from_time, query_limit);
                 if (ret) {
                         gf_msg (GFDB_DATA_STORE, GF_LOG_ERROR, 0,
                                 LG_MSG_FIND_OP_FAILED,
@@ -581,6 +630,8 @@ find_recently_changed_files(gfdb_conn_node_t    *_conn_node,
  *      read_freq_thresold      : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      query_limit             : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int
@@ -590,7 +641,8 @@ find_unchanged_for_time_freq(gfdb_conn_node_t *_conn_node,
                                         gfdb_time_t *for_time,
                                         int write_freq_thresold,
                                         int read_freq_thresold,
-                                        gf_boolean_t _clear_counters)
+                                        gf_boolean_t _clear_counters,
+                                        int query_limit)
 {
         int ret                                 = 0;
         gfdb_db_operations_t *db_operations_t   = NULL;
@@ -607,7 +659,7 @@ find_unchanged_for_time_freq(gfdb_conn_node_t *_conn_node,
                                 gf_db_connection, query_callback,
                                 _query_cbk_args, for_time,
                                 write_freq_thresold, read_freq_thresold,
-                                _clear_counters);
+                                _clear_counters, query_limit);
                 if (ret) {
                         gf_msg (GFDB_DATA_STORE, GF_LOG_ERROR, 0,
                                 LG_MSG_FIND_OP_FAILED,
@@ -634,6 +686,8 @@ find_unchanged_for_time_freq(gfdb_conn_node_t *_conn_node,
  *      read_freq_thresold      : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      query_limit             : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int
@@ -643,7 +697,8 @@ find_recently_changed_files_freq(gfdb_conn_node_t *_conn_node,
                                 gfdb_time_t *from_time,
                                 int write_freq_thresold,
                                 int read_freq_thresold,
-                                gf_boolean_t _clear_counters)
+                                gf_boolean_t _clear_counters,
+                                int query_limit)
 {
 
         int ret                                 = 0;
@@ -661,7 +716,7 @@ find_recently_changed_files_freq(gfdb_conn_node_t *_conn_node,
                                 gf_db_connection, query_callback,
                                 _query_cbk_args, from_time,
                                 write_freq_thresold, read_freq_thresold,
-                                _clear_counters);
+                                _clear_counters, query_limit);
                 if (ret) {
                         gf_msg (GFDB_DATA_STORE, GF_LOG_ERROR, 0,
                                 LG_MSG_FIND_OP_FAILED,
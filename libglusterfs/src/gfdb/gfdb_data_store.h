@@ -31,6 +31,7 @@
 #define GFDB_IPC_CTR_CLEAR_OPS "gfdb.ipc-ctr-clear-op"
 #define GFDB_IPC_CTR_GET_DB_PARAM_OPS "gfdb.ipc-ctr-get-db-parm"
 #define GFDB_IPC_CTR_GET_DB_VERSION_OPS "gfdb.ipc-ctr-get-db-version"
+#define GFDB_IPC_CTR_FLUSH_OPS "gfdb.ipc-ctr-flush-op"
 
 /*
  * CTR IPC INPUT/OUTPUT
@@ -39,6 +40,7 @@
  */
 #define GFDB_IPC_CTR_GET_QFILE_PATH "gfdb.ipc-ctr-get-qfile-path"
 #define GFDB_IPC_CTR_GET_QUERY_PARAMS "gfdb.ipc-ctr-get-query-parms"
+#define GFDB_IPC_CTR_GET_QUERY_LIMIT "gfdb.ipc-ctr-get-query-limit"
 #define GFDB_IPC_CTR_RET_QUERY_COUNT "gfdb.ipc-ctr-ret-rec-count"
 #define GFDB_IPC_CTR_GET_DB_KEY "gfdb.ipc-ctr-get-params-key"
 #define GFDB_IPC_CTR_RET_DB_VERSION "gfdb.ipc-ctr-ret-db-version"
@@ -138,6 +140,24 @@ delete_record(gfdb_conn_node_t *, gfdb_db_record_t *gfdb_db_record);
 
 
 
+/*Libgfdb API Function: Used to update the heat of many inodes at once,
+ *                      the heat being accumulated in memory by the caller.
+ *                      The updates are applied in a single transaction.
+ *                      Only existing records are updated, use
+ *                      insert_record to create them.
+ *                      Refer CTR Xlator features/changetimerecorder for usage
+ * Arguments:
+ *      _conn_node     :  GFDB Connection node
+ *      heat_records   :  Array of heat records
+ *      count          :  Number of heat records
+ * Returns : if successful return 0 or
+ *          -ve value in case of failure*/
+int
+update_heat(gfdb_conn_node_t *, gfdb_heat_record_t *heat_records, int count);
+
+
+
+
 
 /*Libgfdb API Function: Query all the records from the database
  * Arguments:
@@ -165,16 +185,20 @@ int find_all(gfdb_conn_node_t *, gf_query_callback_t query_callback,
  *                                function query_callback
  *      for_time                : Time from where the file/s are not
  *                                changed/accessed
+ *      query_limit             : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int find_unchanged_for_time(gfdb_conn_node_t *,
                         gf_query_callback_t query_callback,
-                        void *_query_cbk_args, gfdb_time_t *for_time);
+                        void *_query_cbk_args, gfdb_time_t *for_time,
+                        int query_limit);
 
 typedef int (*find_unchanged_for_time_t) (gfdb_conn_node_t *_conn_node,
                                           gf_query_callback_t query_callback,
                                           void *_query_cbk_args,
-                                          gfdb_time_t *for_time);
+                                          gfdb_time_t *for_time,
+                                          int query_limit);
 
 
 
@@ -189,16 +213,19 @@ typedef int (*find_unchanged_for_time_t) (gfdb_conn_node_t *_conn_node,
  *                                function query_callback
  *      for_time                : Time from where the file/s are
  *                                changed/accessed
+ *      query_limit             : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int find_recently_changed_files(gfdb_conn_node_t *_conn,
                 gf_query_callback_t query_callback, void *_query_cbk_args,
-                gfdb_time_t *from_time);
+                gfdb_time_t *from_time, int query_limit);
 
 typedef int (*find_recently_changed_files_t) (gfdb_conn_node_t *_conn_node,
                                               gf_query_callback_t query_callback,
                                               void *_query_cbk_args,
-                                              gfdb_time_t *from_time);
+                                              gfdb_time_t *from_time,
+                                              int query_limit);
 
 
 
@@ -218,6 +245,8 @@ typedef int (*find_recently_changed_files_t) (gfdb_conn_node_t *_conn_node,
  *      read_freq_thresold      : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      query_limit             : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int find_unchanged_for_time_freq(gfdb_conn_node_t *_conn,
@@ -226,7 +255,8 @@ int find_unchanged_for_time_freq(gfdb_conn_node_t *_conn,
                                         gfdb_time_t *for_time,
                                         int write_freq_thresold,
                                         int read_freq_thresold,
-                                        gf_boolean_t _clear_counters);
+                                        gf_boolean_t _clear_counters,
+                                        int query_limit);
 
 typedef int (*find_unchanged_for_time_freq_t) (gfdb_conn_node_t *_conn_node,
                                                gf_query_callback_t query_callback,
@@ -234,7 +264,8 @@ typedef int (*find_unchanged_for_time_freq_t) (gfdb_conn_node_t *_conn_node,
                                                gfdb_time_t *for_time,
                                                int write_freq_thresold,
                                                int read_freq_thresold,
-                                               gf_boolean_t _clear_counters);
+                                               gf_boolean_t _clear_counters,
+                                               int query_limit);
 
 
 
@@ -254,6 +285,8 @@ typedef int (*find_unchanged_for_time_freq_t) (gfdb_conn_node_t *_conn_node,
  *      read_freq_thresold      : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      query_limit             : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 int find_recently_changed_files_freq(gfdb_conn_node_t *_conn,
@@ -262,7 +295,8 @@ int find_recently_changed_files_freq(gfdb_conn_node_t *_conn,
                                 gfdb_time_t *from_time,
                                 int write_freq_thresold,
                                 int read_freq_thresold,
-                                gf_boolean_t _clear_counters);
+                                gf_boolean_t _clear_counters,
+                                int query_limit);
 
 typedef int (*find_recently_changed_files_freq_t) (gfdb_conn_node_t *_conn_node,
                                                    gf_query_callback_t query_callback,
@@ -270,7 +304,8 @@ typedef int (*find_recently_changed_files_freq_t) (gfdb_conn_node_t *_conn_node,
                                                    gfdb_time_t *from_time,
                                                    int write_freq_thresold,
                                                    int read_freq_thresold,
-                                                   gf_boolean_t _clear_counters);
+                                                   gf_boolean_t _clear_counters,
+                                                   int query_limit);
 
 typedef const
 char *(*get_db_path_key_t)();
@@ -308,6 +308,23 @@ typedef struct gfdb_db_record {
 } gfdb_db_record_t;
 
 
+/*The structure that is used to update the heat of an inode, accumulated
+ * by the caller over many fops, using update_heat api.
+ * Times that are zero are left as they are in the database and the
+ * counters are added to the ones in the database*/
+typedef struct gfdb_heat_record {
+        uuid_t                          gfid;
+        /* Latest wind and unwind times of write and read fops */
+        gfdb_time_t                     write_wind_time;
+        gfdb_time_t                     write_unwind_time;
+        gfdb_time_t                     read_wind_time;
+        gfdb_time_t                     read_unwind_time;
+        /* Number of writes and reads since the last update */
+        uint32_t                        write_count;
+        uint32_t                        read_count;
+} gfdb_heat_record_t;
+
+
 /*******************************************************************************
  *
  *                           Signatures for the plugin functions
@@ -374,6 +391,20 @@ typedef int
 
 
 
+/*Used to update the heat of many inodes at once
+ * Arguments:
+ *      db_conn        : plugin specific data base connection
+ *      heat_records   : Array of heat records
+ *      count          : Number of heat records
+ * Returns : if successful return 0 or
+ *          -ve value in case of failure*/
+typedef int
+(*gfdb_update_heat_t)(void *db_conn,
+                      gfdb_heat_record_t *heat_records, int count);
+
+
+
+
 /* Query all the records from the database
  * Arguments:
  *      db_conn        : plugin specific data base connection
@@ -401,13 +432,16 @@ typedef int
  *                                function query_callback
  *      for_time                : Time from where the file/s are not
  *                                changed/accessed
+ *      _query_limit            : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 typedef int
 (*gfdb_find_unchanged_for_time_t)(void *db_conn,
                                   gf_query_callback_t query_callback,
                                   void *_cbk_args,
-                                  gfdb_time_t *_time);
+                                  gfdb_time_t *_time,
+                                  int _query_limit);
 
 
 
@@ -421,12 +455,15 @@ typedef int
  *                                function query_callback
  *      _time                   : Time from where the file/s are
  *                                changed/accessed
+ *      _query_limit            : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 typedef int
 (*gfdb_find_recently_changed_files_t)(void *db_conn,
                                         gf_query_callback_t query_callback,
-                                        void *_cbk_args, gfdb_time_t *_time);
+                                        void *_cbk_args, gfdb_time_t *_time,
+                                        int _query_limit);
 
 /* Query records/files that have not changed/accessed
  * from a time in past to current time, with
@@ -444,6 +481,8 @@ typedef int
  *      _read_freq              : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      _query_limit            : Maximum number of file links returned,
+ *                                coldest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 typedef int
@@ -452,7 +491,8 @@ typedef int
                                         gf_query_callback_t query_callback,
                                         void *_cbk_args, gfdb_time_t *_time,
                                         int _write_freq, int _read_freq,
-                                        gf_boolean_t _clear_counters);
+                                        gf_boolean_t _clear_counters,
+                                        int _query_limit);
 
 
 
@@ -471,6 +511,8 @@ typedef int
  *      _read_freq              : Desired Read Frequency lower limit
  *      _clear_counters         : If true, Clears all the frequency counters of
  *                                all files.
+ *      _query_limit            : Maximum number of file links returned,
+ *                                hottest first. 0 for no limit.
  * Returns : if successful return 0 or
  *          -ve value in case of failure*/
 typedef int
@@ -478,7 +520,8 @@ typedef int
                                         gf_query_callback_t query_callback,
                                         void *_cbk_args, gfdb_time_t *_time,
                                         int _write_freq, int _read_freq,
-                                        gf_boolean_t _clear_counters);
+                                        gf_boolean_t _clear_counters,
+                                        int _query_limit);
 
 
 typedef int (*gfdb_clear_files_heat_t)(void *db_conn);
@@ -502,6 +545,7 @@ typedef struct gfdb_db_operations {
         gfdb_fini_db_t                        fini_db_op;
         gfdb_insert_record_t                  insert_record_op;
         gfdb_delete_record_t                  delete_record_op;
+        gfdb_update_heat_t                    update_heat_op;
         gfdb_find_all_t                       find_all_op;
         gfdb_find_unchanged_for_time_t        find_unchanged_for_time_op;
         gfdb_find_recently_changed_files_t    find_recently_changed_files_op;
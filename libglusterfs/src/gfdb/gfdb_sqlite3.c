@@ -29,8 +29,11 @@ gf_sql_connection_init ()
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, ENOMEM,
                         LG_MSG_NO_MEMORY, "Error allocating memory to "
                         "gf_sql_connection_t ");
+                goto out;
         }
 
+        LOCK_INIT (&gf_sql_conn->write_lock);
+out:
         return gf_sql_conn;
 }
 
@@ -39,6 +42,8 @@ gf_sql_connection_fini (gf_sql_connection_t **sql_connection)
 {
         if (!sql_connection)
                 return;
+        if (*sql_connection)
+                LOCK_DESTROY (&(*sql_connection)->write_lock);
         GF_FREE (*sql_connection);
         *sql_connection = NULL;
 }
@@ -239,6 +244,7 @@ gf_sqlite3_fill_db_operations(gfdb_db_operations_t  *gfdb_db_ops)
 
         gfdb_db_ops->insert_record_op = gf_sqlite3_insert;
         gfdb_db_ops->delete_record_op = gf_sqlite3_delete;
+        gfdb_db_ops->update_heat_op = gf_sqlite3_update_heat;
 
         gfdb_db_ops->find_all_op = gf_sqlite3_find_all;
         gfdb_db_ops->find_unchanged_for_time_op =
@@ -295,6 +301,27 @@ out:
 }
 
 
+/* Failing to create the indexes is not fatal, the queries would only be
+ * slower without them */
+static void
+create_indexes (sqlite3 *sqlite3_db_conn)
+{
+        int ret                         =       -1;
+        char *sql_strerror              =       NULL;
+
+        GF_ASSERT(sqlite3_db_conn);
+
+        ret = sqlite3_exec (sqlite3_db_conn, GF_CREATE_INDEX_STMT, NULL, NULL,
+                                &sql_strerror);
+        if (ret != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_WARNING, 0,
+                        LG_MSG_EXEC_FAILED, "Failed executing: %s : %s",
+                        GF_CREATE_INDEX_STMT, sql_strerror);
+                sqlite3_free (sql_strerror);
+        }
+}
+
+
 
 
 static int
@@ -473,6 +500,8 @@ gf_sqlite3_init (dict_t *args, void **db_conn) {
         }
 
 db_exists:
+        create_indexes (sql_conn->sqlite3_db_conn);
+
         ret = 0;
 out:
         if (ret) {
@@ -519,14 +548,11 @@ out:
  *
  * ***************************************************************************/
 
-int gf_sqlite3_insert(void *db_conn, gfdb_db_record_t *gfdb_db_record)
+static int
+_gf_sqlite3_insert (gf_sql_connection_t *sql_conn,
+                    gfdb_db_record_t *gfdb_db_record)
 {
         int ret                         =       -1;
-        gf_sql_connection_t *sql_conn   =       db_conn;
-
-        CHECK_SQL_CONN(sql_conn, out);
-        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, gfdb_db_record, out);
-
 
         switch (gfdb_db_record->gfdb_fop_path) {
         case GFDB_FOP_WIND:
@@ -580,6 +606,23 @@ out:
         return ret;
 }
 
+int gf_sqlite3_insert(void *db_conn, gfdb_db_record_t *gfdb_db_record)
+{
+        int ret                         =       -1;
+        gf_sql_connection_t *sql_conn   =       db_conn;
+
+        CHECK_SQL_CONN(sql_conn, out);
+        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, gfdb_db_record, out);
+
+        LOCK (&sql_conn->write_lock);
+        {
+                ret = _gf_sqlite3_insert (sql_conn, gfdb_db_record);
+        }
+        UNLOCK (&sql_conn->write_lock);
+out:
+        return ret;
+}
+
 int
 gf_sqlite3_delete(void *db_conn, gfdb_db_record_t *gfdb_db_record)
 {
@@ -594,6 +637,33 @@ out:
         return ret;
 }
 
+int
+gf_sqlite3_update_heat (void *db_conn, gfdb_heat_record_t *heat_records,
+                        int count)
+{
+        int ret = -1;
+        gf_sql_connection_t *sql_conn = db_conn;
+
+        CHECK_SQL_CONN(sql_conn, out);
+        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, heat_records, out);
+
+        LOCK (&sql_conn->write_lock);
+        {
+                ret = gf_sql_update_heat (sql_conn, heat_records, count);
+        }
+        UNLOCK (&sql_conn->write_lock);
+        if (ret) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                        LG_MSG_UPDATE_FAILED, "Failed updating heat of %d "
+                        "records", count);
+                goto out;
+        }
+
+        ret = 0;
+out:
+        return ret;
+}
+
 /******************************************************************************
  *
  *                      SELECT QUERY FUNCTIONS
@@ -673,146 +743,135 @@ out:
 
 
 /*
- * Find recently changed files from the DB
- * Input:
- *      query_callback  :       query callback fuction to handle
- *                              result records from the query
- *      from_time       :       Time to define what is recent
+ * The find queries below select the files by their last write/read wind
+ * times, which are indexed (see GF_CREATE_INDEX_STMT). The times are
+ * compared in usecs, along with a comparison on the seconds alone that the
+ * indexes can serve. The files come out hottest (or coldest) first, and
+ * with a limit sqlite keeps only that many rows while sorting, so that a
+ * tiering cycle does not read and sort the whole db for the few files it
+ * can migrate. The links of a file are kept together by ordering on the
+ * gfid last.
+ *
+ * All the find queries share the same parameters, which are bound by
+ * gf_sql_bind_find_params ()
  * */
-int
-gf_sqlite3_find_recently_changed_files(void *db_conn,
-                                        gf_query_callback_t query_callback,
-                                        void *query_cbk_args,
-                                        gfdb_time_t *from_time)
+#define GF_FIND_TIME_USEC       "?1"
+#define GF_FIND_TIME_SEC        "?2"
+#define GF_FIND_WRITE_FREQ      "?3"
+#define GF_FIND_READ_FREQ       "?4"
+#define GF_FIND_LIMIT           "?5"
+
+#define GF_FIND_WRITE_TIME      "(" GF_COL_TB_WSEC " * "\
+                                TOSTRING(GFDB_MICROSEC) " + "\
+                                GF_COL_TB_WMSEC ")"
+#define GF_FIND_READ_TIME       "(" GF_COL_TB_RWSEC " * "\
+                                TOSTRING(GFDB_MICROSEC) " + "\
+                                GF_COL_TB_RWMSEC ")"
+#define GF_FIND_LAST_ACCESS     "MAX(" GF_COL_TB_WSEC ", " GF_COL_TB_RWSEC ")"
+#define GF_FIND_HEAT            "(" GF_COL_TB_WFC " + " GF_COL_TB_RFC ")"
+
+static int
+gf_sql_bind_find_params (gf_sql_connection_t *sql_conn,
+                         sqlite3_stmt *prep_stmt, gfdb_time_t *_time,
+                         int freq_write_cnt, int freq_read_cnt,
+                         int query_limit)
 {
         int ret                                 =       -1;
-        char *query_str                         =       NULL;
-        gf_sql_connection_t *sql_conn           =       db_conn;
-        sqlite3_stmt *prep_stmt                 =       NULL;
-        uint64_t  from_time_usec                =       0;
-        char *base_query_str                    =       NULL;
-
-        CHECK_SQL_CONN (sql_conn, out);
-        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
-
-        ret = gf_get_basic_query_stmt (&base_query_str);
-        if (ret <= 0) {
-                goto out;
-        }
+        uint64_t time_usec                      =       0;
 
-        ret = gf_asprintf (&query_str, "%s AND"
-                /*First condition: For writes*/
-                "( ((" GF_COL_TB_WSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_WMSEC ") >= ? )"
-                " OR "
-                /*Second condition: For reads*/
-                "((" GF_COL_TB_RWSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_RWMSEC ") >= ?) )"
-                /* Order by write wind time in a descending order
-                 * i.e most hot files w.r.t to write */
-                " ORDER BY GF_FILE_TB.W_SEC DESC",
-                base_query_str);
+        time_usec = gfdb_time_2_usec (_time);
 
-        if (ret < 0) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed creating query statement");
-                query_str = NULL;
+        /*Bind the time in usecs*/
+        ret = sqlite3_bind_int64 (prep_stmt, 1, time_usec);
+        if (ret != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                        LG_MSG_BINDING_FAILED, "Failed to bind time_usec "
+                        "%"PRIu64" : %s", time_usec,
+                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
+                ret = -1;
                 goto out;
         }
 
-        from_time_usec = gfdb_time_2_usec (from_time);
-
-        ret = sqlite3_prepare (sql_conn->sqlite3_db_conn, query_str, -1,
-                               &prep_stmt, 0);
+        /*Bind the time in secs*/
+        ret = sqlite3_bind_int64 (prep_stmt, 2, _time->tv_sec);
         if (ret != SQLITE_OK) {
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_PREPARE_FAILED, "Failed to prepare statement %s :"
-                        " %s", query_str,
+                        LG_MSG_BINDING_FAILED, "Failed to bind time_sec "
+                        "%ld : %s", (long)_time->tv_sec,
                         sqlite3_errmsg (sql_conn->sqlite3_db_conn));
                 ret = -1;
                 goto out;
         }
 
-        /*Bind write wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 1, from_time_usec);
+        /*Bind write frequency thresold*/
+        ret = sqlite3_bind_int (prep_stmt, 3, freq_write_cnt);
         if (ret != SQLITE_OK) {
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind from_time_usec "
-                        "%"PRIu64" : %s", from_time_usec,
+                        LG_MSG_BINDING_FAILED, "Failed to bind freq_write_cnt "
+                        "%d : %s", freq_write_cnt,
                         sqlite3_errmsg (sql_conn->sqlite3_db_conn));
                 ret = -1;
                 goto out;
         }
 
-        /*Bind read wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 2, from_time_usec);
+        /*Bind read frequency thresold*/
+        ret = sqlite3_bind_int (prep_stmt, 4, freq_read_cnt);
         if (ret != SQLITE_OK) {
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind from_time_usec "
-                        "%"PRIu64" : %s ", from_time_usec,
+                        LG_MSG_BINDING_FAILED, "Failed to bind freq_read_cnt "
+                        "%d : %s", freq_read_cnt,
                         sqlite3_errmsg (sql_conn->sqlite3_db_conn));
                 ret = -1;
                 goto out;
         }
 
-        /*Execute the query*/
-        ret = gf_sql_query_function (prep_stmt, query_callback, query_cbk_args);
-        if (ret) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed Query %s", query_str);
+        /*Bind the limit, a negative limit is no limit for sqlite*/
+        ret = sqlite3_bind_int (prep_stmt, 5,
+                                (query_limit > 0) ? query_limit : -1);
+        if (ret != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                        LG_MSG_BINDING_FAILED, "Failed to bind query_limit "
+                        "%d : %s", query_limit,
+                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
+                ret = -1;
                 goto out;
         }
 
         ret = 0;
 out:
-        sqlite3_finalize (prep_stmt);
-        GF_FREE (base_query_str);
-        GF_FREE (query_str);
         return ret;
 }
 
 
 /*
- * Find unchanged files from a specified time from the DB
+ * Runs one of the find queries, with the condition and order given
  * Input:
  *      query_callback  :       query callback fuction to handle
  *                              result records from the query
- *      for_time        :        Time from where the file/s are not changed
+ *      condition       :       condition on the files, in the parameters
+ *                              of the find queries
+ *      order           :       ORDER BY of the query
  * */
-int
-gf_sqlite3_find_unchanged_for_time (void *db_conn,
-                                        gf_query_callback_t query_callback,
-                                        void *query_cbk_args,
-                                        gfdb_time_t *for_time)
+static int
+gf_sql_find (gf_sql_connection_t *sql_conn,
+             gf_query_callback_t query_callback, void *query_cbk_args,
+             const char *condition, const char *order, gfdb_time_t *_time,
+             int freq_write_cnt, int freq_read_cnt, int query_limit)
 {
         int ret                                 =       -1;
         char *query_str                         =       NULL;
-        gf_sql_connection_t *sql_conn           =       db_conn;
         sqlite3_stmt *prep_stmt                 =       NULL;
-        uint64_t  for_time_usec                 =       0;
         char *base_query_str                    =       NULL;
 
-        CHECK_SQL_CONN (sql_conn, out);
-        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
-
         ret = gf_get_basic_query_stmt (&base_query_str);
         if (ret <= 0) {
                 goto out;
         }
 
-        ret = gf_asprintf (&query_str, "%s AND "
-                /*First condition: For writes*/
-                "( ((" GF_COL_TB_WSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_WMSEC ") <= ? )"
-                " AND "
-                /*Second condition: For reads*/
-                "((" GF_COL_TB_RWSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_RWMSEC ") <= ?) )"
-                /* Order by write wind time in a ascending order
-                 * i.e most cold files w.r.t to write */
-                " ORDER BY GF_FILE_TB.W_SEC ASC",
-                base_query_str);
-
+        ret = gf_asprintf (&query_str, "%s AND %s ORDER BY %s, "
+                           GF_FILE_TABLE "." GF_COL_GF_ID
+                           " LIMIT " GF_FIND_LIMIT,
+                           base_query_str, condition, order);
         if (ret < 0) {
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
                         "Failed to create query statement");
@@ -820,8 +879,6 @@ gf_sqlite3_find_unchanged_for_time (void *db_conn,
                 goto out;
         }
 
-        for_time_usec = gfdb_time_2_usec (for_time);
-
         ret = sqlite3_prepare (sql_conn->sqlite3_db_conn, query_str, -1,
                                &prep_stmt, 0);
         if (ret != SQLITE_OK) {
@@ -833,25 +890,10 @@ gf_sqlite3_find_unchanged_for_time (void *db_conn,
                 goto out;
         }
 
-        /*Bind write wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 1, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind read wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 2, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
+        ret = gf_sql_bind_find_params (sql_conn, prep_stmt, _time,
+                                       freq_write_cnt, freq_read_cnt,
+                                       query_limit);
+        if (ret) {
                 goto out;
         }
 
@@ -872,6 +914,82 @@ out:
 }
 
 
+/*
+ * Find recently changed files from the DB
+ * Input:
+ *      query_callback  :       query callback fuction to handle
+ *                              result records from the query
+ *      from_time       :       Time to define what is recent
+ *      query_limit     :       Max number of file links, 0 for all
+ * */
+int
+gf_sqlite3_find_recently_changed_files(void *db_conn,
+                                        gf_query_callback_t query_callback,
+                                        void *query_cbk_args,
+                                        gfdb_time_t *from_time,
+                                        int query_limit)
+{
+        int ret                                 =       -1;
+        gf_sql_connection_t *sql_conn           =       db_conn;
+
+        CHECK_SQL_CONN (sql_conn, out);
+        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
+
+        ret = gf_sql_find (sql_conn, query_callback, query_cbk_args,
+                /*First condition: For writes*/
+                "( (" GF_COL_TB_WSEC " >= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_WRITE_TIME " >= " GF_FIND_TIME_USEC ")"
+                " OR "
+                /*Second condition: For reads*/
+                "(" GF_COL_TB_RWSEC " >= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_READ_TIME " >= " GF_FIND_TIME_USEC ") )",
+                /* Most recently accessed files first
+                 * i.e most hot files */
+                GF_FIND_LAST_ACCESS " DESC",
+                from_time, 0, 0, query_limit);
+out:
+        return ret;
+}
+
+
+/*
+ * Find unchanged files from a specified time from the DB
+ * Input:
+ *      query_callback  :       query callback fuction to handle
+ *                              result records from the query
+ *      for_time        :        Time from where the file/s are not changed
+ *      query_limit     :       Max number of file links, 0 for all
+ * */
+int
+gf_sqlite3_find_unchanged_for_time (void *db_conn,
+                                        gf_query_callback_t query_callback,
+                                        void *query_cbk_args,
+                                        gfdb_time_t *for_time,
+                                        int query_limit)
+{
+        int ret                                 =       -1;
+        gf_sql_connection_t *sql_conn           =       db_conn;
+
+        CHECK_SQL_CONN (sql_conn, out);
+        GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
+
+        ret = gf_sql_find (sql_conn, query_callback, query_cbk_args,
+                /*First condition: For writes*/
+                "( (" GF_COL_TB_WSEC " <= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_WRITE_TIME " <= " GF_FIND_TIME_USEC ")"
+                " AND "
+                /*Second condition: For reads*/
+                "(" GF_COL_TB_RWSEC " <= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_READ_TIME " <= " GF_FIND_TIME_USEC ") )",
+                /* Least recently accessed files first
+                 * i.e most cold files */
+                GF_FIND_LAST_ACCESS " ASC",
+                for_time, 0, 0, query_limit);
+out:
+        return ret;
+}
+
+
 
 
 
@@ -885,6 +1003,7 @@ out:
  *      freq_write_cnt  :       Frequency thresold for write
  *      freq_read_cnt   :       Frequency thresold for read
  *      clear_counters  :       Clear counters (r/w) for all inodes in DB
+ *      query_limit     :       Max number of file links, 0 for all
  * */
 int
 gf_sqlite3_find_recently_changed_files_freq (void *db_conn,
@@ -893,113 +1012,33 @@ gf_sqlite3_find_recently_changed_files_freq (void *db_conn,
                                         gfdb_time_t *from_time,
                                         int freq_write_cnt,
                                         int freq_read_cnt,
-                                        gf_boolean_t clear_counters)
+                                        gf_boolean_t clear_counters,
+                                        int query_limit)
 {
         int ret                                 =       -1;
-        char *query_str                         =       NULL;
         gf_sql_connection_t *sql_conn           =       db_conn;
-        sqlite3_stmt *prep_stmt                 =       NULL;
-        uint64_t  from_time_usec                =       0;
-        char *base_query_str                    =       NULL;
 
         CHECK_SQL_CONN (sql_conn, out);
         GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
 
-        ret = gf_get_basic_query_stmt (&base_query_str);
-        if (ret <= 0) {
-                goto out;
-        }
-        ret = gf_asprintf (&query_str, "%s AND "
+        ret = gf_sql_find (sql_conn, query_callback, query_cbk_args,
                 /*First condition: For Writes*/
-                "( ( ((" GF_COL_TB_WSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_WMSEC ") >= ? )"
-                " AND "" (" GF_COL_TB_WFC " >= ? ) )"
+                "( (" GF_COL_TB_WSEC " >= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_WRITE_TIME " >= " GF_FIND_TIME_USEC " AND "
+                GF_COL_TB_WFC " >= " GF_FIND_WRITE_FREQ ")"
                 " OR "
                 /*Second condition: For Reads */
-                "( ((" GF_COL_TB_RWSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_RWMSEC ") >= ?)"
-                " AND "" (" GF_COL_TB_RFC " >= ? ) ) )"
-                /* Order by write wind time and write freq in a descending order
-                 * i.e most hot files w.r.t to write */
-                " ORDER BY GF_FILE_TB.W_SEC DESC, "
-                "GF_FILE_TB.WRITE_FREQ_CNTR DESC",
-                base_query_str);
-
-        if (ret < 0) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed to create query statement");
-                query_str = NULL;
-                goto out;
-        }
-
-        from_time_usec = gfdb_time_2_usec (from_time);
-
-        ret = sqlite3_prepare (sql_conn->sqlite3_db_conn, query_str, -1,
-                                &prep_stmt, 0);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_PREPARE_FAILED, "Failed to prepare statement %s :"
-                        " %s", query_str,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind write wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 1, from_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind from_time_usec "
-                        "%"PRIu64" : %s", from_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind write frequency thresold*/
-        ret = sqlite3_bind_int (prep_stmt, 2, freq_write_cnt);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind freq_write_cnt "
-                        "%d : %s", freq_write_cnt,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-
-        /*Bind read wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 3, from_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind from_time_usec "
-                        "%"PRIu64" : %s", from_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind read frequency thresold*/
-        ret = sqlite3_bind_int (prep_stmt, 4, freq_read_cnt);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind freq_read_cnt "
-                        "%d : %s", freq_read_cnt,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Execute the query*/
-        ret = gf_sql_query_function (prep_stmt, query_callback, query_cbk_args);
+                "(" GF_COL_TB_RWSEC " >= " GF_FIND_TIME_SEC " AND "
+                GF_FIND_READ_TIME " >= " GF_FIND_TIME_USEC " AND "
+                GF_COL_TB_RFC " >= " GF_FIND_READ_FREQ ") )",
+                /* Most frequently and then most recently accessed files
+                 * first i.e most hot files */
+                GF_FIND_HEAT " DESC, " GF_FIND_LAST_ACCESS " DESC",
+                from_time, freq_write_cnt, freq_read_cnt, query_limit);
         if (ret) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed Query %s", query_str);
                 goto out;
         }
 
-
-
         /*Clear counters*/
         if (clear_counters) {
                 ret = gf_sql_clear_counters (sql_conn);
@@ -1012,9 +1051,6 @@ gf_sqlite3_find_recently_changed_files_freq (void *db_conn,
         }
         ret = 0;
 out:
-        sqlite3_finalize (prep_stmt);
-        GF_FREE (base_query_str);
-        GF_FREE (query_str);
         return ret;
 }
 
@@ -1030,6 +1066,7 @@ out:
  *      freq_write_cnt  :       Frequency thresold for write
  *      freq_read_cnt   :       Frequency thresold for read
  *      clear_counters  :       Clear counters (r/w) for all inodes in DB
+ *      query_limit     :       Max number of file links, 0 for all
  * */
 int
 gf_sqlite3_find_unchanged_for_time_freq (void *db_conn,
@@ -1038,150 +1075,43 @@ gf_sqlite3_find_unchanged_for_time_freq (void *db_conn,
                                         gfdb_time_t *for_time,
                                         int freq_write_cnt,
                                         int freq_read_cnt,
-                                        gf_boolean_t clear_counters)
+                                        gf_boolean_t clear_counters,
+                                        int query_limit)
 {
         int ret                                 =       -1;
-        char *query_str                         =       NULL;
         gf_sql_connection_t *sql_conn           =       db_conn;
-        sqlite3_stmt *prep_stmt                 =       NULL;
-        uint64_t  for_time_usec                 =       0;
-        char *base_query_str                    =       NULL;
 
         CHECK_SQL_CONN (sql_conn, out);
         GF_VALIDATE_OR_GOTO(GFDB_STR_SQLITE3, query_callback, out);
 
-        ret = gf_get_basic_query_stmt (&base_query_str);
-        if (ret <= 0) {
-                goto out;
-        }
-
-        ret = gf_asprintf (&query_str, "%s AND "
+        ret = gf_sql_find (sql_conn, query_callback, query_cbk_args,
                 /*First condition: For Writes
                  * Files that have write wind time smaller than for_time
                  * OR
                  * File that have write wind time greater than for_time,
                  * but write_frequency less than freq_write_cnt*/
-                "( ( ((" GF_COL_TB_WSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_WMSEC ") < ? )"
+                "( ( (" GF_FIND_WRITE_TIME " < " GF_FIND_TIME_USEC ")"
                 " OR "
-                "( (" GF_COL_TB_WFC " < ? ) AND"
-                "((" GF_COL_TB_WSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_WMSEC ") >= ? ) ) )"
+                "( (" GF_COL_TB_WFC " < " GF_FIND_WRITE_FREQ ") AND "
+                "(" GF_FIND_WRITE_TIME " >= " GF_FIND_TIME_USEC ") ) )"
                 " AND "
                 /*Second condition: For Reads
-                 * Files that have reaASCd wind time smaller than for_time
+                 * Files that have read wind time smaller than for_time
                  * OR
                  * File that have read wind time greater than for_time,
-                 * but write_frequency less than freq_write_cnt*/
-                "( ((" GF_COL_TB_RWSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_RWMSEC ") < ? )"
+                 * but read_frequency less than freq_read_cnt*/
+                "( (" GF_FIND_READ_TIME " < " GF_FIND_TIME_USEC ")"
                 " OR "
-                "( (" GF_COL_TB_RFC " < ? ) AND"
-                "((" GF_COL_TB_RWSEC " * " TOSTRING(GFDB_MICROSEC) " + "
-                GF_COL_TB_RWMSEC ") >= ? ) ) ) )"
-                /* Order by write wind time and write freq in ascending order
-                 * i.e most cold files w.r.t to write */
-                " ORDER BY GF_FILE_TB.W_SEC ASC, "
-                "GF_FILE_TB.WRITE_FREQ_CNTR ASC",
-                base_query_str);
-
-        if (ret < 0) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed to create query statement");
-                query_str = NULL;
-                goto out;
-        }
-
-        for_time_usec = gfdb_time_2_usec (for_time);
-
-        ret = sqlite3_prepare (sql_conn->sqlite3_db_conn, query_str, -1,
-                                &prep_stmt, 0);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_PREPARE_FAILED, "Failed to prepare delete "
-                        "statement %s : %s", query_str,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind write wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 1, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind write frequency thresold*/
-        ret = sqlite3_bind_int (prep_stmt, 2, freq_write_cnt);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind freq_write_cnt"
-                        " %d : %s", freq_write_cnt,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind write wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 3, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-
-
-        /*Bind read wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 4, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind read frequency thresold*/
-        ret = sqlite3_bind_int (prep_stmt, 5, freq_read_cnt);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind freq_read_cnt "
-                        "%d : %s", freq_read_cnt,
-                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Bind read wind time*/
-        ret = sqlite3_bind_int64 (prep_stmt, 6, for_time_usec);
-        if (ret != SQLITE_OK) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
-                        LG_MSG_BINDING_FAILED, "Failed to bind for_time_usec "
-                        "%"PRIu64" : %s", for_time_usec,
-                        sqlite3_errmsg(sql_conn->sqlite3_db_conn));
-                ret = -1;
-                goto out;
-        }
-
-        /*Execute the query*/
-        ret = gf_sql_query_function (prep_stmt, query_callback, query_cbk_args);
+                "( (" GF_COL_TB_RFC " < " GF_FIND_READ_FREQ ") AND "
+                "(" GF_FIND_READ_TIME " >= " GF_FIND_TIME_USEC ") ) ) )",
+                /* Least frequently and then least recently accessed files
+                 * first i.e most cold files */
+                GF_FIND_HEAT " ASC, " GF_FIND_LAST_ACCESS " ASC",
+                for_time, freq_write_cnt, freq_read_cnt, query_limit);
         if (ret) {
-                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_QUERY_FAILED,
-                        "Failed Query %s", query_str);
                 goto out;
         }
 
-
         /*Clear counters*/
         if (clear_counters) {
                 ret = gf_sql_clear_counters (sql_conn);
@@ -1195,9 +1125,6 @@ gf_sqlite3_find_unchanged_for_time_freq (void *db_conn,
 
         ret = 0;
 out:
-        sqlite3_finalize (prep_stmt);
-        GF_FREE (base_query_str);
-        GF_FREE (query_str);
         return ret;
 }
 
@@ -1210,7 +1137,11 @@ gf_sqlite3_clear_files_heat (void *db_conn)
 
         CHECK_SQL_CONN (sql_conn, out);
 
-        ret = gf_sql_clear_counters (sql_conn);
+        LOCK (&sql_conn->write_lock);
+        {
+                ret = gf_sql_clear_counters (sql_conn);
+        }
+        UNLOCK (&sql_conn->write_lock);
         if (ret) {
                 gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
                         LG_MSG_CLEAR_COUNTER_FAILED, "Failed to clear "
@@ -15,6 +15,7 @@
 #include <sqlite3.h>
 
 #include "logging.h"
+#include "locking.h"
 #include "gfdb_data_store_types.h"
 #include "gfdb_mem-types.h"
 #include "libglusterfs-messages.h"
@@ -55,6 +56,17 @@ do {\
                 );;\
 } while (0)
 
+/* Indexes on the write and read wind times, which the find queries of
+ * tiering select and order the files by. The frequency counters are not
+ * indexed, they change with every heat update and are only ever queried
+ * along with a time range. Also created on the dbs that were created
+ * before the indexes were. */
+#define GF_CREATE_INDEX_STMT\
+        "CREATE INDEX IF NOT EXISTS W_SEC_INDEX ON "\
+        GF_FILE_TABLE "(" GF_COL_WSEC "); "\
+        "CREATE INDEX IF NOT EXISTS W_READ_SEC_INDEX ON "\
+        GF_FILE_TABLE "(" GF_COL_WSEC_READ ");"
+
 #define GF_COL_TB_WSEC          GF_FILE_TABLE "." GF_COL_WSEC
 #define GF_COL_TB_WMSEC         GF_FILE_TABLE "." GF_COL_WMSEC
 #define GF_COL_TB_UWSEC         GF_FILE_TABLE "." GF_COL_UWSEC
@@ -123,6 +135,10 @@ typedef struct gf_sql_connection {
         gf_sql_journal_mode_t   journal_mode;
         gf_sql_sync_t           synchronous;
         gf_sql_auto_vacuum_t    auto_vacuum;
+        /* A transaction of the connection takes in the writes made on it
+         * by other threads meanwhile. Writes are serialized against the
+         * heat flush, so that a failed or cut short flush only loses heat */
+        gf_lock_t               write_lock;
 } gf_sql_connection_t;
 
 
@@ -251,6 +267,8 @@ int gf_sqlite3_init (dict_t *args, void **db_conn);
 /*insert/update/delete modules*/
 int gf_sqlite3_insert (void *db_conn, gfdb_db_record_t *);
 int gf_sqlite3_delete (void *db_conn, gfdb_db_record_t *);
+int gf_sqlite3_update_heat (void *db_conn, gfdb_heat_record_t *heat_records,
+                            int count);
 
 /*querying modules*/
 int gf_sqlite3_find_all (void *db_conn, gf_query_callback_t,
@@ -258,25 +276,29 @@ int gf_sqlite3_find_all (void *db_conn, gf_query_callback_t,
 int gf_sqlite3_find_unchanged_for_time (void *db_conn,
                                         gf_query_callback_t query_callback,
                                         void *_query_cbk_args,
-                                        gfdb_time_t *for_time);
+                                        gfdb_time_t *for_time,
+                                        int query_limit);
 int gf_sqlite3_find_recently_changed_files (void *db_conn,
                                         gf_query_callback_t query_callback,
                                         void *_query_cbk_args,
-                                        gfdb_time_t *from_time);
+                                        gfdb_time_t *from_time,
+                                        int query_limit);
 int gf_sqlite3_find_unchanged_for_time_freq (void *db_conn,
                                         gf_query_callback_t query_callback,
                                         void *_query_cbk_args,
                                         gfdb_time_t *for_time,
                                         int write_freq_cnt,
                                         int read_freq_cnt,
-                                        gf_boolean_t clear_counters);
+                                        gf_boolean_t clear_counters,
+                                        int query_limit);
 int gf_sqlite3_find_recently_changed_files_freq (void *db_conn,
                                         gf_query_callback_t query_callback,
                                         void *_query_cbk_args,
                                         gfdb_time_t *from_time,
                                         int write_freq_cnt,
                                         int read_freq_cnt,
-                                        gf_boolean_t clear_counters);
+                                        gf_boolean_t clear_counters,
+                                        int query_limit);
 
 int gf_sqlite3_clear_files_heat (void *db_conn);
 
@@ -641,7 +641,8 @@ gf_update_time (gf_sql_connection_t    *sql_conn,
                         /*Prefectly safe as we will not go array of bound*/
                         sprintf (update_str, "UPDATE "
                                 GF_FILE_TABLE
-                                " SET UW_SEC = ?, UW_MSEC = ? ;");
+                                " SET UW_SEC = ?, UW_MSEC = ?"
+                                " WHERE GF_ID = ? ;");
                 }
         }
         /*For Read Time update*/
@@ -661,7 +662,8 @@ gf_update_time (gf_sql_connection_t    *sql_conn,
                         /*Prefectly safe as we will not go array of bound*/
                         sprintf (update_str, "UPDATE "
                                 GF_FILE_TABLE
-                                " SET UW_READ_SEC = ?, UW_READ_MSEC = ? ;");
+                                " SET UW_READ_SEC = ?, UW_READ_MSEC = ?"
+                                " WHERE GF_ID = ? ;");
                 }
         }
 
@@ -1126,6 +1128,175 @@ out:
         return ret;
 }
 
+/******************************************************************************
+ *
+ *                      Helper functions for gf_sqlite3_update_heat()
+ *
+ * ****************************************************************************/
+
+/* The statements used to update the heat, all take the time in ?1 and ?2,
+ * the count to add in ?3 (which the unwind ones leave unused) and the gfid
+ * in ?4 */
+enum gf_sql_heat_stmt {
+        GF_SQL_HEAT_WRITE_WIND = 0,
+        GF_SQL_HEAT_WRITE_UNWIND,
+        GF_SQL_HEAT_READ_WIND,
+        GF_SQL_HEAT_READ_UNWIND,
+        GF_SQL_HEAT_STMT_MAX
+};
+
+static const char *gf_sql_heat_str[GF_SQL_HEAT_STMT_MAX] = {
+        [GF_SQL_HEAT_WRITE_WIND] = "UPDATE "
+                GF_FILE_TABLE
+                " SET " GF_COL_WSEC " = ?1, " GF_COL_WMSEC " = ?2, "
+                GF_COL_WRITE_FREQ_CNTR " = " GF_COL_WRITE_FREQ_CNTR " + ?3"
+                " WHERE GF_ID = ?4 ;",
+        [GF_SQL_HEAT_WRITE_UNWIND] = "UPDATE "
+                GF_FILE_TABLE
+                " SET " GF_COL_UWSEC " = ?1, " GF_COL_UWMSEC " = ?2"
+                " WHERE GF_ID = ?4 ;",
+        [GF_SQL_HEAT_READ_WIND] = "UPDATE "
+                GF_FILE_TABLE
+                " SET " GF_COL_WSEC_READ " = ?1, " GF_COL_WMSEC_READ " = ?2, "
+                GF_COL_READ_FREQ_CNTR " = " GF_COL_READ_FREQ_CNTR " + ?3"
+                " WHERE GF_ID = ?4 ;",
+        [GF_SQL_HEAT_READ_UNWIND] = "UPDATE "
+                GF_FILE_TABLE
+                " SET " GF_COL_UWSEC_READ " = ?1, " GF_COL_UWMSEC_READ " = ?2"
+                " WHERE GF_ID = ?4 ;",
+};
+
+static int
+gf_sql_heat_step (gf_sql_connection_t   *sql_conn,
+                  sqlite3_stmt          *heat_stmt,
+                  char                  *gfid,
+                  gfdb_time_t           *update_time,
+                  uint32_t              count)
+{
+        int ret = -1;
+
+        /* Nothing recorded */
+        if (!update_time->tv_sec && !update_time->tv_usec) {
+                ret = 0;
+                goto out;
+        }
+
+        sqlite3_reset (heat_stmt);
+
+        if (sqlite3_bind_int (heat_stmt, 1, update_time->tv_sec)
+                        != SQLITE_OK ||
+            sqlite3_bind_int (heat_stmt, 2, update_time->tv_usec)
+                        != SQLITE_OK ||
+            sqlite3_bind_int (heat_stmt, 3, count) != SQLITE_OK ||
+            sqlite3_bind_text (heat_stmt, 4, gfid, -1, NULL) != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                        LG_MSG_BINDING_FAILED, "Failed binding heat of gfid "
+                        "%s : %s", gfid,
+                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
+                goto out;
+        }
+
+        /*Execute the prepare statement*/
+        if (sqlite3_step (heat_stmt) != SQLITE_DONE) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                        LG_MSG_EXEC_FAILED, "Failed updating heat of gfid "
+                        "%s : %s", gfid,
+                        sqlite3_errmsg (sql_conn->sqlite3_db_conn));
+                goto out;
+        }
+
+        ret = 0;
+out:
+        return ret;
+}
+
+/* Update the heat of @count records in a single transaction. The statements
+ * are prepared once for the whole batch. A record that fails to update does
+ * not stop the others from being committed. To be called with the write
+ * lock of @sql_conn held, so that no other write joins the transaction. */
+int
+gf_sql_update_heat (gf_sql_connection_t  *sql_conn,
+                    gfdb_heat_record_t   *heat_records,
+                    int                  count)
+{
+        int ret                                         = -1;
+        int i                                           = 0;
+        int failed                                      = 0;
+        char *sql_strerror                              = NULL;
+        gfdb_heat_record_t *heat                        = NULL;
+        sqlite3_stmt *heat_stmt[GF_SQL_HEAT_STMT_MAX]   = {NULL, };
+        char gfid_str[GF_UUID_BUF_SIZE]                 = "";
+
+        CHECK_SQL_CONN (sql_conn, out);
+        GF_VALIDATE_OR_GOTO (GFDB_STR_SQLITE3, heat_records, out);
+
+        for (i = 0; i < GF_SQL_HEAT_STMT_MAX; i++) {
+                ret = sqlite3_prepare (sql_conn->sqlite3_db_conn,
+                                       gf_sql_heat_str[i], -1,
+                                       &heat_stmt[i], 0);
+                if (ret != SQLITE_OK) {
+                        gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0,
+                                LG_MSG_PREPARE_FAILED, "Failed preparing "
+                                "update statement %s : %s",
+                                gf_sql_heat_str[i],
+                                sqlite3_errmsg (sql_conn->sqlite3_db_conn));
+                        ret = -1;
+                        goto out;
+                }
+        }
+
+        ret = sqlite3_exec (sql_conn->sqlite3_db_conn, "BEGIN TRANSACTION;",
+                            NULL, NULL, &sql_strerror);
+        if (ret != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_EXEC_FAILED,
+                        "Failed to begin heat transaction : %s",
+                        sql_strerror);
+                sqlite3_free (sql_strerror);
+                ret = -1;
+                goto out;
+        }
+
+        for (i = 0; i < count; i++) {
+                heat = &heat_records[i];
+                uuid_utoa_r (heat->gfid, gfid_str);
+
+                if (gf_sql_heat_step (sql_conn,
+                                      heat_stmt[GF_SQL_HEAT_WRITE_WIND],
+                                      gfid_str, &heat->write_wind_time,
+                                      heat->write_count) ||
+                    gf_sql_heat_step (sql_conn,
+                                      heat_stmt[GF_SQL_HEAT_WRITE_UNWIND],
+                                      gfid_str, &heat->write_unwind_time, 0) ||
+                    gf_sql_heat_step (sql_conn,
+                                      heat_stmt[GF_SQL_HEAT_READ_WIND],
+                                      gfid_str, &heat->read_wind_time,
+                                      heat->read_count) ||
+                    gf_sql_heat_step (sql_conn,
+                                      heat_stmt[GF_SQL_HEAT_READ_UNWIND],
+                                      gfid_str, &heat->read_unwind_time, 0))
+                        failed++;
+        }
+
+        ret = sqlite3_exec (sql_conn->sqlite3_db_conn, "COMMIT;",
+                            NULL, NULL, &sql_strerror);
+        if (ret != SQLITE_OK) {
+                gf_msg (GFDB_STR_SQLITE3, GF_LOG_ERROR, 0, LG_MSG_EXEC_FAILED,
+                        "Failed to commit heat of %d records : %s", count,
+                        sql_strerror);
+                sqlite3_free (sql_strerror);
+                sqlite3_exec (sql_conn->sqlite3_db_conn, "ROLLBACK;",
+                              NULL, NULL, NULL);
+                ret = -1;
+                goto out;
+        }
+
+        ret = (failed) ? -1 : 0;
+out:
+        for (i = 0; i < GF_SQL_HEAT_STMT_MAX; i++)
+                sqlite3_finalize (heat_stmt[i]);
+        return ret;
+}
+
 /******************************************************************************
  *
  *                      Find/Query helper functions
@@ -351,6 +351,7 @@ struct _cmd_args {
         int              selinux;
         int              capability;
         char            *oom_score_adj;
+        uint64_t         cache_budget;
         int              enable_ino32;
         int              worm;
         int              mac_compat;
@@ -446,6 +447,8 @@ struct _glusterfs_ctx {
         void               *mgmt;   /* xlator implementing MOPs for centralized logging, volfile server */
         void               *listener; /* listener of the commands from glusterd */
         unsigned char       measure_latency; /* toggle switch for latency measurement */
+        unsigned char       fop_trace; /* toggle switch for fop-trace rings */
+        int                 fop_trace_users; /* xlators asking for it */
         pthread_t           sigwaiter;
 	char               *cmdlinestr;
         struct mem_pool    *stub_mem_pool;
@@ -503,6 +506,8 @@ struct _glusterfs_ctx {
 
         struct tvec_base *timer_wheel; /* global timer-wheel instance */
 
+        struct gf_cache_budget *cache_budget; /* shared by caching xlators */
+
 };
 typedef struct _glusterfs_ctx glusterfs_ctx_t;
 
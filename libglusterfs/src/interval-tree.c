@@ -0,0 +1,277 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <stddef.h>
+
+#include "interval-tree.h"
+
+/*
+ * Nodes are ordered on (start, address) so that identical intervals can
+ * co-exist and a given node can always be found again for removal.
+ */
+static int
+itree_node_cmp (itree_node_t *a, itree_node_t *b)
+{
+        if (a->start != b->start)
+                return (a->start < b->start) ? -1 : 1;
+
+        if (a == b)
+                return 0;
+
+        return ((uintptr_t)a < (uintptr_t)b) ? -1 : 1;
+}
+
+
+static int
+itree_height (itree_node_t *node)
+{
+        return node ? node->height : 0;
+}
+
+
+static void
+itree_update (itree_node_t *node)
+{
+        int      lh  = itree_height (node->left);
+        int      rh  = itree_height (node->right);
+        uint64_t max = node->end;
+
+        node->height = ((lh > rh) ? lh : rh) + 1;
+
+        if (node->left && node->left->max > max)
+                max = node->left->max;
+        if (node->right && node->right->max > max)
+                max = node->right->max;
+
+        node->max = max;
+}
+
+
+static itree_node_t *
+itree_rotate_right (itree_node_t *node)
+{
+        itree_node_t *pivot = node->left;
+
+        node->left = pivot->right;
+        pivot->right = node;
+
+        itree_update (node);
+        itree_update (pivot);
+
+        return pivot;
+}
+
+
+static itree_node_t *
+itree_rotate_left (itree_node_t *node)
+{
+        itree_node_t *pivot = node->right;
+
+        node->right = pivot->left;
+        pivot->left = node;
+
+        itree_update (node);
+        itree_update (pivot);
+
+        return pivot;
+}
+
+
+static itree_node_t *
+itree_rebalance (itree_node_t *node)
+{
+        int balance = 0;
+
+        itree_update (node);
+
+        balance = itree_height (node->left) - itree_height (node->right);
+
+        if (balance > 1) {
+                if (itree_height (node->left->left) <
+                    itree_height (node->left->right))
+                        node->left = itree_rotate_left (node->left);
+                return itree_rotate_right (node);
+        }
+
+        if (balance < -1) {
+                if (itree_height (node->right->right) <
+                    itree_height (node->right->left))
+                        node->right = itree_rotate_right (node->right);
+                return itree_rotate_left (node);
+        }
+
+        return node;
+}
+
+
+static itree_node_t *
+__itree_insert (itree_node_t *root, itree_node_t *node)
+{
+        if (!root)
+                return node;
+
+        if (itree_node_cmp (node, root) < 0)
+                root->left = __itree_insert (root->left, node);
+        else
+                root->right = __itree_insert (root->right, node);
+
+        return itree_rebalance (root);
+}
+
+
+static itree_node_t *
+__itree_remove_min (itree_node_t *root, itree_node_t **min)
+{
+        if (!root->left) {
+                *min = root;
+                return root->right;
+        }
+
+        root->left = __itree_remove_min (root->left, min);
+
+        return itree_rebalance (root);
+}
+
+
+static itree_node_t *
+__itree_remove (itree_node_t *root, itree_node_t *node, int *found)
+{
+        itree_node_t *min = NULL;
+        int           cmp = 0;
+
+        if (!root)
+                return NULL;
+
+        cmp = itree_node_cmp (node, root);
+        if (cmp < 0) {
+                root->left = __itree_remove (root->left, node, found);
+        } else if (cmp > 0) {
+                root->right = __itree_remove (root->right, node, found);
+        } else {
+                *found = 1;
+
+                if (!root->left)
+                        return root->right;
+                if (!root->right)
+                        return root->left;
+
+                root->right = __itree_remove_min (root->right, &min);
+                min->left = root->left;
+                min->right = root->right;
+                root = min;
+        }
+
+        return itree_rebalance (root);
+}
+
+
+void
+itree_init (itree_t *tree)
+{
+        tree->root = NULL;
+        tree->count = 0;
+}
+
+
+void
+itree_node_init (itree_node_t *node)
+{
+        node->left = node->right = NULL;
+        node->start = node->end = node->max = 0;
+        node->height = 0;
+}
+
+
+void
+itree_insert (itree_t *tree, itree_node_t *node, uint64_t start, uint64_t end)
+{
+        node->left = node->right = NULL;
+        node->start = start;
+        node->end = end;
+        node->max = end;
+        node->height = 1;
+
+        tree->root = __itree_insert (tree->root, node);
+        tree->count++;
+}
+
+
+void
+itree_remove (itree_t *tree, itree_node_t *node)
+{
+        int found = 0;
+
+        if (!itree_node_linked (node))
+                return;
+
+        tree->root = __itree_remove (tree->root, node, &found);
+        if (found)
+                tree->count--;
+
+        itree_node_init (node);
+}
+
+
+static int
+__itree_walk (itree_node_t *node, uint64_t start, uint64_t end,
+              itree_fn_t fn, void *data)
+{
+        int ret = 0;
+
+        /* nothing in this subtree reaches @start */
+        if (!node || node->max < start)
+                return 0;
+
+        ret = __itree_walk (node->left, start, end, fn, data);
+        if (ret)
+                return ret;
+
+        /* this node and everything to its right begin after @end */
+        if (node->start > end)
+                return 0;
+
+        if (node->end >= start) {
+                ret = fn (node, data);
+                if (ret)
+                        return ret;
+        }
+
+        return __itree_walk (node->right, start, end, fn, data);
+}
+
+
+/* visits every node overlapping [start, end] in ascending order of start */
+int
+itree_walk_overlaps (itree_t *tree, uint64_t start, uint64_t end,
+                     itree_fn_t fn, void *data)
+{
+        return __itree_walk (tree->root, start, end, fn, data);
+}
+
+
+static int
+itree_first_overlap_fn (itree_node_t *node, void *data)
+{
+        *(itree_node_t **)data = node;
+
+        return 1;
+}
+
+
+itree_node_t *
+itree_first_overlap (itree_t *tree, uint64_t start, uint64_t end)
+{
+        itree_node_t *node = NULL;
+
+        (void) itree_walk_overlaps (tree, start, end, itree_first_overlap_fn,
+                                    &node);
+
+        return node;
+}
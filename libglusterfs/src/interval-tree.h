@@ -0,0 +1,67 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __INTERVAL_TREE_H
+#define __INTERVAL_TREE_H
+
+#include <stdint.h>
+
+/*
+ * Intrusive interval tree. An itree_node_t is embedded in the object being
+ * indexed (the same way a list_head is) and the object is recovered with
+ * list_entry()/container_of. The tree is an AVL tree ordered on the start
+ * of the interval, augmented with the largest end in every subtree, so
+ * that insert, remove and "does anything overlap [start, end]" are all
+ * O(log n). Intervals are closed, i.e. both @start and @end are inclusive.
+ *
+ * No locking is done here; callers serialize access with their own lock.
+ */
+
+typedef struct itree_node {
+        struct itree_node *left;
+        struct itree_node *right;
+        uint64_t           start;
+        uint64_t           end;
+        uint64_t           max;     /* largest end in this subtree */
+        int                height;  /* 0 when not in a tree */
+} itree_node_t;
+
+typedef struct itree {
+        itree_node_t *root;
+        uint64_t      count;
+} itree_t;
+
+/* return non-zero from the callback to stop the walk */
+typedef int (*itree_fn_t) (itree_node_t *node, void *data);
+
+void
+itree_init (itree_t *tree);
+
+void
+itree_node_init (itree_node_t *node);
+
+void
+itree_insert (itree_t *tree, itree_node_t *node, uint64_t start, uint64_t end);
+
+void
+itree_remove (itree_t *tree, itree_node_t *node);
+
+int
+itree_walk_overlaps (itree_t *tree, uint64_t start, uint64_t end,
+                     itree_fn_t fn, void *data);
+
+itree_node_t *
+itree_first_overlap (itree_t *tree, uint64_t start, uint64_t end);
+
+#define itree_empty(tree) ((tree)->root == NULL)
+
+#define itree_node_linked(node) ((node)->height != 0)
+
+#endif /* __INTERVAL_TREE_H */
@@ -172,6 +172,8 @@ enum gf_common_mem_types_ {
         gf_common_mt_tbf_bucket_t,
         gf_common_mt_tbf_throttle_t,
         gf_common_mt_pthread_t,
+        gf_common_mt_cache_client_t,
+        gf_common_mt_drc_buckets_t,
         gf_common_mt_end
 };
 #endif
@@ -33,6 +33,7 @@ typedef struct call_pool call_pool_t;
 #include "lkowner.h"
 #include "client_t.h"
 #include "libglusterfs-messages.h"
+#include "fop-trace.h"
 
 #define NFS_PID 1
 #define LOW_PRIO_PROC_PID -1
@@ -110,6 +111,7 @@ struct _call_stack_t {
         int32_t                       op;
         int8_t                        type;
         struct timeval                tv;
+        uuid_t                        trace_gfid; /* tagged for fop-trace */
 };
 
 
@@ -264,7 +266,8 @@ STACK_RESET (call_stack_t *stack)
                               "winding from %s to %s",                  \
                               frame->root, old_THIS->name,              \
                               THIS->name);                              \
-                if (frame->this->ctx->measure_latency)                  \
+                if (frame->this->ctx->measure_latency ||                \
+                    frame->this->ctx->fop_trace)                        \
                         gf_latency_begin (_new, fn);                    \
                 fn (_new, obj, params);                                 \
                 THIS = old_THIS;                                        \
@@ -324,7 +327,7 @@ STACK_RESET (call_stack_t *stack)
                               "winding from %s to %s",                  \
                               frame->root, old_THIS->name,              \
                               THIS->name);                              \
-                if (obj->ctx->measure_latency)                          \
+                if (obj->ctx->measure_latency || obj->ctx->fop_trace)   \
                         gf_latency_begin (_new, fn);                    \
                 fn (_new, obj, params);                                 \
                 THIS = old_THIS;                                        \
@@ -369,6 +372,8 @@ STACK_RESET (call_stack_t *stack)
                 frame->unwind_from = __FUNCTION__;                      \
                 if (frame->this->ctx->measure_latency)                  \
                         gf_latency_end (frame);                         \
+                if (frame->this->ctx->fop_trace)                        \
+                        gf_fop_trace_record (frame, op_ret);            \
                 fn (_parent, frame->cookie, _parent->this, op_ret,      \
                     op_errno, params);                                  \
                 THIS = old_THIS;                                        \
@@ -414,6 +419,8 @@ STACK_RESET (call_stack_t *stack)
                 frame->unwind_from = __FUNCTION__;                      \
                 if (frame->this->ctx->measure_latency)                  \
                         gf_latency_end (frame);                         \
+                if (frame->this->ctx->fop_trace)                        \
+                        gf_fop_trace_record (frame, op_ret);            \
                 fn (_parent, frame->cookie, _parent->this, op_ret,      \
                     op_errno, params);                                  \
                 THIS = old_THIS;                                        \
@@ -500,6 +507,7 @@ copy_frame (call_frame_t *frame)
         newstack->pool = oldstack->pool;
         newstack->lk_owner = oldstack->lk_owner;
         newstack->ctx = oldstack->ctx;
+        gf_uuid_copy (newstack->trace_gfid, oldstack->trace_gfid);
 
         if (newstack->ctx->measure_latency) {
                 if (gettimeofday (&newstack->tv, NULL) == -1)
@@ -16,6 +16,7 @@
 #include "stack.h"
 #include "common-utils.h"
 #include "syscall.h"
+#include "cache-budget.h"
 
 
 #ifdef HAVE_MALLOC_H
@@ -765,6 +766,7 @@ gf_proc_dump_info (int signum, glusterfs_ctx_t *ctx)
         char               sign_string[512]        = {0,};
         char               tmp_dump_name[PATH_MAX] = {0,};
         char               path[PATH_MAX]          = {0,};
+        char               trace_path[PATH_MAX]    = {0,};
         struct timeval     tv                      = {0,};
 
         gf_proc_dump_lock ();
@@ -818,6 +820,7 @@ gf_proc_dump_info (int signum, glusterfs_ctx_t *ctx)
         if (GF_PROC_DUMP_IS_OPTION_ENABLED (mem)) {
                 gf_proc_dump_mem_info ();
                 gf_proc_dump_mempool_info (ctx);
+                gf_cache_budget_dump (ctx);
         }
 
         if (GF_PROC_DUMP_IS_OPTION_ENABLED (iobuf))
@@ -858,6 +861,17 @@ gf_proc_dump_info (int signum, glusterfs_ctx_t *ctx)
                   timestr);
         ret = sys_write (gf_dump_fd, sign_string, strlen (sign_string));
 
+        if (ctx->fop_trace) {
+                snprintf (trace_path, sizeof (trace_path),
+                          "%s/%s.%d.trace.%"PRIu64".json",
+                          ((dump_options.dump_path != NULL)?
+                           dump_options.dump_path:
+                           ((ctx->statedump_path != NULL)?ctx->statedump_path:
+                            DEFAULT_VAR_RUN_DIRECTORY)), brick_name, getpid(),
+                          (uint64_t) time (NULL));
+                (void) gf_fop_trace_dump (ctx, trace_path);
+        }
+
 out:
         if (gf_dump_fd != -1)
                 gf_proc_dump_close ();
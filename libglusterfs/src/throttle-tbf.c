@@ -87,15 +87,15 @@ _tbf_dispatch_queued (tbf_bucket_t *bucket)
         }
 }
 
+/**
+ * rate and limit are picked up on every tick as tbf_mod() may change
+ * them while the generator runs.
+ */
 void *tbf_tokengenerator (void *arg)
 {
-        unsigned long tokenrate = 0;
-        unsigned long maxtokens = 0;
         unsigned long token_gen_interval = 0;
         tbf_bucket_t *bucket = arg;
 
-        tokenrate = bucket->tokenrate;
-        maxtokens = bucket->maxtokens;
         token_gen_interval = bucket->token_gen_interval;
 
         while (1) {
@@ -103,9 +103,9 @@ void *tbf_tokengenerator (void *arg)
 
                 LOCK (&bucket->lock);
                 {
-                        bucket->tokens += tokenrate;
-                        if (bucket->tokens > maxtokens)
-                                bucket->tokens = maxtokens;
+                        bucket->tokens += bucket->tokenrate;
+                        if (bucket->tokens > bucket->maxtokens)
+                                bucket->tokens = bucket->maxtokens;
 
                         if (!list_empty (&bucket->queued))
                                 _tbf_dispatch_queued (bucket);
@@ -201,6 +201,28 @@ tbf_init (tbf_opspec_t *tbfspec, unsigned int count)
         return NULL;
 }
 
+/**
+ * A zero rate turns throttling off for the operation: the bucket (and its
+ * generator) stays around for a later change of rate, but requests pass
+ * through untouched and the ones already waiting are let go.
+ */
+static void
+_tbf_release_queued (tbf_bucket_t *bucket)
+{
+        tbf_throttle_t *tmp = NULL;
+        tbf_throttle_t *throttle = NULL;
+
+        list_for_each_entry_safe (throttle, tmp, &bucket->queued, list) {
+                pthread_mutex_lock (&throttle->mutex);
+                {
+                        throttle->done = 1;
+                        list_del_init (&throttle->list);
+                        pthread_cond_signal (&throttle->cond);
+                }
+                pthread_mutex_unlock (&throttle->mutex);
+        }
+}
+
 static void
 tbf_mod_bucket (tbf_bucket_t *bucket, tbf_opspec_t *spec)
 {
@@ -209,6 +231,9 @@ tbf_mod_bucket (tbf_bucket_t *bucket, tbf_opspec_t *spec)
                 bucket->tokens = 0;
                 bucket->tokenrate = spec->rate;
                 bucket->maxtokens = spec->maxlimit;
+
+                if (!bucket->tokenrate)
+                        _tbf_release_queued (bucket);
         }
         UNLOCK (&bucket->lock);
 
@@ -256,6 +281,16 @@ tbf_throttle (tbf_t *tbf, tbf_ops_t op, unsigned long tokens_requested)
 
         LOCK (&bucket->lock);
         {
+                if (!bucket->tokenrate)
+                        goto unblock;
+
+                /**
+                 * a request larger than the bucket would never conform:
+                 * let it drain a full bucket instead.
+                 */
+                if (tokens_requested > bucket->maxtokens)
+                        tokens_requested = bucket->maxtokens;
+
                 /**
                  * if there are enough tokens in the bucket there is no need
                  * to throttle the request: therefore, consume the required
@@ -944,6 +944,9 @@ struct _xlator {
         /* for the memory pool of 'frame->local' */
         struct mem_pool    *local_pool;
         gf_boolean_t        is_autoloaded;
+
+        /* index of this xlator in the fop-trace name table */
+        uint16_t            trace_id;
 };
 
 typedef struct {
@@ -21,23 +21,25 @@
 #include <netinet/in.h>
 #include <unistd.h>
 
+#define DRC_STRIPE(drc, hash)   (&(drc)->stripes[(hash) & (DRC_LOCK_STRIPES - 1)])
+#define DRC_BUCKET(drc, hash)   (&(drc)->buckets[(hash) & ((drc)->bucket_count - 1)])
+
 /**
- * rpcsvc_drc_op_destroy - Destroys the cached reply
+ * rpcsvc_drc_op_destroy - Destroys the cached reply, the op has to be
+ *                         unlinked from its bucket and its client already
  *
  * @param drc - the main drc structure
  * @param reply - the cached reply to destroy
- * @return NULL if reply is destroyed, reply otherwise
+ * @return void
  */
-static drc_cached_op_t *
+static void
 rpcsvc_drc_op_destroy (rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
 {
         GF_ASSERT (drc);
         GF_ASSERT (reply);
 
-        if (reply->state == DRC_OP_IN_TRANSIT)
-                return reply;
-
-        iobref_unref (reply->msg.iobref);
+        if (reply->msg.iobref)
+                iobref_unref (reply->msg.iobref);
         if (reply->msg.rpchdr)
                 GF_FREE (reply->msg.rpchdr);
         if (reply->msg.proghdr)
@@ -45,26 +47,7 @@ rpcsvc_drc_op_destroy (rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
         if (reply->msg.progpayload)
                 GF_FREE (reply->msg.progpayload);
 
-        list_del (&reply->global_list);
-        reply->client->op_count--;
-        drc->op_count--;
         mem_put (reply);
-        reply = NULL;
-
-        return reply;
-}
-
-/**
- * rpcsvc_drc_op_rb_unref - This function is used in rb tree cleanup only
- *
- * @param reply - the cached reply to unref
- * @param drc - the main drc structure
- * @return void
- */
-static void
-rpcsvc_drc_rb_op_destroy (void *reply, void *drc)
-{
-        rpcsvc_drc_op_destroy (drc, (drc_cached_op_t *)reply);
 }
 
 /**
@@ -76,8 +59,8 @@ rpcsvc_drc_rb_op_destroy (void *reply, void *drc)
 static void
 rpcsvc_remove_drc_client (drc_client_t *client)
 {
-        rb_destroy (client->rbtree, rpcsvc_drc_rb_op_destroy);
         list_del (&client->client_list);
+        LOCK_DESTROY (&client->lock);
         GF_FREE (client);
 }
 
@@ -109,63 +92,6 @@ rpcsvc_client_lookup (rpcsvc_drc_globals_t *drc,
         return NULL;
 }
 
-/**
- * drc_compare_reqs - Used by rbtree to determine if incoming req matches with
- *                    an existing node(cached reply) in rbtree
- *
- * @param item - pointer to the incoming req
- * @param rb_node_data - pointer to an rbtree node (cached reply)
- * @param param - drc pointer - unused here, but used in *op_destroy
- * @return 0 if req matches reply, else (req->xid - reply->xid)
- */
-int
-drc_compare_reqs (const void *item, const void *rb_node_data, void *param)
-{
-        int               ret      = -1;
-        drc_cached_op_t  *req      = NULL;
-        drc_cached_op_t  *reply    = NULL;
-
-        GF_ASSERT (item);
-        GF_ASSERT (rb_node_data);
-        GF_ASSERT (param);
-
-        req = (drc_cached_op_t *)item;
-        reply = (drc_cached_op_t *)rb_node_data;
-
-        ret = req->xid - reply->xid;
-        if (ret != 0)
-                return ret;
-
-        if (req->prognum == reply->prognum &&
-            req->procnum == reply->procnum &&
-            req->progversion == reply->progversion)
-                return 0;
-
-        return 1;
-}
-
-/**
- * drc_init_client_cache - initialize a drc client and its rb tree
- *
- * @param drc - the main drc structure
- * @param client - the drc client to be initialized
- * @return 0 on success, -1 on failure
- */
-static int
-drc_init_client_cache (rpcsvc_drc_globals_t *drc, drc_client_t *client)
-{
-        GF_ASSERT (drc);
-        GF_ASSERT (client);
-
-        client->rbtree = rb_create (drc_compare_reqs, drc, NULL);
-        if (!client->rbtree) {
-                gf_log (GF_RPCSVC, GF_LOG_DEBUG, "rb tree creation failed");
-                return -1;
-        }
-
-        return 0;
-}
-
 /**
  * rpcsvc_get_drc_client - find the drc client with given sockaddr, else
  *                         allocate and initialize a new drc client
@@ -196,15 +122,11 @@ rpcsvc_get_drc_client (rpcsvc_drc_globals_t *drc,
         client->ref = 0;
         client->sock_union = (union gf_sock_union)*sockaddr;
         client->op_count = 0;
+        client->mem_size = 0;
+        LOCK_INIT (&client->lock);
+        INIT_LIST_HEAD (&client->lru);
         INIT_LIST_HEAD (&client->client_list);
 
-        if (drc_init_client_cache (drc, client)) {
-                gf_log (GF_RPCSVC, GF_LOG_DEBUG,
-                        "initialization of drc client failed");
-                GF_FREE (client);
-                client = NULL;
-                goto out;
-        }
         drc->client_count++;
 
         list_add (&client->client_list, &drc->clients_head);
@@ -242,7 +164,7 @@ rpcsvc_need_drc (rpcsvc_request_t *req)
 }
 
 /**
- * rpcsvc_drc_client_ref - ref the drc client
+ * rpcsvc_drc_client_ref - ref the drc client, called with drc->lock held
  *
  * @param client - the drc client to ref
  * @return client
@@ -257,7 +179,8 @@ rpcsvc_drc_client_ref (drc_client_t *client)
 
 /**
  * rpcsvc_drc_client_unref - unref the drc client, and destroy
- *                           the client on last unref
+ *                           the client on last unref, called with
+ *                           drc->lock held
  *
  * @param drc - the main drc structure
  * @param client - the drc client to unref
@@ -280,48 +203,399 @@ rpcsvc_drc_client_unref (rpcsvc_drc_globals_t *drc, drc_client_t *client)
 }
 
 /**
- * rpcsvc_drc_lookup - lookup a request to see if it is already cached
+ * rpcsvc_drc_hash - hash of the key identifying a request of a client
  *
+ * @param client - the drc client the request came from
  * @param req - incoming request
+ * @return hash of (xid, program, version, procedure, client)
+ */
+static uint32_t
+rpcsvc_drc_hash (drc_client_t *client, rpcsvc_request_t *req)
+{
+        struct {
+                uint32_t        xid;
+                int             prognum;
+                int             progver;
+                int             procnum;
+                drc_client_t   *client;
+        } key;
+
+        memset (&key, 0, sizeof (key));
+        key.xid = req->xid;
+        key.prognum = req->prognum;
+        key.progver = req->progver;
+        key.procnum = req->procnum;
+        key.client = client;
+
+        return SuperFastHash ((const char *)&key, sizeof (key));
+}
+
+/**
+ * rpcsvc_drc_csum - checksum of the request arguments, so that a client
+ *                   reusing an xid after a reboot or a wrap around does not
+ *                   get the reply of an unrelated request
+ *
+ * @param req - incoming request
+ * @return checksum of the start and the length of the arguments
+ */
+static uint32_t
+rpcsvc_drc_csum (rpcsvc_request_t *req)
+{
+        uint32_t        csum = 0;
+        size_t          len  = 0;
+
+        if (!req->count || !req->msg[0].iov_base)
+                return 0;
+
+        len = min (req->msg[0].iov_len, DRC_CSUM_LEN);
+        csum = SuperFastHash (req->msg[0].iov_base, len);
+
+        return csum ^ (uint32_t)iov_length (req->msg, req->count);
+}
+
+/**
+ * rpcsvc_drc_trans_client - get the drc client of the transport and take a
+ *                           ref on it for a new op
+ *
+ * @param drc - the main drc structure
+ * @param trans - transport the request came on
+ * @return referenced drc client on success, NULL on failure
+ */
+static drc_client_t *
+rpcsvc_drc_trans_client (rpcsvc_drc_globals_t *drc, rpc_transport_t *trans)
+{
+        drc_client_t           *client = NULL;
+
+        LOCK (&drc->lock);
+        {
+                client = trans->drc_client;
+                if (!client) {
+                        client = rpcsvc_get_drc_client (drc,
+                                                  &trans->peerinfo.sockaddr);
+                        if (!client)
+                                goto unlock;
+
+                        trans->drc_client = rpcsvc_drc_client_ref (client);
+                }
+
+                rpcsvc_drc_client_ref (client);
+        }
+unlock:
+        UNLOCK (&drc->lock);
+
+        return client;
+}
+
+/**
+ * rpcsvc_drc_below_low_water - check if the cache has been vacated enough
+ *
+ * @param drc - the main drc structure
+ * @param op_low - no. of ops to get down to
+ * @param mem_low - bytes of replies to get down to
+ * @return _gf_true if both are reached, _gf_false otherwise
+ */
+static gf_boolean_t
+rpcsvc_drc_below_low_water (rpcsvc_drc_globals_t *drc, uint32_t op_low,
+                            uint64_t mem_low)
+{
+        if (drc->op_count > op_low)
+                return _gf_false;
+
+        return (!drc->mem_limit || drc->mem_size <= mem_low);
+}
+
+/**
+ * rpcsvc_drc_evict_client - evict the least recently used ops of a client
+ *                           until the cache is below its low water marks
+ *                           or the client is down to its share of memory
+ *
+ * @param drc - the main drc structure
+ * @param client - the (referenced) client to evict ops of
+ * @param victims - list the evicted ops are moved to
+ * @param op_low - no. of ops to get the cache down to
+ * @param mem_low - bytes of replies to get the cache down to
+ * @param share - bytes of replies the client may keep
+ * @return no. of ops evicted
+ */
+static uint32_t
+rpcsvc_drc_evict_client (rpcsvc_drc_globals_t *drc, drc_client_t *client,
+                         struct list_head *victims, uint32_t op_low,
+                         uint64_t mem_low, uint64_t share)
+{
+        drc_cached_op_t    *reply       = NULL;
+        drc_cached_op_t    *tmp         = NULL;
+        gf_lock_t          *stripe      = NULL;
+        uint32_t            n           = 0;
+
+        LOCK (&client->lock);
+        {
+                list_for_each_entry_safe_reverse (reply, tmp, &client->lru,
+                                                  client_list) {
+                        if (n && (client->mem_size <= share ||
+                                  rpcsvc_drc_below_low_water (drc, op_low,
+                                                              mem_low)))
+                                break;
+
+                        /* buckets are locked before clients everywhere
+                         * else, skip ops whose bucket is busy */
+                        stripe = DRC_STRIPE (drc, reply->hash);
+                        if (TRY_LOCK (stripe))
+                                continue;
+
+                        /* Don't delete ops that are in transit or
+                         * whose reply is being sent */
+                        if (reply->state == DRC_OP_IN_TRANSIT || reply->ref) {
+                                UNLOCK (stripe);
+                                continue;
+                        }
+
+                        list_del_init (&reply->hash_list);
+                        __sync_fetch_and_sub (&drc->op_count, 1);
+                        __sync_fetch_and_sub (&drc->mem_size, reply->size);
+                        UNLOCK (stripe);
+
+                        client->op_count--;
+                        client->mem_size -= reply->size;
+                        list_move (&reply->client_list, victims);
+                        n++;
+                }
+        }
+        UNLOCK (&client->lock);
+
+        return n;
+}
+
+/**
+ * rpcsvc_vacate_drc_entries - evict the least recently used ops of the
+ *                             clients holding the most memory until the
+ *                             cache is below its limits by the lru factor
+ *
+ * @param drc - the main drc structure
+ * @return void
+ */
+static void
+rpcsvc_vacate_drc_entries (rpcsvc_drc_globals_t *drc)
+{
+        struct list_head    victims;
+        drc_cached_op_t    *reply       = NULL;
+        drc_cached_op_t    *tmp         = NULL;
+        drc_client_t       *client      = NULL;
+        drc_client_t       *iter        = NULL;
+        uint32_t            op_low      = 0;
+        uint64_t            mem_low     = 0;
+        uint64_t            share       = 0;
+        uint32_t            n           = 0;
+        uint32_t            i           = 0;
+
+        GF_ASSERT (drc);
+
+        /* one thread evicts at a time, the others go on caching */
+        if (!__sync_bool_compare_and_swap (&drc->evicting, 0, 1))
+                return;
+
+        op_low = drc->global_cache_size -
+                 drc->global_cache_size / drc->lru_factor;
+        mem_low = drc->mem_limit - drc->mem_limit / drc->lru_factor;
+
+        while (!rpcsvc_drc_below_low_water (drc, op_low, mem_low)) {
+                INIT_LIST_HEAD (&victims);
+                client = NULL;
+
+                LOCK (&drc->lock);
+                {
+                        list_for_each_entry (iter, &drc->clients_head,
+                                             client_list) {
+                                if (!iter->op_count)
+                                        continue;
+                                if (!client ||
+                                    iter->mem_size > client->mem_size)
+                                        client = iter;
+                        }
+                        if (client) {
+                                rpcsvc_drc_client_ref (client);
+                                share = drc->mem_size / drc->client_count;
+                        }
+                }
+                UNLOCK (&drc->lock);
+
+                if (!client)
+                        break;
+
+                n = rpcsvc_drc_evict_client (drc, client, &victims, op_low,
+                                             mem_low, share);
+
+                list_for_each_entry_safe (reply, tmp, &victims, client_list) {
+                        list_del (&reply->client_list);
+                        rpcsvc_drc_op_destroy (drc, reply);
+                }
+
+                /* drop the refs of the evicted ops and our own */
+                LOCK (&drc->lock);
+                {
+                        for (i = 0; i < n; i++)
+                                rpcsvc_drc_client_unref (drc, client);
+                        rpcsvc_drc_client_unref (drc, client);
+                }
+                UNLOCK (&drc->lock);
+
+                /* everything left is in transit or being replied to */
+                if (!n)
+                        break;
+
+                __sync_fetch_and_add (&drc->evictions, n);
+        }
+
+        __sync_lock_release (&drc->evicting);
+}
+
+/**
+ * rpcsvc_drc_lookup - lookup a request to see if it is already cached, if
+ *                     it is not, it is cached as in transit and req->reply
+ *                     is set. A cached reply that is returned is referenced
+ *                     and has to be released with rpcsvc_drc_op_unref().
+ *                     The reply can change state once the stripe lock is
+ *                     dropped, so callers branch on *state only.
+ *
+ * @param req - incoming request
+ * @param state - state of the cached reply as seen under the stripe lock
  * @return cached reply of req if found, NULL otherwise
  */
 drc_cached_op_t *
-rpcsvc_drc_lookup (rpcsvc_request_t *req)
+rpcsvc_drc_lookup (rpcsvc_request_t *req, drc_op_state_t *state)
 {
+        rpcsvc_drc_globals_t   *drc    = NULL;
         drc_client_t           *client = NULL;
         drc_cached_op_t        *reply  = NULL;
-        drc_cached_op_t        new = {
-                .xid            = req->xid,
-                .prognum        = req->prognum,
-                .progversion    = req->progver,
-                .procnum        = req->procnum,
-        };
+        drc_cached_op_t        *iter   = NULL;
+        drc_cached_op_t        *new    = NULL;
+        struct list_head       *bucket = NULL;
+        gf_lock_t              *stripe = NULL;
+        uint32_t                hash   = 0;
+        uint32_t                csum   = 0;
 
         GF_ASSERT (req);
+        GF_ASSERT (state);
 
-        if (!req->trans->drc_client) {
-                client = rpcsvc_get_drc_client (req->svc->drc,
-                                                &req->trans->peerinfo.sockaddr);
-                if (!client)
-                        goto out;
+        drc = req->svc->drc;
+
+        client = rpcsvc_drc_trans_client (drc, req->trans);
+        if (!client)
+                goto out;
 
-                req->trans->drc_client
-                        = rpcsvc_drc_client_ref (client);
+        hash = rpcsvc_drc_hash (client, req);
+        csum = rpcsvc_drc_csum (req);
+        bucket = DRC_BUCKET (drc, hash);
+        stripe = DRC_STRIPE (drc, hash);
+
+        /* allocate outside the lock, most requests are not duplicates */
+        new = mem_get0 (drc->mempool);
+        if (new) {
+                new->client = client;
+                new->xid = req->xid;
+                new->prognum = req->prognum;
+                new->progversion = req->progver;
+                new->procnum = req->procnum;
+                new->hash = hash;
+                new->csum = csum;
+                new->state = DRC_OP_IN_TRANSIT;
+                INIT_LIST_HEAD (&new->hash_list);
+                INIT_LIST_HEAD (&new->client_list);
         }
 
-        client = req->trans->drc_client;
+        LOCK (stripe);
+        {
+                list_for_each_entry (iter, bucket, hash_list) {
+                        if (iter->client != client || iter->xid != req->xid ||
+                            iter->prognum != req->prognum ||
+                            iter->progversion != req->progver ||
+                            iter->procnum != req->procnum)
+                                continue;
+
+                        /* same xid but different arguments, a new request */
+                        if (iter->csum != csum) {
+                                __sync_fetch_and_add (&drc->csum_mismatches,
+                                                      1);
+                                break;
+                        }
+
+                        reply = iter;
+                        reply->ref++;
+                        *state = reply->state;
+                        if (*state == DRC_OP_CACHED)
+                                __sync_fetch_and_add (&drc->cache_hits, 1);
+                        else
+                                __sync_fetch_and_add (&drc->intransit_hits,
+                                                      1);
+                        break;
+                }
+
+                if (!reply && new) {
+                        /* newest first, so it shadows a mismatched op */
+                        list_add (&new->hash_list, bucket);
+                        __sync_fetch_and_add (&drc->op_count, 1);
+
+                        LOCK (&client->lock);
+                        {
+                                list_add (&new->client_list, &client->lru);
+                                client->op_count++;
+                        }
+                        UNLOCK (&client->lock);
+                }
+        }
+        UNLOCK (stripe);
 
-        if (client->op_count == 0)
+        if (reply || !new) {
+                if (new)
+                        mem_put (new);
+
+                LOCK (&drc->lock);
+                rpcsvc_drc_client_unref (drc, client);
+                UNLOCK (&drc->lock);
+
+                if (!new)
+                        gf_log (GF_RPCSVC, GF_LOG_DEBUG,
+                                "Failed to add op to drc cache");
                 goto out;
+        }
 
-        reply = rb_find (client->rbtree, &new);
+        req->reply = new;
+
+        /* cache is full, free up some space */
+        if (drc->op_count >= drc->global_cache_size)
+                rpcsvc_vacate_drc_entries (drc);
 
  out:
         return reply;
 }
 
+/**
+ * rpcsvc_drc_op_unref - release a cached reply returned by a lookup
+ *
+ * @param drc - the main drc structure
+ * @param reply - the cached reply
+ * @return void
+ */
+void
+rpcsvc_drc_op_unref (rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
+{
+        gf_lock_t      *stripe = NULL;
+
+        GF_ASSERT (drc);
+        GF_ASSERT (reply);
+
+        stripe = DRC_STRIPE (drc, reply->hash);
+
+        LOCK (stripe);
+        {
+                GF_ASSERT (reply->ref);
+                reply->ref--;
+        }
+        UNLOCK (stripe);
+}
+
 /**
  * rpcsvc_send_cached_reply - send the cached reply for the incoming request
+ *                            and release the reference of the lookup
  *
  * @param req - incoming request (which is a duplicate in this case)
  * @param reply - the cached reply for req
@@ -338,13 +612,12 @@ rpcsvc_send_cached_reply (rpcsvc_request_t *req, drc_cached_op_t *reply)
         gf_log (GF_RPCSVC, GF_LOG_DEBUG, "sending cached reply: xid: %d, "
                 "client: %s", req->xid, req->trans->peerinfo.identifier);
 
-        rpcsvc_drc_client_ref (reply->client);
         ret = rpcsvc_transport_submit (req->trans,
                      reply->msg.rpchdr, reply->msg.rpchdrcount,
                      reply->msg.proghdr, reply->msg.proghdrcount,
                      reply->msg.progpayload, reply->msg.progpayloadcount,
                      reply->msg.iobref, req->trans_private);
-        rpcsvc_drc_client_unref (req->svc->drc, reply->client);
+        rpcsvc_drc_op_unref (req->svc->drc, reply);
 
         return ret;
 }
@@ -370,156 +643,49 @@ rpcsvc_cache_reply (rpcsvc_request_t *req, struct iobref *iobref,
 {
         int                       ret              = -1;
         drc_cached_op_t          *reply            = NULL;
+        rpcsvc_drc_globals_t     *drc              = NULL;
+        gf_lock_t                *stripe           = NULL;
+        rpc_transport_msg_t       msg              = {0, };
 
         GF_ASSERT (req);
         GF_ASSERT (req->reply);
 
+        drc = req->svc->drc;
         reply = req->reply;
+        stripe = DRC_STRIPE (drc, reply->hash);
 
-        reply->state = DRC_OP_CACHED;
+        msg.iobref = iobref_ref (iobref);
 
-        reply->msg.iobref = iobref_ref (iobref);
+        msg.rpchdrcount = rpchdrcount;
+        msg.rpchdr = iov_dup (rpchdr, rpchdrcount);
 
-        reply->msg.rpchdrcount = rpchdrcount;
-        reply->msg.rpchdr = iov_dup (rpchdr, rpchdrcount);
+        msg.proghdrcount = proghdrcount;
+        msg.proghdr = iov_dup (proghdr, proghdrcount);
 
-        reply->msg.proghdrcount = proghdrcount;
-        reply->msg.proghdr = iov_dup (proghdr, proghdrcount);
-
-        reply->msg.progpayloadcount = payloadcount;
+        msg.progpayloadcount = payloadcount;
         if (payloadcount)
-                reply->msg.progpayload = iov_dup (payload, payloadcount);
-
-        //        rpcsvc_drc_client_unref (req->svc->drc, req->trans->drc_client);
-        //        rpcsvc_drc_op_unref (req->svc->drc, reply);
-        ret = 0;
+                msg.progpayload = iov_dup (payload, payloadcount);
 
-        return ret;
-}
-
-/**
- * rpcsvc_vacate_drc_entries - free up some percentage of drc cache
- *                             based on the lru factor
- *
- * @param drc - the main drc structure
- * @return void
- */
-static void
-rpcsvc_vacate_drc_entries (rpcsvc_drc_globals_t *drc)
-{
-        uint32_t            i           = 0;
-        uint32_t            n           = 0;
-        drc_cached_op_t    *reply       = NULL;
-        drc_cached_op_t    *tmp         = NULL;
-        drc_client_t       *client      = NULL;
-
-        GF_ASSERT (drc);
-
-        n = drc->global_cache_size / drc->lru_factor;
-
-        list_for_each_entry_safe_reverse (reply, tmp, &drc->cache_head, global_list) {
-                /* Don't delete ops that are in transit */
-                if (reply->state == DRC_OP_IN_TRANSIT)
-                        continue;
-
-                client = reply->client;
-
-                rb_delete (client->rbtree, reply);
-
-                rpcsvc_drc_op_destroy (drc, reply);
-                rpcsvc_drc_client_unref (drc, client);
-                i++;
-                if (i >= n)
-                        break;
+        LOCK (stripe);
+        {
+                reply->msg = msg;
+                reply->size = sizeof (*reply) + iobref_size (iobref);
+                reply->state = DRC_OP_CACHED;
+                __sync_fetch_and_add (&drc->mem_size, reply->size);
+
+                LOCK (&reply->client->lock);
+                {
+                        reply->client->mem_size += reply->size;
+                }
+                UNLOCK (&reply->client->lock);
         }
-}
-
-/**
- * rpcsvc_add_op_to_cache - insert the cached op into the client rbtree and drc list
- *
- * @param drc - the main drc structure
- * @param reply - the op to be inserted
- * @return 0 on success, -1 on failure
- */
-static int
-rpcsvc_add_op_to_cache (rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
-{
-        drc_client_t        *client         = NULL;
-        drc_cached_op_t    **tmp_reply      = NULL;
-
-        GF_ASSERT (drc);
-        GF_ASSERT (reply);
+        UNLOCK (stripe);
 
-        client = reply->client;
-
-        /* cache is full, free up some space */
-        if (drc->op_count >= drc->global_cache_size)
+        if (drc->mem_limit && drc->mem_size > drc->mem_limit)
                 rpcsvc_vacate_drc_entries (drc);
 
-        tmp_reply = (drc_cached_op_t **)rb_probe (client->rbtree, reply);
-        if (!tmp_reply) {
-                /* mem alloc failed */
-                return -1;
-        } else if (*tmp_reply != reply) {
-                /* should never happen */
-                gf_log (GF_RPCSVC, GF_LOG_ERROR,
-                        "DRC failed to detect duplicates");
-                return -1;
-        }
-
-        client->op_count++;
-        list_add (&reply->global_list, &drc->cache_head);
-        drc->op_count++;
-
-        return 0;
-}
-
-/**
- * rpcsvc_cache_request - cache the in-transition incoming request
- *
- * @param req - incoming request
- * @return 0 on success, -1 on failure
- */
-int
-rpcsvc_cache_request (rpcsvc_request_t *req)
-{
-        int                        ret            = -1;
-        drc_client_t              *client         = NULL;
-        drc_cached_op_t           *reply          = NULL;
-        rpcsvc_drc_globals_t      *drc            = NULL;
-
-        GF_ASSERT (req);
-
-        drc = req->svc->drc;
-
-        client = req->trans->drc_client;
-        if (!client) {
-                gf_log (GF_RPCSVC, GF_LOG_DEBUG, "drc client is NULL");
-                goto out;
-        }
-
-        reply = mem_get0 (drc->mempool);
-        if (!reply)
-                goto out;
-
-        reply->client = rpcsvc_drc_client_ref (client);
-        reply->xid = req->xid;
-        reply->prognum = req->prognum;
-        reply->progversion = req->progver;
-        reply->procnum = req->procnum;
-        reply->state = DRC_OP_IN_TRANSIT;
-        req->reply = reply;
-        INIT_LIST_HEAD (&reply->global_list);
-
-        ret = rpcsvc_add_op_to_cache (drc, reply);
-        if (ret) {
-                req->reply = NULL;
-                rpcsvc_drc_op_destroy (drc, reply);
-                rpcsvc_drc_client_unref (drc, client);
-                gf_log (GF_RPCSVC, GF_LOG_DEBUG, "Failed to add op to drc cache");
-        }
+        ret = 0;
 
- out:
         return ret;
 }
 
@@ -561,14 +727,29 @@ rpcsvc_drc_priv (rpcsvc_drc_globals_t *drc)
         gf_proc_dump_build_key (key, "drc", "max_cache_size");
         gf_proc_dump_write (key, "%d", drc->global_cache_size);
 
+        gf_proc_dump_build_key (key, "drc", "current_mem_size");
+        gf_proc_dump_write (key, "%"PRIu64, drc->mem_size);
+
+        gf_proc_dump_build_key (key, "drc", "mem_limit");
+        gf_proc_dump_write (key, "%"PRIu64, drc->mem_limit);
+
         gf_proc_dump_build_key (key, "drc", "lru_factor");
         gf_proc_dump_write (key, "%d", drc->lru_factor);
 
+        gf_proc_dump_build_key (key, "drc", "hash_buckets");
+        gf_proc_dump_write (key, "%u", drc->bucket_count);
+
         gf_proc_dump_build_key (key, "drc", "duplicate_request_count");
-        gf_proc_dump_write (key, "%d", drc->cache_hits);
+        gf_proc_dump_write (key, "%"PRIu64, drc->cache_hits);
 
         gf_proc_dump_build_key (key, "drc", "in_transit_duplicate_requests");
-        gf_proc_dump_write (key, "%d", drc->intransit_hits);
+        gf_proc_dump_write (key, "%"PRIu64, drc->intransit_hits);
+
+        gf_proc_dump_build_key (key, "drc", "checksum_mismatches");
+        gf_proc_dump_write (key, "%"PRIu64, drc->csum_mismatches);
+
+        gf_proc_dump_build_key (key, "drc", "evictions");
+        gf_proc_dump_write (key, "%"PRIu64, drc->evictions);
 
         list_for_each_entry (client, &drc->clients_head, client_list) {
                 gf_proc_dump_build_key (key, "client", "%d.ip-address", i);
@@ -592,6 +773,8 @@ rpcsvc_drc_priv (rpcsvc_drc_globals_t *drc)
                 gf_proc_dump_write (key, "%d", client->ref);
                 gf_proc_dump_build_key (key, "client", "%d.op_count", i);
                 gf_proc_dump_write (key, "%d", client->op_count);
+                gf_proc_dump_build_key (key, "client", "%d.mem_size", i);
+                gf_proc_dump_write (key, "%"PRIu64, client->mem_size);
                 i++;
         }
 
@@ -658,6 +841,28 @@ unlock:
         return ret;
 }
 
+/**
+ * rpcsvc_drc_get_mem_limit - bytes of cached replies allowed by the options
+ *
+ * @param options - the options dictionary which configures drc
+ * @return the configured limit, the default one if it is not set
+ */
+static uint64_t
+rpcsvc_drc_get_mem_limit (dict_t *options)
+{
+        char                       *str            = NULL;
+        uint64_t                    limit          = 0;
+
+        if (dict_get_str (options, "nfs.drc-mem-limit", &str) ||
+            gf_string2bytesize_uint64 (str, &limit)) {
+                gf_log (GF_RPCSVC, GF_LOG_DEBUG, "drc mem limit not set."
+                        " Continuing with default limit");
+                limit = DRC_DEFAULT_MEM_LIMIT;
+        }
+
+        return limit;
+}
+
 /**
  * rpcsvc_drc_init - Initialize the duplicate request cache service
  *
@@ -672,6 +877,7 @@ rpcsvc_drc_init (rpcsvc_t *svc, dict_t *options)
         uint32_t                    drc_type       = 0;
         uint32_t                    drc_size       = 0;
         uint32_t                    drc_factor     = 0;
+        uint32_t                    i              = 0;
         rpcsvc_drc_globals_t       *drc            = NULL;
 
         GF_ASSERT (svc);
@@ -698,6 +904,8 @@ rpcsvc_drc_init (rpcsvc_t *svc, dict_t *options)
                 return (-1);
 
         LOCK_INIT (&drc->lock);
+        for (i = 0; i < DRC_LOCK_STRIPES; i++)
+                LOCK_INIT (&drc->stripes[i]);
         svc->drc = drc;
 
         LOCK (&drc->lock);
@@ -741,8 +949,24 @@ rpcsvc_drc_init (rpcsvc_t *svc, dict_t *options)
 
         drc->lru_factor = (drc_lru_factor_t) drc_factor;
 
+        /* Bytes of replies to cache, 0 for no limit */
+        drc->mem_limit = rpcsvc_drc_get_mem_limit (options);
+
+        /* a bucket for every 4 ops at a full cache */
+        drc->bucket_count = DRC_MIN_BUCKETS;
+        while (drc->bucket_count < drc->global_cache_size / 4)
+                drc->bucket_count <<= 1;
+
+        drc->buckets = GF_CALLOC (drc->bucket_count, sizeof (*drc->buckets),
+                                  gf_common_mt_drc_buckets_t);
+        if (!drc->buckets) {
+                ret = -1;
+                goto out;
+        }
+        for (i = 0; i < drc->bucket_count; i++)
+                INIT_LIST_HEAD (&drc->buckets[i]);
+
         INIT_LIST_HEAD (&drc->clients_head);
-        INIT_LIST_HEAD (&drc->cache_head);
 
         ret = rpcsvc_register_notify (svc, rpcsvc_drc_notify, THIS);
         if (ret) {
@@ -760,6 +984,7 @@ rpcsvc_drc_init (rpcsvc_t *svc, dict_t *options)
                         mem_pool_destroy (drc->mempool);
                         drc->mempool = NULL;
                 }
+                GF_FREE (drc->buckets);
                 GF_FREE (drc);
                 svc->drc = NULL;
         }
@@ -784,6 +1009,8 @@ rpcsvc_drc_deinit (rpcsvc_t *svc)
                 mem_pool_destroy (drc->mempool);
                 drc->mempool = NULL;
         }
+        GF_FREE (drc->buckets);
+        drc->buckets = NULL;
         UNLOCK (&drc->lock);
 
         GF_FREE (drc);
@@ -825,6 +1052,8 @@ rpcsvc_drc_reconfigure (rpcsvc_t *svc, dict_t *options)
          *         sub-case 2: drc-size just changed
          *              ACTION: rpcsvc_drc_deinit() followed by
          *                      rpcsvc_drc_init().
+         *         drc-mem-limit is applied in place, the next eviction
+         *         brings the cache down to it.
          *
          *     case 2: DRC is "OFF"
          *         ACTION: rpcsvc_drc_deinit()
@@ -842,6 +1071,8 @@ rpcsvc_drc_reconfigure (rpcsvc_t *svc, dict_t *options)
                 if (dict_get_uint32 (options, "nfs.drc-size", &drc_size))
                         drc_size = DRC_DEFAULT_CACHE_SIZE;
 
+                drc->mem_limit = rpcsvc_drc_get_mem_limit (options);
+
                 /* case 1: sub-case 1*/
                 if (drc->global_cache_size == drc_size)
                         return (0);
@@ -15,16 +15,32 @@
 #include "rpcsvc.h"
 #include "locking.h"
 #include "dict.h"
-#include "rb.h"
+
+/* Cached ops are hashed on (xid, procnum, client) into a table of
+ * buckets, every bucket is guarded by one of DRC_LOCK_STRIPES locks so that
+ * requests from different clients or with different xids do not serialize
+ * on a single lock. Every client keeps its ops in LRU order on its own list,
+ * eviction takes the oldest ops of the clients holding the most memory.
+ */
+#define DRC_LOCK_STRIPES        64
+#define DRC_MIN_BUCKETS         1024
+
+/* bytes at the start of the arguments that are checksummed to tell a
+ * retransmission from a new request that reuses the xid */
+#define DRC_CSUM_LEN            256
 
 /* per-client cache structure */
 struct drc_client {
         uint32_t                   ref;
         union gf_sock_union        sock_union;
-        /* pointers to the cache */
-        struct rb_table           *rbtree;
+        /* guards lru, op_count and mem_size */
+        gf_lock_t                  lock;
+        /* cached ops, most recently used first */
+        struct list_head           lru;
         /* no. of ops currently cached */
         uint32_t                   op_count;
+        /* bytes of replies currently cached */
+        uint64_t                   mem_size;
         struct list_head           client_list;
 };
 
@@ -34,10 +50,13 @@ struct drc_cached_op {
         int                            prognum;
         int                            progversion;
         int                            procnum;
+        uint32_t                       csum;
+        uint32_t                       hash;
+        size_t                         size;
         rpc_transport_msg_t            msg;
         drc_client_t                  *client;
-        struct list_head               client_list;
-        struct list_head               global_list;
+        struct list_head               client_list; /* in client->lru */
+        struct list_head               hash_list;   /* in drc->buckets */
         int32_t                        ref;
 };
 
@@ -49,21 +68,26 @@ enum drc_status {
 typedef enum drc_status drc_status_t;
 
 struct drc_globals {
-        /* allocator must be the first member since
-         * it is used so in gf_libavl_allocator
-         */
-        struct libavl_allocator   allocator;
         drc_type_t                type;
-        /* configurable size parameter */
+        /* configurable size parameters */
         uint32_t                  global_cache_size;
+        uint64_t                  mem_limit;
         drc_lru_factor_t          lru_factor;
+        /* guards the client list and the client refs */
         gf_lock_t                 lock;
         drc_status_t              status;
+        /* below counters are updated atomically */
         uint32_t                  op_count;
+        uint64_t                  mem_size;
         uint64_t                  cache_hits;
         uint64_t                  intransit_hits;
+        uint64_t                  csum_mismatches;
+        uint64_t                  evictions;
+        uint32_t                  evicting;
         struct mem_pool          *mempool;
-        struct list_head          cache_head;
+        uint32_t                  bucket_count;
+        struct list_head         *buckets;
+        gf_lock_t                 stripes[DRC_LOCK_STRIPES];
         uint32_t                  client_count;
         struct list_head          clients_head;
 };
@@ -72,7 +96,10 @@ int
 rpcsvc_need_drc (rpcsvc_request_t *req);
 
 drc_cached_op_t *
-rpcsvc_drc_lookup (rpcsvc_request_t *req);
+rpcsvc_drc_lookup (rpcsvc_request_t *req, drc_op_state_t *state);
+
+void
+rpcsvc_drc_op_unref (rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply);
 
 int
 rpcsvc_send_cached_reply (rpcsvc_request_t *req, drc_cached_op_t *reply);
@@ -83,9 +110,6 @@ rpcsvc_cache_reply (rpcsvc_request_t *req, struct iobref *iobref,
                     struct iovec *proghdr, int proghdrcount,
                     struct iovec *payload, int payloadcount);
 
-int
-rpcsvc_cache_request (rpcsvc_request_t *req);
-
 int32_t
 rpcsvc_drc_priv (rpcsvc_drc_globals_t *drc);
 
@@ -581,6 +581,7 @@ rpcsvc_handle_rpc_call (rpcsvc_t *svc, rpc_transport_t *trans,
         gf_boolean_t            is_unix        = _gf_false;
         gf_boolean_t            unprivileged   = _gf_false;
         drc_cached_op_t        *reply          = NULL;
+        drc_op_state_t          drc_state      = DRC_OP_IN_TRANSIT;
         rpcsvc_drc_globals_t   *drc            = NULL;
 
         if (!trans || !svc)
@@ -642,35 +643,25 @@ rpcsvc_handle_rpc_call (rpcsvc_t *svc, rpc_transport_t *trans,
         if (rpcsvc_need_drc (req)) {
                 drc = req->svc->drc;
 
-                LOCK (&drc->lock);
-                {
-                        reply = rpcsvc_drc_lookup (req);
-
-                        /* retransmission of completed request, send cached reply */
-                        if (reply && reply->state == DRC_OP_CACHED) {
-                                gf_log (GF_RPCSVC, GF_LOG_INFO, "duplicate request:"
-                                        " XID: 0x%x", req->xid);
-                                ret = rpcsvc_send_cached_reply (req, reply);
-                                drc->cache_hits++;
-                                UNLOCK (&drc->lock);
-                                goto out;
-
-                        } /* retransmitted request, original op in transit, drop it */
-                        else if (reply && reply->state == DRC_OP_IN_TRANSIT) {
-                                gf_log (GF_RPCSVC, GF_LOG_INFO, "op in transit,"
-                                        " discarding. XID: 0x%x", req->xid);
-                                ret = 0;
-                                drc->intransit_hits++;
-                                rpcsvc_request_destroy (req);
-                                UNLOCK (&drc->lock);
-                                goto out;
-
-                        } /* fresh request, cache it as in-transit and proceed */
-                        else {
-                                ret = rpcsvc_cache_request (req);
-                        }
+                /* caches a fresh request as in-transit */
+                reply = rpcsvc_drc_lookup (req, &drc_state);
+
+                /* retransmission of completed request, send cached reply */
+                if (reply && drc_state == DRC_OP_CACHED) {
+                        gf_log (GF_RPCSVC, GF_LOG_INFO, "duplicate request:"
+                                " XID: 0x%x", req->xid);
+                        ret = rpcsvc_send_cached_reply (req, reply);
+                        goto out;
+
+                } /* retransmitted request, original op in transit, drop it */
+                else if (reply) {
+                        gf_log (GF_RPCSVC, GF_LOG_INFO, "op in transit,"
+                                " discarding. XID: 0x%x", req->xid);
+                        ret = 0;
+                        rpcsvc_drc_op_unref (drc, reply);
+                        rpcsvc_request_destroy (req);
+                        goto out;
                 }
-                UNLOCK (&drc->lock);
         }
 
         if (req->rpc_err == SUCCESS) {
@@ -1251,7 +1242,6 @@ rpcsvc_submit_generic (rpcsvc_request_t *req, struct iovec *proghdr,
         size_t                  msglen     = 0;
         size_t                  hdrlen     = 0;
         char                    new_iobref = 0;
-        rpcsvc_drc_globals_t   *drc        = NULL;
 
         if ((!req) || (!req->trans))
                 return -1;
@@ -1288,13 +1278,9 @@ rpcsvc_submit_generic (rpcsvc_request_t *req, struct iovec *proghdr,
 
         /* cache the request in the duplicate request cache for appropriate ops */
         if ((req->reply) && (rpcsvc_need_drc (req))) {
-                drc = req->svc->drc;
-
-                LOCK (&drc->lock);
                 ret = rpcsvc_cache_reply (req, iobref, &recordhdr, 1,
                                           proghdr, hdrcount,
                                           payload, payloadcount);
-                UNLOCK (&drc->lock);
         }
 
         ret = rpcsvc_transport_submit (trans, &recordhdr, 1, proghdr, hdrcount,
@@ -38,8 +38,27 @@
 #include <errno.h>
 #include <rpc/xdr.h>
 #include <sys/ioctl.h>
+
+/* for MSG_ZEROCOPY, with the kernel headers lacking the definitions */
+#if defined(GF_LINUX_HOST_OS)
+#include <linux/errqueue.h>
+#define GF_SOCKET_ZEROCOPY 1
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#endif
 #define GF_LOG_ERRNO(errno) ((errno == ENOTCONN) ? GF_LOG_DEBUG : GF_LOG_ERROR)
 #define SA(ptr) ((struct sockaddr *)ptr)
+#define SOCKET_WRITE_ZEROCOPY 2 /* as 'write' of __socket_rwv () */
 
 #define SSL_ENABLED_OPT     "transport.socket.ssl-enabled"
 #define SSL_OWN_CERT_OPT    "transport.socket.ssl-own-cert"
@@ -491,6 +510,37 @@ __does_socket_rwv_error_need_logging (socket_private_t *priv, int write)
         return _gf_true;
 }
 
+/* Sends without copying the buffers into the kernel, which reports when it
+ * is done with them on the error queue. Every successful call is one more
+ * zerocopy send id.
+ */
+static ssize_t
+__socket_sendmsg_zerocopy (rpc_transport_t *this, struct iovec *vector,
+                           int count)
+{
+        socket_private_t *priv = this->private;
+        ssize_t           ret  = -1;
+#ifdef GF_SOCKET_ZEROCOPY
+        struct msghdr     msg  = {0, };
+
+        msg.msg_iov = vector;
+        msg.msg_iovlen = count;
+
+        ret = sendmsg (priv->sock, &msg, MSG_ZEROCOPY);
+        if (ret >= 0) {
+                priv->zc_next++;
+                return ret;
+        }
+
+        /* no memory left for the completions, copy this time */
+        if (errno != ENOBUFS)
+                return ret;
+#endif
+        ret = sys_writev (priv->sock, vector, count);
+
+        return ret;
+}
+
 /*
  * return value:
  *   0 = success (completed)
@@ -543,6 +593,9 @@ __socket_rwv (rpc_transport_t *this, struct iovec *vector, int count,
 			if (priv->use_ssl) {
                                 ret = ssl_write_one (this, opvector->iov_base,
                                                      opvector->iov_len);
+			} else if (write == SOCKET_WRITE_ZEROCOPY) {
+                                ret = __socket_sendmsg_zerocopy
+                                        (this, opvector, IOV_MIN(opcount));
 			} else {
 				ret = sys_writev (sock, opvector, IOV_MIN(opcount));
 			}
@@ -667,6 +720,50 @@ __socket_writev (rpc_transport_t *this, struct iovec *vector, int count,
 }
 
 
+static int
+__socket_writev_zerocopy (rpc_transport_t *this, struct iovec *vector,
+                          int count, struct iovec **pending_vector,
+                          int *pending_count)
+{
+        int ret = -1;
+
+        ret = __socket_rwv (this, vector, count,
+                            pending_vector, pending_count, NULL,
+                            SOCKET_WRITE_ZEROCOPY);
+
+        return ret;
+}
+
+
+static void
+__socket_zerocopy_enable (rpc_transport_t *this, int sock, int family)
+{
+        socket_private_t *priv = this->private;
+#ifdef GF_SOCKET_ZEROCOPY
+        int               on   = 1;
+#endif
+
+        priv->zerocopy = _gf_false;
+        priv->zc_next = 0;
+        priv->zc_done = 0;
+
+        if (!priv->zerocopy_threshold || priv->use_ssl || priv->own_thread ||
+            (family == AF_UNIX))
+                return;
+
+#ifdef GF_SOCKET_ZEROCOPY
+        if (setsockopt (sock, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof (on))) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "SO_ZEROCOPY on %d failed (%s), copying writes",
+                        sock, strerror (errno));
+                return;
+        }
+
+        priv->zerocopy = _gf_true;
+#endif
+}
+
+
 static int
 __socket_shutdown (rpc_transport_t *this)
 {
@@ -937,6 +1034,9 @@ __socket_reset (rpc_transport_t *this)
         priv->sock = -1;
         priv->idx = -1;
         priv->connected = -1;
+        priv->zerocopy = _gf_false;
+        priv->zc_next = 0;
+        priv->zc_done = 0;
 
 out:
         return;
@@ -967,6 +1067,7 @@ socket_set_last_frag_header_size (uint32_t size, char *haddr)
 static struct ioq *
 __socket_ioq_new (rpc_transport_t *this, rpc_transport_msg_t *msg)
 {
+        socket_private_t *priv  = NULL;
         struct ioq       *entry = NULL;
         int               count = 0;
         uint32_t          size  = 0;
@@ -1024,6 +1125,10 @@ __socket_ioq_new (rpc_transport_t *this, rpc_transport_msg_t *msg)
         if (msg->iobref != NULL)
                 entry->iobref = iobref_ref (msg->iobref);
 
+        priv = this->private;
+        if (priv->zerocopy && (size >= priv->zerocopy_threshold))
+                entry->zerocopy = _gf_true;
+
         INIT_LIST_HEAD (&entry->list);
 
 out:
@@ -1064,28 +1169,119 @@ __socket_ioq_flush (rpc_transport_t *this)
                 __socket_ioq_entry_free (entry);
         }
 
+        while (!list_empty (&priv->zc_pending)) {
+                entry = list_entry (priv->zc_pending.next, struct ioq, list);
+                __socket_ioq_entry_free (entry);
+        }
+
 out:
         return;
 }
 
 
+/*
+ * Frees the written entries of zerocopy sends the kernel reported as
+ * complete on the error queue of the socket.
+ *
+ * return value: the number of completions read
+ */
+static int
+__socket_zerocopy_reap (rpc_transport_t *this)
+{
+        int                       reaped  = 0;
+#ifdef GF_SOCKET_ZEROCOPY
+        socket_private_t         *priv    = NULL;
+        struct ioq               *entry   = NULL;
+        struct ioq               *tmp     = NULL;
+        struct msghdr             msg     = {0, };
+        struct cmsghdr           *cmsg    = NULL;
+        struct sock_extended_err *serr    = NULL;
+        char                      control[128];
+
+        priv = this->private;
+
+        for (;;) {
+                memset (&msg, 0, sizeof (msg));
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof (control);
+
+                if (recvmsg (priv->sock, &msg, MSG_ERRQUEUE) == -1)
+                        break;
+
+                for (cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+                     cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+                        if (!((cmsg->cmsg_level == SOL_IP &&
+                               cmsg->cmsg_type == IP_RECVERR) ||
+                              (cmsg->cmsg_level == SOL_IPV6 &&
+                               cmsg->cmsg_type == IPV6_RECVERR)))
+                                continue;
+
+                        serr = (struct sock_extended_err *)CMSG_DATA (cmsg);
+                        if ((serr->ee_errno != 0) ||
+                            (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+                                continue;
+
+                        /* sends [ee_info, ee_data] are done, TCP completes
+                         * them in order */
+                        priv->zc_done = serr->ee_data + 1;
+                        reaped++;
+
+                        if (priv->zerocopy &&
+                            (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)) {
+                                /* the device cannot send from our pages */
+                                gf_log (this->name, GF_LOG_DEBUG,
+                                        "zerocopy sends on %d were copied, "
+                                        "copying writes", priv->sock);
+                                priv->zerocopy = _gf_false;
+                        }
+                }
+        }
+
+        list_for_each_entry_safe (entry, tmp, &priv->zc_pending, list) {
+                if ((int32_t)(entry->zc_last - priv->zc_done) >= 0)
+                        break;
+                __socket_ioq_entry_free (entry);
+        }
+#endif
+        return reaped;
+}
+
+
 static int
 __socket_ioq_churn_entry (rpc_transport_t *this, struct ioq *entry, int direct)
 {
         int               ret = -1;
 	socket_private_t *priv = NULL;
 	char              a_byte = 0;
+        uint32_t          zc_next = 0;
 
-        ret = __socket_writev (this, entry->pending_vector,
-                               entry->pending_count,
-                               &entry->pending_vector,
-                               &entry->pending_count);
+        priv = this->private;
+        zc_next = priv->zc_next;
+
+        if (entry->zerocopy && priv->zerocopy)
+                ret = __socket_writev_zerocopy (this, entry->pending_vector,
+                                                entry->pending_count,
+                                                &entry->pending_vector,
+                                                &entry->pending_count);
+        else
+                ret = __socket_writev (this, entry->pending_vector,
+                                       entry->pending_count,
+                                       &entry->pending_vector,
+                                       &entry->pending_count);
+
+        if (priv->zc_next != zc_next) {
+                entry->zc_sent = _gf_true;
+                entry->zc_last = priv->zc_next - 1;
+        }
 
         if (ret == 0) {
                 /* current entry was completely written */
                 GF_ASSERT (entry->pending_count == 0);
-                __socket_ioq_entry_free (entry);
-		priv = this->private;
+                if (entry->zc_sent)
+                        /* freed once the kernel is done with the buffers */
+                        list_move_tail (&entry->list, &priv->zc_pending);
+                else
+                        __socket_ioq_entry_free (entry);
 		if (priv->own_thread) {
 			/*
 			 * The pipe should only remain readable if there are
@@ -2345,6 +2541,12 @@ socket_event_handler (int fd, int idx, void *data,
         pthread_mutex_lock (&priv->lock);
         {
                 priv->idx = idx;
+
+                /* completions of zerocopy sends are reported as errors */
+                if (poll_err && (priv->zc_next != priv->zc_done) &&
+                    __socket_zerocopy_reap (this) &&
+                    !__socket_connect_finish (priv->sock))
+                        poll_err = 0;
         }
         pthread_mutex_unlock (&priv->lock);
 
@@ -2716,6 +2918,11 @@ socket_server_event_handler (int fd, int idx, void *data,
 			new_priv->sock = new_sock;
 			new_priv->own_thread = priv->own_thread;
 
+                        new_priv->zerocopy_threshold =
+                                priv->zerocopy_threshold;
+                        __socket_zerocopy_enable (new_trans, new_sock,
+                                                  new_sockaddr.ss_family);
+
                         new_priv->ssl_ctx = priv->ssl_ctx;
 			if (new_priv->use_ssl && !new_priv->own_thread) {
 				cname = ssl_setup_connection(new_trans,1);
@@ -2989,6 +3196,8 @@ socket_connect (rpc_transport_t *this, int port)
                                         strerror (errno));
                 }
 
+                __socket_zerocopy_enable (this, priv->sock, sa_family);
+
                 SA (&this->myinfo.sockaddr)->sa_family =
                         SA (&this->peerinfo.sockaddr)->sa_family;
 
@@ -3638,6 +3847,19 @@ reconfigure (rpc_transport_t *this, dict_t *options)
 
         priv->windowsize = (int)windowsize;
 
+        optstr = NULL;
+        priv->zerocopy_threshold = 0;
+        if (dict_get_str (this->options, "transport.socket.zerocopy-threshold",
+                          &optstr) == 0) {
+                if (gf_string2bytesize_uint64 (optstr,
+                                               &priv->zerocopy_threshold)) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format: %s", optstr);
+                        ret = -1;
+                        goto out;
+                }
+        }
+
         if (dict_get (this->options, "non-blocking-io")) {
                 optstr = data_to_str (dict_get (this->options,
                                                 "non-blocking-io"));
@@ -3780,6 +4002,7 @@ socket_init (rpc_transport_t *this)
         priv->bio = 0;
         priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
         INIT_LIST_HEAD (&priv->ioq);
+        INIT_LIST_HEAD (&priv->zc_pending);
 
         /* All the below section needs 'this->options' to be present */
         if (!this->options)
@@ -3878,6 +4101,16 @@ socket_init (rpc_transport_t *this)
                 priv->backlog = backlog;
         }
 
+        if (dict_get_str (this->options, "transport.socket.zerocopy-threshold",
+                          &optstr) == 0) {
+                if (gf_string2bytesize_uint64 (optstr,
+                                               &priv->zerocopy_threshold)) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format: %s", optstr);
+                        return -1;
+                }
+        }
+
         optstr = NULL;
 
          /* Check if socket read failures are to be logged */
@@ -4290,6 +4523,9 @@ struct volume_options options[] = {
         { .key   = {"transport.socket.read-fail-log"},
           .type  = GF_OPTION_TYPE_BOOL
         },
+        { .key   = {"transport.socket.zerocopy-threshold"},
+          .type  = GF_OPTION_TYPE_SIZET
+        },
         { .key   = {SSL_ENABLED_OPT},
           .type  = GF_OPTION_TYPE_BOOL
         },
@@ -109,6 +109,9 @@ struct ioq {
         struct iovec      *pending_vector;
         int                pending_count;
         struct iobref     *iobref;
+        gf_boolean_t       zerocopy;    /* send with MSG_ZEROCOPY */
+        gf_boolean_t       zc_sent;     /* kernel may still use the buffers */
+        uint32_t           zc_last;     /* id of the last zerocopy send */
 };
 
 typedef struct {
@@ -240,6 +243,11 @@ typedef struct {
         uint32_t               ot_gen;
         gf_boolean_t           is_server;
         int                    log_ctr;
+        uint64_t               zerocopy_threshold;
+        gf_boolean_t           zerocopy;        /* SO_ZEROCOPY is set */
+        uint32_t               zc_next;         /* id of the next send */
+        uint32_t               zc_done;         /* sends before are complete */
+        struct list_head       zc_pending;      /* written, not complete */
 } socket_private_t;
 
 
@@ -45,6 +45,7 @@ enum gf_bitrot_type {
         GF_BITROT_OPTION_TYPE_SCRUB,
         GF_BITROT_OPTION_TYPE_EXPIRY_TIME,
         GF_BITROT_CMD_SCRUB_STATUS,
+        GF_BITROT_OPTION_TYPE_SCRUB_RATE,
         GF_BITROT_OPTION_TYPE_MAX
 };
 
@@ -0,0 +1,55 @@
+#!/bin/bash
+#
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function trace_file() {
+        local pid=$1
+        ls $statedumpdir | grep -E "\.$pid\.trace\..*\.json$" | head -1
+}
+
+function count_trace_events() {
+        local pid=$1
+        local fop=$2
+        local fname=$(trace_file $pid)
+        grep -c "\"name\":\"$fop\"" $statedumpdir/$fname
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 diagnostics.fop-trace on
+TEST $CLI volume start $V0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0 --attribute-timeout=0 --entry-timeout=0
+
+for i in {1..5}
+do
+        dd if=/dev/zero of=${M0}/testfile$i bs=4k count=1
+done
+
+TEST ls -l $M0
+
+brick_pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+rm -f $statedumpdir/*$brick_pid.trace.*
+generate_statedump $brick_pid
+EXPECT_NOT "" trace_file $brick_pid
+EXPECT_NOT "0" count_trace_events $brick_pid WRITE
+EXPECT_NOT "0" count_trace_events $brick_pid LOOKUP
+
+# the trace must be valid JSON for chrome://tracing / perfetto
+TEST python -c "import json,sys; json.load(open(sys.argv[1]))" \
+     $statedumpdir/$(trace_file $brick_pid)
+
+mount_pid=$(get_mount_process_pid $V0)
+generate_statedump $mount_pid
+EXPECT_NOT "0" count_trace_events $mount_pid WRITE
+
+TEST $CLI volume set $V0 diagnostics.fop-trace off
+rm -f $statedumpdir/*$brick_pid.trace.*
+generate_statedump $brick_pid
+EXPECT "" trace_file $brick_pid
+
+rm -f $statedumpdir/*.trace.*
+cleanup
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+
+#define NUM_FILES       100
+#define XATTR_NAME      "user.batch"
+
+#define VALIDATE_AND_GOTO_LABEL_ON_ERROR(func, ret, label) do { \
+        if (ret < 0) {            \
+                fprintf (stderr, "%s : returned error %d (%s)\n", \
+                         func, ret, strerror (errno)); \
+                goto label; \
+        } \
+        } while (0)
+
+#define CHECK_AND_GOTO_LABEL(func, cond, label) do { \
+        if (!(cond)) {            \
+                fprintf (stderr, "%s : %s failed\n", func, #cond); \
+                ret = -1; \
+                goto label; \
+        } \
+        } while (0)
+
+int
+main (int argc, char *argv[])
+{
+        int                     ret = -1;
+        int                     i = 0;
+        glfs_t                 *fs = NULL;
+        char                   *volname = NULL;
+        char                   *logfile = NULL;
+        char                   *hostname = NULL;
+        struct glfs_object     *dir = NULL;
+        struct glfs_object     *files[NUM_FILES] = {NULL, };
+        struct glfs_object     *objects[NUM_FILES + 2] = {NULL, };
+        const char             *names[NUM_FILES + 2] = {NULL, };
+        char                    namebuf[NUM_FILES][32];
+        struct stat             stats[NUM_FILES + 2];
+        int                     errnos[NUM_FILES + 2];
+        char                    valbuf[NUM_FILES][32];
+        void                   *values[NUM_FILES];
+        ssize_t                 lens[NUM_FILES];
+        char                    value[32];
+
+        if (argc != 4) {
+                fprintf (stderr, "Invalid argument\n");
+                return 1;
+        }
+
+        hostname = argv[1];
+        volname = argv[2];
+        logfile = argv[3];
+
+        fs = glfs_new (volname);
+        if (!fs)
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_new", ret, out);
+
+        ret = glfs_set_volfile_server (fs, "tcp", hostname, 24007);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_volfile_server", ret, out);
+
+        ret = glfs_set_logging (fs, logfile, 7);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_logging", ret, out);
+
+        ret = glfs_init (fs);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_init", ret, out);
+
+        dir = glfs_h_mkdir (fs, NULL, "batch", 0755, NULL);
+        if (!dir) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_mkdir", ret, out);
+        }
+
+        for (i = 0; i < NUM_FILES; i++) {
+                snprintf (namebuf[i], sizeof (namebuf[i]), "file%d", i);
+                files[i] = glfs_h_creat (fs, dir, namebuf[i], O_RDWR, 0644,
+                                         NULL);
+                if (!files[i]) {
+                        ret = -1;
+                        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_creat",
+                                                          ret, out);
+                }
+
+                snprintf (value, sizeof (value), "value%d", i);
+                ret = glfs_h_setxattrs (fs, files[i], XATTR_NAME, value,
+                                        strlen (value), 0);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_setxattrs", ret,
+                                                  out);
+
+                names[i] = namebuf[i];
+        }
+
+        /* a missing name and a name of more than one component */
+        names[NUM_FILES] = "missing";
+        names[NUM_FILES + 1] = "../batch/file0";
+
+        ret = glfs_h_lookupat_batch (fs, dir, names, NUM_FILES + 2, objects,
+                                     stats, errnos, 0);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_lookupat_batch", ret, out);
+        CHECK_AND_GOTO_LABEL ("glfs_h_lookupat_batch", ret == NUM_FILES + 1,
+                              out);
+        CHECK_AND_GOTO_LABEL ("glfs_h_lookupat_batch",
+                              errnos[NUM_FILES] == ENOENT &&
+                              !objects[NUM_FILES], out);
+        CHECK_AND_GOTO_LABEL ("glfs_h_lookupat_batch",
+                              errnos[NUM_FILES + 1] == 0 &&
+                              stats[NUM_FILES + 1].st_ino == stats[0].st_ino,
+                              out);
+        for (i = 0; i < NUM_FILES; i++)
+                CHECK_AND_GOTO_LABEL ("glfs_h_lookupat_batch",
+                                      errnos[i] == 0 && objects[i] &&
+                                      S_ISREG (stats[i].st_mode), out);
+
+        memset (stats, 0, sizeof (stats));
+        ret = glfs_h_stat_batch (fs, files, NUM_FILES, stats, errnos);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_stat_batch", ret, out);
+        CHECK_AND_GOTO_LABEL ("glfs_h_stat_batch", ret == NUM_FILES, out);
+        for (i = 0; i < NUM_FILES; i++)
+                CHECK_AND_GOTO_LABEL ("glfs_h_stat_batch",
+                                      errnos[i] == 0 &&
+                                      S_ISREG (stats[i].st_mode), out);
+
+        for (i = 0; i < NUM_FILES; i++)
+                values[i] = valbuf[i];
+
+        ret = glfs_h_getxattrs_batch (fs, files, NUM_FILES, XATTR_NAME,
+                                      values, sizeof (valbuf[0]), lens,
+                                      errnos);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_getxattrs_batch", ret, out);
+        CHECK_AND_GOTO_LABEL ("glfs_h_getxattrs_batch", ret == NUM_FILES,
+                              out);
+        for (i = 0; i < NUM_FILES; i++) {
+                snprintf (value, sizeof (value), "value%d", i);
+                CHECK_AND_GOTO_LABEL ("glfs_h_getxattrs_batch",
+                                      errnos[i] == 0 &&
+                                      lens[i] == strlen (value) &&
+                                      !memcmp (valbuf[i], value, lens[i]),
+                                      out);
+        }
+
+        ret = 0;
+out:
+        for (i = 0; i < NUM_FILES + 2; i++) {
+                if (objects[i])
+                        glfs_h_close (objects[i]);
+        }
+        for (i = 0; i < NUM_FILES; i++) {
+                if (files[i])
+                        glfs_h_close (files[i]);
+        }
+        if (dir)
+                glfs_h_close (dir);
+        if (fs) {
+                if (glfs_fini (fs))
+                        fprintf (stderr, "glfs_fini(fs) returned error\n");
+        }
+
+        return ret;
+}
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+
+#define DEPTH           16
+#define NUM_BLOCKS      8
+#define BLOCK_SIZE      4096
+
+#define VALIDATE_AND_GOTO_LABEL_ON_ERROR(func, ret, label) do { \
+        if (ret < 0) {            \
+                fprintf (stderr, "%s : returned error %d (%s)\n", \
+                         func, ret, strerror (errno)); \
+                goto label; \
+        } \
+        } while (0)
+
+#define CHECK_AND_GOTO_LABEL(func, cond, label) do { \
+        if (!(cond)) {            \
+                fprintf (stderr, "%s : %s failed\n", func, #cond); \
+                ret = -1; \
+                goto label; \
+        } \
+        } while (0)
+
+/* reaps exactly @count completions, all of @op and successful */
+static int
+reap (glfs_cq_t *cq, struct glfs_cqe *cqes, int count, int op)
+{
+        int             ret = 0;
+        int             i = 0;
+
+        ret = glfs_cq_reap (cq, cqes, count, count);
+        if (ret != count) {
+                fprintf (stderr, "glfs_cq_reap : got %d of %d\n", ret, count);
+                return -1;
+        }
+
+        for (i = 0; i < count; i++) {
+                if (cqes[i].op != op || cqes[i].ret < 0) {
+                        fprintf (stderr, "op %d : returned %zd (%s)\n",
+                                 cqes[i].op, cqes[i].ret,
+                                 strerror (cqes[i].op_errno));
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+        int                     ret = -1;
+        int                     i = 0;
+        glfs_t                 *fs = NULL;
+        glfs_fd_t              *fd = NULL;
+        glfs_cq_t              *cq = NULL;
+        glfs_buf_t             *buf = NULL;
+        char                   *volname = NULL;
+        char                   *logfile = NULL;
+        char                   *hostname = NULL;
+        struct glfs_object     *root = NULL;
+        struct glfs_object     *object = NULL;
+        struct glfs_cqe         cqes[DEPTH];
+        struct pollfd           pfd = {0, };
+        char                    block[BLOCK_SIZE];
+        char                   *ptr = NULL;
+        int                     off = 0;
+        int                     j = 0;
+
+        if (argc != 4) {
+                fprintf (stderr, "Invalid argument\n");
+                return 1;
+        }
+
+        hostname = argv[1];
+        volname = argv[2];
+        logfile = argv[3];
+
+        fs = glfs_new (volname);
+        if (!fs)
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_new", ret, out);
+
+        ret = glfs_set_volfile_server (fs, "tcp", hostname, 24007);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_volfile_server", ret, out);
+
+        ret = glfs_set_logging (fs, logfile, 7);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_logging", ret, out);
+
+        ret = glfs_init (fs);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_init", ret, out);
+
+        fd = glfs_creat (fs, "cq_file", O_RDWR, 0644);
+        if (!fd) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_creat", ret, out);
+        }
+        glfs_close (fd);
+        fd = NULL;
+
+        root = glfs_h_lookupat (fs, NULL, "/", NULL, 0);
+        if (!root) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_h_lookupat", ret, out);
+        }
+
+        cq = glfs_cq_new (fs, DEPTH);
+        if (!cq) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_new", ret, out);
+        }
+
+        /* lookup and open */
+        ret = glfs_cq_h_lookupat (cq, root, "cq_file", NULL);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_h_lookupat", ret, out);
+
+        pfd.fd = glfs_cq_fd (cq);
+        pfd.events = POLLIN;
+        ret = poll (&pfd, 1, 10000);
+        CHECK_AND_GOTO_LABEL ("glfs_cq_fd", ret == 1, out);
+
+        ret = reap (cq, cqes, 1, GLFS_CQ_OP_H_LOOKUPAT);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap lookup", ret, out);
+        object = cqes[0].object;
+        CHECK_AND_GOTO_LABEL ("glfs_cq_h_lookupat",
+                              object && S_ISREG (cqes[0].stat.st_mode), out);
+
+        ret = poll (&pfd, 1, 0);
+        CHECK_AND_GOTO_LABEL ("glfs_cq_fd", ret == 0, out);
+
+        ret = glfs_cq_h_open (cq, object, O_RDWR, NULL);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_h_open", ret, out);
+        ret = reap (cq, cqes, 1, GLFS_CQ_OP_H_OPEN);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap open", ret, out);
+        fd = cqes[0].fd;
+        CHECK_AND_GOTO_LABEL ("glfs_cq_h_open", fd != NULL, out);
+
+        /* writes from a buffer of gfapi, put back right away */
+        buf = glfs_buf_get (fs, BLOCK_SIZE);
+        CHECK_AND_GOTO_LABEL ("glfs_buf_get",
+                              buf && glfs_buf_size (buf) >= BLOCK_SIZE, out);
+        memset (glfs_buf_ptr (buf), 'a', BLOCK_SIZE);
+
+        for (i = 0; i < NUM_BLOCKS; i++) {
+                ret = glfs_cq_pwrite (cq, fd, buf, BLOCK_SIZE,
+                                      i * BLOCK_SIZE, 0, NULL);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_pwrite", ret, out);
+        }
+        glfs_buf_put (buf);
+        buf = NULL;
+
+        ret = reap (cq, cqes, NUM_BLOCKS, GLFS_CQ_OP_PWRITE);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap pwrite", ret, out);
+        for (i = 0; i < NUM_BLOCKS; i++)
+                CHECK_AND_GOTO_LABEL ("glfs_cq_pwrite",
+                                      cqes[i].ret == BLOCK_SIZE, out);
+
+        /* a buffer put back after its write is reaped is not reused for
+           new data while write caching still holds on to it */
+        for (i = 0; i < NUM_BLOCKS; i++) {
+                buf = glfs_buf_get (fs, BLOCK_SIZE);
+                CHECK_AND_GOTO_LABEL ("glfs_buf_get", buf != NULL, out);
+                memset (glfs_buf_ptr (buf), 'A' + i, BLOCK_SIZE);
+
+                ret = glfs_cq_pwrite (cq, fd, buf, BLOCK_SIZE,
+                                      i * BLOCK_SIZE, 0, NULL);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_pwrite", ret, out);
+                ret = reap (cq, cqes, 1, GLFS_CQ_OP_PWRITE);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap pwrite", ret, out);
+
+                glfs_buf_put (buf);
+                buf = NULL;
+        }
+
+        ret = glfs_cq_fsync (cq, fd, NULL);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_fsync", ret, out);
+        ret = reap (cq, cqes, 1, GLFS_CQ_OP_FSYNC);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap fsync", ret, out);
+
+        ret = glfs_cq_h_stat (cq, object, NULL);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_h_stat", ret, out);
+        ret = reap (cq, cqes, 1, GLFS_CQ_OP_H_STAT);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap stat", ret, out);
+        CHECK_AND_GOTO_LABEL ("glfs_cq_h_stat",
+                              cqes[0].stat.st_size == NUM_BLOCKS * BLOCK_SIZE,
+                              out);
+
+        /* reads into the buffers of the graph */
+        for (i = 0; i < NUM_BLOCKS; i++) {
+                ret = glfs_cq_pread (cq, fd, BLOCK_SIZE, i * BLOCK_SIZE, 0,
+                                     (void *)(intptr_t) i);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_pread", ret, out);
+        }
+        ret = reap (cq, cqes, NUM_BLOCKS, GLFS_CQ_OP_PREAD);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap pread", ret, out);
+        for (i = 0; i < NUM_BLOCKS; i++) {
+                CHECK_AND_GOTO_LABEL ("glfs_cq_pread",
+                                      cqes[i].ret == BLOCK_SIZE, out);
+                memset (block, 'A' + (intptr_t) cqes[i].data, BLOCK_SIZE);
+                for (off = 0, j = 0; j < cqes[i].iovcnt; j++) {
+                        ptr = cqes[i].iov[j].iov_base;
+                        CHECK_AND_GOTO_LABEL ("glfs_cq_pread",
+                                              !memcmp (ptr, block + off,
+                                                       cqes[i].iov[j].iov_len),
+                                              out);
+                        off += cqes[i].iov[j].iov_len;
+                }
+                CHECK_AND_GOTO_LABEL ("glfs_cq_pread", off == BLOCK_SIZE,
+                                      out);
+                glfs_cq_release (&cqes[i]);
+        }
+
+        /* no more than DEPTH ops in flight or waiting to be reaped */
+        for (i = 0; i < DEPTH; i++) {
+                ret = glfs_cq_fstat (cq, fd, NULL);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_cq_fstat", ret, out);
+        }
+        ret = glfs_cq_fstat (cq, fd, NULL);
+        CHECK_AND_GOTO_LABEL ("glfs_cq_fstat", ret == -1 && errno == EAGAIN,
+                              out);
+        ret = reap (cq, cqes, DEPTH, GLFS_CQ_OP_FSTAT);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("reap fstat", ret, out);
+
+        ret = 0;
+out:
+        if (buf)
+                glfs_buf_put (buf);
+        if (cq && glfs_cq_destroy (cq))
+                fprintf (stderr, "glfs_cq_destroy returned error\n");
+        if (fd)
+                glfs_close (fd);
+        if (object)
+                glfs_h_close (object);
+        if (root)
+                glfs_h_close (root);
+        if (fs) {
+                if (glfs_fini (fs))
+                        fprintf (stderr, "glfs_fini(fs) returned error\n");
+        }
+
+        return ret;
+}
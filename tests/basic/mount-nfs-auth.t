@@ -32,6 +32,8 @@ V0L3="$V0L2/L3"
 EXPORT_ALLOW_RO="/$V0 $H0(sec=sys,ro,anonuid=0) @ngtop(sec=sys,ro,anonuid=0)"
 EXPORT_ALLOW_L1="/$V0L1 $H0(sec=sys,rw,anonuid=0) @ngtop(sec=sys,rw,anonuid=0)"
 EXPORT_WILDCARD="/$V0 *(sec=sys,rw,anonuid=0) @ngtop(sec=sys,rw,anonuid=0)"
+EXPORT_NETWORK="/$V0 1.2.3.0/24(sec=sys,ro) 0.0.0.0/0(sec=sys,rw,anonuid=0)"
+EXPORT_NETWORK_DENY="/$V0 1.2.3.0/24(sec=sys,rw,anonuid=0)"
 
 function build_dirs () {
         mkdir -p $B0/b{0,1,2}/L1/L2/L3
@@ -57,6 +59,14 @@ function export_allow_wildcard () {
         printf "$EXPORT_WILDCARD\n" > ${NFSDIR}/exports
 }
 
+function export_allow_network () {
+        printf "$EXPORT_NETWORK\n" > ${NFSDIR}/exports
+}
+
+function export_deny_network () {
+        printf "$EXPORT_NETWORK_DENY\n" > ${NFSDIR}/exports
+}
+
 function export_allow_this_host_ro () {
         printf "$EXPORT_ALLOW_RO\n" > ${NFSDIR}/exports
 }
@@ -295,6 +305,21 @@ EXPECT "Y" check_mount_success $V0/
 EXPECT "Y" small_write
 EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" umount_nfs $N0
 
+## Test networks, the longest one containing the address applies
+TEST export_allow_network
+TEST netgroup_deny_this_host
+restart_nfs
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available
+
+EXPECT_WITHIN $MY_MOUNT_TIMEOUT "Y" check_mount_success $V0
+EXPECT "Y" small_write
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" umount_nfs $N0
+
+TEST export_deny_network
+restart_nfs
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available
+EXPECT "Y" check_mount_failure $V0
+
 
 ## Turn off exports authentication
 $CLI vol stop $V0
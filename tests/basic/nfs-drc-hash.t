@@ -0,0 +1,40 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+function drc_value() {
+        local key=$1
+        local fpath=$(generate_nfs_statedump)
+        grep -a "^drc.$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/$V0
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume set $V0 nfs.drc on
+TEST $CLI volume start $V0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available;
+TEST mount_nfs $H0:/$V0 $N0 nolock
+
+# non-idempotent requests are cached with their replies
+for i in $(seq 1 100); do echo $i > $N0/file$i; done
+EXPECT_NOT "0" drc_value current_cache_size
+EXPECT_NOT "0" drc_value current_mem_size
+EXPECT "0" drc_value evictions
+
+# replies above the memory limit are evicted
+TEST $CLI volume set $V0 nfs.drc-mem-limit 16KB
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available;
+EXPECT "16384" drc_value mem_limit
+for i in $(seq 1 100); do rm -f $N0/file$i; done
+EXPECT_NOT "0" drc_value evictions
+TEST [ $(drc_value current_mem_size) -le 16384 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+cleanup;
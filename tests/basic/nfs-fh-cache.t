@@ -0,0 +1,51 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+function fh_cache_value() {
+        local key=$1
+        local fpath=$(generate_nfs_statedump)
+        grep -a "^fh-cache.$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/$V0
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume set $V0 nfs.negative-lookup-timeout 30
+TEST $CLI volume start $V0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available;
+TEST mount_nfs $H0:/$V0 $N0 nolock,lookupcache=none
+EXPECT "30" fh_cache_value negative_timeout
+
+# resolved file handles keep their inodes
+TEST mkdir $N0/dir
+TEST touch $N0/dir/file
+TEST stat $N0/dir/file
+EXPECT_NOT "0" fh_cache_value inodes
+
+# names not found are answered from the cache the second time
+TEST ! stat $N0/dir/missing
+TEST ! stat $N0/dir/missing
+EXPECT_NOT "0" fh_cache_value negative_hits
+
+# creating the name through the server drops it from the cache
+TEST touch $N0/dir/missing
+TEST stat $N0/dir/missing
+
+# and so does renaming another name onto it
+TEST ! stat $N0/dir/other
+TEST mv $N0/dir/missing $N0/dir/other
+TEST stat $N0/dir/other
+
+TEST $CLI volume set $V0 nfs.negative-lookup-timeout 0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available;
+EXPECT "0" fh_cache_value negative_entries
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+cleanup;
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/$V0
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume set $V0 nfs.zerocopy-threshold 64KB
+TEST $CLI volume start $V0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT "1" is_nfs_export_available;
+TEST mount_nfs $H0:/$V0 $N0 nolock,rsize=1048576,wsize=1048576
+
+# large READ replies are sent with zerocopy, small ones are copied, and the
+# buffers stay untouched until the kernel is done with them
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST cp $B0/data $N0/data
+TEST dd if=/dev/urandom of=$N0/small bs=1k count=4
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+TEST mount_nfs $H0:/$V0 $N0 nolock,rsize=1048576,wsize=1048576
+
+TEST cmp $B0/data $N0/data
+TEST cmp $B0/$V0/small $N0/small
+for i in 1 2 3 4; do
+        dd if=$N0/data of=/dev/null bs=1M 2>/dev/null &
+done
+wait
+TEST cmp $B0/data $N0/data
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+rm -f $B0/data
+cleanup;
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_cache_value() {
+        local key=$1
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 \
+     --volfile-id=$V0 $M0
+
+TEST mkdir -p $M0/a/b/c/d/e/f/g/h
+TEST touch $M0/a/b/c/d/e/f/g/h/file
+TEST stat $M0/a/b/c/d/e/f/g/h/file
+TEST stat $M0/a/b/c/d/e/f/g/h/file
+EXPECT_NOT "0" brick_cache_value dir_handle_cache_hits
+EXPECT_NOT "0" brick_cache_value dir_handle_cache_entries
+
+# the paths below a renamed directory have to change
+TEST mv $M0/a/b/c $M0/a/c
+TEST touch $M0/a/c/d/e/f/g/h/file2
+TEST [ -f $B0/${V0}0/a/c/d/e/f/g/h/file2 ]
+TEST [ ! -e $B0/${V0}0/a/b/c ]
+
+# and a removed one must not be found through the cache
+TEST rmdir $M0/a/b
+TEST mkdir $M0/a/b
+TEST touch $M0/a/b/file3
+TEST [ -f $B0/${V0}0/a/b/file3 ]
+
+TEST $CLI volume set $V0 storage.dir-handle-cache-size 0
+EXPECT "0" brick_cache_value dir_handle_cache_entries
+TEST touch $M0/a/c/d/file4
+TEST [ -f $B0/${V0}0/a/c/d/file4 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function listing() {
+        ls -ln $1 | awk '{print $1, $3, $4, $5, $9}'
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.readdirp-threads 0
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 \
+     --volfile-id=$V0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..300}; do
+        echo $i > $M0/dir/file$i
+done
+TEST chmod 600 $M0/dir/file7
+TEST mkdir $M0/dir/subdir
+TEST setfattr -n user.test -v value $M0/dir/file11
+
+listing $M0/dir > $B0/serial
+TEST [ $(wc -l < $B0/serial) -eq 302 ]
+
+TEST $CLI volume set $V0 storage.readdirp-threads 8
+listing $M0/dir > $B0/parallel
+TEST cmp $B0/serial $B0/parallel
+EXPECT "value" echo $(getfattr --only-values -n user.test $M0/dir/file11)
+
+TEST $CLI volume set $V0 storage.readdirp-threads 2
+listing $M0/dir > $B0/parallel
+TEST cmp $B0/serial $B0/parallel
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+rm -f $B0/serial $B0/parallel
+cleanup;
@@ -0,0 +1,65 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_cache_value() {
+        local brick=$1
+        local key=$2
+        local fpath=$(generate_brick_statedump $V0 $H0 $brick)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function pending_xattr() {
+        getfattr --absolute-names -e hex -n trusted.afr.$V0-client-0 $1 \
+                2>/dev/null | grep = | cut -f2 -d'='
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS --entry-timeout=0 --attribute-timeout=0 --volfile-id=$V0 \
+     --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+TEST touch $M0/dir/file
+TEST stat $M0/dir/file
+TEST stat $M0/dir/file
+EXPECT_NOT "0" brick_cache_value $B0/${V0}1 xattr_cache_hits
+EXPECT_NOT "0" brick_cache_value $B0/${V0}1 xattr_cache_size
+
+# setxattr from the mount is seen by lookups
+TEST setfattr -n trusted.test -v value1 $M0/dir/file
+EXPECT "value1" echo $(getfattr --only-values -n trusted.test $M0/dir/file)
+TEST setfattr -n trusted.test -v value2 $M0/dir/file
+EXPECT "value2" echo $(getfattr --only-values -n trusted.test $M0/dir/file)
+TEST setfattr -x trusted.test $M0/dir/file
+TEST ! getfattr -n trusted.test $M0/dir/file
+
+# the pending xattrs written by xattrop have to reach the brick and be
+# read back right by the heal
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST dd if=/dev/urandom of=$M0/dir/file bs=4k count=4
+EXPECT_NOT "0x000000000000000000000000" pending_xattr $B0/${V0}1/dir/file
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+EXPECT "0x000000000000000000000000" pending_xattr $B0/${V0}1/dir/file
+TEST cmp $B0/${V0}0/dir/file $B0/${V0}1/dir/file
+
+TEST $CLI volume set $V0 storage.xattr-cache-size 0
+EXPECT "0" brick_cache_value $B0/${V0}1 xattr_cache_size
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
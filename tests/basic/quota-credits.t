@@ -0,0 +1,48 @@
+#!/bin/bash
+
+## Writes below the soft-limit are admitted from the allowances granted by
+## quotad, the hard-limit is still enforced.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_dump_value() {
+        local key=$1
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}1)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST ! $CLI volume set $V0 features.quota-credits on
+
+TEST $CLI volume quota $V0 enable
+TEST $CLI volume set $V0 features.quota-credits on
+EXPECT 'on' volinfo_field $V0 'features.quota-credits'
+TEST $CLI volume quota $V0 soft-timeout 30
+TEST $CLI volume quota $V0 hard-timeout 0
+
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+TEST mkdir $M0/dir
+TEST $CLI volume quota $V0 limit-usage /dir 20MB
+
+TEST dd if=/dev/zero of=$M0/dir/file1 bs=4k count=1024
+EXPECT "1" brick_dump_value credits
+EXPECT_NOT "0" brick_dump_value credit-hits
+
+## past the soft-limit every write is checked against the hard-limit
+TEST ! dd if=/dev/zero of=$M0/dir/file2 bs=4k count=8192 conv=fdatasync
+EXPECT_WITHIN $MARKER_UPDATE_TIMEOUT "Yes" quota_hl_exceeded "/dir"
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+## Quota size updates held for the update window reach the root once the
+## window is flushed.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_dump_value() {
+        local key=$1
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}1)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $CLI volume quota $V0 enable
+TEST $CLI volume quota $V0 limit-usage / 100MB
+TEST $CLI volume set $V0 features.quota-update-window 500
+EXPECT '500' volinfo_field $V0 'features.quota-update-window'
+TEST ! $CLI volume set $V0 features.quota-update-window 100000
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "500" brick_dump_value quota-update-window
+
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+deep=$M0/a/b/c/d/e
+TEST mkdir -p $deep
+for i in {1..16}; do
+        TEST dd if=/dev/zero of=$deep/file$i bs=64k count=16
+done
+
+EXPECT_WITHIN $MARKER_UPDATE_TIMEOUT "16.0MB" quotausage "/"
+EXPECT_NOT "0" brick_dump_value quota-txn-batches
+EXPECT "0" brick_dump_value quota-txn-pending
+
+## removals are accounted with the held updates
+TEST rm -f $deep/file{1..8}
+EXPECT_WITHIN $MARKER_UPDATE_TIMEOUT "8.0MB" quotausage "/"
+
+## back to updating right away
+TEST $CLI volume set $V0 features.quota-update-window 0
+TEST dd if=/dev/zero of=$M0/a/file bs=1M count=1
+EXPECT_WITHIN $MARKER_UPDATE_TIMEOUT "9.0MB" quotausage "/"
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+## With ctr-db-sync async, the heat of inode fops is gathered in memory by
+## CTR and written to the db by the flush thread. With the default sync it
+## is written right away.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+FLUSH_INTERVAL=2
+
+function brick_dump_value() {
+        local key=$1
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function write_time() {
+        echo "select W_SEC from gf_file_tb where GF_ID = '$1';" | \
+                sqlite3 $B0/${V0}0/.glusterfs/${V0}0.db
+}
+
+function write_time_changed() {
+        [ "$(write_time $2)" != "$1" ] && echo "Y" || echo "N"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 features.ctr-enabled on
+TEST $CLI volume set $V0 features.ctr-db-sync async
+TEST $CLI volume set $V0 features.ctr-flush-interval $FLUSH_INTERVAL
+TEST ! $CLI volume set $V0 features.ctr-flush-interval 0
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+## creates are recorded right away
+TEST touch $M0/file
+gfid=$(gf_gfid_xattr_to_str $(gf_get_gfid_xattr $B0/${V0}0/file))
+wtime=$(write_time $gfid)
+TEST [ -n "$wtime" ]
+
+## writes are merged in memory and reach the db with the next flush
+sleep 1
+TEST dd if=/dev/zero of=$M0/file bs=4k count=16 conv=notrunc
+EXPECT_NOT "0" brick_dump_value heat-merged
+EXPECT_WITHIN $(($FLUSH_INTERVAL * 3)) "Y" write_time_changed $wtime $gfid
+EXPECT_WITHIN $(($FLUSH_INTERVAL * 3)) "0" brick_dump_value heat-cache-entries
+EXPECT "0" brick_dump_value flush-failures
+
+## with ctr-db-sync sync every write goes to the db
+TEST $CLI volume set $V0 features.ctr-db-sync sync
+EXPECT "sync" brick_dump_value db-sync
+wtime=$(write_time $gfid)
+sleep 1
+TEST dd if=/dev/zero of=$M0/file bs=4k count=1 conv=notrunc
+EXPECT "Y" write_time_changed $wtime $gfid
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
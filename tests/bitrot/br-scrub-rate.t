@@ -0,0 +1,41 @@
+#!/bin/bash
+
+## Scrub rate is a byte rate enforced by the scrubber's token bucket
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+TEST glusterd;
+TEST pidof glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1..2}
+TEST $CLI volume start $V0
+
+TEST $CLI volume bitrot $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_bitd_count
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_scrubd_count
+
+## no limit unless set
+EXPECT '' volinfo_field $V0 'features.scrub-rate'
+
+TEST $CLI volume bitrot $V0 scrub-rate 64MB
+EXPECT '64MB' volinfo_field $V0 'features.scrub-rate'
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_scrubd_count
+
+TEST ! $CLI volume bitrot $V0 scrub-rate fast
+TEST ! $CLI volume set $V0 features.scrub-rate 1MB
+EXPECT '64MB' volinfo_field $V0 'features.scrub-rate'
+
+## the limit survives a restart of glusterd
+pkill glusterd;
+TEST glusterd;
+TEST pidof glusterd;
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT 'Started' volinfo_field $V0 'Status';
+EXPECT '64MB' volinfo_field $V0 'features.scrub-rate'
+
+TEST $CLI volume bitrot $V0 scrub-rate 0
+EXPECT '0' volinfo_field $V0 'features.scrub-rate'
+
+cleanup;
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+## Objects signed with a merkle tree keep their block hashes on the brick
+## and are re-signed after modifications.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+SLEEP_TIME=2
+
+function signature_type {
+        getfattr --absolute-names -e hex -n trusted.bit-rot.signature $1 \
+                2>/dev/null | grep = | cut -f2 -d'=' | cut -c1-4
+}
+
+function signature {
+        getfattr --absolute-names -e hex -n trusted.bit-rot.signature $1 \
+                2>/dev/null | grep = | cut -f2 -d'='
+}
+
+function signature_changed {
+        [ "$(signature $2)" != "$1" ] && echo "Y" || echo "N"
+}
+
+function merkle_leaves {
+        [ -f $B0/${V0}1/.glusterfs/merkle/$1 ] && echo "Y" || echo "N"
+}
+
+cleanup;
+
+TEST glusterd;
+TEST pidof glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $CLI volume bitrot $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_bitd_count
+
+TEST $CLI volume bitrot $V0 signing-time $SLEEP_TIME
+TEST $CLI volume set $V0 features.signing-block-size 64KB
+EXPECT '64KB' volinfo_field $V0 'features.signing-block-size'
+TEST ! $CLI volume set $V0 features.signing-block-size 1GB
+
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0;
+
+TEST dd if=/dev/urandom of=$M0/file bs=64k count=16
+gfid=$(getfattr -n glusterfs.gfid.string --only-values $M0/file)
+backpath=$B0/${V0}1/file
+
+EXPECT_WITHIN $(($SLEEP_TIME * 5)) "0x02" signature_type $backpath
+EXPECT "Y" merkle_leaves $gfid
+sign1=$(signature $backpath)
+
+## a modified block gets the object re-signed
+TEST dd if=/dev/urandom of=$M0/file bs=64k count=1 seek=3 conv=notrunc
+EXPECT_WITHIN $(($SLEEP_TIME * 5)) "Y" signature_changed $sign1 $backpath
+EXPECT_WITHIN $(($SLEEP_TIME * 5)) "0x02" signature_type $backpath
+EXPECT "Y" merkle_leaves $gfid
+
+## as does a truncate
+sign2=$(signature $backpath)
+TEST truncate -s 100000 $M0/file
+EXPECT_WITHIN $(($SLEEP_TIME * 5)) "Y" signature_changed $sign2 $backpath
+
+## leaves go with the object
+TEST rm -f $M0/file
+EXPECT "N" merkle_leaves $gfid
+
+## whole object SHA256 is back once the block size is reset
+TEST $CLI volume set $V0 features.signing-block-size 0
+echo "ZZZ" > $M0/file0
+EXPECT_WITHIN $(($SLEEP_TIME * 5)) "0x01" signature_type $B0/${V0}1/file0
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# creates recorded in the changelogs of the brick, ascii encoded
+function changelog_creates() {
+        cat $B0/${V0}0/.glusterfs/changelogs/CHANGELOG* 2>/dev/null | \
+                tr '\0' '\n' | grep -c "/gc-"
+}
+
+function create_files() {
+        local p
+        for p in 1 2 3 4; do
+                (for i in $(seq 1 50); do : > $M0/dir/gc-$1-$p-$i; done) &
+        done
+        wait
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 changelog.encoding ascii
+TEST $CLI volume set $V0 changelog.rollover-time 3
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+export GLUSTER="$CLI"
+TEST $(dirname $0)/../../extras/benchmarking/changelog-bm.sh -p 4 -n 50 $V0 $M0
+
+# every create is in the journal by the time it returns, concurrent records
+# are batched but none is lost or torn across rollovers
+TEST $CLI volume set $V0 changelog.changelog on
+TEST mkdir $M0/dir
+TEST create_files a
+EXPECT "200" changelog_creates
+
+TEST $CLI volume set $V0 changelog.fsync-interval 0
+sleep 4
+TEST create_files b
+EXPECT "400" changelog_creates
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
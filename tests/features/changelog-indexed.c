@@ -0,0 +1,123 @@
+/*
+ * consume the changelogs of a brick for a while, and count the records
+ * naming "ix-" files both in the ascii copies handed out for processing and
+ * read in place from the indexed changelogs they come from.
+ *
+ * usage: changelog-indexed <brick> <scratch-dir> <seconds>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "changelog.h"
+
+static int
+count_ascii (char *path)
+{
+        FILE *fp         = NULL;
+        int   nr         = 0;
+        char  line[8192] = {0,};
+
+        fp = fopen (path, "r");
+        if (!fp)
+                return -1;
+
+        while (fgets (line, sizeof (line), fp)) {
+                if (strstr (line, "%2Fix-"))
+                        nr++;
+        }
+
+        fclose (fp);
+        return nr;
+}
+
+static int
+count_mapped (char *path)
+{
+        gf_changelog_map_t    *map = NULL;
+        gf_changelog_record_t  rec = {0,};
+        ssize_t                i   = 0;
+        ssize_t                nr  = 0;
+        int                    ret = 0;
+
+        map = gf_changelog_map (path);
+        if (!map)
+                return -1;
+
+        nr = gf_changelog_map_count (map);
+        for (i = 0; i < nr; i++) {
+                if (gf_changelog_map_record (map, i, &rec)) {
+                        ret = -1;
+                        break;
+                }
+
+                if ((rec.type == 'E') && (rec.nr_entries > 0) &&
+                    !strncmp (rec.entries[0].bname, "ix-", 3))
+                        ret++;
+        }
+
+        gf_changelog_unmap (map);
+        return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+        int     ascii       = 0;
+        int     mapped      = 0;
+        int     nr          = 0;
+        int     seconds     = 0;
+        ssize_t changes     = 0;
+        char    log[PATH_MAX] = {0,};
+        char    fbuf[PATH_MAX] = {0,};
+
+        if (argc != 4) {
+                fprintf (stderr, "usage: %s <brick> <scratch-dir> "
+                         "<seconds>\n", argv[0]);
+                return 1;
+        }
+
+        seconds = atoi (argv[3]);
+        snprintf (log, sizeof (log), "%s/changelog-indexed.log", argv[2]);
+
+        if (gf_changelog_init (NULL) ||
+            gf_changelog_register (argv[1], argv[2], log, 9, 5)) {
+                fprintf (stderr, "register failed: %s\n", strerror (errno));
+                return 1;
+        }
+
+        for (; seconds > 0; seconds--) {
+                sleep (1);
+
+                if (gf_changelog_scan () < 0)
+                        continue;
+
+                while ((changes = gf_changelog_next_change (fbuf,
+                                                            PATH_MAX)) > 0) {
+                        nr = count_ascii (fbuf);
+                        if (nr < 0) {
+                                fprintf (stderr, "cannot read %s\n", fbuf);
+                                return 1;
+                        }
+                        ascii += nr;
+
+                        nr = count_mapped (fbuf);
+                        if (nr < 0) {
+                                fprintf (stderr, "cannot map %s: %s\n", fbuf,
+                                         strerror (errno));
+                                return 1;
+                        }
+                        mapped += nr;
+
+                        gf_changelog_done (fbuf);
+                }
+        }
+
+        printf ("%d %d\n", ascii, mapped);
+        return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function create_files() {
+        local i
+        for i in $(seq 1 50); do : > $M0/dir/ix-$i; done
+        mv $M0/dir/ix-1 $M0/dir/ix-renamed
+        rm -f $M0/dir/ix-2
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 changelog.encoding indexed
+TEST $CLI volume set $V0 changelog.rollover-time 3
+TEST $CLI volume set $V0 changelog.changelog on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST mkdir $M0/dir
+
+TEST build_tester $(dirname $0)/changelog-indexed.c \
+     $(pkg-config --cflags --libs libgfchangelog)
+mkdir -p $B0/scratch
+$(dirname $0)/changelog-indexed $B0/${V0}0 $B0/scratch 15 > $B0/records &
+consumer=$!
+sleep 2
+
+# 50 creates, a rename and an unlink, the same records in the ascii copies
+# and read in place through the index of the rolled over changelogs
+TEST create_files
+TEST wait $consumer
+EXPECT "52 52" cat $B0/records
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+rm -f $(dirname $0)/changelog-indexed
+cleanup;
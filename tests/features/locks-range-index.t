@@ -0,0 +1,46 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_dump_value() {
+        local key=$1
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function has_wait() {
+        [ -n "$(brick_dump_value $1)" ] && echo "Y" || echo "N"
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# many granted locks per process and contended ranges shared by all
+TEST $CC -o $B0/lock-bm $(dirname $0)/../../extras/benchmarking/lock-bm.c
+TEST $B0/lock-bm -p 4 -l 500 -i 500 -s 16 $M0/lockfile
+
+# a lock waiting behind another one is reported with its wait time
+TEST touch $M0/file
+flock -o $M0/file sleep 30 &
+holder=$!
+EXPECT_WITHIN 10 "1" brick_dump_value posixlk-count
+EXPECT "N" has_wait posixlk.longest-blocked-wait
+flock $M0/file true &
+waiter=$!
+EXPECT_WITHIN 10 "Y" has_wait posixlk.longest-blocked-wait
+
+kill $holder
+wait $waiter
+EXPECT "N" has_wait posixlk.longest-blocked-wait
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+rm -f $B0/lock-bm
+cleanup;
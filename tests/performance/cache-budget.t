@@ -0,0 +1,45 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function cache_budget_value() {
+        local key=$1
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a -A20 "^\[cache-budget\]" $fpath | grep -m1 "^$key=" | \
+                cut -f2 -d'='
+        rm -f $fpath
+}
+
+function cache_budget_within() {
+        local used=$(cache_budget_value used)
+        [ -n "$used" ] && [ $used -le $((2 * 1024 * 1024)) ] && echo "Y" || \
+                echo "N"
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache on
+TEST $CLI volume set $V0 performance.cache-size 64MB
+TEST $CLI volume start $V0
+
+# per-xlator cache-size is 64MB, the budget for the whole mount only 2MB
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 --cache-budget=2MB \
+     -s $H0 --volfile-id=$V0 $M0
+
+for i in {1..8}; do
+        TEST dd if=/dev/urandom of=$M0/file$i bs=1M count=1
+done
+
+for i in {1..8}; do
+        TEST cat $M0/file$i > /dev/null
+done
+
+EXPECT_NOT "" cache_budget_value clients
+EXPECT_WITHIN 10 "Y" cache_budget_within
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function file_exists() {
+        stat $1 > /dev/null 2>&1 && echo "Y" || echo "N"
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume set $V0 features.cache-invalidation-timeout 600
+TEST $CLI volume set $V0 performance.negative-lookup-cache on
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 --negative-timeout=0 \
+     -s $H0 --volfile-id=$V0 $M0
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 --negative-timeout=0 \
+     -s $H0 --volfile-id=$V0 $M1
+
+TEST mkdir $M0/dir
+EXPECT "N" file_exists $M0/dir/missing
+
+# created behind the back of the volume, the missing name stays cached
+TEST touch $B0/${V0}0/dir/missing
+EXPECT "N" file_exists $M0/dir/missing
+TEST rm -f $B0/${V0}0/dir/missing
+
+# a name created from another mount is notified
+EXPECT "N" file_exists $M0/dir/file
+TEST touch $M1/dir/file
+EXPECT_WITHIN 5 "Y" file_exists $M0/dir/file
+
+# and so is one created from this mount
+EXPECT "N" file_exists $M0/dir/file2
+TEST touch $M0/dir/file2
+EXPECT "Y" file_exists $M0/dir/file2
+
+# rename into the directory from the other mount
+EXPECT "N" file_exists $M0/dir/renamed
+TEST touch $M1/other
+TEST mv $M1/other $M1/dir/renamed
+EXPECT_WITHIN 5 "Y" file_exists $M0/dir/renamed
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+cleanup;
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function ob_dump_value() {
+        local key=$1
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.lazy-create on
+TEST $CLI volume set $V0 performance.lazy-release-timeout 5
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 \
+     --volfile-id=$V0 $M0
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 \
+     --volfile-id=$V0 $M1
+
+# a create is sent with the first write
+TEST dd if=/dev/urandom of=$M0/file bs=4k count=4
+EXPECT_NOT "0" ob_dump_value creates_deferred
+TEST cmp $M0/file $B0/${V0}0/file
+TEST cmp $M0/file $M1/file
+
+# or when the file is closed, or looked at
+TEST touch $M0/empty
+TEST stat $B0/${V0}0/empty
+exec 5>$M0/open
+TEST stat $M0/open
+TEST stat $B0/${V0}0/open
+exec 5>&-
+
+# read-only opens, reads and closes of a file share one brick fd
+for i in $(seq 1 10); do
+        cat $M0/file > /dev/null
+done
+EXPECT_NOT "0" ob_dump_value shared_reads
+EXPECT "1" ob_dump_value shared_opens
+
+# and see writes from elsewhere
+TEST dd if=/dev/zero of=$M1/file bs=4k count=4 conv=notrunc
+TEST cmp $M0/file $M1/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+cleanup;
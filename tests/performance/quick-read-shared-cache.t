@@ -0,0 +1,59 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function mount_pid() {
+        ps auxww | grep glusterfs | grep -E "volfile-id[ =]/?$V0 .*$1\$" | \
+                awk '{print $2}' | head -1
+}
+
+function shared_cache_value() {
+        local key=$2
+        local fpath=$(generate_statedump $(mount_pid $1))
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function same_content() {
+        cmp -s $1 $2 && echo "Y" || echo "N"
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.quick-read-shared-cache on
+TEST $CLI volume set $V0 performance.quick-read-shared-cache-size 16MB
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume start $V0
+
+# named after the volume id, a volume of the same name elsewhere has its own
+VOLID=$($CLI volume info $V0 | grep "Volume ID" | awk '{print $3}')
+SHM=/dev/shm/glusterfs-qr.$VOLID.$V0-quick-read
+rm -f $SHM
+
+TEST glusterfs -s $H0 --volfile-id=$V0 $M0
+TEST glusterfs -s $H0 --volfile-id=$V0 $M1
+TEST [ -f $SHM ]
+
+echo "small file" > $B0/src
+TEST cp $B0/src $M0/file
+TEST cmp $B0/src $M0/file
+
+# the first mount fills the shared cache, the second reads from it
+TEST cmp $B0/src $M1/file
+EXPECT_NOT "0" shared_cache_value $M1 shared_cache_hits
+EXPECT_NOT "0" shared_cache_value $M0 shared_cache_stores
+
+# a write from either mount drops the shared copy
+echo "changed" > $B0/src
+TEST cp $B0/src $M0/file
+EXPECT_WITHIN 5 "Y" same_content $B0/src $M1/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+rm -f $B0/src $SHM
+cleanup;
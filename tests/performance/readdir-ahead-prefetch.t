@@ -0,0 +1,64 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function rda_dump_value() {
+        local key=$1
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "^$key=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 performance.readdir-ahead on
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.rda-cache-timeout 10
+TEST $CLI volume set $V0 performance.rda-cache-metadata on
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 \
+     --volfile-id=$V0 $M0
+
+for d in $(seq 1 8); do
+        TEST mkdir -p $M0/dir/sub$d
+        TEST touch $M0/dir/sub$d/file{1..20}
+done
+
+# a walk is served from the subdirectories read ahead of it
+TEST find $M0/dir -exec stat {} +
+EXPECT_NOT "0" rda_dump_value dirs_prefetched
+EXPECT_NOT "0" rda_dump_value dirs_adopted
+EXPECT_NOT "0" rda_dump_value stat_hits
+
+# a write from this mount is not hidden by the prefetched attributes
+TEST ls -l $M0/dir/sub1
+TEST dd if=/dev/zero of=$M0/dir/sub1/file1 bs=4k count=2
+EXPECT "8192" stat -c %s $M0/dir/sub1/file1
+
+# neither is a rename of a prefetched entry
+TEST ls -l $M0/dir/sub2
+TEST mv $M0/dir/sub2/file1 $M0/dir/sub2/renamed
+TEST ! stat $M0/dir/sub2/file1
+TEST stat $M0/dir/sub2/renamed
+
+# a truncating open is not hidden either
+TEST ls -l $M0/dir/sub3
+TEST truncate -s 4096 $M0/dir/sub3/file1
+TEST ls -l $M0/dir/sub3
+TEST dd if=/dev/null of=$M0/dir/sub3/file1
+EXPECT "0" stat -c %s $M0/dir/sub3/file1
+
+# the metadata cache can be turned off again
+TEST $CLI volume set $V0 performance.rda-cache-metadata off
+EXPECT "0" rda_dump_value cache_metadata
+
+TEST $CLI volume set $V0 performance.rda-prefetch-dirs 0
+EXPECT "0" rda_dump_value prefetch_dirs
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function write_calls() {
+        $CLI volume profile $V0 info cumulative | grep -w WRITE | \
+                awk '{print $8}' | head -1
+}
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind-aggregate-size 1MB
+TEST $CLI volume set $V0 performance.write-behind-window-size 4MB
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id=$V0 $M0
+
+TEST $CLI volume profile $V0 start
+
+# 1024 4KB appends must reach the brick as a handful of large writes
+TEST dd if=/dev/urandom of=$B0/src bs=4k count=1024
+TEST dd if=$B0/src of=$M0/file bs=4k count=1024 conv=fsync
+calls=$(write_calls)
+TEST [ $calls -le 32 ]
+
+TEST cmp $B0/src $M0/file
+
+# overlapping rewrites behind the aggregated writes must not be lost
+TEST dd if=/dev/zero of=$M0/file bs=4k count=16 seek=100 conv=notrunc,fsync
+TEST dd if=/dev/zero of=$B0/src bs=4k count=16 seek=100 conv=notrunc
+TEST cmp $B0/src $M0/file
+
+TEST $CLI volume set $V0 performance.write-behind-aggregate-size 4KB
+TEST dd if=/dev/urandom of=$M0/file2 bs=4k count=256 conv=fsync
+TEST cmp $M0/file2 $B0/${V0}0/file2
+
+rm -f $B0/src
+cleanup;
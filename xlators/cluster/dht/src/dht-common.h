@@ -401,17 +401,16 @@ typedef struct gf_tier_conf {
         int                          tier_max_promote_size;
         int                          tier_promote_frequency;
         int                          tier_demote_frequency;
-        uint64_t                     st_last_promoted_size;
-        uint64_t                     st_last_demoted_size;
         tier_pause_state_t           pause_state;
         struct synctask             *pause_synctask;
         gf_timer_t                  *pause_timer;
         pthread_mutex_t              pause_mutex;
+        /* Number of files being promoted/demoted */
         int                          promote_in_progress;
         int                          demote_in_progress;
         /* This Structure is only used in tiering fixlayout */
         gf_tier_fix_layout_arg_t     tier_fix_layout_arg;
-        /* Indicates the index of the first queryfile picked
+        /* Indicates the index of the first brick picked
          * in the last cycle of promote or demote */
         int32_t last_promote_qfile_index;
         int32_t last_demote_qfile_index;
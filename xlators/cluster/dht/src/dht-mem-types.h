@@ -38,6 +38,7 @@ enum gf_dht_mem_types_ {
         gf_tier_mt_ipc_ctr_params_t,
         gf_dht_mt_fd_ctx_t,
         gf_tier_mt_qfile_array_t,
+        gf_tier_mt_worker_t,
         gf_dht_mt_end
 };
 #endif
@@ -1574,15 +1574,9 @@ dht_migrate_file (xlator_t *this, loc_t *loc, xlator_t *from, xlator_t *to,
                 }
         }
 
-        /* store size of previous migrated file  */
-        if (defrag->tier_conf.is_tier) {
-                if (from != TIER_HASHED_SUBVOL) {
-                        defrag->tier_conf.st_last_promoted_size = stbuf.ia_size;
-                } else {
-                        /* Don't delete the linkto file on the hashed subvol */
-                        delete_src_linkto = _gf_false;
-                        defrag->tier_conf.st_last_demoted_size = stbuf.ia_size;
-                }
+        /* Don't delete the linkto file on the hashed subvol */
+        if (defrag->tier_conf.is_tier && from == TIER_HASHED_SUBVOL) {
+                delete_src_linkto = _gf_false;
         }
 
         /* The src file is being unlinked after this so we don't need
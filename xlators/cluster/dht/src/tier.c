@@ -429,11 +429,12 @@ tier_migrate (xlator_t *this, int is_promotion, dict_t *migrate_data,
 {
         int ret = -1;
 
+        /* Counts, the workers of a cycle migrate in parallel */
         pthread_mutex_lock (&tier_conf->pause_mutex);
         if (is_promotion)
-                tier_conf->promote_in_progress = 1;
+                tier_conf->promote_in_progress++;
         else
-                tier_conf->demote_in_progress = 1;
+                tier_conf->demote_in_progress++;
         pthread_mutex_unlock (&tier_conf->pause_mutex);
 
         /* Data migration */
@@ -442,9 +443,9 @@ tier_migrate (xlator_t *this, int is_promotion, dict_t *migrate_data,
 
         pthread_mutex_lock (&tier_conf->pause_mutex);
         if (is_promotion)
-                tier_conf->promote_in_progress = 0;
+                tier_conf->promote_in_progress--;
         else
-                tier_conf->demote_in_progress = 0;
+                tier_conf->demote_in_progress--;
         pthread_mutex_unlock (&tier_conf->pause_mutex);
 
         return ret;
@@ -505,6 +506,61 @@ abort:
         return ret;
 }
 
+/* Takes a file of size bytes out of the budget of the cycle, which the
+ * workers of the cycle share. Returns _gf_false once tier-max-files or
+ * tier-max-mb is reached, no more files are migrated in the cycle then.
+ *
+ * The budget goes to the workers in the order they ask for it, not to the
+ * hottest files across the bricks: each brick is migrated from in its own
+ * heat order as soon as it is queried, with no merge of the bricks. Where
+ * the budget runs out before every brick got to it, the brick taken first
+ * moves on every cycle (see tier_migrate_cycle). */
+static gf_boolean_t
+tier_cycle_take_budget (xlator_t *this, tier_cycle_t *cycle,
+                        gf_tier_conf_t *tier_conf, uint64_t size)
+{
+        gf_boolean_t taken = _gf_false;
+
+        pthread_mutex_lock (&cycle->lock);
+        {
+                if (cycle->budget_exhausted)
+                        goto unlock;
+
+                if ((cycle->files_migrated >= tier_conf->max_migrate_files)
+                    || (cycle->bytes_migrated >
+                        tier_conf->max_migrate_bytes)) {
+                        cycle->budget_exhausted = _gf_true;
+                        gf_msg (this->name, GF_LOG_INFO, 0,
+                                DHT_MSG_LOG_TIER_STATUS,
+                                "Reached cycle migration limit."
+                                "migrated bytes %"PRIu64" files %d",
+                                cycle->bytes_migrated,
+                                cycle->files_migrated);
+                        goto unlock;
+                }
+
+                cycle->files_migrated++;
+                cycle->bytes_migrated += size;
+                taken = _gf_true;
+        }
+unlock:
+        pthread_mutex_unlock (&cycle->lock);
+
+        return taken;
+}
+
+/* Gives back the budget taken for a file that could not be migrated */
+static void
+tier_cycle_give_budget (tier_cycle_t *cycle, uint64_t size)
+{
+        pthread_mutex_lock (&cycle->lock);
+        {
+                cycle->files_migrated--;
+                cycle->bytes_migrated -= size;
+        }
+        pthread_mutex_unlock (&cycle->lock);
+}
+
 static int
 tier_migrate_using_query_file (void *_args)
 {
@@ -534,10 +590,8 @@ tier_migrate_using_query_file (void *_args)
         int total_status                        = 0;
         xlator_t *src_subvol                    = NULL;
         dht_conf_t   *conf                      = NULL;
-        uint64_t total_migrated_bytes           = 0;
-        int total_files                         = 0;
+        tier_cycle_t *cycle                     = NULL;
         loc_t root_loc                          = { 0 };
-        gfdb_time_t  start_time                 = { 0 };
         gfdb_time_t  current_time               = { 0 };
         int total_time                          = 0;
         int max_time                            = 0;
@@ -548,9 +602,11 @@ tier_migrate_using_query_file (void *_args)
         this = query_cbk_args->this;
         GF_VALIDATE_OR_GOTO (this->name, query_cbk_args->defrag, out);
         GF_VALIDATE_OR_GOTO (this->name, query_cbk_args->qfile_array, out);
+        GF_VALIDATE_OR_GOTO (this->name, query_cbk_args->cycle, out);
         GF_VALIDATE_OR_GOTO (this->name, this->private, out);
 
         conf = this->private;
+        cycle = query_cbk_args->cycle;
 
         defrag = query_cbk_args->defrag;
         migrate_data = dict_new ();
@@ -576,7 +632,6 @@ tier_migrate_using_query_file (void *_args)
 
         dht_build_root_loc (defrag->root_inode, &root_loc);
 
-        ret = gettimeofday (&start_time, NULL);
         if (query_cbk_args->is_promotion) {
                 max_time = defrag->tier_conf.tier_promote_frequency;
         } else {
@@ -612,7 +667,7 @@ tier_migrate_using_query_file (void *_args)
                         goto out;
                 }
 
-                total_time = current_time.tv_sec - start_time.tv_sec;
+                total_time = current_time.tv_sec - cycle->start_time.tv_sec;
                 if (total_time > max_time) {
                         gf_msg (this->name, GF_LOG_INFO, 0,
                                 DHT_MSG_LOG_TIER_STATUS,
@@ -620,6 +675,11 @@ tier_migrate_using_query_file (void *_args)
                         goto out;
                 }
 
+                /* Another worker of the cycle used up the budget */
+                if (cycle->budget_exhausted) {
+                        goto out;
+                }
+
                 per_file_status      = 0;
                 per_link_status      = 0;
 
@@ -895,6 +955,13 @@ tier_migrate_using_query_file (void *_args)
                                 goto abort;
                         }
 
+                        if (!tier_cycle_take_budget (this, cycle,
+                                                     &defrag->tier_conf,
+                                                     current.ia_size)) {
+                                per_link_status = 1;
+                                goto abort;
+                        }
+
                         ret = tier_migrate (this, query_cbk_args->is_promotion,
                                             migrate_data, &loc, &defrag->tier_conf);
 
@@ -902,35 +969,28 @@ tier_migrate_using_query_file (void *_args)
                                 gf_msg (this->name, GF_LOG_ERROR, -ret,
                                         DHT_MSG_LOG_TIER_ERROR, "Failed to "
                                         "migrate %s ", loc.path);
+                                tier_cycle_give_budget (cycle,
+                                                        current.ia_size);
                                 per_link_status = -1;
                                 goto abort;
                         }
 
+                        pthread_mutex_lock (&dm_stat_mutex);
                         if (query_cbk_args->is_promotion) {
                                 defrag->total_files_promoted++;
-                                total_migrated_bytes +=
-                                        defrag->tier_conf.st_last_promoted_size;
-                                pthread_mutex_lock (&dm_stat_mutex);
                                 defrag->tier_conf.blocks_used +=
-                                        defrag->tier_conf.st_last_promoted_size;
-                                pthread_mutex_unlock (&dm_stat_mutex);
+                                        current.ia_size;
                         } else {
                                 defrag->total_files_demoted++;
-                                total_migrated_bytes +=
-                                        defrag->tier_conf.st_last_demoted_size;
-                                pthread_mutex_lock (&dm_stat_mutex);
                                 defrag->tier_conf.blocks_used -=
-                                        defrag->tier_conf.st_last_demoted_size;
-                                pthread_mutex_unlock (&dm_stat_mutex);
+                                        current.ia_size;
                         }
                         if (defrag->tier_conf.blocks_total) {
-                                pthread_mutex_lock (&dm_stat_mutex);
                                 defrag->tier_conf.percent_full =
                                         (100 * defrag->tier_conf.blocks_used) /
                                         defrag->tier_conf.blocks_total;
-                                pthread_mutex_unlock (&dm_stat_mutex);
                         }
-                        total_files++;
+                        pthread_mutex_unlock (&dm_stat_mutex);
 abort:
                         GF_FREE ((char *) loc.name);
                         loc.name = NULL;
@@ -943,15 +1003,7 @@ abort:
                                 xdata_response = NULL;
                         }
 
-                        if ((total_files >= defrag->tier_conf.max_migrate_files)
-                            || (total_migrated_bytes >
-                                defrag->tier_conf.max_migrate_bytes)) {
-                                gf_msg (this->name, GF_LOG_INFO, 0,
-                                        DHT_MSG_LOG_TIER_STATUS,
-                                        "Reached cycle migration limit."
-                                        "migrated bytes %"PRId64" files %d",
-                                        total_migrated_bytes,
-                                        total_files);
+                        if (cycle->budget_exhausted) {
                                 goto out;
                         }
                 }
@@ -1080,6 +1132,29 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
                          goto out;
         }
 
+        /* Have CTR write the heat it gathered in memory to the db before
+         * querying it, or the clear below would drop that heat unseen */
+        ctr_ipc_dict = dict_new ();
+        if (!ctr_ipc_dict) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        DHT_MSG_LOG_TIER_ERROR,
+                        "ctr_ipc_dict cannot initialized");
+                goto out;
+        }
+
+        SET_DB_PARAM_TO_DICT(this->name, ctr_ipc_dict,
+                             GFDB_IPC_CTR_KEY, GFDB_IPC_CTR_FLUSH_OPS,
+                             ret, out);
+
+        ret = syncop_ipc (local_brick->xlator, GF_IPC_TARGET_CTR, ctr_ipc_dict,
+                                                                        NULL);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        DHT_MSG_LOG_TIER_ERROR, "Failed flushing the heat "
+                        "to db %s error %d, querying it as it is",
+                        local_brick->brick_db_path, ret);
+        }
+
         /* Query for eligible files from db */
         query_cbk_args->query_fd = open (local_brick->qfile_path,
                         O_WRONLY | O_CREAT | O_APPEND,
@@ -1098,7 +1173,8 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
                                         conn_node,
                                         tier_gf_query_callback,
                                         (void *)query_cbk_args,
-                                        gfdb_brick_info->time_stamp);
+                                        gfdb_brick_info->time_stamp,
+                                        query_cbk_args->cycle->query_limit);
                 } else {
                                 ret = gfdb_methods.find_unchanged_for_time_freq (
                                         conn_node,
@@ -1109,7 +1185,8 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
                                                         write_freq_threshold,
                                         query_cbk_args->defrag->
                                                         read_freq_threshold,
-                                        _gf_false);
+                                        _gf_false,
+                                        query_cbk_args->cycle->query_limit);
                 }
         } else {
                 if (query_cbk_args->defrag->write_freq_threshold == 0 &&
@@ -1118,7 +1195,8 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
                                 conn_node,
                                 tier_gf_query_callback,
                                 (void *)query_cbk_args,
-                                gfdb_brick_info->time_stamp);
+                                gfdb_brick_info->time_stamp,
+                                query_cbk_args->cycle->query_limit);
                 } else {
                         ret = gfdb_methods.find_recently_changed_files_freq (
                                 conn_node,
@@ -1128,7 +1206,8 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
                                 query_cbk_args->defrag->
                                 write_freq_threshold,
                                 query_cbk_args->defrag->read_freq_threshold,
-                                _gf_false);
+                                _gf_false,
+                                query_cbk_args->cycle->query_limit);
                 }
         }
         if (ret) {
@@ -1140,6 +1219,7 @@ tier_process_self_query (tier_brick_list_t *local_brick, void *args)
 
         /*Clear the heat on the DB entries*/
         /*Preparing ctr_ipc_dict*/
+        dict_unref (ctr_ipc_dict);
         ctr_ipc_dict = dict_new ();
         if (!ctr_ipc_dict) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
@@ -1261,6 +1341,15 @@ tier_process_ctr_query (tier_brick_list_t *local_brick, void *args)
                 goto out;
         }
 
+        ret = dict_set_int32 (ctr_ipc_in_dict, GFDB_IPC_CTR_GET_QUERY_LIMIT,
+                              query_cbk_args->cycle->query_limit);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, LG_MSG_SET_PARAM_FAILED,
+                        "Failed setting %s to params dictionary",
+                        GFDB_IPC_CTR_GET_QUERY_LIMIT);
+                goto out;
+        }
+
         ret = syncop_ipc (local_brick->xlator, GF_IPC_TARGET_CTR,
                                 ctr_ipc_in_dict, &ctr_ipc_out_dict);
         if (ret) {
@@ -1289,7 +1378,7 @@ tier_process_ctr_query (tier_brick_list_t *local_brick, void *args)
         }
 
         pthread_mutex_lock (&dm_stat_mutex);
-        query_cbk_args->defrag->num_files_lookedup = count;
+        query_cbk_args->defrag->num_files_lookedup += count;
         pthread_mutex_unlock (&dm_stat_mutex);
 
         ret = 0;
@@ -1420,160 +1509,261 @@ out:
 
 
 
-static int
-tier_build_migration_qfile (migration_args_t *args,
-                            query_cbk_args_t *query_cbk_args,
-                            gf_boolean_t is_promotion)
+/* Picks the next brick of the cycle for a worker. Returns NULL once all the
+ * bricks of the cycle are picked. */
+static tier_brick_list_t *
+tier_cycle_next_brick (tier_cycle_t *cycle)
 {
-        gfdb_time_t               current_time;
-        gfdb_brick_info_t         gfdb_brick_info;
-        gfdb_time_t               time_in_past;
-        int                       ret = -1;
-        tier_brick_list_t         *local_brick = NULL;
-        int                       i = 0;
-        time_in_past.tv_sec = args->freq_time;
-        time_in_past.tv_usec = 0;
-
-        ret = gettimeofday (&current_time, NULL);
-        if (ret == -1) {
-                gf_msg (args->this->name, GF_LOG_ERROR, errno,
-                        DHT_MSG_SYS_CALL_GET_TIME_FAILED,
-                        "Failed to get current time");
-                goto out;
-        }
-        time_in_past.tv_sec = current_time.tv_sec - time_in_past.tv_sec;
-
-        /* The migration daemon may run a varrying numberof usec after the sleep */
-        /* call triggers. A file may be registered in CTR some number of usec X */
-        /* after the daemon started and missed in the subsequent cycle if the */
-        /* daemon starts Y usec after the period in seconds where Y>X. Normalize */
-        /* away this problem by always setting usec to 0. */
-        time_in_past.tv_usec = 0;
-
-        gfdb_brick_info.time_stamp = &time_in_past;
-        gfdb_brick_info._gfdb_promote = is_promotion;
-        gfdb_brick_info._query_cbk_args = query_cbk_args;
-
-        list_for_each_entry (local_brick, args->brick_list, list) {
-
-                /* Construct query file path for this brick
-                 * i.e
-                 * /var/run/gluster/xlator_name/
-                 * {promote/demote}-brickname-indexinbricklist
-                 * So that no two query files will have same path even
-                 * bricks have the same name
-                 * */
-                snprintf (local_brick->qfile_path, PATH_MAX , "%s-%s-%d",
-                        GET_QFILE_PATH (gfdb_brick_info._gfdb_promote),
-                        local_brick->brick_name, i);
-
-                /* Delete any old query files for this brick */
-                sys_unlink (local_brick->qfile_path);
-
-                ret = tier_process_brick (local_brick,
-                                          &gfdb_brick_info);
-                if (ret) {
-                        gf_msg (args->this->name, GF_LOG_ERROR, 0,
-                                DHT_MSG_BRICK_QUERY_FAILED,
-                                "Brick %s query failed\n",
-                                local_brick->brick_db_path);
+        tier_brick_list_t *local_brick          = NULL;
+        tier_brick_list_t *picked_brick         = NULL;
+        int               index                 = 0;
+        int               i                     = 0;
+
+        pthread_mutex_lock (&cycle->lock);
+        {
+                if (cycle->picked == cycle->brick_count)
+                        goto unlock;
+
+                index = (cycle->first_index + cycle->picked) %
+                        cycle->brick_count;
+                list_for_each_entry (local_brick, cycle->brick_list, list) {
+                        if (i++ == index) {
+                                picked_brick = local_brick;
+                                break;
+                        }
                 }
-                i++;
+                cycle->picked++;
         }
-        ret = 0;
-out:
-        return ret;
+unlock:
+        pthread_mutex_unlock (&cycle->lock);
+
+        return picked_brick;
 }
 
+/* Queries a brick for the files to migrate, into the query file of the
+ * brick, and migrates them */
 static int
-tier_migrate_files_using_qfile (migration_args_t *comp,
-                                query_cbk_args_t *query_cbk_args)
+tier_migrate_brick (tier_brick_list_t *local_brick,
+                    query_cbk_args_t *query_cbk_args)
 {
         int ret                                 = -1;
-        tier_brick_list_t *local_brick          = NULL;
-        tier_brick_list_t *temp                 = NULL;
+        xlator_t *this                          = NULL;
+        gfdb_brick_info_t gfdb_brick_info       = {0,};
         char query_file_path_err[PATH_MAX]      = "";
         struct tm tm                            = {0};
         gfdb_time_t current_time                = {0};
         char time_str[256]                      = {0};
         char time_format[20]                    = "%Y-%m-%d-%H-%M-%S";
-        ssize_t qfile_array_size                = 0;
-        int count                               = 0;
-        int temp_fd                             = 0;
-        gf_tier_conf_t  *tier_conf              = NULL;
+        int qfile_fd                            = -1;
 
-        tier_conf = &(query_cbk_args->defrag->tier_conf);
+        this = query_cbk_args->this;
+
+        gfdb_brick_info.time_stamp = &query_cbk_args->cycle->time_in_past;
+        gfdb_brick_info._gfdb_promote = query_cbk_args->is_promotion;
+        gfdb_brick_info._query_cbk_args = query_cbk_args;
 
-        /* Time format for error query files */
-        gettimeofday (&current_time, NULL);
-        gmtime_r (&current_time.tv_sec, &tm);
-        strftime (time_str, 256, time_format, &tm);
+        /* Delete any old query files for this brick */
+        sys_unlink (local_brick->qfile_path);
 
-        /* Build the qfile list */
-        list_for_each_entry_safe (local_brick, temp, comp->brick_list, list) {
-                qfile_array_size++;
+        ret = tier_process_brick (local_brick, &gfdb_brick_info);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        DHT_MSG_BRICK_QUERY_FAILED,
+                        "Brick %s query failed\n",
+                        local_brick->brick_db_path);
+                ret = 0;
+                goto out;
         }
-        query_cbk_args->qfile_array = qfile_array_new (qfile_array_size);
+
+        query_cbk_args->qfile_array = qfile_array_new (1);
         if (!query_cbk_args->qfile_array) {
-                gf_msg ("tier", GF_LOG_ERROR, 0,
+                gf_msg (this->name, GF_LOG_ERROR, 0,
                         DHT_MSG_LOG_TIER_ERROR, "Failed to create new "
                         "qfile_array");
+                ret = -1;
                 goto out;
         }
 
-        /*Open all qfiles*/
-        count = 0;
-        query_cbk_args->qfile_array->exhausted_count = 0;
-        list_for_each_entry_safe (local_brick, temp, comp->brick_list, list) {
-                temp_fd = query_cbk_args->qfile_array->fd_array[count];
-                temp_fd = open (local_brick->qfile_path, O_RDONLY,
-                                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-                if (temp_fd < 0) {
-                        gf_msg ("tier", GF_LOG_ERROR, errno,
-                                DHT_MSG_LOG_TIER_ERROR, "Failed to open "
-                                "%s to the query file",
-                                local_brick->qfile_path);
-                        query_cbk_args->qfile_array->exhausted_count++;
-                }
-                query_cbk_args->qfile_array->fd_array[count] = temp_fd;
-                count++;
-        }
-
-        /* Moving the query file index to the next, so that we won't the same
-         * query file every cycle as the first one */
-        query_cbk_args->qfile_array->next_index =
-                        (query_cbk_args->is_promotion) ?
-                        tier_conf->last_promote_qfile_index :
-                        tier_conf->last_demote_qfile_index;
-        shift_next_index (query_cbk_args->qfile_array);
-        if (query_cbk_args->is_promotion) {
-                tier_conf->last_promote_qfile_index =
-                        query_cbk_args->qfile_array->next_index;
-        } else {
-                tier_conf->last_demote_qfile_index =
-                        query_cbk_args->qfile_array->next_index;
+        qfile_fd = open (local_brick->qfile_path, O_RDONLY,
+                         S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (qfile_fd < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        DHT_MSG_LOG_TIER_ERROR, "Failed to open "
+                        "%s to the query file",
+                        local_brick->qfile_path);
+                ret = 0;
+                goto out;
         }
+        query_cbk_args->qfile_array->fd_array[0] = qfile_fd;
+        query_cbk_args->qfile_array->exhausted_count = 0;
 
-        /* Migrate files using query file list */
+        /* Migrate files using the query file */
         ret = tier_migrate_using_query_file ((void *)query_cbk_args);
 out:
         qfile_array_free (query_cbk_args->qfile_array);
+        query_cbk_args->qfile_array = NULL;
 
-        /* If there is an error rename all the query files to .err files
+        /* If there is an error rename the query file to a .err file
          * with a timestamp for better debugging */
         if (ret) {
-                list_for_each_entry_safe (local_brick, temp, comp->brick_list,
-                                        list) {
-                        /* rename error qfile*/
-                        snprintf (query_file_path_err, PATH_MAX, "%s-%s.err",
-                                local_brick->qfile_path, time_str);
-                        sys_rename (local_brick->qfile_path,
-                                query_file_path_err);
+                gettimeofday (&current_time, NULL);
+                gmtime_r (&current_time.tv_sec, &tm);
+                strftime (time_str, 256, time_format, &tm);
+                snprintf (query_file_path_err, PATH_MAX, "%s-%s.err",
+                          local_brick->qfile_path, time_str);
+                sys_rename (local_brick->qfile_path, query_file_path_err);
+        }
+
+        return ret;
+}
+
+/* A worker of a cycle, migrates from the bricks of the cycle one after the
+ * other until all are picked. Once the budget of the cycle is used up the
+ * remaining bricks are still queried, for their heat to be cleared as in
+ * every cycle, but nothing is migrated from them. */
+static void *
+tier_brick_worker (void *data)
+{
+        query_cbk_args_t *query_cbk_args        = data;
+        tier_cycle_t *cycle                     = NULL;
+        tier_brick_list_t *local_brick          = NULL;
+        int ret                                 = 0;
+
+        THIS = query_cbk_args->this;
+        cycle = query_cbk_args->cycle;
+
+        while ((local_brick = tier_cycle_next_brick (cycle)) != NULL) {
+                ret = tier_migrate_brick (local_brick, query_cbk_args);
+                if (ret) {
+                        pthread_mutex_lock (&cycle->lock);
+                        cycle->ret = -1;
+                        pthread_mutex_unlock (&cycle->lock);
                 }
         }
 
-        query_cbk_args->qfile_array = NULL;
+        return NULL;
+}
+
+/*
+ * Runs a promotion or demotion cycle over the local bricks of the cold or
+ * the hot tier. The bricks are taken by up to as many workers as
+ * rebal-throttle allows migrations in parallel on the node, one worker per
+ * brick at most, so that the migration from a brick starts as soon as its
+ * own query is done rather than after all the bricks are queried.
+ *
+ * Only the hottest (coldest) files of each brick are queried, a few times
+ * as many as tier-max-files (see TIER_QUERY_OVERFETCH): no brick can be
+ * migrated from more than the whole cycle may, but not every file queried
+ * gets migrated. The bricks are not merged into a node wide top list, the
+ * query records do not carry the heat to merge them by and waiting for all
+ * the queries would hold back the first migrations.
+ * */
+static int
+tier_migrate_cycle (migration_args_t *args, gf_boolean_t is_promotion)
+{
+        xlator_t *this                          = NULL;
+        gf_tier_conf_t *tier_conf               = NULL;
+        tier_cycle_t cycle                      = {0,};
+        tier_worker_t *workers                  = NULL;
+        tier_brick_list_t *local_brick          = NULL;
+        int worker_count                        = 0;
+        int spawned                             = 0;
+        int i                                   = 0;
+        int ret                                 = -1;
+
+        this = args->this;
+        tier_conf = &args->defrag->tier_conf;
+
+        pthread_mutex_init (&cycle.lock, NULL);
+        cycle.brick_list = args->brick_list;
+        list_for_each_entry (local_brick, args->brick_list, list) {
+                cycle.brick_count++;
+        }
+
+        if (cycle.brick_count == 0) {
+                ret = 0;
+                goto out;
+        }
+
+        ret = gettimeofday (&cycle.start_time, NULL);
+        if (ret == -1) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        DHT_MSG_SYS_CALL_GET_TIME_FAILED,
+                        "Failed to get current time");
+                goto out;
+        }
+        cycle.time_in_past.tv_sec = cycle.start_time.tv_sec - args->freq_time;
+
+        /* The migration daemon may run a varrying numberof usec after the sleep */
+        /* call triggers. A file may be registered in CTR some number of usec X */
+        /* after the daemon started and missed in the subsequent cycle if the */
+        /* daemon starts Y usec after the period in seconds where Y>X. Normalize */
+        /* away this problem by always setting usec to 0. */
+        cycle.time_in_past.tv_usec = 0;
+
+        /* 0 queries without a limit */
+        if (tier_conf->max_migrate_files <= INT_MAX / TIER_QUERY_OVERFETCH)
+                cycle.query_limit = tier_conf->max_migrate_files *
+                                    TIER_QUERY_OVERFETCH;
+
+        /* Moving the first brick to the next, so that the same brick does
+         * not get to use the budget first every cycle */
+        if (is_promotion) {
+                cycle.first_index = (tier_conf->last_promote_qfile_index + 1)
+                                    % cycle.brick_count;
+                tier_conf->last_promote_qfile_index = cycle.first_index;
+        } else {
+                cycle.first_index = (tier_conf->last_demote_qfile_index + 1)
+                                    % cycle.brick_count;
+                tier_conf->last_demote_qfile_index = cycle.first_index;
+        }
+
+        worker_count = args->defrag->recon_thread_count;
+        if (worker_count < 1)
+                worker_count = 1;
+        if (worker_count > cycle.brick_count)
+                worker_count = cycle.brick_count;
+
+        workers = GF_CALLOC (worker_count, sizeof (tier_worker_t),
+                             gf_tier_mt_worker_t);
+        if (!workers) {
+                ret = -1;
+                goto out;
+        }
+
+        for (i = 0; i < worker_count; i++) {
+                workers[i].query_cbk_args.this = this;
+                workers[i].query_cbk_args.defrag = args->defrag;
+                workers[i].query_cbk_args.is_promotion = is_promotion;
+                workers[i].query_cbk_args.query_fd = -1;
+                workers[i].query_cbk_args.cycle = &cycle;
+        }
+
+        /* This thread is the first worker */
+        for (i = 1; i < worker_count; i++) {
+                ret = gf_thread_create (&workers[i].thread, NULL,
+                                        tier_brick_worker,
+                                        &workers[i].query_cbk_args);
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_WARNING, 0,
+                                DHT_MSG_LOG_TIER_ERROR,
+                                "Failed to start tier worker, migrating "
+                                "with %d workers", i);
+                        break;
+                }
+                spawned++;
+        }
+
+        tier_brick_worker (&workers[0].query_cbk_args);
+
+        for (i = 1; i <= spawned; i++) {
+                pthread_join (workers[i].thread, NULL);
+        }
 
+        ret = cycle.ret;
+out:
+        GF_FREE (workers);
+        pthread_mutex_destroy (&cycle.lock);
         return ret;
 }
 
@@ -1582,7 +1772,6 @@ out:
 int
 tier_demote (migration_args_t *demotion_args)
 {
-        query_cbk_args_t query_cbk_args;
         int ret = -1;
 
         GF_VALIDATE_OR_GOTO ("tier", demotion_args, out);
@@ -1594,21 +1783,7 @@ tier_demote (migration_args_t *demotion_args)
 
         THIS = demotion_args->this;
 
-        query_cbk_args.this = demotion_args->this;
-        query_cbk_args.defrag = demotion_args->defrag;
-        query_cbk_args.is_promotion = 0;
-
-        /*Build the query file using bricklist*/
-        ret = tier_build_migration_qfile (demotion_args, &query_cbk_args,
-                                          _gf_false);
-        if (ret)
-                goto out;
-
-        /* Migrate files using the query file */
-        ret = tier_migrate_files_using_qfile (demotion_args,
-                                              &query_cbk_args);
-        if (ret)
-                goto out;
+        ret = tier_migrate_cycle (demotion_args, _gf_false);
 
 out:
         demotion_args->return_value = ret;
@@ -1620,7 +1795,6 @@ int
 tier_promote (migration_args_t *promotion_args)
 {
         int ret = -1;
-        query_cbk_args_t query_cbk_args;
 
         GF_VALIDATE_OR_GOTO ("tier", promotion_args->this, out);
         GF_VALIDATE_OR_GOTO (promotion_args->this->name,
@@ -1630,20 +1804,7 @@ tier_promote (migration_args_t *promotion_args)
 
         THIS = promotion_args->this;
 
-        query_cbk_args.this = promotion_args->this;
-        query_cbk_args.defrag = promotion_args->defrag;
-        query_cbk_args.is_promotion = 1;
-
-        /*Build the query file using bricklist*/
-        ret = tier_build_migration_qfile (promotion_args, &query_cbk_args,
-                                          _gf_true);
-        if (ret)
-                goto out;
-
-        /* Migrate files using the query file */
-        ret = tier_migrate_files_using_qfile (promotion_args, &query_cbk_args);
-        if (ret)
-                goto out;
+        ret = tier_migrate_cycle (promotion_args, _gf_true);
 
 out:
         promotion_args->return_value = ret;
@@ -48,6 +48,30 @@ typedef struct tier_qfile_array {
 } tier_qfile_array_t;
 
 
+/*
+ * A promotion or demotion cycle. The bricks of the cycle are queried and
+ * migrated from by parallel workers, each worker migrating the files of a
+ * brick as soon as its query is done. The files migrated by the workers
+ * are counted against the budget of the cycle (tier-max-files and
+ * tier-max-mb) as a whole.
+ * */
+typedef struct tier_cycle {
+        pthread_mutex_t         lock;
+        struct list_head        *brick_list;
+        int                     brick_count;
+        /* Index of the first brick picked, the bricks are picked from
+         * there on in the order of the list */
+        int                     first_index;
+        int                     picked;
+        gfdb_time_t             time_in_past;
+        gfdb_time_t             start_time;
+        int                     query_limit;
+        int                     files_migrated;
+        uint64_t                bytes_migrated;
+        gf_boolean_t            budget_exhausted;
+        int                     ret;
+} tier_cycle_t;
+
 typedef struct _query_cbk_args {
         xlator_t                *this;
         gf_defrag_info_t        *defrag;
@@ -56,8 +80,14 @@ typedef struct _query_cbk_args {
         int                     is_promotion;
         /* This is for read */
         tier_qfile_array_t       *qfile_array;
+        tier_cycle_t            *cycle;
 } query_cbk_args_t;
 
+typedef struct tier_worker {
+        pthread_t               thread;
+        query_cbk_args_t        query_cbk_args;
+} tier_worker_t;
+
 int
 gf_run_tier(xlator_t *this, gf_defrag_info_t *defrag);
 
@@ -102,4 +132,10 @@ typedef enum tier_watermark_op_ {
 #define DEFAULT_TIER_MAX_MIGRATE_MB    1000
 #define DEFAULT_TIER_MAX_MIGRATE_FILES 5000
 
+/* The limit of a brick query counts the links of the files, and some of
+ * the files it returns are skipped (already being migrated, on the other
+ * tier already, gone). A brick is queried for this many times tier-max-files
+ * links, so that skipped files do not leave the budget of a cycle unused. */
+#define TIER_QUERY_OVERFETCH           4
+
 #endif
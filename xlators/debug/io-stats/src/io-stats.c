@@ -135,6 +135,8 @@ struct ios_conf {
         gf_boolean_t              dump_fd_stats;
         gf_boolean_t              count_fop_hits;
         gf_boolean_t              measure_latency;
+        gf_boolean_t              fop_trace; /* holds a ref on the tracing
+                                                of the process */
         struct ios_stat_head      list[IOS_STATS_TYPE_MAX];
         struct ios_stat_head      thru_list[IOS_STATS_THRU_MAX];
         int32_t                   ios_dump_interval;
@@ -3532,6 +3534,7 @@ reconfigure (xlator_t *this, dict_t *options)
         uint32_t            log_buf_size = 0;
         uint32_t            log_flush_timeout = 0;
         int32_t             old_dump_interval;
+        gf_boolean_t        fop_trace = _gf_false;
 
         if (!this || !this->private)
                 goto out;
@@ -3547,6 +3550,16 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("latency-measurement", conf->measure_latency,
                           options, bool, out);
 
+        /* other instances in the process may trace too */
+        GF_OPTION_RECONF ("fop-trace", fop_trace, options, bool, out);
+        if (fop_trace != conf->fop_trace) {
+                if (fop_trace)
+                        gf_fop_trace_ref (this->ctx);
+                else
+                        gf_fop_trace_unref (this->ctx);
+                conf->fop_trace = fop_trace;
+        }
+
         old_dump_interval = conf->ios_dump_interval;
         GF_OPTION_RECONF ("ios-dump-interval", conf->ios_dump_interval, options,
                          int32, out);
@@ -3742,6 +3755,11 @@ init (xlator_t *this)
         GF_OPTION_INIT ("log-flush-timeout", log_flush_timeout, time, out);
         gf_log_set_log_flush_timeout (log_flush_timeout);
 
+        /* last, so that no ref is left behind by a failed init */
+        GF_OPTION_INIT ("fop-trace", conf->fop_trace, bool, out);
+        if (conf->fop_trace)
+                gf_fop_trace_ref (this->ctx);
+
         this->private = conf;
         if (conf->ios_dump_interval > 0) {
                 pthread_create (&conf->dump_thread, NULL,
@@ -3767,6 +3785,9 @@ fini (xlator_t *this)
 
         conf = this->private;
 
+        if (conf && conf->fop_trace)
+                gf_fop_trace_unref (this->ctx);
+
         ios_conf_destroy (conf);
         this->private = NULL;
         gf_log (this->name, GF_LOG_INFO,
@@ -3990,6 +4011,13 @@ struct volume_options options[] = {
           .description = "If on stats related to the latency of each operation "
                          "would be tracked inside GlusterFS data-structures. "
         },
+        { .key  = { "fop-trace" },
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "If on, every fop is recorded into per-thread "
+                         "binary rings which are written out in Chrome "
+                         "trace-event JSON format along with a statedump."
+        },
         { .key  = {"count-fop-hits"},
           .type = GF_OPTION_TYPE_BOOL,
         },
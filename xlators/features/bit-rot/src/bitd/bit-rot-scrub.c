@@ -143,9 +143,11 @@ static int32_t
 bitd_signature_staleness (xlator_t *this,
                           br_child_t *child, fd_t *fd,
                           int *stale, unsigned long *version,
+                          br_isignature_out_t **signature,
                           br_scrub_stats_t *scrub_stat, gf_boolean_t skip_stat)
 {
         int32_t ret = -1;
+        size_t signlen = 0;
         dict_t *xattr = NULL;
         br_isignature_out_t *signptr = NULL;
 
@@ -163,6 +165,16 @@ bitd_signature_staleness (xlator_t *this,
         *stale = signptr->stale ? 1 : 0;
         *version = signptr->version;
 
+        /* signature type (and its parameters) decide how to checksum */
+        signlen = signptr->signaturelen;
+        *signature = GF_CALLOC (1, sizeof (br_isignature_out_t) + signlen,
+                                gf_common_mt_char);
+        if (*signature)
+                (void) memcpy (*signature, signptr,
+                               sizeof (br_isignature_out_t) + signlen);
+        else
+                ret = -1;
+
         dict_unref (xattr);
 
  out:
@@ -180,6 +192,7 @@ bitd_signature_staleness (xlator_t *this,
 int32_t
 bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
                               fd_t *fd, unsigned long *version,
+                              br_isignature_out_t **signature,
                               br_scrub_stats_t *scrub_stat,
                               gf_boolean_t skip_stat)
 {
@@ -194,13 +207,15 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
         }
 
         ret = bitd_signature_staleness (this, child, fd, &stale, version,
-                                        scrub_stat, skip_stat);
+                                        signature, scrub_stat, skip_stat);
         if (!ret && stale) {
                 if (!skip_stat)
                         br_inc_unsigned_file_count (scrub_stat);
                 gf_msg_debug (this->name, 0, "<STAGE: PRE> Object [GFID: %s] "
                               "has stale signature",
                               uuid_utoa (fd->inode->gfid));
+                GF_FREE (*signature);
+                *signature = NULL;
                 ret = -1;
         }
 
@@ -208,14 +223,73 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
         return ret;
 }
 
+#define BR_MAX_REPORTED_BLOCKS 32
+
+/**
+ * Tell which blocks of a corrupted merkle signed object are bad by
+ * comparing the leaves just computed with the ones the object was signed
+ * with, provided those are still around and match the signature.
+ */
+static void
+bitd_report_corrupted_blocks (xlator_t *this, br_child_t *child,
+                              br_isignature_out_t *sign, br_merkle_t *merkle,
+                              inode_t *linked_inode, loc_t *loc)
+{
+        uint32_t               i      = 0;
+        uint32_t               nr     = 0;
+        br_merkle_t            signedtree = {0,};
+        br_merkle_signature_t *msign  = NULL;
+
+        msign = (br_merkle_signature_t *)sign->signature;
+
+        if (br_merkle_load (child, linked_inode->gfid,
+                            sign->version, &signedtree))
+                return;
+
+        if ((signedtree.blockshift != msign->blockshift)
+            || (memcmp (signedtree.root, msign->root,
+                        SHA256_DIGEST_LENGTH) != 0))
+                goto wipe;
+
+        for (i = 0; i < max (signedtree.nr_leaves, merkle->nr_leaves); i++) {
+                if ((i < signedtree.nr_leaves) && (i < merkle->nr_leaves)
+                    && (memcmp (signedtree.leaves +
+                                (size_t)i * SHA256_DIGEST_LENGTH,
+                                merkle->leaves +
+                                (size_t)i * SHA256_DIGEST_LENGTH,
+                                SHA256_DIGEST_LENGTH) == 0))
+                        continue;
+
+                if (nr++ < BR_MAX_REPORTED_BLOCKS)
+                        gf_msg (this->name, GF_LOG_ALERT, 0,
+                                BRB_MSG_CORRUPTED_BLOCK, "CORRUPTED BLOCK: "
+                                "Object %s {Brick: %s | GFID: %s | Offset: "
+                                "%"PRIu64" | Length: %"PRIu64"}", loc->path,
+                                child->brick_path,
+                                uuid_utoa (linked_inode->gfid),
+                                (uint64_t)i << signedtree.blockshift,
+                                (uint64_t)1 << signedtree.blockshift);
+        }
+
+        gf_msg (this->name, GF_LOG_ALERT, 0, BRB_MSG_CORRUPTED_BLOCK,
+                "%u corrupted block(s) in object %s {Brick: %s | GFID: %s}",
+                nr, loc->path, child->brick_path,
+                uuid_utoa (linked_inode->gfid));
+
+ wipe:
+        br_merkle_wipe (&signedtree);
+}
+
 /* static int */
 int
 bitd_compare_ckum (xlator_t *this,
                    br_isignature_out_t *sign,
-                   unsigned char *md, inode_t *linked_inode,
-                   gf_dirent_t *entry, fd_t *fd, br_child_t *child, loc_t *loc)
+                   unsigned char *md, br_merkle_t *merkle,
+                   inode_t *linked_inode, gf_dirent_t *entry,
+                   fd_t *fd, br_child_t *child, loc_t *loc)
 {
         int   ret = -1;
+        int   match = 0;
         dict_t *xattr = NULL;
 
         GF_VALIDATE_OR_GOTO ("bit-rot", this, out);
@@ -226,8 +300,14 @@ bitd_compare_ckum (xlator_t *this,
         GF_VALIDATE_OR_GOTO (this->name, md, out);
         GF_VALIDATE_OR_GOTO (this->name, entry, out);
 
-        if (strncmp
-            (sign->signature, (char *) md, strlen (sign->signature)) == 0) {
+        if (sign->signaturetype == BR_SIGNATURE_TYPE_MERKLE)
+                match = (memcmp (sign->signature, md,
+                                 sign->signaturelen) == 0);
+        else
+                match = (strncmp (sign->signature, (char *) md,
+                                  strlen (sign->signature)) == 0);
+
+        if (match) {
                 gf_msg_debug (this->name, 0, "%s [GFID: %s | Brick: %s] "
                               "matches calculated checksum", loc->path,
                               uuid_utoa (linked_inode->gfid),
@@ -242,6 +322,10 @@ bitd_compare_ckum (xlator_t *this,
                 "CORRUPTION DETECTED: Object %s {Brick: %s | GFID: %s}",
                 loc->path, child->brick_path, uuid_utoa (linked_inode->gfid));
 
+        if (merkle)
+                bitd_report_corrupted_blocks (this, child, sign, merkle,
+                                              linked_inode, loc);
+
         /* Perform bad-file marking */
         xattr = dict_new ();
         if (!xattr) {
@@ -276,9 +360,9 @@ bitd_compare_ckum (xlator_t *this,
 /**
  * "The Scrubber"
  *
- * Perform signature validation for a given object with the assumption
- * that the signature is SHA256 (because signer as of now _always_
- * signs with SHA256).
+ * Perform signature validation for a given object. The object is
+ * checksummed the way it was signed: a plain SHA256, or a merkle tree
+ * with the block size recorded in the signature.
  */
 int
 br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
@@ -293,6 +377,9 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         unsigned char         *md            = NULL;
         inode_t               *linked_inode  = NULL;
         br_isignature_out_t   *sign          = NULL;
+        br_isignature_out_t   *presign       = NULL;
+        br_merkle_signature_t *msign         = NULL;
+        br_merkle_t            merkle        = {0, };
         unsigned long          signedversion = 0;
         gf_dirent_t           *entry         = NULL;
         br_private_t          *priv          = NULL;
@@ -381,17 +468,33 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
          *  - signature staleness
          */
         ret = bitd_scrub_pre_compute_check (this, child, fd, &signedversion,
-                                            &priv->scrub_stat, skip_stat);
+                                            &presign, &priv->scrub_stat,
+                                            skip_stat);
         if (ret)
                 goto unrefd; /* skip this object */
 
         /* if all's good, proceed to calculate the hash */
-        md = GF_CALLOC (SHA256_DIGEST_LENGTH, sizeof (*md),
+        md = GF_CALLOC (max (SHA256_DIGEST_LENGTH,
+                             sizeof (br_merkle_signature_t)), sizeof (*md),
                         gf_common_mt_char);
         if (!md)
-                goto unrefd;
+                goto free_presign;
 
-        ret = br_calculate_obj_checksum (md, child, fd, &iatt);
+        if (presign->signaturetype == BR_SIGNATURE_TYPE_MERKLE) {
+                ret = -1;
+                msign = (br_merkle_signature_t *)presign->signature;
+                if ((presign->signaturelen == sizeof (*msign))
+                    && (msign->blockshift < 64))
+                        ret = br_merkle_compute (child, fd, iatt.ia_size,
+                                                 msign->blockshift, NULL,
+                                                 NULL, &merkle);
+
+                msign = (br_merkle_signature_t *)md;
+                msign->blockshift = merkle.blockshift;
+                memcpy (msign->root, merkle.root, SHA256_DIGEST_LENGTH);
+        } else {
+                ret = br_calculate_obj_checksum (md, child, fd, &iatt);
+        }
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_CALC_ERROR,
                         "error calculating hash for object [GFID: %s]",
@@ -411,6 +514,7 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
                 goto free_md;
 
         ret = bitd_compare_ckum (this, sign, md,
+                                 merkle.leaves ? &merkle : NULL,
                                  linked_inode, entry, fd, child, &loc);
 
         if (!skip_stat)
@@ -421,7 +525,10 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         /** fd_unref() takes care of closing fd.. like syncop_close() */
 
  free_md:
+        br_merkle_wipe (&merkle);
         GF_FREE (md);
+ free_presign:
+        GF_FREE (presign);
  unrefd:
         fd_unref (fd);
  unref_inode:
@@ -439,8 +546,18 @@ _br_lock_cleaner (void *arg)
         pthread_mutex_unlock (mutex);
 }
 
+#define NR_ENTRIES (1<<7) /* ..bulk scrubbing */
+
+/**
+ * Hand off the collected entries to the scrubbers and wait till no more
+ * than @limit entries are left to be scrubbed. While crawling, @limit is
+ * a batch worth of entries: the crawler goes on reading directories while
+ * scrubbers work through the previous batch, which keeps at most two
+ * batches in flight per subvolume. At the end of the crawl @limit is zero.
+ */
 static void
-wait_for_scrubbing (xlator_t *this, struct br_scanfs *fsscan)
+wait_for_scrubbing (xlator_t *this,
+                    struct br_scanfs *fsscan, unsigned int limit)
 {
         br_private_t *priv = NULL;
         struct br_scrubber *fsscrub = NULL;
@@ -448,21 +565,26 @@ wait_for_scrubbing (xlator_t *this, struct br_scanfs *fsscan)
         priv = this->private;
         fsscrub = &priv->fsscrub;
 
-        pthread_cleanup_push (_br_lock_cleaner, &fsscan->waitlock);
-        pthread_mutex_lock (&fsscan->waitlock);
+        pthread_cleanup_push (_br_lock_cleaner, &fsscrub->mutex);
+        pthread_mutex_lock (&fsscrub->mutex);
         {
-                pthread_cleanup_push (_br_lock_cleaner, &fsscrub->mutex);
-                pthread_mutex_lock (&fsscrub->mutex);
+                LOCK (&fsscan->entrylock);
                 {
-                        list_replace_init (&fsscan->queued, &fsscan->ready);
-
-                        /* wake up scrubbers */
-                        pthread_cond_broadcast (&fsscrub->cond);
+                        list_append_init (&fsscan->queued, &fsscan->ready);
+                        fsscan->nr_queued = 0;
                 }
-                pthread_mutex_unlock (&fsscrub->mutex);
-                pthread_cleanup_pop (0);
+                UNLOCK (&fsscan->entrylock);
 
-                while (fsscan->entries != 0)
+                /* wake up scrubbers */
+                pthread_cond_broadcast (&fsscrub->cond);
+        }
+        pthread_mutex_unlock (&fsscrub->mutex);
+        pthread_cleanup_pop (0);
+
+        pthread_cleanup_push (_br_lock_cleaner, &fsscan->waitlock);
+        pthread_mutex_lock (&fsscan->waitlock);
+        {
+                while (fsscan->entries > limit)
                         pthread_cond_wait
                                     (&fsscan->waitcond, &fsscan->waitlock);
         }
@@ -479,7 +601,10 @@ _br_fsscan_inc_entry_count (struct br_scanfs *fsscan)
 static void
 _br_fsscan_dec_entry_count (struct br_scanfs *fsscan)
 {
-        if (--fsscan->entries == 0) {
+        --fsscan->entries;
+
+        /* the two limits the crawler waits on */
+        if ((fsscan->entries == 0) || (fsscan->entries == NR_ENTRIES)) {
                 pthread_mutex_lock (&fsscan->waitlock);
                 {
                         pthread_cond_signal (&fsscan->waitcond);
@@ -493,11 +618,10 @@ _br_fsscan_collect_entry (struct br_scanfs *fsscan,
                            struct br_fsscan_entry *fsentry)
 {
         list_add_tail (&fsentry->list, &fsscan->queued);
+        fsscan->nr_queued++;
         _br_fsscan_inc_entry_count (fsscan);
 }
 
-#define NR_ENTRIES (1<<7) /* ..bulk scrubbing */
-
 int
 br_fsscanner_handle_entry (xlator_t *subvol,
                            gf_dirent_t *entry, loc_t *parent, void *data)
@@ -547,7 +671,7 @@ br_fsscanner_handle_entry (xlator_t *subvol,
                  * need not be a equality check as entries may be pushed
                  * back onto the scanned queue when thread(s) are cleaned.
                  */
-                if (fsscan->entries >= NR_ENTRIES)
+                if (fsscan->nr_queued >= NR_ENTRIES)
                         scrub = 1;
         }
         UNLOCK (&fsscan->entrylock);
@@ -555,7 +679,7 @@ br_fsscanner_handle_entry (xlator_t *subvol,
         _unmask_cancellation ();
 
         if (scrub)
-                wait_for_scrubbing (this, fsscan);
+                wait_for_scrubbing (this, fsscan, NR_ENTRIES);
 
         return 0;
 
@@ -806,8 +930,7 @@ br_fsscanner (void *arg)
                         (void) syncop_ftw (child->xl,
                                            &loc, GF_CLIENT_PID_SCRUB,
                                            child, br_fsscanner_handle_entry);
-                        if (!list_empty (&fsscan->queued))
-                                wait_for_scrubbing (this, fsscan);
+                        wait_for_scrubbing (this, fsscan, 0);
 
                         /* scrub exit criteria */
                         br_fsscanner_exit_control (this, child);
@@ -1224,7 +1347,6 @@ void *br_scrubber_proc (void *arg)
         while (1) {
                 br_scrubber_pick_entry (fsscrub, &fsentry);
                 br_scrubber_scrub_entry (this, fsentry);
-                sleep (1);
         }
 
         return NULL;
@@ -1467,6 +1589,58 @@ br_scrubber_handle_freq (xlator_t *this, br_private_t *priv,
         return -1;
 }
 
+#define BR_SCRUB_RATE_INTERVAL 100000 /* In usec */
+
+/**
+ * Scrub rate is enforced by the token bucket filter in bytes: scrubbers
+ * take tokens for every byte they checksum, refilled a tenth of the rate
+ * every BR_SCRUB_RATE_INTERVAL. The bucket holds up to a second worth of
+ * tokens, but never less than a read, so that bursts stay bounded.
+ */
+static int32_t
+br_scrubber_handle_rate (xlator_t *this, br_private_t *priv, dict_t *options)
+{
+        int32_t             ret     = 0;
+        uint64_t            rate    = 0;
+        tbf_opspec_t        spec    = {0,};
+        struct br_scrubber *fsscrub = NULL;
+
+        fsscrub = &priv->fsscrub;
+
+        if (options)
+                GF_OPTION_RECONF ("scrub-rate", rate,
+                                  options, size_uint64, error_return);
+        else
+                GF_OPTION_INIT ("scrub-rate", rate, size_uint64, error_return);
+
+        if (rate == fsscrub->rate)
+                return 0;
+
+        spec.op = TBF_OP_HASH;
+        spec.token_gen_interval = BR_SCRUB_RATE_INTERVAL;
+        spec.rate = rate / (1000000 / BR_SCRUB_RATE_INTERVAL);
+        if (rate && !spec.rate)
+                spec.rate = 1;
+        spec.maxlimit = max (rate, BR_SCRUB_READ_SIZE);
+
+        ret = tbf_mod (priv->tbf, &spec);
+        if (ret)
+                goto error_return;
+
+        fsscrub->rate = rate;
+
+        if (!rate)
+                gf_msg (this->name, GF_LOG_INFO, 0, BRB_MSG_SCRUB_TUNABLE,
+                        "SCRUB RATE:: \"FULL THROTTLE\"");
+        else
+                gf_msg (this->name, GF_LOG_INFO, 0, BRB_MSG_SCRUB_TUNABLE,
+                        "SCRUB RATE:: %"PRIu64" bytes/sec", rate);
+        return 0;
+
+ error_return:
+        return -1;
+}
+
 static void br_scrubber_log_option (xlator_t *this,
                                     br_private_t *priv, gf_boolean_t scrubstall)
 {
@@ -1515,6 +1689,10 @@ br_scrubber_handle_options (xlator_t *this, br_private_t *priv, dict_t *options)
         if (ret)
                 goto error_return;
 
+        ret = br_scrubber_handle_rate (this, priv, options);
+        if (ret)
+                goto error_return;
+
         br_scrubber_log_option (this, priv, scrubstall);
 
         return 0;
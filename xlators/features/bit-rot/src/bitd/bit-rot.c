@@ -15,6 +15,7 @@
 #include "xlator.h"
 #include "logging.h"
 #include "compat-errno.h"
+#include "syscall.h"
 
 #include "bit-rot.h"
 #include "bit-rot-scrub.h"
@@ -316,7 +317,7 @@ br_object_read_block_and_sign (xlator_t *this, fd_t *fd, br_child_t *child,
                         SHA256_Update (sha256, (const unsigned char *)
                                        (iovec[i].iov_base), iovec[i].iov_len);
                 }
-                TBF_THROTTLE_BEGIN (tbf, TBF_OP_HASH, iovec[i].iov_len);
+                TBF_THROTTLE_END (tbf, TBF_OP_HASH, iovec[i].iov_len);
         }
 
  out:
@@ -333,10 +334,11 @@ int32_t
 br_calculate_obj_checksum (unsigned char *md,
                            br_child_t *child, fd_t *fd, struct iatt *iatt)
 {
-        int32_t   ret    = -1;
-        off_t     offset = 0;
-        size_t    block  = BR_HASH_CALC_READ_SIZE;
-        xlator_t *this   = NULL;
+        int32_t       ret    = -1;
+        off_t         offset = 0;
+        size_t        block  = BR_HASH_CALC_READ_SIZE;
+        xlator_t     *this   = NULL;
+        br_private_t *priv   = NULL;
 
         SHA256_CTX       sha256;
 
@@ -345,6 +347,15 @@ br_calculate_obj_checksum (unsigned char *md,
         GF_VALIDATE_OR_GOTO ("bit-rot", fd, out);
 
         this = child->this;
+        priv = this->private;
+
+        /**
+         * scrubbing reads whole files back to back: fewer, larger reads
+         * keep the disks streaming. offsets stay multiples of the block
+         * size as only the last read of a file comes back short.
+         */
+        if (priv->iamscrubber)
+                block = BR_SCRUB_READ_SIZE;
 
         SHA256_Init (&sha256);
 
@@ -379,12 +390,444 @@ br_object_checksum (unsigned char *md,
         return br_calculate_obj_checksum (md, object->child, fd,  iatt);
 }
 
+/**
+ * Merkle signing
+ *
+ * An object is split into fixed size blocks, each block is hashed with
+ * SHA256 and the signature is the SHA256 over the block size and all the
+ * block hashes (leaves). The leaves are kept in a sidecar file on the
+ * brick, so that re-signing an object after a modification only reads
+ * the blocks the stub reports as dirty, and the scrubber can tell which
+ * blocks of a corrupted object are bad.
+ */
+uint8_t
+br_merkle_blockshift (uint64_t blocksize, uint64_t size)
+{
+        uint8_t shift = BR_MERKLE_MIN_BLOCKSHIFT;
+
+        while ((1ULL << shift) < blocksize)
+                shift++;
+        while (((size + (1ULL << shift) - 1) >> shift) > BR_MERKLE_MAX_LEAVES)
+                shift++;
+
+        return shift;
+}
+
+static void
+br_merkle_root (br_merkle_t *merkle)
+{
+        SHA256_CTX sha256;
+
+        SHA256_Init (&sha256);
+        SHA256_Update (&sha256, &merkle->blockshift,
+                       sizeof (merkle->blockshift));
+        SHA256_Update (&sha256, merkle->leaves,
+                       (size_t)merkle->nr_leaves * SHA256_DIGEST_LENGTH);
+        SHA256_Final (merkle->root, &sha256);
+}
+
+/**
+ * can leaf @leaf be taken from @old? not if the block was written to, or
+ * if it's the last block of either tree and the object size changed.
+ */
+static gf_boolean_t
+br_merkle_leaf_clean (br_merkle_t *merkle, br_merkle_t *old,
+                      br_dirty_extents_t *dirty, uint32_t leaf)
+{
+        uint32_t i     = 0;
+        uint64_t start = 0;
+        uint64_t end   = 0;
+
+        if (!old || (leaf >= old->nr_leaves))
+                return _gf_false;
+
+        if ((old->size != merkle->size)
+            && ((leaf == (old->nr_leaves - 1))
+                || (leaf == (merkle->nr_leaves - 1))))
+                return _gf_false;
+
+        start = (uint64_t)leaf << merkle->blockshift;
+        end = start + (1ULL << merkle->blockshift);
+
+        for (i = 0; i < dirty->count; i++) {
+                if ((dirty->extent[i].start < end)
+                    && (dirty->extent[i].end > start))
+                        return _gf_false;
+        }
+
+        return _gf_true;
+}
+
+/**
+ * hash the (contiguous) blocks @first..@last of an object. reads are not
+ * limited to a block, a read spanning blocks is split among them.
+ */
+static int32_t
+br_merkle_hash_blocks (xlator_t *this, br_child_t *child, fd_t *fd,
+                       br_merkle_t *merkle, uint32_t first, uint32_t last)
+{
+        int32_t        ret      = 0;
+        int            i        = 0;
+        int            count    = 0;
+        size_t         len      = 0;
+        size_t         n        = 0;
+        size_t         readsize = BR_HASH_CALC_READ_SIZE;
+        uint64_t       offset   = 0;
+        uint64_t       end      = 0;
+        uint64_t       blockend = 0;
+        uint32_t       leaf     = first;
+        char          *ptr      = NULL;
+        tbf_t         *tbf      = NULL;
+        struct iovec  *iovec    = NULL;
+        struct iobref *iobref   = NULL;
+        br_private_t  *priv     = NULL;
+        SHA256_CTX     sha256;
+
+        priv = this->private;
+        tbf = priv->tbf;
+
+        if (priv->iamscrubber)
+                readsize = BR_SCRUB_READ_SIZE;
+
+        offset = (uint64_t)first << merkle->blockshift;
+        end = min (merkle->size, (uint64_t)(last + 1) << merkle->blockshift);
+        blockend = min (end, offset + (1ULL << merkle->blockshift));
+
+        SHA256_Init (&sha256);
+
+        while (offset < end) {
+                ret = syncop_readv (child->xl, fd, min (readsize, end - offset),
+                                    offset, 0, &iovec, &count, &iobref, NULL,
+                                    NULL);
+                if (ret < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, -ret,
+                                BRB_MSG_BLOCK_READ_FAILED, "reading block with "
+                                "offset %"PRIu64" of object %s failed", offset,
+                                uuid_utoa (fd->inode->gfid));
+                        ret = -1;
+                        break;
+                }
+
+                /* object shrunk underneath, signature will be stale */
+                if (ret == 0)
+                        break;
+
+                for (i = 0; (i < count) && (offset < end); i++) {
+                        ptr = iovec[i].iov_base;
+                        len = iovec[i].iov_len;
+
+                        while (len && (offset < end)) {
+                                n = min (len, blockend - offset);
+
+                                TBF_THROTTLE_BEGIN (tbf, TBF_OP_HASH, n);
+                                {
+                                        SHA256_Update (&sha256, ptr, n);
+                                }
+                                TBF_THROTTLE_END (tbf, TBF_OP_HASH, n);
+
+                                ptr += n;
+                                len -= n;
+                                offset += n;
+
+                                if (offset == blockend) {
+                                        SHA256_Final (merkle->leaves + (size_t)
+                                                      leaf * SHA256_DIGEST_LENGTH,
+                                                      &sha256);
+                                        SHA256_Init (&sha256);
+                                        leaf++;
+                                        blockend = min (end, blockend +
+                                                   (1ULL << merkle->blockshift));
+                                }
+                        }
+                }
+
+                GF_FREE (iovec);
+                iovec = NULL;
+                iobref_unref (iobref);
+                iobref = NULL;
+                ret = 0;
+        }
+
+        if (leaf <= last)
+                SHA256_Final (merkle->leaves
+                              + (size_t)leaf * SHA256_DIGEST_LENGTH, &sha256);
+
+        if (iovec)
+                GF_FREE (iovec);
+        if (iobref)
+                iobref_unref (iobref);
+
+        return ret;
+}
+
+/**
+ * build the merkle tree of an object of @size bytes. leaves of blocks
+ * that are clean with respect to @dirty are reused from @old (if given),
+ * the rest are read and hashed.
+ */
+int32_t
+br_merkle_compute (br_child_t *child, fd_t *fd, uint64_t size,
+                   uint8_t blockshift, br_merkle_t *old,
+                   br_dirty_extents_t *dirty, br_merkle_t *merkle)
+{
+        int32_t   ret  = 0;
+        uint32_t  i    = 0;
+        uint32_t  j    = 0;
+        xlator_t *this = NULL;
+
+        this = child->this;
+
+        merkle->blockshift = blockshift;
+        merkle->size = size;
+        merkle->nr_leaves = size ? ((size - 1) >> blockshift) + 1 : 0;
+
+        merkle->leaves = GF_CALLOC (max (merkle->nr_leaves, 1),
+                                    SHA256_DIGEST_LENGTH,
+                                    gf_br_mt_merkle_leaves_t);
+        if (!merkle->leaves)
+                return -1;
+
+        for (i = 0; i < merkle->nr_leaves; i = j) {
+                if (br_merkle_leaf_clean (merkle, old, dirty, i)) {
+                        memcpy (merkle->leaves + (size_t)i * SHA256_DIGEST_LENGTH,
+                                old->leaves + (size_t)i * SHA256_DIGEST_LENGTH,
+                                SHA256_DIGEST_LENGTH);
+                        j = i + 1;
+                        continue;
+                }
+
+                for (j = i + 1; j < merkle->nr_leaves; j++) {
+                        if (br_merkle_leaf_clean (merkle, old, dirty, j))
+                                break;
+                }
+
+                ret = br_merkle_hash_blocks (this, child, fd, merkle, i, j - 1);
+                if (ret)
+                        goto error_return;
+        }
+
+        br_merkle_root (merkle);
+        return 0;
+
+ error_return:
+        br_merkle_wipe (merkle);
+        return -1;
+}
+
+void
+br_merkle_wipe (br_merkle_t *merkle)
+{
+        GF_FREE (merkle->leaves);
+        memset (merkle, 0, sizeof (*merkle));
+}
+
+static void
+br_merkle_path (br_child_t *child, uuid_t gfid, char *path, size_t len)
+{
+        (void) snprintf (path, len, "%s/%s/%s",
+                         child->brick_path, BR_MERKLE_DIR, uuid_utoa (gfid));
+}
+
+/**
+ * load the leaves an object was signed with at version @version. the
+ * root is recomputed to catch a torn sidecar.
+ */
+int32_t
+br_merkle_load (br_child_t *child, uuid_t gfid,
+                unsigned long version, br_merkle_t *merkle)
+{
+        int                 fd     = -1;
+        size_t              len    = 0;
+        char                path[PATH_MAX] = {0,};
+        br_merkle_header_t  header = {0,};
+
+        br_merkle_path (child, gfid, path, sizeof (path));
+
+        fd = open (path, O_RDONLY, 0);
+        if (fd < 0)
+                goto error_return;
+
+        if (sys_read (fd, &header, sizeof (header)) != sizeof (header))
+                goto error_return;
+
+        if ((header.magic != BR_MERKLE_MAGIC)
+            || (header.signedversion != version)
+            || (header.nr_leaves > BR_MERKLE_MAX_LEAVES)
+            || (header.blockshift >= 64)
+            || (header.nr_leaves != (header.size
+                ? ((header.size - 1) >> header.blockshift) + 1 : 0)))
+                goto error_return;
+
+        merkle->blockshift = header.blockshift;
+        merkle->size = header.size;
+        merkle->nr_leaves = header.nr_leaves;
+
+        merkle->leaves = GF_CALLOC (max (merkle->nr_leaves, 1),
+                                    SHA256_DIGEST_LENGTH,
+                                    gf_br_mt_merkle_leaves_t);
+        if (!merkle->leaves)
+                goto error_return;
+
+        len = (size_t)merkle->nr_leaves * SHA256_DIGEST_LENGTH;
+        if (sys_read (fd, merkle->leaves, len) != len)
+                goto wipe;
+
+        br_merkle_root (merkle);
+        if (memcmp (merkle->root, header.root, SHA256_DIGEST_LENGTH) != 0)
+                goto wipe;
+
+        sys_close (fd);
+        return 0;
+
+ wipe:
+        br_merkle_wipe (merkle);
+ error_return:
+        if (fd >= 0)
+                sys_close (fd);
+        return -1;
+}
+
+int32_t
+br_merkle_store (br_child_t *child, uuid_t gfid,
+                 unsigned long version, br_merkle_t *merkle)
+{
+        int                 fd      = -1;
+        int32_t             ret     = -1;
+        size_t              len     = 0;
+        xlator_t           *this    = NULL;
+        char                dir[PATH_MAX]     = {0,};
+        char                path[PATH_MAX]    = {0,};
+        char                tmppath[PATH_MAX] = {0,};
+        br_merkle_header_t  header  = {0,};
+
+        this = child->this;
+
+        br_merkle_path (child, gfid, path, sizeof (path));
+        (void) snprintf (tmppath, sizeof (tmppath), "%s.%lx",
+                         path, (unsigned long) pthread_self ());
+
+        fd = open (tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if ((fd < 0) && (errno == ENOENT)) {
+                (void) snprintf (dir, sizeof (dir), "%s/%s",
+                                 child->brick_path, BR_MERKLE_DIR);
+                if (sys_mkdir (dir, 0700) && (errno != EEXIST))
+                        goto out;
+                fd = open (tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        }
+        if (fd < 0)
+                goto out;
+
+        header.magic = BR_MERKLE_MAGIC;
+        header.blockshift = merkle->blockshift;
+        header.signedversion = version;
+        header.size = merkle->size;
+        header.nr_leaves = merkle->nr_leaves;
+        memcpy (header.root, merkle->root, SHA256_DIGEST_LENGTH);
+
+        len = (size_t)merkle->nr_leaves * SHA256_DIGEST_LENGTH;
+        if ((sys_write (fd, &header, sizeof (header)) != sizeof (header))
+            || (sys_write (fd, merkle->leaves, len) != len))
+                goto unlink;
+
+        if (sys_close (fd))
+                goto unlink;
+        fd = -1;
+
+        ret = sys_rename (tmppath, path);
+        if (ret == 0)
+                goto out;
+
+ unlink:
+        ret = -1;
+        if (fd >= 0)
+                sys_close (fd);
+        (void) sys_unlink (tmppath);
+ out:
+        if (ret)
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        BRB_MSG_MERKLE_LEAVES_FAILED, "failed to save merkle "
+                        "leaves of object %s", uuid_utoa (gfid));
+        return ret;
+}
+
+/**
+ * sign @object with a merkle root. if the stub tracked the modifications
+ * since the object was last signed and the leaves of that signing are
+ * around, only dirty blocks are read.
+ */
+static br_isignature_t *
+br_object_merkle_sign (xlator_t *this, br_object_t *object,
+                       fd_t *fd, struct iatt *iatt)
+{
+        int32_t                ret         = -1;
+        uint8_t                blockshift  = 0;
+        dict_t                *xattr       = NULL;
+        br_private_t          *priv        = NULL;
+        br_isignature_t       *sign        = NULL;
+        br_dirty_extents_t    *dirty       = NULL;
+        br_merkle_t            old         = {0,};
+        br_merkle_t            merkle      = {0,};
+        br_merkle_signature_t  msign       = {0,};
+        gf_boolean_t           incremental = _gf_false;
+
+        priv = this->private;
+
+        blockshift = br_merkle_blockshift (priv->signing_block_size,
+                                           iatt->ia_size);
+
+        ret = syncop_fgetxattr (object->child->xl, fd, &xattr,
+                                GLUSTERFS_GET_OBJECT_DIRTY_EXTENTS, NULL, NULL);
+        if (!ret)
+                ret = dict_get_bin (xattr, GLUSTERFS_GET_OBJECT_DIRTY_EXTENTS,
+                                    (void **)&dirty);
+        if (!ret && !br_merkle_load (object->child, fd->inode->gfid,
+                                     dirty->base, &old)) {
+                incremental = (old.blockshift == blockshift);
+        }
+
+        ret = br_merkle_compute (object->child, fd, iatt->ia_size, blockshift,
+                                 incremental ? &old : NULL, dirty, &merkle);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        BRB_MSG_CALC_CHECKSUM_FAILED, "calculating merkle "
+                        "tree for the object %s failed",
+                        uuid_utoa (fd->inode->gfid));
+                goto out;
+        }
+
+        gf_msg_debug (this->name, 0, "merkle signing object %s: %u leaves, "
+                      "%s", uuid_utoa (fd->inode->gfid), merkle.nr_leaves,
+                      incremental ? "incremental" : "full");
+
+        /**
+         * leaves go first: a signature is accepted only if the object did
+         * not change while it was read, so saved leaves of a rejected
+         * signature are never used (c.f. dirty extents' base version).
+         */
+        (void) br_merkle_store (object->child, fd->inode->gfid,
+                                ntohl (object->signedversion), &merkle);
+
+        msign.blockshift = blockshift;
+        memcpy (msign.root, merkle.root, SHA256_DIGEST_LENGTH);
+
+        sign = br_prepare_signature ((unsigned char *)&msign, sizeof (msign),
+                                     BR_SIGNATURE_TYPE_MERKLE, object);
+
+ out:
+        br_merkle_wipe (&merkle);
+        br_merkle_wipe (&old);
+        if (xattr)
+                dict_unref (xattr);
+        return sign;
+}
+
 static int32_t
 br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                      struct iatt *iatt)
 {
         int32_t          ret           = -1;
         xlator_t        *this          = NULL;
+        br_private_t    *priv          = NULL;
         dict_t          *xattr         = NULL;
         unsigned char   *md            = NULL;
         br_isignature_t *sign          = NULL;
@@ -394,6 +837,19 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
         GF_VALIDATE_OR_GOTO ("bit-rot", fd, out);
 
         this = object->this;
+        priv = this->private;
+
+        if (priv->signing_block_size) {
+                sign = br_object_merkle_sign (this, object, fd, iatt);
+                if (!sign) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                BRB_MSG_GET_SIGN_FAILED, "failed to get the "
+                                "signature for the object %s",
+                                uuid_utoa (fd->inode->gfid));
+                        goto out;
+                }
+                goto set_signature;
+        }
 
         md = GF_CALLOC (SHA256_DIGEST_LENGTH, sizeof (*md), gf_common_mt_char);
         if (!md) {
@@ -421,9 +877,11 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                 goto free_signature;
         }
 
+ set_signature:
+        ret = -1;
         xattr = dict_for_key_value
                 (GLUSTERFS_SET_OBJECT_SIGNATURE,
-                 (void *)sign, signature_size (SHA256_DIGEST_LENGTH));
+                 (void *)sign, signature_size (sign->signaturelen));
 
         if (!xattr) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_SET_SIGN_FAILED,
@@ -1808,12 +2266,19 @@ br_rate_limit_signer (xlator_t *this, int child_count, int numbricks)
 static int32_t
 br_signer_handle_options (xlator_t *this, br_private_t *priv, dict_t *options)
 {
-        if (options)
+        if (options) {
                 GF_OPTION_RECONF ("expiry-time", priv->expiry_time,
                                   options, uint32, error_return);
-        else
+                GF_OPTION_RECONF ("signing-block-size",
+                                  priv->signing_block_size, options,
+                                  size_uint64, error_return);
+        } else {
                 GF_OPTION_INIT ("expiry-time", priv->expiry_time,
                                 uint32, error_return);
+                GF_OPTION_INIT ("signing-block-size",
+                                priv->signing_block_size, size_uint64,
+                                error_return);
+        }
 
         return 0;
 
@@ -2117,6 +2582,17 @@ struct volume_options options[] = {
           .description = "Waiting time for an object on which it waits "
                          "before it is signed",
         },
+        { .key = {"signing-block-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "0",
+          .min = 0,
+          .max = 64 * GF_UNIT_MB,
+          .description = "Sign objects with a merkle tree over blocks of "
+                         "this size (rounded up to a power of two, 4KB at "
+                         "least) so that re-signing a modified object reads "
+                         "only the blocks that changed. 0 signs whole "
+                         "objects with SHA256.",
+        },
         { .key = {"brick-count"},
           .type = GF_OPTION_TYPE_STR,
           .description = "Total number of bricks for the current node for "
@@ -2138,6 +2614,12 @@ struct volume_options options[] = {
           .default_value = "biweekly",
           .description = "Scrub frequency for volume <VOLNAME>",
         },
+        { .key = {"scrub-rate"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "0",
+          .description = "Maximum number of bytes per second the scrubber "
+                         "checksums for volume <VOLNAME>, 0 for no limit",
+        },
         { .key = {"scrub-state"},
           .type = GF_OPTION_TYPE_STR,
           .default_value = "active",
@@ -36,6 +36,15 @@
  */
 #define BR_WORKERS 4
 
+#define BR_SCRUB_READ_SIZE  (1024 * 1024)
+
+/**
+ * merkle signing: block size is at least 4KB and is raised for large
+ * objects to keep the number of leaves (and the sidecar) bounded.
+ */
+#define BR_MERKLE_MIN_BLOCKSHIFT  12
+#define BR_MERKLE_MAX_LEAVES      (1 << 16)
+
 typedef enum scrub_throttle {
         BR_SCRUB_THROTTLE_VOID       = -1,
         BR_SCRUB_THROTTLE_LAZY       = 0,
@@ -62,7 +71,8 @@ struct br_scanfs {
         pthread_mutex_t waitlock;
         pthread_cond_t  waitcond;
 
-        unsigned int     entries;
+        unsigned int     entries;    /* entries not yet scrubbed */
+        unsigned int     nr_queued;  /* entries not yet handed off */
         struct list_head queued;
         struct list_head ready;
 };
@@ -138,6 +148,8 @@ struct br_scrubber {
         unsigned int nr_scrubbers;
         struct list_head scrubbers;
 
+        uint64_t rate;            /* bytes/sec checksummed, 0 for no limit */
+
         /**
          * list of "rotatable" subvolume(s) undergoing scrubbing
          */
@@ -209,6 +221,9 @@ struct br_private {
 
         uint32_t expiry_time;              /* objects "wait" time */
 
+        uint64_t signing_block_size;       /* merkle block size, 0 signs
+                                              with a plain SHA256 */
+
         tbf_t *tbf;                    /* token bucket filter */
 
         gf_boolean_t iamscrubber;         /* function as a fs scrubber */
@@ -237,6 +252,17 @@ struct br_object {
 };
 
 typedef struct br_object br_object_t;
+
+/* in-memory merkle tree of an object: block hashes and their root */
+struct br_merkle {
+        uint8_t        blockshift;
+        uint64_t       size;
+        uint32_t       nr_leaves;
+        unsigned char *leaves;          /* nr_leaves SHA256 hashes */
+        unsigned char  root[SHA256_DIGEST_LENGTH];
+};
+
+typedef struct br_merkle br_merkle_t;
 typedef int32_t (br_scrub_ssm_call) (xlator_t *);
 
 void
@@ -249,6 +275,22 @@ int32_t
 br_calculate_obj_checksum (unsigned char *,
                            br_child_t *, fd_t *, struct iatt *);
 
+uint8_t
+br_merkle_blockshift (uint64_t, uint64_t);
+
+int32_t
+br_merkle_compute (br_child_t *, fd_t *, uint64_t, uint8_t,
+                   br_merkle_t *, br_dirty_extents_t *, br_merkle_t *);
+
+int32_t
+br_merkle_load (br_child_t *, uuid_t, unsigned long, br_merkle_t *);
+
+int32_t
+br_merkle_store (br_child_t *, uuid_t, unsigned long, br_merkle_t *);
+
+void
+br_merkle_wipe (br_merkle_t *);
+
 int32_t
 br_prepare_loc (xlator_t *, br_child_t *, loc_t *, gf_dirent_t *, loc_t *);
 
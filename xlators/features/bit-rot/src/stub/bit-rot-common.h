@@ -121,9 +121,49 @@ typedef enum {
         BR_SIGNATURE_TYPE_VOID   = -1,   /* object is not signed       */
         BR_SIGNATURE_TYPE_ZERO   = 0,    /* min boundary               */
         BR_SIGNATURE_TYPE_SHA256 = 1,    /* signed with SHA256         */
-        BR_SIGNATURE_TYPE_MAX    = 2,    /* max boundary               */
+        BR_SIGNATURE_TYPE_MERKLE = 2,    /* SHA256 merkle root         */
+        BR_SIGNATURE_TYPE_MAX    = 3,    /* max boundary               */
 } br_signature_type;
 
+/**
+ * signature of an object signed with BR_SIGNATURE_TYPE_MERKLE: the root
+ * over the SHA256 hashes of fixed size blocks of the object. the block
+ * hashes (leaves) are kept in a sidecar file under BR_MERKLE_DIR so that
+ * the signer need not read blocks that did not change, c.f. on-disk
+ * format in bit-rot-object-version.h.
+ */
+#define BR_MERKLE_ROOT_LEN  32           /* SHA256_DIGEST_LENGTH */
+#define BR_MERKLE_DIR       GF_HIDDEN_PATH"/merkle"
+
+typedef struct __attribute__ ((__packed__)) br_merkle_signature {
+        uint8_t blockshift;              /* log2 (block size)         */
+        unsigned char root[BR_MERKLE_ROOT_LEN];
+} br_merkle_signature_t;
+
+/**
+ * byte ranges of an object modified since it was last signed, maintained
+ * by the stub (virtual xattr). @base is the signed version the extents
+ * are relative to. an extent ending at BR_DIRTY_EXTENT_EOF covers all of
+ * the object past its start (truncate). when there are more disjoint
+ * ranges than BR_DIRTY_EXTENTS_MAX, the closest ones are merged.
+ */
+#define GLUSTERFS_GET_OBJECT_DIRTY_EXTENTS              \
+        "trusted.glusterfs.bit-rot.dirty-extents"
+
+#define BR_DIRTY_EXTENTS_MAX 8
+#define BR_DIRTY_EXTENT_EOF  UINT64_MAX
+
+typedef struct br_dirty_extent {
+        uint64_t start;
+        uint64_t end;                    /* exclusive                 */
+} br_dirty_extent_t;
+
+typedef struct br_dirty_extents {
+        unsigned long base;
+        uint32_t count;
+        br_dirty_extent_t extent[BR_DIRTY_EXTENTS_MAX];
+} br_dirty_extents_t;
+
 /* BitRot stub start time (virtual xattr) */
 #define GLUSTERFS_GET_BR_STUB_INIT_TIME  "trusted.glusterfs.bit-rot.stub-init"
 
@@ -27,4 +27,22 @@ typedef struct __attribute__ ((__packed__)) br_signature {
         char signature[0];
 } br_signature_t;
 
+/**
+ * sidecar file holding the leaves of a merkle signed object, named after
+ * the object's gfid under BR_MERKLE_DIR. the header is followed by
+ * @nr_leaves block hashes.
+ */
+#define BR_MERKLE_MAGIC 0x6272746d
+
+typedef struct __attribute__ ((__packed__)) br_merkle_header {
+        uint32_t magic;
+        uint8_t blockshift;
+
+        unsigned long signedversion;     /* version the leaves hash   */
+        uint64_t size;                   /* object size               */
+        uint32_t nr_leaves;
+
+        unsigned char root[32];
+} br_merkle_header_t;
+
 #endif
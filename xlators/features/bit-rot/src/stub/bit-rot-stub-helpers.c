@@ -223,6 +223,33 @@ out:
         return ret;
 }
 
+/**
+ * remove the merkle leaves (if any) of an object that is gone. the signer
+ * creates these only for objects signed with BR_SIGNATURE_TYPE_MERKLE.
+ */
+int
+br_stub_merkle_del (xlator_t *this, uuid_t gfid)
+{
+        br_stub_private_t *priv = NULL;
+        int          ret = 0;
+        char         merkle_path[PATH_MAX] = {0};
+
+        priv = this->private;
+
+        (void) snprintf (merkle_path, sizeof (merkle_path), "%s/%s/%s",
+                         priv->export, BR_MERKLE_DIR, uuid_utoa (gfid));
+        ret = sys_unlink (merkle_path);
+        if (ret && (errno != ENOENT)) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        BRS_MSG_MERKLE_UNLINK_FAIL,
+                        "%s: failed to delete merkle leaves of object",
+                        merkle_path);
+                return -errno;
+        }
+
+        return 0;
+}
+
 static int
 br_stub_check_stub_directory (xlator_t *this, char *fullpath)
 {
@@ -28,6 +28,8 @@ enum br_mem_types {
         gf_br_stub_mt_br_scanner_freq_t,
         gf_br_stub_mt_sigstub_t,
         gf_br_mt_br_child_event_t,
+        gf_br_stub_mt_dirty_extents_t,
+        gf_br_mt_merkle_leaves_t,
         gf_br_stub_mt_end,
 };
 
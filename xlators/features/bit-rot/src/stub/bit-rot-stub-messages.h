@@ -40,7 +40,7 @@
  */
 
 #define GLFS_BITROT_STUB_BASE                   GLFS_MSGID_COMP_BITROT_STUB
-#define GLFS_BITROT_STUB_NUM_MESSAGES           31
+#define GLFS_BITROT_STUB_NUM_MESSAGES           32
 #define GLFS_MSGID_END         (GLFS_BITROT_STUB_BASE + \
                                 GLFS_BITROT_STUB_NUM_MESSAGES + 1)
 /* Messaged with message IDs */
@@ -259,6 +259,13 @@
  *
  */
 #define BRS_MSG_BAD_OBJ_UNLINK_FAIL        (GLFS_BITROT_STUB_BASE + 31)
+/*!
+ * @messageid
+ * @diagnosis
+ * @recommendedaction
+ *
+ */
+#define BRS_MSG_MERKLE_UNLINK_FAIL         (GLFS_BITROT_STUB_BASE + 32)
 /*!
  * @messageid
  * @diagnosis
@@ -322,12 +322,14 @@ br_stub_prepare_signing_request (dict_t *dict,
  * initialize an inode context starting with a given ongoing version.
  * a fresh lookup() or a first creat() call initializes the inode
  * context, hence the inode is marked dirty. this routine also
- * initializes the transient inode version.
+ * initializes the transient inode version. @issigned tells that the
+ * object is signed with the ongoing version, in which case modifications
+ * from here on are tracked as dirty extents.
  */
 static int
 br_stub_init_inode_versions (xlator_t *this, fd_t *fd, inode_t *inode,
                              unsigned long version, gf_boolean_t markdirty,
-                             gf_boolean_t bad_object)
+                             gf_boolean_t bad_object, gf_boolean_t issigned)
 {
         int32_t ret = 0;
         br_stub_inode_ctx_t *ctx = NULL;
@@ -345,6 +347,9 @@ br_stub_init_inode_versions (xlator_t *this, fd_t *fd, inode_t *inode,
         if (bad_object)
                 __br_stub_mark_object_bad (ctx);
 
+        if (issigned)
+                __br_stub_reset_dirty_extents (ctx, version);
+
         if (fd) {
                 ret = br_stub_add_fd_to_inode (this, fd, ctx);
                 if (ret)
@@ -390,6 +395,89 @@ unblock:
         return ret;
 }
 
+/**
+ * add [@start, @end) to the dirty extents of an object, merging it with
+ * the extents it overlaps or touches. extents are kept sorted; if a new
+ * disjoint extent does not fit, the two extents with the smallest gap in
+ * between are merged (the signer then rehashes a bit more than needed).
+ */
+static void
+__br_stub_add_dirty_extent (br_stub_inode_ctx_t *ctx,
+                            uint64_t start, uint64_t end)
+{
+        uint32_t            i      = 0;
+        uint32_t            j      = 0;
+        uint32_t            n      = 0;
+        uint32_t            min    = 0;
+        uint64_t            mingap = BR_DIRTY_EXTENT_EOF;
+        br_dirty_extents_t *dirty  = &ctx->dirty;
+        br_dirty_extent_t   ext[BR_DIRTY_EXTENTS_MAX + 1];
+
+        if (!ctx->dirty_valid || (start >= end))
+                return;
+
+        for (i = 0; i < dirty->count; i++) {
+                if (dirty->extent[i].end >= start)
+                        break;
+        }
+
+        for (j = i; j < dirty->count; j++) {
+                if (dirty->extent[j].start > end)
+                        break;
+                start = min (start, dirty->extent[j].start);
+                end = max (end, dirty->extent[j].end);
+        }
+
+        memcpy (ext, dirty->extent, i * sizeof (br_dirty_extent_t));
+        ext[i].start = start;
+        ext[i].end = end;
+        memcpy (&ext[i + 1], &dirty->extent[j],
+                (dirty->count - j) * sizeof (br_dirty_extent_t));
+        n = i + 1 + dirty->count - j;
+
+        if (n > BR_DIRTY_EXTENTS_MAX) {
+                for (i = 0; i < (n - 1); i++) {
+                        if ((ext[i + 1].start - ext[i].end) < mingap) {
+                                mingap = ext[i + 1].start - ext[i].end;
+                                min = i;
+                        }
+                }
+
+                ext[min].end = ext[min + 1].end;
+                memmove (&ext[min + 1], &ext[min + 2],
+                         (n - min - 2) * sizeof (br_dirty_extent_t));
+                n--;
+        }
+
+        memcpy (dirty->extent, ext, n * sizeof (br_dirty_extent_t));
+        dirty->count = n;
+}
+
+/**
+ * modifications are marked dirty when wound, i.e. after the versioning
+ * for the modification is done. a signature for the version before the
+ * modification is thereby never accepted (c.f. compare_sign_version())
+ * after the extent is marked.
+ */
+static void
+br_stub_mark_dirty_extent (xlator_t *this,
+                           inode_t *inode, uint64_t start, uint64_t end)
+{
+        int32_t              ret      = -1;
+        uint64_t             ctx_addr = 0;
+        br_stub_inode_ctx_t *ctx      = NULL;
+
+        LOCK (&inode->lock);
+        {
+                ret = __br_stub_get_inode_ctx (this, inode, &ctx_addr);
+                if (ret == 0) {
+                        ctx = (br_stub_inode_ctx_t *)(long)ctx_addr;
+                        __br_stub_add_dirty_extent (ctx, start, end);
+                }
+        }
+        UNLOCK (&inode->lock);
+}
+
 static void
 br_stub_fill_local (br_stub_local_t *local,
                     call_stub_t *stub, fd_t *fd, inode_t *inode, uuid_t gfid,
@@ -833,6 +921,14 @@ br_stub_compare_sign_version (xlator_t *this,
                                       "(%lu)", ctx->currentversion,
                                       sbuf->signedversion);
                         *fakesuccess = 1;
+                } else {
+                        /**
+                         * the object is going to be signed with its
+                         * current version: modifications from here on
+                         * are relative to this signature.
+                         */
+                        __br_stub_reset_dirty_extents
+                                (ctx, sbuf->signedversion);
                 }
         }
         UNLOCK (&inode->lock);
@@ -1583,6 +1679,62 @@ br_stub_send_stub_init_time (call_frame_t *frame, xlator_t *this)
                 dict_unref (xattr);
 }
 
+static void
+br_stub_send_dirty_extents (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        int32_t              op_ret   = -1;
+        int32_t              op_errno = 0;
+        uint64_t             ctx_addr = 0;
+        dict_t              *xattr    = NULL;
+        br_stub_inode_ctx_t *ctx      = NULL;
+        br_dirty_extents_t  *dirty    = NULL;
+
+        op_errno = EINVAL;
+        if (br_stub_get_inode_ctx (this, fd->inode, &ctx_addr))
+                goto unwind;
+        ctx = (br_stub_inode_ctx_t *)(long)ctx_addr;
+
+        op_errno = ENOMEM;
+        dirty = GF_CALLOC (1, sizeof (*dirty), gf_br_stub_mt_dirty_extents_t);
+        if (!dirty)
+                goto unwind;
+
+        LOCK (&fd->inode->lock);
+        {
+                if (ctx->dirty_valid) {
+                        *dirty = ctx->dirty;
+                        op_ret = 0;
+                }
+        }
+        UNLOCK (&fd->inode->lock);
+
+        op_errno = ENODATA;
+        if (op_ret)
+                goto unwind;
+
+        op_ret = -1;
+        op_errno = ENOMEM;
+        xattr = dict_new ();
+        if (!xattr)
+                goto unwind;
+
+        op_errno = EINVAL;
+        if (dict_set_bin (xattr, GLUSTERFS_GET_OBJECT_DIRTY_EXTENTS,
+                          (void *)dirty, sizeof (*dirty)) < 0)
+                goto unwind;
+        dirty = NULL;
+
+        op_ret = sizeof (br_dirty_extents_t);
+        op_errno = 0;
+
+ unwind:
+        STACK_UNWIND (frame, op_ret, op_errno, xattr, NULL);
+
+        GF_FREE (dirty);
+        if (xattr)
+                dict_unref (xattr);
+}
+
 int
 br_stub_getxattr (call_frame_t *frame, xlator_t *this,
                   loc_t *loc, const char *name, dict_t *xdata)
@@ -1707,6 +1859,11 @@ br_stub_fgetxattr (call_frame_t *frame, xlator_t *this,
         if (!IA_ISREG (fd->inode->ia_type))
                 goto wind;
 
+        if (name && (strcmp (name, GLUSTERFS_GET_OBJECT_DIRTY_EXTENTS) == 0)) {
+                br_stub_send_dirty_extents (frame, this, fd);
+                return 0;
+        }
+
         if (name && (strncmp (name, GLUSTERFS_GET_OBJECT_SIGNATURE,
                               strlen (GLUSTERFS_GET_OBJECT_SIGNATURE)) == 0)) {
                 cookie = (void *) BR_STUB_REQUEST_COOKIE;
@@ -1804,6 +1961,9 @@ br_stub_writev_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
                        struct iovec *vector, int32_t count, off_t offset,
                        uint32_t flags, struct iobref *iobref, dict_t *xdata)
 {
+        br_stub_mark_dirty_extent (this, fd->inode, offset,
+                                   offset + iov_length (vector, count));
+
         STACK_WIND (frame, br_stub_writev_cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->writev, fd, vector, count,
                     offset, flags, iobref, xdata);
@@ -1887,6 +2047,9 @@ br_stub_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         return br_stub_perform_incversioning (this, frame, stub, fd, ctx);
 
  wind:
+        br_stub_mark_dirty_extent (this, fd->inode, offset,
+                                   offset + iov_length (vector, count));
+
         STACK_WIND (frame, cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->writev,
                     fd, vector, count, offset, flags, iobref, xdata);
@@ -1938,6 +2101,9 @@ int32_t
 br_stub_ftruncate_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
                           off_t offset, dict_t *xdata)
 {
+        br_stub_mark_dirty_extent (this, fd->inode,
+                                   offset, BR_DIRTY_EXTENT_EOF);
+
         STACK_WIND (frame, br_stub_ftruncate_cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
         return 0;
@@ -1997,6 +2163,9 @@ br_stub_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd,
         return br_stub_perform_incversioning (this, frame, stub, fd, ctx);
 
  wind:
+        br_stub_mark_dirty_extent (this, fd->inode,
+                                   offset, BR_DIRTY_EXTENT_EOF);
+
         STACK_WIND (frame, cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
         return 0;
@@ -2047,6 +2216,9 @@ br_stub_truncate_resume (call_frame_t *frame, xlator_t *this, loc_t *loc,
 {
         br_stub_local_t *local = frame->local;
 
+        br_stub_mark_dirty_extent (this, loc->inode,
+                                   offset, BR_DIRTY_EXTENT_EOF);
+
         fd_unref (local->u.context.fd);
         STACK_WIND (frame, br_stub_ftruncate_cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
@@ -2131,6 +2303,9 @@ br_stub_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
         return br_stub_perform_incversioning (this, frame, stub, fd, ctx);
 
  wind:
+        br_stub_mark_dirty_extent (this, loc->inode,
+                                   offset, BR_DIRTY_EXTENT_EOF);
+
         STACK_WIND (frame, cbk, FIRST_CHILD(this),
                     FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
         fd_unref (fd);
@@ -2279,7 +2454,8 @@ br_stub_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         ret = br_stub_get_inode_ctx (this, fd->inode, &ctx_addr);
         if (ret < 0) {
                 ret = br_stub_init_inode_versions (this, fd, inode, version,
-                                                   _gf_true, _gf_false);
+                                                   _gf_true, _gf_false,
+                                                   _gf_false);
                 if (ret) {
                         op_ret = -1;
                         op_errno = EINVAL;
@@ -2329,7 +2505,7 @@ br_stub_mknod_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto unwind;
 
         ret = br_stub_init_inode_versions (this, NULL, inode, version,
-                                           _gf_true, _gf_false);
+                                           _gf_true, _gf_false, _gf_false);
         /**
          * Like lookup, if init_inode_versions fail, return EINVAL
          */
@@ -2419,8 +2595,10 @@ br_stub_lookup_version (xlator_t *this,
         if (status == BR_VXATTR_STATUS_INVALID)
                 return -1;
 
-        return br_stub_init_inode_versions (this, NULL, inode, version,
-                                            _gf_true, bad_object);
+        return br_stub_init_inode_versions
+                        (this, NULL, inode, version, _gf_true, bad_object,
+                         (status == BR_VXATTR_STATUS_FULL)
+                         && (obuf->ongoingversion == sbuf->signedversion));
 }
 
 
@@ -2853,6 +3031,7 @@ br_stub_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         uint64_t             ctx_addr = 0;
         br_stub_inode_ctx_t *ctx      = NULL;
         int32_t              ret      = -1;
+        uint32_t             nlink    = 0;
 
         local = frame->local;
         frame->local = NULL;
@@ -2864,6 +3043,11 @@ br_stub_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if (!IA_ISREG (inode->ia_type))
            goto unwind;
 
+        /* link count before the unlink, gfid handle included */
+        if (xdata && !dict_get_uint32 (xdata, GF_RESPONSE_LINK_COUNT_XDATA,
+                                       &nlink) && (nlink == 1))
+                (void) br_stub_merkle_del (this, inode->gfid);
+
         ret = br_stub_get_inode_ctx (this, inode, &ctx_addr);
         if (ret) {
                 /**
@@ -2912,6 +3096,27 @@ br_stub_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int flag,
         br_stub_local_t *local = NULL;
         int32_t          op_ret = -1;
         int32_t          op_errno = 0;
+        int32_t          ret = 0;
+
+        /* to know when the merkle leaves of the object can go */
+        if (IA_ISREG (loc->inode->ia_type)) {
+                if (xdata)
+                        xdata = dict_ref (xdata);
+                else
+                        xdata = dict_new ();
+                if (!xdata) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = dict_set_int32 (xdata, GF_REQUEST_LINK_COUNT_XDATA, 1);
+                if (ret) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+        } else if (xdata) {
+                xdata = dict_ref (xdata);
+        }
 
         local = br_stub_alloc_local (this);
         if (!local) {
@@ -2931,9 +3136,14 @@ br_stub_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int flag,
 
         STACK_WIND (frame, br_stub_unlink_cbk, FIRST_CHILD (this),
                     FIRST_CHILD (this)->fops->unlink, loc, flag, xdata);
+
+        if (xdata)
+                dict_unref (xdata);
         return 0;
 
 unwind:
+        if (xdata)
+                dict_unref (xdata);
         STACK_UNWIND_STRICT (unlink, frame, op_ret, op_errno, NULL, NULL, NULL);
         return 0;
 }
@@ -36,6 +36,10 @@ typedef struct br_stub_inode_ctx {
         struct list_head fd_list; /* list of open fds or fds participating in
                                      write operations */
         gf_boolean_t bad_object;
+
+        gf_boolean_t dirty_valid;        /* are writes since the last
+                                            signing all in ->dirty? */
+        br_dirty_extents_t dirty;
 } br_stub_inode_ctx_t;
 
 typedef struct br_stub_fd {
@@ -125,6 +129,19 @@ __br_stub_mark_object_bad (br_stub_inode_ctx_t *ctx)
         ctx->bad_object = _gf_true;
 }
 
+/**
+ * dirty extents are tracked only from a point where the object is known
+ * to be signed, i.e. its on-disk ongoing version matches the signed
+ * version, or its signature was just accepted.
+ */
+static inline void
+__br_stub_reset_dirty_extents (br_stub_inode_ctx_t *ctx, unsigned long base)
+{
+        ctx->dirty_valid = _gf_true;
+        ctx->dirty.base = base;
+        ctx->dirty.count = 0;
+}
+
 /* inode writeback helpers */
 static inline void
 __br_stub_mark_inode_dirty (br_stub_inode_ctx_t *ctx)
@@ -460,4 +477,7 @@ br_stub_readdir_wrapper (call_frame_t *frame, xlator_t *this,
 int
 br_stub_del (xlator_t *this, uuid_t gfid);
 
+int
+br_stub_merkle_del (xlator_t *this, uuid_t gfid);
+
 #endif /* __BIT_ROT_STUB_H__ */
@@ -15,6 +15,7 @@
 
 #include "gf-changelog-helpers.h"
 #include "gf-changelog-journal.h"
+#include "changelog-misc.h"
 #include "changelog-mem-types.h"
 #include "changelog-lib-messages.h"
 
@@ -222,3 +223,137 @@ gf_changelog_scan ()
  out:
         return -1;
 }
+
+/* open @path if it is a changelog in the indexed encoding */
+static int
+gf_changelog_open_indexed (char *path, size_t *hlen, struct stat *stbuf)
+{
+        int    fd       = -1;
+        int    encoding = -1;
+        int    major    = -1;
+        int    minor    = -1;
+        size_t elen     = 0;
+        char buffer[1024] = {0,};
+
+        fd = open (path, O_RDONLY);
+        if (fd < 0)
+                return -1;
+
+        CHANGELOG_GET_HEADER_INFO (fd, buffer, 1024, encoding,
+                                   major, minor, elen);
+        if ((encoding != CHANGELOG_ENCODE_INDEXED) || sys_fstat (fd, stbuf)) {
+                sys_close (fd);
+                errno = EINVAL;
+                return -1;
+        }
+
+        *hlen = elen;
+        return fd;
+}
+
+/**
+ * @API
+ *  map a changelog in the indexed encoding to read its records in place.
+ *  @file is either a changelog of the brick or one handed out by
+ *  gf_changelog_next_change (), the brick's changelog it was processed
+ *  from is mapped then.
+ */
+gf_changelog_map_t *
+gf_changelog_map (char *file)
+{
+        int                     fd    = -1;
+        size_t                  hlen  = 0;
+        xlator_t               *this  = NULL;
+        gf_changelog_map_t     *map   = NULL;
+        gf_changelog_journal_t *jnl   = NULL;
+        struct stat             stbuf = {0,};
+        char path[PATH_MAX]           = {0,};
+
+        errno = EINVAL;
+
+        this = THIS;
+        if (!this || !file)
+                goto out;
+
+        fd = gf_changelog_open_indexed (file, &hlen, &stbuf);
+        if (fd < 0) {
+                jnl = (gf_changelog_journal_t *)
+                        GF_CHANGELOG_GET_API_PTR (this);
+                if (!jnl)
+                        goto out;
+
+                (void) snprintf (path, PATH_MAX, "%s/%s/%s",
+                                 jnl->jnl_brickpath, GF_CHANGELOG_JOURNAL_DIR,
+                                 basename (file));
+                fd = gf_changelog_open_indexed (path, &hlen, &stbuf);
+                if (fd < 0)
+                        goto out;
+        }
+
+        map = GF_CALLOC (1, sizeof (*map),
+                         gf_changelog_mt_libgfchangelog_map_t);
+        if (!map)
+                goto close_fd;
+
+        if (gf_changelog_map_fd (this, map, fd, hlen, stbuf.st_size)) {
+                GF_FREE (map);
+                map = NULL;
+                errno = EIO;
+        }
+
+ close_fd:
+        sys_close (fd);
+ out:
+        return map;
+}
+
+/**
+ * @API
+ *  number of records of a mapped changelog
+ */
+ssize_t
+gf_changelog_map_count (gf_changelog_map_t *map)
+{
+        if (!map) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        return map->count;
+}
+
+/**
+ * @API
+ *  fill @rec with the @index'th record of a mapped changelog, pointing in
+ *  the mapping. Records can be read in any order, by any number of threads.
+ */
+int
+gf_changelog_map_record (gf_changelog_map_t *map, size_t index,
+                         gf_changelog_record_t *rec)
+{
+        if (!map || !rec || (index >= map->count)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        if (gf_changelog_map_decode (map, map->index[index], rec) < 0) {
+                errno = EIO;
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * @API
+ *  unmap a changelog, its records are not to be referred to anymore.
+ */
+void
+gf_changelog_unmap (gf_changelog_map_t *map)
+{
+        if (!map)
+                return;
+
+        gf_changelog_map_release (map);
+        GF_FREE (map);
+}
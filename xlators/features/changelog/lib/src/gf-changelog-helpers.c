@@ -8,7 +8,10 @@
    cases as published by the Free Software Foundation.
 */
 
+#include <sys/mman.h>
+
 #include "changelog-mem-types.h"
+#include "changelog-misc.h"
 #include "gf-changelog-helpers.h"
 #include "changelog-lib-messages.h"
 #include "syscall.h"
@@ -217,3 +220,226 @@ gf_thread_cleanup (xlator_t *this, pthread_t thread)
  error_return:
         return -1;
 }
+
+/**
+ * decode the record at @off of a mapped indexed changelog: @rec points in
+ * the mapping, nothing is copied but the fixed size header. Returns the
+ * length of the record, -1 if it is not a valid record.
+ */
+ssize_t
+gf_changelog_map_decode (struct gf_changelog_map *map, uint64_t off,
+                         gf_changelog_record_t *rec)
+{
+        int                         i   = 0;
+        uint64_t                    pos = 0;
+        uint64_t                    end = 0;
+        struct changelog_rec_hdr    hdr = {0,};
+        struct changelog_rec_entry  cre = {{0,},};
+
+        if ((off < map->end) && (map->end - off >= sizeof (hdr)))
+                memcpy (&hdr, map->start + off, sizeof (hdr));
+
+        if ((hdr.crh_len < sizeof (hdr))
+            || (hdr.crh_len % CHANGELOG_REC_ALIGN)
+            || (hdr.crh_len > map->end - off)
+            || (hdr.crh_nr_entries > GF_CHANGELOG_MAX_ENTRIES)
+            || (hdr.crh_nr_uint32 > GF_CHANGELOG_MAX_UINT32))
+                return -1;
+
+        switch (hdr.crh_type) {
+        case 'D':
+        case 'M':
+        case 'E':
+                break;
+        default:
+                return -1;
+        }
+
+        rec->type = hdr.crh_type;
+        rec->fop = hdr.crh_fop;
+        rec->gfid = (unsigned char *) map->start + off
+                         + offsetof (struct changelog_rec_hdr, crh_gfid);
+
+        rec->nr_uint32 = hdr.crh_nr_uint32;
+        for (i = 0; i < hdr.crh_nr_uint32; i++)
+                rec->uint32[i] = hdr.crh_uint32[i];
+
+        pos = off + sizeof (hdr);
+        end = off + hdr.crh_len;
+
+        rec->nr_entries = hdr.crh_nr_entries;
+        for (i = 0; i < hdr.crh_nr_entries; i++) {
+                if (end - pos < sizeof (cre))
+                        return -1;
+                memcpy (&cre, map->start + pos, sizeof (cre));
+                rec->entries[i].pargfid = (unsigned char *) map->start + pos;
+                pos += sizeof (cre);
+
+                if (end - pos < cre.cre_bname_len + cre.cre_path_len + 2)
+                        return -1;
+
+                rec->entries[i].bname = map->start + pos;
+                pos += cre.cre_bname_len + 1;
+                rec->entries[i].path = map->start + pos;
+                pos += cre.cre_path_len + 1;
+
+                if ((rec->entries[i].bname[cre.cre_bname_len] != '\0')
+                    || (rec->entries[i].path[cre.cre_path_len] != '\0'))
+                        return -1;
+        }
+
+        return hdr.crh_len;
+}
+
+/* the index appended on rollover, if it covers the records exactly */
+static int
+gf_changelog_map_index (struct gf_changelog_map *map, size_t hlen)
+{
+        uint64_t                        i       = 0;
+        ssize_t                         len     = 0;
+        gf_changelog_record_t           rec     = {0,};
+        struct changelog_index_trailer  trailer = {0,};
+
+        if (map->size < hlen + sizeof (trailer))
+                return -1;
+
+        memcpy (&trailer, map->start + map->size - sizeof (trailer),
+                sizeof (trailer));
+
+        /* bounded one by one, so that no sum of a corrupt offset and
+         * count can wrap around */
+        if ((trailer.cit_magic != CHANGELOG_INDEX_MAGIC)
+            || (trailer.cit_count == 0)
+            || (trailer.cit_offset < hlen)
+            || (trailer.cit_offset > map->size - sizeof (trailer))
+            || (trailer.cit_count != (map->size - sizeof (trailer)
+                                      - trailer.cit_offset)
+                                     / sizeof (uint64_t))
+            || ((map->size - sizeof (trailer) - trailer.cit_offset)
+                % sizeof (uint64_t)))
+                return -1;
+
+        map->index = GF_MALLOC (trailer.cit_count * sizeof (uint64_t),
+                                gf_changelog_mt_journal_index_t);
+        if (!map->index)
+                return -1;
+
+        memcpy (map->index, map->start + trailer.cit_offset,
+                trailer.cit_count * sizeof (uint64_t));
+
+        map->end = trailer.cit_offset;
+        map->count = trailer.cit_count;
+
+        if (map->index[0] != hlen)
+                goto err;
+
+        for (i = 1; i < map->count; i++) {
+                if (map->index[i] <= map->index[i - 1])
+                        goto err;
+        }
+
+        len = gf_changelog_map_decode (map, map->index[map->count - 1], &rec);
+        if ((len < 0) || (map->index[map->count - 1] + len != map->end))
+                goto err;
+
+        return 0;
+
+ err:
+        GF_FREE (map->index);
+        map->index = NULL;
+        map->count = 0;
+        return -1;
+}
+
+/* no usable index (the changelog is still written to, or its index could
+ * not be kept): find the records walking them */
+static int
+gf_changelog_map_walk (struct gf_changelog_map *map, size_t hlen)
+{
+        uint64_t               off   = hlen;
+        uint64_t               size  = 0;
+        uint64_t              *index = NULL;
+        ssize_t                len   = 0;
+        gf_changelog_record_t  rec   = {0,};
+
+        map->end = map->size;
+
+        while (off < map->end) {
+                len = gf_changelog_map_decode (map, off, &rec);
+                if (len < 0)
+                        return -1;
+
+                if (map->count == size) {
+                        size = size ? (size * 2) : 1024;
+                        if (map->index)
+                                index = GF_REALLOC (map->index,
+                                                    size * sizeof (*index));
+                        else
+                                index = GF_MALLOC (size * sizeof (*index),
+                                               gf_changelog_mt_journal_index_t);
+                        if (!index)
+                                return -1;
+                        map->index = index;
+                }
+
+                map->index[map->count++] = off;
+                off += len;
+        }
+
+        return 0;
+}
+
+/**
+ * map the changelog open at @fd, of @size bytes with a @hlen bytes header,
+ * and locate its records.
+ */
+int
+gf_changelog_map_fd (xlator_t *this, struct gf_changelog_map *map,
+                     int fd, size_t hlen, size_t size)
+{
+        int ret = -1;
+
+        map->size = size;
+        if (size <= hlen)
+                return 0;
+
+        map->start = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map->start == MAP_FAILED) {
+                map->start = NULL;
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        CHANGELOG_LIB_MSG_MMAP_FAILED,
+                        "mmap() error");
+                goto out;
+        }
+
+        if (gf_changelog_map_index (map, hlen) == 0) {
+                ret = 0;
+                goto out;
+        }
+
+        ret = gf_changelog_map_walk (map, hlen);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        CHANGELOG_LIB_MSG_PARSE_ERROR,
+                        "invalid record after %"PRIu64" records of "
+                        "indexed changelog", map->count);
+                gf_changelog_map_release (map);
+        }
+
+ out:
+        return ret;
+}
+
+void
+gf_changelog_map_release (struct gf_changelog_map *map)
+{
+        if (map->start && munmap (map->start, map->size))
+                gf_msg (THIS->name, GF_LOG_ERROR, errno,
+                        CHANGELOG_LIB_MSG_MUNMAP_FAILED,
+                        "munmap() error");
+
+        GF_FREE (map->index);
+        map->start = NULL;
+        map->index = NULL;
+        map->count = 0;
+}
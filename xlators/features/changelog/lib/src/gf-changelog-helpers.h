@@ -29,6 +29,7 @@
 #define GF_CHANGELOG_PROCESSED_DIR  ".processed"
 #define GF_CHANGELOG_PROCESSING_DIR ".processing"
 #define GF_CHANGELOG_HISTORY_DIR    ".history"
+#define GF_CHANGELOG_JOURNAL_DIR    ".glusterfs/changelogs"
 #define TIMESTAMP_LENGTH 10
 
 #ifndef MAXLINE
@@ -40,6 +41,19 @@
                 off += len;                                     \
         } while (0)
 
+/* a changelog in the indexed encoding, mapped */
+struct gf_changelog_map {
+        char     *start;
+        size_t    size;
+
+        /* end of the records, where the index starts */
+        uint64_t  end;
+
+        /* offsets of the records */
+        uint64_t *index;
+        uint64_t  count;
+};
+
 typedef struct read_line {
         int rl_cnt;
         char *rl_bufptr;
@@ -223,6 +237,17 @@ gf_ftruncate (int fd, off_t length);
 off_t
 gf_lseek (int fd, off_t offset, int whence);
 
+ssize_t
+gf_changelog_map_decode (struct gf_changelog_map *map, uint64_t off,
+                         gf_changelog_record_t *rec);
+
+int
+gf_changelog_map_fd (xlator_t *this, struct gf_changelog_map *map,
+                     int fd, size_t hlen, size_t size);
+
+void
+gf_changelog_map_release (struct gf_changelog_map *map);
+
 int
 gf_changelog_consume (xlator_t *this,
                       gf_changelog_journal_t *jnl,
@@ -433,6 +433,103 @@ gf_changelog_parse_ascii (xlator_t *this,
         return ret;
 }
 
+/**
+ * indexed decoder: the fixed size record headers locate every field, the
+ * records are converted to the same ascii form as by the ascii decoder
+ * without scanning them.
+ */
+static int
+gf_changelog_parse_indexed (xlator_t *this,
+                            gf_changelog_journal_t *jnl,
+                            int from_fd, int to_fd,
+                            size_t start_offset, struct stat *stbuf,
+                            int version_idx)
+{
+        int                      i          = 0;
+        int                      ret        = -1;
+        int                      len        = 0;
+        off_t                    off        = 0;
+        uint64_t                 nr         = 0;
+        char                    *eptr       = NULL;
+        const char              *fopname    = NULL;
+        gf_changelog_record_t    rec        = {0,};
+        struct gf_changelog_map  map        = {0,};
+        char ascii[LINE_BUFSIZE]            = {0,};
+        char entry[LINE_BUFSIZE]            = {0,};
+
+        if (gf_changelog_map_fd (this, &map, from_fd,
+                                 start_offset, stbuf->st_size))
+                goto out;
+
+        for (nr = 0; nr < map.count; nr++) {
+                if (gf_changelog_map_decode (&map, map.index[nr], &rec) < 0)
+                        break;
+
+                off = 0;
+                GF_CHANGELOG_FILL_BUFFER (&rec.type, ascii, off, 1);
+                GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
+                eptr = uuid_utoa ((unsigned char *) rec.gfid);
+                GF_CHANGELOG_FILL_BUFFER (eptr, ascii, off, strlen (eptr));
+
+                if (rec.fop != GF_FOP_NULL) {
+                        if ((rec.fop < 0) || (rec.fop >= GF_FOP_MAXVALUE)
+                            || !(fopname = gf_fop_list[rec.fop]))
+                                break;
+                        GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
+                        GF_CHANGELOG_FILL_BUFFER (fopname, ascii,
+                                                  off, strlen (fopname));
+                }
+
+                for (i = 0; i < rec.nr_uint32; i++)
+                        off += sprintf (ascii + off, " %u", rec.uint32[i]);
+
+                for (i = 0; i < rec.nr_entries; i++) {
+                        len = snprintf (entry, sizeof (entry), "%s/%s",
+                                        uuid_utoa ((unsigned char *)
+                                                   rec.entries[i].pargfid),
+                                        rec.entries[i].bname);
+                        if (off + 3 * (len + strlen (rec.entries[i].path))
+                            + 3 > LINE_BUFSIZE)
+                                break;
+
+                        GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
+                        gf_rfc3986_encode ((unsigned char *) entry,
+                                           ascii + off, jnl->rfc3986);
+                        off += strlen (ascii + off);
+
+                        if (rec.entries[i].path[0] == '\0')
+                                continue;
+
+                        GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
+                        gf_rfc3986_encode ((unsigned char *)
+                                           rec.entries[i].path,
+                                           ascii + off, jnl->rfc3986);
+                        off += strlen (ascii + off);
+                }
+
+                if (i < rec.nr_entries)
+                        break;
+
+                GF_CHANGELOG_FILL_BUFFER ("\n", ascii, off, 1);
+
+                if (gf_changelog_write (to_fd, ascii, off) != off) {
+                        gf_msg (this->name, GF_LOG_ERROR, errno,
+                                CHANGELOG_LIB_MSG_ASCII_ERROR,
+                                "processing indexed changelog failed due to "
+                                " error in writing change");
+                        break;
+                }
+        }
+
+        if (nr == map.count)
+                ret = 0;
+
+        gf_changelog_map_release (&map);
+
+ out:
+        return ret;
+}
+
 #define COPY_BUFSIZE  8192
 static int
 gf_changelog_copy (xlator_t *this, int from_fd, int to_fd)
@@ -519,6 +616,12 @@ gf_changelog_decode (xlator_t *this, gf_changelog_journal_t *jnl,
                                                 to_fd, elen, stbuf,
                                                 version_idx);
                 break;
+
+        case CHANGELOG_ENCODE_INDEXED:
+                ret = gf_changelog_parse_indexed (this, jnl, from_fd,
+                                                  to_fd, elen, stbuf,
+                                                  version_idx);
+                break;
         default:
                 ret = gf_changelog_copy (this, from_fd, to_fd);
         }
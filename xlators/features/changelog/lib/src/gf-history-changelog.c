@@ -310,41 +310,42 @@ gf_history_changelog_scan ()
         return -1;
 }
 
+/* a HTIME file, mapped for the searches */
+struct gf_history_htime {
+        char   *start;
+        size_t  size;
+};
+
 /*
  * Gets timestamp value at the changelog path at index.
  * Returns 0 on success(updates given time-stamp), -1 on failure.
  */
 int
-gf_history_get_timestamp (int fd, int index, int len,
+gf_history_get_timestamp (struct gf_history_htime *htime, int index, int len,
                           unsigned long *ts)
 {
         xlator_t        *this             = NULL;
-        int             n_read            = -1;
-        char            path_buf[PATH_MAX]= {0,};
-        char            *iter             = path_buf;
         size_t          offset            = index * (len+1);
-        unsigned long   value             = 0;
-        int             ret               = 0;
+        char            value[TIMESTAMP_LENGTH + 1] = {0,};
 
         this = THIS;
         if (!this) {
                 return -1;
         }
 
-        n_read = sys_pread (fd, path_buf, len, offset);
-        if (n_read < 0 ) {
-                ret = -1;
-                gf_msg (this->name, GF_LOG_ERROR, errno,
-                         CHANGELOG_LIB_MSG_READ_ERROR,
-                         "could not read from htime file");
-                goto out;
+        if ((index < 0) || (len < TIMESTAMP_LENGTH)
+            || (offset + len > htime->size)) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        CHANGELOG_LIB_MSG_READ_ERROR,
+                        "no changelog at index %d of htime file", index);
+                return -1;
         }
-        iter+= len - TIMESTAMP_LENGTH;
-        sscanf (iter, "%lu",&value);
-out:
-        if(ret == 0)
-                *ts = value;
-        return ret;
+
+        memcpy (value, htime->start + offset + len - TIMESTAMP_LENGTH,
+                TIMESTAMP_LENGTH);
+        *ts = strtoul (value, NULL, 10);
+
+        return 0;
 }
 
 /*
@@ -352,14 +353,15 @@ out:
  * Checks whether @value is there next to @target_index or not
  */
 int
-gf_history_check ( int fd, int target_index, unsigned long value, int len)
+gf_history_check (struct gf_history_htime *htime, int target_index,
+                  unsigned long value, int len)
 {
         int             ret = 0;
         unsigned long   ts1 = 0;
         unsigned long   ts2 = 0;
 
         if (target_index == 0) {
-                ret = gf_history_get_timestamp (fd, target_index, len, &ts1);
+                ret = gf_history_get_timestamp (htime, target_index, len, &ts1);
                 if (ret == -1)
                         goto out;
                 if (value <= ts1)
@@ -370,10 +372,10 @@ gf_history_check ( int fd, int target_index, unsigned long value, int len)
                 }
         }
 
-        ret = gf_history_get_timestamp (fd, target_index, len, &ts1);
+        ret = gf_history_get_timestamp (htime, target_index, len, &ts1);
         if (ret ==-1)
                 goto out;
-        ret = gf_history_get_timestamp (fd, target_index -1, len, &ts2);
+        ret = gf_history_get_timestamp (htime, target_index -1, len, &ts2);
         if (ret ==-1)
                 goto out;
 
@@ -395,7 +397,7 @@ out:
  * Actual offset can be calculated as (index* (len+1) ).
  * "1" is because the changelog paths are null terminated.
  *
- * @path        : Htime file to search in
+ * @htime       : mapped Htime file to search in
  * @value       : time stamp to search
  * @from        : start index to search
  * @to          : end index to search
@@ -403,7 +405,7 @@ out:
  */
 
 int
-gf_history_b_search (int fd, unsigned long value,
+gf_history_b_search (struct gf_history_htime *htime, unsigned long value,
                      unsigned long from, unsigned long to, int len)
 {
         int             m_index   = -1;
@@ -419,7 +421,7 @@ gf_history_b_search (int fd, unsigned long value,
                         /* check if value is less or greater than to
                          * return accordingly
                          */
-                        ret = gf_history_get_timestamp (fd, from, len, &ts1);
+                        ret = gf_history_get_timestamp (htime, from, len, &ts1);
                         if (ret ==-1)
                                 goto out;
                         if ( ts1 >= value) {
@@ -437,20 +439,21 @@ gf_history_b_search (int fd, unsigned long value,
                         return to;
         }
 
-        ret = gf_history_get_timestamp (fd, m_index, len, &cur_value);
+        ret = gf_history_get_timestamp (htime, m_index, len, &cur_value);
         if (ret == -1)
                 goto out;
         if (cur_value == value) {
                 return m_index;
         }
         else if (value > cur_value) {
-                ret = gf_history_get_timestamp (fd, m_index+1, len, &cur_value);
+                ret = gf_history_get_timestamp (htime, m_index+1, len,
+                                                &cur_value);
                 if (ret == -1)
                         goto out;
                 if (value < cur_value)
                         return m_index + 1;
                 else
-                        return gf_history_b_search (fd, value,
+                        return gf_history_b_search (htime, value,
                                                     m_index+1, to, len);
         }
         else {
@@ -461,7 +464,7 @@ gf_history_b_search (int fd, unsigned long value,
                         return 0;
                 }
                 else {
-                        ret = gf_history_get_timestamp (fd, m_index-1, len,
+                        ret = gf_history_get_timestamp (htime, m_index-1, len,
                                                         &cur_value);
                         if (ret == -1)
                                 goto out;
@@ -469,7 +472,7 @@ gf_history_b_search (int fd, unsigned long value,
                                 return m_index;
                         }
                         else
-                                return gf_history_b_search (fd, value, from,
+                                return gf_history_b_search (htime, value, from,
                                                             m_index-1, len);
                 }
         }
@@ -800,6 +803,8 @@ gf_history_changelog (char* changelog_dir, unsigned long start,
         pthread_t                       consume_th              = 0;
         char                            htime_dir[PATH_MAX]     = {0,};
         char                            buffer[PATH_MAX]        = {0,};
+        struct stat                     stbuf                   = {0,};
+        struct gf_history_htime         htime                   = {0,};
 
         pthread_attr_t attr;
 
@@ -881,15 +886,36 @@ gf_history_changelog (char* changelog_dir, unsigned long start,
 
                         len = strlen (buffer);
 
+                        /* the searches probe the htime file in memory */
+                        if (sys_fstat (fd, &stbuf)) {
+                                ret = -1;
+                                gf_msg (this->name, GF_LOG_ERROR, errno,
+                                        CHANGELOG_LIB_MSG_HTIME_ERROR,
+                                        "fstat() failed on htime file");
+                                goto out;
+                        }
+
+                        htime.size = stbuf.st_size;
+                        htime.start = mmap (NULL, htime.size, PROT_READ,
+                                            MAP_PRIVATE, fd, 0);
+                        if (htime.start == MAP_FAILED) {
+                                htime.start = NULL;
+                                ret = -1;
+                                gf_msg (this->name, GF_LOG_ERROR, errno,
+                                        CHANGELOG_LIB_MSG_MMAP_FAILED,
+                                        "mmap() error");
+                                goto out;
+                        }
+
                         /**
                          * search @start in the htime file returning it's index
                          * (@from)
                          */
-                        from = gf_history_b_search (fd, start, 0,
+                        from = gf_history_b_search (&htime, start, 0,
                                                    total_changelog - 1, len);
 
                         /* ensuring correctness of gf_b_search */
-                        if (gf_history_check (fd, from, start, len) != 0) {
+                        if (gf_history_check (&htime, from, start, len) != 0) {
                                 ret = -1;
                                 gf_msg (this->name, GF_LOG_ERROR, 0,
                                         CHANGELOG_LIB_MSG_GET_TIME_ERROR,
@@ -903,10 +929,10 @@ gf_history_changelog (char* changelog_dir, unsigned long start,
                         /**
                          * search @end2 in htime file returning it's index (@to)
                          */
-                        to = gf_history_b_search (fd, end2,
+                        to = gf_history_b_search (&htime, end2,
                                                   0, total_changelog - 1, len);
 
-                        if (gf_history_check (fd, to, end2, len) != 0) {
+                        if (gf_history_check (&htime, to, end2, len) != 0) {
                                 ret = -1;
                                 gf_msg (this->name, GF_LOG_ERROR, 0,
                                         CHANGELOG_LIB_MSG_GET_TIME_ERROR,
@@ -915,11 +941,13 @@ gf_history_changelog (char* changelog_dir, unsigned long start,
                                 goto out;
                         }
 
-                        ret = gf_history_get_timestamp (fd, from, len, &ts1);
+                        ret = gf_history_get_timestamp (&htime, from, len,
+                                                        &ts1);
                         if (ret == -1)
                                 goto out;
 
-                        ret = gf_history_get_timestamp (fd, to, len, &ts2);
+                        ret = gf_history_get_timestamp (&htime, to, len,
+                                                        &ts2);
                         if (ret == -1)
                                 goto out;
 
@@ -975,6 +1003,9 @@ out:
         if (dirp != NULL)
                 (void) sys_closedir (dirp);
 
+        if (htime.start)
+                (void) munmap (htime.start, htime.size);
+
         if (ret < 0) {
                 if (fd != -1)
                         (void) sys_close (fd);
@@ -191,7 +191,7 @@ changelog_encode_ascii (xlator_t *this, changelog_log_data_t *cld)
 
         CHANGELOG_FILL_BUFFER (buffer, off, "\0", 1);
 
-        return changelog_write_change (priv, buffer, off);
+        return changelog_journal_stage (priv, buffer, off);
 }
 
 int
@@ -212,7 +212,84 @@ changelog_encode_binary (xlator_t *this, changelog_log_data_t *cld)
 
         CHANGELOG_FILL_BUFFER (buffer, off, "\0", 1);
 
-        return changelog_write_change (priv, buffer, off);
+        return changelog_journal_stage (priv, buffer, off);
+}
+
+static size_t
+changelog_encode_indexed_entry (changelog_opt_t *co, char *buffer)
+{
+        size_t                      off   = 0;
+        struct changelog_rec_entry  cre   = {{0,},};
+        const char                 *path  = "";
+
+        /* the path is captured for deletes only */
+        if ((co->co_convert == del_entry_fn) && co->co_entry.cef_path)
+                path = co->co_entry.cef_path;
+
+        gf_uuid_copy (cre.cre_pargfid, co->co_entry.cef_uuid);
+        cre.cre_bname_len = strlen (co->co_entry.cef_bname);
+        cre.cre_path_len = strlen (path);
+
+        CHANGELOG_FILL_BUFFER (buffer, off, &cre, sizeof (cre));
+        CHANGELOG_FILL_BUFFER (buffer, off,
+                               co->co_entry.cef_bname, cre.cre_bname_len + 1);
+        CHANGELOG_FILL_BUFFER (buffer, off, path, cre.cre_path_len + 1);
+
+        return off;
+}
+
+int
+changelog_encode_indexed (xlator_t *this, changelog_log_data_t *cld)
+{
+        int                       i      = 0;
+        int                       ret    = 0;
+        size_t                    off    = 0;
+        size_t                    len    = 0;
+        char                     *buffer = NULL;
+        changelog_opt_t          *co     = NULL;
+        changelog_priv_t         *priv   = NULL;
+        struct changelog_rec_hdr  hdr    = {0,};
+
+        priv = this->private;
+
+        hdr.crh_type = *priv->maps[cld->cld_type];
+        gf_uuid_copy (hdr.crh_gfid, cld->cld_gfid);
+
+        /* entries are smaller than their ascii form, plus the padding */
+        buffer = alloca (sizeof (hdr) + cld->cld_ptr_len + CHANGELOG_REC_ALIGN);
+        off = sizeof (hdr);
+
+        if (cld->cld_xtra_records)
+                co = (changelog_opt_t *) cld->cld_ptr;
+
+        for (; i < cld->cld_xtra_records; i++, co++) {
+                switch (co->co_type) {
+                case CHANGELOG_OPT_REC_FOP:
+                        hdr.crh_fop = co->co_fop;
+                        break;
+                case CHANGELOG_OPT_REC_UINT32:
+                        if (hdr.crh_nr_uint32 < CHANGELOG_REC_MAX_UINT32)
+                                hdr.crh_uint32[hdr.crh_nr_uint32++] =
+                                        co->co_uint32;
+                        break;
+                case CHANGELOG_OPT_REC_ENTRY:
+                        off += changelog_encode_indexed_entry (co,
+                                                               buffer + off);
+                        hdr.crh_nr_entries++;
+                        break;
+                }
+        }
+
+        len = CHANGELOG_REC_ALIGNED (off);
+        memset (buffer + off, 0, len - off);
+
+        hdr.crh_len = len;
+        memcpy (buffer, &hdr, sizeof (hdr));
+
+        ret = changelog_journal_stage (priv, buffer, len);
+        changelog_journal_index_add (priv, len, ret);
+
+        return ret;
 }
 
 static struct changelog_encoder
@@ -227,6 +304,11 @@ cb_encoder[] = {
                 .encoder = CHANGELOG_ENCODE_ASCII,
                 .encode = changelog_encode_ascii,
         },
+        [CHANGELOG_ENCODE_INDEXED] =
+        {
+                .encoder = CHANGELOG_ENCODE_INDEXED,
+                .encode = changelog_encode_indexed,
+        },
 };
 
 void
@@ -46,6 +46,8 @@ int
 changelog_encode_binary (xlator_t *, changelog_log_data_t *);
 int
 changelog_encode_ascii (xlator_t *, changelog_log_data_t *);
+int
+changelog_encode_indexed (xlator_t *, changelog_log_data_t *);
 void
 changelog_encode_change(changelog_priv_t *);
 
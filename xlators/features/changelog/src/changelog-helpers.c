@@ -938,6 +938,12 @@ changelog_open_journal (xlator_t *this,
                 goto out;
         }
 
+        /* records of an indexed journal are located from here on */
+        priv->journal.index_nr = 0;
+        priv->journal.index_broken = _gf_false;
+        priv->journal.index_next = sys_lseek (priv->changelog_fd,
+                                              0, SEEK_CUR);
+
         ret = 0;
 
  out:
@@ -995,6 +1001,265 @@ changelog_write_change (changelog_priv_t *priv, char *buffer, size_t len)
         return changelog_write (priv->changelog_fd, buffer, len);
 }
 
+int
+changelog_journal_init (xlator_t *this, changelog_priv_t *priv)
+{
+        int                  ret = 0;
+        changelog_journal_t *j   = &priv->journal;
+
+        j->buf[0] = GF_MALLOC (CHANGELOG_JOURNAL_BUFSIZE,
+                               gf_changelog_mt_journal_buf_t);
+        j->buf[1] = GF_MALLOC (CHANGELOG_JOURNAL_BUFSIZE,
+                               gf_changelog_mt_journal_buf_t);
+        if (!j->buf[0] || !j->buf[1])
+                goto free_bufs;
+
+        if ((ret = pthread_mutex_init (&j->lock, NULL)) != 0) {
+                gf_msg (this->name, GF_LOG_ERROR, ret,
+                        CHANGELOG_MSG_PTHREAD_MUTEX_INIT_FAILED,
+                        "journal pthread_mutex_init failed (%d)", ret);
+                goto free_bufs;
+        }
+
+        if ((ret = pthread_cond_init (&j->cond, NULL)) != 0) {
+                gf_msg (this->name, GF_LOG_ERROR, ret,
+                        CHANGELOG_MSG_PTHREAD_COND_INIT_FAILED,
+                        "journal pthread_cond_init failed (%d)", ret);
+                pthread_mutex_destroy (&j->lock);
+                goto free_bufs;
+        }
+
+        return 0;
+
+ free_bufs:
+        GF_FREE (j->buf[0]);
+        GF_FREE (j->buf[1]);
+        j->buf[0] = j->buf[1] = NULL;
+        return -1;
+}
+
+void
+changelog_journal_destroy (changelog_priv_t *priv)
+{
+        changelog_journal_t *j = &priv->journal;
+
+        pthread_cond_destroy (&j->cond);
+        pthread_mutex_destroy (&j->lock);
+        GF_FREE (j->buf[0]);
+        GF_FREE (j->buf[1]);
+        GF_FREE (j->index);
+}
+
+/* account a written batch and wake up the fops waiting for it */
+static void
+__changelog_journal_written (changelog_journal_t *j,
+                             uint64_t start, uint64_t end, int ret)
+{
+        j->written = end;
+        if (ret) {
+                if (j->failed_upto == j->failed_from)
+                        j->failed_from = start;
+                j->failed_upto = end;
+        }
+
+        pthread_cond_broadcast (&j->cond);
+}
+
+static int
+__changelog_journal_flush (changelog_priv_t *priv)
+{
+        int                  ret = 0;
+        changelog_journal_t *j   = &priv->journal;
+
+        while (j->writing)
+                pthread_cond_wait (&j->cond, &j->lock);
+
+        if (j->len) {
+                ret = changelog_write_change (priv, j->buf[j->active], j->len);
+                __changelog_journal_written (j, j->written, j->staged, ret);
+                j->len = 0;
+        }
+
+        return ret;
+}
+
+/**
+ * stage an encoded record; called with the dispatcher lock held, the record
+ * is written by changelog_journal_commit () once the lock is dropped.
+ */
+int
+changelog_journal_stage (changelog_priv_t *priv, char *buffer, size_t len)
+{
+        int                  ret = 0;
+        changelog_journal_t *j   = &priv->journal;
+
+        pthread_mutex_lock (&j->lock);
+        {
+                if (j->len + len > CHANGELOG_JOURNAL_BUFSIZE) {
+                        ret = __changelog_journal_flush (priv);
+                        if (ret)
+                                goto unlock;
+                }
+
+                if (len > CHANGELOG_JOURNAL_BUFSIZE) {
+                        ret = changelog_write_change (priv, buffer, len);
+                        j->staged += len;
+                        __changelog_journal_written (j, j->written, j->staged,
+                                                     ret);
+                        goto unlock;
+                }
+
+                memcpy (j->buf[j->active] + j->len, buffer, len);
+                j->len += len;
+                j->staged += len;
+        }
+ unlock:
+        pthread_mutex_unlock (&j->lock);
+
+        return ret;
+}
+
+/**
+ * write all the staged records; called with the dispatcher lock held before
+ * the journal is fsync()'d or rolled over.
+ */
+int
+changelog_journal_flush (changelog_priv_t *priv)
+{
+        int                  ret = 0;
+        changelog_journal_t *j   = &priv->journal;
+
+        pthread_mutex_lock (&j->lock);
+        {
+                ret = __changelog_journal_flush (priv);
+        }
+        pthread_mutex_unlock (&j->lock);
+
+        return ret;
+}
+
+/**
+ * wait until the journal has all the records staged up to @seq. The first
+ * waiter writes every staged record in one go while new ones are staged in
+ * the other buffer, the waiters which come in meanwhile are covered by the
+ * next write.
+ */
+int
+changelog_journal_commit (changelog_priv_t *priv, uint64_t seq)
+{
+        int                  ret   = 0;
+        char                *buf   = NULL;
+        size_t               len   = 0;
+        uint64_t             start = 0;
+        uint64_t             end   = 0;
+        changelog_journal_t *j     = &priv->journal;
+
+        pthread_mutex_lock (&j->lock);
+        {
+                while (j->written < seq) {
+                        if (j->writing) {
+                                pthread_cond_wait (&j->cond, &j->lock);
+                                continue;
+                        }
+
+                        buf = j->buf[j->active];
+                        len = j->len;
+                        start = j->written;
+                        end = j->staged;
+
+                        j->active ^= 1;
+                        j->len = 0;
+                        j->writing = _gf_true;
+
+                        pthread_mutex_unlock (&j->lock);
+                        ret = changelog_write_change (priv, buf, len);
+                        pthread_mutex_lock (&j->lock);
+
+                        j->writing = _gf_false;
+                        __changelog_journal_written (j, start, end, ret);
+                }
+
+                ret = (seq > j->failed_from && seq <= j->failed_upto) ? -1 : 0;
+        }
+        pthread_mutex_unlock (&j->lock);
+
+        return ret;
+}
+
+/**
+ * account a record of @len bytes staged to an indexed journal; called with
+ * the dispatcher lock held. A journal missing a record, or whose offsets
+ * could not be kept, is left without an index: readers walk its records.
+ */
+void
+changelog_journal_index_add (changelog_priv_t *priv, size_t len, int ret)
+{
+        uint64_t            *index = NULL;
+        uint64_t             size  = 0;
+        changelog_journal_t *j     = &priv->journal;
+
+        if (j->index_broken)
+                return;
+
+        if (ret) {
+                j->index_broken = _gf_true;
+                return;
+        }
+
+        if (j->index_nr == j->index_size) {
+                size = j->index_size ? (j->index_size * 2) : 1024;
+                if (j->index)
+                        index = GF_REALLOC (j->index, size * sizeof (*index));
+                else
+                        index = GF_MALLOC (size * sizeof (*index),
+                                           gf_changelog_mt_journal_index_t);
+                if (!index) {
+                        j->index_broken = _gf_true;
+                        return;
+                }
+
+                j->index = index;
+                j->index_size = size;
+        }
+
+        j->index[j->index_nr++] = j->index_next;
+        j->index_next += len;
+}
+
+/**
+ * append the offsets of the records and the trailer to an indexed journal
+ * about to be rolled over; called with the dispatcher lock held after the
+ * staged records are written. Empty journals are left as they are.
+ */
+int
+changelog_journal_index_write (xlator_t *this, changelog_priv_t *priv)
+{
+        int                             ret     = 0;
+        struct changelog_index_trailer  trailer = {0,};
+        changelog_journal_t            *j       = &priv->journal;
+
+        if (j->index_broken || (j->index_nr == 0))
+                goto out;
+
+        trailer.cit_offset = j->index_next;
+        trailer.cit_count = j->index_nr;
+        trailer.cit_magic = CHANGELOG_INDEX_MAGIC;
+
+        ret = changelog_write_change (priv, (char *) j->index,
+                                      j->index_nr * sizeof (*j->index));
+        if (!ret)
+                ret = changelog_write_change (priv, (char *) &trailer,
+                                              sizeof (trailer));
+        if (ret)
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        CHANGELOG_MSG_WRITE_FAILED,
+                        "error writing the index of the changelog");
+
+ out:
+        j->index_nr = 0;
+        return ret;
+}
+
 /*
  * Descriptions:
  *      Writes fop details in ascii format to CSNAP.
@@ -1058,6 +1323,15 @@ changelog_handle_change (xlator_t *this,
         int ret = 0;
 
         if (CHANGELOG_TYPE_IS_ROLLOVER (cld->cld_type)) {
+                /* the staged records belong to the journal rolled over */
+                if (changelog_journal_flush (priv))
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                CHANGELOG_MSG_WRITE_FAILED,
+                                "error writing changelog to disk");
+                else if ((priv->changelog_fd != -1) &&
+                         (priv->ce->encoder == CHANGELOG_ENCODE_INDEXED))
+                        (void) changelog_journal_index_write (this, priv);
+
                 changelog_encode_change (priv);
                 ret = changelog_start_next_change (this, priv,
                                                    cld->cld_roll_time,
@@ -1077,6 +1351,12 @@ changelog_handle_change (xlator_t *this,
                 return 0;
 
         if (CHANGELOG_TYPE_IS_FSYNC (cld->cld_type)) {
+                ret = changelog_journal_flush (priv);
+                if (ret)
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                CHANGELOG_MSG_WRITE_FAILED,
+                                "error writing changelog to disk");
+
                 ret = sys_fsync (priv->changelog_fd);
                 if (ret < 0) {
                         gf_msg (this->name, GF_LOG_ERROR, errno,
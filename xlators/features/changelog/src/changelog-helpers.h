@@ -179,6 +179,51 @@ typedef struct barrier_flags {
         gf_boolean_t barrier_ext;
 } barrier_flags_t;
 
+/* Group commit of the journal:
+ * ----------------------------
+ * Records are encoded and staged in memory under the dispatcher lock, which
+ * is not held across any syscall. Once the lock is dropped, a fop waits for
+ * its record to reach the journal before it is unwound: the first waiter
+ * swaps the staging buffers and writes every staged record with one write(),
+ * the other waiters sleep until that write covers their record. Rollover and
+ * fsync first write all staged records, under the dispatcher lock, so they
+ * still act on a complete journal.
+ */
+
+#define CHANGELOG_JOURNAL_BUFSIZE  (128 * GF_UNIT_KB)
+
+typedef struct changelog_journal {
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond;
+
+        /* records are staged in one buffer while the other is written */
+        char            *buf[2];
+        int              active;
+        size_t           len;
+
+        /* bytes ever staged and bytes written out of them */
+        uint64_t         staged;
+        uint64_t         written;
+
+        /* a waiter is writing the other buffer */
+        gf_boolean_t     writing;
+
+        /* staged bytes spanning every batch which failed to be written.
+         * A waiter may wake up after several batches were written, so no
+         * failure is forgotten; one written fine in between is reported
+         * failed too, never the other way around */
+        uint64_t         failed_from;
+        uint64_t         failed_upto;
+
+        /* offsets of the records of an indexed journal and where the next
+         * one goes, under the dispatcher lock like the encoding */
+        uint64_t        *index;
+        uint64_t         index_nr;
+        uint64_t         index_size;
+        uint64_t         index_next;
+        gf_boolean_t     index_broken;
+} changelog_journal_t;
+
 /* Event selection */
 typedef struct changelog_ev_selector {
         gf_lock_t reflock;
@@ -238,6 +283,9 @@ struct changelog_priv {
         /* context of the updater */
         changelog_dispatcher_t cd;
 
+        /* group commit of the records */
+        changelog_journal_t journal;
+
         /* context of the rollover thread */
         changelog_rollover_t cr;
 
@@ -421,6 +469,20 @@ changelog_write (int fd, char *buffer, size_t len);
 int
 changelog_write_change (changelog_priv_t *priv, char *buffer, size_t len);
 int
+changelog_journal_init (xlator_t *this, changelog_priv_t *priv);
+void
+changelog_journal_destroy (changelog_priv_t *priv);
+int
+changelog_journal_stage (changelog_priv_t *priv, char *buffer, size_t len);
+int
+changelog_journal_flush (changelog_priv_t *priv);
+int
+changelog_journal_commit (changelog_priv_t *priv, uint64_t seq);
+void
+changelog_journal_index_add (changelog_priv_t *priv, size_t len, int ret);
+int
+changelog_journal_index_write (xlator_t *this, changelog_priv_t *priv);
+int
 changelog_handle_change (xlator_t *this,
                          changelog_priv_t *priv, changelog_log_data_t *cld);
 void
@@ -28,6 +28,9 @@ enum gf_changelog_mem_types {
         gf_changelog_mt_libgfchangelog_call_pool_t = gf_common_mt_end + 12,
         gf_changelog_mt_libgfchangelog_event_t     = gf_common_mt_end + 13,
         gf_changelog_mt_ev_dispatcher_t            = gf_common_mt_end + 14,
+        gf_changelog_mt_journal_buf_t              = gf_common_mt_end + 15,
+        gf_changelog_mt_journal_index_t            = gf_common_mt_end + 16,
+        gf_changelog_mt_libgfchangelog_map_t       = gf_common_mt_end + 17,
         gf_changelog_mt_end
 };
 
@@ -118,12 +118,53 @@ typedef enum {
         CHANGELOG_ENCODE_MIN = 0,
         CHANGELOG_ENCODE_BINARY,
         CHANGELOG_ENCODE_ASCII,
+        CHANGELOG_ENCODE_INDEXED,
         CHANGELOG_ENCODE_MAX,
 } changelog_encoder_t;
 
 #define CHANGELOG_VALID_ENCODING(enc)                                   \
         (enc > CHANGELOG_ENCODE_MIN && enc < CHANGELOG_ENCODE_MAX)
 
+/**
+ * indexed encoding: every record is a fixed size header followed by its
+ * entries (parent gfid, basename and for deletes the path), padded to
+ * CHANGELOG_REC_ALIGN bytes. Fields are in host byte order. On rollover
+ * the offsets of all the records, as an array of uint64_t, and a trailer
+ * are appended to the changelog so that readers can jump to any record.
+ */
+#define CHANGELOG_REC_ALIGN         8
+#define CHANGELOG_REC_MAX_UINT32    3
+#define CHANGELOG_INDEX_MAGIC       0x47464349  /* "GFCI" */
+
+#define CHANGELOG_REC_ALIGNED(len)                                      \
+        (((len) + CHANGELOG_REC_ALIGN - 1) & ~(CHANGELOG_REC_ALIGN - 1))
+
+struct changelog_rec_hdr {
+        uint32_t      crh_len;          /* header, entries and padding */
+        uint8_t       crh_type;         /* 'D', 'M' or 'E' */
+        uint8_t       crh_nr_entries;
+        uint8_t       crh_nr_uint32;
+        uint8_t       crh_pad;
+        uint32_t      crh_fop;          /* GF_FOP_NULL for data records */
+        uint32_t      crh_uint32[CHANGELOG_REC_MAX_UINT32];
+        unsigned char crh_gfid[16];
+};
+
+/* basename and path follow, each with its '\0' (lengths do not count it),
+ * the path is empty unless it was captured for a delete */
+struct changelog_rec_entry {
+        unsigned char cre_pargfid[16];
+        uint16_t      cre_bname_len;
+        uint16_t      cre_path_len;
+};
+
+struct changelog_index_trailer {
+        uint64_t      cit_offset;       /* of the offsets of the records */
+        uint64_t      cit_count;
+        uint32_t      cit_magic;
+        uint32_t      cit_pad;
+};
+
 #define CHANGELOG_TYPE_IS_ENTRY(type)  (type == CHANGELOG_TYPE_ENTRY)
 #define CHANGELOG_TYPE_IS_ROLLOVER(type)  (type == CHANGELOG_TYPE_ROLLOVER)
 #define CHANGELOG_TYPE_IS_FSYNC(type)  (type == CHANGELOG_TYPE_FSYNC)
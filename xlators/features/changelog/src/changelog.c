@@ -2024,6 +2024,8 @@ changelog_assign_encoding (changelog_priv_t *priv, char *enc)
                 priv->encode_mode = CHANGELOG_ENCODE_BINARY;
         } else if ( strncmp (enc, "ascii", 5) == 0 ) {
                 priv->encode_mode = CHANGELOG_ENCODE_ASCII;
+        } else if ( strncmp (enc, "indexed", 7) == 0 ) {
+                priv->encode_mode = CHANGELOG_ENCODE_INDEXED;
         }
 }
 
@@ -2820,10 +2822,14 @@ init (xlator_t *this)
         LOCK_INIT (&priv->lock);
         LOCK_INIT (&priv->c_snap_lock);
 
-        ret = changelog_init_options (this, priv);
+        ret = changelog_journal_init (this, priv);
         if (ret)
                 goto cleanup_mempool;
 
+        ret = changelog_init_options (this, priv);
+        if (ret)
+                goto cleanup_journal;
+
         /* snap dependency changes */
         priv->dm.black_fop_cnt = 0;
         priv->dm.white_fop_cnt = 0;
@@ -2866,6 +2872,8 @@ init (xlator_t *this)
         changelog_barrier_pthread_destroy (priv);
  cleanup_options:
         changelog_freeup_options (this, priv);
+ cleanup_journal:
+        changelog_journal_destroy (priv);
  cleanup_mempool:
         mem_pool_destroy (this->local_pool);
  cleanup_priv:
@@ -2892,6 +2900,9 @@ fini (xlator_t *this)
                 /* cleanup allocated options */
                 changelog_freeup_options (this, priv);
 
+                /* every staged record was committed by its fop */
+                changelog_journal_destroy (priv);
+
                 /* deallocate mempool */
                 mem_pool_destroy (this->local_pool);
                 /* finally, dealloac private variable */
@@ -2956,8 +2967,10 @@ struct volume_options options[] = {
         {.key = {"encoding"},
          .type = GF_OPTION_TYPE_STR,
          .default_value = "ascii",
-         .value = {"binary", "ascii"},
-         .description = "encoding type for changelogs"
+         .value = {"binary", "ascii", "indexed"},
+         .description = "encoding type for changelogs. \"indexed\" writes "
+         "fixed size record headers and an index of the records on rollover, "
+         "for consumers to read the changelogs in place."
         },
         {.key = {"rollover-time"},
          .default_value = "15",
@@ -14,6 +14,7 @@
 #include "ctr-helper.h"
 #include "ctr-messages.h"
 #include "syscall.h"
+#include "statedump.h"
 
 /*******************************inode forget***********************************/
 
@@ -1695,6 +1696,7 @@ out:
  * void *conn_node : Database connection
  * char *query_file: the query file that needs to be updated
  * gfdb_ipc_ctr_params_t *ipc_ctr_params: the query parameters
+ * int query_limit: max number of file links in the query file, 0 for all
  * Return:
  * On success 0
  * On failure -1
@@ -1703,7 +1705,8 @@ int
 ctr_db_query (xlator_t *this,
               void *conn_node,
               char *query_file,
-              gfdb_ipc_ctr_params_t *ipc_ctr_params)
+              gfdb_ipc_ctr_params_t *ipc_ctr_params,
+              int query_limit)
 {
         int ret = -1;
         ctr_query_cbk_args_t query_cbk_args = {0};
@@ -1730,7 +1733,8 @@ ctr_db_query (xlator_t *this,
                                         conn_node,
                                         ctr_db_query_callback,
                                         (void *)&query_cbk_args,
-                                        &ipc_ctr_params->time_stamp);
+                                        &ipc_ctr_params->time_stamp,
+                                        query_limit);
                 } else {
                                 ret = find_unchanged_for_time_freq (
                                         conn_node,
@@ -1739,7 +1743,7 @@ ctr_db_query (xlator_t *this,
                                         &ipc_ctr_params->time_stamp,
                                         ipc_ctr_params->write_freq_threshold,
                                         ipc_ctr_params->read_freq_threshold,
-                                        _gf_false);
+                                        _gf_false, query_limit);
                 }
         } else {
                 if (ipc_ctr_params->write_freq_threshold == 0 &&
@@ -1748,7 +1752,8 @@ ctr_db_query (xlator_t *this,
                                 conn_node,
                                 ctr_db_query_callback,
                                 (void *)&query_cbk_args,
-                                &ipc_ctr_params->time_stamp);
+                                &ipc_ctr_params->time_stamp,
+                                query_limit);
                 } else {
                         ret = find_recently_changed_files_freq (
                                 conn_node,
@@ -1757,7 +1762,7 @@ ctr_db_query (xlator_t *this,
                                 &ipc_ctr_params->time_stamp,
                                 ipc_ctr_params->write_freq_threshold,
                                 ipc_ctr_params->read_freq_threshold,
-                                _gf_false);
+                                _gf_false, query_limit);
                 }
         }
         if (ret) {
@@ -1802,6 +1807,7 @@ ctr_ipc_helper (xlator_t *this, dict_t *in_dict,
         char *db_param = NULL;
         char *query_file = NULL;
         gfdb_ipc_ctr_params_t *ipc_ctr_params = NULL;
+        int query_limit = 0;
 
 
         GF_VALIDATE_OR_GOTO ("ctr", this, out);
@@ -1814,6 +1820,16 @@ ctr_ipc_helper (xlator_t *this, dict_t *in_dict,
         GET_DB_PARAM_FROM_DICT(this->name, in_dict, GFDB_IPC_CTR_KEY,
                                 ctr_ipc_ops, out);
 
+        /* The heat gathered in memory goes to the db before the db is
+         * queried or cleared */
+        if (strncmp (ctr_ipc_ops, GFDB_IPC_CTR_CLEAR_OPS,
+                        strlen (GFDB_IPC_CTR_CLEAR_OPS)) == 0 ||
+            strncmp (ctr_ipc_ops, GFDB_IPC_CTR_QUERY_OPS,
+                        strlen (GFDB_IPC_CTR_QUERY_OPS)) == 0) {
+                if (priv->heat_cache)
+                        ctr_heat_cache_flush (priv->heat_cache);
+        }
+
         /*if its a db clear operation */
         if (strncmp (ctr_ipc_ops, GFDB_IPC_CTR_CLEAR_OPS,
                         strlen (GFDB_IPC_CTR_CLEAR_OPS)) == 0) {
@@ -1842,8 +1858,13 @@ ctr_ipc_helper (xlator_t *this, dict_t *in_dict,
                         goto out;
                 }
 
+                /* Older tier daemons do not send a limit */
+                if (dict_get_int32 (in_dict, GFDB_IPC_CTR_GET_QUERY_LIMIT,
+                                    &query_limit))
+                        query_limit = 0;
+
                 ret = ctr_db_query (this, priv->_db_conn, query_file,
-                                ipc_ctr_params);
+                                ipc_ctr_params, query_limit);
 
                 ret = dict_set_int32 (out_dict,
                                       GFDB_IPC_CTR_RET_QUERY_COUNT, ret);
@@ -1853,6 +1874,17 @@ ctr_ipc_helper (xlator_t *this, dict_t *in_dict,
                         goto out;
                 }
 
+        } /* if its a flush of the heat gathered in memory, before the db
+           * is queried directly */
+        else if (strncmp (ctr_ipc_ops, GFDB_IPC_CTR_FLUSH_OPS,
+                                strlen (GFDB_IPC_CTR_FLUSH_OPS)) == 0) {
+
+                if (priv->heat_cache) {
+                        ret = ctr_heat_cache_flush (priv->heat_cache);
+                        if (ret)
+                                goto out;
+                }
+
         } /* if its a query for db version */
         else if (strncmp (ctr_ipc_ops, GFDB_IPC_CTR_GET_DB_VERSION_OPS,
                         strlen (GFDB_IPC_CTR_GET_DB_VERSION_OPS)) == 0) {
@@ -1959,6 +1991,7 @@ reconfigure (xlator_t *this, dict_t *options)
 {
         char *temp_str = NULL;
         int ret = 0;
+        gfdb_sync_type_t sync_type = GFDB_INVALID_SYNC;
         gf_ctr_private_t *priv = NULL;
 
         priv = this->private;
@@ -1994,6 +2027,27 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("record-entry", priv->ctr_record_wind, options,
                           bool, out);
 
+        GF_OPTION_RECONF ("ctr-heat-cache-size", priv->ctr_heat_cache_size,
+                          options, uint64, out);
+
+        GF_OPTION_RECONF ("ctr-flush-interval", priv->ctr_flush_interval,
+                          options, uint32, out);
+
+        ctr_heat_cache_reconfigure (priv->heat_cache,
+                                    priv->ctr_heat_cache_size,
+                                    priv->ctr_flush_interval);
+
+        GF_OPTION_RECONF ("db-sync", temp_str, options, str, out);
+        sync_type = gf_string2gfdbdbsync (temp_str);
+        if (sync_type != GFDB_INVALID_SYNC &&
+            sync_type != priv->gfdb_sync_type) {
+                priv->gfdb_sync_type = sync_type;
+                /* What the cache holds is older than what the fops in
+                 * flight will record synchronously from now on */
+                if (sync_type == GFDB_DB_SYNC && priv->heat_cache)
+                        ctr_heat_cache_flush (priv->heat_cache);
+        }
+
 
 
 
@@ -2078,6 +2132,8 @@ init (xlator_t *this)
                                 CTR_DEFAULT_HARDLINK_EXP_PERIOD;
         priv->ctr_lookupheal_inode_timeout =
                                 CTR_DEFAULT_INODE_EXP_PERIOD;
+        priv->ctr_heat_cache_size      = CTR_DEFAULT_HEAT_CACHE_SIZE;
+        priv->ctr_flush_interval       = CTR_DEFAULT_FLUSH_INTERVAL;
 
         /*Extract ctr xlator options*/
         ret_db = extract_ctr_options (this, priv);
@@ -2123,6 +2179,18 @@ init (xlator_t *this)
                         goto error;
         }
 
+        /*Heat cache used when the db is written asynchronously, it is
+         * created even with db-sync sync so that it can be reconfigured*/
+        priv->heat_cache = ctr_heat_cache_new (this, priv->_db_conn,
+                                               priv->ctr_heat_cache_size,
+                                               priv->ctr_flush_interval);
+        if (!priv->heat_cache) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        CTR_MSG_HEAT_CACHE_INIT_FAILED,
+                        "Failed initializing the heat cache");
+                goto error;
+        }
+
         ret_db = 0;
         goto out;
 
@@ -2133,6 +2201,8 @@ error:
                 mem_pool_destroy (this->local_pool);
 
         if (priv) {
+                if (priv->_db_conn)
+                        fini_db (priv->_db_conn);
                 GF_FREE (priv->ctr_db_path);
         }
         GF_FREE (priv);
@@ -2179,6 +2249,8 @@ fini (xlator_t *this)
         priv = this->private;
 
         if (priv) {
+                /* Flushes what is left in the cache */
+                ctr_heat_cache_destroy (priv->heat_cache);
                 if (fini_db (priv->_db_conn)) {
                         gf_msg (this->name, GF_LOG_WARNING, 0,
                                 CTR_MSG_CLOSE_DB_CONN_FAILED, "Failed closing "
@@ -2192,6 +2264,28 @@ fini (xlator_t *this)
         return;
 }
 
+int32_t
+ctr_priv_dump (xlator_t *this)
+{
+        gf_ctr_private_t *priv                       = NULL;
+        char  key_prefix[GF_DUMP_MAX_BUF_LEN]        = {0, };
+
+        priv = this->private;
+        if (!priv)
+                goto out;
+
+        gf_proc_dump_build_key (key_prefix, this->type, "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("enabled", "%d", priv->enabled);
+        gf_proc_dump_write ("db-sync", "%s",
+                            (priv->gfdb_sync_type == GFDB_DB_ASYNC) ?
+                            GFDB_STR_DB_ASYNC : GFDB_STR_DB_SYNC);
+        ctr_heat_cache_dump (priv->heat_cache);
+out:
+        return 0;
+}
+
 struct xlator_fops fops = {
         /*lookup*/
         .lookup         = ctr_lookup,
@@ -2220,6 +2314,10 @@ struct xlator_cbks cbks = {
         .forget = ctr_forget
 };
 
+struct xlator_dumpops dumpops = {
+        .priv = ctr_priv_dump,
+};
+
 struct volume_options options[] = {
         { .key  = {"ctr-enabled",},
           .type = GF_OPTION_TYPE_BOOL,
@@ -2274,7 +2372,30 @@ struct volume_options options[] = {
         { .key  = {"db-sync"},
           .type = GF_OPTION_TYPE_STR,
           .value = {"sync", "async"},
-          .default_value = "sync"
+          .default_value = "sync",
+          .description = "With sync, every fop is written to the db. "
+                         "With async, the heat of inode fops is gathered "
+                         "in memory and written to the db in a single "
+                         "transaction every ctr-flush-interval seconds, "
+                         "and up to that much heat is lost on a crash."
+        },
+        { .key  = {"ctr-flush-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 600,
+          .default_value = "5",
+          .description = "Seconds between two writes of the heat gathered "
+                         "in memory to the db, with db-sync async. This is "
+                         "the most heat lost on a crash."
+        },
+        { .key  = {"ctr-heat-cache-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1024,
+          .max  = 4194304,
+          .default_value = "65536",
+          .description = "Number of inodes whose heat is gathered in memory "
+                         "with db-sync async. Fops on more inodes are "
+                         "written to the db right away."
         },
         { .key  = {"db-path"},
           .type = GF_OPTION_TYPE_PATH
@@ -0,0 +1,390 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#include "ctr-heat-cache.h"
+#include "ctr-messages.h"
+#include "statedump.h"
+#include <time.h>
+
+static ctr_heat_stripe_t *
+ctr_heat_stripe (ctr_heat_cache_t *cache, uuid_t gfid,
+                 struct list_head **bucket)
+{
+        ctr_heat_stripe_t *stripe = NULL;
+
+        stripe = &cache->stripes[gfid[15] % CTR_HEAT_CACHE_STRIPES];
+        *bucket = &stripe->buckets[gfid[14] % CTR_HEAT_CACHE_BUCKETS];
+
+        return stripe;
+}
+
+static gfdb_time_t *
+ctr_heat_time (gfdb_heat_record_t *heat, gf_boolean_t is_read,
+               gf_boolean_t is_wind)
+{
+        if (is_read)
+                return (is_wind) ? &heat->read_wind_time
+                                 : &heat->read_unwind_time;
+
+        return (is_wind) ? &heat->write_wind_time : &heat->write_unwind_time;
+}
+
+int
+ctr_heat_cache_record (ctr_heat_cache_t *cache, gfdb_db_record_t *record)
+{
+        int                  ret        = -1;
+        ctr_heat_stripe_t   *stripe     = NULL;
+        struct list_head    *bucket     = NULL;
+        ctr_heat_entry_t    *entry      = NULL;
+        ctr_heat_entry_t    *tmp        = NULL;
+        gfdb_time_t         *fop_time   = NULL;
+        gfdb_time_t         *latest     = NULL;
+        gf_boolean_t         is_read    = _gf_false;
+        gf_boolean_t         is_wind    = _gf_false;
+        gf_boolean_t         wake       = _gf_false;
+
+        GF_ASSERT (cache);
+        GF_ASSERT (record);
+
+        /* Dentry fops change records and links, they go to the db */
+        if (isdentryfop (record->gfdb_fop_type))
+                goto out;
+
+        is_read = isreadfop (record->gfdb_fop_type);
+
+        switch (record->gfdb_fop_path) {
+        case GFDB_FOP_WIND:
+                is_wind = _gf_true;
+                fop_time = &record->gfdb_wind_change_time;
+                if (!record->do_record_times) {
+                        ret = 0;
+                        goto out;
+                }
+                break;
+        case GFDB_FOP_UNWIND:
+                fop_time = &record->gfdb_unwind_change_time;
+                if (!record->do_record_times ||
+                    !record->do_record_uwind_time) {
+                        ret = 0;
+                        goto out;
+                }
+                break;
+        default:
+                goto out;
+        }
+
+        stripe = ctr_heat_stripe (cache, record->gfid, &bucket);
+
+        LOCK (&stripe->lock);
+        {
+                list_for_each_entry (tmp, bucket, list) {
+                        if (gf_uuid_compare (tmp->heat.gfid,
+                                             record->gfid) == 0) {
+                                entry = tmp;
+                                break;
+                        }
+                }
+
+                if (entry) {
+                        __sync_fetch_and_add (&cache->merged, 1);
+                } else {
+                        if (cache->entries >= cache->max_entries) {
+                                __sync_fetch_and_add (&cache->overflows, 1);
+                                wake = _gf_true;
+                                goto unlock;
+                        }
+
+                        entry = GF_CALLOC (1, sizeof (*entry),
+                                           gf_ctr_mt_heat_entry_t);
+                        if (!entry)
+                                goto unlock;
+
+                        gf_uuid_copy (entry->heat.gfid, record->gfid);
+                        list_add (&entry->list, bucket);
+                        if (__sync_add_and_fetch (&cache->entries, 1) >=
+                            cache->max_entries / 2)
+                                wake = _gf_true;
+                }
+
+                latest = ctr_heat_time (&entry->heat, is_read, is_wind);
+                if (timercmp (fop_time, latest, >))
+                        *latest = *fop_time;
+
+                if (is_wind && record->do_record_counters) {
+                        if (is_read)
+                                entry->heat.read_count++;
+                        else
+                                entry->heat.write_count++;
+                }
+
+                ret = 0;
+        }
+unlock:
+        UNLOCK (&stripe->lock);
+
+        if (ret == 0)
+                __sync_fetch_and_add (&cache->recorded, 1);
+
+        /* Flush early once the cache is half full */
+        if (wake && !cache->flush_wanted) {
+                cache->flush_wanted = _gf_true;
+                pthread_cond_signal (&cache->flush_cond);
+        }
+out:
+        return ret;
+}
+
+/* Call with flush_lock held */
+static int
+__ctr_heat_cache_flush (ctr_heat_cache_t *cache)
+{
+        int                  ret        = 0;
+        int                  i          = 0;
+        int                  j          = 0;
+        uint64_t             count      = 0;
+        uint64_t             usec       = 0;
+        uint64_t             overflows  = 0;
+        ctr_heat_stripe_t   *stripe     = NULL;
+        ctr_heat_entry_t    *entry      = NULL;
+        ctr_heat_entry_t    *tmp        = NULL;
+        gfdb_heat_record_t  *records    = NULL;
+        struct list_head     drained;
+        struct timeval       start      = {0, };
+        struct timeval       end        = {0, };
+
+        INIT_LIST_HEAD (&drained);
+
+        for (i = 0; i < CTR_HEAT_CACHE_STRIPES; i++) {
+                stripe = &cache->stripes[i];
+
+                LOCK (&stripe->lock);
+                {
+                        for (j = 0; j < CTR_HEAT_CACHE_BUCKETS; j++)
+                                list_splice_init (&stripe->buckets[j],
+                                                  &drained);
+                }
+                UNLOCK (&stripe->lock);
+        }
+
+        list_for_each_entry (entry, &drained, list)
+                count++;
+
+        if (!count)
+                goto out;
+
+        __sync_fetch_and_sub (&cache->entries, count);
+
+        records = GF_CALLOC (count, sizeof (*records),
+                             gf_ctr_mt_heat_record_t);
+
+        i = 0;
+        list_for_each_entry_safe (entry, tmp, &drained, list) {
+                if (records)
+                        records[i++] = entry->heat;
+                list_del (&entry->list);
+                GF_FREE (entry);
+        }
+
+        if (!records) {
+                gf_msg (cache->this->name, GF_LOG_ERROR, ENOMEM,
+                        CTR_MSG_HEAT_CACHE_FLUSH_FAILED, "Dropping the heat "
+                        "of %"PRIu64" inodes", count);
+                cache->flush_failures++;
+                ret = -1;
+                goto out;
+        }
+
+        gettimeofday (&start, NULL);
+        ret = update_heat (cache->db_conn, records, count);
+        gettimeofday (&end, NULL);
+
+        usec = gfdb_time_2_usec (&end) - gfdb_time_2_usec (&start);
+        cache->last_flush_usec = usec;
+        if (usec > cache->max_flush_usec)
+                cache->max_flush_usec = usec;
+
+        cache->flushes++;
+        cache->flushed += count;
+        if (ret) {
+                cache->flush_failures++;
+                gf_msg (cache->this->name, GF_LOG_WARNING, 0,
+                        CTR_MSG_HEAT_CACHE_FLUSH_FAILED, "Failed writing the "
+                        "heat of %"PRIu64" inodes to the db", count);
+        }
+
+out:
+        overflows = cache->overflows - cache->overflows_logged;
+        cache->overflows_logged += overflows;
+        if (overflows)
+                gf_msg (cache->this->name, GF_LOG_INFO, 0,
+                        CTR_MSG_HEAT_CACHE_FULL, "Heat cache of %"PRIu64
+                        " inodes was full, %"PRIu64" fops were recorded "
+                        "synchronously", cache->max_entries, overflows);
+
+        GF_FREE (records);
+        return ret;
+}
+
+int
+ctr_heat_cache_flush (ctr_heat_cache_t *cache)
+{
+        int ret = -1;
+
+        GF_VALIDATE_OR_GOTO ("ctr", cache, out);
+
+        pthread_mutex_lock (&cache->flush_lock);
+        {
+                ret = __ctr_heat_cache_flush (cache);
+        }
+        pthread_mutex_unlock (&cache->flush_lock);
+out:
+        return ret;
+}
+
+static void *
+ctr_heat_cache_flusher (void *data)
+{
+        ctr_heat_cache_t *cache = data;
+        struct timespec   ts    = {0, };
+
+        THIS = cache->this;
+
+        pthread_mutex_lock (&cache->flush_lock);
+        while (!cache->fini) {
+                if (!cache->flush_wanted) {
+                        clock_gettime (CLOCK_REALTIME, &ts);
+                        ts.tv_sec += cache->flush_interval;
+                        pthread_cond_timedwait (&cache->flush_cond,
+                                                &cache->flush_lock, &ts);
+                }
+                cache->flush_wanted = _gf_false;
+
+                if (cache->fini)
+                        break;
+
+                __ctr_heat_cache_flush (cache);
+        }
+        pthread_mutex_unlock (&cache->flush_lock);
+
+        return NULL;
+}
+
+ctr_heat_cache_t *
+ctr_heat_cache_new (xlator_t *this, gfdb_conn_node_t *db_conn,
+                    uint64_t max_entries, uint32_t flush_interval)
+{
+        ctr_heat_cache_t *cache = NULL;
+        int               i     = 0;
+        int               j     = 0;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_ctr_mt_heat_cache_t);
+        if (!cache)
+                goto out;
+
+        cache->this = this;
+        cache->db_conn = db_conn;
+        cache->max_entries = max_entries;
+        cache->flush_interval = flush_interval;
+
+        for (i = 0; i < CTR_HEAT_CACHE_STRIPES; i++) {
+                LOCK_INIT (&cache->stripes[i].lock);
+                for (j = 0; j < CTR_HEAT_CACHE_BUCKETS; j++)
+                        INIT_LIST_HEAD (&cache->stripes[i].buckets[j]);
+        }
+
+        pthread_mutex_init (&cache->flush_lock, NULL);
+        pthread_cond_init (&cache->flush_cond, NULL);
+
+        if (gf_thread_create (&cache->flusher, NULL, ctr_heat_cache_flusher,
+                              cache)) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        CTR_MSG_HEAT_CACHE_INIT_FAILED,
+                        "Failed creating the heat cache flush thread");
+                goto err;
+        }
+
+out:
+        return cache;
+err:
+        pthread_cond_destroy (&cache->flush_cond);
+        pthread_mutex_destroy (&cache->flush_lock);
+        for (i = 0; i < CTR_HEAT_CACHE_STRIPES; i++)
+                LOCK_DESTROY (&cache->stripes[i].lock);
+        GF_FREE (cache);
+        return NULL;
+}
+
+void
+ctr_heat_cache_destroy (ctr_heat_cache_t *cache)
+{
+        int i = 0;
+
+        if (!cache)
+                return;
+
+        pthread_mutex_lock (&cache->flush_lock);
+        {
+                cache->fini = _gf_true;
+                pthread_cond_signal (&cache->flush_cond);
+        }
+        pthread_mutex_unlock (&cache->flush_lock);
+
+        pthread_join (cache->flusher, NULL);
+
+        /* Whatever was gathered since the last flush */
+        __ctr_heat_cache_flush (cache);
+
+        pthread_cond_destroy (&cache->flush_cond);
+        pthread_mutex_destroy (&cache->flush_lock);
+        for (i = 0; i < CTR_HEAT_CACHE_STRIPES; i++)
+                LOCK_DESTROY (&cache->stripes[i].lock);
+        GF_FREE (cache);
+}
+
+void
+ctr_heat_cache_reconfigure (ctr_heat_cache_t *cache, uint64_t max_entries,
+                            uint32_t flush_interval)
+{
+        GF_VALIDATE_OR_GOTO ("ctr", cache, out);
+
+        pthread_mutex_lock (&cache->flush_lock);
+        {
+                cache->max_entries = max_entries;
+                /* a new interval is waited for after the next flush */
+                cache->flush_interval = flush_interval;
+        }
+        pthread_mutex_unlock (&cache->flush_lock);
+out:
+        return;
+}
+
+void
+ctr_heat_cache_dump (ctr_heat_cache_t *cache)
+{
+        if (!cache)
+                return;
+
+        gf_proc_dump_write ("heat-cache-entries", "%"PRIu64, cache->entries);
+        gf_proc_dump_write ("heat-cache-size", "%"PRIu64,
+                            cache->max_entries);
+        gf_proc_dump_write ("flush-interval", "%"PRIu32,
+                            cache->flush_interval);
+        gf_proc_dump_write ("heat-recorded", "%"PRIu64, cache->recorded);
+        gf_proc_dump_write ("heat-merged", "%"PRIu64, cache->merged);
+        gf_proc_dump_write ("heat-overflows", "%"PRIu64, cache->overflows);
+        gf_proc_dump_write ("flushes", "%"PRIu64, cache->flushes);
+        gf_proc_dump_write ("flushed", "%"PRIu64, cache->flushed);
+        gf_proc_dump_write ("flush-failures", "%"PRIu64,
+                            cache->flush_failures);
+        gf_proc_dump_write ("last-flush-usec", "%"PRIu64,
+                            cache->last_flush_usec);
+        gf_proc_dump_write ("max-flush-usec", "%"PRIu64,
+                            cache->max_flush_usec);
+}
@@ -0,0 +1,109 @@
+/*
+   Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#ifndef __CTR_HEAT_CACHE_H
+#define __CTR_HEAT_CACHE_H
+
+#include "xlator.h"
+#include "ctr_mem_types.h"
+#include "glusterfs.h"
+#include "logging.h"
+#include "locking.h"
+#include "common-utils.h"
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "gfdb_data_store.h"
+
+#define CTR_HEAT_CACHE_STRIPES          64
+#define CTR_HEAT_CACHE_BUCKETS          256 /* per stripe */
+
+#define CTR_DEFAULT_FLUSH_INTERVAL      5      /* secs */
+#define CTR_DEFAULT_HEAT_CACHE_SIZE     65536  /* inodes */
+
+/*
+ * With the db written asynchronously the heat of inode fops is not written
+ * to the db by the fop itself. It is merged by gfid in the heat cache: the
+ * latest wind/unwind times and the number of reads and writes since the
+ * last flush. A flush thread writes the whole cache to the db in a single
+ * transaction every flush_interval, or sooner when the cache fills up. The
+ * cache is also flushed before the db is queried or its heat is cleared,
+ * and when the xlator goes down.
+ *
+ * Dentry fops, which create/delete the records and links of the db, are
+ * still recorded synchronously, so a crash can only lose the heat gathered
+ * since the last flush, never a record. A flush is a single sqlite
+ * transaction, on a crash in the middle of it the db comes back as it was
+ * before the flush.
+ * */
+typedef struct ctr_heat_entry {
+        struct list_head        list;
+        gfdb_heat_record_t      heat;
+} ctr_heat_entry_t;
+
+typedef struct ctr_heat_stripe {
+        gf_lock_t               lock;
+        struct list_head        buckets[CTR_HEAT_CACHE_BUCKETS];
+} ctr_heat_stripe_t;
+
+typedef struct ctr_heat_cache {
+        xlator_t                *this;
+        gfdb_conn_node_t        *db_conn;
+        ctr_heat_stripe_t       stripes[CTR_HEAT_CACHE_STRIPES];
+        /* Number of inodes in the cache and the limit of it, fops on new
+         * inodes beyond the limit are recorded synchronously */
+        uint64_t                entries;
+        uint64_t                max_entries;
+        uint32_t                flush_interval;
+
+        /* Held for the whole of a flush so that an older flush does not
+         * overwrite the times written by a newer one */
+        pthread_mutex_t         flush_lock;
+        pthread_cond_t          flush_cond;
+        pthread_t               flusher;
+        gf_boolean_t            flush_wanted;
+        gf_boolean_t            fini;
+
+        /* Statistics */
+        uint64_t                recorded;
+        uint64_t                merged;
+        uint64_t                overflows;
+        uint64_t                overflows_logged;
+        uint64_t                flushes;
+        uint64_t                flushed;
+        uint64_t                flush_failures;
+        uint64_t                last_flush_usec;
+        uint64_t                max_flush_usec;
+} ctr_heat_cache_t;
+
+
+ctr_heat_cache_t *
+ctr_heat_cache_new (xlator_t *this, gfdb_conn_node_t *db_conn,
+                    uint64_t max_entries, uint32_t flush_interval);
+
+void
+ctr_heat_cache_destroy (ctr_heat_cache_t *cache);
+
+/* Returns 0 if the heat of the record was merged in the cache, -1 if the
+ * record has to be inserted in the db synchronously */
+int
+ctr_heat_cache_record (ctr_heat_cache_t *cache, gfdb_db_record_t *record);
+
+int
+ctr_heat_cache_flush (ctr_heat_cache_t *cache);
+
+void
+ctr_heat_cache_reconfigure (ctr_heat_cache_t *cache, uint64_t max_entries,
+                            uint32_t flush_interval);
+
+void
+ctr_heat_cache_dump (ctr_heat_cache_t *cache);
+
+#endif
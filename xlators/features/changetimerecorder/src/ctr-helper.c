@@ -301,6 +301,13 @@ int extract_ctr_options (xlator_t *this, gf_ctr_private_t *_priv) {
         GF_OPTION_INIT ("db-sync", _val_str, str, out);
         _priv->gfdb_sync_type = gf_string2gfdbdbsync(_val_str);
 
+        /*Extract the heat cache size and flush interval for async mode*/
+        GF_OPTION_INIT ("ctr-heat-cache-size", _priv->ctr_heat_cache_size,
+                        uint64, out);
+
+        GF_OPTION_INIT ("ctr-flush-interval", _priv->ctr_flush_interval,
+                        uint32, out);
+
         ret = 0;
 
 out:
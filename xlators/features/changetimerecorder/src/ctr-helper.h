@@ -25,6 +25,7 @@
 
 #include "gfdb_data_store.h"
 #include "ctr-xlator-ctx.h"
+#include "ctr-heat-cache.h"
 #include "ctr-messages.h"
 
 #define CTR_DEFAULT_HARDLINK_EXP_PERIOD 300  /* Five mins */
@@ -52,6 +53,10 @@ typedef struct gf_ctr_private {
         gfdb_conn_node_t                *_db_conn;
         uint64_t                        ctr_lookupheal_link_timeout;
         uint64_t                        ctr_lookupheal_inode_timeout;
+        /* Heat of inode fops aggregated in memory with db-sync async */
+        ctr_heat_cache_t                *heat_cache;
+        uint64_t                        ctr_heat_cache_size;
+        uint32_t                        ctr_flush_interval;
 } gf_ctr_private_t;
 
 
@@ -432,6 +437,21 @@ fill_db_record_for_wind (xlator_t                *this,
                         gf_ctr_local_t          *ctr_local,
                         gf_ctr_inode_context_t  *ctr_inode_cx);
 
+/*
+ * With db-sync async the heat of inode fops is merged in the heat cache and
+ * written to the db by its flush thread. Dentry fops, and fops on new inodes
+ * while the cache is full, are written to the db right away.
+ * */
+static inline int
+ctr_insert_record (gf_ctr_private_t *_priv, gfdb_db_record_t *db_record)
+{
+        if (_priv->gfdb_sync_type == GFDB_DB_ASYNC && _priv->heat_cache &&
+            ctr_heat_cache_record (_priv->heat_cache, db_record) == 0)
+                return 0;
+
+        return insert_record (_priv->_db_conn, db_record);
+}
+
 /*******************************************************************************
  *                              CTR INSERT WIND
  * *****************************************************************************
@@ -529,8 +549,7 @@ ctr_insert_wind (call_frame_t                    *frame,
                 }
 
                 /*Insert the db record*/
-                ret = insert_record (_priv->_db_conn,
-                                &ctr_local->gfdb_db_record);
+                ret = ctr_insert_record (_priv, &ctr_local->gfdb_db_record);
                 if (ret) {
                         gf_msg (this->name, GF_LOG_ERROR, 0,
                                 CTR_MSG_INSERT_RECORD_WIND_FAILED,
@@ -595,8 +614,7 @@ ctr_insert_unwind (call_frame_t          *frame,
                         goto out;
                 }
 
-                ret = insert_record(_priv->_db_conn,
-                                        &ctr_local->gfdb_db_record);
+                ret = ctr_insert_record (_priv, &ctr_local->gfdb_db_record);
                 if (ret == -1) {
                         gf_msg(this->name, GF_LOG_ERROR, 0,
                                CTR_MSG_FILL_CTR_LOCAL_ERROR_UNWIND,
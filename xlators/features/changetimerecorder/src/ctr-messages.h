@@ -41,7 +41,7 @@
  */
 
 #define GLFS_COMP_BASE         GLFS_MSGID_COMP_CTR
-#define GLFS_NUM_MESSAGES       57
+#define GLFS_NUM_MESSAGES       60
 #define GLFS_MSGID_END          (GLFS_COMP_BASE + GLFS_NUM_MESSAGES + 1)
 /* Messaged with message IDs */
 #define glfs_msg_start_x GLFS_COMP_BASE, "Invalid: Start of messages"
@@ -496,6 +496,30 @@
  *
  */
 #define CTR_MSG_NULL_LOCAL                               (GLFS_COMP_BASE + 57)
+
+/*!
+ * @messageid
+ * @diagnosis
+ * @recommendedaction
+ *
+ */
+#define CTR_MSG_HEAT_CACHE_INIT_FAILED                   (GLFS_COMP_BASE + 58)
+
+/*!
+ * @messageid
+ * @diagnosis
+ * @recommendedaction
+ *
+ */
+#define CTR_MSG_HEAT_CACHE_FLUSH_FAILED                  (GLFS_COMP_BASE + 59)
+
+/*!
+ * @messageid
+ * @diagnosis
+ * @recommendedaction
+ *
+ */
+#define CTR_MSG_HEAT_CACHE_FULL                          (GLFS_COMP_BASE + 60)
 /*------------*/
 #define glfs_msg_end_x GLFS_MSGID_END, "Invalid: End of messages"
 
@@ -171,7 +171,7 @@ clrlk_clear_posixlk (xlator_t *this, pl_inode_t *pl_inode, clrlk_args *args,
                             || plock->user_flock.l_len != ulock.l_len))
                                 continue;
 
-                        list_del_init (&plock->list);
+                        __delete_lock (pl_inode, plock);
                         if (plock->blocked) {
                                 bcount++;
                                 pl_trace_out (this, plock->frame, NULL, NULL,
@@ -235,7 +235,7 @@ blkd:
 
                         bcount++;
                         list_del_init (&ilock->client_list);
-                        list_del_init (&ilock->blocked_locks);
+                        __pl_inodelk_unblock (ilock);
                         list_add (&ilock->blocked_locks, &released);
                 }
         }
@@ -270,7 +270,7 @@ granted:
 
                         gcount++;
                         list_del_init (&ilock->client_list);
-                        list_del_init (&ilock->list);
+                        __delete_inode_lock (ilock);
                         list_add (&ilock->list, &released);
                 }
         }
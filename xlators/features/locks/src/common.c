@@ -53,6 +53,8 @@ __allocate_domain (const char *volume)
         INIT_LIST_HEAD (&dom->blocked_entrylks);
         INIT_LIST_HEAD (&dom->inodelk_list);
         INIT_LIST_HEAD (&dom->blocked_inodelks);
+        itree_init (&dom->inodelk_tree);
+        itree_init (&dom->blocked_inodelk_tree);
 
 out:
         if (dom && (NULL == dom->domain)) {
@@ -428,6 +430,7 @@ pl_inode_get (xlator_t *this, inode_t *inode)
 
                 INIT_LIST_HEAD (&pl_inode->dom_list);
                 INIT_LIST_HEAD (&pl_inode->ext_list);
+                itree_init (&pl_inode->ext_tree);
                 INIT_LIST_HEAD (&pl_inode->rw_list);
                 INIT_LIST_HEAD (&pl_inode->reservelk_list);
                 INIT_LIST_HEAD (&pl_inode->blocked_reservelks);
@@ -492,6 +495,7 @@ new_posix_lock (struct gf_flock *flock, client_t *client, pid_t client_pid,
         lock->blocking  = blocking;
 
         INIT_LIST_HEAD (&lock->list);
+        itree_node_init (&lock->range);
 
 out:
         return lock;
@@ -500,8 +504,13 @@ out:
 
 /* Delete a lock from the inode's lock list */
 void
-__delete_lock (posix_lock_t *lock)
+__delete_lock (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
+        if (itree_node_linked (&lock->range))
+                itree_remove (&pl_inode->ext_tree, &lock->range);
+        else if (lock->blocked && !list_empty (&lock->list))
+                pl_inode->ext_blocked--;
+
         list_del_init (&lock->list);
 }
 
@@ -529,14 +538,21 @@ posix_lock_to_flock (posix_lock_t *lock, struct gf_flock *flock)
                 flock->l_len = lock->fl_end - lock->fl_start + 1;
 }
 
-/* Insert the lock into the inode's lock list */
-static void
+/* Insert the lock into the inode's lock list. Granted locks are also
+   indexed by range in ext_tree, which is what conflict checks walk. A lock
+   that goes back to waiting keeps the time it first blocked at. */
+void
 __insert_lock (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        if (lock->blocked)
-                gettimeofday (&lock->blkd_time, NULL);
-        else
+        if (lock->blocked) {
+                if (!timerisset (&lock->blkd_time))
+                        gettimeofday (&lock->blkd_time, NULL);
+                pl_inode->ext_blocked++;
+        } else {
                 gettimeofday (&lock->granted_time, NULL);
+                itree_insert (&pl_inode->ext_tree, &lock->range,
+                              lock->fl_start, lock->fl_end);
+        }
 
         list_add_tail (&lock->list, &pl_inode->ext_list);
 
@@ -570,22 +586,6 @@ same_owner (posix_lock_t *l1, posix_lock_t *l2)
 }
 
 
-/* Delete all F_UNLCK locks */
-void
-__delete_unlck_locks (pl_inode_t *pl_inode)
-{
-        posix_lock_t *l = NULL;
-        posix_lock_t *tmp = NULL;
-
-        list_for_each_entry_safe (l, tmp, &pl_inode->ext_list, list) {
-                if (l->fl_type == F_UNLCK) {
-                        __delete_lock (l);
-                        __destroy_lock (l);
-                }
-        }
-}
-
-
 /* Add two locks */
 static posix_lock_t *
 add_locks (posix_lock_t *l1, posix_lock_t *l2)
@@ -714,78 +714,101 @@ done:
         return v;
 }
 
+struct pl_overlap_search {
+        posix_lock_t *lock;
+        posix_lock_t *found;
+};
+
+
+static int
+__conflicting_overlap_fn (itree_node_t *node, void *data)
+{
+        struct pl_overlap_search *search = data;
+        posix_lock_t             *l      = NULL;
+
+        l = list_entry (node, posix_lock_t, range);
+
+        if (same_owner (l, search->lock))
+                return 0;
+
+        if ((l->fl_type == F_WRLCK) || (search->lock->fl_type == F_WRLCK)) {
+                search->found = l;
+                return 1;
+        }
+
+        return 0;
+}
+
+
+static posix_lock_t *
+__first_conflicting_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
+{
+        struct pl_overlap_search search = {0, };
+
+        search.lock = lock;
+
+        itree_walk_overlaps (&pl_inode->ext_tree, lock->fl_start,
+                             lock->fl_end, __conflicting_overlap_fn, &search);
+
+        return search.found;
+}
+
+
 static posix_lock_t *
 first_conflicting_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
         posix_lock_t *conf = NULL;
 
         pthread_mutex_lock (&pl_inode->mutex);
         {
-                list_for_each_entry (l, &pl_inode->ext_list, list) {
-                        if (l->blocked)
-                                continue;
-
-                        if (locks_overlap (l, lock)) {
-                                if (same_owner (l, lock))
-                                        continue;
-
-                                if ((l->fl_type == F_WRLCK) ||
-                                    (lock->fl_type == F_WRLCK)) {
-                                        conf = l;
-                                        goto unlock;
-                                }
-                        }
-                }
+                conf = __first_conflicting_overlap (pl_inode, lock);
         }
-unlock:
         pthread_mutex_unlock (&pl_inode->mutex);
 
         return conf;
 }
 
 /*
-  Start searching from {begin}, and return the first lock that
-  conflicts, NULL if no conflict
-  If {begin} is NULL, then start from the beginning of the list
+  Return the first granted lock that overlaps {lock}, NULL if there is none
 */
 static posix_lock_t *
 first_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
+        itree_node_t *node = NULL;
 
-        list_for_each_entry (l, &pl_inode->ext_list, list) {
-                if (l->blocked)
-                        continue;
-
-                if (locks_overlap (l, lock))
-                        return l;
-        }
+        node = itree_first_overlap (&pl_inode->ext_tree, lock->fl_start,
+                                    lock->fl_end);
+        if (!node)
+                return NULL;
 
-        return NULL;
+        return list_entry (node, posix_lock_t, range);
 }
 
 
+static int
+__same_owner_overlap_fn (itree_node_t *node, void *data)
+{
+        struct pl_overlap_search *search = data;
+        posix_lock_t             *l      = NULL;
+
+        l = list_entry (node, posix_lock_t, range);
+
+        if (!same_owner (l, search->lock))
+                return 0;
+
+        search->found = l;
+        return 1;
+}
+
 
 /* Return true if lock is grantable */
 static int
 __is_lock_grantable (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
-        int           ret = 1;
-
-        list_for_each_entry (l, &pl_inode->ext_list, list) {
-                if (!l->blocked && locks_overlap (lock, l)) {
-                        if (((l->fl_type == F_WRLCK)
-                             || (lock->fl_type == F_WRLCK))
-                            && (lock->fl_type != F_UNLCK)
-                            && !same_owner (l, lock)) {
-                                ret = 0;
-                                break;
-                        }
-                }
-        }
-        return ret;
+        if (lock->fl_type == F_UNLCK)
+                return 1;
+
+        return (__first_conflicting_overlap (pl_inode, lock) == NULL);
 }
 
 
@@ -796,88 +819,81 @@ static void
 __insert_and_merge (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
         posix_lock_t  *conf = NULL;
-        posix_lock_t  *t = NULL;
         posix_lock_t  *sum = NULL;
         int            i = 0;
         struct _values v = { .locks = {0, 0, 0} };
         client_t      *client = NULL;
+        struct pl_overlap_search search = {0, };
+
+        /* only granted locks of the same owner are merged with or split
+           by @lock, locks of other owners it overlaps are compatible with
+           it or it would not have been granted */
+        search.lock = lock;
+        itree_walk_overlaps (&pl_inode->ext_tree, lock->fl_start,
+                             lock->fl_end, __same_owner_overlap_fn, &search);
+        conf = search.found;
+
+        if (conf) {
+                if (conf->fl_type == lock->fl_type &&
+                                conf->lk_flags == lock->lk_flags) {
+                        sum = add_locks (lock, conf);
+
+                        sum->fl_type    = lock->fl_type;
+                        sum->client     = lock->client;
+                        client          = sum->client;
+                        sum->client_uid =
+                                 gf_strdup (client->client_uid);
+                        sum->fd_num     = lock->fd_num;
+                        sum->client_pid = lock->client_pid;
+                        sum->owner      = lock->owner;
+                        sum->lk_flags   = lock->lk_flags;
+
+                        __delete_lock (pl_inode, conf);
+                        __destroy_lock (conf);
+
+                        __destroy_lock (lock);
+                        INIT_LIST_HEAD (&sum->list);
+                        itree_node_init (&sum->range);
+                        posix_lock_to_flock (sum, &sum->user_flock);
+                        __insert_and_merge (pl_inode, sum);
 
-        list_for_each_entry_safe (conf, t, &pl_inode->ext_list, list) {
-                if (conf->blocked)
-                        continue;
-                if (!locks_overlap (conf, lock))
-                        continue;
-
-                if (same_owner (conf, lock)) {
-                        if (conf->fl_type == lock->fl_type &&
-                                        conf->lk_flags == lock->lk_flags) {
-                                sum = add_locks (lock, conf);
-
-                                sum->fl_type    = lock->fl_type;
-                                sum->client     = lock->client;
-                                client          = sum->client;
-                                sum->client_uid =
-                                         gf_strdup (client->client_uid);
-                                sum->fd_num     = lock->fd_num;
-                                sum->client_pid = lock->client_pid;
-                                sum->owner      = lock->owner;
-                                sum->lk_flags   = lock->lk_flags;
-
-                                __delete_lock (conf);
-                                __destroy_lock (conf);
-
-                                __destroy_lock (lock);
-                                INIT_LIST_HEAD (&sum->list);
-                                posix_lock_to_flock (sum, &sum->user_flock);
-                                __insert_and_merge (pl_inode, sum);
-
-                                return;
-                        } else {
-                                sum = add_locks (lock, conf);
-
-                                sum->fl_type    = conf->fl_type;
-                                sum->client     = conf->client;
-                                client          = sum->client;
-                                sum->client_uid =
-                                         gf_strdup (client->client_uid);
-
-                                sum->fd_num     = conf->fd_num;
-                                sum->client_pid = conf->client_pid;
-                                sum->owner      = conf->owner;
-                                sum->lk_flags   = conf->lk_flags;
-
-                                v = subtract_locks (sum, lock);
-
-                                __delete_lock (conf);
-                                __destroy_lock (conf);
-
-                                __delete_lock (lock);
-                                __destroy_lock (lock);
-
-                                __destroy_lock (sum);
-
-                                for (i = 0; i < 3; i++) {
-                                        if (!v.locks[i])
-                                                continue;
-
-                                        INIT_LIST_HEAD (&v.locks[i]->list);
-                                        posix_lock_to_flock (v.locks[i],
-                                                       &v.locks[i]->user_flock);
-                                        __insert_and_merge (pl_inode,
-                                                            v.locks[i]);
-                                }
-
-                                __delete_unlck_locks (pl_inode);
-                                return;
-                        }
-                }
+                        return;
+                } else {
+                        sum = add_locks (lock, conf);
 
-                if (lock->fl_type == F_UNLCK) {
-                        continue;
-                }
+                        sum->fl_type    = conf->fl_type;
+                        sum->client     = conf->client;
+                        client          = sum->client;
+                        sum->client_uid =
+                                 gf_strdup (client->client_uid);
+
+                        sum->fd_num     = conf->fd_num;
+                        sum->client_pid = conf->client_pid;
+                        sum->owner      = conf->owner;
+                        sum->lk_flags   = conf->lk_flags;
+
+                        v = subtract_locks (sum, lock);
+
+                        __delete_lock (pl_inode, conf);
+                        __destroy_lock (conf);
+
+                        __delete_lock (pl_inode, lock);
+                        __destroy_lock (lock);
+
+                        __destroy_lock (sum);
+
+                        for (i = 0; i < 3; i++) {
+                                if (!v.locks[i])
+                                        continue;
+
+                                INIT_LIST_HEAD (&v.locks[i]->list);
+                                itree_node_init (&v.locks[i]->range);
+                                posix_lock_to_flock (v.locks[i],
+                                               &v.locks[i]->user_flock);
+                                __insert_and_merge (pl_inode,
+                                                    v.locks[i]);
+                        }
 
-                if ((conf->fl_type == F_RDLCK) && (lock->fl_type == F_RDLCK)) {
-                        __insert_lock (pl_inode, lock);
                         return;
                 }
         }
@@ -901,6 +917,9 @@ __grant_blocked_locks (xlator_t *this, pl_inode_t *pl_inode, struct list_head *g
 
         INIT_LIST_HEAD (&tmp_list);
 
+        if (!pl_inode->ext_blocked)
+                return;
+
         list_for_each_entry_safe (l, tmp, &pl_inode->ext_list, list) {
                 if (l->blocked) {
                         conf = first_overlap (pl_inode, l);
@@ -908,6 +927,7 @@ __grant_blocked_locks (xlator_t *this, pl_inode_t *pl_inode, struct list_head *g
                                 continue;
 
                         l->blocked = 0;
+                        pl_inode->ext_blocked--;
                         list_move_tail (&l->list, &tmp_list);
                 }
         }
@@ -60,7 +60,9 @@ locks_overlap (posix_lock_t *l1, posix_lock_t *l2);
 int
 same_owner (posix_lock_t *l1, posix_lock_t *l2);
 
-void __delete_lock (posix_lock_t *);
+void __delete_lock (pl_inode_t *, posix_lock_t *);
+
+void __insert_lock (pl_inode_t *, posix_lock_t *);
 
 void __destroy_lock (posix_lock_t *);
 
@@ -74,6 +76,9 @@ grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
 void
 __delete_inode_lock (pl_inode_lock_t *lock);
 
+void
+__pl_inodelk_unblock (pl_inode_lock_t *lock);
+
 void
 __pl_inodelk_unref (pl_inode_lock_t *lock);
 
@@ -22,9 +22,36 @@
 void
 __delete_inode_lock (pl_inode_lock_t *lock)
 {
+        if (itree_node_linked (&lock->range))
+                itree_remove (&lock->dom->inodelk_tree, &lock->range);
+
         list_del_init (&lock->list);
 }
 
+/* Queue @lock on the blocked list of @dom, the time it first blocked at is
+ * kept across the grant passes that put it back on the list */
+static void
+__pl_inodelk_block (pl_dom_list_t *dom, pl_inode_lock_t *lock)
+{
+        if (!timerisset (&lock->blkd_time))
+                gettimeofday (&lock->blkd_time, NULL);
+
+        lock->dom = dom;
+        list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+        itree_insert (&dom->blocked_inodelk_tree, &lock->blocked_range,
+                      lock->fl_start, lock->fl_end);
+}
+
+void
+__pl_inodelk_unblock (pl_inode_lock_t *lock)
+{
+        if (itree_node_linked (&lock->blocked_range))
+                itree_remove (&lock->dom->blocked_inodelk_tree,
+                              &lock->blocked_range);
+
+        list_del_init (&lock->blocked_locks);
+}
+
 static void
 __pl_inodelk_ref (pl_inode_lock_t *lock)
 {
@@ -157,6 +184,25 @@ __stale_inodelk (xlator_t *this, pl_inode_lock_t *candidate_lock,
         return _gf_false;
 }
 
+struct pl_inodelk_search {
+        xlator_t        *this;
+        pl_inode_lock_t *lock;
+        pl_inode_lock_t *found;
+        time_t           age;
+};
+
+static int
+__stale_inodelk_fn (itree_node_t *node, void *data)
+{
+        struct pl_inodelk_search *search = data;
+        pl_inode_lock_t          *lk     = NULL;
+
+        lk = list_entry (node, pl_inode_lock_t, range);
+
+        return (__stale_inodelk (search->this, lk, search->lock,
+                                 &search->age) == _gf_true);
+}
+
 /* Examine any locks held on this inode and potentially revoke the lock
  * if the age exceeds revocation_secs.  We will clear _only_ those locks
  * which are granted, and then grant those locks which are blocked.
@@ -181,6 +227,7 @@ __inodelk_prune_stale (xlator_t *this, pl_inode_t *pinode, pl_dom_list_t *dom,
         time_t lk_age_sec = 0;
         uint32_t max_blocked = 0;
         char *reason_str = NULL;
+        struct pl_inodelk_search stale = {0, };
 
         priv = this->private;
 
@@ -194,13 +241,14 @@ __inodelk_prune_stale (xlator_t *this, pl_inode_t *pinode, pl_dom_list_t *dom,
                 goto out;
 
         pthread_mutex_lock (&pinode->mutex);
-        list_for_each_entry_safe (lk, tmp, &dom->inodelk_list, list) {
-                if (__stale_inodelk (this, lk, lock, &lk_age_sec) == _gf_true) {
-                        revoke_lock = _gf_true;
-                        reason_str = "age";
-                        break;
-                }
+        stale.this = this;
+        stale.lock = lock;
+        if (itree_walk_overlaps (&dom->inodelk_tree, lock->fl_start,
+                                 lock->fl_end, __stale_inodelk_fn, &stale)) {
+                revoke_lock = _gf_true;
+                reason_str = "age";
         }
+        lk_age_sec = stale.age;
 
         max_blocked = priv->revocation_max_blocked;
         if (max_blocked != 0 && revoke_lock == _gf_false) {
@@ -230,43 +278,62 @@ out:
         return revoke_lock;
 }
 
+static int
+__granted_conflict_fn (itree_node_t *node, void *data)
+{
+        struct pl_inodelk_search *search = data;
+        pl_inode_lock_t          *l      = NULL;
+
+        l = list_entry (node, pl_inode_lock_t, range);
+
+        if (inodelk_type_conflict (search->lock, l) &&
+            !same_inodelk_owner (search->lock, l)) {
+                search->found = l;
+                return 1;
+        }
+
+        return 0;
+}
+
 /* Determine if lock is grantable or not */
 static pl_inode_lock_t *
 __inodelk_grantable (pl_dom_list_t *dom, pl_inode_lock_t *lock)
 {
-        pl_inode_lock_t *l = NULL;
-        pl_inode_lock_t *ret = NULL;
-        if (list_empty (&dom->inodelk_list))
-                goto out;
-        list_for_each_entry (l, &dom->inodelk_list, list){
-                if (inodelk_conflict (lock, l) &&
-                    !same_inodelk_owner (lock, l)) {
-                        ret = l;
-                        goto out;
-                }
+        struct pl_inodelk_search search = {0, };
+
+        search.lock = lock;
+        itree_walk_overlaps (&dom->inodelk_tree, lock->fl_start,
+                             lock->fl_end, __granted_conflict_fn, &search);
+
+        return search.found;
+}
+
+static int
+__blocked_conflict_fn (itree_node_t *node, void *data)
+{
+        struct pl_inodelk_search *search = data;
+        pl_inode_lock_t          *l      = NULL;
+
+        l = list_entry (node, pl_inode_lock_t, blocked_range);
+
+        if (inodelk_type_conflict (search->lock, l)) {
+                search->found = l;
+                return 1;
         }
-out:
-        return ret;
+
+        return 0;
 }
 
 static pl_inode_lock_t *
 __blocked_lock_conflict (pl_dom_list_t *dom, pl_inode_lock_t *lock)
 {
-        pl_inode_lock_t *l   = NULL;
-        pl_inode_lock_t *ret = NULL;
+        struct pl_inodelk_search search = {0, };
 
-        if (list_empty (&dom->blocked_inodelks))
-                return NULL;
+        search.lock = lock;
+        itree_walk_overlaps (&dom->blocked_inodelk_tree, lock->fl_start,
+                             lock->fl_end, __blocked_conflict_fn, &search);
 
-        list_for_each_entry (l, &dom->blocked_inodelks, blocked_locks) {
-                if (inodelk_conflict (lock, l)) {
-                        ret = l;
-                        goto out;
-                }
-        }
-
-out:
-        return ret;
+        return search.found;
 }
 
 static int
@@ -304,8 +371,7 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
                 if (can_block == 0)
                         goto out;
 
-                gettimeofday (&lock->blkd_time, NULL);
-                list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+                __pl_inodelk_block (dom, lock);
 
                 gf_log (this->name, GF_LOG_TRACE,
                         "%s (pid=%d) lk-owner:%s %"PRId64" - %"PRId64" => Blocked",
@@ -336,8 +402,7 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
                 if (can_block == 0)
                         goto out;
 
-                gettimeofday (&lock->blkd_time, NULL);
-                list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+                __pl_inodelk_block (dom, lock);
 
                 gf_log (this->name, GF_LOG_DEBUG,
                         "Lock is grantable, but blocking to prevent starvation");
@@ -354,7 +419,10 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
         }
         __pl_inodelk_ref (lock);
         gettimeofday (&lock->granted_time, NULL);
+        lock->dom = dom;
         list_add (&lock->list, &dom->inodelk_list);
+        itree_insert (&dom->inodelk_tree, &lock->range, lock->fl_start,
+                      lock->fl_end);
 
         ret = 0;
 
@@ -374,16 +442,33 @@ inodelks_equal (pl_inode_lock_t *l1, pl_inode_lock_t *l2)
 }
 
 
+static int
+__matching_inodelk_fn (itree_node_t *node, void *data)
+{
+        struct pl_inodelk_search *search = data;
+        pl_inode_lock_t          *l      = NULL;
+
+        l = list_entry (node, pl_inode_lock_t, range);
+
+        if (inodelks_equal (l, search->lock) &&
+            same_inodelk_owner (l, search->lock)) {
+                search->found = l;
+                return 1;
+        }
+
+        return 0;
+}
+
 static pl_inode_lock_t *
 find_matching_inodelk (pl_inode_lock_t *lock, pl_dom_list_t *dom)
 {
-        pl_inode_lock_t *l = NULL;
-        list_for_each_entry (l, &dom->inodelk_list, list) {
-                if (inodelks_equal (l, lock) &&
-                    same_inodelk_owner (l, lock))
-                        return l;
-        }
-        return NULL;
+        struct pl_inodelk_search search = {0, };
+
+        search.lock = lock;
+        itree_walk_overlaps (&dom->inodelk_tree, lock->fl_start,
+                             lock->fl_end, __matching_inodelk_fn, &search);
+
+        return search.found;
 }
 
 /* Set F_UNLCK removes a lock which has the exact same lock boundaries
@@ -429,9 +514,15 @@ __grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
         INIT_LIST_HEAD (&blocked_list);
         list_splice_init (&dom->blocked_inodelks, &blocked_list);
 
+        /* every blocked lock is taken off the queue and tried again in
+         * order, the ones that still wait go back behind those that were
+         * tried before them */
+        itree_init (&dom->blocked_inodelk_tree);
+
         list_for_each_entry_safe (bl, tmp, &blocked_list, blocked_locks) {
 
                 list_del_init (&bl->blocked_locks);
+                itree_node_init (&bl->blocked_range);
 
                 bl_ret = __lock_inodelk (this, pl_inode, bl, 1, dom);
 
@@ -563,7 +654,7 @@ pl_inodelk_client_cleanup (xlator_t *this, pl_ctx_t *ctx)
                                         list_add_tail (&l->client_list,
                                                        &released);
                                 } else {
-                                        list_del_init(&l->blocked_locks);
+                                        __pl_inodelk_unblock (l);
                                         list_add_tail (&l->client_list,
                                                        &unwind);
                                 }
@@ -772,6 +863,8 @@ new_inode_lock (struct gf_flock *flock, client_t *client, pid_t client_pid,
         INIT_LIST_HEAD (&lock->list);
         INIT_LIST_HEAD (&lock->blocked_locks);
 	INIT_LIST_HEAD (&lock->client_list);
+        itree_node_init (&lock->range);
+        itree_node_init (&lock->blocked_range);
         __pl_inodelk_ref (lock);
 
         return lock;
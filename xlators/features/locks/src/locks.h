@@ -15,6 +15,7 @@
 #include "call-stub.h"
 #include "locks-mem-types.h"
 #include "client_t.h"
+#include "interval-tree.h"
 
 #include "lkowner.h"
 
@@ -40,6 +41,8 @@ struct __posix_lock {
         xlator_t          *this;       /* required for blocked locks */
         unsigned long      fd_num;
 
+        itree_node_t       range;      /* in pl_inode->ext_tree while granted */
+
         fd_t              *fd;
         call_frame_t      *frame;
 
@@ -72,6 +75,10 @@ struct __pl_inode_lock {
         struct list_head   blocked_locks; /* list_head pointing to blocked_inodelks */
         int                ref;
 
+        itree_node_t       range;         /* in dom->inodelk_tree */
+        itree_node_t       blocked_range; /* in dom->blocked_inodelk_tree */
+        struct __pl_dom_list_t *dom;      /* domain the lock was queued in */
+
         short              fl_type;
         off_t              fl_start;
         off_t              fl_end;
@@ -114,6 +121,8 @@ struct __pl_dom_list_t {
         struct list_head   blocked_entrylks; /* List of all blocked entrylks */
         struct list_head   inodelk_list;     /* List of inode locks */
         struct list_head   blocked_inodelks; /* List of all blocked inodelks */
+        itree_t            inodelk_tree;     /* inodelk_list by range */
+        itree_t            blocked_inodelk_tree; /* blocked_inodelks by range */
 };
 typedef struct __pl_dom_list_t pl_dom_list_t;
 
@@ -153,6 +162,8 @@ struct __pl_inode {
 
         struct list_head dom_list;       /* list of domains */
         struct list_head ext_list;       /* list of fcntl locks */
+        itree_t          ext_tree;       /* granted fcntl locks by range */
+        int              ext_blocked;    /* blocked locks on ext_list */
         struct list_head rw_list;        /* list of waiting r/w requests */
         struct list_head reservelk_list;        /* list of reservelks */
         struct list_head blocked_reservelks;        /* list of blocked reservelks */
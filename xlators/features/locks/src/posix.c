@@ -934,11 +934,11 @@ delete_locks_of_fd (xlator_t *this, pl_inode_t *pl_inode, fd_t *fd)
 
                list_for_each_entry_safe (l, tmp, &pl_inode->ext_list, list) {
                        if (l->fd_num == fd_to_fdnum(fd)) {
+                               __delete_lock (pl_inode, l);
                                if (l->blocked) {
-                                       list_move_tail (&l->list, &blocked_list);
+                                       list_add_tail (&l->list, &blocked_list);
                                        continue;
                                }
-                               __delete_lock (l);
                                __destroy_lock (l);
                        }
                }
@@ -983,7 +983,7 @@ __delete_locks_of_owner (pl_inode_t *pl_inode,
                                 l->user_flock.l_len,
                                 l->blocked == 1 ? "Blocked" : "Active");
 
-                        __delete_lock (l);
+                        __delete_lock (pl_inode, l);
                         __destroy_lock (l);
                 }
         }
@@ -1813,32 +1813,51 @@ do_blocked_rw (pl_inode_t *pl_inode)
         return;
 }
 
+struct pl_rw_search {
+        posix_lock_t          *region;
+        glusterfs_fop_t        op;
+        posix_locks_private_t *priv;
+};
+
+static int
+__rw_conflict_fn (itree_node_t *node, void *data)
+{
+        struct pl_rw_search *search = data;
+        posix_lock_t        *l      = NULL;
+
+        l = list_entry (node, posix_lock_t, range);
+
+        if (same_owner (l, search->region))
+                return 0;
+
+        if ((search->op == GF_FOP_READ) && (l->fl_type != F_WRLCK))
+                return 0;
+
+        /* Check for mandatory lock under optimal
+         * mandatory-locking mode */
+        if (search->priv->mandatory_mode == MLK_OPTIMAL
+                        && !(l->lk_flags & GF_LK_MANDATORY))
+                return 0;
+
+        return 1;
+}
+
 static int
 __rw_allowable (pl_inode_t *pl_inode, posix_lock_t *region,
                 glusterfs_fop_t op)
 {
-        posix_lock_t *l = NULL;
-        posix_locks_private_t *priv = NULL;
-        int           ret = 1;
+        struct pl_rw_search search = {0, };
 
-        priv = THIS->private;
+        search.region = region;
+        search.op     = op;
+        search.priv   = THIS->private;
 
-        list_for_each_entry (l, &pl_inode->ext_list, list) {
-                if (!l->blocked && locks_overlap (l, region)
-                                && !same_owner (l, region)) {
-                        if ((op == GF_FOP_READ) && (l->fl_type != F_WRLCK))
-                                continue;
-                        /* Check for mandatory lock under optimal
-                         * mandatory-locking mode */
-                        if (priv->mandatory_mode == MLK_OPTIMAL
-                                        && !(l->lk_flags & GF_LK_MANDATORY))
-                                continue;
-                        ret = 0;
-                        break;
-                }
-        }
+        /* only granted locks are in ext_tree */
+        if (itree_walk_overlaps (&pl_inode->ext_tree, region->fl_start,
+                                 region->fl_end, __rw_conflict_fn, &search))
+                return 0;
 
-        return ret;
+        return 1;
 }
 
 int
@@ -2496,7 +2515,7 @@ pl_forget (xlator_t *this,
                         list_for_each_entry_safe (ext_l, ext_tmp, &pl_inode->ext_list,
                                                   list) {
 
-                                __delete_lock (ext_l);
+                                __delete_lock (pl_inode, ext_l);
                                 if (ext_l->blocked) {
                                         list_add_tail (&ext_l->list, &posixlks_released);
                                         continue;
@@ -2974,7 +2993,7 @@ __unwind_blocked_locks (xlator_t *this, pl_inode_t *pl_inode,
                 if (!lock->blocking)
                         continue;
 
-                list_del_init (&lock->list);
+                __delete_lock (pl_inode, lock);
                 list_add_tail (&lock->list, tmp_list);
         }
 }
@@ -3171,6 +3190,29 @@ pl_dump_lock (char *str, int size, struct gf_flock *flock,
 
 }
 
+/* how long the lock that blocked at @oldest has been waiting, in seconds */
+static void
+pl_dump_longest_wait (const char *prefix, struct timeval *oldest)
+{
+        struct timeval now  = {0, };
+        struct timeval wait = {0, };
+        char           key[GF_DUMP_MAX_BUF_LEN] = {0,};
+
+        gettimeofday (&now, NULL);
+        timersub (&now, oldest, &wait);
+
+        gf_proc_dump_build_key (key, prefix, "longest-blocked-wait");
+        gf_proc_dump_write (key, "%ld.%06ld", (long) wait.tv_sec,
+                            (long) wait.tv_usec);
+}
+
+#define PL_TRACK_OLDEST(oldest, blkd_time)                              \
+        do {                                                            \
+                if (!timerisset (oldest) ||                             \
+                    timercmp (blkd_time, oldest, <))                    \
+                        *(oldest) = *(blkd_time);                       \
+        } while (0)
+
 void
 __dump_entrylks (pl_inode_t *pl_inode)
 {
@@ -3181,12 +3223,14 @@ __dump_entrylks (pl_inode_t *pl_inode)
         int              count = 0;
         char             key[GF_DUMP_MAX_BUF_LEN] = {0,};
         char            *k = "xlator.feature.locks.lock-dump.domain.entrylk";
+        struct timeval   oldest = {0, };
 
         char tmp[4098];
 
         list_for_each_entry (dom, &pl_inode->dom_list, inode_list) {
 
                 count = 0;
+                timerclear (&oldest);
 
                 gf_proc_dump_build_key(key,
                                        "lock-dump.domain",
@@ -3247,9 +3291,12 @@ __dump_entrylks (pl_inode_t *pl_inode)
 
                         gf_proc_dump_write(key, tmp);
 
+                        PL_TRACK_OLDEST (&oldest, &lock->blkd_time);
                         count++;
                 }
 
+                if (timerisset (&oldest))
+                        pl_dump_longest_wait (k, &oldest);
         }
 }
 
@@ -3271,12 +3318,14 @@ __dump_inodelks (pl_inode_t *pl_inode)
         pl_inode_lock_t *lock = NULL;
         int             count = 0;
         char            key[GF_DUMP_MAX_BUF_LEN];
+        struct timeval  oldest = {0, };
 
         char tmp[4098];
 
         list_for_each_entry (dom, &pl_inode->dom_list, inode_list) {
 
                 count = 0;
+                timerclear (&oldest);
 
                 gf_proc_dump_build_key(key,
                                        "lock-dump.domain",
@@ -3314,9 +3363,12 @@ __dump_inodelks (pl_inode_t *pl_inode)
                                       _gf_false);
                         gf_proc_dump_write(key, tmp);
 
+                        PL_TRACK_OLDEST (&oldest, &lock->blkd_time);
                         count++;
                 }
 
+                if (timerisset (&oldest))
+                        pl_dump_longest_wait ("inodelk", &oldest);
         }
 
 }
@@ -3338,6 +3390,7 @@ __dump_posixlks (pl_inode_t *pl_inode)
         posix_lock_t    *lock = NULL;
         int             count = 0;
         char            key[GF_DUMP_MAX_BUF_LEN];
+        struct timeval  oldest = {0, };
 
         char tmp[4098];
 
@@ -3355,8 +3408,13 @@ __dump_posixlks (pl_inode_t *pl_inode)
                             (lock->blocked)? _gf_false: _gf_true);
               gf_proc_dump_write(key, tmp);
 
+              if (lock->blocked)
+                      PL_TRACK_OLDEST (&oldest, &lock->blkd_time);
               count++;
         }
+
+        if (timerisset (&oldest))
+                pl_dump_longest_wait ("posixlk", &oldest);
 }
 
 void
@@ -3817,6 +3875,7 @@ gf_lkmig_info_to_posix_lock (call_frame_t *frame,
         lock->owner      = lmi->flock.l_owner;
 
         INIT_LIST_HEAD (&lock->list);
+        itree_node_init (&lock->range);
 
 out:
         return lock;
@@ -3865,7 +3924,7 @@ pl_write_active_locks (call_frame_t *frame, pl_inode_t *pl_inode,
                                 ret = -1;
                                 goto out;
                         }
-                        list_add_tail (&newlock->list, &pl_inode->ext_list);
+                        __insert_lock (pl_inode, newlock);
                 }
         }
 
@@ -22,6 +22,8 @@ enum gf_marker_mem_types_ {
         gf_marker_mt_inode_contribution_t,
         gf_marker_mt_quota_meta_t,
         gf_marker_mt_quota_synctask_t,
+        gf_marker_mt_quota_pending_txn_t,
+        gf_marker_mt_quota_txn_batch_t,
         gf_marker_mt_end
 };
 #endif
@@ -1690,6 +1690,429 @@ out:
         return 0;
 }
 
+static void
+mq_txn_destroy (quota_pending_txn_t *txn)
+{
+        if (!txn->released)
+                mq_set_ctx_updation_status (txn->ctx, _gf_false);
+
+        loc_wipe (&txn->loc);
+        loc_wipe (&txn->parent_loc);
+
+        if (txn->contri)
+                GF_REF_PUT (txn->contri);
+
+        GF_FREE (txn);
+}
+
+static quota_pending_txn_t *
+mq_txn_new (loc_t *loc, quota_inode_ctx_t *ctx)
+{
+        quota_pending_txn_t    *txn         = NULL;
+
+        txn = GF_CALLOC (1, sizeof (*txn), gf_marker_mt_quota_pending_txn_t);
+        if (txn == NULL)
+                goto out;
+
+        INIT_LIST_HEAD (&txn->list);
+        if (mq_loc_copy (&txn->loc, loc) < 0) {
+                GF_FREE (txn);
+                txn = NULL;
+                goto out;
+        }
+        txn->ctx = ctx;
+        gettimeofday (&txn->queued, NULL);
+out:
+        return txn;
+}
+
+static int
+mq_txn_fill_parent (xlator_t *this, quota_pending_txn_t *txn)
+{
+        int32_t                ret         = -1;
+
+        if (txn->loc.parent == NULL) {
+                ret = mq_build_ancestry (this, &txn->loc);
+                if (ret < 0 || txn->loc.parent == NULL) {
+                        gf_log (this->name,
+                                (-ret == ENOENT || -ret == ESTALE)
+                                ? GF_LOG_DEBUG:GF_LOG_ERROR,
+                                "build ancestry failed for inode %s",
+                                uuid_utoa (txn->loc.inode->gfid));
+                        return -1;
+                }
+        }
+
+        ret = mq_inode_loc_fill (NULL, txn->loc.parent, &txn->parent_loc);
+        if (ret < 0)
+                gf_log (this->name, GF_LOG_ERROR, "parent_loc fill failed "
+                        "for child inode %s", uuid_utoa (txn->loc.inode->gfid));
+
+        return ret;
+}
+
+/* Queue the update txn of the parent for the next level of the batch,
+ * unless one is already pending for it.
+ */
+static void
+mq_txn_queue_parent (xlator_t *this, loc_t *parent_loc,
+                     struct list_head *next)
+{
+        int32_t                ret         = -1;
+        gf_boolean_t           status      = _gf_true;
+        quota_inode_ctx_t     *ctx         = NULL;
+        quota_pending_txn_t   *txn         = NULL;
+
+        ret = mq_inode_ctx_get (parent_loc->inode, this, &ctx);
+        if (ret < 0)
+                return;
+
+        ret = mq_test_and_set_ctx_updation_status (ctx, &status);
+        if (ret < 0 || status == _gf_true)
+                return;
+
+        txn = mq_txn_new (parent_loc, ctx);
+        if (txn == NULL) {
+                mq_set_ctx_updation_status (ctx, _gf_false);
+                return;
+        }
+
+        list_add_tail (&txn->list, next);
+}
+
+static int
+mq_txn_get_contribution (xlator_t *this, quota_pending_txn_t *txn)
+{
+        inode_t               *tmp_parent  = NULL;
+
+        /* See mq_initiate_quota_task for when the contribution node
+         * has to be created here
+         */
+        txn->contri = mq_get_contribution_node (txn->loc.parent, txn->ctx);
+        if (txn->contri)
+                return 0;
+
+        tmp_parent = inode_parent (txn->loc.inode, 0, NULL);
+        if (tmp_parent == NULL) {
+                gf_log (this->name, GF_LOG_WARNING, "parent is NULL for "
+                        "inode %s", uuid_utoa (txn->loc.inode->gfid));
+                return -1;
+        }
+
+        if (gf_uuid_compare (tmp_parent->gfid, txn->parent_loc.gfid)) {
+                /* renamed meanwhile, skip it */
+                inode_unref (tmp_parent);
+                return -1;
+        }
+        inode_unref (tmp_parent);
+
+        txn->contri = mq_add_new_contribution_node (this, txn->ctx, &txn->loc);
+        if (txn->contri == NULL) {
+                gf_log (this->name, GF_LOG_ERROR, "Failed to create "
+                        "contribution node for %s", txn->loc.path);
+                return -1;
+        }
+
+        return 0;
+}
+
+/* Apply the deltas of all the children in @group to their common parent
+ * under a single lock, dirty mark and size update.
+ */
+static int
+mq_txn_update_parent (xlator_t *this, struct list_head *group,
+                      loc_t *parent_loc, struct list_head *next)
+{
+        int32_t                ret         = -1;
+        int32_t                prev_dirty  = 0;
+        gf_boolean_t           locked      = _gf_false;
+        gf_boolean_t           dirty       = _gf_false;
+        gf_boolean_t           updated     = _gf_false;
+        quota_meta_t           total       = {0, };
+        quota_pending_txn_t   *txn         = NULL;
+        quota_inode_ctx_t     *parent_ctx  = NULL;
+
+        ret = mq_lock (this, parent_loc, F_WRLCK);
+        if (ret < 0)
+                goto out;
+        locked = _gf_true;
+
+        list_for_each_entry (txn, group, list) {
+                mq_set_ctx_updation_status (txn->ctx, _gf_false);
+                txn->released = _gf_true;
+
+                if (mq_txn_get_contribution (this, txn) < 0)
+                        continue;
+
+                ret = mq_get_delta (this, &txn->loc, &txn->delta, txn->ctx,
+                                    txn->contri);
+                if (ret < 0 || quota_meta_is_null (&txn->delta))
+                        goto skip;
+
+                if (!dirty) {
+                        ret = mq_get_set_dirty (this, parent_loc, 1,
+                                                &prev_dirty);
+                        if (ret < 0)
+                                goto out;
+                        dirty = _gf_true;
+                }
+
+                ret = mq_update_contri (this, &txn->loc, txn->contri,
+                                        &txn->delta);
+                if (ret < 0)
+                        goto skip;
+
+                mq_add_meta (&total, &txn->delta);
+                continue;
+skip:
+                GF_REF_PUT (txn->contri);
+                txn->contri = NULL;
+        }
+
+        if (quota_meta_is_null (&total)) {
+                ret = 0;
+                goto out;
+        }
+
+        ret = mq_update_size (this, parent_loc, &total);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_DEBUG, "rollback contri updation");
+                list_for_each_entry (txn, group, list) {
+                        if (txn->contri == NULL)
+                                continue;
+                        mq_sub_meta (&txn->delta, NULL);
+                        mq_update_contri (this, &txn->loc, txn->contri,
+                                          &txn->delta);
+                }
+                goto out;
+        }
+        updated = _gf_true;
+
+out:
+        if (dirty) {
+                if (ret < 0 || prev_dirty) {
+                        /* same as in mq_initiate_quota_task, the next
+                         * lookup fixes the dirty directory
+                         */
+                        if (mq_inode_ctx_get (parent_loc->inode, this,
+                                              &parent_ctx) == 0)
+                                mq_set_ctx_dirty_status (parent_ctx,
+                                                         _gf_false);
+                } else {
+                        mq_mark_dirty (this, parent_loc, 0);
+                }
+        }
+
+        if (locked)
+                mq_lock (this, parent_loc, F_UNLCK);
+
+        if (updated && !__is_root_gfid (parent_loc->gfid))
+                mq_txn_queue_parent (this, parent_loc, next);
+
+        return ret;
+}
+
+int
+mq_txn_batch_task (void *opaque)
+{
+        quota_txn_batch_t     *batch       = NULL;
+        xlator_t              *this        = NULL;
+        marker_conf_t         *priv        = NULL;
+        quota_pending_txn_t   *txn         = NULL;
+        quota_pending_txn_t   *tmp         = NULL;
+        quota_pending_txn_t   *first       = NULL;
+        struct list_head       group;
+        struct list_head       next;
+        struct timeval         now         = {0, };
+        uint64_t               updates     = 0;
+        int64_t                lag         = 0;
+
+        GF_VALIDATE_OR_GOTO ("marker", opaque, out);
+
+        batch = opaque;
+        this = batch->this;
+        priv = this->private;
+        THIS = this;
+
+        INIT_LIST_HEAD (&group);
+        INIT_LIST_HEAD (&next);
+
+        while (!list_empty (&batch->txns)) {
+                list_for_each_entry_safe (txn, tmp, &batch->txns, list) {
+                        if (__is_root_gfid (txn->loc.gfid) ||
+                            mq_txn_fill_parent (this, txn) < 0) {
+                                list_del_init (&txn->list);
+                                mq_txn_destroy (txn);
+                        }
+                }
+
+                /* one level of the ancestry, grouped by parent */
+                while (!list_empty (&batch->txns)) {
+                        first = list_entry (batch->txns.next,
+                                            quota_pending_txn_t, list);
+                        list_for_each_entry_safe (txn, tmp, &batch->txns,
+                                                  list) {
+                                if (gf_uuid_compare (txn->parent_loc.gfid,
+                                                     first->parent_loc.gfid)
+                                    == 0)
+                                        list_move_tail (&txn->list, &group);
+                        }
+
+                        mq_txn_update_parent (this, &group,
+                                              &first->parent_loc, &next);
+                        updates++;
+
+                        list_for_each_entry_safe (txn, tmp, &group, list) {
+                                list_del_init (&txn->list);
+                                mq_txn_destroy (txn);
+                        }
+                }
+
+                list_splice_init (&next, &batch->txns);
+        }
+
+        gettimeofday (&now, NULL);
+        lag = (now.tv_sec - batch->oldest.tv_sec) * 1000000 +
+              (now.tv_usec - batch->oldest.tv_usec);
+
+        LOCK (&priv->lock);
+        {
+                priv->quota_txn_batches++;
+                priv->quota_parent_updates += updates;
+                priv->quota_lag_last = (lag > 0) ? lag : 0;
+                if (priv->quota_lag_last > priv->quota_lag_max)
+                        priv->quota_lag_max = priv->quota_lag_last;
+        }
+        UNLOCK (&priv->lock);
+
+out:
+        return 0;
+}
+
+int
+mq_txn_batch_cleanup (int ret, call_frame_t *frame, void *opaque)
+{
+        quota_txn_batch_t     *batch       = opaque;
+        quota_pending_txn_t   *txn         = NULL;
+        quota_pending_txn_t   *tmp         = NULL;
+
+        list_for_each_entry_safe (txn, tmp, &batch->txns, list) {
+                list_del_init (&txn->list);
+                mq_txn_destroy (txn);
+        }
+
+        GF_FREE (batch);
+
+        return 0;
+}
+
+/* Timer callback of the update window: hands every txn queued since the
+ * last flush to a synctask.
+ */
+void
+mq_txn_flush (void *data)
+{
+        int32_t                ret         = -1;
+        xlator_t              *this        = data;
+        marker_conf_t         *priv        = NULL;
+        quota_txn_batch_t     *batch       = NULL;
+        quota_pending_txn_t   *txn         = NULL;
+
+        THIS = this;
+        priv = this->private;
+
+        batch = GF_CALLOC (1, sizeof (*batch), gf_marker_mt_quota_txn_batch_t);
+
+        LOCK (&priv->lock);
+        {
+                priv->quota_flush_timer = NULL;
+                if (batch) {
+                        INIT_LIST_HEAD (&batch->txns);
+                        list_splice_init (&priv->quota_pending, &batch->txns);
+                        priv->quota_txn_pending = 0;
+                }
+        }
+        UNLOCK (&priv->lock);
+
+        if (batch == NULL) {
+                /* left queued for the next flush */
+                gf_log (this->name, GF_LOG_ERROR, "out of memory");
+                return;
+        }
+
+        if (list_empty (&batch->txns)) {
+                GF_FREE (batch);
+                return;
+        }
+
+        batch->this = this;
+        txn = list_entry (batch->txns.next, quota_pending_txn_t, list);
+        batch->oldest = txn->queued;
+
+        ret = synctask_new1 (this->ctx->env, 1024 * 16, mq_txn_batch_task,
+                             mq_txn_batch_cleanup, NULL, batch);
+        if (ret) {
+                gf_log (this->name, GF_LOG_ERROR, "Failed to spawn new "
+                        "synctask");
+                mq_txn_batch_cleanup (ret, NULL, batch);
+        }
+}
+
+static int
+mq_txn_queue (xlator_t *this, loc_t *loc, quota_inode_ctx_t *ctx)
+{
+        marker_conf_t         *priv        = this->private;
+        quota_pending_txn_t   *txn         = NULL;
+        struct timespec        delta       = {0, };
+        gf_boolean_t           flush       = _gf_false;
+
+        txn = mq_txn_new (loc, ctx);
+        if (txn == NULL)
+                return -1;
+
+        LOCK (&priv->lock);
+        {
+                list_add_tail (&txn->list, &priv->quota_pending);
+                priv->quota_txn_pending++;
+
+                if (priv->quota_flush_timer == NULL) {
+                        delta.tv_sec = priv->quota_update_window / 1000;
+                        delta.tv_nsec = (priv->quota_update_window % 1000) *
+                                        1000000;
+                        priv->quota_flush_timer =
+                                gf_timer_call_after (this->ctx, delta,
+                                                     mq_txn_flush, this);
+                        if (priv->quota_flush_timer == NULL)
+                                flush = _gf_true;
+                }
+        }
+        UNLOCK (&priv->lock);
+
+        if (flush)
+                mq_txn_flush (this);
+
+        return 0;
+}
+
+void
+mq_txn_queue_cleanup (xlator_t *this)
+{
+        marker_conf_t         *priv        = this->private;
+        quota_pending_txn_t   *txn         = NULL;
+        quota_pending_txn_t   *tmp         = NULL;
+
+        if (priv->quota_flush_timer) {
+                gf_timer_call_cancel (this->ctx, priv->quota_flush_timer);
+                priv->quota_flush_timer = NULL;
+        }
+
+        list_for_each_entry_safe (txn, tmp, &priv->quota_pending, list) {
+                list_del_init (&txn->list);
+                mq_txn_destroy (txn);
+        }
+        priv->quota_txn_pending = 0;
+}
+
 int
 _mq_initiate_quota_txn (xlator_t *this, loc_t *origin_loc, struct iatt *buf,
                         gf_boolean_t spawn)
@@ -1698,6 +2121,7 @@ _mq_initiate_quota_txn (xlator_t *this, loc_t *origin_loc, struct iatt *buf,
         quota_inode_ctx_t      *ctx          = NULL;
         gf_boolean_t            status       = _gf_true;
         loc_t                   loc          = {0,};
+        marker_conf_t          *priv         = this->private;
 
         ret = mq_prevalidate_txn (this, origin_loc, &loc, &ctx, buf);
         if (ret < 0)
@@ -1709,10 +2133,23 @@ _mq_initiate_quota_txn (xlator_t *this, loc_t *origin_loc, struct iatt *buf,
         }
 
         ret = mq_test_and_set_ctx_updation_status (ctx, &status);
-        if (ret < 0 || status == _gf_true)
+        if (ret < 0)
                 goto out;
 
-        ret = mq_synctask (this, mq_initiate_quota_task, spawn, &loc);
+        if (status == _gf_true) {
+                /* the pending txn picks this change up too */
+                LOCK (&priv->lock);
+                {
+                        priv->quota_txn_coalesced++;
+                }
+                UNLOCK (&priv->lock);
+                goto out;
+        }
+
+        if (spawn && priv->quota_update_window)
+                ret = mq_txn_queue (this, &loc, ctx);
+        else
+                ret = mq_synctask (this, mq_initiate_quota_task, spawn, &loc);
 
 out:
         if (ret < 0 && status == _gf_false)
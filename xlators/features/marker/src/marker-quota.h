@@ -121,6 +121,30 @@ struct quota_synctask {
 };
 typedef struct quota_synctask quota_synctask_t;
 
+/* An update txn waiting for the next flush of the update window. Txns
+ * queued in the same window are applied together, one level of the
+ * ancestry at a time, so that every directory gets a single size update
+ * for all of its children which changed.
+ */
+struct quota_pending_txn {
+        struct list_head       list;
+        loc_t                  loc;
+        loc_t                  parent_loc;
+        quota_inode_ctx_t     *ctx;
+        struct inode_contribution *contri;
+        quota_meta_t           delta;
+        gf_boolean_t           released;
+        struct timeval         queued;
+};
+typedef struct quota_pending_txn quota_pending_txn_t;
+
+struct quota_txn_batch {
+        xlator_t              *this;
+        struct list_head       txns;
+        struct timeval         oldest;
+};
+typedef struct quota_txn_batch quota_txn_batch_t;
+
 struct inode_contribution {
         struct list_head contri_list;
         int64_t          contribution;
@@ -153,4 +177,10 @@ mq_reduce_parent_size_txn (xlator_t *, loc_t *, quota_meta_t *,
 
 int32_t
 mq_forget (xlator_t *, quota_inode_ctx_t *);
+
+void
+mq_txn_flush (void *data);
+
+void
+mq_txn_queue_cleanup (xlator_t *this);
 #endif
@@ -18,6 +18,7 @@
 #include "byte-order.h"
 #include "syncop.h"
 #include "syscall.h"
+#include "statedump.h"
 
 #include <fnmatch.h>
 
@@ -3285,6 +3286,8 @@ marker_priv_cleanup (xlator_t *this)
 
         marker_xtime_priv_cleanup (this);
 
+        mq_txn_queue_cleanup (this);
+
         LOCK_DESTROY (&priv->lock);
 
         GF_FREE (priv);
@@ -3336,6 +3339,15 @@ reconfigure (xlator_t *this, dict_t *options)
                                 "version %d", priv->version);
         }
 
+        data = dict_get (options, "quota-update-window");
+        if (data) {
+                ret = gf_string2uint32 (data->data,
+                                        &priv->quota_update_window);
+                if (ret)
+                        gf_log (this->name, GF_LOG_ERROR, "Invalid quota "
+                                "update window %s", data->data);
+        }
+
         data = dict_get (options, "xtime");
         if (data) {
                 ret = gf_string2boolean (data->data, &flag);
@@ -3394,6 +3406,7 @@ init (xlator_t *this)
         priv->version = 0;
 
         LOCK_INIT (&priv->lock);
+        INIT_LIST_HEAD (&priv->quota_pending);
 
         data = dict_get (options, "quota");
         if (data) {
@@ -3419,6 +3432,17 @@ init (xlator_t *this)
                 goto err;
         }
 
+        data = dict_get (options, "quota-update-window");
+        if (data) {
+                ret = gf_string2uint32 (data->data,
+                                        &priv->quota_update_window);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR, "Invalid quota "
+                                "update window %s", data->data);
+                        goto err;
+                }
+        }
+
         data = dict_get (options, "xtime");
         if (data) {
                 ret = gf_string2boolean (data->data, &flag);
@@ -3479,6 +3503,44 @@ fini (xlator_t *this)
         marker_priv_cleanup (this);
 }
 
+int32_t
+marker_priv_dump (xlator_t *this)
+{
+        marker_conf_t *priv = NULL;
+        int32_t        ret  = -1;
+
+        GF_VALIDATE_OR_GOTO ("marker", this, out);
+
+        priv = this->private;
+        GF_VALIDATE_OR_GOTO (this->name, priv, out);
+
+        gf_proc_dump_add_section ("xlators.features.marker.priv", this->name);
+
+        ret = TRY_LOCK (&priv->lock);
+        if (ret)
+                goto out;
+        else {
+                gf_proc_dump_write ("quota-update-window", "%u",
+                                    priv->quota_update_window);
+                gf_proc_dump_write ("quota-txn-pending", "%"PRIu64,
+                                    priv->quota_txn_pending);
+                gf_proc_dump_write ("quota-txn-coalesced", "%"PRIu64,
+                                    priv->quota_txn_coalesced);
+                gf_proc_dump_write ("quota-txn-batches", "%"PRIu64,
+                                    priv->quota_txn_batches);
+                gf_proc_dump_write ("quota-parent-updates", "%"PRIu64,
+                                    priv->quota_parent_updates);
+                gf_proc_dump_write ("quota-propagation-lag-usec", "%"PRIu64,
+                                    priv->quota_lag_last);
+                gf_proc_dump_write ("quota-max-propagation-lag-usec",
+                                    "%"PRIu64, priv->quota_lag_max);
+        }
+        UNLOCK (&priv->lock);
+
+out:
+        return 0;
+}
+
 struct xlator_fops fops = {
         .lookup      = marker_lookup,
         .create      = marker_create,
@@ -3508,6 +3570,10 @@ struct xlator_cbks cbks = {
         .forget = marker_forget
 };
 
+struct xlator_dumpops dumpops = {
+        .priv = marker_priv_dump,
+};
+
 struct volume_options options[] = {
         {.key = {"volume-uuid"}},
         {.key = {"timestamp-file"}},
@@ -3516,5 +3582,15 @@ struct volume_options options[] = {
         {.key = {"xtime"}},
         {.key = {"gsync-force-xtime"}},
         {.key = {"quota-version"} },
+        {.key = {"quota-update-window"},
+         .type = GF_OPTION_TYPE_INT,
+         .min = 0,
+         .max = 10000,
+         .default_value = "0",
+         .description = "Time in milliseconds for which the quota size "
+                        "updates of modified inodes are held and merged, "
+                        "so that every ancestor directory is updated once "
+                        "per window. 0 starts the updates right away."
+        },
         {.key = {NULL}}
 };
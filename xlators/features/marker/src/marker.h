@@ -15,6 +15,7 @@
 #include "defaults.h"
 #include "compat-uuid.h"
 #include "call-stub.h"
+#include "timer.h"
 
 #define MARKER_XATTR_PREFIX "trusted.glusterfs"
 #define XTIME               "xtime"
@@ -143,6 +144,19 @@ struct marker_conf{
         uint64_t     quota_lk_owner;
         gf_lock_t    lock;
         int32_t      version;
+
+        /* quota update window, in msec. 0 starts the update txn of an
+         * inode as soon as it is modified.
+         */
+        uint32_t          quota_update_window;
+        struct list_head  quota_pending;
+        gf_timer_t       *quota_flush_timer;
+        uint64_t          quota_txn_pending;
+        uint64_t          quota_txn_coalesced;
+        uint64_t          quota_txn_batches;
+        uint64_t          quota_parent_updates;
+        uint64_t          quota_lag_last;     /* usec */
+        uint64_t          quota_lag_max;      /* usec */
 };
 typedef struct marker_conf marker_conf_t;
 
@@ -24,6 +24,8 @@ enum gf_quota_mem_types_ {
         gf_quota_mt_quota_limits_level_t,
         gf_quota_mt_qd_vols_conf_t,
         gf_quota_mt_aggregator_state_t,
+        gf_quota_mt_quota_credit_t,
+        gf_quota_mt_credit_table_t,
         gf_quota_mt_end
 };
 #endif
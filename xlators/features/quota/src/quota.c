@@ -582,6 +582,34 @@ out:
         return;
 }
 
+/* Take the allowance granted by quotad with a validation, it replaces
+ * whatever was left of the previous one.
+ */
+static void
+quota_credit_update (quota_inode_ctx_t *ctx, dict_t *xdata)
+{
+        int64_t         size    = 0;
+        int64_t         objects = 0;
+
+        /* no grant, or none for that resource, when a key is absent */
+        if (xdata) {
+                if (dict_get_int64 (xdata, QUOTA_CREDIT_SIZE_KEY, &size))
+                        size = 0;
+                if (dict_get_int64 (xdata, QUOTA_CREDIT_OBJECTS_KEY,
+                                    &objects))
+                        objects = 0;
+        }
+
+        LOCK (&ctx->lock);
+        {
+                ctx->credit = ctx->credit_grant = size;
+                ctx->object_credit = ctx->object_credit_grant = objects;
+                gettimeofday (&ctx->credit_tv, NULL);
+                ctx->credit_refill = _gf_false;
+        }
+        UNLOCK (&ctx->lock);
+}
+
 int32_t
 quota_validate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                     int32_t op_ret, int32_t op_errno, inode_t *inode,
@@ -641,6 +669,9 @@ quota_validate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
         UNLOCK (&ctx->lock);
 
+        if (((quota_priv_t *)this->private)->credits_on)
+                quota_credit_update (ctx, xdata);
+
         quota_check_limit (frame, local->validate_loc.inode, this);
         return 0;
 
@@ -946,6 +977,54 @@ err:
         return 0;
 }
 
+/* Ask for an allowance below the soft limits of the directory. Credits are
+ * leased for the soft-timeout, the time for which the validated size would
+ * have been trusted anyway.
+ */
+static int
+quota_credit_request (xlator_t *this, inode_t *inode, dict_t *xdata)
+{
+        quota_priv_t      *priv         = this->private;
+        quota_inode_ctx_t *ctx          = NULL;
+        uint64_t           value        = 0;
+        int64_t            limit        = 0;
+        int64_t            object_limit = 0;
+        int                ret          = 0;
+
+        if (!priv->credits_on || priv->soft_timeout == 0)
+                goto out;
+
+        inode_ctx_get (inode, this, &value);
+        ctx = (quota_inode_ctx_t *)(unsigned long)value;
+        if (ctx == NULL)
+                goto out;
+
+        LOCK (&ctx->lock);
+        {
+                limit = (ctx->soft_lim > 0) ? ctx->soft_lim : ctx->hard_lim;
+                object_limit = (ctx->object_soft_lim > 0) ?
+                                ctx->object_soft_lim : ctx->object_hard_lim;
+        }
+        UNLOCK (&ctx->lock);
+
+        if (limit <= 0 && object_limit <= 0)
+                goto out;
+
+        ret = dict_set_int64 (xdata, QUOTA_CREDIT_LIMIT_KEY, limit);
+        if (ret < 0)
+                goto out;
+
+        ret = dict_set_int64 (xdata, QUOTA_CREDIT_OBJECT_LIMIT_KEY,
+                              object_limit);
+        if (ret < 0)
+                goto out;
+
+        ret = dict_set_uint32 (xdata, QUOTA_CREDIT_LEASE_KEY,
+                               priv->soft_timeout);
+out:
+        return ret;
+}
+
 int
 quota_validate (call_frame_t *frame, inode_t *inode, xlator_t *this,
                 fop_lookup_cbk_t cbk_fn)
@@ -1000,6 +1079,14 @@ quota_validate (call_frame_t *frame, inode_t *inode, xlator_t *this,
                 goto err;
         }
 
+        ret = quota_credit_request (this, inode, xdata);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, ENOMEM,
+			Q_MSG_ENOMEM, "dict set failed");
+                ret = -ENOMEM;
+                goto err;
+        }
+
         ret = quota_enforcer_lookup (frame, this, xdata, cbk_fn);
         if (ret < 0) {
                 ret = -ENOTCONN;
@@ -1014,6 +1101,139 @@ err:
         return ret;
 }
 
+int32_t
+quota_credit_refill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, inode_t *inode,
+                         struct iatt *buf, dict_t *xdata,
+                         struct iatt *postparent)
+{
+        quota_local_t     *local      = NULL;
+        quota_inode_ctx_t *ctx        = NULL;
+        quota_priv_t      *priv       = NULL;
+        uint64_t           value      = 0;
+        quota_meta_t       size       = {0,};
+
+        local = frame->local;
+        priv = this->private;
+
+        inode_ctx_get (local->validate_loc.inode, this, &value);
+        ctx = (quota_inode_ctx_t *)(unsigned long)value;
+        if (ctx == NULL)
+                goto out;
+
+        if (op_ret < 0 || quota_dict_get_meta (xdata, QUOTA_SIZE_KEY,
+                                               &size) < 0) {
+                LOCK (&ctx->lock);
+                {
+                        ctx->credit_refill = _gf_false;
+                }
+                UNLOCK (&ctx->lock);
+                goto out;
+        }
+
+        LOCK (&ctx->lock);
+        {
+                ctx->size = size.size;
+                ctx->file_count = size.file_count;
+                ctx->dir_count = size.dir_count;
+                gettimeofday (&ctx->tv, NULL);
+        }
+        UNLOCK (&ctx->lock);
+
+        quota_credit_update (ctx, xdata);
+
+        QUOTA_SAFE_INCREMENT (&priv->lock, priv->credit_refills);
+out:
+        frame->local = NULL;
+        STACK_DESTROY (frame->root);
+        quota_local_cleanup (local);
+
+        return 0;
+}
+
+/* Refill the allowance of a directory in the background, before it runs
+ * out in the write path.
+ */
+static void
+quota_credit_refill (xlator_t *this, inode_t *inode, quota_inode_ctx_t *ctx)
+{
+        call_frame_t   *frame  = NULL;
+        quota_local_t  *local  = NULL;
+        int             ret    = -1;
+
+        frame = create_frame (this, this->ctx->pool);
+        if (frame == NULL)
+                goto err;
+
+        local = quota_local_new ();
+        if (local == NULL)
+                goto err;
+        frame->local = local;
+
+        ret = quota_validate (frame, inode, this, quota_credit_refill_cbk);
+        if (ret < 0)
+                goto err;
+
+        return;
+err:
+        LOCK (&ctx->lock);
+        {
+                ctx->credit_refill = _gf_false;
+        }
+        UNLOCK (&ctx->lock);
+
+        if (frame) {
+                frame->local = NULL;
+                STACK_DESTROY (frame->root);
+        }
+        quota_local_cleanup (local);
+}
+
+/* Return: 1 if @delta was taken from the credits of the directory, which
+ *           then needs no other check
+ *         0 otherwise
+ */
+static int
+quota_credit_consume (xlator_t *this, quota_inode_ctx_t *ctx, inode_t *inode,
+                      int64_t delta, gf_boolean_t objects)
+{
+        quota_priv_t   *priv     = this->private;
+        int64_t        *credit   = NULL;
+        int64_t         grant    = 0;
+        int             admitted = 0;
+        gf_boolean_t    refill   = _gf_false;
+
+        if (!priv->credits_on || delta <= 0)
+                return 0;
+
+        credit = objects ? &ctx->object_credit : &ctx->credit;
+
+        LOCK (&ctx->lock);
+        {
+                grant = objects ? ctx->object_credit_grant : ctx->credit_grant;
+
+                if (*credit >= delta &&
+                    !quota_timeout (&ctx->credit_tv, priv->soft_timeout)) {
+                        *credit -= delta;
+                        admitted = 1;
+
+                        if (*credit < grant / 2 && !ctx->credit_refill) {
+                                ctx->credit_refill = _gf_true;
+                                refill = _gf_true;
+                        }
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        if (admitted)
+                __sync_fetch_and_add (&priv->credit_hits, 1);
+
+        if (refill)
+                quota_credit_refill (this, inode, ctx);
+
+        return admitted;
+}
+
 void
 quota_check_limit_continuation (struct list_head *parents, inode_t *inode,
                                 int32_t op_ret, int32_t op_errno, void *data)
@@ -1103,6 +1323,10 @@ quota_check_object_limit (call_frame_t *frame, quota_inode_ctx_t *ctx,
 
         if (ctx != NULL && (ctx->object_hard_lim > 0 ||
                             ctx->object_soft_lim)) {
+                if (!just_validated &&
+                    quota_credit_consume (this, ctx, _inode, 1, _gf_true))
+                        goto done;
+
                 LOCK (&ctx->lock);
                 {
                         timeout = priv->soft_timeout;
@@ -1143,6 +1367,7 @@ quota_check_object_limit (call_frame_t *frame, quota_inode_ctx_t *ctx,
                         goto out;
                 }
 
+done:
                 /*We log usage only if quota limit is configured on
                    that inode
                 */
@@ -1176,6 +1401,10 @@ quota_check_size_limit (call_frame_t *frame, quota_inode_ctx_t *ctx,
         GF_ASSERT (local);
 
         if (ctx != NULL && (ctx->hard_lim > 0 || ctx->soft_lim > 0)) {
+                if (!just_validated &&
+                    quota_credit_consume (this, ctx, _inode, delta, _gf_false))
+                        goto done;
+
                 wouldbe_size = ctx->size + delta;
 
                 LOCK (&ctx->lock);
@@ -1230,6 +1459,7 @@ quota_check_size_limit (call_frame_t *frame, quota_inode_ctx_t *ctx,
                         }
                 }
 
+done:
                 /* We log usage only if quota limit is configured on
                    that inode. */
                 quota_log_usage (this, ctx, _inode, delta);
@@ -5114,6 +5344,7 @@ init (xlator_t *this)
         GF_OPTION_INIT ("hard-timeout", priv->hard_timeout, time, err);
         GF_OPTION_INIT ("alert-time", priv->log_timeout, time, err);
         GF_OPTION_INIT ("volume-uuid", priv->volume_uuid, str, err);
+        GF_OPTION_INIT ("credits", priv->credits_on, bool, err);
 
         this->local_pool = mem_pool_new (quota_local_t, 64);
         if (!this->local_pool) {
@@ -5167,6 +5398,8 @@ reconfigure (xlator_t *this, dict_t *options)
                           time, out);
         GF_OPTION_RECONF ("hard-timeout", priv->hard_timeout, options,
                           time, out);
+        GF_OPTION_RECONF ("credits", priv->credits_on, options, bool,
+                          out);
 
         if (quota_on) {
                 priv->rpc_clnt = quota_enforcer_init (this,
@@ -5229,6 +5462,11 @@ quota_priv_dump (xlator_t *this)
                 gf_proc_dump_write("volume-uuid", "%s", priv->volume_uuid);
                 gf_proc_dump_write("validation-count", "%ld",
                                     priv->validation_count);
+                gf_proc_dump_write("credits", "%d", priv->credits_on);
+                gf_proc_dump_write("credit-hits", "%"PRIu64,
+                                    priv->credit_hits);
+                gf_proc_dump_write("credit-refills", "%"PRIu64,
+                                    priv->credit_refills);
         }
         UNLOCK (&priv->lock);
 
@@ -5344,5 +5582,14 @@ struct volume_options options[] = {
           .max = 7*86400,
           .default_value = "86400",
         },
+        {.key = {"credits"},
+         .type = GF_OPTION_TYPE_BOOL,
+         .default_value = "off",
+         .description = "If set to on, every validation of a directory "
+                        "with a limit also obtains an allowance of bytes "
+                        "and objects from quotad, which is consumed without "
+                        "revalidating. Allowances are only granted below the "
+                        "soft-limit and expire after soft-timeout."
+        },
         {.key = {NULL}}
 };
@@ -153,6 +153,21 @@
 #define QUOTA_REG_OR_LNK_FILE(ia_type)  \
     (IA_ISREG (ia_type) || IA_ISLNK (ia_type))
 
+/* Credits: with the validation of a limited directory, the enforcer asks
+ * quotad for an allowance of bytes and objects below the given limit. The
+ * allowance is consumed locally without revalidating until it runs out or
+ * its lease expires.
+ */
+#define QUOTA_CREDIT_LIMIT_KEY          "quota-credit.limit"
+#define QUOTA_CREDIT_OBJECT_LIMIT_KEY   "quota-credit.object-limit"
+#define QUOTA_CREDIT_LEASE_KEY          "quota-credit.lease"
+#define QUOTA_CREDIT_SIZE_KEY           "quota-credit.size"
+#define QUOTA_CREDIT_OBJECTS_KEY        "quota-credit.objects"
+
+/* share of the headroom granted to every enforcer */
+#define QUOTA_CREDIT_SHARES             4
+#define QUOTA_CREDIT_BUCKETS            256
+
 
 
 struct quota_dentry {
@@ -176,9 +191,26 @@ struct quota_inode_ctx {
         struct timeval   prev_log;
         gf_boolean_t     ancestry_built;
         gf_lock_t        lock;
+        int64_t          credit;
+        int64_t          credit_grant;
+        int64_t          object_credit;
+        int64_t          object_credit_grant;
+        struct timeval   credit_tv;
+        gf_boolean_t     credit_refill;
 };
 typedef struct quota_inode_ctx quota_inode_ctx_t;
 
+/* quotad: an allowance granted to an enforcer for a directory */
+struct quota_credit {
+        struct list_head  list;
+        uuid_t            gfid;
+        void             *client;
+        int64_t           size;
+        int64_t           objects;
+        time_t            expiry;
+};
+typedef struct quota_credit quota_credit_t;
+
 typedef void
 (*quota_ancestry_built_t) (struct list_head *parents, inode_t *inode,
                            int32_t op_ret, int32_t op_errno, void *data);
@@ -234,6 +266,11 @@ struct quota_priv {
         char                  *volume_uuid;
         uint64_t               validation_count;
         int32_t                quotad_conn_status;
+        gf_boolean_t           credits_on;
+        uint64_t               credit_hits;
+        uint64_t               credit_refills;
+        struct list_head      *credits;         /* quotad */
+        uint64_t               credits_granted; /* quotad */
 };
 typedef struct quota_priv      quota_priv_t;
 
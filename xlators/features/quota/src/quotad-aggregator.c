@@ -357,6 +357,7 @@ quotad_aggregator_rpc_notify (rpcsvc_t *rpc, void *xl, rpcsvc_event_t event,
                 break;
 
         case RPCSVC_EVENT_DISCONNECT:
+                qd_credit_forget_client (xl, data);
                 break;
 
         default:
@@ -23,6 +23,11 @@ typedef struct {
         inode_table_t *itable;
         loc_t          loc;
         dict_t        *xdata;
+        gf_boolean_t   credit;
+        int64_t        credit_limit;
+        int64_t        credit_object_limit;
+        uint32_t       credit_lease;
+        void          *client;
 } quotad_aggregator_state_t;
 
 typedef int (*quotad_aggregator_lookup_cbk_t) (xlator_t *this,
@@ -34,4 +39,7 @@ qd_nameless_lookup (xlator_t *this, call_frame_t *frame, gfs3_lookup_req *req,
 int
 quotad_aggregator_init (xlator_t *this);
 
+void
+qd_credit_forget_client (xlator_t *this, void *client);
+
 #endif
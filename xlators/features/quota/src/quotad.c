@@ -42,6 +42,142 @@ mem_acct_init (xlator_t *this)
         return ret;
 }
 
+static int64_t
+qd_credit_share (int64_t limit, int64_t used, int64_t outstanding,
+                 int32_t clients)
+{
+        int64_t headroom = limit - used - outstanding;
+
+        if (limit <= 0 || headroom <= 0)
+                return 0;
+
+        return headroom / (QUOTA_CREDIT_SHARES * clients);
+}
+
+/* Grant the enforcer which sent the validation an allowance for the
+ * directory. The allowances outstanding with all the enforcers never add
+ * up to more than the headroom left below the limit they asked for, and
+ * every new grant gets a smaller share of what is left, so grants shrink
+ * to nothing as the directory approaches the limit. A grant replaces the
+ * previous one of the same enforcer.
+ */
+static void
+qd_credit_grant (xlator_t *this, quotad_aggregator_state_t *state,
+                 uuid_t gfid, dict_t *xdata)
+{
+        quota_priv_t      *priv         = this->private;
+        quota_meta_t       size         = {0, };
+        quota_credit_t    *credit       = NULL;
+        quota_credit_t    *tmp          = NULL;
+        quota_credit_t    *mine         = NULL;
+        struct list_head  *bucket       = NULL;
+        int64_t            out_size     = 0;
+        int64_t            out_objects  = 0;
+        int64_t            grant_size   = 0;
+        int64_t            grant_objs   = 0;
+        int32_t            clients      = 1;
+        time_t             now          = 0;
+
+        if (priv->credits == NULL)
+                return;
+
+        if (quota_dict_get_meta (xdata, QUOTA_SIZE_KEY, &size) < 0)
+                return;
+
+        now = time (NULL);
+        bucket = &priv->credits[gfid[15] % QUOTA_CREDIT_BUCKETS];
+
+        LOCK (&priv->lock);
+        {
+                list_for_each_entry_safe (credit, tmp, bucket, list) {
+                        if (credit->expiry <= now) {
+                                list_del (&credit->list);
+                                GF_FREE (credit);
+                                continue;
+                        }
+
+                        if (gf_uuid_compare (credit->gfid, gfid))
+                                continue;
+
+                        if (credit->client == state->client) {
+                                mine = credit;
+                                continue;
+                        }
+
+                        out_size += credit->size;
+                        out_objects += credit->objects;
+                        clients++;
+                }
+
+                grant_size = qd_credit_share (state->credit_limit, size.size,
+                                              out_size, clients);
+                grant_objs = qd_credit_share (state->credit_object_limit,
+                                              size.file_count + size.dir_count,
+                                              out_objects, clients);
+
+                if (grant_size == 0 && grant_objs == 0) {
+                        if (mine) {
+                                list_del (&mine->list);
+                                GF_FREE (mine);
+                        }
+                        goto unlock;
+                }
+
+                if (mine == NULL) {
+                        mine = GF_CALLOC (1, sizeof (*mine),
+                                          gf_quota_mt_quota_credit_t);
+                        if (mine == NULL) {
+                                grant_size = grant_objs = 0;
+                                goto unlock;
+                        }
+                        gf_uuid_copy (mine->gfid, gfid);
+                        mine->client = state->client;
+                        list_add_tail (&mine->list, bucket);
+                }
+
+                mine->size = grant_size;
+                mine->objects = grant_objs;
+                mine->expiry = now + state->credit_lease;
+                priv->credits_granted++;
+        }
+unlock:
+        UNLOCK (&priv->lock);
+
+        if (dict_set_int64 (xdata, QUOTA_CREDIT_SIZE_KEY, grant_size) ||
+            dict_set_int64 (xdata, QUOTA_CREDIT_OBJECTS_KEY, grant_objs))
+                gf_msg (this->name, GF_LOG_WARNING, ENOMEM, Q_MSG_ENOMEM,
+                        "dict set failed");
+}
+
+/* Drop the allowances of a disconnected enforcer, or all of them if
+ * @client is NULL.
+ */
+void
+qd_credit_forget_client (xlator_t *this, void *client)
+{
+        quota_priv_t      *priv         = this->private;
+        quota_credit_t    *credit       = NULL;
+        quota_credit_t    *tmp          = NULL;
+        int                i            = 0;
+
+        if (priv->credits == NULL)
+                return;
+
+        LOCK (&priv->lock);
+        {
+                for (i = 0; i < QUOTA_CREDIT_BUCKETS; i++) {
+                        list_for_each_entry_safe (credit, tmp,
+                                                  &priv->credits[i], list) {
+                                if (client && credit->client != client)
+                                        continue;
+                                list_del (&credit->list);
+                                GF_FREE (credit);
+                        }
+                }
+        }
+        UNLOCK (&priv->lock);
+}
+
 int32_t
 qd_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, inode_t *inode,
@@ -49,8 +185,13 @@ qd_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 {
         quotad_aggregator_lookup_cbk_t  lookup_cbk = NULL;
         gfs3_lookup_rsp                 rsp = {0, };
+        quotad_aggregator_state_t      *state = NULL;
 
         lookup_cbk = cookie;
+        state = frame->root->state;
+
+        if (op_ret == 0 && xdata && state->credit)
+                qd_credit_grant (this, state, buf->ia_gfid, xdata);
 
         rsp.op_ret = op_ret;
         rsp.op_errno = op_errno;
@@ -129,6 +270,24 @@ qd_nameless_lookup (xlator_t *this, call_frame_t *frame, gfs3_lookup_req *req,
                 goto out;
         }
 
+        /* the credit request is for quotad, not for the bricks */
+        if (dict_get_int64 (xdata, QUOTA_CREDIT_LIMIT_KEY,
+                            &state->credit_limit) == 0) {
+                state->credit = _gf_true;
+                state->client = ((rpcsvc_request_t *)frame->local)->trans;
+                /* without an object limit no objects are granted, and
+                 * without a lease the grant expires right away */
+                if (dict_get_int64 (xdata, QUOTA_CREDIT_OBJECT_LIMIT_KEY,
+                                    &state->credit_object_limit))
+                        state->credit_object_limit = 0;
+                if (dict_get_uint32 (xdata, QUOTA_CREDIT_LEASE_KEY,
+                                     &state->credit_lease))
+                        state->credit_lease = 0;
+                dict_del (xdata, QUOTA_CREDIT_LIMIT_KEY);
+                dict_del (xdata, QUOTA_CREDIT_OBJECT_LIMIT_KEY);
+                dict_del (xdata, QUOTA_CREDIT_LEASE_KEY);
+        }
+
         ret = dict_set_int8 (xdata, QUOTA_READ_ONLY_KEY, 1);
         if (ret < 0) {
                 gf_msg (this->name, GF_LOG_WARNING, ENOMEM,
@@ -179,6 +338,11 @@ qd_fini (xlator_t *this)
                 priv->rpcsvc = NULL;
         }
 
+        if (priv->credits) {
+                qd_credit_forget_client (this, NULL);
+                GF_FREE (priv->credits);
+        }
+
         GF_FREE (priv);
 
 out:
@@ -190,6 +354,7 @@ qd_init (xlator_t *this)
 {
         int32_t          ret            = -1;
         quota_priv_t    *priv           = NULL;
+        int              i              = 0;
 
         if (NULL == this->children) {
                 gf_log (this->name, GF_LOG_ERROR,
@@ -202,6 +367,16 @@ qd_init (xlator_t *this)
         QUOTA_ALLOC_OR_GOTO (priv, quota_priv_t, err);
         LOCK_INIT (&priv->lock);
 
+        priv->credits = GF_CALLOC (QUOTA_CREDIT_BUCKETS,
+                                   sizeof (struct list_head),
+                                   gf_quota_mt_credit_table_t);
+        if (priv->credits == NULL) {
+                ret = -1;
+                goto err;
+        }
+        for (i = 0; i < QUOTA_CREDIT_BUCKETS; i++)
+                INIT_LIST_HEAD (&priv->credits[i]);
+
         this->private = priv;
 
         ret = 0;
@@ -466,6 +466,7 @@ upcall_cache_invalidate (call_frame_t *frame, xlator_t *this, client_t *client,
         upcall_client_t *tmp             = NULL;
         upcall_inode_ctx_t *up_inode_ctx = NULL;
         gf_boolean_t     found           = _gf_false;
+        upcall_local_t  *local           = NULL;
 
         if (!is_upcall_enabled(this))
                 return;
@@ -478,7 +479,11 @@ upcall_cache_invalidate (call_frame_t *frame, xlator_t *this, client_t *client,
                 return;
         }
 
-        up_inode_ctx = ((upcall_local_t *)frame->local)->upcall_inode_ctx;
+        local = frame->local;
+
+        /* the inode may also be a parent of the one the fop is on */
+        if (local && (local->inode == inode))
+                up_inode_ctx = local->upcall_inode_ctx;
 
         if (!up_inode_ctx)
                 up_inode_ctx = upcall_inode_ctx_get (inode, this);
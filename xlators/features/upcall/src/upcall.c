@@ -395,6 +395,14 @@ up_rename_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         upcall_cache_invalidate (frame, this, client, local->inode, flags,
                                  stbuf, postnewparent, postoldparent, NULL);
 
+        /* a new entry appeared in the destination directory */
+        if (local->loc.parent && postnewparent) {
+                flags = UP_TIMES;
+                upcall_cache_invalidate (frame, this, client,
+                                         local->loc.parent, flags,
+                                         postnewparent, NULL, NULL, NULL);
+        }
+
 out:
         UPCALL_STACK_UNWIND (rename, frame, op_ret, op_errno,
                              stbuf, preoldparent, postoldparent,
@@ -412,7 +420,8 @@ up_rename (call_frame_t *frame, xlator_t *this,
 
         EXIT_IF_UPCALL_OFF (this, out);
 
-        local = upcall_local_init (frame, this, NULL, NULL, oldloc->inode, NULL);
+        local = upcall_local_init (frame, this, newloc, NULL, oldloc->inode,
+                                   NULL);
         if (!local) {
                 op_errno = ENOMEM;
                 goto err;
@@ -511,6 +520,14 @@ up_link_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         upcall_cache_invalidate (frame, this, client, local->inode, flags,
                                  stbuf, postparent, NULL, NULL);
 
+        /* a new entry appeared in the directory */
+        if (local->loc.parent && postparent) {
+                flags = UP_TIMES;
+                upcall_cache_invalidate (frame, this, client,
+                                         local->loc.parent, flags,
+                                         postparent, NULL, NULL, NULL);
+        }
+
 out:
         UPCALL_STACK_UNWIND (link, frame, op_ret, op_errno,
                              inode, stbuf, preparent, postparent, xdata);
@@ -527,7 +544,8 @@ up_link (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
 
         EXIT_IF_UPCALL_OFF (this, out);
 
-        local = upcall_local_init (frame, this, NULL, NULL, oldloc->inode, NULL);
+        local = upcall_local_init (frame, this, newloc, NULL, oldloc->inode,
+                                   NULL);
         if (!local) {
                 op_errno = ENOMEM;
                 goto err;
@@ -742,7 +760,20 @@ up_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         client = frame->root->client;
         local = frame->local;
 
-        if ((op_ret < 0) || !local) {
+        if (!local)
+                goto out;
+
+        if (op_ret < 0) {
+                /* let the client cache the missing name, creating an entry
+                 * in the parent notifies it
+                 */
+                if ((op_errno == ENOENT) && local->loc.parent && postparent) {
+                        flags = UP_UPDATE_CLIENT;
+                        upcall_cache_invalidate (frame, this, client,
+                                                 local->loc.parent, flags,
+                                                 postparent, NULL, NULL,
+                                                 NULL);
+                }
                 goto out;
         }
         flags = UP_UPDATE_CLIENT;
@@ -765,7 +796,7 @@ up_lookup (call_frame_t *frame, xlator_t *this,
 
         EXIT_IF_UPCALL_OFF (this, out);
 
-        local = upcall_local_init (frame, this, NULL, NULL, loc->inode, NULL);
+        local = upcall_local_init (frame, this, loc, NULL, loc->inode, NULL);
         if (!local) {
                 op_errno = ENOMEM;
                 goto err;
@@ -41,6 +41,7 @@ DECLARE_HOOK(history_file);
 DECLARE_HOOK(master_dir);
 DECLARE_HOOK(meminfo_file);
 DECLARE_HOOK(measure_file);
+DECLARE_HOOK(fop_trace_file);
 DECLARE_HOOK(profile_file);
 
 #endif
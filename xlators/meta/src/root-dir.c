@@ -55,6 +55,10 @@ static struct meta_dirent root_dir_dirents[] = {
 	  .type = IA_IFREG,
 	  .hook = meta_measure_file_hook,
 	},
+	{ .name = "fop_trace",
+	  .type = IA_IFREG,
+	  .hook = meta_fop_trace_file_hook,
+	},
 	{ .name = NULL }
 };
 
@@ -34,6 +34,7 @@ const char *gd_bitrot_op_list[GF_BITROT_OPTION_TYPE_MAX] = {
         [GF_BITROT_OPTION_TYPE_SCRUB_FREQ]      = "scrub-frequency",
         [GF_BITROT_OPTION_TYPE_SCRUB]           = "scrub",
         [GF_BITROT_OPTION_TYPE_EXPIRY_TIME]     = "expiry-time",
+        [GF_BITROT_OPTION_TYPE_SCRUB_RATE]      = "scrub-rate",
 };
 
 int
@@ -110,6 +111,16 @@ __glusterd_handle_bitrot (rpcsvc_request_t *req)
                 goto out;
         }
 
+        if ((type == GF_BITROT_OPTION_TYPE_SCRUB_RATE) &&
+            (conf->op_version < GD_OP_VERSION_4_0_0)) {
+                snprintf (msg, sizeof (msg), "Cannot execute command. The "
+                          "cluster is operating at version %d. Bitrot command "
+                          "%s is unavailable in this version", conf->op_version,
+                          gd_bitrot_op_list[type]);
+                ret = -1;
+                goto out;
+        }
+
         if (type == GF_BITROT_CMD_SCRUB_STATUS) {
                 /* Backward compatibility handling for scrub status command*/
                 if (conf->op_version < GD_OP_VERSION_3_7_7) {
@@ -241,6 +252,48 @@ out:
         return ret;
 }
 
+static int
+glusterd_bitrot_scrub_rate (glusterd_volinfo_t *volinfo, dict_t *dict,
+                            char *key, char **op_errstr)
+{
+        int32_t        ret                  = -1;
+        char           *scrub_rate          = NULL;
+        xlator_t       *this                = NULL;
+        char           *option              = NULL;
+
+        this = THIS;
+        GF_ASSERT (this);
+
+        ret = dict_get_str (dict, "scrub-rate-value", &scrub_rate);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        GD_MSG_DICT_GET_FAILED, "Unable to fetch scrub-"
+                        "rate value");
+                goto out;
+        }
+
+        option = gf_strdup (scrub_rate);
+        ret = dict_set_dynstr (volinfo->dict, key, option);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        GD_MSG_DICT_SET_FAILED, "Failed to set option %s",
+                        key);
+                goto out;
+        }
+
+        ret = glusterd_scrubsvc_reconfigure ();
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_SCRUBSVC_RECONF_FAIL,
+                        "Failed to reconfigure scrub "
+                        "services");
+                goto out;
+        }
+
+out:
+        return ret;
+}
+
 static int
 glusterd_bitrot_scrub (glusterd_volinfo_t *volinfo, dict_t *dict,
                        char *key, char **op_errstr)
@@ -565,6 +618,14 @@ glusterd_op_bitrot (dict_t *dict, char **op_errstr, dict_t *rsp_dict)
                         goto out;
                 break;
 
+        case GF_BITROT_OPTION_TYPE_SCRUB_RATE:
+                ret = glusterd_bitrot_scrub_rate (volinfo, dict,
+                                                  "features.scrub-rate",
+                                                  op_errstr);
+                if (ret)
+                        goto out;
+                break;
+
         case GF_BITROT_OPTION_TYPE_EXPIRY_TIME:
                 ret = glusterd_bitrot_expiry_time (volinfo, dict,
                                                    "features.expiry-time",
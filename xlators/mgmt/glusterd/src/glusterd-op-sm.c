@@ -462,6 +462,15 @@ glusterd_check_bitrot_cmd (char *key, char *value, char *errstr, size_t size)
                           key);
                 ret = -1;
                 goto out;
+        } else if ((!strncmp (key, "scrub-rate", strlen ("scrub-rate"))) ||
+                   (!strncmp (key, "features.scrub-rate",
+                    strlen ("features.scrub-rate")))) {
+                snprintf (errstr, size, " 'gluster volume set <VOLNAME> %s' is "
+                          "invalid command. Use 'gluster volume bitrot "
+                          "<VOLNAME> scrub-rate <bytes-per-second>' instead.",
+                          key);
+                ret = -1;
+                goto out;
         } else if ((!strncmp (key, "scrub", strlen ("scrub"))) ||
                   (!strncmp (key, "features.scrub",
                    strlen ("features.scrub")))) {
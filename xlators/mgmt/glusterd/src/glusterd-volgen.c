@@ -2636,6 +2636,7 @@ perfxl_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
 {
         gf_boolean_t enabled = _gf_false;
         glusterd_volinfo_t *volinfo = NULL;
+        xlator_t *xl = NULL;
 
         GF_ASSERT (param);
         volinfo = param;
@@ -2654,10 +2655,16 @@ perfxl_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
             (vme->op_version > volinfo->client_op_version))
                 return 0;
 
-        if (volgen_graph_add (graph, vme->voltype, volinfo->volname))
-                return 0;
-        else
+        xl = volgen_graph_add (graph, vme->voltype, volinfo->volname);
+        if (!xl)
                 return -1;
+
+        /* the shared cache of quick-read is named after the volume id */
+        if (!strcmp (vme->key, "performance.quick-read"))
+                return xlator_set_option (xl, "volume-id",
+                                          uuid_utoa (volinfo->volume_id));
+
+        return 0;
 }
 
 static int
@@ -4262,6 +4269,13 @@ bitrot_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
                         return -1;
         }
 
+        if (!strcmp (vme->option, "signing-block-size")) {
+                ret = xlator_set_option (xl, "signing-block-size",
+                                         vme->value);
+                if (ret)
+                        return -1;
+        }
+
         return ret;
 }
 
@@ -4300,6 +4314,12 @@ scrubber_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
                         return -1;
         }
 
+        if (!strcmp (vme->option, "scrub-rate")) {
+                ret = xlator_set_option (xl, "scrub-rate", vme->value);
+                if (ret)
+                        return -1;
+        }
+
         if (!strcmp (vme->option, "scrubber")) {
                 if (!strcmp (vme->value, "pause")) {
                         ret = gf_asprintf (&scrub_option, "scrub-state");
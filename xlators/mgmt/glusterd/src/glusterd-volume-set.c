@@ -1330,6 +1330,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "debug/io-stats",
           .op_version  = 1
         },
+        { .key         = "diagnostics.fop-trace",
+          .voltype     = "debug/io-stats",
+          .option      = "fop-trace",
+          .value       = "off",
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
         { .key         = VKEY_DIAG_CNT_FOP_HITS,
           .voltype     = "debug/io-stats",
           .option      = "count-fop-hits",
@@ -1493,6 +1499,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.quick-read-shared-cache",
+          .voltype    = "performance/quick-read",
+          .option     = "shared-cache",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.quick-read-shared-cache-size",
+          .voltype    = "performance/quick-read",
+          .option     = "shared-cache-size",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.flush-behind",
           .voltype    = "performance/write-behind",
           .option     = "flush-behind",
@@ -1511,6 +1529,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.write-behind-aggregate-size",
+          .voltype    = "performance/write-behind",
+          .option     = "aggregate-size",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.resync-failed-syncs-after-fsync",
           .voltype    = "performance/write-behind",
           .option     = "resync-failed-syncs-after-fsync",
@@ -1567,6 +1591,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 3,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.lazy-create",
+          .voltype    = "performance/open-behind",
+          .option     = "lazy-create",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.lazy-release-timeout",
+          .voltype    = "performance/open-behind",
+          .option     = "lazy-release-timeout",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.read-ahead-page-count",
           .voltype    = "performance/read-ahead",
           .option     = "page-count",
@@ -1868,6 +1904,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .description = "enable/disable readdir-ahead translator in the volume.",
           .flags       = OPT_FLAG_CLIENT_OPT | OPT_FLAG_XLATOR_OPT
         },
+        { .key         = "performance.rda-cache-timeout",
+          .voltype     = "performance/readdir-ahead",
+          .option      = "rda-cache-timeout",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .flags       = OPT_FLAG_CLIENT_OPT
+        },
+        { .key         = "performance.rda-cache-metadata",
+          .voltype     = "performance/readdir-ahead",
+          .option      = "rda-cache-metadata",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .flags       = OPT_FLAG_CLIENT_OPT
+        },
+        { .key         = "performance.rda-prefetch-dirs",
+          .voltype     = "performance/readdir-ahead",
+          .option      = "rda-prefetch-dirs",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .flags       = OPT_FLAG_CLIENT_OPT
+        },
 
         { .key         = "performance.io-cache",
           .voltype     = "performance/io-cache",
@@ -1973,6 +2027,20 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_9_0,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "features.cache-invalidation-timeout",
+          .voltype    = "performance/md-cache",
+          .option     = "cache-invalidation-timeout",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.negative-lookup-cache",
+          .voltype    = "performance/md-cache",
+          .option     = "negative-lookup-cache",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .description = "Cache lookups of missing names per directory, "
+                         "needs features.cache-invalidation.",
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
 
 	/* Feature translators */
         { .key         = "features.uss",
@@ -2092,6 +2160,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version    = 2,
           .validate_fn   = validate_quota,
         },
+        { .key           = "features.quota-credits",
+          .voltype       = "features/quota",
+          .option        = "credits",
+          .value         = "off",
+          .op_version    = GD_OP_VERSION_4_0_0,
+          .validate_fn   = validate_quota,
+          .description   = "Let the bricks consume allowances granted by "
+                           "quotad for directories below their soft-limit "
+                           "instead of fetching the directory size."
+        },
 
         /* Marker xlator options */
         { .key         = VKEY_MARKER_XTIME,
@@ -2142,6 +2220,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .flags       = OPT_FLAG_NEVER_RESET,
           .op_version  = 1
         },
+        { .key         = "features.quota-update-window",
+          .voltype     = "features/marker",
+          .option      = "quota-update-window",
+          .value       = "0",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .description = "Time in milliseconds for which quota size updates "
+                         "are merged before they are propagated to the "
+                         "ancestor directories."
+        },
 
         { .key         = VKEY_FEATURES_BITROT,
           .voltype     = "features/bit-rot",
@@ -2386,6 +2473,30 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .type        = GLOBAL_DOC,
           .op_version  = 3
         },
+        { .key         = "nfs.drc-mem-limit",
+          .voltype     = "nfs/server",
+          .option      = "nfs.drc-mem-limit",
+          .type        = GLOBAL_DOC,
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
+        { .key         = "nfs.fh-cache-size",
+          .voltype     = "nfs/server",
+          .option      = "nfs.fh-cache-size",
+          .type        = GLOBAL_DOC,
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
+        { .key         = "nfs.negative-lookup-timeout",
+          .voltype     = "nfs/server",
+          .option      = "nfs.negative-lookup-timeout",
+          .type        = GLOBAL_DOC,
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
+        { .key         = "nfs.zerocopy-threshold",
+          .voltype     = "nfs/server",
+          .option      = "transport.socket.zerocopy-threshold",
+          .type        = GLOBAL_DOC,
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
         { .key         = "nfs.read-size",
           .voltype     = "nfs/server",
           .option      = "nfs3.read-size",
@@ -2508,6 +2619,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "storage/posix",
           .op_version  = 3
         },
+        { .key         = "storage.readdirp-threads",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
+        { .key         = "storage.dir-handle-cache-size",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
+        { .key         = "storage.xattr-cache-size",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_4_0_0
+        },
         { .option      = "update-link-count-parent",
           .key         = "storage.build-pgfid",
           .voltype     = "storage/posix",
@@ -2836,6 +2959,38 @@ struct volopt_map_entry glusterd_volopt_map[] = {
                          "The max value is 262144 pages i.e 1 GB and "
                          "the min value is 1000 pages i.e ~4 MB."
         },
+        { .key         = "features.ctr-db-sync",
+          .voltype     = "features/changetimerecorder",
+          .value       = "sync",
+          .option      = "db-sync",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .description = "With sync, every fop is written to the database. "
+                         "With async, changetimerecorder gathers the heat "
+                         "of inode fops in memory and writes it to the "
+                         "sqlite database in a single transaction every "
+                         "features.ctr-flush-interval seconds, losing up to "
+                         "that much heat on a crash of the brick."
+        },
+        { .key         = "features.ctr-flush-interval",
+          .voltype     = "features/changetimerecorder",
+          .value       = "5",
+          .option      = "ctr-flush-interval",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .description = "Seconds between two writes of the heat gathered "
+                         "in memory to the database of changetimerecorder, "
+                         "with features.ctr-db-sync async. This is also the "
+                         "most heat lost on a crash of the brick."
+        },
+        { .key         = "features.ctr-heat-cache-size",
+          .voltype     = "features/changetimerecorder",
+          .value       = "65536",
+          .option      = "ctr-heat-cache-size",
+          .op_version  = GD_OP_VERSION_4_0_0,
+          .description = "Number of files whose heat changetimerecorder "
+                         "gathers in memory with features.ctr-db-sync async. "
+                         "Fops on more files are written to the database "
+                         "right away."
+        },
 #endif /* USE_GFDB */
         { .key         = "locks.trace",
           .voltype     = "features/locks",
@@ -2898,6 +3053,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_7_0,
           .type       = NO_DOC,
         },
+        { .key        = "features.scrub-rate",
+          .voltype    = "features/bit-rot",
+          .value      = "0",
+          .option     = "scrub-rate",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .type       = NO_DOC,
+        },
         { .key        = "features.scrub",
           .voltype    = "features/bit-rot",
           .option     = "scrubber",
@@ -2912,6 +3074,17 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_7_0,
           .type       = NO_DOC,
         },
+        { .key        = "features.signing-block-size",
+          .voltype    = "features/bit-rot",
+          .value      = "0",
+          .option     = "signing-block-size",
+          .op_version = GD_OP_VERSION_4_0_0,
+          .description = "Sign objects with a merkle tree over blocks of "
+                         "this size, so that a modified object is re-signed "
+                         "by reading only the blocks that changed and the "
+                         "scrubber reports corrupted blocks. 0 signs whole "
+                         "objects with SHA256.",
+        },
         /* Upcall translator options */
         { .key         = "features.cache-invalidation",
           .voltype     = "features/upcall",
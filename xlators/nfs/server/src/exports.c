@@ -408,6 +408,24 @@ exp_file_dir_from_uuid (const struct exports_file *file,
         return dir;
 }
 
+/**
+ * exp_dir_hash -- Hash an export directory name the way its mountid is made.
+ *                 Leading slashes are not part of the hash, so "/vol" and
+ *                 "vol" give the same value.
+ *
+ * @dir : Directory name to hash
+ *
+ * @return : the hash, which is also the first four bytes of the mountid
+ */
+uint32_t
+exp_dir_hash (const char *dir)
+{
+        while (*dir == '/')
+                dir++;
+
+        return SuperFastHash (dir, strlen (dir));
+}
+
 /**
  * _exp_file_insert -- Insert the exports directory into the file structure
  *                     using the directory as a dict. Also hashes the dirname,
@@ -428,7 +446,6 @@ _exp_file_insert (struct exports_file *file, struct export_dir *dir)
         uint32_t  hashedval            = 0;
         uuid_t    export_uuid          = {0, };
         char      export_uuid_str[512] = {0, };
-        char     *dirdup               = NULL;
 
         GF_VALIDATE_OR_GOTO (GF_EXP, file, out);
         GF_VALIDATE_OR_GOTO (GF_EXP, dir, out);
@@ -436,11 +453,7 @@ _exp_file_insert (struct exports_file *file, struct export_dir *dir)
         dirdata = bin_to_data (dir, sizeof (*dir));
         dict_set (file->exports_dict, dir->dir_name, dirdata);
 
-        dirdup = strdupa (dir->dir_name);
-        while (strlen (dirdup) > 0 && dirdup[0] == '/')
-                dirdup++;
-
-        hashedval = SuperFastHash (dirdup, strlen (dirdup));
+        hashedval = exp_dir_hash (dir->dir_name);
         memset (export_uuid, 0, sizeof (export_uuid));
         memcpy (export_uuid, &hashedval, sizeof (hashedval));
         gf_uuid_unparse (export_uuid, export_uuid_str);
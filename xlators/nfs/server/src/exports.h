@@ -85,6 +85,9 @@ exp_dir_get_host (const struct export_dir *expdir, const char *host);
 struct export_item *
 exp_dir_get_netgroup (const struct export_dir *expdir, const char *netgroup);
 
+uint32_t
+exp_dir_hash (const char *dir);
+
 struct export_dir *
 exp_file_dir_from_uuid (const struct exports_file *file,
                         const uuid_t export_uuid);
@@ -33,6 +33,12 @@
  *
  * - Same goes for the netgroups file parameter, except use the netgroups file
  *   as the parameter.
+ *
+ * - Every time one of the files is set, both are compiled into a table
+ *   (struct mnt3_auth_table) with the hosts of every export, the members of
+ *   its netgroups included, in a hash and its networks in a trie. The table
+ *   is published with RCU: mnt3_auth_host () reads it without any lock and
+ *   the table it replaces is freed once no reader can still be using it.
  */
 
 #include "mount3-auth.h"
@@ -40,6 +46,23 @@
 #include "netgroups.h"
 #include "mem-pool.h"
 #include "nfs-messages.h"
+#include "hashfn.h"
+
+#include <arpa/inet.h>
+#include <urcu-bp.h>
+
+#define MNT3_AUTH_DIR_BUCKETS   256
+#define MNT3_AUTH_HOST_BUCKETS  4096
+
+#define MNT3_AUTH_IPV4          0
+#define MNT3_AUTH_IPV6          1
+
+static struct mnt3_auth_table *
+_mnt3_auth_table_build (const struct exports_file *expfile,
+                        const struct netgroups_file *ngfile);
+static void
+_mnt3_auth_table_publish (struct mnt3_auth_params *auth_params,
+                          struct mnt3_auth_table *table);
 
 /**
  * mnt3_auth_params_init -- Initialize the mount3 authorization parameters
@@ -64,6 +87,7 @@ mnt3_auth_params_init (struct mount3_state *ms)
 
         auth_params->ngfile = NULL;
         auth_params->expfile = NULL;
+        auth_params->table = NULL;
         auth_params->ms = ms;
 out:
         return auth_params;
@@ -88,6 +112,7 @@ mnt3_auth_params_deinit (struct mnt3_auth_params *auth_params)
          */
         (void)__sync_lock_test_and_set (&auth_params->ms->auth_params, NULL);
 
+        _mnt3_auth_table_publish (auth_params, NULL);
         ng_file_deinit (auth_params->ngfile);
         exp_file_deinit (auth_params->expfile);
         auth_params->ms = NULL;
@@ -111,9 +136,10 @@ int
 mnt3_auth_set_exports_auth (struct mnt3_auth_params *auth_params,
                             const char *filename)
 {
-        struct exports_file *expfile = NULL;
-        struct exports_file *oldfile = NULL;
-        int                  ret     = -EINVAL;
+        struct exports_file    *expfile = NULL;
+        struct exports_file    *oldfile = NULL;
+        struct mnt3_auth_table *table   = NULL;
+        int                     ret     = -EINVAL;
 
         /* Validate args */
         GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, auth_params, out);
@@ -128,8 +154,19 @@ mnt3_auth_set_exports_auth (struct mnt3_auth_params *auth_params,
                 goto out;
         }
 
-        /* Atomically set the file pointer */
-        oldfile = __sync_lock_test_and_set (&auth_params->expfile, expfile);
+        table = _mnt3_auth_table_build (expfile, auth_params->ngfile);
+        if (!table) {
+                exp_file_deinit (expfile);
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        /* The files are only read through the table, the old file can be
+         * freed as soon as the old table is.
+         */
+        oldfile = auth_params->expfile;
+        auth_params->expfile = expfile;
+        _mnt3_auth_table_publish (auth_params, table);
         exp_file_deinit (oldfile);
         ret = 0;
 out:
@@ -151,9 +188,10 @@ int
 mnt3_auth_set_netgroups_auth (struct mnt3_auth_params *auth_params,
                               const char *filename)
 {
-        struct netgroups_file *ngfile  = NULL;
-        struct netgroups_file *oldfile = NULL;
-        int                    ret     = -EINVAL;
+        struct netgroups_file  *ngfile  = NULL;
+        struct netgroups_file  *oldfile = NULL;
+        struct mnt3_auth_table *table   = NULL;
+        int                     ret     = -EINVAL;
 
         /* Validate args */
         GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, auth_params, out);
@@ -168,396 +206,516 @@ mnt3_auth_set_netgroups_auth (struct mnt3_auth_params *auth_params,
                 goto out;
         }
 
-        /* Atomically set the file pointer */
-        oldfile = __sync_lock_test_and_set (&auth_params->ngfile, ngfile);
+        table = _mnt3_auth_table_build (auth_params->expfile, ngfile);
+        if (!table) {
+                ng_file_deinit (ngfile);
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        oldfile = auth_params->ngfile;
+        auth_params->ngfile = ngfile;
+        _mnt3_auth_table_publish (auth_params, table);
         ng_file_deinit (oldfile);
         ret = 0;
 out:
         return ret;
 }
 
-/* Struct used to pass parameters to
- * _mnt3_auth_subnet_match () which
- * checks if an IP matches a subnet
+/* A node of the binary trie over the address bits of the networks (CIDR)
+ * listed for an export. The longest network containing an address wins.
  */
-struct _mnt3_subnet_match_s {
-        char                  *ip;   /* IP address to match */
-        struct export_item   **host; /* Host structure to set */
+struct mnt3_auth_net {
+        struct mnt3_auth_net *child[2];
+        struct export_item   *item;     /* set if a network ends here */
+};
+
+/* An export directory of the exports file */
+struct mnt3_auth_dir {
+        struct mnt3_auth_dir *next;     /* next in the hash bucket */
+        struct export_dir    *expdir;
+        const char           *name;     /* dir_name without leading '/' */
+        uint32_t              hash;     /* exp_dir_hash () of the name */
+        uuid_t                mountid;  /* mountid of the filehandles */
+        struct export_item   *wildcard; /* the '*' host */
+        struct mnt3_auth_net *nets[2];  /* IPv4 and IPv6 networks */
+        gf_boolean_t          has_names; /* lists hosts by name */
+};
+
+/* A host of an export, listed by itself or as a member of a netgroup */
+struct mnt3_auth_host {
+        struct mnt3_auth_host *next;    /* next in the hash bucket */
+        struct mnt3_auth_dir  *dir;
+        const char            *name;    /* points into the parsed files */
+        struct export_item    *item;
+        gf_boolean_t           netgroup;
+};
+
+struct mnt3_auth_table {
+        struct mnt3_auth_dir  *dirs[MNT3_AUTH_DIR_BUCKETS];
+        struct mnt3_auth_host *hosts[MNT3_AUTH_HOST_BUCKETS];
+};
+
+/* Parameters of the walks compiling the table */
+struct mnt3_auth_build {
+        struct mnt3_auth_table      *table;
+        const struct netgroups_file *ngfile;
+        struct mnt3_auth_dir        *dir;   /* directory being compiled */
+        struct export_item          *item;  /* netgroup being compiled */
 };
 
 /**
- * _mnt3_auth_subnet_match -- Check if an ip (specified in the parameter tmp)
- *                            is in the subnet specified by key.
+ * _mnt3_auth_addr_parse -- Convert an IP address string to binary.
+ *
+ * @str  : The string to convert
+ * @addr : Buffer of at least 16 bytes to store the address in
  *
- * @dict: The dict to walk
- * @key : The key we are on
- * @val : The value we are on
- * @tmp : Parameter that points to the above struct
+ * @return: MNT3_AUTH_IPV4 or MNT3_AUTH_IPV6, -1 if @str is not an address
  *
+ * Not for external use.
  */
 static int
-_mnt3_auth_subnet_match (dict_t *dict, char *key, data_t *val, void *tmp)
+_mnt3_auth_addr_parse (const char *str, unsigned char *addr)
 {
-        struct  _mnt3_subnet_match_s *match = NULL;
+        if (inet_pton (AF_INET, str, addr) == 1)
+                return MNT3_AUTH_IPV4;
 
-        match = (struct _mnt3_subnet_match_s *)tmp;
+        if (inet_pton (AF_INET6, str, addr) == 1)
+                return MNT3_AUTH_IPV6;
 
-        if (!match)
-                return 0;
+        return -1;
+}
 
-        if (!match->host)
-                return 0;
+/**
+ * _mnt3_auth_host_hash -- Hash bucket of a host of an export directory
+ *
+ * Not for external use.
+ */
+static uint32_t
+_mnt3_auth_host_hash (const struct mnt3_auth_dir *dir, const char *host)
+{
+        return (SuperFastHash (host, strlen (host)) + dir->hash) %
+               MNT3_AUTH_HOST_BUCKETS;
+}
 
-        if (!match->ip)
-                return 0;
+/**
+ * _mnt3_auth_table_add_host -- Add a host of an export directory to the
+ *                              table. When a host is listed twice the first
+ *                              entry is kept, like the dict walks did.
+ *
+ * Not for external use.
+ */
+static int
+_mnt3_auth_table_add_host (struct mnt3_auth_table *table,
+                           struct mnt3_auth_dir *dir, const char *name,
+                           struct export_item *item, gf_boolean_t netgroup)
+{
+        struct mnt3_auth_host *host     = NULL;
+        unsigned char          addr[16] = {0, };
+        uint32_t               bucket   = 0;
+
+        bucket = _mnt3_auth_host_hash (dir, name);
+        for (host = table->hosts[bucket]; host; host = host->next) {
+                if (host->dir == dir && host->netgroup == netgroup &&
+                    strcmp (host->name, name) == 0)
+                        return 0;
+        }
 
-        /* Already found the host */
-        if (*(match->host))
-                return 0;
+        host = GF_CALLOC (1, sizeof (*host), gf_nfs_mt_mnt3_auth_entry);
+        if (!host)
+                return -ENOMEM;
 
-        /* Don't process anything that's not in CIDR */
-        if (!strchr (key, '/'))
-                return 0;
+        host->dir = dir;
+        host->name = name;
+        host->item = item;
+        host->netgroup = netgroup;
+        host->next = table->hosts[bucket];
+        table->hosts[bucket] = host;
 
-        /* Strip out leading whitespaces */
-        while (*key == ' ')
-                key++;
+        /* Only hosts listed by name need the reverse lookup of clients */
+        if (_mnt3_auth_addr_parse (name, addr) < 0)
+                dir->has_names = _gf_true;
 
-        /* If we found that the IP was in the network, set the host
-         * to point to the value in the dict.
-         */
-        if (gf_is_ip_in_net (key, match->ip)) {
-                *(match->host) = (struct export_item *)val->data;
-        }
         return 0;
 }
 
 /**
- * _find_host_in_export -- Find a host in the exports file.
- *
- * Case 1: FH is non-null
- * -----------------------
- * The lookup process is two-step: The FH has a mountid which represents the
- * export that was mounted by the client. The export is defined as an entry in
- * the exports file. The FH's 'mountid' is hashed in the exports file to lookup
- * an export directory.
- *
- * Case 2: FH is null
- * -------------------
- * The lookup process is two-step: You need a directory and a hostname
- * to do the lookup. We first lookup the export directory in the file
- * and then do a lookup on the directory to find the host. If the host
- * is not found, we must finally check for subnets and then do a match.
- *
- * @file: Exports file to lookup in
- * @dir : Directory to do the lookup
- * @host: Host to lookup in the directory
+ * _mnt3_auth_table_add_net -- Add a network like '10.5.153.0/24' of an
+ *                             export directory to its trie.
  *
  * Not for external use.
  */
-static struct export_item *
-_mnt3_auth_check_host_in_export (const struct exports_file *file,
-                                 const char *dir, const char *host,
-                                 struct nfs3_fh *fh)
+static int
+_mnt3_auth_table_add_net (struct mnt3_auth_dir *dir, const char *network,
+                          struct export_item *item)
 {
-        struct export_dir           *expdir = NULL;
-        struct export_item          *host_s = NULL;
-        struct _mnt3_subnet_match_s  snet_match_s = {0, };
-
-        /* Validate args */
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, file, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, host, out);
+        struct mnt3_auth_net **node     = NULL;
+        unsigned char          addr[16] = {0, };
+        char                  *netdup   = NULL;
+        char                  *slash    = NULL;
+        char                  *end      = NULL;
+        long                   prefix   = 0;
+        int                    family   = -1;
+        int                    bits     = 0;
+        int                    i        = 0;
+
+        netdup = strdupa (network);
+        slash = strchr (netdup, '/');
+        *slash = '\0';
+
+        family = _mnt3_auth_addr_parse (netdup, addr);
+        bits = (family == MNT3_AUTH_IPV6) ? 128 : 32;
+        prefix = strtol (slash + 1, &end, 10);
+        if (family < 0 || end == slash + 1 || *end != '\0' ||
+            prefix < 0 || prefix > bits) {
+                gf_msg (GF_MNT_AUTH, GF_LOG_WARNING, EINVAL,
+                        NFS_MSG_PARSE_FAIL, "Ignoring invalid network %s "
+                        "of %s", network, dir->expdir->dir_name);
+                return 0;
+        }
 
-        /* If the filehandle is defined, use that to perform authentication.
-         * All file operations that need authentication must follow this
-         * code path.
-         */
-        if (fh) {
-                expdir = exp_file_dir_from_uuid (file, fh->mountid);
-                if (!expdir)
-                        goto out;
-        } else {
-                /* Get the exports directory from the exports file */
-                expdir = exp_file_get_dir (file, dir);
-                if (!expdir)
-                        goto out;
+        node = &dir->nets[family];
+        for (i = 0; ; i++) {
+                if (!*node) {
+                        *node = GF_CALLOC (1, sizeof (**node),
+                                           gf_nfs_mt_mnt3_auth_entry);
+                        if (!*node)
+                                return -ENOMEM;
+                }
+                if (i == prefix)
+                        break;
+                node = &(*node)->child[(addr[i / 8] >> (7 - i % 8)) & 1];
         }
 
-        /* Extract the host from the export directory */
-        host_s = exp_dir_get_host (expdir, host);
-        if (!host_s)
-                goto subnet_match;
-        else
-                goto out;
+        if (!(*node)->item)
+                (*node)->item = item;
 
-        /* If the host is not found, we need to walk through the hosts
-         * in the exports directory and see if any of the "hosts" are actually
-         * networks (e.g. 10.5.153.0/24). If they are we should match the
-         * incoming network.
-         */
-subnet_match:
-        if (!expdir->hosts)
-                goto out;
-        snet_match_s.ip = (char *)host;
-        snet_match_s.host = &host_s;
-        dict_foreach (expdir->hosts, _mnt3_auth_subnet_match, &snet_match_s);
-out:
-        return host_s;
+        return 0;
 }
 
-/* This struct represents all the parameters necessary to search through a
- * netgroups file to find a host.
- */
-struct ng_auth_search {
-        const char                  *search_for; /* strings to search for */
-        gf_boolean_t                 found;      /* mark true once found */
-        const struct netgroups_file *file;       /* netgroups file to search */
-        const char                  *expdir;
-        struct export_item          *expitem;    /* pointer to the export */
-        const struct exports_file   *expfile;
-        gf_boolean_t                 _is_host_dict; /* searching a host dict? */
-        struct netgroup_entry       *found_entry;   /* the entry we found! */
-};
-
 /**
- * __netgroup_dict_search -- Function to search the netgroups dict.
- *
- * @dict: The dict we are walking
- * @key : The key we are on
- * @val : The value associated with that key
- * @data: Additional parameters. We pass a pointer to ng_auth_search_s
+ * __mnt3_auth_build_host_walk -- Compile a host of an export directory
  *
  * This is passed as a function pointer to dict_foreach ().
  *
  * Not for external use.
  */
 static int
-__netgroup_dict_search (dict_t *dict, char *key, data_t *val, void *data)
+__mnt3_auth_build_host_walk (dict_t *dict, char *key, data_t *val, void *tmp)
 {
-        struct ng_auth_search *ngsa    = NULL;
-        struct netgroup_entry *ngentry = NULL;
-        data_t                *hdata   = NULL;
-
-        /* 'ngsa' is the search params */
-        ngsa    = (struct ng_auth_search *)data;
-        ngentry = (struct netgroup_entry *)val->data;
-
-        if (ngsa->_is_host_dict) {
-                /* If are on a host dict, we can simply hash the search key
-                 * against the host dict and see if we find anything.
-                 */
-                hdata = dict_get (dict, (char *)ngsa->search_for);
-                if (hdata) {
-                        /* If it was found, log the message, mark the search
-                         * params dict as found and return.
-                         */
-                        gf_msg_debug (GF_MNT_AUTH, errno, "key %s was hashed "
-                                      "and found", key);
-                        ngsa->found = _gf_true;
-                        ngsa->found_entry = (struct netgroup_entry *)hdata->data;
-                        goto out;
-                }
-        }
+        struct mnt3_auth_build *build = tmp;
+        struct export_item     *item  = (struct export_item *)val->data;
 
-        /* If the key is what we are searching for, mark the item as
-         * found and return.
-         */
-        if (strcmp (key, ngsa->search_for) == 0) {
-                ngsa->found = _gf_true;
-                ngsa->found_entry = ngentry;
-                goto out;
-        }
+        /* Strip out leading whitespaces */
+        while (*key == ' ')
+                key++;
 
-        /* If we have a netgroup hosts dict, then search the dict using this
-         * same function.
-         */
-        if (ngentry->netgroup_hosts) {
-                ngsa->_is_host_dict = _gf_true;
-                dict_foreach (ngentry->netgroup_hosts, __netgroup_dict_search,
-                                                        ngsa);
+        if (strcmp (key, "*") == 0) {
+                build->dir->wildcard = item;
+                return 0;
         }
 
-        /* If that search was successful, just return */
-        if (ngsa->found)
-                goto out;
+        if (strchr (key, '/'))
+                return _mnt3_auth_table_add_net (build->dir, key, item);
 
-        /* If we have a netgroup dict, then search the dict using this same
-         * function.
-         */
-        if (ngentry->netgroup_ngs) {
-                ngsa->_is_host_dict = _gf_false;
-                dict_foreach (ngentry->netgroup_ngs, __netgroup_dict_search,
-                                                        ngsa);
-        }
-out:
-        return 0;
+        return _mnt3_auth_table_add_host (build->table, build->dir, key, item,
+                                          _gf_false);
 }
 
 /**
- * __export_dir_lookup_netgroup -- Function to search an exports directory
- *                                 for a host name.
+ * __mnt3_auth_build_ng_host -- Compile a member of a netgroup of an export
+ *                              directory, called by ng_file_foreach_host ().
  *
- * This function walks all the netgroups & hosts in an export directory
- * and tries to match it with the search key. This function calls the above
- * netgroup search function to search through the netgroups.
+ * Not for external use.
+ */
+static int
+__mnt3_auth_build_ng_host (const char *hostname, void *data)
+{
+        struct mnt3_auth_build *build = data;
+
+        return _mnt3_auth_table_add_host (build->table, build->dir, hostname,
+                                          build->item, _gf_true);
+}
+
+/**
+ * __mnt3_auth_build_netgroup_walk -- Compile a netgroup of an export
+ *                                    directory, flattening it to its hosts.
  *
- * This function is very similar to the above function, but both are necessary
- * since we are walking two different dicts. For each netgroup in _this_ dict
- * (the exports dict) we are going to find the corresponding netgroups dict
- * and walk that (nested) structure until we find the host we are looking for.
+ * This is passed as a function pointer to dict_foreach ().
  *
- * @dict: The dict we are walking
- * @key : The key we are on
- * @val : The value associated with that key
- * @data: Additional parameters. We pass a pointer to ng_auth_search_s
+ * Not for external use.
+ */
+static int
+__mnt3_auth_build_netgroup_walk (dict_t *dict, char *key, data_t *val,
+                                 void *tmp)
+{
+        struct mnt3_auth_build *build = tmp;
+
+        if (!build->ngfile)
+                return 0;
+
+        build->item = (struct export_item *)val->data;
+
+        /* Keys of netgroups start with '@' */
+        if (*key == '@')
+                key++;
+
+        return ng_file_foreach_host (build->ngfile, key,
+                                     __mnt3_auth_build_ng_host, build);
+}
+
+/**
+ * __mnt3_auth_build_dir_walk -- Compile an export directory
  *
  * This is passed as a function pointer to dict_foreach ().
  *
  * Not for external use.
  */
 static int
-__export_dir_lookup_netgroup (dict_t *dict, char *key, data_t *val,
-                                void *data)
+__mnt3_auth_build_dir_walk (dict_t *dict, char *key, data_t *val, void *tmp)
 {
-        struct ng_auth_search *ngsa    = NULL; /* Search params */
-        struct netgroups_file *nfile   = NULL; /* Netgroups file to search */
-        struct netgroup_entry *ngentry = NULL; /* Entry in the netgroups file */
-        struct export_dir     *tmpdir  = NULL;
+        struct mnt3_auth_build *build  = tmp;
+        struct export_dir      *expdir = (struct export_dir *)val->data;
+        struct mnt3_auth_dir   *dir    = NULL;
+        uint32_t                bucket = 0;
+        int                     ret    = 0;
+
+        dir = GF_CALLOC (1, sizeof (*dir), gf_nfs_mt_mnt3_auth_entry);
+        if (!dir)
+                return -ENOMEM;
+
+        dir->expdir = expdir;
+        dir->name = expdir->dir_name;
+        while (*dir->name == '/')
+                dir->name++;
+        dir->hash = exp_dir_hash (expdir->dir_name);
+        memcpy (dir->mountid, &dir->hash, sizeof (dir->hash));
+
+        bucket = dir->hash % MNT3_AUTH_DIR_BUCKETS;
+        dir->next = build->table->dirs[bucket];
+        build->table->dirs[bucket] = dir;
+
+        build->dir = dir;
+        if (expdir->hosts) {
+                ret = dict_foreach (expdir->hosts,
+                                    __mnt3_auth_build_host_walk, build);
+                if (ret)
+                        return ret;
+        }
 
-        ngsa  = (struct ng_auth_search *)data;
-        nfile = (struct netgroups_file *)ngsa->file;
+        if (expdir->netgroups)
+                ret = dict_foreach (expdir->netgroups,
+                                    __mnt3_auth_build_netgroup_walk, build);
 
-        GF_ASSERT ((*key == '@'));
+        return ret;
+}
 
-        /* We use ++key here because keys start with '@' for ngs */
-        ngentry = ng_file_get_netgroup (nfile, (key + 1));
-        if (!ngentry) {
-                gf_msg_debug (GF_MNT_AUTH, 0, "%s not found in %s",
-                              key, nfile->filename);
-                goto out;
-        }
+/**
+ * _mnt3_auth_net_free -- Free a trie of networks
+ *
+ * Not for external use.
+ */
+static void
+_mnt3_auth_net_free (struct mnt3_auth_net *node)
+{
+        if (!node)
+                return;
 
-        tmpdir = exp_file_get_dir (ngsa->expfile, ngsa->expdir);
-        if (!tmpdir)
-                goto out;
+        _mnt3_auth_net_free (node->child[0]);
+        _mnt3_auth_net_free (node->child[1]);
+        GF_FREE (node);
+}
 
-        ngsa->expitem = exp_dir_get_netgroup (tmpdir, key);
-        if (!ngsa->expitem)
-                goto out;
+/**
+ * _mnt3_auth_table_free -- Free a compiled table. The parsed files it
+ *                          points into are not freed.
+ *
+ * Not for external use.
+ */
+static void
+_mnt3_auth_table_free (struct mnt3_auth_table *table)
+{
+        struct mnt3_auth_dir  *dir  = NULL;
+        struct mnt3_auth_host *host = NULL;
+        int                    i    = 0;
 
-        /* Run through the host dict */
-        if (ngentry->netgroup_hosts) {
-                ngsa->_is_host_dict = _gf_true;
-                dict_foreach (ngentry->netgroup_hosts, __netgroup_dict_search,
-                              ngsa);
-        }
+        if (!table)
+                return;
 
-        /* If the above search was successful, just return */
-        if (ngsa->found)
-                goto out;
+        for (i = 0; i < MNT3_AUTH_HOST_BUCKETS; i++) {
+                while ((host = table->hosts[i])) {
+                        table->hosts[i] = host->next;
+                        GF_FREE (host);
+                }
+        }
 
-        /* Run through the netgroups dict */
-        if (ngentry->netgroup_ngs) {
-                ngsa->_is_host_dict = _gf_false;
-                dict_foreach (ngentry->netgroup_ngs, __netgroup_dict_search,
-                              ngsa);
+        for (i = 0; i < MNT3_AUTH_DIR_BUCKETS; i++) {
+                while ((dir = table->dirs[i])) {
+                        table->dirs[i] = dir->next;
+                        _mnt3_auth_net_free (dir->nets[MNT3_AUTH_IPV4]);
+                        _mnt3_auth_net_free (dir->nets[MNT3_AUTH_IPV6]);
+                        GF_FREE (dir);
+                }
         }
-out:
-        return 0;
+
+        GF_FREE (table);
 }
 
 /**
- * _mnt3_auth_setup_search_param -- This function sets up an ng_auth_search
- *                                  struct with host and file as the parameters.
- *                                  Host is what we are searching for and file
- *                                  is what we are searching in.
- * @params: Search params to setup
- * @host  : The host to set
- * @nfile : The netgroups file to set
+ * _mnt3_auth_table_build -- Compile the exports and netgroups files into a
+ *                           table the hosts are checked against. The
+ *                           netgroups of every export are flattened to
+ *                           their hosts.
+ *
+ * @expfile: The exports file, may be NULL
+ * @ngfile : The netgroups file, may be NULL
+ *
+ * @return : success: Pointer to the table
+ *           failure: NULL
  *
+ * Not for external use.
  */
-void _mnt3_auth_setup_search_params (struct ng_auth_search *params,
-                                     const char *host, const char *dir,
-                                     const struct netgroups_file *nfile,
-                                     const struct exports_file *expfile)
+static struct mnt3_auth_table *
+_mnt3_auth_table_build (const struct exports_file *expfile,
+                        const struct netgroups_file *ngfile)
 {
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, params, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, host, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, nfile, out);
-
-        params->search_for = host;
-        params->found = _gf_false;
-        params->file = nfile;
-        params->_is_host_dict = _gf_false;
-        params->found_entry = NULL;
-        params->expitem = NULL;
-        params->expfile = expfile;
-        params->expdir = dir;
-out:
-        return;
+        struct mnt3_auth_build build = {0, };
+        int                    ret   = 0;
+
+        build.table = GF_CALLOC (1, sizeof (*build.table),
+                                 gf_nfs_mt_mnt3_auth_table);
+        if (!build.table)
+                goto nomem;
+
+        build.ngfile = ngfile;
+        if (expfile && expfile->exports_dict) {
+                ret = dict_foreach (expfile->exports_dict,
+                                    __mnt3_auth_build_dir_walk, &build);
+                if (ret)
+                        goto nomem;
+        }
+
+        return build.table;
+nomem:
+        gf_msg (GF_MNT_AUTH, GF_LOG_ERROR, ENOMEM, NFS_MSG_NO_MEMORY,
+                "Failed to compile the exports and netgroups");
+        _mnt3_auth_table_free (build.table);
+        return NULL;
 }
 
 /**
- * _mnt3_auth_find_host_in_netgroup -- Given a host name for an directory
- *                                     find if that hostname is in the
- *                                     directory's dict of netgroups.
- * @nfile: Netgroups file to search
- * @efile: Exports file to search
- * @dir  : The exports directory name (used to lookup in exports file)
- * @host : The host we are searching for
- *
- * Search procedure:
- *
- * - Lookup directory string against exports file structure,
- *   get an exports directory structure.
- * - Walk the export file structure's netgroup dict. This dict
- *   holds each netgroup that is authorized to mount that directory.
- * - We then have to walk the netgroup structure, which is a set of
- *   nested dicts until we find the host we are looking for.
- *
- * @return: success: Pointer to the netgroup entry found
- *          failure: NULL
+ * _mnt3_auth_table_publish -- Replace the table of the auth params and free
+ *                             the old one once no check can be using it.
+ *                             Only the thread (re)loading the files calls
+ *                             this.
  *
  * Not for external use.
  */
-static struct netgroup_entry *
-_mnt3_auth_check_host_in_netgroup (const struct mnt3_auth_params *auth_params,
-                                   struct nfs3_fh *fh, const char *host,
-                                   const char *dir, struct export_item **item)
+static void
+_mnt3_auth_table_publish (struct mnt3_auth_params *auth_params,
+                          struct mnt3_auth_table *table)
 {
-        struct export_dir     *expdir      = NULL;
-        struct ng_auth_search  ngsa        = {0, };
-        struct netgroup_entry *found_entry = NULL;
-        struct exports_file   *efile       = auth_params->expfile;
-        struct netgroups_file *nfile       = auth_params->ngfile;
+        struct mnt3_auth_table *old = NULL;
 
-        /* Validate args */
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, nfile, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, efile, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, host, out);
-        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, item, out);
+        old = rcu_xchg_pointer (&auth_params->table, table);
+        if (!old)
+                return;
+
+        synchronize_rcu ();
+        _mnt3_auth_table_free (old);
+}
+
+/**
+ * _mnt3_auth_table_get_dir -- Find an export directory in the table
+ *
+ * @table: The table to lookup from
+ * @fh   : Filehandle of a fop, its mountid names the directory
+ * @dir  : Directory of a mount request, used when fh is NULL
+ *
+ * Must be called in an RCU read-side section.
+ *
+ * Not for external use.
+ */
+static struct mnt3_auth_dir *
+_mnt3_auth_table_get_dir (const struct mnt3_auth_table *table,
+                          struct nfs3_fh *fh, const char *dir)
+{
+        struct mnt3_auth_dir *expdir = NULL;
+        uint32_t              hash   = 0;
 
         if (fh) {
-                expdir = exp_file_dir_from_uuid (efile, fh->mountid);
-                if (!expdir)
-                        goto out;
+                memcpy (&hash, fh->mountid, sizeof (hash));
         } else {
-                /* Get the exports directory */
-                expdir = exp_file_get_dir (efile, dir);
-                if (!expdir)
+                if (!dir)
                         goto out;
+                hash = exp_dir_hash (dir);
+                while (*dir == '/')
+                        dir++;
         }
 
-        /* Setup search struct */
-        _mnt3_auth_setup_search_params (&ngsa, host, expdir->dir_name, nfile,
-                                        efile);
-
-        /* Do the search */
-        dict_foreach (expdir->netgroups, __export_dir_lookup_netgroup, &ngsa);
-        found_entry = ngsa.found_entry;
-        *item = ngsa.expitem;
+        for (expdir = table->dirs[hash % MNT3_AUTH_DIR_BUCKETS]; expdir;
+             expdir = expdir->next) {
+                if (expdir->hash != hash)
+                        continue;
+                if (fh ? (gf_uuid_compare (expdir->mountid, fh->mountid) == 0)
+                       : (strcmp (expdir->name, dir) == 0))
+                        break;
+        }
 out:
-        return found_entry;
+        return expdir;
+}
+
+/**
+ * _mnt3_auth_table_get_host -- Find the export item authorizing a host for
+ *                              an export directory.
+ *
+ * The host is looked up in this order, like the exports file used to be:
+ * the hosts of the directory, the '*' wildcard, the networks (the longest
+ * one containing the address) and finally the members of its netgroups.
+ *
+ * Must be called in an RCU read-side section.
+ *
+ * Not for external use.
+ */
+static struct export_item *
+_mnt3_auth_table_get_host (const struct mnt3_auth_table *table,
+                           const struct mnt3_auth_dir *dir, const char *host)
+{
+        struct mnt3_auth_host *entry    = NULL;
+        struct mnt3_auth_net  *node     = NULL;
+        struct export_item    *ngitem   = NULL;
+        struct export_item    *item     = NULL;
+        unsigned char          addr[16] = {0, };
+        int                    family   = -1;
+        int                    i        = 0;
+
+        for (entry = table->hosts[_mnt3_auth_host_hash (dir, host)]; entry;
+             entry = entry->next) {
+                if (entry->dir != dir || strcmp (entry->name, host) != 0)
+                        continue;
+                if (!entry->netgroup)
+                        return entry->item;
+                ngitem = entry->item;
+        }
+
+        if (dir->wildcard)
+                return dir->wildcard;
+
+        family = _mnt3_auth_addr_parse (host, addr);
+        if (family >= 0) {
+                node = dir->nets[family];
+                for (i = 0; node; i++) {
+                        if (node->item)
+                                item = node->item;
+                        if (i == ((family == MNT3_AUTH_IPV6) ? 128 : 32))
+                                break;
+                        node = node->child[(addr[i / 8] >> (7 - i % 8)) & 1];
+                }
+                if (item)
+                        return item;
+        }
+
+        return ngitem;
 }
 
 /**
@@ -600,9 +758,13 @@ out:
  *
  * Procedure:
  *
- * - Check if the host is in the exports directory.
- * - If not, check if the host is in the netgroups file for the
- *   netgroups authorized for the exports.
+ * - Find the export directory in the compiled table, by the mountid of the
+ *   filehandle or by name.
+ * - Check if the host is listed for the directory, by itself, through a
+ *   network or as a member of one of the netgroups of the directory.
+ *
+ * No lock is taken, the table is read in an RCU read-side section. The
+ * export item saved in @save_item stays valid until the files are reloaded.
  *
  * @return: 0 if authorized
  *          -EACCES for completely unauthorized fop
@@ -613,32 +775,64 @@ mnt3_auth_host (const struct mnt3_auth_params *auth_params, const char *host,
                 struct nfs3_fh *fh, const char *dir, gf_boolean_t is_write_op,
                 struct export_item **save_item)
 {
-        int                  auth_status_code = -EACCES;
-        struct export_item  *item             = NULL;
+        int                     auth_status_code = -EACCES;
+        struct export_item     *item             = NULL;
+        struct mnt3_auth_table *table            = NULL;
+        struct mnt3_auth_dir   *expdir           = NULL;
 
         GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, auth_params, out);
         GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, host, out);
 
-        /* Find the host in the exports file */
-        item = _mnt3_auth_check_host_in_export (auth_params->expfile, dir,
-                                                    host, fh);
-        if (item) {
-                auth_status_code = (is_write_op) ?
-                                   check_rw_access (item) : 0;
-                goto out;
-        }
+        rcu_read_lock ();
 
-        /* Find the host in the netgroups file for the exports directory */
-        if (_mnt3_auth_check_host_in_netgroup (auth_params, fh, host, dir,
-                                               &item)) {
+        table = rcu_dereference (auth_params->table);
+        if (table)
+                expdir = _mnt3_auth_table_get_dir (table, fh, dir);
+        if (expdir)
+                item = _mnt3_auth_table_get_host (table, expdir, host);
+        if (item)
                 auth_status_code = (is_write_op) ?
                                    check_rw_access (item) : 0;
-                goto out;
-        }
 
+        rcu_read_unlock ();
 out:
         if (save_item)
                 *save_item = item;
 
         return auth_status_code;
 }
+
+/**
+ * mnt3_auth_has_hostnames -- Check if an export directory lists any host by
+ *                            name, by itself or in its netgroups. If it only
+ *                            lists addresses and networks, there is no use
+ *                            in a reverse lookup of a client's address.
+ *
+ * @auth_params : Auth parameters to authenticate against
+ * @fh  : The filehandle passed from an fop to authenticate
+ * @dir : Directory that the host requests
+ *
+ * @return: _gf_true if a hostname could authorize a client
+ */
+gf_boolean_t
+mnt3_auth_has_hostnames (const struct mnt3_auth_params *auth_params,
+                         struct nfs3_fh *fh, const char *dir)
+{
+        struct mnt3_auth_table *table     = NULL;
+        struct mnt3_auth_dir   *expdir    = NULL;
+        gf_boolean_t            has_names = _gf_false;
+
+        GF_VALIDATE_OR_GOTO (GF_MNT_AUTH, auth_params, out);
+
+        rcu_read_lock ();
+
+        table = rcu_dereference (auth_params->table);
+        if (table)
+                expdir = _mnt3_auth_table_get_dir (table, fh, dir);
+        if (expdir)
+                has_names = expdir->has_names;
+
+        rcu_read_unlock ();
+out:
+        return has_names;
+}
@@ -23,10 +23,13 @@
 
 #define GF_MNT_AUTH GF_NFS"-mount3-auth"
 
+struct mnt3_auth_table;
+
 struct mnt3_auth_params {
-        struct netgroups_file *ngfile;  /* The netgroup file to auth against */
-        struct exports_file   *expfile; /* The export file to auth against */
-        struct mount3_state   *ms;      /* The mount state that owns this */
+        struct netgroups_file  *ngfile;  /* The netgroup file to auth against */
+        struct exports_file    *expfile; /* The export file to auth against */
+        struct mnt3_auth_table *table;   /* Both files compiled, RCU */
+        struct mount3_state    *ms;      /* The mount state that owns this */
 };
 
 /* Initialize auth params struct */
@@ -48,6 +51,11 @@ mnt3_auth_host (const struct mnt3_auth_params *aps, const char *host,
                 struct nfs3_fh *fh, const char *dir, gf_boolean_t is_write_op,
                 struct export_item **save_item);
 
+/* Check if a host could be authorized by its name (needs a reverse lookup) */
+gf_boolean_t
+mnt3_auth_has_hostnames (const struct mnt3_auth_params *aps,
+                         struct nfs3_fh *fh, const char *dir);
+
 /* Free resources used by the auth params struct */
 void
 mnt3_auth_params_deinit (struct mnt3_auth_params *aps);
@@ -1997,8 +1997,13 @@ _mnt3_authenticate_req (struct mount3_state *ms, rpcsvc_request_t *req,
         gf_msg_debug (GF_MNT, 0, "access from IP %s is %s", host_addr_ip,
                       auth_status_code ? "denied" : "allowed");
 
-        if (auth_status_code != 0) {
-                /* If not, check if the FQDN is authorized */
+        if (auth_status_code == 0) {
+                auth_host = host_addr_ip;
+        } else if (mnt3_auth_has_hostnames (ms->auth_params, fh, pathdup)) {
+                /* If not, check if the FQDN is authorized. There is no
+                 * use in the reverse lookup if the export only lists
+                 * addresses and networks.
+                 */
                 host_addr_fqdn = gf_rev_dns_lookup (host_addr_ip);
                 auth_status_code = mnt3_auth_host (ms->auth_params,
                                                    host_addr_fqdn,
@@ -2011,8 +2016,7 @@ _mnt3_authenticate_req (struct mount3_state *ms, rpcsvc_request_t *req,
 
                 if (auth_status_code == 0)
                         auth_host = host_addr_fqdn;
-        } else
-                auth_host = host_addr_ip;
+        }
 
         /* Skip the lines that set authorized export &
          * host if they are null.
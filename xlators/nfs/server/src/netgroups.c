@@ -662,6 +662,117 @@ err:
         return NULL;
 }
 
+/* Parameters of a walk over the hosts of a netgroup */
+struct ng_host_walk {
+        ng_host_walk_fn  fn;      /* called for every host */
+        void            *data;    /* passed to fn */
+        dict_t          *visited; /* netgroups already walked */
+};
+
+static int
+__nge_foreach_host (struct netgroup_entry *nge, struct ng_host_walk *walk);
+
+/**
+ * __ngh_walk - Call the walk function on a host of a netgroup
+ *
+ * This is passed as a function pointer to dict_foreach ().
+ *
+ * Not for external use.
+ */
+static int
+__ngh_walk (dict_t *dict, char *key, data_t *val, void *tmp)
+{
+        struct ng_host_walk *walk = tmp;
+
+        return walk->fn (key, walk->data);
+}
+
+/**
+ * __nge_walk - Walk the hosts of a netgroup nested in another one
+ *
+ * This is passed as a function pointer to dict_foreach ().
+ *
+ * Not for external use.
+ */
+static int
+__nge_walk (dict_t *dict, char *key, data_t *val, void *tmp)
+{
+        return __nge_foreach_host ((struct netgroup_entry *)val->data, tmp);
+}
+
+/**
+ * __nge_foreach_host - Walk the hosts of a netgroup and of every netgroup
+ *                      nested in it. A netgroup reachable through several
+ *                      paths, or through a loop, is only walked once.
+ *
+ * Not for external use.
+ */
+static int
+__nge_foreach_host (struct netgroup_entry *nge, struct ng_host_walk *walk)
+{
+        int ret = 0;
+
+        if (dict_get (walk->visited, nge->netgroup_name))
+                goto out;
+
+        ret = dict_set_int32 (walk->visited, nge->netgroup_name, 1);
+        if (ret)
+                goto out;
+
+        if (nge->netgroup_hosts) {
+                ret = dict_foreach (nge->netgroup_hosts, __ngh_walk, walk);
+                if (ret)
+                        goto out;
+        }
+
+        if (nge->netgroup_ngs)
+                ret = dict_foreach (nge->netgroup_ngs, __nge_walk, walk);
+out:
+        return ret;
+}
+
+/**
+ * ng_file_foreach_host - Call a function on every host which is a member
+ *                        of a netgroup, directly or through the netgroups
+ *                        nested in it.
+ *
+ * @ngfile   : The netgroups file to lookup from
+ * @netgroup : Name of the netgroup to walk
+ * @fn       : Function to call on the hostnames, a negative return stops
+ *             the walk
+ * @data     : Additional parameter passed to fn
+ *
+ * @return : success: 0, also when the netgroup does not exist
+ *           failure: -ENOMEM or the negative return of fn
+ *
+ * Externally usable.
+ */
+int
+ng_file_foreach_host (const struct netgroups_file *ngfile,
+                      const char *netgroup, ng_host_walk_fn fn, void *data)
+{
+        struct netgroup_entry *nge  = NULL;
+        struct ng_host_walk    walk = {0, };
+        int                    ret  = 0;
+
+        nge = ng_file_get_netgroup (ngfile, netgroup);
+        if (!nge)
+                goto out;
+
+        walk.fn = fn;
+        walk.data = data;
+        walk.visited = dict_new ();
+        if (!walk.visited) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = __nge_foreach_host (nge, &walk);
+        dict_unref (walk.visited);
+out:
+        return ret;
+}
+
 /**
  * __check_host_entry_str - Check if the host string which should be
  *                          in the format '(host,user,domain)' is
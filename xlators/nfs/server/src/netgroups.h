@@ -48,6 +48,12 @@ struct netgroup_entry *
 ng_file_get_netgroup (const struct netgroups_file *ngfile,
                       const char *netgroup);
 
+typedef int (*ng_host_walk_fn) (const char *hostname, void *data);
+
+int
+ng_file_foreach_host (const struct netgroups_file *ngfile,
+                      const char *netgroup, ng_host_walk_fn fn, void *data);
+
 void
 ng_file_deinit (struct netgroups_file *ngfile);
 
@@ -21,6 +21,7 @@
 #include "inode.h"
 #include "nfs-common.h"
 #include "nfs3-helpers.h"
+#include "nfs3-fh-cache.h"
 #include "nfs-mem-types.h"
 #include "nfs-messages.h"
 #include <libgen.h>
@@ -785,6 +786,23 @@ err:
 }
 
 
+/* Names cached as not found in @parent may have been created by the fop */
+static void
+nfs_fop_fh_cache_invalidate (struct nfs_fop_local *nfl, int32_t op_ret,
+                             struct iatt *parent)
+{
+        struct nfs_state        *nfs = NULL;
+
+        if ((op_ret < 0) || (!parent) || (!nfl->nfsx))
+                return;
+
+        nfs = nfs_state (nfl->nfsx);
+        if (nfs && nfs->nfs3state)
+                nfs3_fh_cache_invalidate (nfs->nfs3state->fhcache,
+                                          parent->ia_gfid, _gf_false);
+}
+
+
 int32_t
 nfs_fop_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                     int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
@@ -799,6 +817,7 @@ nfs_fop_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postparent);
         nfs_fop_restore_root_ino (nfl, op_ret, buf, NULL, preparent,
                                   postparent);
         if (progcbk)
@@ -905,6 +924,7 @@ nfs_fop_mkdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postparent);
         nfs_fop_restore_root_ino (nfl, op_ret, buf, NULL,preparent, postparent);
         if (progcbk)
                 progcbk (frame, cookie, this, op_ret, op_errno, inode, buf,
@@ -958,6 +978,7 @@ nfs_fop_symlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postparent);
         nfs_fop_restore_root_ino (nfl, op_ret,buf, NULL, preparent, postparent);
         if (progcbk)
                 progcbk (frame, cookie, this, op_ret, op_errno, inode, buf,
@@ -1058,6 +1079,7 @@ nfs_fop_mknod_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postparent);
         nfs_fop_restore_root_ino (nfl, op_ret,buf, NULL, preparent, postparent);
         if (progcbk)
                 progcbk (frame, cookie, this, op_ret, op_errno, inode, buf,
@@ -1209,6 +1231,7 @@ nfs_fop_link_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postparent);
         nfs_fop_restore_root_ino (nfl, op_ret, buf, NULL, preparent,
                                   postparent);
         if (progcbk)
@@ -1262,6 +1285,7 @@ nfs_fop_rename_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         fop_rename_cbk_t        progcbk = NULL;
 
         nfl_to_prog_data (nfl, progcbk, frame);
+        nfs_fop_fh_cache_invalidate (nfl, op_ret, postnewparent);
         /* The preattr arg needs to be NULL instead of @buf because it is
          * possible that the new parent is not root whereas the source dir
          * could have been. That is handled in the next macro.
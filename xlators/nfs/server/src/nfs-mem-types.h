@@ -50,6 +50,10 @@ enum gf_nfs_mem_types_ {
         gf_nfs_mt_arr,
         gf_nfs_mt_auth_cache,
         gf_nfs_mt_auth_cache_entry,
+        gf_nfs_mt_fh_cache,
+        gf_nfs_mt_fh_cache_entry,
+        gf_nfs_mt_mnt3_auth_table,
+        gf_nfs_mt_mnt3_auth_entry,
         gf_nfs_mt_end
 };
 #endif
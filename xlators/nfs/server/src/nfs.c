@@ -26,6 +26,7 @@
 #include "nfs3.h"
 #include "nfs-mem-types.h"
 #include "nfs3-helpers.h"
+#include "nfs3-fh-cache.h"
 #include "nlm4.h"
 #include "options.h"
 #include "acl3.h"
@@ -1550,6 +1551,12 @@ notify (xlator_t *this, int32_t event, void *data, ...)
         case GF_EVENT_PARENT_UP:
                 default_notify (this, GF_EVENT_PARENT_UP, data);
                 break;
+
+        case GF_EVENT_UPCALL:
+                priv = this->private;
+                if (priv->nfs3state)
+                        nfs3_fh_cache_upcall (priv->nfs3state->fhcache, data);
+                break;
         }
 
         return 0;
@@ -1694,6 +1701,10 @@ nfs_priv (xlator_t *this)
                 gf_msg_debug (this->name, 0, "Statedump of NLM failed");
                 goto out;
         }
+
+        if (((struct nfs_state *)(this->private))->nfs3state)
+                nfs3_fh_cache_dump (((struct nfs_state *)
+                                     (this->private))->nfs3state->fhcache);
  out:
         return ret;
 }
@@ -2075,6 +2086,42 @@ struct volume_options options[] = {
           .description = "Sets the number of non-idempotent "
                          "requests to cache in drc"
         },
+        { .key  = {"nfs.drc-mem-limit"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "64MB",
+          .description = "Sets the memory the replies cached in drc may "
+                         "use, the least recently used replies of the clients "
+                         "using the most memory are evicted above it. 0 for "
+                         "no limit"
+        },
+        { .key  = {"nfs.fh-cache-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .default_value = "16384",
+          .description = "Sets the number of inodes of resolved file handles "
+                         "kept in the inode tables, so that they need not be "
+                         "looked up by gfid again, and of names cached as "
+                         "not found. 0 disables the cache"
+        },
+        { .key  = {"nfs.negative-lookup-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 600,
+          .default_value = "0",
+          .description = "Seconds a name LOOKUP did not find is answered as "
+                         "not found without asking the bricks. Creations "
+                         "through this server and, with "
+                         "features.cache-invalidation, through others drop "
+                         "the cached names of their directory. 0 disables it"
+        },
+        { .key  = {"transport.socket.zerocopy-threshold"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "0",
+          .description = "Replies at least this large, those of READ mostly, "
+                         "are sent from the buffers returned by the volume "
+                         "without the kernel copying them (MSG_ZEROCOPY). "
+                         "Worth it above a few tens of KB on NICs doing "
+                         "scatter-gather. 0 disables it"
+        },
         { .key = {"nfs.exports-auth-enable"},
           .type = GF_OPTION_TYPE_BOOL,
           .description = "Set the option to 'on' to enable exports/netgroup "
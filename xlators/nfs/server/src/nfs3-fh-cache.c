@@ -0,0 +1,528 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "nfs3-fh-cache.h"
+#include "nfs-mem-types.h"
+#include "nfs-messages.h"
+#include "statedump.h"
+
+enum nfs3_fh_cache_entry_type {
+        NFS3_FHC_INODE,         /* an inode kept in the table */
+        NFS3_FHC_NEGATIVE,      /* a name LOOKUP did not find */
+        NFS3_FHC_RESOLVING,     /* a gfid lookup in flight */
+};
+
+struct nfs3_fh_cache_entry {
+        struct list_head        hash;
+        struct list_head        list;           /* lru or negative */
+        int                     type;
+        xlator_t                *vol;
+        uuid_t                  gfid;           /* inode, or parent of name */
+        inode_t                 *inode;
+        char                    *name;
+        time_t                  expire;
+        nfs3_call_state_t       *owner;         /* winds the gfid lookup */
+        struct list_head        waiters;        /* for the gfid lookup */
+};
+
+
+static struct list_head *
+nfs3_fh_cache_bucket (struct nfs3_fh_cache *cache, uuid_t gfid)
+{
+        uint32_t        hash = 0;
+
+        /* gfids are random, but for the root one, whose last byte is set */
+        memcpy (&hash, &gfid[12], sizeof (hash));
+
+        return &cache->buckets[hash % GF_NFS3_FH_CACHE_BUCKETS];
+}
+
+
+static struct nfs3_fh_cache_entry *
+__nfs3_fh_cache_find (struct nfs3_fh_cache *cache, int type, xlator_t *vol,
+                      uuid_t gfid, const char *name)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+
+        list_for_each_entry (entry, nfs3_fh_cache_bucket (cache, gfid), hash) {
+                if ((entry->type != type) || (entry->vol != vol) ||
+                    gf_uuid_compare (entry->gfid, gfid))
+                        continue;
+
+                if (name && strcmp (entry->name, name))
+                        continue;
+
+                return entry;
+        }
+
+        return NULL;
+}
+
+
+static struct nfs3_fh_cache_entry *
+nfs3_fh_cache_entry_new (int type, xlator_t *vol, uuid_t gfid)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_nfs_mt_fh_cache_entry);
+        if (!entry)
+                return NULL;
+
+        INIT_LIST_HEAD (&entry->hash);
+        INIT_LIST_HEAD (&entry->list);
+        INIT_LIST_HEAD (&entry->waiters);
+        entry->type = type;
+        entry->vol = vol;
+        gf_uuid_copy (entry->gfid, gfid);
+
+        return entry;
+}
+
+
+/* Unhashes the entry and moves it to @dead, freed out of the lock */
+static void
+__nfs3_fh_cache_drop (struct nfs3_fh_cache *cache,
+                      struct nfs3_fh_cache_entry *entry, struct list_head *dead)
+{
+        list_del_init (&entry->hash);
+        list_move_tail (&entry->list, dead);
+
+        if (entry->type == NFS3_FHC_INODE)
+                cache->inode_count--;
+        else if (entry->type == NFS3_FHC_NEGATIVE)
+                cache->neg_count--;
+}
+
+
+static void
+nfs3_fh_cache_free (struct list_head *dead)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        struct nfs3_fh_cache_entry      *tmp = NULL;
+
+        list_for_each_entry_safe (entry, tmp, dead, list) {
+                list_del_init (&entry->list);
+
+                if (entry->inode)
+                        inode_unref (entry->inode);
+                GF_FREE (entry->name);
+                GF_FREE (entry);
+        }
+}
+
+
+static void
+__nfs3_fh_cache_trim (struct nfs3_fh_cache *cache, struct list_head *dead)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        time_t                           now = time (NULL);
+
+        while (cache->inode_count > cache->size) {
+                entry = list_first_entry (&cache->lru,
+                                          struct nfs3_fh_cache_entry, list);
+                __nfs3_fh_cache_drop (cache, entry, dead);
+                cache->evictions++;
+        }
+
+        while (!list_empty (&cache->negative)) {
+                entry = list_first_entry (&cache->negative,
+                                          struct nfs3_fh_cache_entry, list);
+                if ((cache->neg_count <= cache->size) &&
+                    (entry->expire > now) && cache->neg_timeout)
+                        break;
+
+                __nfs3_fh_cache_drop (cache, entry, dead);
+        }
+}
+
+
+struct nfs3_fh_cache *
+nfs3_fh_cache_init (uint32_t size, uint32_t neg_timeout)
+{
+        struct nfs3_fh_cache    *cache = NULL;
+        int                      i = 0;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_nfs_mt_fh_cache);
+        if (!cache)
+                return NULL;
+
+        cache->buckets = GF_CALLOC (GF_NFS3_FH_CACHE_BUCKETS,
+                                    sizeof (*cache->buckets),
+                                    gf_nfs_mt_list_head);
+        if (!cache->buckets) {
+                GF_FREE (cache);
+                return NULL;
+        }
+
+        for (i = 0; i < GF_NFS3_FH_CACHE_BUCKETS; i++)
+                INIT_LIST_HEAD (&cache->buckets[i]);
+
+        LOCK_INIT (&cache->lock);
+        INIT_LIST_HEAD (&cache->lru);
+        INIT_LIST_HEAD (&cache->negative);
+        cache->size = size;
+        cache->neg_timeout = neg_timeout;
+
+        return cache;
+}
+
+
+void
+nfs3_fh_cache_reconf (struct nfs3_fh_cache *cache, uint32_t size,
+                      uint32_t neg_timeout)
+{
+        struct list_head        dead;
+
+        if (!cache)
+                return;
+
+        INIT_LIST_HEAD (&dead);
+
+        LOCK (&cache->lock);
+        {
+                cache->size = size;
+                cache->neg_timeout = neg_timeout;
+                __nfs3_fh_cache_trim (cache, &dead);
+        }
+        UNLOCK (&cache->lock);
+
+        nfs3_fh_cache_free (&dead);
+}
+
+
+/* Keeps @inode, resolved for a file handle, in the inode table of @vol */
+void
+nfs3_fh_cache_pin (struct nfs3_fh_cache *cache, xlator_t *vol,
+                   inode_t *inode)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        struct list_head                 dead;
+
+        if (!cache || !inode || gf_uuid_is_null (inode->gfid))
+                return;
+
+        INIT_LIST_HEAD (&dead);
+
+        LOCK (&cache->lock);
+        {
+                if (!cache->size)
+                        goto unlock;
+
+                entry = __nfs3_fh_cache_find (cache, NFS3_FHC_INODE, vol,
+                                              inode->gfid, NULL);
+                if (entry) {
+                        list_move_tail (&entry->list, &cache->lru);
+                        goto unlock;
+                }
+
+                entry = nfs3_fh_cache_entry_new (NFS3_FHC_INODE, vol,
+                                                 inode->gfid);
+                if (!entry)
+                        goto unlock;
+
+                entry->inode = inode_ref (inode);
+                list_add (&entry->hash,
+                          nfs3_fh_cache_bucket (cache, inode->gfid));
+                list_add_tail (&entry->list, &cache->lru);
+                cache->inode_count++;
+
+                __nfs3_fh_cache_trim (cache, &dead);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        nfs3_fh_cache_free (&dead);
+}
+
+
+/* Negative entries are added only if nothing was invalidated since @gen was
+ * read, before the LOOKUP which did not find the name was sent.
+ */
+uint64_t
+nfs3_fh_cache_gen (struct nfs3_fh_cache *cache)
+{
+        uint64_t        gen = 0;
+
+        if (!cache)
+                return 0;
+
+        LOCK (&cache->lock);
+        {
+                gen = cache->gen;
+        }
+        UNLOCK (&cache->lock);
+
+        return gen;
+}
+
+
+gf_boolean_t
+nfs3_fh_cache_negative (struct nfs3_fh_cache *cache, xlator_t *vol,
+                        uuid_t pargfid, const char *name)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        struct list_head                 dead;
+        gf_boolean_t                     found = _gf_false;
+
+        if (!cache || !cache->neg_timeout || !name)
+                return _gf_false;
+
+        INIT_LIST_HEAD (&dead);
+
+        LOCK (&cache->lock);
+        {
+                entry = __nfs3_fh_cache_find (cache, NFS3_FHC_NEGATIVE, vol,
+                                              pargfid, name);
+                if (!entry)
+                        goto unlock;
+
+                if (entry->expire > time (NULL)) {
+                        cache->neg_hits++;
+                        found = _gf_true;
+                } else {
+                        __nfs3_fh_cache_drop (cache, entry, &dead);
+                }
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        nfs3_fh_cache_free (&dead);
+
+        return found;
+}
+
+
+void
+nfs3_fh_cache_negative_add (struct nfs3_fh_cache *cache, xlator_t *vol,
+                            uuid_t pargfid, const char *name, uint64_t gen)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        struct list_head                 dead;
+
+        if (!cache || !cache->neg_timeout || !name)
+                return;
+
+        INIT_LIST_HEAD (&dead);
+
+        LOCK (&cache->lock);
+        {
+                if ((cache->gen != gen) || !cache->size ||
+                    !cache->neg_timeout)
+                        goto unlock;
+
+                entry = __nfs3_fh_cache_find (cache, NFS3_FHC_NEGATIVE, vol,
+                                              pargfid, name);
+                if (!entry) {
+                        entry = nfs3_fh_cache_entry_new (NFS3_FHC_NEGATIVE,
+                                                         vol, pargfid);
+                        if (!entry)
+                                goto unlock;
+
+                        entry->name = gf_strdup (name);
+                        if (!entry->name) {
+                                GF_FREE (entry);
+                                goto unlock;
+                        }
+
+                        list_add (&entry->hash,
+                                  nfs3_fh_cache_bucket (cache, pargfid));
+                        cache->neg_count++;
+                }
+
+                entry->expire = time (NULL) + cache->neg_timeout;
+                list_move_tail (&entry->list, &cache->negative);
+
+                __nfs3_fh_cache_trim (cache, &dead);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        nfs3_fh_cache_free (&dead);
+}
+
+
+/* Drops the names cached in the directory @gfid, of every volume, and the
+ * inode @gfid itself if @unpin.
+ */
+void
+nfs3_fh_cache_invalidate (struct nfs3_fh_cache *cache, uuid_t gfid,
+                          gf_boolean_t unpin)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        struct nfs3_fh_cache_entry      *tmp = NULL;
+        struct list_head                 dead;
+
+        if (!cache || gf_uuid_is_null (gfid))
+                return;
+
+        INIT_LIST_HEAD (&dead);
+
+        LOCK (&cache->lock);
+        {
+                cache->gen++;
+                cache->invalidations++;
+
+                list_for_each_entry_safe (entry, tmp,
+                                          nfs3_fh_cache_bucket (cache, gfid),
+                                          hash) {
+                        if (gf_uuid_compare (entry->gfid, gfid))
+                                continue;
+
+                        if ((entry->type == NFS3_FHC_NEGATIVE) ||
+                            (unpin && (entry->type == NFS3_FHC_INODE)))
+                                __nfs3_fh_cache_drop (cache, entry, &dead);
+                }
+        }
+        UNLOCK (&cache->lock);
+
+        nfs3_fh_cache_free (&dead);
+}
+
+
+/* Changes made through other servers and clients are learnt through the
+ * cache-invalidation upcalls of the bricks.
+ */
+void
+nfs3_fh_cache_upcall (struct nfs3_fh_cache *cache, struct gf_upcall *up)
+{
+        struct gf_upcall_cache_invalidation     *ci = NULL;
+
+        if (!cache || !up || (up->event_type != GF_UPCALL_CACHE_INVALIDATION))
+                return;
+
+        ci = up->data;
+        if (!ci)
+                return;
+
+        nfs3_fh_cache_invalidate (cache, up->gfid,
+                                  !!(ci->flags & (UP_NLINK | UP_RENAME |
+                                                  UP_FORGET)));
+
+        if (ci->flags & (UP_PARENT_DENTRY_FLAGS | UP_RENAME_FLAGS)) {
+                nfs3_fh_cache_invalidate (cache, ci->p_stat.ia_gfid,
+                                          _gf_false);
+                nfs3_fh_cache_invalidate (cache, ci->oldp_stat.ia_gfid,
+                                          _gf_false);
+        }
+}
+
+
+/**
+ * nfs3_fh_cache_resolve_begin -- Coalesces gfid lookups of a file handle
+ *
+ * @return: 1 if another call state resolves the same file handle, @cs is
+ *          then resumed by nfs3_fh_cache_resolve_end() of that one,
+ *          0 if @cs has to resolve it.
+ */
+int
+nfs3_fh_cache_resolve_begin (struct nfs3_fh_cache *cache,
+                             nfs3_call_state_t *cs)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+        int                              ret = 0;
+
+        if (!cache)
+                return 0;
+
+        LOCK (&cache->lock);
+        {
+                entry = __nfs3_fh_cache_find (cache, NFS3_FHC_RESOLVING,
+                                              cs->vol, cs->resolvefh.gfid,
+                                              NULL);
+                if (entry) {
+                        list_add_tail (&cs->resolve_wait, &entry->waiters);
+                        cache->coalesced++;
+                        ret = 1;
+                        goto unlock;
+                }
+
+                entry = nfs3_fh_cache_entry_new (NFS3_FHC_RESOLVING, cs->vol,
+                                                 cs->resolvefh.gfid);
+                if (!entry)
+                        goto unlock;
+
+                entry->owner = cs;
+                list_add (&entry->hash,
+                          nfs3_fh_cache_bucket (cache, cs->resolvefh.gfid));
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        return ret;
+}
+
+
+/* Moves the call states waiting for the gfid lookup of @cs to @waiters */
+void
+nfs3_fh_cache_resolve_end (struct nfs3_fh_cache *cache,
+                           nfs3_call_state_t *cs, struct list_head *waiters)
+{
+        struct nfs3_fh_cache_entry      *entry = NULL;
+
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                entry = __nfs3_fh_cache_find (cache, NFS3_FHC_RESOLVING,
+                                              cs->vol, cs->resolvefh.gfid,
+                                              NULL);
+                if (entry && (entry->owner == cs)) {
+                        list_splice_init (&entry->waiters, waiters);
+                        list_del_init (&entry->hash);
+                } else {
+                        entry = NULL;
+                }
+        }
+        UNLOCK (&cache->lock);
+
+        GF_FREE (entry);
+}
+
+
+void
+nfs3_fh_cache_dump (struct nfs3_fh_cache *cache)
+{
+        char    key[GF_DUMP_MAX_BUF_LEN] = {0};
+
+        if (!cache)
+                return;
+
+        gf_proc_dump_add_section ("nfs.fh-cache");
+
+        if (TRY_LOCK (&cache->lock))
+                return;
+
+        gf_proc_dump_build_key (key, "fh-cache", "size");
+        gf_proc_dump_write (key, "%u", cache->size);
+
+        gf_proc_dump_build_key (key, "fh-cache", "inodes");
+        gf_proc_dump_write (key, "%u", cache->inode_count);
+
+        gf_proc_dump_build_key (key, "fh-cache", "negative_timeout");
+        gf_proc_dump_write (key, "%u", cache->neg_timeout);
+
+        gf_proc_dump_build_key (key, "fh-cache", "negative_entries");
+        gf_proc_dump_write (key, "%u", cache->neg_count);
+
+        gf_proc_dump_build_key (key, "fh-cache", "negative_hits");
+        gf_proc_dump_write (key, "%"PRIu64, cache->neg_hits);
+
+        gf_proc_dump_build_key (key, "fh-cache", "coalesced_resolutions");
+        gf_proc_dump_write (key, "%"PRIu64, cache->coalesced);
+
+        gf_proc_dump_build_key (key, "fh-cache", "invalidations");
+        gf_proc_dump_write (key, "%"PRIu64, cache->invalidations);
+
+        gf_proc_dump_build_key (key, "fh-cache", "evictions");
+        gf_proc_dump_write (key, "%"PRIu64, cache->evictions);
+
+        UNLOCK (&cache->lock);
+}
@@ -0,0 +1,86 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef _NFS3_FH_CACHE_H_
+#define _NFS3_FH_CACHE_H_
+
+#include "xlator.h"
+#include "inode.h"
+#include "upcall-utils.h"
+#include "nfs3.h"
+
+#define GF_NFS3_FH_CACHE_BUCKETS        4096
+#define GF_NFS3_DEFAULT_FH_CACHE_SIZE   16384
+#define GF_NFS3_DEFAULT_NEG_TIMEOUT     0
+#define GF_NFS3_MAX_NEG_TIMEOUT         600
+
+/* Keeps the inodes file handles resolved to around beyond the LRU limit of
+ * the inode tables, so that they are not resolved again with a gfid lookup,
+ * caches the names LOOKUP did not find for a few seconds, and has one gfid
+ * lookup resolve all the requests for a file handle coming in at once.
+ */
+struct nfs3_fh_cache {
+        gf_lock_t               lock;
+        struct list_head        *buckets;       /* entries hashed by gfid */
+        struct list_head        lru;            /* inodes, oldest first */
+        struct list_head        negative;       /* names, oldest first */
+        uint32_t                size;           /* max inodes and names */
+        uint32_t                neg_timeout;    /* seconds names are cached */
+        uint32_t                inode_count;
+        uint32_t                neg_count;
+        uint64_t                gen;            /* bumped by invalidations */
+
+        uint64_t                neg_hits;
+        uint64_t                coalesced;
+        uint64_t                invalidations;
+        uint64_t                evictions;
+};
+
+struct nfs3_fh_cache *
+nfs3_fh_cache_init (uint32_t size, uint32_t neg_timeout);
+
+void
+nfs3_fh_cache_reconf (struct nfs3_fh_cache *cache, uint32_t size,
+                      uint32_t neg_timeout);
+
+void
+nfs3_fh_cache_pin (struct nfs3_fh_cache *cache, xlator_t *vol,
+                   inode_t *inode);
+
+uint64_t
+nfs3_fh_cache_gen (struct nfs3_fh_cache *cache);
+
+gf_boolean_t
+nfs3_fh_cache_negative (struct nfs3_fh_cache *cache, xlator_t *vol,
+                        uuid_t pargfid, const char *name);
+
+void
+nfs3_fh_cache_negative_add (struct nfs3_fh_cache *cache, xlator_t *vol,
+                            uuid_t pargfid, const char *name, uint64_t gen);
+
+void
+nfs3_fh_cache_invalidate (struct nfs3_fh_cache *cache, uuid_t gfid,
+                          gf_boolean_t unpin);
+
+void
+nfs3_fh_cache_upcall (struct nfs3_fh_cache *cache, struct gf_upcall *up);
+
+int
+nfs3_fh_cache_resolve_begin (struct nfs3_fh_cache *cache,
+                             nfs3_call_state_t *cs);
+
+void
+nfs3_fh_cache_resolve_end (struct nfs3_fh_cache *cache,
+                           nfs3_call_state_t *cs, struct list_head *waiters);
+
+void
+nfs3_fh_cache_dump (struct nfs3_fh_cache *cache);
+
+#endif /* _NFS3_FH_CACHE_H_ */
@@ -19,6 +19,7 @@
 #include "nfs-inodes.h"
 #include "nfs-generics.h"
 #include "nfs3-helpers.h"
+#include "nfs3-fh-cache.h"
 #include "nfs-mem-types.h"
 #include "iatt.h"
 #include "common-utils.h"
@@ -3658,6 +3659,8 @@ nfs3_fh_resolve_entry_lookup_cbk (call_frame_t *frame, void *cookie,
         if (linked_inode) {
                 nfs_fix_generation (this, linked_inode);
                 inode_lookup (linked_inode);
+                nfs3_fh_cache_pin (cs->nfs3state->fhcache, cs->vol,
+                                   linked_inode);
                 inode_unref (cs->resolvedloc.inode);
                 cs->resolvedloc.inode = linked_inode;
         }
@@ -3666,6 +3669,40 @@ err:
         return 0;
 }
 
+/* Resumes the call states which waited for the gfid lookup resolving the
+ * same file handle into @loc.
+ */
+static void
+nfs3_fh_resolve_inode_waiters (struct list_head *waiters, int32_t op_ret,
+                               int32_t op_errno, loc_t *loc, struct iatt *buf)
+{
+        nfs3_call_state_t       *cs = NULL;
+        nfs3_call_state_t       *tmp = NULL;
+
+        list_for_each_entry_safe (cs, tmp, waiters, resolve_wait) {
+                list_del_init (&cs->resolve_wait);
+
+                cs->resolve_ret = op_ret;
+                cs->resolve_errno = op_errno;
+                if ((op_ret == 0) && loc_copy (&cs->resolvedloc, loc)) {
+                        cs->resolve_ret = -1;
+                        cs->resolve_errno = ENOMEM;
+                }
+
+                if (cs->resolve_ret < 0) {
+                        nfs3_call_resume (cs);
+                        continue;
+                }
+
+                memcpy (&cs->stbuf, buf, sizeof (*buf));
+                memcpy (&cs->postparent, buf, sizeof (*buf));
+                if (cs->resolventry)
+                        nfs3_fh_resolve_entry_hard (cs);
+                else
+                        nfs3_call_resume (cs);
+        }
+}
+
 int32_t
 nfs3_fh_resolve_inode_lookup_cbk (call_frame_t *frame, void *cookie,
                                   xlator_t *this, int32_t op_ret,
@@ -3675,11 +3712,15 @@ nfs3_fh_resolve_inode_lookup_cbk (call_frame_t *frame, void *cookie,
 {
         nfs3_call_state_t       *cs = NULL;
         inode_t                 *linked_inode = NULL;
+        struct list_head        waiters;
 
         cs = frame->local;
         cs->resolve_ret = op_ret;
         cs->resolve_errno = op_errno;
 
+        INIT_LIST_HEAD (&waiters);
+        nfs3_fh_cache_resolve_end (cs->nfs3state->fhcache, cs, &waiters);
+
         if (op_ret == -1) {
                 if (op_errno == ENOENT) {
                         gf_msg_trace (GF_NFS3, 0, "Lookup failed: %s: %s",
@@ -3690,6 +3731,8 @@ nfs3_fh_resolve_inode_lookup_cbk (call_frame_t *frame, void *cookie,
                                         NFS_MSG_LOOKUP_FAIL, "Lookup failed: %s: %s",
                                         cs->resolvedloc.path, strerror (op_errno));
                 }
+                nfs3_fh_resolve_inode_waiters (&waiters, op_ret, op_errno,
+                                               NULL, NULL);
                 nfs3_call_resume (cs);
                 goto err;
         }
@@ -3701,10 +3744,15 @@ nfs3_fh_resolve_inode_lookup_cbk (call_frame_t *frame, void *cookie,
         if (linked_inode) {
                 nfs_fix_generation (this, linked_inode);
                 inode_lookup (linked_inode);
+                nfs3_fh_cache_pin (cs->nfs3state->fhcache, cs->vol,
+                                   linked_inode);
 		inode_unref (cs->resolvedloc.inode);
 		cs->resolvedloc.inode = linked_inode;
         }
 
+        nfs3_fh_resolve_inode_waiters (&waiters, op_ret, op_errno,
+                                       &cs->resolvedloc, buf);
+
         /* If it is an entry lookup and we landed in the callback for hard
          * inode resolution, it means the parent inode was not available and
          * had to be resolved first. Now that is done, lets head back into
@@ -3725,16 +3773,24 @@ err:
 int
 nfs3_fh_resolve_inode_hard (nfs3_call_state_t *cs)
 {
-        int             ret = -EFAULT;
-        nfs_user_t      nfu = {0, };
+        int                     ret = -EFAULT;
+        nfs_user_t              nfu = {0, };
+        struct list_head        waiters;
 
         if (!cs)
                 return ret;
 
+        INIT_LIST_HEAD (&waiters);
+
         gf_msg_trace (GF_NFS3, 0, "FH hard resolution for: gfid 0x%s",
                       uuid_utoa (cs->resolvefh.gfid));
 	cs->hardresolved = 1;
         nfs_loc_wipe (&cs->resolvedloc);
+
+        /* The lookup of the same file handle in flight resumes cs too */
+        if (nfs3_fh_cache_resolve_begin (cs->nfs3state->fhcache, cs))
+                return 0;
+
         ret = nfs_gfid_loc_fill (cs->vol->itable, cs->resolvefh.gfid,
                                  &cs->resolvedloc, NFS_RESOLVE_CREATE);
         if (ret < 0) {
@@ -3750,6 +3806,13 @@ nfs3_fh_resolve_inode_hard (nfs3_call_state_t *cs)
                           nfs3_fh_resolve_inode_lookup_cbk, cs);
 
 out:
+        if (ret < 0) {
+                nfs3_fh_cache_resolve_end (cs->nfs3state->fhcache, cs,
+                                           &waiters);
+                nfs3_fh_resolve_inode_waiters (&waiters, -1, EFAULT, NULL,
+                                               NULL);
+        }
+
         return ret;
 }
 
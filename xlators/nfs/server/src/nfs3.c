@@ -23,6 +23,7 @@
 #include "nfs-inodes.h"
 #include "nfs-generics.h"
 #include "nfs3-helpers.h"
+#include "nfs3-fh-cache.h"
 #include "nfs-mem-types.h"
 #include "nfs.h"
 #include "xdr-rpc.h"
@@ -461,6 +462,7 @@ nfs3_call_state_init (struct nfs3_state *s, rpcsvc_request_t *req, xlator_t *v)
         memset (cs, 0, sizeof (*cs));
         INIT_LIST_HEAD (&cs->entries.list);
         INIT_LIST_HEAD (&cs->openwait_q);
+        INIT_LIST_HEAD (&cs->resolve_wait);
         cs->operrno = EINVAL;
         cs->req = req;
         cs->vol = v;
@@ -1278,12 +1280,20 @@ nfs3svc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         cs = frame->local;
         if (op_ret == -1) {
                 status = nfs3_cbk_errno_status (op_ret, op_errno);
+                if ((op_errno == ENOENT) && !nfs3_is_revalidate_lookup (cs))
+                        nfs3_fh_cache_negative_add (cs->nfs3state->fhcache,
+                                                    cs->vol,
+                                                    cs->resolvefh.gfid,
+                                                    cs->resolventry,
+                                                    cs->fhcache_gen);
                 goto xmit_res;
         }
 
         nfs3_fh_build_child_fh (&cs->parent, buf, &newfh);
         oldinode = inode_link (inode, cs->resolvedloc.parent,
                                cs->resolvedloc.name, buf);
+        if (oldinode)
+                nfs3_fh_cache_pin (cs->nfs3state->fhcache, cs->vol, oldinode);
 xmit_res:
         /* Only send fresh lookup if it was a revalidate that failed. */
         if ((op_ret ==  -1) && (nfs3_is_revalidate_lookup (cs))) {
@@ -1487,6 +1497,7 @@ nfs3_lookup (rpcsvc_request_t *req, struct nfs3_fh *fh, int fhlen, char *name)
         int                             ret = -EFAULT;
         struct nfs3_state               *nfs3 = NULL;
         nfs3_call_state_t               *cs = NULL;
+        struct nfs_state                *nfs = NULL;
 
         GF_VALIDATE_OR_GOTO (GF_NFS3, req, out);
         GF_VALIDATE_OR_GOTO (GF_NFS3, fh, out);
@@ -1502,8 +1513,21 @@ nfs3_lookup (rpcsvc_request_t *req, struct nfs3_fh *fh, int fhlen, char *name)
         nfs3_validate_strlen_or_goto (name, NFS_NAME_MAX, nfs3err, stat, ret);
         nfs3_map_fh_to_volume (nfs3, fh, req, vol, stat, nfs3err);
         nfs3_volume_started_check (nfs3, vol, ret, out);
+
+        /* A name looked up a moment ago and not found is answered right
+         * away, unless the file handle has to be authorized first.
+         */
+        nfs = nfs_state (nfs3->nfsx);
+        if (!nfs->exports_auth &&
+            nfs3_fh_cache_negative (nfs3->fhcache, vol, fh->gfid, name)) {
+                stat = NFS3ERR_NOENT;
+                ret = -ENOENT;
+                goto nfs3err;
+        }
+
         nfs3_handle_call_state_init (nfs3, cs, req, vol, stat, nfs3err);
 
+        cs->fhcache_gen = nfs3_fh_cache_gen (nfs3->fhcache);
         cs->lookuptype = GF_NFS3_REVALIDATE;
         ret = nfs3_fh_resolve_and_resume (cs, fh, name,
                                           nfs3_lookup_resume);
@@ -5378,6 +5402,50 @@ nfs3_init_options (struct nfs3_state *nfs3, dict_t *options)
                 nfs3->readdirsize = size64;
         }
 
+        /* nfs.fh-cache-size */
+        nfs3->fhcache_size = GF_NFS3_DEFAULT_FH_CACHE_SIZE;
+        if (dict_get (options, "nfs.fh-cache-size")) {
+                ret = dict_get_str (options, "nfs.fh-cache-size", &optstr);
+                if (ret < 0) {
+                        gf_msg (GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_READ_FAIL,
+                                "Failed to read option: nfs.fh-cache-size");
+                        ret = -1;
+                        goto err;
+                }
+
+                ret = gf_string2uint32 (optstr, &nfs3->fhcache_size);
+                if (ret == -1) {
+                        gf_msg (GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_FORMAT_FAIL,
+                                "Failed to format option: nfs.fh-cache-size");
+                        ret = -1;
+                        goto err;
+                }
+        }
+
+        /* nfs.negative-lookup-timeout */
+        nfs3->neg_timeout = GF_NFS3_DEFAULT_NEG_TIMEOUT;
+        if (dict_get (options, "nfs.negative-lookup-timeout")) {
+                ret = dict_get_str (options, "nfs.negative-lookup-timeout",
+                                    &optstr);
+                if (ret < 0) {
+                        gf_msg (GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_READ_FAIL,
+                                "Failed to read option: "
+                                "nfs.negative-lookup-timeout");
+                        ret = -1;
+                        goto err;
+                }
+
+                ret = gf_string2uint32 (optstr, &nfs3->neg_timeout);
+                if ((ret == -1) ||
+                    (nfs3->neg_timeout > GF_NFS3_MAX_NEG_TIMEOUT)) {
+                        gf_msg (GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_FORMAT_FAIL,
+                                "Failed to format option: "
+                                "nfs.negative-lookup-timeout");
+                        ret = -1;
+                        goto err;
+                }
+        }
+
         /* We want to use the size of the biggest param for the io buffer size.
          */
         nfs3->iobsize = nfs3->readsize;
@@ -5696,6 +5764,15 @@ nfs3_init_state (xlator_t *nfsx)
         LOCK_INIT (&nfs3->fdlrulock);
         nfs3->fdcount = 0;
 
+        nfs3->fhcache = nfs3_fh_cache_init (nfs3->fhcache_size,
+                                            nfs3->neg_timeout);
+        if (!nfs3->fhcache) {
+                gf_msg (GF_NFS3, GF_LOG_ERROR, ENOMEM, NFS_MSG_NO_MEMORY,
+                        "file handle cache creation failed");
+                ret = -1;
+                goto free_localpool;
+        }
+
         ret = rpcsvc_create_listeners (nfs->rpcsvc, nfsx->options, nfsx->name);
         if (ret == -1) {
                 gf_msg (GF_NFS, GF_LOG_ERROR, 0, NFS_MSG_LISTENERS_CREATE_FAIL,
@@ -5763,6 +5840,9 @@ nfs3_reconfigure_state (xlator_t *nfsx, dict_t *options)
                 goto out;
         }
 
+        nfs3_fh_cache_reconf (nfs3->fhcache, nfs3->fhcache_size,
+                              nfs3->neg_timeout);
+
         list_for_each_entry (exp, &nfs3->exports, explist) {
                 ret = nfs3_init_subvolume_options (nfsx, exp, options);
                 if (ret) {
@@ -142,6 +142,11 @@ typedef struct nfs3_state {
         gf_lock_t               fdlrulock;
         int                     fdcount;
         uint32_t                occ_logger;
+
+        /* Inodes of resolved file handles and names LOOKUP did not find */
+        struct nfs3_fh_cache    *fhcache;
+        uint32_t                fhcache_size;
+        uint32_t                neg_timeout;
 } nfs3_state_t;
 
 typedef enum nfs3_lookup_type {
@@ -240,6 +245,9 @@ struct nfs3_local {
         gf_dirent_t             *hashmatch;
         gf_dirent_t             *entrymatch;
         off_t                   lastentryoffset;
+        /* Hook to wait for the gfid lookup of the same file handle */
+        struct list_head        resolve_wait;
+        uint64_t                fhcache_gen;
         struct flock            flock;
         args                    args;
         nlm4_lkowner_t          lkowner;
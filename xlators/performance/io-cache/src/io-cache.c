@@ -1023,6 +1023,7 @@ ioc_dispatch_requests (call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
                                                       "offset=%"PRId64"",
                                                       trav_offset,
                                                       local_offset);
+                                        gf_cache_budget_hit (table->budget);
                                         waitq = __ioc_page_wakeup (trav,
                                                                    trav->op_errno);
                                 } else {
@@ -1839,6 +1840,14 @@ init (xlator_t *this)
                 goto out;
         }
 
+        table->budget = gf_cache_budget_register (this, 1, ioc_cache_usage,
+                                                  ioc_cache_reclaim);
+        if (!table->budget) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        IO_CACHE_MSG_NO_MEMORY, "failed to register with the "
+                        "cache budget, cache-size is the only limit");
+        }
+
         ret = 0;
 
         ctx = this->ctx;
@@ -2093,6 +2102,9 @@ fini (xlator_t *this)
         if (table == NULL)
                 return;
 
+        /* the reclaimer looks at this->private */
+        gf_cache_budget_unregister (table->budget);
+
         this->private = NULL;
 
         if (table->mem_pool != NULL) {
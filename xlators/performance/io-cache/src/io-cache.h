@@ -22,6 +22,7 @@
 #include "call-stub.h"
 #include "rbthash.h"
 #include "hashfn.h"
+#include "cache-budget.h"
 #include <sys/time.h>
 #include <fnmatch.h>
 #include "io-cache-messages.h"
@@ -165,6 +166,7 @@ struct ioc_table {
         int32_t          cache_timeout;
         int32_t          max_pri;
         struct mem_pool  *mem_pool;
+        gf_cache_client_t *budget;
 };
 
 typedef struct ioc_table ioc_table_t;
@@ -322,6 +324,12 @@ ioc_cache_still_valid (ioc_inode_t *ioc_inode, struct iatt *stbuf);
 int32_t
 ioc_prune (ioc_table_t *table);
 
+uint64_t
+ioc_cache_usage (xlator_t *this);
+
+uint64_t
+ioc_cache_reclaim (xlator_t *this, uint64_t bytes);
+
 int32_t
 ioc_need_prune (ioc_table_t *table);
 
@@ -187,48 +187,60 @@ out:
         return 0;
 }
 /*
- * ioc_prune - prune the cache. we have a limit to the number of pages we
- *             can have in-memory.
+ * __ioc_prune - drop least recently used pages until @size_to_prune bytes
+ *               are gone. To be called with the table lock held.
  *
  * @table: ioc_table_t of this translator
+ * @size_to_prune: bytes to drop
  *
  */
-int32_t
-ioc_prune (ioc_table_t *table)
+static void
+__ioc_prune (ioc_table_t *table, uint64_t size_to_prune)
 {
         ioc_inode_t *curr          = NULL, *next_ioc_inode = NULL;
         int32_t      index         = 0;
-        uint64_t     size_to_prune = 0;
         uint64_t     size_pruned   = 0;
 
-        GF_VALIDATE_OR_GOTO ("io-cache", table, out);
-
-        ioc_table_lock (table);
-        {
-                size_to_prune = table->cache_used - table->cache_size;
-                /* take out the least recently used inode */
-                for (index=0; index < table->max_pri; index++) {
-                        list_for_each_entry_safe (curr, next_ioc_inode,
-                                                  &table->inode_lru[index],
-                                                  inode_lru) {
-                                /* prune page-by-page for this inode, till
-                                 * we reach the equilibrium */
-                                ioc_inode_lock (curr);
-                                {
-                                        __ioc_inode_prune (curr, &size_pruned,
-                                                           size_to_prune,
-                                                           index);
-                                }
-                                ioc_inode_unlock (curr);
-
-                                if (size_pruned >= size_to_prune)
-                                        break;
-                        } /* list_for_each_entry_safe (curr...) */
+        /* take out the least recently used inode */
+        for (index=0; index < table->max_pri; index++) {
+                list_for_each_entry_safe (curr, next_ioc_inode,
+                                          &table->inode_lru[index],
+                                          inode_lru) {
+                        /* prune page-by-page for this inode, till
+                         * we reach the equilibrium */
+                        ioc_inode_lock (curr);
+                        {
+                                __ioc_inode_prune (curr, &size_pruned,
+                                                   size_to_prune, index);
+                        }
+                        ioc_inode_unlock (curr);
 
                         if (size_pruned >= size_to_prune)
                                 break;
-                } /* for(index=0;...) */
+                } /* list_for_each_entry_safe (curr...) */
+
+                if (size_pruned >= size_to_prune)
+                        break;
+        } /* for(index=0;...) */
+}
+
+/*
+ * ioc_prune - prune the cache. we have a limit to the number of pages we
+ *             can have in-memory.
+ *
+ * @table: ioc_table_t of this translator
+ *
+ */
+int32_t
+ioc_prune (ioc_table_t *table)
+{
+        GF_VALIDATE_OR_GOTO ("io-cache", table, out);
 
+        ioc_table_lock (table);
+        {
+                if (table->cache_used > table->cache_size)
+                        __ioc_prune (table,
+                                     table->cache_used - table->cache_size);
         } /* ioc_inode_table locked region end */
         ioc_table_unlock (table);
 
@@ -236,6 +248,52 @@ out:
         return 0;
 }
 
+/*
+ * ioc_cache_usage - bytes held in pages, reported to the cache budget.
+ */
+uint64_t
+ioc_cache_usage (xlator_t *this)
+{
+        ioc_table_t *table = NULL;
+        uint64_t     used  = 0;
+
+        table = this->private;
+
+        ioc_table_lock (table);
+        {
+                used = table->cache_used;
+        }
+        ioc_table_unlock (table);
+
+        return used;
+}
+
+/*
+ * ioc_cache_reclaim - give @bytes back to the cache budget, least recently
+ *                     used pages first. Returns what was actually freed,
+ *                     pages with readers waiting on them are skipped.
+ */
+uint64_t
+ioc_cache_reclaim (xlator_t *this, uint64_t bytes)
+{
+        ioc_table_t *table  = NULL;
+        uint64_t     before = 0;
+        uint64_t     freed  = 0;
+
+        table = this->private;
+
+        ioc_table_lock (table);
+        {
+                before = table->cache_used;
+                __ioc_prune (table, bytes);
+                if (table->cache_used < before)
+                        freed = before - table->cache_used;
+        }
+        ioc_table_unlock (table);
+
+        return freed;
+}
+
 /*
  * __ioc_page_create - create a new page.
  *
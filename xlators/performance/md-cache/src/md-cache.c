@@ -18,6 +18,7 @@
 #include "glusterfs-acl.h"
 #include "defaults.h"
 #include "upcall-utils.h"
+#include "timespec.h"
 #include <assert.h>
 #include <sys/time.h>
 #include "md-cache-messages.h"
@@ -37,10 +38,20 @@ struct mdc_conf {
         gf_boolean_t cache_swift_metadata;
         gf_boolean_t cache_samba_metadata;
         gf_boolean_t mdc_invalidation;
-        time_t last_child_down;
+        int  registration_timeout;
+        gf_boolean_t negative_cache;
+        uint64_t last_child_down;
         gf_lock_t lock;
 };
 
+/* The brick stamps the registration of a client a little before the reply
+ * reaches us, do not trust the last second of the window.
+ */
+#define MDC_REGISTRATION_GRACE  GIGA
+
+/* Names known not to exist kept per directory */
+#define MDC_NEG_ENTRIES_MAX     256
+
 
 static struct mdc_key {
 	const char *name;
@@ -136,12 +147,28 @@ struct md_cache {
         uint64_t      md_blocks;
         dict_t       *xattr;
         char         *linkname;
-	time_t        ia_time;
-	time_t        xa_time;
+	uint64_t      ia_time;
+	uint64_t      xa_time;
+        /* the brick keeps sending us invalidations for this inode since
+         * reg_since, at least until reg_time + registration-timeout
+         */
+        uint64_t      reg_since;
+        uint64_t      reg_time;
+        /* names looked up in this directory and found missing */
+        struct list_head neg_list;
+        uint32_t      neg_count;
+        uint64_t      neg_gen;
         gf_lock_t     lock;
 };
 
 
+struct mdc_neg {
+        struct list_head list;
+        uint64_t         time;
+        char             name[];
+};
+
+
 struct mdc_local {
         loc_t   loc;
         loc_t   loc2;
@@ -149,6 +176,7 @@ struct mdc_local {
         char   *linkname;
 	char   *key;
         dict_t *xattr;
+        uint64_t neg_gen;
 };
 
 
@@ -255,6 +283,33 @@ mdc_local_wipe (xlator_t *this, mdc_local_t *local)
 }
 
 
+static uint64_t
+mdc_time_now (void)
+{
+        struct timespec ts = {0, };
+
+        timespec_now (&ts);
+
+        return TS (ts);
+}
+
+
+static void
+__mdc_inode_neg_purge (struct md_cache *mdc)
+{
+        struct mdc_neg *neg = NULL;
+        struct mdc_neg *tmp = NULL;
+
+        list_for_each_entry_safe (neg, tmp, &mdc->neg_list, list) {
+                list_del (&neg->list);
+                GF_FREE (neg);
+        }
+
+        mdc->neg_count = 0;
+        mdc->neg_gen++;
+}
+
+
 int
 mdc_inode_wipe (xlator_t *this, inode_t *inode)
 {
@@ -268,6 +323,8 @@ mdc_inode_wipe (xlator_t *this, inode_t *inode)
 
         mdc = (void *) (long) mdc_int;
 
+        __mdc_inode_neg_purge (mdc);
+
         if (mdc->xattr)
                 dict_unref (mdc->xattr);
 
@@ -301,6 +358,7 @@ mdc_inode_prep (xlator_t *this, inode_t *inode)
                 }
 
                 LOCK_INIT (&mdc->lock);
+                INIT_LIST_HEAD (&mdc->neg_list);
 
                 ret = __mdc_inode_ctx_set (this, inode, mdc);
                 if (ret) {
@@ -320,16 +378,21 @@ unlock:
 /* Cache is valid if:
  * - It is not cached before any brick was down. Brick down case is handled by
  *   invalidating all the cache when any brick went down.
- * - The cache time is not expired
+ * - The cache time is not expired, or
+ * - with cache-invalidation, the brick has kept us registered for
+ *   invalidations of the inode since before it was cached. As long as that
+ *   registration is held any change is notified, so the cache need not
+ *   expire on md-cache-timeout.
  */
 static gf_boolean_t
-__is_cache_valid (xlator_t *this, time_t mdc_time)
+__is_cache_valid (xlator_t *this, struct md_cache *mdc, uint64_t mdc_time)
 {
-        time_t           now             = 0;
+        uint64_t         now             = 0;
         gf_boolean_t     ret             = _gf_true;
         struct mdc_conf *conf            = NULL;
-        int              timeout         = 0;
-        time_t           last_child_down = 0;
+        uint64_t         timeout         = 0;
+        uint64_t         reg_timeout     = 0;
+        uint64_t         last_child_down = 0;
 
         conf = this->private;
 
@@ -340,9 +403,9 @@ __is_cache_valid (xlator_t *this, time_t mdc_time)
          * is for a very short period of time.
          */
         last_child_down = conf->last_child_down;
-        timeout = conf->timeout;
+        timeout = conf->timeout * GIGA;
 
-        time (&now);
+        now = mdc_time_now ();
 
         if ((mdc_time == 0) ||
             ((last_child_down != 0) && (mdc_time < last_child_down))) {
@@ -350,15 +413,70 @@ __is_cache_valid (xlator_t *this, time_t mdc_time)
                 goto out;
         }
 
-        if (now >= (mdc_time + timeout)) {
-                ret = _gf_false;
-        }
+        if (now < (mdc_time + timeout))
+                goto out;
+
+        ret = _gf_false;
+
+        if (!conf->mdc_invalidation || !conf->registration_timeout)
+                goto out;
+
+        reg_timeout = conf->registration_timeout * GIGA;
+        if (reg_timeout <= MDC_REGISTRATION_GRACE)
+                goto out;
 
+        if ((mdc->reg_since == 0) || (mdc->reg_since < last_child_down) ||
+            (mdc_time < mdc->reg_since))
+                goto out;
+
+        if (now < (mdc->reg_time + reg_timeout - MDC_REGISTRATION_GRACE))
+                ret = _gf_true;
 out:
         return ret;
 }
 
 
+/* Called on replies of fops for which the brick registers us for
+ * invalidations of the inode (see upcall), before the attributes they
+ * brought back are cached.
+ */
+static void
+mdc_inode_registered (xlator_t *this, inode_t *inode)
+{
+        struct mdc_conf *conf = NULL;
+        struct md_cache *mdc  = NULL;
+        uint64_t         now  = 0;
+
+        conf = this->private;
+
+        if (!conf->mdc_invalidation || !conf->registration_timeout)
+                return;
+
+        if (!inode)
+                return;
+
+        mdc = mdc_inode_prep (this, inode);
+        if (!mdc)
+                return;
+
+        now = mdc_time_now ();
+
+        LOCK (&mdc->lock);
+        {
+                /* the registration has lapsed in between, changes made
+                 * since then were not notified
+                 */
+                if ((mdc->reg_time == 0) ||
+                    (now >= (mdc->reg_time +
+                             conf->registration_timeout * GIGA -
+                             MDC_REGISTRATION_GRACE)))
+                        mdc->reg_since = now;
+                mdc->reg_time = now;
+        }
+        UNLOCK (&mdc->lock);
+}
+
+
 static gf_boolean_t
 is_md_cache_iatt_valid (xlator_t *this, struct md_cache *mdc)
 {
@@ -366,7 +484,7 @@ is_md_cache_iatt_valid (xlator_t *this, struct md_cache *mdc)
 
         LOCK (&mdc->lock);
         {
-                ret = __is_cache_valid (this, mdc->ia_time);
+                ret = __is_cache_valid (this, mdc, mdc->ia_time);
                 if (ret == _gf_false)
                         mdc->ia_time = 0;
         }
@@ -383,7 +501,7 @@ is_md_cache_xatt_valid (xlator_t *this, struct md_cache *mdc)
 
         LOCK (&mdc->lock);
         {
-                ret = __is_cache_valid (this, mdc->xa_time);
+                ret = __is_cache_valid (this, mdc, mdc->xa_time);
                 if (ret == _gf_false)
                         mdc->xa_time = 0;
         }
@@ -497,7 +615,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
 
                 mdc_from_iatt (mdc, iatt);
 
-                time (&mdc->ia_time);
+                mdc->ia_time = mdc_time_now ();
         }
 unlock:
         UNLOCK (&mdc->lock);
@@ -647,7 +765,7 @@ mdc_inode_xatt_set (xlator_t *this, inode_t *inode, dict_t *dict)
 		if (newdict)
 			mdc->xattr = newdict;
 
-                time (&mdc->xa_time);
+                mdc->xa_time = mdc_time_now ();
         }
         UNLOCK (&mdc->lock);
         ret = 0;
@@ -677,7 +795,7 @@ mdc_inode_xatt_update (xlator_t *this, inode_t *inode, dict_t *dict)
 			goto out;
 		}
 
-                time (&mdc->xa_time);
+                mdc->xa_time = mdc_time_now ();
         }
         UNLOCK (&mdc->lock);
 
@@ -784,6 +902,141 @@ out:
 }
 
 
+static gf_boolean_t
+mdc_neg_enabled (xlator_t *this)
+{
+        struct mdc_conf *conf = NULL;
+
+        conf = this->private;
+
+        /* without invalidations nobody tells us the name was created */
+        return (conf->negative_cache && conf->mdc_invalidation);
+}
+
+
+static uint64_t
+mdc_inode_neg_gen (xlator_t *this, inode_t *parent)
+{
+        struct md_cache *mdc = NULL;
+        uint64_t         gen = 0;
+
+        mdc = mdc_inode_prep (this, parent);
+        if (!mdc)
+                return 0;
+
+        LOCK (&mdc->lock);
+        {
+                gen = mdc->neg_gen;
+        }
+        UNLOCK (&mdc->lock);
+
+        return gen;
+}
+
+
+/* Remember that @name does not exist in @parent, unless an entry was
+ * created in it since the lookup was sent (@gen changed).
+ */
+static void
+mdc_inode_neg_add (xlator_t *this, inode_t *parent, const char *name,
+                   uint64_t gen)
+{
+        struct md_cache *mdc  = NULL;
+        struct mdc_neg  *neg  = NULL;
+        struct mdc_neg  *tmp  = NULL;
+        size_t           len  = 0;
+
+        if (mdc_inode_ctx_get (this, parent, &mdc) != 0)
+                return;
+
+        len = strlen (name);
+        neg = GF_MALLOC (sizeof (*neg) + len + 1, gf_mdc_mt_mdc_neg_t);
+        if (!neg)
+                return;
+
+        memcpy (neg->name, name, len + 1);
+        neg->time = mdc_time_now ();
+
+        LOCK (&mdc->lock);
+        {
+                if (mdc->neg_gen != gen)
+                        goto unlock;
+
+                list_for_each_entry (tmp, &mdc->neg_list, list) {
+                        if (strcmp (tmp->name, name) == 0) {
+                                tmp->time = neg->time;
+                                list_move (&tmp->list, &mdc->neg_list);
+                                goto unlock;
+                        }
+                }
+
+                if (mdc->neg_count >= MDC_NEG_ENTRIES_MAX) {
+                        tmp = list_entry (mdc->neg_list.prev,
+                                          struct mdc_neg, list);
+                        list_del (&tmp->list);
+                        GF_FREE (tmp);
+                        mdc->neg_count--;
+                }
+
+                list_add (&neg->list, &mdc->neg_list);
+                mdc->neg_count++;
+                neg = NULL;
+        }
+unlock:
+        UNLOCK (&mdc->lock);
+
+        GF_FREE (neg);
+}
+
+
+static gf_boolean_t
+mdc_inode_neg_get (xlator_t *this, inode_t *parent, const char *name)
+{
+        struct md_cache *mdc   = NULL;
+        struct mdc_neg  *neg   = NULL;
+        gf_boolean_t     found = _gf_false;
+
+        if (mdc_inode_ctx_get (this, parent, &mdc) != 0)
+                return _gf_false;
+
+        LOCK (&mdc->lock);
+        {
+                list_for_each_entry (neg, &mdc->neg_list, list) {
+                        if (strcmp (neg->name, name) != 0)
+                                continue;
+
+                        found = __is_cache_valid (this, mdc, neg->time);
+                        if (!found) {
+                                list_del (&neg->list);
+                                GF_FREE (neg);
+                                mdc->neg_count--;
+                        }
+                        break;
+                }
+        }
+        UNLOCK (&mdc->lock);
+
+        return found;
+}
+
+
+/* An entry may have been created in @parent */
+static void
+mdc_inode_neg_invalidate (xlator_t *this, inode_t *parent)
+{
+        struct md_cache *mdc = NULL;
+
+        if (!parent || mdc_inode_ctx_get (this, parent, &mdc) != 0)
+                return;
+
+        LOCK (&mdc->lock);
+        {
+                __mdc_inode_neg_purge (mdc);
+        }
+        UNLOCK (&mdc->lock);
+}
+
+
 void
 mdc_load_reqs (xlator_t *this, dict_t *dict)
 {
@@ -906,17 +1159,28 @@ mdc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
         local = frame->local;
 
-        if (op_ret != 0)
+        if (!local)
                 goto out;
 
-        if (!local)
+        if (op_ret != 0) {
+                if ((op_errno == ENOENT) && local->loc.parent &&
+                    local->loc.name && mdc_neg_enabled (this)) {
+                        /* the brick registered us on the parent, creation
+                         * of the name in it is notified
+                         */
+                        mdc_inode_registered (this, local->loc.parent);
+                        mdc_inode_neg_add (this, local->loc.parent,
+                                           local->loc.name, local->neg_gen);
+                }
                 goto out;
+        }
 
         if (local->loc.parent) {
                 mdc_inode_iatt_set (this, local->loc.parent, postparent);
         }
 
         if (local->loc.inode) {
+                mdc_inode_registered (this, local->loc.inode);
                 mdc_inode_iatt_set (this, local->loc.inode, stbuf);
                 mdc_inode_xatt_set (this, local->loc.inode, dict);
         }
@@ -954,7 +1218,7 @@ mdc_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
 
         ret = mdc_inode_iatt_get (this, loc->inode, &stbuf);
         if (ret != 0)
-                goto uncached;
+                goto negative;
 
         if (xdata) {
                 ret = mdc_inode_xatt_get (this, loc->inode, &xattr_rsp);
@@ -973,7 +1237,20 @@ mdc_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
 
         return 0;
 
+negative:
+        if (!loc->parent || !loc->name || !mdc_neg_enabled (this))
+                goto uncached;
+
+        if (mdc_inode_neg_get (this, loc->parent, loc->name)) {
+                MDC_STACK_UNWIND (lookup, frame, -1, ENOENT, NULL, NULL,
+                                  NULL, NULL);
+                return 0;
+        }
+
 uncached:
+        if (local && loc->parent && loc->name && mdc_neg_enabled (this))
+                local->neg_gen = mdc_inode_neg_gen (this, loc->parent);
+
 	if (!xdata)
 		xdata = xattr_alloc = dict_new ();
 	if (xdata)
@@ -1003,6 +1280,7 @@ mdc_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if (!local)
                 goto out;
 
+        mdc_inode_registered (this, local->loc.inode);
         mdc_inode_iatt_set (this, local->loc.inode, buf);
 
 out:
@@ -1055,6 +1333,7 @@ mdc_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if (!local)
                 goto out;
 
+        mdc_inode_registered (this, local->fd->inode);
         mdc_inode_iatt_set (this, local->fd->inode, buf);
 
 out:
@@ -1194,6 +1473,7 @@ mdc_mknod_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto out;
 
         if (local->loc.parent) {
+                mdc_inode_registered (this, local->loc.parent);
                 mdc_inode_iatt_set (this, local->loc.parent, postparent);
         }
 
@@ -1219,6 +1499,8 @@ mdc_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc,
         loc_copy (&local->loc, loc);
         local->xattr = dict_ref (xdata);
 
+        mdc_inode_neg_invalidate (this, loc->parent);
+
         STACK_WIND (frame, mdc_mknod_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->mknod,
                     loc, mode, rdev, umask, xdata);
@@ -1243,6 +1525,7 @@ mdc_mkdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto out;
 
         if (local->loc.parent) {
+                mdc_inode_registered (this, local->loc.parent);
                 mdc_inode_iatt_set (this, local->loc.parent, postparent);
         }
 
@@ -1268,6 +1551,8 @@ mdc_mkdir (call_frame_t *frame, xlator_t *this, loc_t *loc,
         loc_copy (&local->loc, loc);
         local->xattr = dict_ref (xdata);
 
+        mdc_inode_neg_invalidate (this, loc->parent);
+
         STACK_WIND (frame, mdc_mkdir_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->mkdir,
                     loc, mode, umask, xdata);
@@ -1382,6 +1667,7 @@ mdc_symlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto out;
 
         if (local->loc.parent) {
+                mdc_inode_registered (this, local->loc.parent);
                 mdc_inode_iatt_set (this, local->loc.parent, postparent);
         }
 
@@ -1407,6 +1693,8 @@ mdc_symlink (call_frame_t *frame, xlator_t *this, const char *linkname,
 
         local->linkname = gf_strdup (linkname);
 
+        mdc_inode_neg_invalidate (this, loc->parent);
+
         STACK_WIND (frame, mdc_symlink_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->symlink,
                     linkname, loc, umask, xdata);
@@ -1465,6 +1753,8 @@ mdc_rename (call_frame_t *frame, xlator_t *this,
         loc_copy (&local->loc, oldloc);
         loc_copy (&local->loc2, newloc);
 
+        mdc_inode_neg_invalidate (this, newloc->parent);
+
         STACK_WIND (frame, mdc_rename_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->rename,
                     oldloc, newloc, xdata);
@@ -1512,6 +1802,8 @@ mdc_link (call_frame_t *frame, xlator_t *this,
         loc_copy (&local->loc, oldloc);
         loc_copy (&local->loc2, newloc);
 
+        mdc_inode_neg_invalidate (this, newloc->parent);
+
         STACK_WIND (frame, mdc_link_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->link,
                     oldloc, newloc, xdata);
@@ -1536,6 +1828,7 @@ mdc_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto out;
 
         if (local->loc.parent) {
+                mdc_inode_registered (this, local->loc.parent);
                 mdc_inode_iatt_set (this, local->loc.parent, postparent);
         }
 
@@ -1561,6 +1854,8 @@ mdc_create (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
         loc_copy (&local->loc, loc);
         local->xattr = dict_ref (xdata);
 
+        mdc_inode_neg_invalidate (this, loc->parent);
+
         STACK_WIND (frame, mdc_create_cbk,
                     FIRST_CHILD(this), FIRST_CHILD(this)->fops->create,
                     loc, flags, mode, umask, fd, xdata);
@@ -2391,6 +2686,10 @@ mdc_invalidate (xlator_t *this, void *data)
                 goto out;
         }
 
+        /* entries may have been created in the directory */
+        if (IA_ISDIR (inode->ia_type))
+                mdc_inode_neg_invalidate (this, inode);
+
         if (up_ci->flags & IATT_UPDATE_FLAGS) {
                 ret = mdc_inode_iatt_set_validate (this, inode, NULL,
                                                    &up_ci->stat);
@@ -2401,6 +2700,7 @@ mdc_invalidate (xlator_t *this, void *data)
                 if (ret < 0)
                         goto out;
         }
+
         if (up_ci->flags & UP_XATTR) {
                 ret = mdc_inode_xatt_update (this, inode, up_ci->dict);
         } else if (up_ci->flags & UP_XATTR_RM) {
@@ -2449,6 +2749,10 @@ reconfigure (xlator_t *this, dict_t *options)
 	GF_OPTION_RECONF("force-readdirp", conf->force_readdirp, options, bool, out);
         GF_OPTION_RECONF("cache-invalidation", conf->mdc_invalidation, options,
                          bool, out);
+        GF_OPTION_RECONF ("cache-invalidation-timeout",
+                          conf->registration_timeout, options, int32, out);
+        GF_OPTION_RECONF ("negative-lookup-cache", conf->negative_cache,
+                          options, bool, out);
 
         /* If timeout is greater than 60s (default before the patch that added
          * cache invalidation support was added) then, cache invalidation
@@ -2509,9 +2813,13 @@ init (xlator_t *this)
 
 	GF_OPTION_INIT("force-readdirp", conf->force_readdirp, bool, out);
         GF_OPTION_INIT("cache-invalidation", conf->mdc_invalidation, bool, out);
+        GF_OPTION_INIT ("cache-invalidation-timeout",
+                        conf->registration_timeout, int32, out);
+        GF_OPTION_INIT ("negative-lookup-cache", conf->negative_cache, bool,
+                        out);
 
         LOCK_INIT (&conf->lock);
-        time (&conf->last_child_down);
+        conf->last_child_down = mdc_time_now ();
 
         /* If timeout is greater than 60s (default before the patch that added
          * cache invalidation support was added) then, cache invalidation
@@ -2532,7 +2840,7 @@ out:
 
 
 void
-mdc_update_child_down_time (xlator_t *this, time_t *now)
+mdc_update_child_down_time (xlator_t *this, uint64_t *now)
 {
         struct mdc_conf *conf = NULL;
 
@@ -2551,14 +2859,14 @@ notify (xlator_t *this, int event, void *data, ...)
 {
         int ret = 0;
         struct mdc_conf *conf = NULL;
-        time_t           now = 0;
+        uint64_t         now = 0;
 
         conf = this->private;
         switch (event) {
         case GF_EVENT_CHILD_DOWN:
         case GF_EVENT_SOME_CHILD_DOWN:
         case GF_EVENT_CHILD_MODIFIED:
-                time (&now);
+                now = mdc_time_now ();
                 mdc_update_child_down_time (this, &now);
                 ret = default_notify (this, event, data);
                 break;
@@ -2647,7 +2955,10 @@ struct volume_options options[] = {
           .min = 0,
           .max = 600,
           .default_value = "1",
-          .description = "Time period after which cache has to be refreshed",
+          .description = "Time period after which cache has to be refreshed. "
+                         "With cache-invalidation, metadata is kept for as "
+                         "long as the brick sends invalidations for it, see "
+                         "cache-invalidation-timeout.",
         },
 	{ .key = {"force-readdirp"},
 	  .type = GF_OPTION_TYPE_BOOL,
@@ -2661,5 +2972,25 @@ struct volume_options options[] = {
           .description = "When \"on\", invalidates/updates the metadata cache "
                          "on receiving of the cache-invalidation notifications",
         },
+        { .key = {"cache-invalidation-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 3600,
+          .default_value = "60",
+          .description = "Time the bricks keep sending cache-invalidation "
+                         "notifications to a client after it last accessed "
+                         "a file. Metadata looked up within that time stays "
+                         "cached regardless of md-cache-timeout, 0 disables "
+                         "this. Must not exceed the value used by the "
+                         "bricks.",
+        },
+        { .key = {"negative-lookup-cache"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "false",
+          .description = "Remember names found missing in a directory and "
+                         "fail further lookups of them without reaching the "
+                         "bricks, until an entry is created in the "
+                         "directory. Needs cache-invalidation.",
+        },
     { .key = {NULL} },
 };
@@ -40,7 +40,7 @@
  */
 
 #define GLFS_OPEN_BEHIND_BASE                   GLFS_MSGID_COMP_OPEN_BEHIND
-#define GLFS_OPEN_BEHIND_NUM_MESSAGES           3
+#define GLFS_OPEN_BEHIND_NUM_MESSAGES           4
 #define GLFS_MSGID_END  (GLFS_OPEN_BEHIND_BASE + \
         GLFS_OPEN_BEHIND_NUM_MESSAGES + 1)
 
@@ -77,6 +77,15 @@
 
 #define OPEN_BEHIND_MSG_NO_MEMORY        (GLFS_OPEN_BEHIND_BASE + 3)
 
+/*!
+ * @messageid
+ * @diagnosis A create deferred by lazy-create failed in the backend
+ * @recommendedaction  None
+ *
+ */
+
+#define OPEN_BEHIND_MSG_CREATE_FAILED    (GLFS_OPEN_BEHIND_BASE + 4)
+
 
 /*------------*/
 #define glfs_msg_end_x GLFS_MSGID_END, "Invalid: End of messages"
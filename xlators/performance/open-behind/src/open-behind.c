@@ -14,6 +14,8 @@
 #include "call-stub.h"
 #include "defaults.h"
 #include "open-behind-messages.h"
+#include "timer.h"
+#include "timespec.h"
 
 typedef struct ob_conf {
 	gf_boolean_t  use_anonymous_fd; /* use anonymous FDs wherever safe
@@ -29,6 +31,15 @@ typedef struct ob_conf {
                                                first and then send readv i.e
                                                similar to what writev does
                                             */
+        gf_boolean_t  lazy_create; /* delay the create of files opened for
+                                      writing until a fop needs them */
+        uint32_t      lazy_release_timeout; /* seconds the brick fd shared
+                                               by the read-only fds of an
+                                               inode stays open after the
+                                               last one is released */
+        uint64_t      creates_deferred;
+        uint64_t      shared_reads;
+        uint64_t      shared_opens;
 } ob_conf_t;
 
 
@@ -39,9 +50,27 @@ typedef struct ob_fd {
 	int               flags;
 	int               op_errno;
 	struct list_head  list;
+	mode_t            mode;
+	mode_t            umask;
+	gf_boolean_t      create; /* open_frame winds a create, not an open */
+	gf_boolean_t      shared; /* read-only, reads go to the inode's read_fd */
 } ob_fd_t;
 
 
+typedef struct ob_inode {
+	gf_lock_t         lock;
+	xlator_t         *this;
+	inode_t          *inode;
+	fd_t             *read_fd;  /* opened once, shared by read-only fds */
+	gf_boolean_t      opening;
+	gf_boolean_t      wound;
+	struct list_head  waiters;  /* stubs waiting for read_fd to open */
+	int               users;    /* read-only fds not opened on their own */
+	time_t            idle_since;
+	gf_boolean_t      expiring; /* a timer will release read_fd */
+} ob_inode_t;
+
+
 ob_fd_t *
 __ob_fd_ctx_get (xlator_t *this, fd_t *fd)
 {
@@ -131,14 +160,168 @@ ob_fd_free (ob_fd_t *ob_fd)
 }
 
 
+ob_inode_t *
+__ob_inode_ctx_get (xlator_t *this, inode_t *inode)
+{
+	uint64_t     value = 0;
+	ob_inode_t  *ob_inode = NULL;
+
+	if (__inode_ctx_get (inode, this, &value) == 0)
+		return (void *) ((long) value);
+
+	ob_inode = GF_CALLOC (1, sizeof (*ob_inode), gf_ob_mt_inode_t);
+	if (!ob_inode)
+		return NULL;
+
+	LOCK_INIT (&ob_inode->lock);
+	ob_inode->this = this;
+	ob_inode->inode = inode;
+	INIT_LIST_HEAD (&ob_inode->waiters);
+
+	value = (long) ((void *) ob_inode);
+	if (__inode_ctx_set (inode, this, &value)) {
+		LOCK_DESTROY (&ob_inode->lock);
+		GF_FREE (ob_inode);
+		return NULL;
+	}
+
+	return ob_inode;
+}
+
+
+ob_inode_t *
+ob_inode_ctx_get (xlator_t *this, inode_t *inode)
+{
+	ob_inode_t  *ob_inode = NULL;
+
+	LOCK (&inode->lock);
+	{
+		ob_inode = __ob_inode_ctx_get (this, inode);
+	}
+	UNLOCK (&inode->lock);
+
+	return ob_inode;
+}
+
+
+void
+ob_shared_fd_expire (void *data)
+{
+	ob_inode_t       *ob_inode = data;
+	inode_t          *inode = ob_inode->inode;
+	xlator_t         *this = ob_inode->this;
+	ob_conf_t        *conf = this->private;
+	fd_t             *read_fd = NULL;
+	struct timespec   delay = {0, };
+	time_t            idle = 0;
+
+	LOCK (&ob_inode->lock);
+	{
+		if (ob_inode->users || !ob_inode->read_fd) {
+			ob_inode->expiring = _gf_false;
+			goto unlock;
+		}
+
+		idle = time (NULL) - ob_inode->idle_since;
+		if (ob_inode->opening || idle < conf->lazy_release_timeout) {
+			/* used again since the timer was set */
+			delay.tv_sec = conf->lazy_release_timeout - idle;
+			if (delay.tv_sec <= 0)
+				delay.tv_sec = 1;
+			goto unlock;
+		}
+
+		read_fd = ob_inode->read_fd;
+		ob_inode->read_fd = NULL;
+		ob_inode->expiring = _gf_false;
+	}
+unlock:
+	UNLOCK (&ob_inode->lock);
+
+	if (delay.tv_sec) {
+		if (gf_timer_call_after (this->ctx, delay, ob_shared_fd_expire,
+					 ob_inode))
+			return;
+
+		/* released by the next timer of the inode */
+		LOCK (&ob_inode->lock);
+		{
+			ob_inode->expiring = _gf_false;
+		}
+		UNLOCK (&ob_inode->lock);
+	}
+
+	if (read_fd)
+		fd_unref (read_fd);
+
+	inode_unref (inode);
+}
+
+
 int
-ob_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
-	     int op_ret, int op_errno, fd_t *fd_ret, dict_t *xdata)
+ob_inode_get_user (xlator_t *this, inode_t *inode)
+{
+	ob_inode_t  *ob_inode = NULL;
+
+	ob_inode = ob_inode_ctx_get (this, inode);
+	if (!ob_inode)
+		return -1;
+
+	LOCK (&ob_inode->lock);
+	{
+		ob_inode->users++;
+	}
+	UNLOCK (&ob_inode->lock);
+
+	return 0;
+}
+
+
+void
+ob_inode_put_user (xlator_t *this, inode_t *inode)
+{
+	ob_conf_t        *conf = NULL;
+	ob_inode_t       *ob_inode = NULL;
+	struct timespec   delay = {0, };
+	gf_boolean_t      expire = _gf_false;
+
+	conf = this->private;
+
+	ob_inode = ob_inode_ctx_get (this, inode);
+	if (!ob_inode)
+		return;
+
+	LOCK (&ob_inode->lock);
+	{
+		ob_inode->idle_since = time (NULL);
+		if (--ob_inode->users == 0 && ob_inode->read_fd &&
+		    !ob_inode->expiring)
+			expire = ob_inode->expiring = _gf_true;
+	}
+	UNLOCK (&ob_inode->lock);
+
+	if (!expire)
+		return;
+
+	/* the timer keeps the inode, and so its context, around */
+	inode_ref (inode);
+
+	delay.tv_sec = conf->lazy_release_timeout;
+	if (!gf_timer_call_after (this->ctx, delay, ob_shared_fd_expire,
+				  ob_inode))
+		ob_shared_fd_expire (ob_inode);
+}
+
+
+int
+ob_fd_wake_done (call_frame_t *frame, xlator_t *this, int op_ret,
+		 int op_errno)
 {
 	fd_t              *fd = NULL;
 	struct list_head   list;
 	ob_fd_t           *ob_fd = NULL;
 	call_stub_t       *stub = NULL, *tmp = NULL;
+	gf_boolean_t       shared = _gf_false;
 
 	fd = frame->local;
 	frame->local = NULL;
@@ -156,11 +339,16 @@ ob_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 			ob_fd->op_errno = op_errno;
 		} else {
 			__fd_ctx_del (fd, this, NULL);
+			shared = ob_fd->shared;
 			ob_fd_free (ob_fd);
 		}
 	}
 	UNLOCK (&fd->lock);
 
+	/* opened on its own now */
+	if (shared)
+		ob_inode_put_user (this, fd->inode);
+
 	list_for_each_entry_safe (stub, tmp, &list, list) {
 		list_del_init (&stub->list);
 
@@ -178,6 +366,29 @@ ob_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+int
+ob_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+	     int op_ret, int op_errno, fd_t *fd_ret, dict_t *xdata)
+{
+	return ob_fd_wake_done (frame, this, op_ret, op_errno);
+}
+
+
+int
+ob_create_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+		    int op_ret, int op_errno, fd_t *fd_ret, inode_t *inode,
+		    struct iatt *buf, struct iatt *preparent,
+		    struct iatt *postparent, dict_t *xdata)
+{
+	if (op_ret < 0)
+		gf_msg (this->name, GF_LOG_WARNING, op_errno,
+			OPEN_BEHIND_MSG_CREATE_FAILED,
+			"deferred create failed, fops on the fd will fail");
+
+	return ob_fd_wake_done (frame, this, op_ret, op_errno);
+}
+
+
 int
 ob_fd_wake (xlator_t *this, fd_t *fd)
 {
@@ -199,9 +410,17 @@ unlock:
 	if (frame) {
 		frame->local = fd_ref (fd);
 
-		STACK_WIND (frame, ob_wake_cbk, FIRST_CHILD (this),
-			    FIRST_CHILD (this)->fops->open,
-			    &ob_fd->loc, ob_fd->flags, fd, ob_fd->xdata);
+		if (ob_fd->create)
+			STACK_WIND (frame, ob_create_wake_cbk,
+				    FIRST_CHILD (this),
+				    FIRST_CHILD (this)->fops->create,
+				    &ob_fd->loc, ob_fd->flags, ob_fd->mode,
+				    ob_fd->umask, fd, ob_fd->xdata);
+		else
+			STACK_WIND (frame, ob_wake_cbk, FIRST_CHILD (this),
+				    FIRST_CHILD (this)->fops->open,
+				    &ob_fd->loc, ob_fd->flags, fd,
+				    ob_fd->xdata);
 	}
 
 	return 0;
@@ -245,6 +464,227 @@ nofd:
 }
 
 
+/* fd of a create not sent to the bricks yet */
+fd_t *
+ob_pending_create_fd (xlator_t *this, inode_t *inode)
+{
+	fd_t          *fd = NULL;
+	ob_fd_t       *ob_fd = NULL;
+	gf_boolean_t   pending = _gf_false;
+
+	if (!inode)
+		return NULL;
+
+	fd = fd_lookup (inode, 0);
+	if (!fd)
+		return NULL;
+
+	LOCK (&fd->lock);
+	{
+		ob_fd = __ob_fd_ctx_get (this, fd);
+		if (ob_fd && ob_fd->create)
+			pending = _gf_true;
+	}
+	UNLOCK (&fd->lock);
+
+	if (!pending) {
+		fd_unref (fd);
+		fd = NULL;
+	}
+
+	return fd;
+}
+
+
+void
+ob_shared_fd_opened (xlator_t *this, fd_t *read_fd, int op_ret, int op_errno)
+{
+	ob_inode_t        *ob_inode = NULL;
+	struct list_head   list;
+	call_stub_t       *stub = NULL, *tmp = NULL;
+	gf_boolean_t       drop = _gf_false;
+
+	INIT_LIST_HEAD (&list);
+
+	ob_inode = ob_inode_ctx_get (this, read_fd->inode);
+
+	LOCK (&ob_inode->lock);
+	{
+		list_splice_init (&ob_inode->waiters, &list);
+		ob_inode->opening = _gf_false;
+		ob_inode->wound = _gf_false;
+
+		if (op_ret < 0 && ob_inode->read_fd == read_fd) {
+			ob_inode->read_fd = NULL;
+			drop = _gf_true;
+		}
+	}
+	UNLOCK (&ob_inode->lock);
+
+	list_for_each_entry_safe (stub, tmp, &list, list) {
+		list_del_init (&stub->list);
+
+		if (op_ret < 0)
+			call_unwind_error (stub, -1, op_errno);
+		else
+			call_resume (stub);
+	}
+
+	if (drop)
+		fd_unref (read_fd);
+}
+
+
+int
+ob_shared_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+		    int op_ret, int op_errno, fd_t *fd, dict_t *xdata)
+{
+	ob_shared_fd_opened (this, cookie, op_ret, op_errno);
+
+	STACK_DESTROY (frame->root);
+
+	return 0;
+}
+
+
+void
+ob_shared_fd_open (call_frame_t *frame, xlator_t *this, fd_t *fd,
+		   fd_t *read_fd)
+{
+	ob_conf_t     *conf = NULL;
+	call_frame_t  *open_frame = NULL;
+	ob_fd_t       *ob_fd = NULL;
+	loc_t          loc = {0, };
+	int            ret = -1;
+
+	conf = this->private;
+
+	LOCK (&fd->lock);
+	{
+		ob_fd = __ob_fd_ctx_get (this, fd);
+		if (ob_fd)
+			ret = loc_copy (&loc, &ob_fd->loc);
+	}
+	UNLOCK (&fd->lock);
+
+	if (ret == 0)
+		open_frame = copy_frame (frame);
+
+	if (!open_frame) {
+		loc_wipe (&loc);
+		ob_shared_fd_opened (this, read_fd, -1, ENOMEM);
+		return;
+	}
+
+	__sync_fetch_and_add (&conf->shared_opens, 1);
+
+	STACK_WIND_COOKIE (open_frame, ob_shared_open_cbk, read_fd,
+			   FIRST_CHILD (this), FIRST_CHILD (this)->fops->open,
+			   &loc, O_RDONLY, read_fd, NULL);
+
+	loc_wipe (&loc);
+}
+
+
+/*
+ * Read-only fds never opened on the bricks read through one fd of the
+ * inode, which is opened by the first read and released only when no such
+ * fd has been around for lazy-release-timeout seconds. Hot files opened,
+ * read and closed again and again keep their brick fd.
+ */
+fd_t *
+ob_shared_fd_get (xlator_t *this, fd_t *fd)
+{
+	ob_fd_t       *ob_fd = NULL;
+	ob_inode_t    *ob_inode = NULL;
+	fd_t          *read_fd = NULL;
+	gf_boolean_t   shared = _gf_false;
+
+	LOCK (&fd->lock);
+	{
+		ob_fd = __ob_fd_ctx_get (this, fd);
+		if (ob_fd && ob_fd->shared && ob_fd->open_frame &&
+		    !ob_fd->op_errno)
+			shared = _gf_true;
+	}
+	UNLOCK (&fd->lock);
+
+	if (!shared)
+		return NULL;
+
+	ob_inode = ob_inode_ctx_get (this, fd->inode);
+	if (!ob_inode)
+		return NULL;
+
+	LOCK (&ob_inode->lock);
+	{
+		if (!ob_inode->read_fd) {
+			ob_inode->read_fd = fd_create (fd->inode, 0);
+			ob_inode->opening = (ob_inode->read_fd != NULL);
+		}
+
+		if (ob_inode->read_fd)
+			read_fd = fd_ref (ob_inode->read_fd);
+	}
+	UNLOCK (&ob_inode->lock);
+
+	return read_fd;
+}
+
+
+int
+ob_shared_fd_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
+		     fd_t *read_fd, call_stub_t *stub)
+{
+	ob_inode_t    *ob_inode = NULL;
+	int            op_errno = 0;
+	gf_boolean_t   queued = _gf_false;
+	gf_boolean_t   wind = _gf_false;
+
+	ob_inode = ob_inode_ctx_get (this, read_fd->inode);
+	if (!ob_inode) {
+		op_errno = ENOMEM;
+		goto out;
+	}
+
+	LOCK (&ob_inode->lock);
+	{
+		if (ob_inode->read_fd != read_fd) {
+			/* its open failed */
+			op_errno = EBADFD;
+		} else if (ob_inode->opening) {
+			list_add_tail (&stub->list, &ob_inode->waiters);
+			queued = _gf_true;
+			if (!ob_inode->wound)
+				wind = ob_inode->wound = _gf_true;
+		}
+	}
+	UNLOCK (&ob_inode->lock);
+
+out:
+	if (op_errno)
+		call_unwind_error (stub, -1, op_errno);
+	else if (!queued)
+		call_resume (stub);
+	else if (wind)
+		ob_shared_fd_open (frame, this, fd, read_fd);
+
+	return 0;
+}
+
+
+gf_boolean_t
+ob_open_shareable (xlator_t *this, int flags)
+{
+	ob_conf_t  *conf = NULL;
+
+	conf = this->private;
+
+	return (conf->lazy_open && conf->lazy_release_timeout &&
+		(flags & O_ACCMODE) == O_RDONLY && !(flags & O_TRUNC));
+}
+
+
 int
 ob_open_behind (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
 		fd_t *fd, dict_t *xdata)
@@ -278,9 +718,16 @@ ob_open_behind (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
 	if (xdata)
 		ob_fd->xdata = dict_ref (xdata);
 
+	if (ob_open_shareable (this, flags) &&
+	    ob_inode_get_user (this, fd->inode) == 0)
+		ob_fd->shared = _gf_true;
+
 	ret = ob_fd_ctx_set (this, fd, ob_fd);
-	if (ret)
+	if (ret) {
+		if (ob_fd->shared)
+			ob_inode_put_user (this, fd->inode);
 		goto enomem;
+	}
 
 	fd_ref (fd);
 
@@ -311,11 +758,22 @@ ob_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
 	 fd_t *fd, dict_t *xdata)
 {
 	fd_t         *old_fd = NULL;
+	ob_fd_t      *ob_fd = NULL;
 	int           ret = -1;
 	int           op_errno = 0;
 	call_stub_t  *stub = NULL;
 
 	old_fd = fd_lookup (fd->inode, 0);
+	if (old_fd && ob_open_shareable (this, flags)) {
+		/* read-only fds need not be ordered after others opened
+		   already, only after the ones still to be opened */
+		ob_fd = ob_fd_ctx_get (this, old_fd);
+		if (!ob_fd || ob_fd->shared) {
+			fd_unref (old_fd);
+			old_fd = NULL;
+		}
+	}
+
 	if (old_fd) {
 		/* open-behind only when this is the first FD */
 		stub = fop_open_stub (frame, default_open_resume,
@@ -350,6 +808,119 @@ err:
 }
 
 
+dict_t *
+ob_create_xdata (dict_t *xdata, void *gfid_req)
+{
+	dict_t  *dict = NULL;
+	void    *gfid = NULL;
+
+	/* gfid-req may point to memory of the caller of the create */
+	dict = dict_copy_with_ref (xdata, NULL);
+	if (!dict)
+		return NULL;
+
+	gfid = GF_MALLOC (sizeof (uuid_t), gf_common_mt_char);
+	if (!gfid)
+		goto err;
+
+	gf_uuid_copy (gfid, gfid_req);
+	if (dict_set_dynptr (dict, "gfid-req", gfid, sizeof (uuid_t))) {
+		GF_FREE (gfid);
+		goto err;
+	}
+
+	return dict;
+err:
+	dict_unref (dict);
+	return NULL;
+}
+
+
+/*
+ * A file created to be written is created on the bricks just before the
+ * first fop on its fd (usually the first write) or on its inode, and the
+ * create is answered right away with the attributes the file will have.
+ * The gfid comes from gfid-req, files created without one are created
+ * right away. Until then the file is not listed in its directory, and an
+ * error of the create is returned by the fops on the fd.
+ */
+int
+ob_create (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+	   mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+	ob_conf_t        *conf = NULL;
+	ob_fd_t          *ob_fd = NULL;
+	void             *gfid_req = NULL;
+	struct iatt       buf = {0, };
+	struct iatt       parent = {0, };
+	struct timespec   now = {0, };
+	int               ret = -1;
+
+	conf = this->private;
+
+	if (!conf->lazy_create || (flags & O_ACCMODE) != O_WRONLY ||
+	    (flags & O_EXCL) || !xdata ||
+	    dict_get_ptr (xdata, "gfid-req", &gfid_req) || !gfid_req)
+		goto wind;
+
+	ob_fd = ob_fd_new ();
+	if (!ob_fd)
+		goto wind;
+
+	ob_fd->open_frame = copy_frame (frame);
+	if (!ob_fd->open_frame)
+		goto err;
+	ret = loc_copy (&ob_fd->loc, loc);
+	if (ret)
+		goto err;
+	ob_fd->xdata = ob_create_xdata (xdata, gfid_req);
+	if (!ob_fd->xdata)
+		goto err;
+
+	ob_fd->flags = flags;
+	ob_fd->mode = mode;
+	ob_fd->umask = umask;
+	ob_fd->create = _gf_true;
+
+	ret = ob_fd_ctx_set (this, fd, ob_fd);
+	if (ret)
+		goto err;
+
+	__sync_fetch_and_add (&conf->creates_deferred, 1);
+
+	gf_uuid_copy (buf.ia_gfid, gfid_req);
+	buf.ia_ino = gfid_to_ino (buf.ia_gfid);
+	buf.ia_type = IA_IFREG;
+	buf.ia_prot = ia_prot_from_st_mode (mode & ~umask);
+	buf.ia_nlink = 1;
+	buf.ia_uid = frame->root->uid;
+	buf.ia_gid = frame->root->gid;
+	buf.ia_blksize = 4096;
+
+	timespec_now (&now);
+	buf.ia_atime = buf.ia_mtime = buf.ia_ctime = now.tv_sec;
+	buf.ia_atime_nsec = buf.ia_mtime_nsec = buf.ia_ctime_nsec = now.tv_nsec;
+
+	fd_ref (fd);
+
+	/* the attributes of the parent are not known, they are all zero so
+	   that caches above drop theirs */
+	STACK_UNWIND_STRICT (create, frame, 0, 0, fd, fd->inode, &buf,
+			     &parent, &parent, NULL);
+
+	fd_unref (fd);
+
+	return 0;
+err:
+	ob_fd_free (ob_fd);
+wind:
+	STACK_WIND (frame, default_create_cbk, FIRST_CHILD (this),
+		    FIRST_CHILD (this)->fops->create, loc, flags, mode, umask,
+		    fd, xdata);
+	return 0;
+}
+
+
 fd_t *
 ob_get_wind_fd (xlator_t *this, fd_t *fd)
 {
@@ -360,7 +931,8 @@ ob_get_wind_fd (xlator_t *this, fd_t *fd)
 
 	ob_fd = ob_fd_ctx_get (this, fd);
 
-	if (ob_fd && conf->use_anonymous_fd)
+	/* a file still to be created cannot be read on an anonymous fd */
+	if (ob_fd && !ob_fd->create && conf->use_anonymous_fd)
 		return fd_anonymous (fd->inode);
 
 	return fd_ref (fd);
@@ -373,10 +945,27 @@ ob_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 {
 	call_stub_t  *stub = NULL;
 	fd_t         *wind_fd = NULL;
+	fd_t         *read_fd = NULL;
         ob_conf_t    *conf = NULL;
 
         conf = this->private;
 
+	read_fd = ob_shared_fd_get (this, fd);
+	if (read_fd) {
+		stub = fop_readv_stub (frame, default_readv_resume, read_fd,
+				       size, offset, flags, xdata);
+		if (!stub) {
+			fd_unref (read_fd);
+			goto err;
+		}
+
+		__sync_fetch_and_add (&conf->shared_reads, 1);
+		ob_shared_fd_resume (frame, this, fd, read_fd, stub);
+		fd_unref (read_fd);
+
+		return 0;
+	}
+
         if (!conf->read_after_open)
                 wind_fd = ob_get_wind_fd (this, fd);
         else
@@ -426,6 +1015,22 @@ ob_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 {
 	call_stub_t  *stub = NULL;
 	fd_t         *wind_fd = NULL;
+	fd_t         *read_fd = NULL;
+
+	read_fd = ob_shared_fd_get (this, fd);
+	if (read_fd) {
+		stub = fop_fstat_stub (frame, default_fstat_resume, read_fd,
+				       xdata);
+		if (!stub) {
+			fd_unref (read_fd);
+			goto err;
+		}
+
+		ob_shared_fd_resume (frame, this, fd, read_fd, stub);
+		fd_unref (read_fd);
+
+		return 0;
+	}
 
 	wind_fd = ob_get_wind_fd (this, fd);
 
@@ -456,9 +1061,10 @@ ob_flush (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 	LOCK (&fd->lock);
 	{
 		ob_fd = __ob_fd_ctx_get (this, fd);
-		if (ob_fd && ob_fd->open_frame)
+		if (ob_fd && ob_fd->open_frame && !ob_fd->create)
 			/* if open() was never wound to backend,
-			   no need to wind flush() either.
+			   no need to wind flush() either. A create
+			   still has to be, the file is closed empty.
 			*/
 			unwind = _gf_true;
 	}
@@ -751,6 +1357,255 @@ err:
 }
 
 
+/*
+ * Fops on the inode of a file still to be created have it created first.
+ */
+int
+ob_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_lookup_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->lookup, loc, xdata);
+		return 0;
+	}
+
+	stub = fop_lookup_stub (frame, default_lookup_resume, loc, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (lookup, frame, -1, ENOMEM, NULL, NULL, NULL,
+				     NULL);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_stat (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_stat_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->stat, loc, xdata);
+		return 0;
+	}
+
+	stub = fop_stat_stub (frame, default_stat_resume, loc, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (stat, frame, -1, ENOMEM, 0, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_access (call_frame_t *frame, xlator_t *this, loc_t *loc, int mask,
+	   dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_access_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->access,
+			    loc, mask, xdata);
+		return 0;
+	}
+
+	stub = fop_access_stub (frame, default_access_resume, loc, mask,
+				xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (access, frame, -1, ENOMEM, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+	    struct iatt *stbuf, int valid, dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_setattr_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->setattr,
+			    loc, stbuf, valid, xdata);
+		return 0;
+	}
+
+	stub = fop_setattr_stub (frame, default_setattr_resume, loc, stbuf,
+				 valid, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (setattr, frame, -1, ENOMEM, 0, 0, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+	     dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_truncate_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->truncate,
+			    loc, offset, xdata);
+		return 0;
+	}
+
+	stub = fop_truncate_stub (frame, default_truncate_resume, loc, offset,
+				  xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (truncate, frame, -1, ENOMEM, 0, 0, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_setxattr (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+	     int flags, dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_setxattr_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->setxattr,
+			    loc, dict, flags, xdata);
+		return 0;
+	}
+
+	stub = fop_setxattr_stub (frame, default_setxattr_resume, loc, dict,
+				  flags, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (setxattr, frame, -1, ENOMEM, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc, const char *name,
+	     dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_getxattr_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->getxattr,
+			    loc, name, xdata);
+		return 0;
+	}
+
+	stub = fop_getxattr_stub (frame, default_getxattr_resume, loc, name,
+				  xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (getxattr, frame, -1, ENOMEM, 0, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_removexattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+		const char *name, dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_removexattr_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->removexattr,
+			    loc, name, xdata);
+		return 0;
+	}
+
+	stub = fop_removexattr_stub (frame, default_removexattr_resume, loc,
+				     name, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (removexattr, frame, -1, ENOMEM, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
+int
+ob_link (call_frame_t *frame, xlator_t *this, loc_t *loc, loc_t *newloc,
+	 dict_t *xdata)
+{
+	call_stub_t  *stub = NULL;
+	fd_t         *fd = NULL;
+
+	fd = ob_pending_create_fd (this, loc->inode);
+	if (!fd) {
+		STACK_WIND (frame, default_link_cbk, FIRST_CHILD (this),
+			    FIRST_CHILD (this)->fops->link,
+			    loc, newloc, xdata);
+		return 0;
+	}
+
+	stub = fop_link_stub (frame, default_link_resume, loc, newloc, xdata);
+	if (stub)
+		open_and_resume (this, fd, stub);
+	else
+		STACK_UNWIND_STRICT (link, frame, -1, ENOMEM, 0, 0, 0, 0, 0);
+
+	fd_unref (fd);
+
+	return 0;
+}
+
+
 int
 ob_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
 	   dict_t *xdata)
@@ -790,6 +1645,8 @@ ob_rename (call_frame_t *frame, xlator_t *this, loc_t *src, loc_t *dst,
 
 	if (dst->inode)
 		fd = fd_lookup (dst->inode, 0);
+	if (!fd)
+		fd = ob_pending_create_fd (this, src->inode);
 
 	open_and_resume (this, fd, stub);
         if (fd)
@@ -809,6 +1666,11 @@ ob_release (xlator_t *this, fd_t *fd)
 	ob_fd_t *ob_fd = NULL;
 
 	ob_fd = ob_fd_ctx_get (this, fd);
+	if (!ob_fd)
+		return 0;
+
+	if (ob_fd->shared)
+		ob_inode_put_user (this, fd->inode);
 
 	ob_fd_free (ob_fd);
 
@@ -816,6 +1678,24 @@ ob_release (xlator_t *this, fd_t *fd)
 }
 
 
+int
+ob_forget (xlator_t *this, inode_t *inode)
+{
+	ob_inode_t  *ob_inode = NULL;
+	uint64_t     value = 0;
+
+	inode_ctx_del (inode, this, &value);
+
+	ob_inode = (void *) ((long) value);
+	if (ob_inode) {
+		LOCK_DESTROY (&ob_inode->lock);
+		GF_FREE (ob_inode);
+	}
+
+	return 0;
+}
+
+
 int
 ob_priv_dump (xlator_t *this)
 {
@@ -836,6 +1716,18 @@ ob_priv_dump (xlator_t *this)
 
         gf_proc_dump_write ("lazy_open", "%d", conf->lazy_open);
 
+        gf_proc_dump_write ("lazy_create", "%d", conf->lazy_create);
+
+        gf_proc_dump_write ("lazy_release_timeout", "%u",
+                            conf->lazy_release_timeout);
+
+        gf_proc_dump_write ("creates_deferred", "%"PRIu64,
+                            conf->creates_deferred);
+
+        gf_proc_dump_write ("shared_reads", "%"PRIu64, conf->shared_reads);
+
+        gf_proc_dump_write ("shared_opens", "%"PRIu64, conf->shared_opens);
+
         return 0;
 }
 
@@ -875,6 +1767,10 @@ ob_fdctx_dump (xlator_t *this, fd_t *fd)
 
         gf_proc_dump_write ("flags", "%d", ob_fd->flags);
 
+        gf_proc_dump_write ("create", "%d", ob_fd->create);
+
+        gf_proc_dump_write ("shared", "%d", ob_fd->shared);
+
 	UNLOCK (&fd->lock);
 
 	return 0;
@@ -911,6 +1807,10 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("lazy-open", conf->lazy_open, options, bool, out);
         GF_OPTION_RECONF ("read-after-open", conf->read_after_open, options,
                           bool, out);
+        GF_OPTION_RECONF ("lazy-create", conf->lazy_create, options, bool,
+                          out);
+        GF_OPTION_RECONF ("lazy-release-timeout", conf->lazy_release_timeout,
+                          options, uint32, out);
 
         ret = 0;
 out:
@@ -944,6 +1844,9 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("lazy-open", conf->lazy_open, bool, err);
         GF_OPTION_INIT ("read-after-open", conf->read_after_open, bool, err);
+        GF_OPTION_INIT ("lazy-create", conf->lazy_create, bool, err);
+        GF_OPTION_INIT ("lazy-release-timeout", conf->lazy_release_timeout,
+                        uint32, err);
         this->private = conf;
 
 	return 0;
@@ -970,6 +1873,7 @@ fini (xlator_t *this)
 
 struct xlator_fops fops = {
         .open        = ob_open,
+        .create      = ob_create,
         .readv       = ob_readv,
         .writev      = ob_writev,
 	.flush       = ob_flush,
@@ -989,10 +1893,20 @@ struct xlator_fops fops = {
 	.unlink      = ob_unlink,
 	.rename      = ob_rename,
 	.lk          = ob_lk,
+	.lookup      = ob_lookup,
+	.stat        = ob_stat,
+	.access      = ob_access,
+	.setattr     = ob_setattr,
+	.truncate    = ob_truncate,
+	.setxattr    = ob_setxattr,
+	.getxattr    = ob_getxattr,
+	.removexattr = ob_removexattr,
+	.link        = ob_link,
 };
 
 struct xlator_cbks cbks = {
         .release  = ob_release,
+        .forget   = ob_forget,
 };
 
 struct xlator_dumpops dumpops = {
@@ -1021,6 +1935,24 @@ struct volume_options options[] = {
           .description = "read is sent only after actual open happens and real "
           "fd is obtained, instead of doing on anonymous fd (similar to write)",
         },
+        { .key  = {"lazy-create"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "no",
+          .description = "Create files opened write-only (and not O_EXCL) in "
+          "the backend only when the first FOP on them arrives, usually the "
+          "first write. Until then the file is not listed in its directory, "
+          "and errors of the create are returned by the FOPs on the FD.",
+        },
+        { .key  = {"lazy-release-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 60,
+          .default_value = "0",
+          .description = "Read-only FDs read through one backend FD of the "
+          "file, opened on the first read and released this many seconds "
+          "after the last such FD is closed. Files opened, read and closed "
+          "repeatedly keep their backend FD. 0 disables it.",
+        },
         { .key  = {NULL} }
 
 };
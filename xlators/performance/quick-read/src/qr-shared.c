@@ -0,0 +1,533 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <sys/mman.h>
+
+#include "quick-read.h"
+#include "qr-shared.h"
+#include "statedump.h"
+#include "syscall.h"
+#include "quick-read-messages.h"
+
+/* how long to wait for another process to finish creating the cache */
+#define QR_SHM_ATTACH_TRIES     100
+#define QR_SHM_ATTACH_USEC      10000
+
+
+static size_t
+qr_shm_header_size (void)
+{
+        return roof (sizeof (qr_shm_header_t), getpagesize ());
+}
+
+
+static size_t
+qr_shm_entries_size (uint64_t nsets)
+{
+        return roof (nsets * QR_SHM_WAYS * sizeof (qr_shm_entry_t),
+                     getpagesize ());
+}
+
+
+static size_t
+qr_shm_map_size (uint64_t nsets, uint64_t slot_size)
+{
+        return qr_shm_header_size () + qr_shm_entries_size (nsets)
+                + (nsets * QR_SHM_WAYS * slot_size);
+}
+
+
+static int
+qr_shm_map (qr_shm_t *shm, int fd, size_t size)
+{
+        void *addr = NULL;
+
+        addr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+                return -1;
+
+        shm->hdr = addr;
+        shm->map_size = size;
+        shm->entries = (void *)((char *)addr + qr_shm_header_size ());
+        shm->slots = (char *)shm->entries
+                + qr_shm_entries_size (shm->hdr->nsets);
+
+        return 0;
+}
+
+
+static int
+qr_shm_create (qr_shm_t *shm, int fd, uint64_t nsets, uint64_t slot_size)
+{
+        pthread_mutexattr_t  attr;
+        size_t               size = 0;
+        int                  i    = 0;
+
+        size = qr_shm_map_size (nsets, slot_size);
+
+        if (sys_ftruncate (fd, size) != 0)
+                return -1;
+
+        if (qr_shm_map (shm, fd, qr_shm_header_size ()) != 0)
+                return -1;
+
+        shm->hdr->version = QR_SHM_VERSION;
+        shm->hdr->slot_size = slot_size;
+        shm->hdr->nsets = nsets;
+        shm->hdr->tick = 0;
+
+        pthread_mutexattr_init (&attr);
+        pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+        for (i = 0; i < QR_SHM_STRIPES; i++)
+                pthread_mutex_init (&shm->hdr->stripes[i], &attr);
+        pthread_mutexattr_destroy (&attr);
+
+        munmap (shm->hdr, shm->map_size);
+        shm->hdr = NULL;
+
+        /* entries and slots are zero filled by ftruncate, i.e. invalid */
+        if (qr_shm_map (shm, fd, size) != 0)
+                return -1;
+
+        __sync_synchronize ();
+        shm->hdr->magic = QR_SHM_MAGIC;
+
+        return 0;
+}
+
+
+/* returns -EPERM when the file may have been planted by another user,
+ * and -EAGAIN when it is left over from a creator which died half way or
+ * from an incompatible version */
+static int
+qr_shm_attach (qr_shm_t *shm, int fd)
+{
+        struct stat          stbuf      = {0,};
+        qr_shm_header_t     *hdr        = NULL;
+        uint64_t             nsets      = 0;
+        uint64_t             slot_size  = 0;
+        uint32_t             version    = 0;
+        int                  i          = 0;
+        int                  ret        = -EAGAIN;
+
+        /* the cached contents and the locks in it are trusted as they are,
+         * only a file no other user could have written to will do */
+        if (sys_fstat (fd, &stbuf) != 0)
+                return -errno;
+
+        if (!S_ISREG (stbuf.st_mode) || (stbuf.st_uid != geteuid ()) ||
+            (stbuf.st_mode & (S_IRWXG | S_IRWXO)))
+                return -EPERM;
+
+        for (i = 0; i < QR_SHM_ATTACH_TRIES; i++) {
+                if (sys_fstat (fd, &stbuf) != 0)
+                        return -errno;
+
+                if (stbuf.st_size >= qr_shm_header_size ())
+                        break;
+
+                usleep (QR_SHM_ATTACH_USEC);
+        }
+
+        if (stbuf.st_size < qr_shm_header_size ())
+                return -EAGAIN;
+
+        hdr = mmap (NULL, qr_shm_header_size (), PROT_READ, MAP_SHARED, fd, 0);
+        if (hdr == MAP_FAILED)
+                return -errno;
+
+        for (i = 0; i < QR_SHM_ATTACH_TRIES; i++) {
+                if (hdr->magic == QR_SHM_MAGIC)
+                        break;
+
+                usleep (QR_SHM_ATTACH_USEC);
+        }
+
+        __sync_synchronize ();
+        version = hdr->version;
+        nsets = hdr->nsets;
+        slot_size = hdr->slot_size;
+
+        if ((hdr->magic != QR_SHM_MAGIC) || (version != QR_SHM_VERSION) ||
+            !nsets || !slot_size)
+                goto out;
+
+        if (stbuf.st_size != qr_shm_map_size (nsets, slot_size))
+                goto out;
+
+        ret = (qr_shm_map (shm, fd, stbuf.st_size) == 0) ? 0 : -errno;
+out:
+        munmap (hdr, qr_shm_header_size ());
+
+        return ret;
+}
+
+
+qr_shm_t *
+qr_shm_open (xlator_t *this, const char *dir, const char *volume_id,
+             uint64_t size, uint64_t slot_size)
+{
+        qr_shm_t *shm     = NULL;
+        uint64_t  nsets   = 0;
+        int       fd      = -1;
+        int       ret     = -1;
+
+        shm = GF_CALLOC (1, sizeof (*shm), gf_qr_mt_qr_shm_t);
+        if (!shm)
+                goto out;
+
+        /* volfiles not generated by glusterd may not have the volume id */
+        if (volume_id)
+                ret = gf_asprintf (&shm->path, "%s/glusterfs-qr.%s.%s", dir,
+                                   volume_id, this->name);
+        else
+                ret = gf_asprintf (&shm->path, "%s/glusterfs-qr.%s", dir,
+                                   this->name);
+        if (ret < 0)
+                goto out;
+        ret = -1;
+
+        slot_size = roof (max (slot_size, 1), 64);
+        nsets = size / (slot_size * QR_SHM_WAYS);
+        if (!nsets)
+                nsets = 1;
+
+        fd = open (shm->path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW |
+                   O_CLOEXEC, 0600);
+        if (fd >= 0) {
+                ret = qr_shm_create (shm, fd, nsets, slot_size);
+                if (ret) {
+                        ret = -errno;
+                        /* nobody got to use it yet */
+                        sys_unlink (shm->path);
+                }
+                sys_close (fd);
+        } else if (errno == EEXIST) {
+                fd = open (shm->path, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+                if (fd < 0) {
+                        ret = -errno;
+                } else {
+                        /* on a bad header only this process stays away,
+                         * others may be using the file */
+                        ret = qr_shm_attach (shm, fd);
+                        sys_close (fd);
+                }
+        } else {
+                ret = -errno;
+        }
+
+        if (ret) {
+                gf_msg (this->name, GF_LOG_WARNING, -ret,
+                        QUICK_READ_MSG_SHARED_CACHE_FAILED,
+                        "could not set up the shared cache %s, caching "
+                        "privately", shm->path);
+                goto out;
+        }
+
+        gf_msg (this->name, GF_LOG_INFO, 0, QUICK_READ_MSG_SHARED_CACHE,
+                "using shared cache %s (%"PRIu64" files of up to %"PRIu64
+                " bytes)", shm->path, shm->hdr->nsets * QR_SHM_WAYS,
+                shm->hdr->slot_size);
+out:
+        if (ret && shm) {
+                GF_FREE (shm->path);
+                GF_FREE (shm);
+                shm = NULL;
+        }
+
+        return shm;
+}
+
+
+void
+qr_shm_close (qr_shm_t *shm)
+{
+        if (!shm)
+                return;
+
+        /* the file stays, other processes may still be using it */
+        if (shm->hdr)
+                munmap (shm->hdr, shm->map_size);
+
+        GF_FREE (shm->path);
+        GF_FREE (shm);
+}
+
+
+static uint64_t
+qr_shm_set (qr_shm_t *shm, uuid_t gfid)
+{
+        uint64_t hash = 0;
+
+        /* gfids are random, their tail is as good a hash as any */
+        memcpy (&hash, gfid + 8, sizeof (hash));
+
+        return hash % shm->hdr->nsets;
+}
+
+
+static void
+__qr_shm_stripe_reset (qr_shm_t *shm, int stripe)
+{
+        uint64_t set = 0;
+        int      i   = 0;
+
+        for (set = stripe; set < shm->hdr->nsets; set += QR_SHM_STRIPES) {
+                for (i = 0; i < QR_SHM_WAYS; i++)
+                        shm->entries[set * QR_SHM_WAYS + i].valid = 0;
+        }
+}
+
+
+static int
+qr_shm_lock (qr_shm_t *shm, uint64_t set)
+{
+        pthread_mutex_t *lock = NULL;
+        int              ret  = 0;
+
+        lock = &shm->hdr->stripes[set % QR_SHM_STRIPES];
+
+        ret = pthread_mutex_lock (lock);
+        if (ret == EOWNERDEAD) {
+                /* the owner died half way through an update, nothing the
+                 * stripe covers can be trusted */
+                __qr_shm_stripe_reset (shm, set % QR_SHM_STRIPES);
+                pthread_mutex_consistent (lock);
+                ret = 0;
+        }
+
+        return ret;
+}
+
+
+static void
+qr_shm_unlock (qr_shm_t *shm, uint64_t set)
+{
+        pthread_mutex_unlock (&shm->hdr->stripes[set % QR_SHM_STRIPES]);
+}
+
+
+static qr_shm_entry_t *
+__qr_shm_find (qr_shm_t *shm, uint64_t set, uuid_t gfid)
+{
+        qr_shm_entry_t *entry = NULL;
+        int             i     = 0;
+
+        for (i = 0; i < QR_SHM_WAYS; i++) {
+                entry = &shm->entries[set * QR_SHM_WAYS + i];
+                if (entry->valid && !memcmp (entry->gfid, gfid, 16))
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static gf_boolean_t
+__qr_shm_entry_matches (qr_shm_entry_t *entry, struct iatt *buf)
+{
+        return (!memcmp (entry->gfid, buf->ia_gfid, 16) &&
+                entry->ia_mtime == buf->ia_mtime &&
+                entry->ia_mtime_nsec == buf->ia_mtime_nsec &&
+                entry->size == buf->ia_size);
+}
+
+
+static char *
+qr_shm_slot (qr_shm_t *shm, qr_shm_entry_t *entry)
+{
+        return shm->slots + ((entry - shm->entries) * shm->hdr->slot_size);
+}
+
+
+int
+qr_shm_store (qr_shm_t *shm, uuid_t gfid, struct iatt *buf, void *data)
+{
+        qr_shm_entry_t *entry = NULL;
+        qr_shm_entry_t *tmp   = NULL;
+        uint64_t        set   = 0;
+        int             i     = 0;
+
+        if (buf->ia_size > shm->hdr->slot_size || gf_uuid_is_null (gfid))
+                return -1;
+
+        set = qr_shm_set (shm, gfid);
+
+        if (qr_shm_lock (shm, set) != 0)
+                return -1;
+        {
+                entry = __qr_shm_find (shm, set, gfid);
+
+                /* else the first free way, else the least recently used */
+                for (i = 0; !entry && i < QR_SHM_WAYS; i++) {
+                        tmp = &shm->entries[set * QR_SHM_WAYS + i];
+                        if (!tmp->valid)
+                                entry = tmp;
+                }
+
+                for (i = 0; !entry && i < QR_SHM_WAYS; i++) {
+                        tmp = &shm->entries[set * QR_SHM_WAYS + i];
+                        if (!entry || tmp->atime < entry->atime)
+                                entry = tmp;
+                }
+
+                entry->valid = 0;
+
+                memcpy (qr_shm_slot (shm, entry), data, buf->ia_size);
+
+                memcpy (entry->gfid, gfid, 16);
+                entry->ia_mtime = buf->ia_mtime;
+                entry->ia_mtime_nsec = buf->ia_mtime_nsec;
+                entry->size = buf->ia_size;
+                entry->atime = __sync_add_and_fetch (&shm->hdr->tick, 1);
+                entry->valid = 1;
+        }
+        qr_shm_unlock (shm, set);
+
+        __sync_fetch_and_add (&shm->stores, 1);
+
+        return 0;
+}
+
+
+/* is the content matching @buf cached? Content of another version is
+ * dropped, so the next lookup asks for the current one.
+ */
+gf_boolean_t
+qr_shm_valid (qr_shm_t *shm, uuid_t gfid, struct iatt *buf)
+{
+        qr_shm_entry_t *entry = NULL;
+        uint64_t        set   = 0;
+        gf_boolean_t    valid = _gf_false;
+        gf_boolean_t    stale = _gf_false;
+
+        if (gf_uuid_is_null (gfid))
+                return _gf_false;
+
+        set = qr_shm_set (shm, gfid);
+
+        if (qr_shm_lock (shm, set) != 0)
+                return _gf_false;
+        {
+                entry = __qr_shm_find (shm, set, gfid);
+                if (entry && __qr_shm_entry_matches (entry, buf)) {
+                        valid = _gf_true;
+                } else if (entry) {
+                        entry->valid = 0;
+                        stale = _gf_true;
+                }
+        }
+        qr_shm_unlock (shm, set);
+
+        if (stale)
+                __sync_fetch_and_add (&shm->invalidations, 1);
+
+        return valid;
+}
+
+
+/* is any content of @gfid cached, used before the iatt is known */
+gf_boolean_t
+qr_shm_contains (qr_shm_t *shm, uuid_t gfid)
+{
+        uint64_t        set   = 0;
+        gf_boolean_t    found = _gf_false;
+
+        if (gf_uuid_is_null (gfid))
+                return _gf_false;
+
+        set = qr_shm_set (shm, gfid);
+
+        if (qr_shm_lock (shm, set) != 0)
+                return _gf_false;
+        {
+                found = (__qr_shm_find (shm, set, gfid) != NULL);
+        }
+        qr_shm_unlock (shm, set);
+
+        return found;
+}
+
+
+int
+qr_shm_read (qr_shm_t *shm, uuid_t gfid, struct iatt *buf, off_t offset,
+             size_t size, char *dst)
+{
+        qr_shm_entry_t *entry = NULL;
+        uint64_t        set   = 0;
+        int             ret   = -1;
+
+        set = qr_shm_set (shm, gfid);
+
+        if (qr_shm_lock (shm, set) != 0)
+                goto out;
+        {
+                entry = __qr_shm_find (shm, set, gfid);
+                if (!entry || !__qr_shm_entry_matches (entry, buf) ||
+                    offset >= entry->size)
+                        goto unlock;
+
+                ret = min (size, (entry->size - offset));
+                memcpy (dst, qr_shm_slot (shm, entry) + offset, ret);
+
+                entry->atime = __sync_add_and_fetch (&shm->hdr->tick, 1);
+        }
+unlock:
+        qr_shm_unlock (shm, set);
+out:
+        if (ret < 0)
+                __sync_fetch_and_add (&shm->misses, 1);
+        else
+                __sync_fetch_and_add (&shm->hits, 1);
+
+        return ret;
+}
+
+
+void
+qr_shm_invalidate (qr_shm_t *shm, uuid_t gfid)
+{
+        qr_shm_entry_t *entry = NULL;
+        uint64_t        set   = 0;
+
+        if (gf_uuid_is_null (gfid))
+                return;
+
+        set = qr_shm_set (shm, gfid);
+
+        if (qr_shm_lock (shm, set) != 0)
+                return;
+        {
+                entry = __qr_shm_find (shm, set, gfid);
+                if (entry)
+                        entry->valid = 0;
+        }
+        qr_shm_unlock (shm, set);
+
+        if (entry)
+                __sync_fetch_and_add (&shm->invalidations, 1);
+}
+
+
+void
+qr_shm_dump (qr_shm_t *shm)
+{
+        gf_proc_dump_write ("shared_cache_path", "%s", shm->path);
+        gf_proc_dump_write ("shared_cache_files", "%"PRIu64,
+                            shm->hdr->nsets * QR_SHM_WAYS);
+        gf_proc_dump_write ("shared_cache_slot_size", "%"PRIu64,
+                            shm->hdr->slot_size);
+        gf_proc_dump_write ("shared_cache_hits", "%"PRIu64, shm->hits);
+        gf_proc_dump_write ("shared_cache_misses", "%"PRIu64, shm->misses);
+        gf_proc_dump_write ("shared_cache_stores", "%"PRIu64, shm->stores);
+        gf_proc_dump_write ("shared_cache_invalidations", "%"PRIu64,
+                            shm->invalidations);
+}
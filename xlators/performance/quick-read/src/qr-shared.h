@@ -0,0 +1,100 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __QR_SHARED_H
+#define __QR_SHARED_H
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "iatt.h"
+
+/*
+ * Small file cache shared by every client process of a volume on the
+ * host. It lives in a file (normally on /dev/shm) which all of them map.
+ *
+ *   [ header | entries[nsets * QR_SHM_WAYS] | slots[nsets * QR_SHM_WAYS] ]
+ *
+ * The file is named after the volume id, volumes of the same name on
+ * different clusters do not share it.
+ *
+ * A file is cached in one of the QR_SHM_WAYS entries of the set picked by
+ * its gfid, together with the size and mtime it had when the content was
+ * read, so a reader only ever gets back the content matching the iatt it
+ * has. An entry found not to match on lookup is dropped. A
+ * set is replaced LRU. Sets are protected by QR_SHM_STRIPES robust,
+ * process shared mutexes, a process dying with one held only costs the
+ * content of that stripe.
+ */
+
+#define QR_SHM_MAGIC    0x47514352      /* "GQCR" */
+#define QR_SHM_VERSION  1
+#define QR_SHM_WAYS     8
+#define QR_SHM_STRIPES  64
+
+typedef struct qr_shm_entry {
+        unsigned char    gfid[16];
+        uint32_t         ia_mtime;
+        uint32_t         ia_mtime_nsec;
+        uint64_t         size;
+        uint64_t         atime;     /* value of the header tick */
+        uint32_t         valid;
+        uint32_t         pad;
+} qr_shm_entry_t;
+
+typedef struct qr_shm_header {
+        uint32_t         magic;     /* written last by the creator */
+        uint32_t         version;
+        uint64_t         slot_size;
+        uint64_t         nsets;
+        uint64_t         tick;
+        pthread_mutex_t  stripes[QR_SHM_STRIPES];
+} qr_shm_header_t;
+
+typedef struct qr_shm {
+        qr_shm_header_t *hdr;
+        qr_shm_entry_t  *entries;
+        char            *slots;
+        size_t           map_size;
+        char            *path;
+
+        /* counters of this process only */
+        uint64_t         hits;
+        uint64_t         misses;
+        uint64_t         stores;
+        uint64_t         invalidations;
+} qr_shm_t;
+
+qr_shm_t *
+qr_shm_open (xlator_t *this, const char *dir, const char *volume_id,
+             uint64_t size, uint64_t slot_size);
+
+void
+qr_shm_close (qr_shm_t *shm);
+
+int
+qr_shm_store (qr_shm_t *shm, uuid_t gfid, struct iatt *buf, void *data);
+
+gf_boolean_t
+qr_shm_valid (qr_shm_t *shm, uuid_t gfid, struct iatt *buf);
+
+gf_boolean_t
+qr_shm_contains (qr_shm_t *shm, uuid_t gfid);
+
+int
+qr_shm_read (qr_shm_t *shm, uuid_t gfid, struct iatt *buf, off_t offset,
+             size_t size, char *dst);
+
+void
+qr_shm_invalidate (qr_shm_t *shm, uuid_t gfid);
+
+void
+qr_shm_dump (qr_shm_t *shm);
+
+#endif /* __QR_SHARED_H */
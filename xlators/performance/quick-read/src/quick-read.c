@@ -11,6 +11,7 @@
 #include "quick-read.h"
 #include "statedump.h"
 #include "quick-read-messages.h"
+#include "upcall-utils.h"
 
 qr_inode_t *qr_inode_ctx_get (xlator_t *this, inode_t *inode);
 void __qr_inode_prune (qr_inode_table_t *table, qr_inode_t *qr_inode);
@@ -182,6 +183,7 @@ __qr_inode_prune (qr_inode_table_t *table, qr_inode_t *qr_inode)
 {
 	GF_FREE (qr_inode->data);
 	qr_inode->data = NULL;
+	qr_inode->shared = _gf_false;
 
 	if (!list_empty (&qr_inode->lru)) {
 		table->cache_used -= qr_inode->size;
@@ -216,6 +218,21 @@ qr_inode_prune (xlator_t *this, inode_t *inode)
 }
 
 
+/* content of @inode changed, drop it here and for everyone on the host */
+void
+qr_inode_invalidate (xlator_t *this, inode_t *inode)
+{
+        qr_private_t     *priv          = NULL;
+
+        priv = this->private;
+
+        if (priv->shm)
+                qr_shm_invalidate (priv->shm, inode->gfid);
+
+        qr_inode_prune (this, inode);
+}
+
+
 /* To be called with priv->table.lock held */
 void
 __qr_cache_prune (qr_inode_table_t *table, qr_conf_t *conf)
@@ -241,6 +258,65 @@ __qr_cache_prune (qr_inode_table_t *table, qr_conf_t *conf)
 }
 
 
+uint64_t
+qr_cache_usage (xlator_t *this)
+{
+        qr_private_t      *priv = NULL;
+        qr_inode_table_t  *table = NULL;
+        uint64_t           used = 0;
+
+        priv = this->private;
+        table = &priv->table;
+
+	LOCK (&table->lock);
+	{
+		used = table->cache_used;
+	}
+	UNLOCK (&table->lock);
+
+        return used;
+}
+
+
+/* called by the cache budget, drops about @bytes in LRU order */
+uint64_t
+qr_cache_reclaim (xlator_t *this, uint64_t bytes)
+{
+        qr_private_t      *priv = NULL;
+        qr_conf_t         *conf = NULL;
+        qr_inode_table_t  *table = NULL;
+        qr_inode_t        *curr = NULL;
+	qr_inode_t        *next = NULL;
+        int                index = 0;
+        uint64_t           before = 0;
+        uint64_t           freed = 0;
+
+        priv = this->private;
+        table = &priv->table;
+        conf = &priv->conf;
+
+	LOCK (&table->lock);
+	{
+                before = table->cache_used;
+
+                for (index = 0; index < conf->max_pri; index++) {
+                        list_for_each_entry_safe (curr, next, &table->lru[index],
+                                                  lru) {
+                                __qr_inode_prune (table, curr);
+
+                                if (before - table->cache_used >= bytes)
+                                        goto unlock;
+                        }
+                }
+	}
+unlock:
+        freed = before - table->cache_used;
+	UNLOCK (&table->lock);
+
+        return freed;
+}
+
+
 void
 qr_cache_prune (xlator_t *this)
 {
@@ -370,6 +446,74 @@ qr_content_refresh (xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf)
 }
 
 
+/*
+ * Shared cache mode: @content, when the server sent it along, goes to the
+ * shared cache and the inode only remembers the iatt it matches. Without
+ * @content the inode is pointed at whatever the shared cache holds for
+ * @buf, if anything.
+ */
+void
+qr_shared_update (xlator_t *this, inode_t *inode, void *content,
+                  struct iatt *buf)
+{
+        qr_private_t      *priv     = NULL;
+        qr_inode_table_t  *table    = NULL;
+        qr_inode_t        *qr_inode = NULL;
+        gf_boolean_t       cached   = _gf_false;
+
+        priv = this->private;
+        table = &priv->table;
+
+        if (content) {
+                if (qr_shm_store (priv->shm, buf->ia_gfid, buf, content) < 0) {
+                        /* too large for a shared slot, keep it to ourselves */
+                        qr_inode = qr_inode_ctx_get_or_new (this, inode);
+                        if (!qr_inode) {
+                                GF_FREE (content);
+                                return;
+                        }
+                        qr_content_update (this, qr_inode, content, buf);
+                        return;
+                }
+
+                GF_FREE (content);
+                cached = _gf_true;
+        } else {
+                cached = qr_size_fits (&priv->conf, buf) &&
+                         qr_shm_valid (priv->shm, buf->ia_gfid, buf);
+        }
+
+        if (cached)
+                qr_inode = qr_inode_ctx_get_or_new (this, inode);
+        else
+                qr_inode = qr_inode_ctx_get (this, inode);
+
+        if (!qr_inode)
+                return;
+
+        if (!cached && qr_inode->data) {
+                /* privately cached content */
+                qr_content_refresh (this, qr_inode, buf);
+                return;
+        }
+
+        LOCK (&table->lock);
+        {
+                __qr_inode_prune (table, qr_inode);
+
+                if (cached) {
+                        qr_inode->shared = _gf_true;
+                        qr_inode->ia_mtime = buf->ia_mtime;
+                        qr_inode->ia_mtime_nsec = buf->ia_mtime_nsec;
+                        qr_inode->buf = *buf;
+
+                        gettimeofday (&qr_inode->last_refresh, NULL);
+                }
+        }
+        UNLOCK (&table->lock);
+}
+
+
 gf_boolean_t
 __qr_cache_is_fresh (xlator_t *this, qr_inode_t *qr_inode)
 {
@@ -400,6 +544,7 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         void             *content  = NULL;
         qr_inode_t       *qr_inode = NULL;
 	inode_t          *inode    = NULL;
+        qr_private_t     *priv     = NULL;
 
 	inode = frame->local;
 	frame->local = NULL;
@@ -421,6 +566,12 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
 	content = qr_content_extract (xdata);
 
+        priv = this->private;
+        if (priv->shm) {
+                qr_shared_update (this, inode, content, buf);
+                goto out;
+        }
+
 	if (content) {
 		/* new content came along, always replace old content */
 		qr_inode = qr_inode_ctx_get_or_new (this, inode);
@@ -462,10 +613,17 @@ qr_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         conf = &priv->conf;
 
 	qr_inode = qr_inode_ctx_get (this, loc->inode);
-	if (qr_inode && qr_inode->data)
+	if (qr_inode && (qr_inode->data || qr_inode->shared))
 		/* cached. only validate in qr_lookup_cbk */
 		goto wind;
 
+        if (priv->shm &&
+            qr_shm_contains (priv->shm, gf_uuid_is_null (loc->gfid)
+                             ? loc->inode->gfid : loc->gfid))
+                /* another process on this host has it, validate against
+                 * the iatt in qr_lookup_cbk */
+                goto wind;
+
 	if (!xdata)
 		xdata = new_xdata = dict_new ();
 
@@ -498,16 +656,26 @@ int
 qr_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 		 int op_ret, int op_errno, gf_dirent_t *entries, dict_t *xdata)
 {
-        gf_dirent_t *entry      = NULL;
-	qr_inode_t  *qr_inode   = NULL;
+        gf_dirent_t  *entry      = NULL;
+	qr_inode_t   *qr_inode   = NULL;
+        qr_private_t *priv       = NULL;
 
 	if (op_ret <= 0)
 		goto unwind;
 
+        priv = this->private;
+
         list_for_each_entry (entry, &entries->list, list) {
                 if (!entry->inode)
 			continue;
 
+                if (priv->shm) {
+                        if (entry->d_stat.ia_type == IA_IFREG)
+                                qr_shared_update (this, entry->inode, NULL,
+                                                  &entry->d_stat);
+                        continue;
+                }
+
 		qr_inode = qr_inode_ctx_get (this, entry->inode);
 		if (!qr_inode)
 			/* no harm */
@@ -585,6 +753,8 @@ qr_readv_cached (call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 		__qr_inode_register (table, qr_inode);
 	}
 unlock:
+	if (op_ret >= 0)
+		gf_cache_budget_hit (priv->budget);
 	UNLOCK (&table->lock);
 
 	if (op_ret >= 0) {
@@ -604,20 +774,101 @@ unlock:
 }
 
 
+int
+qr_readv_shared (call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
+		 off_t offset, uint32_t flags, dict_t *xdata)
+{
+	xlator_t         *this = NULL;
+	qr_private_t     *priv = NULL;
+	qr_inode_table_t *table = NULL;
+	int               op_ret = -1;
+	struct iobuf     *iobuf = NULL;
+	struct iobref    *iobref = NULL;
+	struct iovec      iov = {0, };
+	struct iatt       buf = {0, };
+
+	this = frame->this;
+	priv = this->private;
+	table = &priv->table;
+
+	LOCK (&table->lock);
+	{
+		if (qr_inode->shared && __qr_cache_is_fresh (this, qr_inode)) {
+			buf = qr_inode->buf;
+			op_ret = 0;
+		}
+	}
+	UNLOCK (&table->lock);
+
+	if (op_ret < 0 || offset >= buf.ia_size) {
+		op_ret = -1;
+		goto out;
+	}
+
+	iobuf = iobuf_get2 (this->ctx->iobuf_pool,
+			    min (size, (buf.ia_size - offset)));
+	if (!iobuf) {
+		op_ret = -1;
+		goto out;
+	}
+
+	op_ret = qr_shm_read (priv->shm, buf.ia_gfid, &buf, offset, size,
+			      iobuf->ptr);
+	if (op_ret < 0) {
+		/* evicted or changed by another process */
+		LOCK (&table->lock);
+		{
+			qr_inode->shared = _gf_false;
+		}
+		UNLOCK (&table->lock);
+		goto out;
+	}
+
+	iobref = iobref_new ();
+	if (!iobref) {
+		op_ret = -1;
+		goto out;
+	}
+
+	iobref_add (iobref, iobuf);
+
+	gf_cache_budget_hit (priv->budget);
+
+	iov.iov_base = iobuf->ptr;
+	iov.iov_len = op_ret;
+
+	STACK_UNWIND_STRICT (readv, frame, op_ret, 0, &iov, 1, &buf, iobref,
+			     xdata);
+out:
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        if (iobref)
+	        iobref_unref (iobref);
+
+	return op_ret;
+}
+
+
 int
 qr_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
           off_t offset, uint32_t flags, dict_t *xdata)
 {
-	qr_inode_t *qr_inode = NULL;
+	qr_inode_t   *qr_inode = NULL;
+        qr_private_t *priv     = NULL;
+
+        priv = this->private;
 
 	qr_inode = qr_inode_ctx_get (this, fd->inode);
 	if (!qr_inode)
 		goto wind;
 
-	if (qr_readv_cached (frame, qr_inode, size, offset, flags, xdata) < 0)
-		goto wind;
+	if (qr_readv_cached (frame, qr_inode, size, offset, flags, xdata) >= 0)
+		return 0;
 
-	return 0;
+	if (priv->shm &&
+	    qr_readv_shared (frame, qr_inode, size, offset, flags, xdata) >= 0)
+		return 0;
 wind:
 	STACK_WIND (frame, default_readv_cbk,
 		    FIRST_CHILD (this), FIRST_CHILD (this)->fops->readv,
@@ -631,7 +882,7 @@ qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *iov,
 	   int count, off_t offset, uint32_t flags, struct iobref *iobref,
 	   dict_t *xdata)
 {
-	qr_inode_prune (this, fd->inode);
+	qr_inode_invalidate (this, fd->inode);
 
 	STACK_WIND (frame, default_writev_cbk,
 		    FIRST_CHILD (this), FIRST_CHILD (this)->fops->writev,
@@ -644,7 +895,7 @@ int
 qr_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
 	     dict_t *xdata)
 {
-	qr_inode_prune (this, loc->inode);
+	qr_inode_invalidate (this, loc->inode);
 
 	STACK_WIND (frame, default_truncate_cbk,
 		    FIRST_CHILD (this), FIRST_CHILD (this)->fops->truncate,
@@ -657,7 +908,7 @@ int
 qr_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
 	      dict_t *xdata)
 {
-	qr_inode_prune (this, fd->inode);
+	qr_inode_invalidate (this, fd->inode);
 
 	STACK_WIND (frame, default_ftruncate_cbk,
 		    FIRST_CHILD (this), FIRST_CHILD (this)->fops->ftruncate,
@@ -775,11 +1026,70 @@ qr_priv_dump (xlator_t *this)
         gf_proc_dump_write ("total_files_cached", "%d", file_count);
         gf_proc_dump_write ("total_cache_used", "%d", total_size);
 
+        if (priv->shm)
+                qr_shm_dump (priv->shm);
+
 out:
         return 0;
 }
 
 
+static int
+qr_invalidate (xlator_t *this, void *data)
+{
+        struct gf_upcall                    *up_data = NULL;
+        struct gf_upcall_cache_invalidation *up_ci   = NULL;
+        inode_table_t                       *itable  = NULL;
+        inode_t                             *inode   = NULL;
+
+        up_data = (struct gf_upcall *)data;
+
+        if (up_data->event_type != GF_UPCALL_CACHE_INVALIDATION)
+                goto out;
+
+        up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+
+        if (!(up_ci->flags & UP_WRITE_FLAGS))
+                goto out;
+
+        itable = ((xlator_t *)this->graph->top)->itable;
+        inode = inode_find (itable, up_data->gfid);
+        if (!inode) {
+                /* not known here, but other processes may have it */
+                qr_private_t *priv = this->private;
+
+                if (priv->shm)
+                        qr_shm_invalidate (priv->shm, up_data->gfid);
+                goto out;
+        }
+
+        qr_inode_invalidate (this, inode);
+
+        inode_unref (inode);
+out:
+        return 0;
+}
+
+
+int
+notify (xlator_t *this, int event, void *data, ...)
+{
+        int ret = 0;
+
+        switch (event) {
+        case GF_EVENT_UPCALL:
+                qr_invalidate (this, data);
+                ret = default_notify (this, event, data);
+                break;
+        default:
+                ret = default_notify (this, event, data);
+                break;
+        }
+
+        return ret;
+}
+
+
 int32_t
 mem_acct_init (xlator_t *this)
 {
@@ -1014,6 +1324,15 @@ init (xlator_t *this)
                 goto out;
         }
 
+        GF_OPTION_INIT ("shared-cache", conf->shared_cache, bool, out);
+
+        GF_OPTION_INIT ("shared-cache-size", conf->shared_cache_size,
+                        size_uint64, out);
+
+        GF_OPTION_INIT ("shared-cache-dir", conf->shared_cache_dir, path, out);
+
+        GF_OPTION_INIT ("volume-id", conf->volume_id, str, out);
+
         INIT_LIST_HEAD (&conf->priority_list);
         conf->max_pri = 1;
         if (dict_get (this->options, "priority")) {
@@ -1042,9 +1361,24 @@ init (xlator_t *this)
                 INIT_LIST_HEAD (&priv->table.lru[i]);
         }
 
+        if (conf->shared_cache && conf->max_file_size)
+                /* falls back to caching privately on failure */
+                priv->shm = qr_shm_open (this, conf->shared_cache_dir,
+                                         conf->volume_id,
+                                         conf->shared_cache_size,
+                                         conf->max_file_size);
+
         ret = 0;
 
         this->private = priv;
+
+        priv->budget = gf_cache_budget_register (this, 1, qr_cache_usage,
+                                                 qr_cache_reclaim);
+        if (!priv->budget) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        QUICK_READ_MSG_NO_MEMORY, "failed to register with "
+                        "the cache budget, cache-size is the only limit");
+        }
 out:
         if ((ret == -1) && priv) {
                 GF_FREE (priv);
@@ -1108,6 +1442,10 @@ fini (xlator_t *this)
                 goto out;
         }
 
+        gf_cache_budget_unregister (priv->budget);
+
+        qr_shm_close (priv->shm);
+
         qr_inode_table_destroy (priv);
         qr_conf_destroy (&priv->conf);
 
@@ -1160,5 +1498,32 @@ struct volume_options options[] = {
           .max  = 1 * GF_UNIT_KB * 1000,
           .default_value = "64KB",
         },
+        { .key  = {"shared-cache"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep cached files in memory shared by all the "
+                         "client processes of the volume on this host, "
+                         "instead of in every process. Takes effect on "
+                         "the next mount."
+        },
+        { .key  = {"shared-cache-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 1 * GF_UNIT_MB,
+          .max  = 32 * GF_UNIT_GB,
+          .default_value = "256MB",
+          .description = "Size of the shared cache. The process creating "
+                         "the cache decides, others use it as it is."
+        },
+        { .key  = {"shared-cache-dir"},
+          .type = GF_OPTION_TYPE_PATH,
+          .default_value = "/dev/shm",
+          .description = "Directory holding the shared cache, should be a "
+                         "tmpfs."
+        },
+        { .key  = {"volume-id"},
+          .type = GF_OPTION_TYPE_STR,
+          .description = "Id of the volume, set by glusterd. Names the "
+                         "shared cache."
+        },
         { .key  = {NULL} }
 };
@@ -21,6 +21,7 @@
 #include "common-utils.h"
 #include "call-stub.h"
 #include "defaults.h"
+#include "cache-budget.h"
 #include <libgen.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -28,6 +29,7 @@
 #include <unistd.h>
 #include <fnmatch.h>
 #include "quick-read-mem-types.h"
+#include "qr-shared.h"
 
 
 struct qr_inode {
@@ -37,6 +39,7 @@ struct qr_inode {
 	uint32_t          ia_mtime;
 	uint32_t          ia_mtime_nsec;
 	struct iatt       buf;
+        gf_boolean_t      shared;   /* content is in the shared cache */
         struct timeval    last_refresh;
         struct list_head  lru;
 };
@@ -56,6 +59,10 @@ struct qr_conf {
         uint64_t         cache_size;
         int              max_pri;
         struct list_head priority_list;
+        gf_boolean_t     shared_cache;
+        uint64_t         shared_cache_size;
+        char            *shared_cache_dir;
+        char            *volume_id;
 };
 typedef struct qr_conf qr_conf_t;
 
@@ -67,8 +74,10 @@ struct qr_inode_table {
 typedef struct qr_inode_table qr_inode_table_t;
 
 struct qr_private {
-        qr_conf_t         conf;
-        qr_inode_table_t  table;
+        qr_conf_t          conf;
+        qr_inode_table_t   table;
+        gf_cache_client_t *budget;
+        qr_shm_t          *shm;
 };
 typedef struct qr_private qr_private_t;
 
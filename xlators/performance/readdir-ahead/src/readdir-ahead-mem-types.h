@@ -18,6 +18,9 @@ enum gf_rda_mem_types_ {
         gf_rda_mt_rda_local   = gf_common_mt_end + 1,
 	gf_rda_mt_rda_fd_ctx,
 	gf_rda_mt_rda_priv,
+	gf_rda_mt_inode_ctx,
+	gf_rda_mt_dir_prefetch,
+	gf_rda_mt_subdir,
         gf_rda_mt_end
 };
 
@@ -30,6 +30,7 @@
 #include "readdir-ahead-mem-types.h"
 #include "defaults.h"
 #include "readdir-ahead-messages.h"
+#include "statedump.h"
 static int rda_fill_fd(call_frame_t *, xlator_t *, fd_t *);
 
 /*
@@ -69,6 +70,693 @@ out:
 	return ctx;
 }
 
+static uint64_t
+rda_gen(xlator_t *this)
+{
+	struct rda_priv *priv = this->private;
+
+	return __sync_fetch_and_add(&priv->gen, 0);
+}
+
+/*
+ * Get the inode context holding the metadata prefetched for an inode and, for
+ * a directory, its subdirectories to prefetch during a walk. Modifications
+ * are recorded on the context of the inode, so a new one has not been
+ * modified, unless a modification could not be recorded at all.
+ */
+static struct rda_inode_ctx *
+rda_inode_ctx_get(xlator_t *this, inode_t *inode, gf_boolean_t create)
+{
+	struct rda_priv *priv = this->private;
+	uint64_t val = 0;
+	struct rda_inode_ctx *ctx = NULL;
+
+	if (!inode)
+		return NULL;
+
+	LOCK(&inode->lock);
+
+	if (__inode_ctx_get(inode, this, &val) == 0) {
+		ctx = (struct rda_inode_ctx *) (uintptr_t) val;
+		goto out;
+	}
+
+	if (!create)
+		goto out;
+
+	ctx = GF_CALLOC(1, sizeof(struct rda_inode_ctx), gf_rda_mt_inode_ctx);
+	if (!ctx)
+		goto out;
+
+	LOCK_INIT(&ctx->lock);
+	INIT_LIST_HEAD(&ctx->subdirs);
+	ctx->gen = __sync_fetch_and_add(&priv->gen_floor, 0);
+
+	val = (uint64_t) (uintptr_t) ctx;
+	if (__inode_ctx_set(inode, this, &val) < 0) {
+		LOCK_DESTROY(&ctx->lock);
+		GF_FREE(ctx);
+		ctx = NULL;
+	}
+out:
+	UNLOCK(&inode->lock);
+	return ctx;
+}
+
+static void
+rda_inode_ctx_destroy(struct rda_inode_ctx *ctx)
+{
+	struct rda_subdir *subdir, *tmp;
+
+	if (ctx->xattrs)
+		dict_unref(ctx->xattrs);
+	if (ctx->keys)
+		dict_unref(ctx->keys);
+	if (ctx->prefetch_keys)
+		dict_unref(ctx->prefetch_keys);
+
+	list_for_each_entry_safe(subdir, tmp, &ctx->subdirs, list) {
+		list_del(&subdir->list);
+		GF_FREE(subdir);
+	}
+
+	LOCK_DESTROY(&ctx->lock);
+	GF_FREE(ctx);
+}
+
+/*
+ * Record the metadata an entry was read with, unless the inode has been
+ * modified through this client since the readdirp was sent.
+ */
+static void
+rda_inode_ctx_update(xlator_t *this, inode_t *inode, struct iatt *stbuf,
+		     dict_t *xattrs, dict_t *keys, uint64_t gen)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx;
+
+	if (!inode || gf_uuid_is_null(stbuf->ia_gfid))
+		return;
+
+	/* even uncached, the context tells the entry was modified */
+	ctx = rda_inode_ctx_get(this, inode, _gf_true);
+	if (!ctx)
+		return;
+
+	LOCK(&ctx->lock);
+
+	if (ctx->gen > gen || !priv->rda_cache_metadata ||
+	    !priv->rda_cache_timeout)
+		goto unlock;
+
+	ctx->statbuf = *stbuf;
+	ctx->valid = _gf_true;
+	ctx->expire = time(NULL) + priv->rda_cache_timeout;
+
+	if (ctx->xattrs)
+		dict_unref(ctx->xattrs);
+	ctx->xattrs = NULL;
+	if (ctx->keys)
+		dict_unref(ctx->keys);
+	ctx->keys = NULL;
+
+	/* without values the keys may not have been asked for at all */
+	if (xattrs && keys) {
+		ctx->xattrs = dict_ref(xattrs);
+		ctx->keys = dict_ref(keys);
+	}
+unlock:
+	UNLOCK(&ctx->lock);
+}
+
+static gf_boolean_t
+rda_inode_modified_since(xlator_t *this, inode_t *inode, uint64_t gen)
+{
+	struct rda_inode_ctx *ctx;
+	gf_boolean_t modified = _gf_false;
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_false);
+	if (!ctx)
+		return _gf_false;
+
+	LOCK(&ctx->lock);
+	modified = (ctx->gen > gen);
+	UNLOCK(&ctx->lock);
+
+	return modified;
+}
+
+static gf_boolean_t
+rda_inode_cached_iatt(xlator_t *this, inode_t *inode, struct iatt *stbuf)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx;
+	gf_boolean_t hit = _gf_false;
+
+	if (!priv->rda_cache_metadata)
+		return _gf_false;
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_false);
+	if (!ctx)
+		return _gf_false;
+
+	LOCK(&ctx->lock);
+	if (ctx->valid && time(NULL) < ctx->expire) {
+		*stbuf = ctx->statbuf;
+		hit = _gf_true;
+	}
+	UNLOCK(&ctx->lock);
+
+	if (hit)
+		__sync_fetch_and_add(&priv->stat_hits, 1);
+
+	return hit;
+}
+
+/*
+ * A key readdirp was asked for is either in the values fetched with the
+ * entry or the inode does not have it.
+ */
+static gf_boolean_t
+rda_inode_cached_xattr(xlator_t *this, inode_t *inode, const char *name,
+		       dict_t **dict, int *op_errno)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx;
+	data_t *value = NULL;
+	gf_boolean_t hit = _gf_false;
+
+	if (!priv->rda_cache_metadata)
+		return _gf_false;
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_false);
+	if (!ctx)
+		return _gf_false;
+
+	LOCK(&ctx->lock);
+	if (!ctx->valid || time(NULL) >= ctx->expire || !ctx->keys ||
+	    !dict_get(ctx->keys, (char *) name))
+		goto unlock;
+
+	hit = _gf_true;
+	value = dict_get(ctx->xattrs, (char *) name);
+	if (!value) {
+		*op_errno = ENODATA;
+		goto unlock;
+	}
+
+	*dict = dict_new();
+	if (!*dict || dict_set(*dict, (char *) name, value)) {
+		if (*dict)
+			dict_unref(*dict);
+		*dict = NULL;
+		hit = _gf_false;
+	}
+unlock:
+	UNLOCK(&ctx->lock);
+
+	if (hit)
+		__sync_fetch_and_add(&priv->getxattr_hits, 1);
+
+	return hit;
+}
+
+/*
+ * Publish the metadata of entries read from a directory, and remember its
+ * subdirectories in readdir order so a walk into them can be read ahead.
+ */
+static void
+rda_entries_fetched(xlator_t *this, inode_t *dir, gf_dirent_t *entries,
+		    dict_t *keys, uint64_t gen, gf_boolean_t first)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx = NULL;
+	struct rda_subdir *subdir, *tmp;
+	gf_dirent_t *dirent;
+
+	list_for_each_entry(dirent, &entries->list, list)
+		rda_inode_ctx_update(this, dirent->inode, &dirent->d_stat,
+				     dirent->dict, keys, gen);
+
+	if (!priv->rda_prefetch_dirs)
+		return;
+
+	ctx = rda_inode_ctx_get(this, dir, _gf_true);
+	if (!ctx)
+		return;
+
+	LOCK(&ctx->lock);
+
+	if (first) {
+		list_for_each_entry_safe(subdir, tmp, &ctx->subdirs, list) {
+			list_del(&subdir->list);
+			GF_FREE(subdir);
+		}
+		ctx->subdir_count = 0;
+	}
+
+	if (keys && ctx->prefetch_keys != keys) {
+		if (ctx->prefetch_keys)
+			dict_unref(ctx->prefetch_keys);
+		ctx->prefetch_keys = dict_ref(keys);
+	}
+
+	list_for_each_entry(dirent, &entries->list, list) {
+		if (ctx->subdir_count >= RDA_MAX_SUBDIRS)
+			break;
+		if (!IA_ISDIR(dirent->d_stat.ia_type) ||
+		    gf_uuid_is_null(dirent->d_stat.ia_gfid) ||
+		    !strcmp(dirent->d_name, ".") ||
+		    !strcmp(dirent->d_name, ".."))
+			continue;
+
+		subdir = GF_CALLOC(1, sizeof(*subdir), gf_rda_mt_subdir);
+		if (!subdir)
+			break;
+		gf_uuid_copy(subdir->gfid, dirent->d_stat.ia_gfid);
+		list_add_tail(&subdir->list, &ctx->subdirs);
+		ctx->subdir_count++;
+	}
+
+	UNLOCK(&ctx->lock);
+}
+
+static void
+rda_prefetch_destroy(xlator_t *this, struct rda_dir_prefetch *pf)
+{
+	gf_dirent_free(&pf->entries);
+	if (pf->fd)
+		fd_unref(pf->fd);
+	if (pf->xattrs)
+		dict_unref(pf->xattrs);
+	GF_FREE(pf);
+}
+
+/*
+ * Drop the oldest completed prefetches nobody opened, each one holds an fd
+ * on its directory.
+ */
+static void
+rda_prefetch_evict(xlator_t *this)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_dir_prefetch *pf, *iter;
+
+	for (;;) {
+		pf = NULL;
+
+		LOCK(&priv->lock);
+		if (priv->prefetch_count > RDA_PREFETCH_KEEP(priv)) {
+			list_for_each_entry_reverse(iter, &priv->prefetched,
+						    list) {
+				if (iter->state == RDA_PREFETCH_DONE) {
+					pf = iter;
+					break;
+				}
+			}
+		}
+		if (pf) {
+			list_del_init(&pf->list);
+			priv->prefetch_count--;
+			pf->ictx->prefetch = NULL;
+		}
+		UNLOCK(&priv->lock);
+
+		if (!pf)
+			break;
+
+		rda_prefetch_destroy(this, pf);
+	}
+}
+
+/*
+ * Detach the prefetch of a directory. One still running is abandoned to its
+ * callback, a completed one is returned.
+ */
+static struct rda_dir_prefetch *
+rda_prefetch_detach(xlator_t *this, struct rda_inode_ctx *ctx)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_dir_prefetch *pf = NULL;
+
+	LOCK(&priv->lock);
+	pf = ctx->prefetch;
+	if (pf) {
+		ctx->prefetch = NULL;
+		list_del_init(&pf->list);
+		priv->prefetch_count--;
+		if (pf->state != RDA_PREFETCH_DONE) {
+			pf->state = RDA_PREFETCH_ABANDONED;
+			pf = NULL;
+		}
+	}
+	UNLOCK(&priv->lock);
+
+	return pf;
+}
+
+/*
+ * Take the prefetch of a directory being opened.
+ */
+static struct rda_dir_prefetch *
+rda_prefetch_take(xlator_t *this, inode_t *inode)
+{
+	struct rda_inode_ctx *ctx;
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_false);
+	if (!ctx)
+		return NULL;
+
+	return rda_prefetch_detach(this, ctx);
+}
+
+/*
+ * Drop the cached metadata and the prefetched entries of an inode modified
+ * through this client. The generation recorded on the inode keeps readdirps
+ * sent before from caching it again, and the entries they buffered from
+ * being served with it, without affecting any other inode. Only when no
+ * context can be had for it, every context created from now on starts out
+ * modified.
+ */
+static void
+rda_inode_invalidate(xlator_t *this, inode_t *inode)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx = NULL;
+	struct rda_dir_prefetch *pf;
+	uint64_t gen = 0;
+
+	if (!inode)
+		return;
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_true);
+	if (!ctx) {
+		gen = __sync_add_and_fetch(&priv->gen, 1);
+		LOCK(&priv->lock);
+		if (priv->gen_floor < gen)
+			priv->gen_floor = gen;
+		UNLOCK(&priv->lock);
+		return;
+	}
+
+	LOCK(&ctx->lock);
+
+	ctx->gen = __sync_add_and_fetch(&priv->gen, 1);
+	ctx->valid = _gf_false;
+	if (ctx->xattrs)
+		dict_unref(ctx->xattrs);
+	ctx->xattrs = NULL;
+	if (ctx->keys)
+		dict_unref(ctx->keys);
+	ctx->keys = NULL;
+
+	UNLOCK(&ctx->lock);
+
+	pf = rda_prefetch_detach(this, ctx);
+	if (pf)
+		rda_prefetch_destroy(this, pf);
+}
+
+static int32_t
+rda_prefetch_done(call_frame_t *frame, xlator_t *this, int32_t op_ret,
+		  int32_t op_errno, gf_dirent_t *entries)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_local *local = frame->local;
+	struct rda_dir_prefetch *pf = local->prefetch;
+	gf_dirent_t *dirent, *tmp;
+	gf_boolean_t destroy = _gf_true;
+
+	LOCK(&priv->lock);
+	if (pf->state == RDA_PREFETCH_RUNNING && op_ret >= 0) {
+		pf->state = RDA_PREFETCH_DONE;
+		pf->expire = time(NULL) + priv->rda_cache_timeout;
+		pf->op_ret = op_ret;
+		pf->op_errno = op_errno;
+		if (entries) {
+			list_for_each_entry_safe(dirent, tmp, &entries->list,
+						 list) {
+				list_del_init(&dirent->list);
+				list_add_tail(&dirent->list, &pf->entries.list);
+				pf->size += gf_dirent_size(dirent->d_name);
+				pf->next_offset = dirent->d_off;
+			}
+		}
+		destroy = _gf_false;
+	} else if (pf->state == RDA_PREFETCH_RUNNING) {
+		/* failed, nobody took it yet */
+		pf->ictx->prefetch = NULL;
+		list_del_init(&pf->list);
+		priv->prefetch_count--;
+	}
+	UNLOCK(&priv->lock);
+
+	if (destroy)
+		rda_prefetch_destroy(this, pf);
+
+	frame->local = NULL;
+	inode_unref(local->inode);
+	mem_put(local);
+	STACK_DESTROY(frame->root);
+
+	return 0;
+}
+
+static int32_t
+rda_prefetch_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+			  int32_t op_ret, int32_t op_errno,
+			  gf_dirent_t *entries, dict_t *xdata)
+{
+	struct rda_local *local = frame->local;
+	struct rda_dir_prefetch *pf = local->prefetch;
+
+	if (op_ret > 0)
+		rda_entries_fetched(this, local->inode, entries, pf->xattrs,
+				    pf->gen, _gf_true);
+
+	return rda_prefetch_done(frame, this, op_ret, op_errno, entries);
+}
+
+static int32_t
+rda_prefetch_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+			 int32_t op_ret, int32_t op_errno, fd_t *fd,
+			 dict_t *xdata)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_local *local = frame->local;
+	struct rda_dir_prefetch *pf = local->prefetch;
+
+	if (op_ret < 0)
+		return rda_prefetch_done(frame, this, op_ret, op_errno, NULL);
+
+	STACK_WIND(frame, rda_prefetch_readdirp_cbk, FIRST_CHILD(this),
+		   FIRST_CHILD(this)->fops->readdirp, pf->fd,
+		   priv->rda_req_size, 0, pf->xattrs);
+
+	return 0;
+}
+
+/*
+ * Open and read the first chunk of a directory a walk is about to enter,
+ * with the credentials of the walk.
+ */
+static void
+rda_prefetch_dir(call_frame_t *frame, xlator_t *this, inode_t *inode,
+		 dict_t *keys)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx;
+	struct rda_dir_prefetch *pf;
+	struct rda_local *local = NULL;
+	call_frame_t *nframe = NULL;
+	loc_t loc = {0, };
+
+	ctx = rda_inode_ctx_get(this, inode, _gf_true);
+	if (!ctx || ctx->prefetch)
+		return;
+
+	pf = GF_CALLOC(1, sizeof(*pf), gf_rda_mt_dir_prefetch);
+	if (!pf)
+		return;
+
+	INIT_LIST_HEAD(&pf->list);
+	INIT_LIST_HEAD(&pf->entries.list);
+	pf->state = RDA_PREFETCH_RUNNING;
+	pf->ictx = ctx;
+	pf->gen = rda_gen(this);
+	if (keys)
+		pf->xattrs = dict_ref(keys);
+
+	nframe = copy_frame(frame);
+	local = mem_get0(this->local_pool);
+	pf->fd = fd_create(inode, frame->root->pid);
+	if (!nframe || !local || !pf->fd)
+		goto err;
+
+	LOCK(&priv->lock);
+	if (ctx->prefetch) {
+		UNLOCK(&priv->lock);
+		goto err;
+	}
+	ctx->prefetch = pf;
+	list_add(&pf->list, &priv->prefetched);
+	priv->prefetch_count++;
+	UNLOCK(&priv->lock);
+
+	rda_prefetch_evict(this);
+	__sync_fetch_and_add(&priv->dirs_prefetched, 1);
+
+	local->inode = inode_ref(inode);
+	local->prefetch = pf;
+	nframe->local = local;
+
+	loc.inode = inode_ref(inode);
+	gf_uuid_copy(loc.gfid, inode->gfid);
+	inode_path(inode, NULL, (char **) &loc.path);
+
+	STACK_WIND(nframe, rda_prefetch_opendir_cbk, FIRST_CHILD(this),
+		   FIRST_CHILD(this)->fops->opendir, &loc, pf->fd, NULL);
+
+	loc_wipe(&loc);
+	return;
+err:
+	if (local)
+		mem_put(local);
+	if (nframe)
+		STACK_DESTROY(nframe->root);
+	rda_prefetch_destroy(this, pf);
+}
+
+/*
+ * Read ahead the subdirectories of dir a walk enters next: the first ones
+ * once it has been listed, the ones following a subdirectory once that is
+ * opened.
+ */
+static void
+rda_prefetch_subdirs(call_frame_t *frame, xlator_t *this, inode_t *dir,
+		     uuid_t after)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_inode_ctx *ctx;
+	struct rda_subdir *subdir, *tmp;
+	uuid_t gfids[RDA_MAX_PREFETCH_DIRS];
+	dict_t *keys = NULL;
+	inode_t *inode;
+	gf_boolean_t found = _gf_false;
+	int count = 0, i;
+
+	/* nothing read ahead could be adopted */
+	if (!priv->rda_prefetch_dirs || !priv->rda_cache_timeout)
+		return;
+
+	ctx = rda_inode_ctx_get(this, dir, _gf_false);
+	if (!ctx)
+		return;
+
+	LOCK(&ctx->lock);
+
+	if (after) {
+		list_for_each_entry(subdir, &ctx->subdirs, list) {
+			if (!gf_uuid_compare(subdir->gfid, after)) {
+				found = _gf_true;
+				break;
+			}
+		}
+		if (!found)
+			goto unlock;
+
+		/* the walk is past the ones before it */
+		list_for_each_entry_safe(subdir, tmp, &ctx->subdirs, list) {
+			found = !gf_uuid_compare(subdir->gfid, after);
+			list_del(&subdir->list);
+			GF_FREE(subdir);
+			ctx->subdir_count--;
+			if (found)
+				break;
+		}
+	}
+
+	list_for_each_entry(subdir, &ctx->subdirs, list) {
+		if (count >= priv->rda_prefetch_dirs)
+			break;
+		gf_uuid_copy(gfids[count++], subdir->gfid);
+	}
+
+	if (count && ctx->prefetch_keys)
+		keys = dict_ref(ctx->prefetch_keys);
+unlock:
+	UNLOCK(&ctx->lock);
+
+	for (i = 0; i < count; i++) {
+		/* only entries handed out, and so linked, can be opened */
+		inode = inode_find(dir->table, gfids[i]);
+		if (!inode)
+			continue;
+		if (IA_ISDIR(inode->ia_type))
+			rda_prefetch_dir(frame, this, inode, keys);
+		inode_unref(inode);
+	}
+
+	if (keys)
+		dict_unref(keys);
+}
+
+/*
+ * Hand the prefetched first chunk of a directory over to an fd opened on it,
+ * unless it is too old or the directory was modified since it was read.
+ * Returns true if the chunk was the whole directory.
+ */
+static gf_boolean_t
+rda_prefetch_adopt(xlator_t *this, fd_t *fd)
+{
+	struct rda_priv *priv = this->private;
+	struct rda_dir_prefetch *pf;
+	struct rda_fd_ctx *ctx;
+	gf_dirent_t *dirent, *tmp;
+	gf_boolean_t eod = _gf_false;
+
+	pf = rda_prefetch_take(this, fd->inode);
+	if (!pf)
+		return _gf_false;
+
+	if (time(NULL) >= pf->expire ||
+	    rda_inode_modified_since(this, fd->inode, pf->gen))
+		goto out;
+
+	ctx = get_rda_fd_ctx(fd, this);
+	if (!ctx)
+		goto out;
+
+	LOCK(&ctx->lock);
+
+	if (!(ctx->state & RDA_FD_NEW) || ctx->cur_size)
+		goto unlock;
+
+	list_for_each_entry_safe(dirent, tmp, &pf->entries.list, list) {
+		list_del_init(&dirent->list);
+		list_add_tail(&dirent->list, &ctx->entries.list);
+	}
+	ctx->cur_size = pf->size;
+	ctx->next_offset = pf->next_offset;
+	ctx->buffer_gen = pf->gen;
+
+	if (!pf->op_ret) {
+		ctx->state = RDA_FD_EOD;
+		eod = _gf_true;
+	} else {
+		/* serve what we have while the rest is read */
+		ctx->state = RDA_FD_RUNNING;
+	}
+	pf->size = 0;
+
+	__sync_fetch_and_add(&priv->dirs_adopted, 1);
+unlock:
+	UNLOCK(&ctx->lock);
+out:
+	rda_prefetch_destroy(this, pf);
+	return eod;
+}
+
 /*
  * Reset the tracking state of the context.
  */
@@ -125,6 +813,14 @@ __rda_serve_readdirp(xlator_t *this, gf_dirent_t *entries, size_t request_size,
 		list_del_init(&dirent->list);
 		ctx->cur_size -= dirent_size;
 
+		/* modified since it was read, let it be looked up */
+		if (dirent->inode &&
+		    rda_inode_modified_since(this, dirent->inode,
+					     ctx->buffer_gen)) {
+			inode_unref(dirent->inode);
+			dirent->inode = NULL;
+		}
+
 		list_add_tail(&dirent->list, &entries->list);
 		ctx->cur_offset = dirent->d_off;
 		count++;
@@ -143,6 +839,8 @@ rda_readdirp_stub(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 	gf_dirent_t entries;
 	int32_t ret;
 	struct rda_fd_ctx *ctx;
+	struct rda_inode_ctx *ictx;
+	call_frame_t *walk_frame = NULL;
         int op_errno = 0;
 
 	ctx = get_rda_fd_ctx(fd, this);
@@ -166,9 +864,24 @@ rda_readdirp_stub(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
          */
         op_errno = ctx->op_errno;
 
+	/*
+	 * The directory has been listed, a walk enters its subdirectories
+	 * next. They can be opened once the entries are linked by the unwind.
+	 */
+	if (!ret && (ctx->state & RDA_FD_EOD)) {
+		ictx = rda_inode_ctx_get(this, fd->inode, _gf_false);
+		if (ictx && ictx->subdir_count)
+			walk_frame = copy_frame(frame);
+	}
+
 	STACK_UNWIND_STRICT(readdirp, frame, ret, op_errno, &entries, xdata);
 	gf_dirent_free(&entries);
 
+	if (walk_frame) {
+		rda_prefetch_subdirs(walk_frame, this, fd->inode, NULL);
+		STACK_DESTROY(walk_frame->root);
+	}
+
 	return 0;
 }
 
@@ -267,6 +980,10 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 	struct rda_priv *priv = this->private;
 	int fill = 1;
 
+	if (entries && op_ret > 0)
+		rda_entries_fetched(this, local->fd->inode, entries,
+				    ctx->xattrs, local->gen, !local->offset);
+
 	LOCK(&ctx->lock);
 
 	/* Verify that the preload buffer is still pending on this data. */
@@ -281,6 +998,9 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 	}
 
 	if (entries) {
+		if (!ctx->cur_size)
+			ctx->buffer_gen = local->gen;
+
 		list_for_each_entry_safe(dirent, tmp, &entries->list, list) {
 			list_del_init(&dirent->list);
 			/* must preserve entry order */
@@ -381,149 +1101,756 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
 			goto err;
 		}
 
-		local = mem_get0(this->local_pool);
-		if (!local) {
-			UNLOCK(&ctx->lock);
-			goto err;
-		}
+		local = mem_get0(this->local_pool);
+		if (!local) {
+			UNLOCK(&ctx->lock);
+			goto err;
+		}
+
+		local->ctx = ctx;
+		local->fd = fd;
+		nframe->local = local;
+
+		ctx->fill_frame = nframe;
+
+        if (!ctx->xattrs && orig_local && orig_local->xattrs) {
+                /* when this function is invoked by rda_opendir_cbk */
+                ctx->xattrs = dict_ref(orig_local->xattrs);
+        }
+	} else {
+		nframe = ctx->fill_frame;
+		local = nframe->local;
+	}
+
+	local->offset = offset;
+	local->gen = rda_gen(this);
+
+	UNLOCK(&ctx->lock);
+
+        STACK_WIND(nframe, rda_fill_fd_cbk, FIRST_CHILD(this),
+                   FIRST_CHILD(this)->fops->readdirp, fd,
+                   priv->rda_req_size, offset, ctx->xattrs);
+
+	return 0;
+
+err:
+	if (nframe)
+		FRAME_DESTROY(nframe);
+
+	return -1;
+}
+
+
+static int
+rda_unpack_mdc_loaded_keys_to_dict(char *payload, dict_t *dict)
+{
+        int      ret = -1;
+        char    *mdc_key = NULL;
+
+        if (!payload || !dict) {
+                goto out;
+        }
+
+        mdc_key = strtok(payload, " ");
+        while (mdc_key != NULL) {
+                ret = dict_set_int8 (dict, mdc_key, 0);
+                if (ret) {
+                        goto out;
+                }
+                mdc_key = strtok(NULL, " ");
+        }
+
+out:
+        return ret;
+}
+
+
+static int32_t
+rda_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		    int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+        struct rda_local *local = frame->local;
+	struct rda_priv *priv = this->private;
+
+	if (!op_ret) {
+		/* a walk may have read this one ahead already */
+		if (!priv->rda_prefetch_dirs || !rda_prefetch_adopt(this, fd))
+			rda_fill_fd(frame, this, fd);
+
+		if (local && local->parent)
+			rda_prefetch_subdirs(frame, this, local->parent,
+					     fd->inode->gfid);
+	}
+
+        frame->local = NULL;
+
+	STACK_UNWIND_STRICT(opendir, frame, op_ret, op_errno, fd, xdata);
+
+        if (local && local->xattrs) {
+                /* unref for dict_new() done in rda_opendir */
+                dict_unref (local->xattrs);
+                local->xattrs = NULL;
+        }
+
+        if (local && local->parent)
+                inode_unref (local->parent);
+
+        if (local)
+                mem_put (local);
+
+	return 0;
+}
+
+static int32_t
+rda_opendir(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
+		dict_t *xdata)
+{
+        int                  ret = -1;
+        int                  op_errno = 0;
+        char                *payload = NULL;
+        struct rda_local    *local = NULL;
+        dict_t              *xdata_from_req = NULL;
+        struct rda_priv     *priv = this->private;
+
+        /* the walk that opens it is prefetched from its parent */
+        if (priv->rda_prefetch_dirs && loc->parent) {
+                local = mem_get0(this->local_pool);
+                if (!local) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                local->parent = inode_ref(loc->parent);
+                frame->local = local;
+        }
+
+        if (xdata) {
+                /*
+                 * Retrieve list of keys set by md-cache xlator and store it
+                 * in local to be consumed in rda_opendir_cbk
+                 */
+                ret = dict_get_str (xdata, GF_MDC_LOADED_KEY_NAMES, &payload);
+                if (ret)
+                        goto wind;
+
+                xdata_from_req = dict_new();
+                if (!xdata_from_req) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = rda_unpack_mdc_loaded_keys_to_dict((char *) payload,
+                                                         xdata_from_req);
+                if (ret) {
+                        dict_unref(xdata_from_req);
+                        goto wind;
+                }
+
+                if (!local)
+                        local = mem_get0(this->local_pool);
+                if (!local) {
+                        dict_unref(xdata_from_req);
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                local->xattrs = xdata_from_req;
+                frame->local = local;
+        }
+
+wind:
+        if (xdata)
+                /* Remove the key after consumption. */
+                dict_del (xdata, GF_MDC_LOADED_KEY_NAMES);
+
+        STACK_WIND(frame, rda_opendir_cbk, FIRST_CHILD(this),
+                   FIRST_CHILD(this)->fops->opendir, loc, fd, xdata);
+        return 0;
+
+unwind:
+        if (local) {
+                frame->local = NULL;
+                if (local->parent)
+                        inode_unref(local->parent);
+                mem_put(local);
+        }
+        STACK_UNWIND_STRICT(opendir, frame, -1, op_errno, fd, xdata);
+        return 0;
+}
+
+static int32_t
+rda_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+	struct iatt stbuf = {0, };
+
+	if (!xdata && rda_inode_cached_iatt(this, loc->inode, &stbuf)) {
+		STACK_UNWIND_STRICT(stat, frame, 0, 0, &stbuf, NULL);
+		return 0;
+	}
+
+	STACK_WIND(frame, default_stat_cbk, FIRST_CHILD(this),
+		   FIRST_CHILD(this)->fops->stat, loc, xdata);
+	return 0;
+}
+
+static int32_t
+rda_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+	struct iatt stbuf = {0, };
+
+	if (!xdata && rda_inode_cached_iatt(this, fd->inode, &stbuf)) {
+		STACK_UNWIND_STRICT(fstat, frame, 0, 0, &stbuf, NULL);
+		return 0;
+	}
+
+	STACK_WIND(frame, default_fstat_cbk, FIRST_CHILD(this),
+		   FIRST_CHILD(this)->fops->fstat, fd, xdata);
+	return 0;
+}
+
+static int32_t
+rda_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+	     const char *name, dict_t *xdata)
+{
+	dict_t *dict = NULL;
+	int op_ret = 0;
+	int op_errno = 0;
+
+	if (!xdata && name &&
+	    rda_inode_cached_xattr(this, loc->inode, name, &dict, &op_errno)) {
+		op_ret = dict ? 0 : -1;
+		STACK_UNWIND_STRICT(getxattr, frame, op_ret, op_errno, dict,
+				    NULL);
+		if (dict)
+			dict_unref(dict);
+		return 0;
+	}
+
+	STACK_WIND(frame, default_getxattr_cbk, FIRST_CHILD(this),
+		   FIRST_CHILD(this)->fops->getxattr, loc, name, xdata);
+	return 0;
+}
+
+/*
+ * Fops modifying an inode invalidate its prefetched metadata when they are
+ * sent and again when they return, the cookie is the inode.
+ */
+static int32_t
+rda_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	       int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+	       struct iatt *postbuf, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(writev, frame, op_ret, op_errno, prebuf, postbuf,
+			    xdata);
+	return 0;
+}
+
+static int32_t
+rda_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
+	   struct iovec *vector, int32_t count, off_t off, uint32_t flags,
+	   struct iobref *iobref, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_writev_cbk, fd->inode, FIRST_CHILD(this),
+			  FIRST_CHILD(this)->fops->writev, fd, vector, count,
+			  off, flags, iobref, xdata);
+	return 0;
+}
+
+static int32_t
+rda_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+		 struct iatt *postbuf, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(truncate, frame, op_ret, op_errno, prebuf,
+			    postbuf, xdata);
+	return 0;
+}
+
+static int32_t
+rda_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+	     dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_truncate_cbk, loc->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->truncate,
+			  loc, offset, xdata);
+	return 0;
+}
+
+static int32_t
+rda_ftruncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+		  struct iatt *postbuf, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(ftruncate, frame, op_ret, op_errno, prebuf,
+			    postbuf, xdata);
+	return 0;
+}
+
+static int32_t
+rda_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+	      dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_ftruncate_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->ftruncate,
+			  fd, offset, xdata);
+	return 0;
+}
+
+static int32_t
+rda_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+		struct iatt *statpost, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(setattr, frame, op_ret, op_errno, statpre,
+			    statpost, xdata);
+	return 0;
+}
+
+static int32_t
+rda_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+	    struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_setattr_cbk, loc->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->setattr,
+			  loc, stbuf, valid, xdata);
+	return 0;
+}
+
+static int32_t
+rda_fsetattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		 int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+		 struct iatt *statpost, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(fsetattr, frame, op_ret, op_errno, statpre,
+			    statpost, xdata);
+	return 0;
+}
+
+static int32_t
+rda_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+	     struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_fsetattr_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->fsetattr,
+			  fd, stbuf, valid, xdata);
+	return 0;
+}
+
+static int32_t
+rda_fallocate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		  int32_t op_ret, int32_t op_errno, struct iatt *pre,
+		  struct iatt *post, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(fallocate, frame, op_ret, op_errno, pre, post,
+			    xdata);
+	return 0;
+}
+
+static int32_t
+rda_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
+	      off_t offset, size_t len, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_fallocate_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->fallocate,
+			  fd, mode, offset, len, xdata);
+	return 0;
+}
+
+static int32_t
+rda_discard_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		int32_t op_ret, int32_t op_errno, struct iatt *pre,
+		struct iatt *post, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(discard, frame, op_ret, op_errno, pre, post,
+			    xdata);
+	return 0;
+}
+
+static int32_t
+rda_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+	    size_t len, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_discard_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->discard,
+			  fd, offset, len, xdata);
+	return 0;
+}
+
+static int32_t
+rda_zerofill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		 int32_t op_ret, int32_t op_errno, struct iatt *pre,
+		 struct iatt *post, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(zerofill, frame, op_ret, op_errno, pre, post,
+			    xdata);
+	return 0;
+}
 
-		local->ctx = ctx;
-		local->fd = fd;
-		nframe->local = local;
+static int32_t
+rda_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+	     off_t len, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_zerofill_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->zerofill,
+			  fd, offset, len, xdata);
+	return 0;
+}
 
-		ctx->fill_frame = nframe;
+static int32_t
+rda_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	     int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(open, frame, op_ret, op_errno, fd, xdata);
+	return 0;
+}
 
-        if (!ctx->xattrs && orig_local && orig_local->xattrs) {
-                /* when this function is invoked by rda_opendir_cbk */
-                ctx->xattrs = dict_ref(orig_local->xattrs);
-        }
-	} else {
-		nframe = ctx->fill_frame;
-		local = nframe->local;
+static int32_t
+rda_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+	 fd_t *fd, dict_t *xdata)
+{
+	if (!(flags & O_TRUNC)) {
+		STACK_WIND(frame, default_open_cbk, FIRST_CHILD(this),
+			   FIRST_CHILD(this)->fops->open, loc, flags, fd,
+			   xdata);
+		return 0;
 	}
 
-	local->offset = offset;
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_open_cbk, loc->inode, FIRST_CHILD(this),
+			  FIRST_CHILD(this)->fops->open, loc, flags, fd, xdata);
+	return 0;
+}
 
-	UNLOCK(&ctx->lock);
+static int32_t
+rda_setxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		 int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(setxattr, frame, op_ret, op_errno, xdata);
+	return 0;
+}
 
-        STACK_WIND(nframe, rda_fill_fd_cbk, FIRST_CHILD(this),
-                   FIRST_CHILD(this)->fops->readdirp, fd,
-                   priv->rda_req_size, offset, ctx->xattrs);
+static int32_t
+rda_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+	     int32_t flags, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_setxattr_cbk, loc->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->setxattr,
+			  loc, dict, flags, xdata);
+	return 0;
+}
 
+static int32_t
+rda_fsetxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		  int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(fsetxattr, frame, op_ret, op_errno, xdata);
 	return 0;
+}
 
-err:
-	if (nframe)
-		FRAME_DESTROY(nframe);
+static int32_t
+rda_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+	      int32_t flags, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_fsetxattr_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->fsetxattr,
+			  fd, dict, flags, xdata);
+	return 0;
+}
 
-	return -1;
+static int32_t
+rda_removexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		    int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(removexattr, frame, op_ret, op_errno, xdata);
+	return 0;
 }
 
+static int32_t
+rda_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+		const char *name, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_removexattr_cbk, loc->inode,
+			  FIRST_CHILD(this),
+			  FIRST_CHILD(this)->fops->removexattr, loc, name,
+			  xdata);
+	return 0;
+}
 
-static int
-rda_unpack_mdc_loaded_keys_to_dict(char *payload, dict_t *dict)
+static int32_t
+rda_fremovexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		     int32_t op_ret, int32_t op_errno, dict_t *xdata)
 {
-        int      ret = -1;
-        char    *mdc_key = NULL;
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(fremovexattr, frame, op_ret, op_errno, xdata);
+	return 0;
+}
 
-        if (!payload || !dict) {
-                goto out;
-        }
+static int32_t
+rda_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+		 const char *name, dict_t *xdata)
+{
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_fremovexattr_cbk, fd->inode,
+			  FIRST_CHILD(this),
+			  FIRST_CHILD(this)->fops->fremovexattr, fd, name,
+			  xdata);
+	return 0;
+}
 
-        mdc_key = strtok(payload, " ");
-        while (mdc_key != NULL) {
-                ret = dict_set_int8 (dict, mdc_key, 0);
-                if (ret) {
-                        goto out;
-                }
-                mdc_key = strtok(NULL, " ");
-        }
+/*
+ * Entry fops change the directories they work in, and the link count of
+ * the inodes they unlink or link. The cookie is the parent.
+ */
+static int32_t
+rda_xattrop_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		int32_t op_ret, int32_t op_errno, dict_t *dict, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(xattrop, frame, op_ret, op_errno, dict, xdata);
+	return 0;
+}
 
-out:
-        return ret;
+static int32_t
+rda_xattrop(call_frame_t *frame, xlator_t *this, loc_t *loc,
+	    gf_xattrop_flags_t flags, dict_t *dict, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	STACK_WIND_COOKIE(frame, rda_xattrop_cbk, loc->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->xattrop,
+			  loc, flags, dict, xdata);
+	return 0;
 }
 
+static int32_t
+rda_fxattrop_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		 int32_t op_ret, int32_t op_errno, dict_t *dict, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(fxattrop, frame, op_ret, op_errno, dict, xdata);
+	return 0;
+}
 
 static int32_t
-rda_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
-		    int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+rda_fxattrop(call_frame_t *frame, xlator_t *this, fd_t *fd,
+	     gf_xattrop_flags_t flags, dict_t *dict, dict_t *xdata)
 {
-        struct rda_local *local = frame->local;
+	rda_inode_invalidate(this, fd->inode);
+	STACK_WIND_COOKIE(frame, rda_fxattrop_cbk, fd->inode,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->fxattrop,
+			  fd, flags, dict, xdata);
+	return 0;
+}
 
-	if (!op_ret)
-		rda_fill_fd(frame, this, fd);
+static int32_t
+rda_unlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	       int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+	       struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(unlink, frame, op_ret, op_errno, preparent,
+			    postparent, xdata);
+	return 0;
+}
 
-        frame->local = NULL;
+static int32_t
+rda_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
+	   dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_unlink_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->unlink,
+			  loc, xflag, xdata);
+	return 0;
+}
 
-	STACK_UNWIND_STRICT(opendir, frame, op_ret, op_errno, fd, xdata);
+static int32_t
+rda_rmdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	      int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+	      struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(rmdir, frame, op_ret, op_errno, preparent,
+			    postparent, xdata);
+	return 0;
+}
 
-        if (local && local->xattrs) {
-                /* unref for dict_new() done in rda_opendir */
-                dict_unref (local->xattrs);
-                local->xattrs = NULL;
-        }
+static int32_t
+rda_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+	  dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->inode);
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_rmdir_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->rmdir,
+			  loc, flags, xdata);
+	return 0;
+}
 
-        if (local)
-                mem_put (local);
+static int32_t
+rda_link_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	     int32_t op_ret, int32_t op_errno, inode_t *inode,
+	     struct iatt *buf, struct iatt *preparent,
+	     struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(link, frame, op_ret, op_errno, inode, buf,
+			    preparent, postparent, xdata);
+	return 0;
+}
 
+static int32_t
+rda_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+	 dict_t *xdata)
+{
+	rda_inode_invalidate(this, oldloc->inode);
+	rda_inode_invalidate(this, newloc->parent);
+	STACK_WIND_COOKIE(frame, rda_link_cbk, newloc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->link,
+			  oldloc, newloc, xdata);
 	return 0;
 }
 
 static int32_t
-rda_opendir(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
-		dict_t *xdata)
+rda_rename_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	       int32_t op_ret, int32_t op_errno, struct iatt *buf,
+	       struct iatt *preoldparent, struct iatt *postoldparent,
+	       struct iatt *prenewparent, struct iatt *postnewparent,
+	       dict_t *xdata)
 {
-        int                  ret = -1;
-        int                  op_errno = 0;
-        char                *payload = NULL;
-        struct rda_local    *local = NULL;
-        dict_t              *xdata_from_req = NULL;
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(rename, frame, op_ret, op_errno, buf, preoldparent,
+			    postoldparent, prenewparent, postnewparent, xdata);
+	return 0;
+}
 
-        if (xdata) {
-                /*
-                 * Retrieve list of keys set by md-cache xlator and store it
-                 * in local to be consumed in rda_opendir_cbk
-                 */
-                ret = dict_get_str (xdata, GF_MDC_LOADED_KEY_NAMES, &payload);
-                if (ret)
-                        goto wind;
+static int32_t
+rda_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+	   loc_t *newloc, dict_t *xdata)
+{
+	rda_inode_invalidate(this, oldloc->inode);
+	rda_inode_invalidate(this, oldloc->parent);
+	rda_inode_invalidate(this, newloc->inode);
+	rda_inode_invalidate(this, newloc->parent);
+	STACK_WIND_COOKIE(frame, rda_rename_cbk, newloc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->rename,
+			  oldloc, newloc, xdata);
+	return 0;
+}
 
-                xdata_from_req = dict_new();
-                if (!xdata_from_req) {
-                        op_errno = ENOMEM;
-                        goto unwind;
-                }
+static int32_t
+rda_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	       int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+	       struct iatt *buf, struct iatt *preparent,
+	       struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(create, frame, op_ret, op_errno, fd, inode, buf,
+			    preparent, postparent, xdata);
+	return 0;
+}
 
-                ret = rda_unpack_mdc_loaded_keys_to_dict((char *) payload,
-                                                         xdata_from_req);
-                if (ret) {
-                        dict_unref(xdata_from_req);
-                        goto wind;
-                }
+static int32_t
+rda_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+	   mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_create_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->create,
+			  loc, flags, mode, umask, fd, xdata);
+	return 0;
+}
 
-                local = mem_get0(this->local_pool);
-                if (!local) {
-                        dict_unref(xdata_from_req);
-                        op_errno = ENOMEM;
-                        goto unwind;
-                }
+static int32_t
+rda_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	      int32_t op_ret, int32_t op_errno, inode_t *inode,
+	      struct iatt *buf, struct iatt *preparent,
+	      struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(mkdir, frame, op_ret, op_errno, inode, buf,
+			    preparent, postparent, xdata);
+	return 0;
+}
 
-                local->xattrs = xdata_from_req;
-                frame->local = local;
-        }
+static int32_t
+rda_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+	  mode_t umask, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_mkdir_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->mkdir,
+			  loc, mode, umask, xdata);
+	return 0;
+}
 
-wind:
-        if (xdata)
-                /* Remove the key after consumption. */
-                dict_del (xdata, GF_MDC_LOADED_KEY_NAMES);
+static int32_t
+rda_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+	      int32_t op_ret, int32_t op_errno, inode_t *inode,
+	      struct iatt *buf, struct iatt *preparent,
+	      struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(mknod, frame, op_ret, op_errno, inode, buf,
+			    preparent, postparent, xdata);
+	return 0;
+}
 
-        STACK_WIND(frame, rda_opendir_cbk, FIRST_CHILD(this),
-                   FIRST_CHILD(this)->fops->opendir, loc, fd, xdata);
-        return 0;
+static int32_t
+rda_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+	  dev_t rdev, mode_t umask, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_mknod_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->mknod,
+			  loc, mode, rdev, umask, xdata);
+	return 0;
+}
 
-unwind:
-        STACK_UNWIND_STRICT(opendir, frame, -1, op_errno, fd, xdata);
-        return 0;
+static int32_t
+rda_symlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+		int32_t op_ret, int32_t op_errno, inode_t *inode,
+		struct iatt *buf, struct iatt *preparent,
+		struct iatt *postparent, dict_t *xdata)
+{
+	rda_inode_invalidate(this, cookie);
+	STACK_UNWIND_STRICT(symlink, frame, op_ret, op_errno, inode, buf,
+			    preparent, postparent, xdata);
+	return 0;
+}
+
+static int32_t
+rda_symlink(call_frame_t *frame, xlator_t *this, const char *linkname,
+	    loc_t *loc, mode_t umask, dict_t *xdata)
+{
+	rda_inode_invalidate(this, loc->parent);
+	STACK_WIND_COOKIE(frame, rda_symlink_cbk, loc->parent,
+			  FIRST_CHILD(this), FIRST_CHILD(this)->fops->symlink,
+			  linkname, loc, umask, xdata);
+	return 0;
 }
 
 static int32_t
@@ -553,6 +1880,44 @@ rda_releasedir(xlator_t *this, fd_t *fd)
 	return 0;
 }
 
+static int32_t
+rda_forget(xlator_t *this, inode_t *inode)
+{
+	uint64_t val = 0;
+
+	if (inode_ctx_del(inode, this, &val) < 0 || !val)
+		return 0;
+
+	rda_inode_ctx_destroy((struct rda_inode_ctx *) (uintptr_t) val);
+	return 0;
+}
+
+static int32_t
+rda_priv_dump(xlator_t *this)
+{
+	struct rda_priv *priv = this->private;
+	char key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+	if (!priv)
+		return -1;
+
+	gf_proc_dump_build_key(key_prefix, "xlator.performance.readdir-ahead",
+			       "priv");
+	gf_proc_dump_add_section(key_prefix);
+
+	gf_proc_dump_write("cache_timeout", "%u", priv->rda_cache_timeout);
+	gf_proc_dump_write("cache_metadata", "%d", priv->rda_cache_metadata);
+	gf_proc_dump_write("prefetch_dirs", "%u", priv->rda_prefetch_dirs);
+	gf_proc_dump_write("stat_hits", "%"PRIu64, priv->stat_hits);
+	gf_proc_dump_write("getxattr_hits", "%"PRIu64, priv->getxattr_hits);
+	gf_proc_dump_write("dirs_prefetched", "%"PRIu64,
+			   priv->dirs_prefetched);
+	gf_proc_dump_write("dirs_adopted", "%"PRIu64, priv->dirs_adopted);
+	gf_proc_dump_write("prefetches_pending", "%u", priv->prefetch_count);
+
+	return 0;
+}
+
 int32_t
 mem_acct_init(xlator_t *this)
 {
@@ -583,6 +1948,15 @@ reconfigure(xlator_t *this, dict_t *options)
 			 err);
 	GF_OPTION_RECONF("rda-high-wmark", priv->rda_high_wmark, options, size_uint64,
 			 err);
+	GF_OPTION_RECONF("rda-cache-timeout", priv->rda_cache_timeout, options,
+			 uint32, err);
+	GF_OPTION_RECONF("rda-cache-metadata", priv->rda_cache_metadata,
+			 options, bool, err);
+	GF_OPTION_RECONF("rda-prefetch-dirs", priv->rda_prefetch_dirs, options,
+			 uint32, err);
+
+	/* fewer prefetches may be kept now */
+	rda_prefetch_evict(this);
 
 	return 0;
 err:
@@ -614,6 +1988,8 @@ init(xlator_t *this)
 	if (!priv)
 		goto err;
 	this->private = priv;
+	LOCK_INIT(&priv->lock);
+	INIT_LIST_HEAD(&priv->prefetched);
 
 	this->local_pool = mem_pool_new(struct rda_local, 32);
 	if (!this->local_pool)
@@ -622,6 +1998,10 @@ init(xlator_t *this)
 	GF_OPTION_INIT("rda-request-size", priv->rda_req_size, uint32, err);
 	GF_OPTION_INIT("rda-low-wmark", priv->rda_low_wmark, size_uint64, err);
 	GF_OPTION_INIT("rda-high-wmark", priv->rda_high_wmark, size_uint64, err);
+	GF_OPTION_INIT("rda-cache-timeout", priv->rda_cache_timeout, uint32, err);
+	GF_OPTION_INIT("rda-cache-metadata", priv->rda_cache_metadata, bool,
+		       err);
+	GF_OPTION_INIT("rda-prefetch-dirs", priv->rda_prefetch_dirs, uint32, err);
 
 	return 0;
 
@@ -649,10 +2029,41 @@ out:
 struct xlator_fops fops = {
 	.opendir	= rda_opendir,
 	.readdirp	= rda_readdirp,
+	.stat		= rda_stat,
+	.fstat		= rda_fstat,
+	.getxattr	= rda_getxattr,
+	.open		= rda_open,
+	.writev		= rda_writev,
+	.truncate	= rda_truncate,
+	.ftruncate	= rda_ftruncate,
+	.setattr	= rda_setattr,
+	.fsetattr	= rda_fsetattr,
+	.fallocate	= rda_fallocate,
+	.discard	= rda_discard,
+	.zerofill	= rda_zerofill,
+	.setxattr	= rda_setxattr,
+	.fsetxattr	= rda_fsetxattr,
+	.removexattr	= rda_removexattr,
+	.fremovexattr	= rda_fremovexattr,
+	.xattrop	= rda_xattrop,
+	.fxattrop	= rda_fxattrop,
+	.unlink		= rda_unlink,
+	.rmdir		= rda_rmdir,
+	.link		= rda_link,
+	.rename		= rda_rename,
+	.create		= rda_create,
+	.mkdir		= rda_mkdir,
+	.mknod		= rda_mknod,
+	.symlink	= rda_symlink,
 };
 
 struct xlator_cbks cbks = {
 	.releasedir	= rda_releasedir,
+	.forget		= rda_forget,
+};
+
+struct xlator_dumpops dumpops = {
+	.priv		= rda_priv_dump,
 };
 
 struct volume_options options[] = {
@@ -677,6 +2088,28 @@ struct volume_options options[] = {
 	  .default_value = "131072",
 	  .description = "the value over which we unplug",
 	},
+	{ .key = {"rda-cache-timeout"},
+	  .type = GF_OPTION_TYPE_INT,
+	  .min = 0,
+	  .max = 60,
+	  .default_value = "1",
+	  .description = "seconds the metadata of prefetched entries and the "
+			 "prefetched directories are kept, 0 to disable",
+	},
+	{ .key = {"rda-cache-metadata"},
+	  .type = GF_OPTION_TYPE_BOOL,
+	  .default_value = "off",
+	  .description = "serve stat, fstat and getxattr of the keys md-cache "
+			 "asks for from the metadata of prefetched entries",
+	},
+	{ .key = {"rda-prefetch-dirs"},
+	  .type = GF_OPTION_TYPE_INT,
+	  .min = 0,
+	  .max = RDA_MAX_PREFETCH_DIRS,
+	  .default_value = "4",
+	  .description = "number of subdirectories read ahead of a directory "
+			 "walk entering them, 0 to disable",
+	},
         { .key = {NULL} },
 };
 
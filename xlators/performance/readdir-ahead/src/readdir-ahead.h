@@ -19,6 +19,18 @@
 #define RDA_FD_BYPASS	(1 << 4)
 #define RDA_FD_PLUGGED	(1 << 5)
 
+/* most subdirectories remembered per directory for prefetching */
+#define RDA_MAX_SUBDIRS	1024
+#define RDA_MAX_PREFETCH_DIRS	64
+
+/* unopened prefetched directories kept before the oldest are dropped */
+#define RDA_PREFETCH_KEEP(priv)	(4 * (priv)->rda_prefetch_dirs)
+
+/* prefetch states */
+#define RDA_PREFETCH_RUNNING	0
+#define RDA_PREFETCH_DONE	1
+#define RDA_PREFETCH_ABANDONED	2
+
 struct rda_fd_ctx {
 	off_t cur_offset;	/* current head of the ctx */
 	size_t cur_size;	/* current size of the preload */
@@ -30,6 +42,52 @@ struct rda_fd_ctx {
 	call_stub_t *stub;
 	int op_errno;
         dict_t *xattrs;      /* md-cache keys to be sent in readdirp() */
+	uint64_t buffer_gen;	/* generation when the oldest buffered entry
+				   was fetched */
+};
+
+/*
+ * A directory read ahead of its opendir during a recursive walk. The entries
+ * are handed over to the fd of the first opendir of the directory.
+ */
+struct rda_inode_ctx;
+
+struct rda_dir_prefetch {
+	struct list_head list;	/* in priv->prefetched */
+	int state;		/* guarded by priv->lock */
+	struct rda_inode_ctx *ictx;
+	fd_t *fd;
+	gf_dirent_t entries;
+	size_t size;
+	off_t next_offset;
+	int op_ret;
+	int op_errno;
+	uint64_t gen;
+	time_t expire;		/* adopted until then once done */
+	dict_t *xattrs;
+};
+
+struct rda_subdir {
+	struct list_head list;
+	uuid_t gfid;
+};
+
+/*
+ * Metadata of the entries prefetched by readdirp, for stat, fstat and
+ * getxattr of the keys md-cache asked for.
+ */
+struct rda_inode_ctx {
+	gf_lock_t lock;
+	uint64_t gen;		/* last local modification */
+	gf_boolean_t valid;
+	time_t expire;
+	struct iatt statbuf;
+	dict_t *xattrs;		/* values fetched with the entry */
+	dict_t *keys;		/* keys that were asked for */
+	struct rda_dir_prefetch *prefetch;	/* guarded by priv->lock */
+	struct list_head subdirs;	/* of a directory, in readdir order */
+	uint32_t subdir_count;
+	dict_t *prefetch_keys;	/* to read the subdirectories with */
 };
 
 struct rda_local {
@@ -37,12 +95,29 @@ struct rda_local {
 	fd_t *fd;
 	off_t offset;
         dict_t *xattrs;      /* md-cache keys to be sent in readdirp() */
+	uint64_t gen;
+	inode_t *parent;
+	inode_t *inode;
+	struct rda_dir_prefetch *prefetch;
 };
 
 struct rda_priv {
 	uint32_t rda_req_size;
 	uint64_t rda_low_wmark;
 	uint64_t rda_high_wmark;
+	uint32_t rda_cache_timeout;
+	gf_boolean_t rda_cache_metadata;
+	uint32_t rda_prefetch_dirs;
+	uint64_t gen;
+	uint64_t gen_floor;	/* last modification not recorded on its inode,
+				   every new inode context starts out there */
+	gf_lock_t lock;
+	struct list_head prefetched;	/* oldest last */
+	uint32_t prefetch_count;
+	uint64_t stat_hits;
+	uint64_t getxattr_hits;
+	uint64_t dirs_prefetched;
+	uint64_t dirs_adopted;
 };
 
 #endif /* __READDIR_AHEAD_H */
@@ -20,11 +20,12 @@
 #include "call-stub.h"
 #include "statedump.h"
 #include "defaults.h"
+#include "interval-tree.h"
 #include "write-behind-mem-types.h"
 #include "write-behind-messages.h"
 
 #define MAX_VECTOR_COUNT          8
-#define WB_AGGREGATE_SIZE         131072 /* 128 KB */
+#define WB_AGGREGATE_SIZE_MAX     1048576 /* 1MB */
 #define WB_WINDOW_SIZE            1048576 /* 1MB */
 
 typedef struct list_head list_head_t;
@@ -105,6 +106,18 @@ typedef struct wb_inode {
 				liability generation higher than itself)
 			     */
 	size_t       size; /* Size of the file to catch write after EOF. */
+
+        itree_t      liability_tree; /* @liability indexed by byte range, so
+                                        that causal checks of new requests
+                                        need not walk the whole list.
+                                     */
+        itree_t      wip_tree;       /* same for @wip */
+        uint32_t     append_liabilities; /* appends in @liability. They
+                                            conflict with everything, so
+                                            checks fall back to the list
+                                            while there are any.
+                                         */
+        uint64_t     lie_seq;  /* order of addition to @liability */
         gf_lock_t    lock;
         xlator_t    *this;
         int          dontsync; /* If positive, dont pick lies for
@@ -148,9 +161,16 @@ typedef struct wb_request {
         glusterfs_fop_t       fop;
         gf_lkowner_t          lk_owner;
 	struct iobref        *iobref;
+        size_t                iobuf_size;  /* capacity of the buffer in
+                                              @iobref that small writes are
+                                              collapsed into */
 	uint64_t              gen;  /* inode liability state at the time of
 				       request arrival */
 
+        itree_node_t          lie_node; /* in wb_inode->liability_tree */
+        itree_node_t          wip_node; /* in wb_inode->wip_tree */
+        uint64_t              lie_seq;  /* position in @liability */
+
 	fd_t                 *fd;
         int                   wind_count;    /* number of sync-attempts. Only
                                                 for debug purposes */
@@ -237,6 +257,18 @@ out:
   }
 */
 
+static void
+wb_request_range (wb_request_t *req, uint64_t *start, uint64_t *end)
+{
+        *start = req->ordering.off;
+
+        if (req->ordering.size)
+                *end = *start + req->ordering.size - 1;
+        else
+                *end = ULLONG_MAX;
+}
+
+
 gf_boolean_t
 wb_requests_overlap (wb_request_t *req1, wb_request_t *req2)
 {
@@ -246,17 +278,8 @@ wb_requests_overlap (wb_request_t *req1, wb_request_t *req2)
 	uint64_t         r2_end = 0;
         enum _gf_boolean do_overlap = 0;
 
-        r1_start = req1->ordering.off;
-	if (req1->ordering.size)
-		r1_end = r1_start + req1->ordering.size - 1;
-	else
-		r1_end = ULLONG_MAX;
-
-        r2_start = req2->ordering.off;
-	if (req2->ordering.size)
-		r2_end = r2_start + req2->ordering.size - 1;
-	else
-		r2_end = ULLONG_MAX;
+        wb_request_range (req1, &r1_start, &r1_end);
+        wb_request_range (req2, &r2_start, &r2_end);
 
         do_overlap = ((r1_end >= r2_start) && (r2_end >= r1_start));
 
@@ -296,39 +319,165 @@ wb_requests_conflict (wb_request_t *lie, wb_request_t *req)
 }
 
 
+static void
+__wb_request_liability_add (wb_request_t *req)
+{
+        wb_inode_t *wb_inode = req->wb_inode;
+        uint64_t    start    = 0;
+        uint64_t    end      = 0;
+
+        list_add_tail (&req->lie, &wb_inode->liability);
+
+        wb_request_range (req, &start, &end);
+        itree_insert (&wb_inode->liability_tree, &req->lie_node, start, end);
+
+        req->lie_seq = ++wb_inode->lie_seq;
+
+        if (req->ordering.append)
+                wb_inode->append_liabilities++;
+}
+
+
+/* takes @req off either @liability or @temptation */
+static void
+__wb_request_lie_del (wb_request_t *req)
+{
+        wb_inode_t *wb_inode = req->wb_inode;
+
+        if (itree_node_linked (&req->lie_node)) {
+                itree_remove (&wb_inode->liability_tree, &req->lie_node);
+
+                if (req->ordering.append)
+                        wb_inode->append_liabilities--;
+        }
+
+        list_del_init (&req->lie);
+}
+
+
+static void
+__wb_request_wip_add (wb_request_t *req)
+{
+        wb_inode_t *wb_inode = req->wb_inode;
+        uint64_t    start    = 0;
+        uint64_t    end      = 0;
+
+        list_add_tail (&req->wip, &wb_inode->wip);
+
+        wb_request_range (req, &start, &end);
+        itree_insert (&wb_inode->wip_tree, &req->wip_node, start, end);
+}
+
+
+static void
+__wb_request_wip_del (wb_request_t *req)
+{
+        itree_remove (&req->wb_inode->wip_tree, &req->wip_node);
+
+        list_del_init (&req->wip);
+}
+
+
+/* the range of a collapsing @holder grows, re-index it if it is a lie */
+static void
+__wb_request_range_changed (wb_request_t *req)
+{
+        wb_inode_t *wb_inode = req->wb_inode;
+        uint64_t    start    = 0;
+        uint64_t    end      = 0;
+
+        if (!itree_node_linked (&req->lie_node))
+                return;
+
+        itree_remove (&wb_inode->liability_tree, &req->lie_node);
+
+        wb_request_range (req, &start, &end);
+        itree_insert (&wb_inode->liability_tree, &req->lie_node, start, end);
+}
+
+
+struct wb_conflict_search {
+        wb_request_t *req;
+        wb_request_t *conflict;
+};
+
+
+static int
+wb_liability_conflict_fn (itree_node_t *node, void *data)
+{
+        struct wb_conflict_search *search = data;
+        wb_request_t              *each   = NULL;
+
+        each = list_entry (node, wb_request_t, lie_node);
+
+        if ((each == search->req) || (each->gen >= search->req->gen))
+                return 0;
+
+        /* report the oldest liability, as a walk of the list would */
+        if (!search->conflict || (each->lie_seq < search->conflict->lie_seq))
+                search->conflict = each;
+
+        return 0;
+}
+
+
 wb_request_t *
 wb_liability_has_conflict (wb_inode_t *wb_inode, wb_request_t *req)
 {
-        wb_request_t *each     = NULL;
+        wb_request_t              *each   = NULL;
+        wb_conf_t                 *conf   = NULL;
+        struct wb_conflict_search  search = {0, };
+        uint64_t                   start  = 0;
+        uint64_t                   end    = 0;
+
+        conf = wb_inode->this->private;
 
-        list_for_each_entry (each, &wb_inode->liability, lie) {
-		if (wb_requests_conflict (each, req))
-			return each;
+        if (conf->strict_write_ordering || wb_inode->append_liabilities) {
+                /* ordering is not purely by range, check every lie */
+                list_for_each_entry (each, &wb_inode->liability, lie) {
+                        if (wb_requests_conflict (each, req))
+                                return each;
+                }
+
+                return NULL;
         }
 
-        return NULL;
+        search.req = req;
+        wb_request_range (req, &start, &end);
+
+        itree_walk_overlaps (&wb_inode->liability_tree, start, end,
+                             wb_liability_conflict_fn, &search);
+
+        return search.conflict;
+}
+
+
+static int
+wb_wip_conflict_fn (itree_node_t *node, void *data)
+{
+        wb_request_t *req = data;
+
+        /* request never conflicts with itself, though this condition
+           should never occur. */
+        return (list_entry (node, wb_request_t, wip_node) != req);
 }
 
 
 gf_boolean_t
 wb_wip_has_conflict (wb_inode_t *wb_inode, wb_request_t *req)
 {
-        wb_request_t *each     = NULL;
+        uint64_t start = 0;
+        uint64_t end   = 0;
 
 	if (req->stub->fop != GF_FOP_WRITE)
 		/* non-writes fundamentally never conflict with WIP requests */
 		return _gf_false;
 
-        list_for_each_entry (each, &wb_inode->wip, wip) {
-		if (each == req)
-			/* request never conflicts with itself,
-			   though this condition should never occur.
-			*/
-			continue;
+        wb_request_range (req, &start, &end);
 
-		if (wb_requests_overlap (each, req))
-			return _gf_true;
-        }
+        if (itree_walk_overlaps (&wb_inode->wip_tree, start, end,
+                                 wb_wip_conflict_fn, req))
+                return _gf_true;
 
         return _gf_false;
 }
@@ -352,12 +501,13 @@ __wb_request_unref (wb_request_t *req)
         ret = --req->refcount;
         if (req->refcount == 0) {
                 list_del_init (&req->todo);
-                list_del_init (&req->lie);
-		list_del_init (&req->wip);
+                __wb_request_lie_del (req);
+		__wb_request_wip_del (req);
 
 		list_del_init (&req->all);
 		if (list_empty (&wb_inode->all)) {
 			wb_inode->gen = 0;
+			wb_inode->lie_seq = 0;
 			/* in case of accounting errors? */
 			wb_inode->window_current = 0;
 		}
@@ -461,6 +611,8 @@ wb_enqueue_common (wb_inode_t *wb_inode, call_stub_t *stub, int tempted)
         INIT_LIST_HEAD (&req->winds);
         INIT_LIST_HEAD (&req->unwinds);
         INIT_LIST_HEAD (&req->wip);
+        itree_node_init (&req->lie_node);
+        itree_node_init (&req->wip_node);
 
         req->stub = stub;
         req->wb_inode = wb_inode;
@@ -607,6 +759,8 @@ __wb_inode_create (xlator_t *this, inode_t *inode)
         INIT_LIST_HEAD (&wb_inode->liability);
         INIT_LIST_HEAD (&wb_inode->temptation);
         INIT_LIST_HEAD (&wb_inode->wip);
+        itree_init (&wb_inode->liability_tree);
+        itree_init (&wb_inode->wip_tree);
 
         wb_inode->this = this;
 
@@ -718,7 +872,7 @@ __wb_add_request_for_retry (wb_request_t *req)
 
         list_del_init (&req->winds);
         list_del_init (&req->todo);
-        list_del_init (&req->wip);
+        __wb_request_wip_del (req);
 
         /* sanitize ordering flags to retry */
         req->ordering.go = 0;
@@ -1172,14 +1326,14 @@ __wb_pick_unwinds (wb_inode_t *wb_inode, list_head_t *lies)
 		    wb_inode->window_current > wb_inode->window_conf)
 			continue;
 
-		list_del_init (&req->lie);
+		__wb_request_lie_del (req);
 		list_move_tail (&req->unwinds, lies);
 
 		wb_inode->window_current += req->orig_size;
 
 		if (!req->ordering.fulfilled) {
 			/* burden increased */
-			list_add_tail (&req->lie, &wb_inode->liability);
+			__wb_request_liability_add (req);
 
 			req->ordering.lied = 1;
 
@@ -1192,24 +1346,37 @@ __wb_pick_unwinds (wb_inode_t *wb_inode, list_head_t *lies)
 
 
 int
-__wb_collapse_small_writes (wb_request_t *holder, wb_request_t *req)
+__wb_collapse_small_writes (wb_conf_t *conf, wb_request_t *holder,
+                            wb_request_t *req)
 {
         char          *ptr    = NULL;
         struct iobuf  *iobuf  = NULL;
         struct iobref *iobref = NULL;
         int            ret    = -1;
         ssize_t        required_size = 0;
+        ssize_t        grown_size = 0;
         size_t         holder_len = 0;
         size_t         req_len = 0;
 
-        if (!holder->iobref) {
+        req_len = iov_length (req->stub->args.vector, req->stub->args.count);
+
+        /* The buffer is sized for what is collapsed so far, and regrown up
+           to aggregate-size as more small writes come in. It at least
+           doubles every time, so what is held is only copied a few times
+           on the way to a full aggregate. */
+        if (!holder->iobref ||
+            (holder->write_size + req_len) > holder->iobuf_size) {
                 holder_len = iov_length (holder->stub->args.vector,
                                          holder->stub->args.count);
-                req_len = iov_length (req->stub->args.vector,
-                                      req->stub->args.count);
 
                 required_size = max ((THIS->ctx->page_size),
                                      (holder_len + req_len));
+                if (holder->iobref) {
+                        grown_size = min ((ssize_t) (2 * holder->iobuf_size),
+                                          (ssize_t) conf->aggregate_size);
+                        required_size = max (required_size, grown_size);
+                }
+
                 iobuf = iobuf_get2 (req->wb_inode->this->ctx->iobuf_pool,
                                     required_size);
                 if (iobuf == NULL) {
@@ -1241,8 +1408,14 @@ __wb_collapse_small_writes (wb_request_t *holder, wb_request_t *req)
                 iobref_unref (holder->stub->args.iobref);
                 holder->stub->args.iobref = iobref;
 
+                /* following small writes also go into what the arena
+                   rounded the buffer up to */
+                holder->iobuf_size = iobuf_pagesize (iobuf);
+
                 iobuf_unref (iobuf);
 
+                if (holder->iobref)
+                        iobref_unref (holder->iobref);
                 holder->iobref = iobref_ref (iobref);
         }
 
@@ -1255,12 +1428,35 @@ __wb_collapse_small_writes (wb_request_t *holder, wb_request_t *req)
         holder->write_size += req->write_size;
         holder->ordering.size += req->write_size;
 
+        __wb_request_range_changed (holder);
+
         ret = 0;
 out:
         return ret;
 }
 
 
+/* How much more @holder can take. Collapsed writes stop at the next
+   multiple of aggregate-size in the file, so that a stream of small
+   appends reaches the server as large, aligned writes. */
+static ssize_t
+__wb_holder_space_left (wb_conf_t *conf, wb_request_t *holder)
+{
+        ssize_t  space_left = 0;
+        uint64_t boundary   = 0;
+        uint64_t end        = 0;
+
+        space_left = conf->aggregate_size - holder->write_size;
+
+        end = holder->stub->args.offset + holder->write_size;
+        boundary = conf->aggregate_size - (end % conf->aggregate_size);
+        if (boundary == conf->aggregate_size)
+                return 0;
+
+        return min (space_left, (ssize_t) boundary);
+}
+
+
 void
 __wb_preprocess_winds (wb_inode_t *wb_inode)
 {
@@ -1271,7 +1467,6 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
 	wb_request_t *holder          = NULL;
 	wb_conf_t    *conf            = NULL;
         int           ret             = 0;
-	ssize_t       page_size       = 0;
 
 	/* With asynchronous IO from a VM guest (as a file), there
 	   can be two sequential writes happening in two regions
@@ -1282,7 +1477,6 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
 	   through the interleaved ops
 	*/
 
-	page_size = wb_inode->this->ctx->page_size;
 	conf = wb_inode->this->private;
 
         list_for_each_entry_safe (req, tmp, &wb_inode->todo, todo) {
@@ -1333,7 +1527,7 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
                         continue;
                 }
 
-		space_left = page_size - holder->write_size;
+		space_left = __wb_holder_space_left (conf, holder);
 
 		if (space_left < req->write_size) {
 			holder->ordering.go = 1;
@@ -1341,7 +1535,7 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
 			continue;
 		}
 
-		ret = __wb_collapse_small_writes (holder, req);
+		ret = __wb_collapse_small_writes (conf, holder, req);
 		if (ret)
 			continue;
 
@@ -1403,7 +1597,7 @@ __wb_handle_failed_conflict (wb_request_t *req, wb_request_t *conflict,
                                  * wb_do_unwinds too. Otherwise there'll be
                                  * a double wind.
                                  */
-                                list_del_init (&req->lie);
+                                __wb_request_lie_del (req);
                                 __wb_fulfill_request (req);
                         }
 
@@ -1477,7 +1671,7 @@ __wb_pick_winds (wb_inode_t *wb_inode, list_head_t *tasks,
 			if (wb_wip_has_conflict (wb_inode, req))
 				continue;
 
-			list_add_tail (&req->wip, &wb_inode->wip);
+			__wb_request_wip_add (req);
                         req->wind_count++;
 
 			if (!req->ordering.tempted)
@@ -2410,6 +2604,11 @@ wb_inode_dump (xlator_t *this, inode_t *inode)
         ret = TRY_LOCK (&wb_inode->lock);
         if (!ret)
         {
+                gf_proc_dump_write ("liabilities", "%"PRIu64,
+                                    wb_inode->liability_tree.count);
+                gf_proc_dump_write ("wip", "%"PRIu64,
+                                    wb_inode->wip_tree.count);
+
                 if (!list_empty (&wb_inode->all)) {
                         __wb_dump_requests (&wb_inode->all, key_prefix);
                 }
@@ -2461,6 +2660,18 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("cache-size", conf->window_size, options, size_uint64,
                           out);
 
+        GF_OPTION_RECONF ("aggregate-size", conf->aggregate_size, options,
+                          size_uint64, out);
+
+        if (conf->window_size < conf->aggregate_size) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        WRITE_BEHIND_MSG_EXCEEDED_MAX_SIZE,
+                        "aggregate-size(%"PRIu64") cannot be more than "
+                        "window-size(%"PRIu64"), using window-size",
+                        conf->aggregate_size, conf->window_size);
+                conf->aggregate_size = conf->window_size;
+        }
+
         GF_OPTION_RECONF ("flush-behind", conf->flush_behind, options, bool,
                           out);
 
@@ -2508,7 +2719,8 @@ init (xlator_t *this)
         }
 
         /* configure 'options aggregate-size <size>' */
-        conf->aggregate_size = WB_AGGREGATE_SIZE;
+        GF_OPTION_INIT ("aggregate-size", conf->aggregate_size, size_uint64,
+                        out);
 
         /* configure 'option window-size <size>' */
         GF_OPTION_INIT ("cache-size", conf->window_size, size_uint64, out);
@@ -2522,13 +2734,15 @@ init (xlator_t *this)
                 conf->window_size = conf->aggregate_size;
         }
 
+        /* clamped as in reconfigure, so that a volume set accepted on a
+           running graph does not keep it from starting again */
         if (conf->window_size < conf->aggregate_size) {
-                gf_msg (this->name, GF_LOG_ERROR, 0,
+                gf_msg (this->name, GF_LOG_WARNING, 0,
                         WRITE_BEHIND_MSG_EXCEEDED_MAX_SIZE,
                         "aggregate-size(%"PRIu64") cannot be more than "
-                        "window-size(%"PRIu64")", conf->aggregate_size,
-                        conf->window_size);
-                goto out;
+                        "window-size(%"PRIu64"), using window-size",
+                        conf->aggregate_size, conf->window_size);
+                conf->aggregate_size = conf->window_size;
         }
 
         /* configure 'option flush-behind <on/off>' */
@@ -2619,6 +2833,16 @@ struct volume_options options[] = {
           .description = "Size of the write-behind buffer for a single file "
                          "(inode)."
         },
+        { .key  = {"aggregate-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 4 * GF_UNIT_KB,
+          .max  = WB_AGGREGATE_SIZE_MAX,
+          .default_value = "128KB",
+          .description = "Consecutive small writes to a file are coalesced "
+                         "into a single write of up to this size, aligned "
+                         "to a multiple of it in the file, before being "
+                         "sent to the backend."
+        },
         { .key = {"trickling-writes"},
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "on",
@@ -587,6 +587,13 @@ server_resolve_done (call_frame_t *frame)
 
         server_print_request (frame);
 
+        if (frame->root->ctx->fop_trace) {
+                if (state->loc.inode)
+                        gf_fop_trace_set_gfid (frame, state->loc.inode->gfid);
+                else if (state->fd)
+                        gf_fop_trace_set_gfid (frame, state->fd->inode->gfid);
+        }
+
         state->resume_fn (frame, frame->root->client->bound_xl);
 
         return 0;
@@ -23,6 +23,7 @@
 #include "xlator.h"
 #include "syscall.h"
 #include "posix-messages.h"
+#include "statedump.h"
 
 #include "compat-errno.h"
 
@@ -352,6 +353,369 @@ err:
 }
 
 
+static int
+posix_hpath_hash (uuid_t gfid)
+{
+        return ((gfid[14] << 8) | gfid[15]) % POSIX_HPATH_BUCKETS;
+}
+
+
+int
+posix_hpath_cache_init (xlator_t *this, uint32_t limit)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+        int                   i     = 0;
+
+        priv = this->private;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_hpath_t);
+        if (!cache)
+                return -1;
+
+        LOCK_INIT (&cache->lock);
+        for (i = 0; i < POSIX_HPATH_BUCKETS; i++)
+                INIT_LIST_HEAD (&cache->buckets[i]);
+        INIT_LIST_HEAD (&cache->lru);
+        cache->limit = limit;
+
+        priv->hpath_cache = cache;
+
+        return 0;
+}
+
+
+static void
+__posix_hpath_del (posix_hpath_cache_t *cache, posix_hpath_t *hpath)
+{
+        list_del (&hpath->hash);
+        list_del (&hpath->lru);
+        cache->count--;
+        GF_FREE (hpath);
+}
+
+
+static void
+__posix_hpath_cache_shrink (posix_hpath_cache_t *cache, uint32_t limit)
+{
+        posix_hpath_t *hpath = NULL;
+
+        while (cache->count > limit) {
+                hpath = list_entry (cache->lru.prev, posix_hpath_t, lru);
+                __posix_hpath_del (cache, hpath);
+                cache->evictions++;
+        }
+}
+
+
+void
+posix_hpath_cache_set_limit (xlator_t *this, uint32_t limit)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->hpath_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->limit = limit;
+                __posix_hpath_cache_shrink (cache, limit);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+static posix_hpath_t *
+__posix_hpath_find (posix_hpath_cache_t *cache, uuid_t gfid)
+{
+        posix_hpath_t *hpath = NULL;
+
+        list_for_each_entry (hpath, &cache->buckets[posix_hpath_hash (gfid)],
+                             hash) {
+                if (gf_uuid_compare (hpath->gfid, gfid) == 0)
+                        return hpath;
+        }
+
+        return NULL;
+}
+
+
+/* copies the path of directory @gfid to @buf, returns its length or -1 */
+static int
+posix_hpath_cache_get (posix_hpath_cache_t *cache, uuid_t gfid, char *buf,
+                       int maxlen, uint64_t *gen)
+{
+        posix_hpath_t *hpath = NULL;
+        int            len   = -1;
+
+        LOCK (&cache->lock);
+        {
+                *gen = cache->gen;
+
+                if (!cache->limit)
+                        goto unlock;
+
+                hpath = __posix_hpath_find (cache, gfid);
+                if (!hpath)
+                        goto unlock;
+
+                if (hpath->len >= maxlen)
+                        goto unlock;
+
+                memcpy (buf, hpath->path, hpath->len + 1);
+                len = hpath->len;
+                list_move (&hpath->lru, &cache->lru);
+                cache->hits++;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        return len;
+}
+
+
+static void
+posix_hpath_cache_add (posix_hpath_cache_t *cache, uuid_t gfid,
+                       const char *path, int len, uint64_t gen)
+{
+        posix_hpath_t *hpath = NULL;
+
+        hpath = GF_MALLOC (sizeof (*hpath) + len + 1, gf_posix_mt_hpath_t);
+        if (!hpath)
+                return;
+
+        gf_uuid_copy (hpath->gfid, gfid);
+        memcpy (hpath->path, path, len);
+        hpath->path[len] = '\0';
+        hpath->len = len;
+
+        LOCK (&cache->lock);
+        {
+                if ((cache->gen != gen) || !cache->limit ||
+                    __posix_hpath_find (cache, gfid))
+                        goto unlock;
+
+                list_add (&hpath->hash,
+                          &cache->buckets[posix_hpath_hash (gfid)]);
+                list_add (&hpath->lru, &cache->lru);
+                cache->count++;
+                __posix_hpath_cache_shrink (cache, cache->limit);
+                hpath = NULL;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        GF_FREE (hpath);
+}
+
+
+void
+posix_hpath_cache_forget (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+        posix_hpath_t        *hpath = NULL;
+
+        priv = this->private;
+        cache = priv->hpath_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->gen++;
+                hpath = __posix_hpath_find (cache, gfid);
+                if (hpath)
+                        __posix_hpath_del (cache, hpath);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+void
+posix_hpath_cache_purge (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->hpath_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->gen++;
+                __posix_hpath_cache_shrink (cache, 0);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+void
+posix_hpath_cache_destroy (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->hpath_cache;
+        if (!cache)
+                return;
+
+        priv->hpath_cache = NULL;
+        __posix_hpath_cache_shrink (cache, 0);
+        LOCK_DESTROY (&cache->lock);
+        GF_FREE (cache);
+}
+
+
+void
+posix_hpath_cache_dump (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        posix_hpath_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->hpath_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                gf_proc_dump_write ("dir_handle_cache_entries", "%u",
+                                    cache->count);
+                gf_proc_dump_write ("dir_handle_cache_limit", "%u",
+                                    cache->limit);
+                gf_proc_dump_write ("dir_handle_cache_hits", "%"PRIu64,
+                                    cache->hits);
+                gf_proc_dump_write ("dir_handle_cache_misses", "%"PRIu64,
+                                    cache->misses);
+                gf_proc_dump_write ("dir_handle_cache_evictions", "%"PRIu64,
+                                    cache->evictions);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+/* Real path of directory @gfid, from the cache or by following the handle
+ * symlinks up to the nearest cached ancestor. Returns its length or -1.
+ */
+static int
+posix_hpath_resolve (xlator_t *this, uuid_t gfid, char *buf, int maxlen,
+                     int depth)
+{
+        struct posix_private *priv          = NULL;
+        char                 *base_str      = NULL;
+        char                  linkname[512] = {0,};
+        uuid_t                pgfid         = {0,};
+        char                  pgfid_str[UUID_CANONICAL_FORM_LEN + 1];
+        uint64_t              gen           = 0;
+        int                   len           = 0;
+        int                   nlen          = 0;
+        int                   ret           = 0;
+
+        priv = this->private;
+
+        if (__is_root_gfid (gfid)) {
+                if (priv->base_path_length >= maxlen)
+                        return -1;
+                strcpy (buf, priv->base_path);
+                return priv->base_path_length;
+        }
+
+        len = posix_hpath_cache_get (priv->hpath_cache, gfid, buf, maxlen,
+                                     &gen);
+        if (len >= 0)
+                return len;
+
+        /* a chain this long would ELOOP anyway */
+        if (depth > 256)
+                return -1;
+
+        MAKE_HANDLE_ABSPATH (base_str, this, gfid);
+
+        ret = sys_readlink (base_str, linkname, sizeof (linkname) - 1);
+        if (ret == -1)
+                return -1;
+        linkname[ret] = '\0';
+
+        LOCK (&priv->hpath_cache->lock);
+        {
+                priv->hpath_cache->misses++;
+        }
+        UNLOCK (&priv->hpath_cache->lock);
+
+        if ((ret == 8) && (memcmp (linkname, "../../..", 8) == 0))
+                return posix_hpath_resolve (this, (uuid_t) {0, 0, 0, 0, 0, 0,
+                                            0, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+                                            buf, maxlen, depth + 1);
+
+        if (posix_is_malformed_link (this, base_str, linkname, ret))
+                return -1;
+
+        memcpy (pgfid_str, linkname + 12, UUID_CANONICAL_FORM_LEN);
+        pgfid_str[UUID_CANONICAL_FORM_LEN] = '\0';
+        if (gf_uuid_parse (pgfid_str, pgfid))
+                return -1;
+
+        len = posix_hpath_resolve (this, pgfid, buf, maxlen, depth + 1);
+        if (len < 0)
+                return -1;
+
+        nlen = ret - 49;
+        if (len + 1 + nlen >= maxlen)
+                return -1;
+
+        buf[len] = '/';
+        memcpy (buf + len + 1, linkname + 49, nlen + 1);
+        len += 1 + nlen;
+
+        posix_hpath_cache_add (priv->hpath_cache, gfid, buf, len, gen);
+
+        return len;
+}
+
+
+/* Fills @buf with the real path of directory @gfid followed by @basename.
+ * Without @resolve only the cache is looked at. Returns the length or -1.
+ */
+static int
+posix_handle_path_cached (xlator_t *this, uuid_t gfid, const char *basename,
+                          char *buf, int maxlen, gf_boolean_t resolve)
+{
+        struct posix_private *priv = NULL;
+        uint64_t              gen  = 0;
+        int                   len  = 0;
+        int                   blen = 0;
+
+        priv = this->private;
+
+        if (resolve || __is_root_gfid (gfid))
+                len = posix_hpath_resolve (this, gfid, buf, maxlen, 0);
+        else
+                len = posix_hpath_cache_get (priv->hpath_cache, gfid, buf,
+                                             maxlen, &gen);
+        if (len < 0)
+                return -1;
+
+        if (!basename)
+                return len;
+
+        blen = strlen (basename);
+        if (len + 1 + blen >= maxlen)
+                return -1;
+
+        buf[len] = '/';
+        memcpy (buf + len + 1, basename, blen + 1);
+
+        return len + 1 + blen;
+}
+
+
 /*
   posix_handle_path differs from posix_handle_gfid_path in the way that the
   path filled in @buf by posix_handle_path will return type IA_IFDIR when
@@ -396,6 +760,13 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
 
         pfx_len = priv->base_path_length + 1 + SLEN(GF_HIDDEN_PATH) + 1;
 
+        if (priv->hpath_cache && priv->hpath_cache->limit) {
+                len = posix_handle_path_cached (this, gfid, basename, buf,
+                                                maxlen, _gf_false);
+                if (len >= 0)
+                        goto out;
+        }
+
         if (basename) {
                 len = snprintf (buf, maxlen, "%s/%s", base_str, basename);
         } else {
@@ -407,6 +778,22 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
         if (!(ret == 0 && S_ISLNK(stat.st_mode) && stat.st_nlink == 1))
                 goto out;
 
+        /* a directory, the handle symlinks have to be followed */
+        if (priv->hpath_cache && priv->hpath_cache->limit) {
+                ret = posix_handle_path_cached (this, gfid, basename, buf,
+                                                maxlen, _gf_true);
+                if (ret >= 0) {
+                        len = ret;
+                        goto out;
+                }
+                /* fall back to the snprintf'd handle path */
+                if (basename)
+                        len = snprintf (buf, maxlen, "%s/%s", base_str,
+                                        basename);
+                else
+                        len = snprintf (buf, maxlen, "%s", base_str);
+        }
+
         do {
                 errno = 0;
                 ret = posix_handle_pump (this, buf, len, maxlen,
@@ -883,6 +1270,9 @@ posix_handle_unset_gfid (xlator_t *this, uuid_t gfid)
                 goto out;
         }
 
+        if (S_ISLNK (stat.st_mode))
+                posix_hpath_cache_forget (this, gfid);
+
         ret = sys_unlink (path);
         if (ret == -1) {
                 gf_msg (this->name, GF_LOG_WARNING, errno,
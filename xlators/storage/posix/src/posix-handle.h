@@ -23,6 +23,8 @@
 
 #define TRASH_DIR "landfill"
 
+#define POSIX_HPATH_BUCKETS 1024
+
 #define UUID0_STR "00000000-0000-0000-0000-000000000000"
 #define SLEN(str) (sizeof(str) - 1)
 
@@ -242,6 +244,32 @@
         } while (0)
 
 
+/* Real paths of directories, by gfid. Saves walking the chain of handle
+ * symlinks up to the root on every fop on a directory handle. A directory
+ * rename changes the path of everything below it, it drops all entries.
+ */
+typedef struct posix_hpath {
+        struct list_head  hash;
+        struct list_head  lru;
+        uuid_t            gfid;
+        int               len;
+        char              path[];
+} posix_hpath_t;
+
+typedef struct posix_hpath_cache {
+        gf_lock_t         lock;
+        struct list_head  buckets[POSIX_HPATH_BUCKETS];
+        struct list_head  lru;
+        uint32_t          count;
+        uint32_t          limit;
+        /* bumped by every purge, resolutions started before it are
+         * not cached */
+        uint64_t          gen;
+        uint64_t          hits;
+        uint64_t          misses;
+        uint64_t          evictions;
+} posix_hpath_cache_t;
+
 #define POSIX_ANCESTRY_PATH (1 << 0)
 #define POSIX_ANCESTRY_DENTRY (1 << 1)
 
@@ -285,4 +313,22 @@ int posix_create_link_if_gfid_exists (xlator_t *this, uuid_t gfid,
 
 int
 posix_handle_trash_init (xlator_t *this);
+
+int
+posix_hpath_cache_init (xlator_t *this, uint32_t limit);
+
+void
+posix_hpath_cache_set_limit (xlator_t *this, uint32_t limit);
+
+void
+posix_hpath_cache_forget (xlator_t *this, uuid_t gfid);
+
+void
+posix_hpath_cache_purge (xlator_t *this);
+
+void
+posix_hpath_cache_destroy (xlator_t *this);
+
+void
+posix_hpath_cache_dump (xlator_t *this);
 #endif /* !_POSIX_HANDLE_H */
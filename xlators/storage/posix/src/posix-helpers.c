@@ -132,6 +132,20 @@ posix_is_valid_namespace (char *key)
         return _gf_false;
 }
 
+static gf_boolean_t
+_posix_xattr_listed (posix_xattr_filler_t *filler, const char *key)
+{
+        ssize_t  offset = 0;
+
+        while (offset < filler->xattr_list_size) {
+                if (strcmp (filler->xattr_list + offset, key) == 0)
+                        return _gf_true;
+                offset += strlen (filler->xattr_list + offset) + 1;
+        }
+
+        return _gf_false;
+}
+
 static int
 _posix_xattr_get_set_from_backend (posix_xattr_filler_t *filler, char *key)
 {
@@ -146,6 +160,22 @@ _posix_xattr_get_set_from_backend (posix_xattr_filler_t *filler, char *key)
                 goto out;
         }
 
+        if (filler->xctx) {
+                ret = posix_xattr_cache_get (filler->this, filler->xctx, key,
+                                             filler->xattr);
+                if (ret >= 0) {
+                        ret = (ret == 1) ? 0 : -1;
+                        goto out;
+                }
+                ret = 0;
+        }
+
+        /* saves a getxattr failing with ENODATA */
+        if (filler->xattr_list && !_posix_xattr_listed (filler, key)) {
+                ret = -1;
+                goto out;
+        }
+
         /* Most of the gluster internal xattrs don't exceed 256 bytes. So try
          * getxattr with ~256 bytes. If it gives ERANGE then go the old way
          * of getxattr with NULL buf to find the length and then getxattr with
@@ -759,6 +789,7 @@ posix_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
         dict_t     *xattr             = NULL;
         posix_xattr_filler_t filler   = {0, };
         gf_boolean_t    list          = _gf_false;
+        char        xattr_list[4096];
 
         if (dict_get (xattr_req, "list-xattr")) {
                 dict_del (xattr_req, "list-xattr");
@@ -777,6 +808,36 @@ posix_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
         filler.loc       = loc;
         filler.fd        = fd;
         filler.fdnum    = fdnum;
+        filler.xattr_list_size = -1;
+
+        filler.xctx = posix_xattr_ctx_get (this, _get_filler_inode (&filler));
+        if (filler.xctx) {
+                if (posix_xattr_cache_fill (this, filler.xctx, real_path,
+                                            fdnum) == 0)
+                        filler.xattr_list_size =
+                                posix_xattr_cache_list (this, filler.xctx,
+                                                        xattr_list,
+                                                        sizeof (xattr_list));
+                else
+                        filler.xctx = NULL;
+        }
+
+        /* Most of the keys asked for (acls, selinux, samba and swift
+         * metadata, ...) are usually not set. When several are requested,
+         * one listxattr tells which are worth a getxattr.
+         */
+        if ((filler.xattr_list_size < 0) && (xattr_req->count > 1)) {
+                if (real_path)
+                        filler.xattr_list_size =
+                                sys_llistxattr (real_path, xattr_list,
+                                                sizeof (xattr_list));
+                else if (fdnum >= 0)
+                        filler.xattr_list_size =
+                                sys_flistxattr (fdnum, xattr_list,
+                                                sizeof (xattr_list));
+        }
+        if (filler.xattr_list_size >= 0)
+                filler.xattr_list = xattr_list;
 
         dict_foreach (xattr_req, _posix_xattr_get_set, &filler);
         if (list)
@@ -813,6 +874,7 @@ posix_gfid_set (xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req)
         int          ret = 0;
         ssize_t      size = 0;
         struct stat  stat = {0, };
+        inode_t     *inode = NULL;
 
 
         if (!xattr_req)
@@ -843,6 +905,16 @@ posix_gfid_set (xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req)
         }
         gf_uuid_copy (uuid_curr, uuid_req);
 
+        /* a file recreated with the gfid of a removed one */
+        if (loc->inode) {
+                posix_xattr_cache_invalidate (this, loc->inode);
+                inode = inode_find (loc->inode->table, uuid_curr);
+                if (inode) {
+                        posix_xattr_cache_invalidate (this, inode);
+                        inode_unref (inode);
+                }
+        }
+
 verify_handle:
         if (!S_ISDIR (stat.st_mode))
                 ret = posix_handle_hard (this, path, uuid_curr, &stat);
@@ -1900,6 +1972,123 @@ unlock:
         UNLOCK (&priv->lock);
 }
 
+static void *
+posix_readdirp_thread_proc (void *data)
+{
+        xlator_t             *this  = NULL;
+        struct posix_private *priv  = NULL;
+        posix_rdp_batch_t    *batch = NULL;
+        struct posix_rdp_sync *sync = NULL;
+
+        this = data;
+        priv = this->private;
+
+        THIS = this;
+
+        for (;;) {
+                pthread_mutex_lock (&priv->rdp_mutex);
+                {
+                        while (list_empty (&priv->rdp_batches) &&
+                               !priv->rdp_stop)
+                                pthread_cond_wait (&priv->rdp_cond,
+                                                   &priv->rdp_mutex);
+
+                        if (priv->rdp_stop) {
+                                pthread_mutex_unlock (&priv->rdp_mutex);
+                                break;
+                        }
+
+                        batch = list_entry (priv->rdp_batches.next,
+                                            posix_rdp_batch_t, list);
+                        list_del_init (&batch->list);
+                }
+                pthread_mutex_unlock (&priv->rdp_mutex);
+
+                /* the batch belongs to the readdirp waiting on its sync */
+                sync = batch->sync;
+                posix_readdirp_fill_batch (batch);
+
+                pthread_mutex_lock (&sync->mutex);
+                {
+                        if (--sync->pending == 0)
+                                pthread_cond_signal (&sync->cond);
+                }
+                pthread_mutex_unlock (&sync->mutex);
+        }
+
+        return NULL;
+}
+
+
+/* Batches still queued when the threads stop are filled by the readdirp
+ * they belong to, see posix_readdirp_fill ().
+ */
+void
+posix_stop_readdirp_threads (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        uint32_t              i    = 0;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->rdp_mutex);
+        {
+                priv->rdp_stop = _gf_true;
+                pthread_cond_broadcast (&priv->rdp_cond);
+        }
+        pthread_mutex_unlock (&priv->rdp_mutex);
+
+        for (i = 0; i < priv->rdp_thread_count; i++)
+                pthread_join (priv->rdp_threads[i], NULL);
+
+        pthread_mutex_lock (&priv->rdp_mutex);
+        {
+                priv->rdp_thread_count = 0;
+                priv->rdp_stop = _gf_false;
+        }
+        pthread_mutex_unlock (&priv->rdp_mutex);
+}
+
+
+int
+posix_spawn_readdirp_threads (xlator_t *this, uint32_t count)
+{
+        struct posix_private *priv = NULL;
+        uint32_t              i    = 0;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        if (count == priv->rdp_thread_count)
+                return 0;
+
+        posix_stop_readdirp_threads (this);
+
+        if (count > POSIX_RDP_THREADS_MAX)
+                count = POSIX_RDP_THREADS_MAX;
+
+        for (i = 0; i < count; i++) {
+                ret = gf_thread_create (&priv->rdp_threads[i], NULL,
+                                        posix_readdirp_thread_proc, this);
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_ERROR, errno,
+                                P_MSG_READDIRP_THREAD_FAILED,
+                                "failed to start readdirp thread %u, "
+                                "running with %u", i, i);
+                        break;
+                }
+        }
+
+        pthread_mutex_lock (&priv->rdp_mutex);
+        {
+                priv->rdp_thread_count = i;
+        }
+        pthread_mutex_unlock (&priv->rdp_mutex);
+
+        return ret;
+}
+
+
 int
 posix_fsyncer_pick (xlator_t *this, struct list_head *head)
 {
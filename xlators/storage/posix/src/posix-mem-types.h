@@ -22,6 +22,9 @@ enum gf_posix_mem_types_ {
         gf_posix_mt_trash_path,
 	gf_posix_mt_paiocb,
         gf_posix_mt_inode_ctx_t,
+        gf_posix_mt_rdp_batch_t,
+        gf_posix_mt_hpath_t,
+        gf_posix_mt_xattr_cache_t,
         gf_posix_mt_end
 };
 #endif
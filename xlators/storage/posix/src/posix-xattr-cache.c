@@ -0,0 +1,724 @@
+/*
+  Copyright (c) 2016 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <errno.h>
+#include <sys/types.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "statedump.h"
+#include "syscall.h"
+#include "posix.h"
+#include "posix-messages.h"
+
+/*
+ * Write-through cache of the xattrs of the inodes of the brick. An inode
+ * is filled with one listxattr and a getxattr of each of its "trusted."
+ * xattrs the first time they are asked for. setxattr and removexattr drop
+ * what is cached for the inode, as do the xattrs this xlator writes itself
+ * on lookup and entry creation. xattrop writes the new values through.
+ * Filled inodes are kept in a brick wide LRU, bounded by the
+ * "xattr-cache-size" option.
+ */
+
+#define POSIX_XATTR_CACHED_NS   "trusted."
+
+static gf_boolean_t
+posix_xattr_cacheable (const char *key)
+{
+        return (strncmp (key, POSIX_XATTR_CACHED_NS,
+                         SLEN (POSIX_XATTR_CACHED_NS)) == 0);
+}
+
+
+static posix_xattr_val_t *
+posix_xattr_val_new (const char *key, const void *value, int32_t len)
+{
+        posix_xattr_val_t *val  = NULL;
+        size_t             klen = 0;
+
+        klen = strlen (key) + 1;
+
+        val = GF_MALLOC (sizeof (*val) + len + klen,
+                         gf_posix_mt_xattr_cache_t);
+        if (!val)
+                return NULL;
+
+        INIT_LIST_HEAD (&val->list);
+        val->len = len;
+        memcpy (val->value, value, len);
+        val->key = val->value + len;
+        memcpy (val->key, key, klen);
+
+        return val;
+}
+
+
+static size_t
+posix_xattr_val_size (posix_xattr_val_t *val)
+{
+        return sizeof (*val) + val->len + strlen (val->key) + 1;
+}
+
+
+static posix_xattr_val_t *
+__posix_xattr_val_find (posix_xattr_ctx_t *xctx, const char *key)
+{
+        posix_xattr_val_t *val = NULL;
+
+        list_for_each_entry (val, &xctx->values, list) {
+                if (strcmp (val->key, key) == 0)
+                        return val;
+        }
+
+        return NULL;
+}
+
+
+static gf_boolean_t
+__posix_xattr_name_listed (posix_xattr_ctx_t *xctx, const char *key)
+{
+        ssize_t  offset = 0;
+
+        while (offset < xctx->names_size) {
+                if (strcmp (xctx->names + offset, key) == 0)
+                        return _gf_true;
+                offset += strlen (xctx->names + offset) + 1;
+        }
+
+        return _gf_false;
+}
+
+
+static void
+__posix_xattr_ctx_empty (posix_xattr_cache_t *cache, posix_xattr_ctx_t *xctx)
+{
+        posix_xattr_val_t *val = NULL;
+        posix_xattr_val_t *tmp = NULL;
+
+        list_for_each_entry_safe (val, tmp, &xctx->values, list) {
+                list_del (&val->list);
+                GF_FREE (val);
+        }
+
+        GF_FREE (xctx->names);
+        xctx->names = NULL;
+        xctx->names_size = 0;
+
+        if (cache)
+                cache->size -= xctx->size;
+        xctx->size = 0;
+        xctx->valid = _gf_false;
+
+        list_del_init (&xctx->lru);
+}
+
+
+static void
+__posix_xattr_cache_shrink (posix_xattr_cache_t *cache, uint64_t limit)
+{
+        posix_xattr_ctx_t *xctx = NULL;
+
+        while ((cache->size > limit) && !list_empty (&cache->lru)) {
+                xctx = list_entry (cache->lru.prev, posix_xattr_ctx_t, lru);
+                __posix_xattr_ctx_empty (cache, xctx);
+                cache->evictions++;
+        }
+}
+
+
+int
+posix_xattr_cache_init (xlator_t *this, uint64_t limit)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+
+        priv = this->private;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_xattr_cache_t);
+        if (!cache)
+                return -1;
+
+        LOCK_INIT (&cache->lock);
+        INIT_LIST_HEAD (&cache->lru);
+        cache->limit = limit;
+
+        priv->xattr_cache = cache;
+
+        return 0;
+}
+
+
+void
+posix_xattr_cache_set_limit (xlator_t *this, uint64_t limit)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->limit = limit;
+                __posix_xattr_cache_shrink (cache, limit);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+void
+posix_xattr_cache_destroy (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+        if (!cache)
+                return;
+
+        /* the ctxs themselves go away with the inodes */
+        priv->xattr_cache = NULL;
+        __posix_xattr_cache_shrink (cache, 0);
+        LOCK_DESTROY (&cache->lock);
+        GF_FREE (cache);
+}
+
+
+void
+posix_xattr_cache_dump (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                gf_proc_dump_write ("xattr_cache_size", "%"PRIu64,
+                                    cache->size);
+                gf_proc_dump_write ("xattr_cache_limit", "%"PRIu64,
+                                    cache->limit);
+                gf_proc_dump_write ("xattr_cache_hits", "%"PRIu64,
+                                    cache->hits);
+                gf_proc_dump_write ("xattr_cache_misses", "%"PRIu64,
+                                    cache->misses);
+                gf_proc_dump_write ("xattr_cache_evictions", "%"PRIu64,
+                                    cache->evictions);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+/* returns the xattr ctx of @inode, allocating it if needed. NULL when the
+ * cache is disabled. Must not be called with the inode locked.
+ */
+posix_xattr_ctx_t *
+posix_xattr_ctx_get (xlator_t *this, inode_t *inode)
+{
+        struct posix_private *priv = NULL;
+        posix_xattr_ctx_t    *xctx = NULL;
+        uint64_t              tmp  = 0;
+
+        priv = this->private;
+
+        if (!inode || !priv->xattr_cache || !priv->xattr_cache->limit)
+                return NULL;
+
+        LOCK (&inode->lock);
+        {
+                if ((__inode_ctx_get1 (inode, this, &tmp) == 0) && tmp) {
+                        xctx = (posix_xattr_ctx_t *)(uintptr_t) tmp;
+                        goto unlock;
+                }
+
+                xctx = GF_CALLOC (1, sizeof (*xctx),
+                                  gf_posix_mt_xattr_cache_t);
+                if (!xctx)
+                        goto unlock;
+
+                INIT_LIST_HEAD (&xctx->lru);
+                INIT_LIST_HEAD (&xctx->values);
+
+                tmp = (uint64_t)(uintptr_t) xctx;
+                if (__inode_ctx_set1 (inode, this, &tmp)) {
+                        GF_FREE (xctx);
+                        xctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return xctx;
+}
+
+
+void
+posix_xattr_ctx_release (xlator_t *this, uint64_t ctx)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+        posix_xattr_ctx_t    *xctx  = NULL;
+
+        priv = this->private;
+        cache = priv ? priv->xattr_cache : NULL;
+        xctx = (posix_xattr_ctx_t *)(uintptr_t) ctx;
+        if (!xctx)
+                return;
+
+        if (cache) {
+                LOCK (&cache->lock);
+                {
+                        __posix_xattr_ctx_empty (cache, xctx);
+                }
+                UNLOCK (&cache->lock);
+        } else {
+                __posix_xattr_ctx_empty (NULL, xctx);
+        }
+
+        GF_FREE (xctx);
+}
+
+
+void
+posix_xattr_ctx_invalidate (xlator_t *this, posix_xattr_ctx_t *xctx)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                xctx->gen++;
+                __posix_xattr_ctx_empty (cache, xctx);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+void
+posix_xattr_cache_invalidate (xlator_t *this, inode_t *inode)
+{
+        uint64_t  tmp = 0;
+
+        if (!inode)
+                return;
+
+        if (inode_ctx_get1 (inode, this, &tmp) || !tmp)
+                return;
+
+        posix_xattr_ctx_invalidate (this, (posix_xattr_ctx_t *)(uintptr_t) tmp);
+}
+
+
+/* the xattrs of the file @loc was created as were written, drops them from
+ * its inode and from the one of the gfid it asked for, which may be an
+ * existing file it was linked to
+ */
+void
+posix_xattr_cache_invalidate_entry (xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+        void     *uuid_req = NULL;
+        inode_t  *inode    = NULL;
+
+        if (!loc->inode)
+                return;
+
+        posix_xattr_cache_invalidate (this, loc->inode);
+
+        if (!xdata || dict_get_ptr (xdata, "gfid-req", &uuid_req) ||
+            !uuid_req || gf_uuid_is_null (uuid_req))
+                return;
+
+        inode = inode_find (loc->inode->table, uuid_req);
+        if (inode) {
+                posix_xattr_cache_invalidate (this, inode);
+                inode_unref (inode);
+        }
+}
+
+
+static ssize_t
+posix_xattr_backend_get (const char *real_path, int fdnum, const char *key,
+                         char **value_p)
+{
+        char     buf[256];
+        char    *value = NULL;
+        ssize_t  size  = 0;
+
+        if (real_path)
+                size = sys_lgetxattr (real_path, key, buf, sizeof (buf));
+        else
+                size = sys_fgetxattr (fdnum, key, buf, sizeof (buf));
+
+        if (size >= 0) {
+                value = GF_MALLOC (size + 1, gf_posix_mt_char);
+                if (!value)
+                        return -1;
+                memcpy (value, buf, size);
+                goto out;
+        }
+
+        if (errno != ERANGE)
+                return -1;
+
+        if (real_path)
+                size = sys_lgetxattr (real_path, key, NULL, 0);
+        else
+                size = sys_fgetxattr (fdnum, key, NULL, 0);
+        if (size < 0)
+                return -1;
+
+        value = GF_MALLOC (size + 1, gf_posix_mt_char);
+        if (!value)
+                return -1;
+
+        if (real_path)
+                size = sys_lgetxattr (real_path, key, value, size);
+        else
+                size = sys_fgetxattr (fdnum, key, value, size);
+        if (size < 0) {
+                GF_FREE (value);
+                return -1;
+        }
+out:
+        *value_p = value;
+        return size;
+}
+
+
+/* makes sure the xattrs of the inode are cached, returns 0 when they are */
+int
+posix_xattr_cache_fill (xlator_t *this, posix_xattr_ctx_t *xctx,
+                        const char *real_path, int fdnum)
+{
+        struct posix_private *priv       = NULL;
+        posix_xattr_cache_t  *cache      = NULL;
+        posix_xattr_val_t    *val        = NULL;
+        posix_xattr_val_t    *tmp        = NULL;
+        struct list_head      values;
+        char                 *names      = NULL;
+        char                 *value      = NULL;
+        ssize_t               names_size = 0;
+        ssize_t               size       = 0;
+        ssize_t               offset     = 0;
+        size_t                total      = 0;
+        uint64_t              gen        = 0;
+        int                   ret        = -1;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+
+        if (!xctx || (!real_path && fdnum < 0))
+                return -1;
+
+        INIT_LIST_HEAD (&values);
+
+        LOCK (&cache->lock);
+        {
+                if (xctx->valid) {
+                        list_move (&xctx->lru, &cache->lru);
+                        ret = 0;
+                }
+                gen = xctx->gen;
+        }
+        UNLOCK (&cache->lock);
+
+        if (ret == 0)
+                return 0;
+
+        if (real_path)
+                names_size = sys_llistxattr (real_path, NULL, 0);
+        else
+                names_size = sys_flistxattr (fdnum, NULL, 0);
+        if (names_size < 0)
+                goto out;
+
+        names = GF_MALLOC (names_size + 1, gf_posix_mt_char);
+        if (!names)
+                goto out;
+
+        if (names_size) {
+                if (real_path)
+                        names_size = sys_llistxattr (real_path, names,
+                                                     names_size);
+                else
+                        names_size = sys_flistxattr (fdnum, names,
+                                                     names_size);
+                /* grown in between, not worth retrying */
+                if (names_size < 0)
+                        goto out;
+        }
+        total = names_size;
+
+        for (offset = 0; offset < names_size;
+             offset += strlen (names + offset) + 1) {
+                if (!posix_xattr_cacheable (names + offset))
+                        continue;
+
+                size = posix_xattr_backend_get (real_path, fdnum,
+                                                names + offset, &value);
+                if (size < 0)
+                        goto out;
+
+                val = posix_xattr_val_new (names + offset, value, size);
+                GF_FREE (value);
+                if (!val)
+                        goto out;
+
+                list_add_tail (&val->list, &values);
+                total += posix_xattr_val_size (val);
+        }
+
+        total += sizeof (*xctx);
+
+        LOCK (&cache->lock);
+        {
+                cache->misses++;
+
+                if ((xctx->gen != gen) || xctx->valid ||
+                    (total > cache->limit))
+                        goto unlock;
+
+                list_splice_init (&values, &xctx->values);
+                xctx->names = names;
+                xctx->names_size = names_size;
+                xctx->size = total;
+                xctx->valid = _gf_true;
+                names = NULL;
+
+                cache->size += total;
+                list_add (&xctx->lru, &cache->lru);
+                __posix_xattr_cache_shrink (cache, cache->limit);
+
+                ret = 0;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+out:
+        list_for_each_entry_safe (val, tmp, &values, list) {
+                list_del (&val->list);
+                GF_FREE (val);
+        }
+        GF_FREE (names);
+
+        return ret;
+}
+
+
+/* copies the names of the xattrs of the inode to @list, -1 if they are not
+ * cached or do not fit
+ */
+ssize_t
+posix_xattr_cache_list (xlator_t *this, posix_xattr_ctx_t *xctx, char *list,
+                        size_t size)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+        ssize_t               ret   = -1;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+
+        LOCK (&cache->lock);
+        {
+                if (!xctx->valid || (xctx->names_size > size))
+                        goto unlock;
+
+                memcpy (list, xctx->names, xctx->names_size);
+                ret = xctx->names_size;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        return ret;
+}
+
+
+/* 1 if @key was found and set in @dict, 0 if the inode does not have it,
+ * -1 if the cache cannot tell
+ */
+int
+posix_xattr_cache_get (xlator_t *this, posix_xattr_ctx_t *xctx,
+                       const char *key, dict_t *dict)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+        posix_xattr_val_t    *val   = NULL;
+        char                 *value = NULL;
+        int32_t               len   = 0;
+        int                   ret   = -1;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+
+        if (!posix_xattr_cacheable (key))
+                return -1;
+
+        LOCK (&cache->lock);
+        {
+                if (!xctx->valid)
+                        goto unlock;
+
+                val = __posix_xattr_val_find (xctx, key);
+                if (!val) {
+                        ret = 0;
+                        goto unlock;
+                }
+
+                cache->hits++;
+
+                len = val->len;
+                value = GF_MALLOC (len + 1, gf_posix_mt_char);
+                if (!value)
+                        goto unlock;
+
+                memcpy (value, val->value, len);
+                value[len] = '\0';
+                ret = 1;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        if ((ret == 1) && dict_set_bin (dict, (char *)key, value, len)) {
+                GF_FREE (value);
+                ret = -1;
+        }
+
+        return ret;
+}
+
+
+/* getxattr(2) from the cache: the size of the value, or -1 with errno set.
+ * errno is EAGAIN when the cache cannot tell.
+ */
+ssize_t
+posix_xattr_cache_read (xlator_t *this, posix_xattr_ctx_t *xctx,
+                        const char *key, void *value, size_t size)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+        posix_xattr_val_t    *val   = NULL;
+        ssize_t               ret   = -1;
+        int                   err   = EAGAIN;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+
+        if (!posix_xattr_cacheable (key))
+                goto out;
+
+        LOCK (&cache->lock);
+        {
+                if (!xctx->valid)
+                        goto unlock;
+
+                val = __posix_xattr_val_find (xctx, key);
+                if (!val) {
+                        err = ENODATA;
+                        goto unlock;
+                }
+
+                cache->hits++;
+
+                if (val->len > size) {
+                        err = ERANGE;
+                        goto unlock;
+                }
+
+                memcpy (value, val->value, val->len);
+                ret = val->len;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+out:
+        if (ret < 0)
+                errno = err;
+
+        return ret;
+}
+
+
+/* @key of the inode was just set to @value */
+void
+posix_xattr_cache_update (xlator_t *this, posix_xattr_ctx_t *xctx,
+                          const char *key, const void *value, int32_t len)
+{
+        struct posix_private *priv  = NULL;
+        posix_xattr_cache_t  *cache = NULL;
+        posix_xattr_val_t    *val   = NULL;
+        posix_xattr_val_t    *old   = NULL;
+        char                 *names = NULL;
+        size_t                klen  = 0;
+
+        priv = this->private;
+        cache = priv->xattr_cache;
+
+        if (posix_xattr_cacheable (key))
+                val = posix_xattr_val_new (key, value, len);
+
+        LOCK (&cache->lock);
+        {
+                xctx->gen++;
+
+                if (!xctx->valid)
+                        goto unlock;
+
+                if (posix_xattr_cacheable (key) && !val) {
+                        __posix_xattr_ctx_empty (cache, xctx);
+                        goto unlock;
+                }
+
+                old = __posix_xattr_val_find (xctx, key);
+                if (old) {
+                        list_del (&old->list);
+                        xctx->size -= posix_xattr_val_size (old);
+                        cache->size -= posix_xattr_val_size (old);
+                        GF_FREE (old);
+                } else if (!__posix_xattr_name_listed (xctx, key)) {
+                        klen = strlen (key) + 1;
+                        names = GF_REALLOC (xctx->names,
+                                            xctx->names_size + klen);
+                        if (!names) {
+                                __posix_xattr_ctx_empty (cache, xctx);
+                                goto unlock;
+                        }
+                        memcpy (names + xctx->names_size, key, klen);
+                        xctx->names = names;
+                        xctx->names_size += klen;
+                        xctx->size += klen;
+                        cache->size += klen;
+                }
+
+                if (val) {
+                        list_add_tail (&val->list, &xctx->values);
+                        xctx->size += posix_xattr_val_size (val);
+                        cache->size += posix_xattr_val_size (val);
+                        val = NULL;
+                }
+
+                list_move (&xctx->lru, &cache->lru);
+                __posix_xattr_cache_shrink (cache, cache->limit);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        GF_FREE (val);
+}
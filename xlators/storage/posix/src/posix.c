@@ -107,17 +107,20 @@ int
 posix_forget (xlator_t *this, inode_t *inode)
 {
         uint64_t tmp_cache = 0;
+        uint64_t tmp_xattr = 0;
         int ret = 0;
         char *unlink_path = NULL;
         struct posix_private    *priv_posix = NULL;
 
         priv_posix = (struct posix_private *) this->private;
 
-        ret = inode_ctx_del (inode, this, &tmp_cache);
+        ret = inode_ctx_del2 (inode, this, &tmp_cache, &tmp_xattr);
         if (ret < 0) {
                 ret = 0;
                 goto out;
         }
+        posix_xattr_ctx_release (this, tmp_xattr);
+
         if (tmp_cache == GF_UNLINK_TRUE) {
                 POSIX_GET_FILE_UNLINK_PATH(priv_posix->base_path,
                                            inode->gfid, unlink_path);
@@ -222,6 +225,10 @@ posix_lookup (call_frame_t *frame, xlator_t *this,
                         }
 unlock:
                         UNLOCK (&loc->inode->lock);
+
+                        /* the key was missing and just got set */
+                        if (op_ret == 0)
+                                posix_xattr_cache_invalidate (this, loc->inode);
                 }
         }
 
@@ -1359,6 +1366,8 @@ ignore:
                 }
         }
 
+        posix_xattr_cache_invalidate_entry (this, loc, xdata);
+
         op_ret = posix_pstat (this, NULL, real_path, &stbuf);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -1622,6 +1631,8 @@ posix_mkdir (call_frame_t *frame, xlator_t *this,
                 gfid_set = _gf_true;
         }
 
+        posix_xattr_cache_invalidate_entry (this, loc, xdata);
+
         op_ret = posix_pstat (this, NULL, real_path, &stbuf);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -2051,6 +2062,9 @@ posix_unlink (call_frame_t *frame, xlator_t *this,
         unwind_dict = posix_dict_set_nlink (xdata, unwind_dict, stbuf.ia_nlink);
         op_ret = 0;
 out:
+        if (loc)
+                posix_xattr_cache_invalidate (this, loc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (unlink, frame, op_ret, op_errno,
@@ -2177,6 +2191,9 @@ posix_rmdir (call_frame_t *frame, xlator_t *this,
         }
 
 out:
+        if (loc)
+                posix_xattr_cache_invalidate (this, loc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (rmdir, frame, op_ret, op_errno,
@@ -2286,6 +2303,8 @@ ignore:
                 gfid_set = _gf_true;
         }
 
+        posix_xattr_cache_invalidate_entry (this, loc, xdata);
+
         op_ret = posix_pstat (this, NULL, real_path, &stbuf);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -2433,8 +2452,11 @@ posix_rename (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
-        if (IA_ISDIR (oldloc->inode->ia_type))
+        /* every cached path below the directory changes */
+        if (IA_ISDIR (oldloc->inode->ia_type)) {
+                posix_hpath_cache_purge (this);
                 posix_handle_unset (this, oldloc->inode->gfid, NULL);
+        }
 
         LOCK (&oldloc->inode->lock);
         {
@@ -2493,6 +2515,9 @@ posix_rename (call_frame_t *frame, xlator_t *this,
                         goto unlock;
                 }
 
+                if (IA_ISDIR (oldloc->inode->ia_type))
+                        posix_hpath_cache_purge (this);
+
                 if (locked) {
                         UNLOCK (&newloc->inode->lock);
                         locked = _gf_false;
@@ -2573,6 +2598,11 @@ unlock:
                 unwind_dict = posix_dict_set_nlink (xdata, unwind_dict, nlink);
         op_ret = 0;
 out:
+        /* the pgfid xattrs of the inodes changed */
+        if (oldloc && newloc) {
+                posix_xattr_cache_invalidate (this, oldloc->inode);
+                posix_xattr_cache_invalidate (this, newloc->inode);
+        }
 
         SET_TO_OLD_FS_ID ();
 
@@ -2690,6 +2720,10 @@ posix_link (call_frame_t *frame, xlator_t *this,
         op_ret = 0;
 
 out:
+        /* the pgfid xattrs of the inode changed */
+        if (oldloc)
+                posix_xattr_cache_invalidate (this, oldloc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (link, frame, op_ret, op_errno,
@@ -2892,6 +2926,8 @@ fill_stat:
                 gfid_set = _gf_true;
         }
 
+        posix_xattr_cache_invalidate_entry (this, loc, xdata);
+
         op_ret = posix_fdstat (this, _fd, &stbuf);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -3855,6 +3891,9 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
                 }
         }
 out:
+        if (loc)
+                posix_xattr_cache_invalidate (this, loc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (setxattr, frame, op_ret, op_errno, xattr);
@@ -5014,6 +5053,9 @@ posix_fsetxattr (call_frame_t *frame, xlator_t *this,
         }
 
 out:
+        if (fd)
+                posix_xattr_cache_invalidate (this, fd->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (fsetxattr, frame, op_ret, op_errno, xattr);
@@ -5152,6 +5194,9 @@ posix_removexattr (call_frame_t *frame, xlator_t *this,
         op_ret = 0;
 
 out:
+        if (loc)
+                posix_xattr_cache_invalidate (this, loc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (removexattr, frame, op_ret, op_errno, xattr);
@@ -5223,6 +5268,9 @@ posix_fremovexattr (call_frame_t *frame, xlator_t *this,
         op_ret = 0;
 
 out:
+        if (fd)
+                posix_xattr_cache_invalidate (this, fd->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (fremovexattr, frame, op_ret, op_errno, xattr);
@@ -5433,12 +5481,19 @@ _posix_handle_xattr_keyvalue_pair (dict_t *d, char *k, data_t *v,
 
         LOCK (&inode->lock);
         {
-                if (filler->real_path) {
-                        size = sys_lgetxattr (filler->real_path, k,
-                                              (char *)array, count);
-                } else {
-                        size = sys_fgetxattr (filler->fdnum, k, (char *)array,
-                                              count);
+                size = -1;
+                errno = EAGAIN;
+                if (filler->xctx)
+                        size = posix_xattr_cache_read (this, filler->xctx, k,
+                                                       array, count);
+
+                if (size == -1 && errno == EAGAIN) {
+                        if (filler->real_path)
+                                size = sys_lgetxattr (filler->real_path, k,
+                                                      (char *)array, count);
+                        else
+                                size = sys_fgetxattr (filler->fdnum, k,
+                                                      (char *)array, count);
                 }
 
                 op_errno = errno;
@@ -5538,6 +5593,12 @@ _posix_handle_xattr_keyvalue_pair (dict_t *d, char *k, data_t *v,
                                               count, 0);
                 }
                 op_errno = errno;
+
+                if (size == 0 && filler->xctx)
+                        posix_xattr_cache_update (this, filler->xctx, k,
+                                                  dst_data, count);
+                else if (filler->xctx)
+                        posix_xattr_ctx_invalidate (this, filler->xctx);
         }
 unlock:
         UNLOCK (&inode->lock);
@@ -5657,6 +5718,7 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
         filler.flags = (int)optype;
         filler.inode = inode;
         filler.xattr = xdata;
+        filler.xctx = posix_xattr_ctx_get (this, inode);
 
         op_ret = dict_foreach (xattr, _posix_handle_xattr_keyvalue_pair,
                                &filler);
@@ -6158,79 +6220,247 @@ posix_d_type_from_ia_type (ia_type_t type)
 #endif
 
 
-int
-posix_readdirp_fill (xlator_t *this, fd_t *fd, gf_dirent_t *entries, dict_t *dict)
+static void
+posix_readdirp_fill_entry (xlator_t *this, fd_t *fd, gf_dirent_t *entry,
+                           dict_t *dict, char *hpath, int len)
 {
-        gf_dirent_t     *entry    = NULL;
         inode_table_t   *itable   = NULL;
 	inode_t         *inode    = NULL;
-	char            *hpath    = NULL;
-	int              len      = 0;
         struct iatt      stbuf    = {0, };
 	uuid_t           gfid;
         int              ret      = -1;
 
-	if (list_empty(&entries->list))
-		return 0;
-
         itable = fd->inode->table;
 
-	len = posix_handle_path (this, fd->inode->gfid, NULL, NULL, 0);
-        if (len <= 0)
-                return -1;
-	hpath = alloca (len + 256); /* NAME_MAX */
-	if (posix_handle_path (this, fd->inode->gfid, NULL, hpath, len) <= 0)
-                return -1;
-	len = strlen (hpath);
-	hpath[len] = '/';
+        memset (gfid, 0, 16);
+        inode = inode_grep (fd->inode->table, fd->inode,
+                            entry->d_name);
+        if (inode)
+                gf_uuid_copy (gfid, inode->gfid);
 
-        list_for_each_entry (entry, &entries->list, list) {
-		memset (gfid, 0, 16);
-		inode = inode_grep (fd->inode->table, fd->inode,
-				    entry->d_name);
-		if (inode)
-			gf_uuid_copy (gfid, inode->gfid);
+        strcpy (&hpath[len+1], entry->d_name);
+
+        ret = posix_pstat (this, gfid, hpath, &stbuf);
 
-		strcpy (&hpath[len+1], entry->d_name);
+        if (ret == -1) {
+                if (inode)
+                        inode_unref (inode);
+                return;
+        }
 
-                ret = posix_pstat (this, gfid, hpath, &stbuf);
+        if (!inode)
+                inode = inode_find (itable, stbuf.ia_gfid);
 
-                if (ret == -1) {
-                        if (inode)
-                                inode_unref (inode);
-                      continue;
-                }
+        if (!inode)
+                inode = inode_new (itable);
+
+        entry->inode = inode;
+
+        if (dict) {
+                entry->dict =
+                        posix_entry_xattr_fill (this, entry->inode,
+                                                fd, hpath,
+                                                dict, &stbuf);
+        }
+
+        entry->d_stat = stbuf;
+        if (stbuf.ia_ino)
+                entry->d_ino = stbuf.ia_ino;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+        if (entry->d_type == DT_UNKNOWN && !IA_ISINVAL(stbuf.ia_type)) {
+                /* The platform supports d_type but the underlying
+                   filesystem doesn't. We set d_type to the correct
+                   value from ia_type */
+                entry->d_type =
+                        posix_d_type_from_ia_type (stbuf.ia_type);
+        }
+#endif
+}
+
+
+void
+posix_readdirp_fill_batch (posix_rdp_batch_t *batch)
+{
+	char            *hpath    = NULL;
+        int              i        = 0;
+
+	hpath = alloca (batch->dir_len + 256); /* NAME_MAX */
+        memcpy (hpath, batch->dir_path, batch->dir_len + 1);
 
-		if (!inode)
-			inode = inode_find (itable, stbuf.ia_gfid);
+        for (i = 0; i < batch->count; i++)
+                posix_readdirp_fill_entry (batch->this, batch->fd,
+                                           batch->entries[i], batch->dict,
+                                           hpath, batch->dir_len);
+}
 
-		if (!inode)
-			inode = inode_new (itable);
 
-		entry->inode = inode;
+/* Below this many entries per batch the hand off costs more than it saves */
+#define POSIX_RDP_BATCH_MIN     32
 
-                if (dict) {
-                        entry->dict =
-                                posix_entry_xattr_fill (this, entry->inode,
-                                                        fd, hpath,
-                                                        dict, &stbuf);
+static int
+posix_readdirp_fill_parallel (xlator_t *this, fd_t *fd, gf_dirent_t *entries,
+                              int count, dict_t *dict, char *hpath, int len)
+{
+        struct posix_private  *priv    = NULL;
+        struct posix_rdp_sync  sync;
+        posix_rdp_batch_t     *batches = NULL;
+        posix_rdp_batch_t     *batch   = NULL;
+        posix_rdp_batch_t     *tmp     = NULL;
+        gf_dirent_t          **array   = NULL;
+        gf_dirent_t           *entry   = NULL;
+        struct list_head       mine;
+        int                    nbatch  = 0;
+        int                    i       = 0;
+        int                    j       = 0;
+
+        priv = this->private;
+
+        nbatch = count / POSIX_RDP_BATCH_MIN;
+        if (nbatch > (int) priv->rdp_thread_count + 1)
+                nbatch = priv->rdp_thread_count + 1;
+
+        batches = GF_CALLOC (nbatch, sizeof (*batches),
+                             gf_posix_mt_rdp_batch_t);
+        array = GF_CALLOC (count, sizeof (*array), gf_posix_mt_rdp_batch_t);
+        if (!batches || !array) {
+                GF_FREE (batches);
+                GF_FREE (array);
+                return -1;
+        }
+
+        list_for_each_entry (entry, &entries->list, list)
+                array[i++] = entry;
+
+        pthread_mutex_init (&sync.mutex, NULL);
+        pthread_cond_init (&sync.cond, NULL);
+        sync.pending = nbatch - 1;
+
+        hpath[len + 1] = '\0';
+        for (i = 0, j = 0; i < nbatch; i++) {
+                batch = &batches[i];
+                INIT_LIST_HEAD (&batch->list);
+                batch->this = this;
+                batch->fd = fd;
+                /* posix_xattr_fill() edits the request dict, every batch
+                 * handed to a thread gets a copy of its own */
+                if (dict && i > 0) {
+                        batch->dict = dict_copy_with_ref (dict, NULL);
+                        if (!batch->dict)
+                                goto err;
+                } else {
+                        batch->dict = dict;
                 }
+                batch->dir_path = hpath;
+                batch->dir_len = len;
+                batch->sync = &sync;
+                batch->entries = &array[j];
+                batch->count = (count - j) / (nbatch - i);
+                j += batch->count;
+        }
 
-                entry->d_stat = stbuf;
-                if (stbuf.ia_ino)
-                        entry->d_ino = stbuf.ia_ino;
+        pthread_mutex_lock (&priv->rdp_mutex);
+        {
+                for (i = 1; i < nbatch; i++)
+                        list_add_tail (&batches[i].list, &priv->rdp_batches);
+                pthread_cond_broadcast (&priv->rdp_cond);
+        }
+        pthread_mutex_unlock (&priv->rdp_mutex);
 
-#ifdef _DIRENT_HAVE_D_TYPE
-                if (entry->d_type == DT_UNKNOWN && !IA_ISINVAL(stbuf.ia_type)) {
-                        /* The platform supports d_type but the underlying
-                           filesystem doesn't. We set d_type to the correct
-                           value from ia_type */
-                        entry->d_type =
-                                posix_d_type_from_ia_type (stbuf.ia_type);
+        posix_readdirp_fill_batch (&batches[0]);
+
+        /* take back what the threads did not get to yet */
+        INIT_LIST_HEAD (&mine);
+        pthread_mutex_lock (&priv->rdp_mutex);
+        {
+                for (i = 1; i < nbatch; i++) {
+                        if (list_empty (&batches[i].list))
+                                continue;
+                        list_move_tail (&batches[i].list, &mine);
                 }
-#endif
+        }
+        pthread_mutex_unlock (&priv->rdp_mutex);
+
+        list_for_each_entry_safe (batch, tmp, &mine, list) {
+                list_del_init (&batch->list);
+                posix_readdirp_fill_batch (batch);
+                pthread_mutex_lock (&sync.mutex);
+                {
+                        sync.pending--;
+                }
+                pthread_mutex_unlock (&sync.mutex);
+        }
+
+        pthread_mutex_lock (&sync.mutex);
+        {
+                while (sync.pending > 0)
+                        pthread_cond_wait (&sync.cond, &sync.mutex);
+        }
+        pthread_mutex_unlock (&sync.mutex);
+
+        pthread_cond_destroy (&sync.cond);
+        pthread_mutex_destroy (&sync.mutex);
 
-		inode = NULL;
+        for (i = 1; i < nbatch; i++) {
+                if (batches[i].dict)
+                        dict_unref (batches[i].dict);
+        }
+
+        GF_FREE (array);
+        GF_FREE (batches);
+
+        return 0;
+err:
+        for (i = 1; i < nbatch; i++) {
+                if (batches[i].dict)
+                        dict_unref (batches[i].dict);
+        }
+
+        pthread_cond_destroy (&sync.cond);
+        pthread_mutex_destroy (&sync.mutex);
+
+        GF_FREE (array);
+        GF_FREE (batches);
+
+        return -1;
+}
+
+
+int
+posix_readdirp_fill (xlator_t *this, fd_t *fd, gf_dirent_t *entries, dict_t *dict)
+{
+        struct posix_private *priv    = NULL;
+        gf_dirent_t     *entry    = NULL;
+	char            *hpath    = NULL;
+	int              len      = 0;
+        int              count    = 0;
+
+	if (list_empty(&entries->list))
+		return 0;
+
+        priv = this->private;
+
+	len = posix_handle_path (this, fd->inode->gfid, NULL, NULL, 0);
+        if (len <= 0)
+                return -1;
+	hpath = alloca (len + 256); /* NAME_MAX */
+	if (posix_handle_path (this, fd->inode->gfid, NULL, hpath, len) <= 0)
+                return -1;
+	len = strlen (hpath);
+	hpath[len] = '/';
+
+        if (priv->rdp_thread_count) {
+                list_for_each_entry (entry, &entries->list, list)
+                        count++;
+
+                if ((count >= 2 * POSIX_RDP_BATCH_MIN) &&
+                    (posix_readdirp_fill_parallel (this, fd, entries, count,
+                                                   dict, hpath, len) == 0))
+                        return 0;
+        }
+
+        list_for_each_entry (entry, &entries->list, list) {
+                posix_readdirp_fill_entry (this, fd, entry, dict, hpath, len);
         }
 
 	return 0;
@@ -6379,6 +6609,8 @@ posix_priv (xlator_t *this)
         gf_proc_dump_write("max_read","%d", priv->read_value);
         gf_proc_dump_write("max_write","%d", priv->write_value);
         gf_proc_dump_write("nr_files","%ld", priv->nr_files);
+        posix_hpath_cache_dump (this);
+        posix_xattr_cache_dump (this);
 
         return 0;
 }
@@ -6602,6 +6834,9 @@ set_xattr_user_namespace_mode (struct posix_private *priv, const char *str)
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
+        uint32_t              rdp_threads = 0;
+        uint32_t              hpath_limit = 0;
+        uint64_t              xattr_limit = 0;
 	int                   ret = -1;
 struct posix_private *priv = NULL;
         int32_t               uid = -1;
@@ -6668,6 +6903,18 @@ struct posix_private *priv = NULL;
                           options, uint32, out);
         posix_spawn_health_check_thread (this);
 
+        GF_OPTION_RECONF ("readdirp-threads", rdp_threads, options, uint32,
+                          out);
+        posix_spawn_readdirp_threads (this, rdp_threads);
+
+        GF_OPTION_RECONF ("dir-handle-cache-size", hpath_limit, options,
+                          uint32, out);
+        posix_hpath_cache_set_limit (this, hpath_limit);
+
+        GF_OPTION_RECONF ("xattr-cache-size", xattr_limit, options,
+                          size_uint64, out);
+        posix_xattr_cache_set_limit (this, xattr_limit);
+
 	ret = 0;
 out:
 	return ret;
@@ -6763,6 +7010,9 @@ init (xlator_t *this)
         int32_t               uid           = -1;
         int32_t               gid           = -1;
 	char                 *batch_fsync_mode_str;
+        uint32_t              rdp_threads   = 0;
+        uint32_t              hpath_limit   = 0;
+        uint64_t              xattr_limit   = 0;
 
         dir_data = dict_get (this->options, "directory");
 
@@ -7197,6 +7447,25 @@ init (xlator_t *this)
 	pthread_cond_init (&_private->fsync_cond, NULL);
 	INIT_LIST_HEAD (&_private->fsyncs);
 
+        pthread_mutex_init (&_private->rdp_mutex, NULL);
+        pthread_cond_init (&_private->rdp_cond, NULL);
+        INIT_LIST_HEAD (&_private->rdp_batches);
+
+        GF_OPTION_INIT ("readdirp-threads", rdp_threads, uint32, out);
+        posix_spawn_readdirp_threads (this, rdp_threads);
+
+        GF_OPTION_INIT ("dir-handle-cache-size", hpath_limit, uint32, out);
+        if (posix_hpath_cache_init (this, hpath_limit)) {
+                ret = -1;
+                goto out;
+        }
+
+        GF_OPTION_INIT ("xattr-cache-size", xattr_limit, size_uint64, out);
+        if (posix_xattr_cache_init (this, xattr_limit)) {
+                ret = -1;
+                goto out;
+        }
+
 	ret = gf_thread_create (&_private->fsyncer, NULL, posix_fsyncer, this);
 	if (ret) {
 		gf_msg (this->name, GF_LOG_ERROR, errno,
@@ -7241,6 +7510,9 @@ fini (xlator_t *this)
         struct posix_private *priv = this->private;
         if (!priv)
                 return;
+        posix_stop_readdirp_threads (this);
+        posix_hpath_cache_destroy (this);
+        posix_xattr_cache_destroy (this);
         this->private = NULL;
         /*unlock brick dir*/
         if (priv->mount_lock)
@@ -7373,6 +7645,33 @@ struct volume_options options[] = {
           .description = "Interval in seconds for a filesystem health check, "
                          "set to 0 to disable"
         },
+        { .key = {"readdirp-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = POSIX_RDP_THREADS_MAX,
+          .default_value = "4",
+          .description = "Number of threads stating and fetching the xattrs "
+                         "of the entries of large readdirp replies in "
+                         "parallel, 0 fills them in the thread of the fop."
+        },
+        { .key = {"dir-handle-cache-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .default_value = "8192",
+          .validate = GF_OPT_VALIDATE_MIN,
+          .description = "Number of directories whose real path is kept in "
+                         "memory, saving the readlink of every handle up to "
+                         "the root when their gfid handle is resolved. 0 "
+                         "disables the cache."
+        },
+        { .key = {"xattr-cache-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .default_value = "16MB",
+          .description = "Memory used to keep the extended attributes of "
+                         "the inodes of the brick, saving the getxattrs of "
+                         "lookups asking for them. 0 disables the cache."
+        },
 	{ .key = {"batch-fsync-mode"},
 	  .type = GF_OPTION_TYPE_STR,
 	  .default_value = "reverse-fsync",
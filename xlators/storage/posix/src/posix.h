@@ -60,6 +60,8 @@
                                                + SLEN(GF_HIDDEN_PATH) + SLEN("/") \
                                                + SLEN("00/")            \
                                                + SLEN("00/") + SLEN(UUID0_STR) + 1) /* '\0' */;
+#define POSIX_RDP_THREADS_MAX   32
+
 #define GF_UNLINK_TRUE 0x0000000000000001
 #define GF_UNLINK_FALSE 0x0000000000000000
 
@@ -77,6 +79,41 @@ struct posix_fd {
 };
 
 
+/* xattrs of an inode, in the ctx of the inode. The names of all of them
+ * are kept, the values of the "trusted." ones only: those are the ones the
+ * cluster xlators ask for on every lookup. Any xattr, in any namespace, is
+ * only written by this xlator: by setxattr, removexattr and xattrop, and
+ * internally (the gfid, the pgfid link counts, the xattrs and acls of a new
+ * entry). Each of those writes drops or updates the cached xattrs.
+ */
+typedef struct posix_xattr_val {
+        struct list_head  list;
+        char             *key;
+        int32_t           len;
+        char              value[];
+} posix_xattr_val_t;
+
+typedef struct posix_xattr_ctx {
+        struct list_head  lru;
+        gf_boolean_t      valid;
+        /* bumped by every change, a fill started before it is dropped */
+        uint64_t          gen;
+        char             *names;
+        ssize_t           names_size;
+        struct list_head  values;
+        size_t            size;
+} posix_xattr_ctx_t;
+
+typedef struct posix_xattr_cache {
+        gf_lock_t         lock;
+        struct list_head  lru;
+        uint64_t          size;
+        uint64_t          limit;
+        uint64_t          hits;
+        uint64_t          misses;
+        uint64_t          evictions;
+} posix_xattr_cache_t;
+
 struct posix_private {
 	char   *base_path;
 	int32_t base_path_length;
@@ -166,6 +203,17 @@ struct posix_private {
         pthread_t       health_check;
         gf_boolean_t    health_check_active;
 
+        posix_hpath_cache_t *hpath_cache;
+        posix_xattr_cache_t *xattr_cache;
+
+        /* threads sharing the stat and xattr work of large readdirps */
+        uint32_t          rdp_thread_count;
+        pthread_t         rdp_threads[POSIX_RDP_THREADS_MAX];
+        struct list_head  rdp_batches;
+        pthread_mutex_t   rdp_mutex;
+        pthread_cond_t    rdp_cond;
+        gf_boolean_t      rdp_stop;
+
 #ifdef GF_DARWIN_HOST_OS
         enum {
                 XATTR_NONE = 0,
@@ -188,8 +236,33 @@ typedef struct {
         int          fdnum;
         int          flags;
         int32_t     op_errno;
+        /* names of the xattrs present on the file, if listed upfront */
+        char        *xattr_list;
+        ssize_t      xattr_list_size;
+        posix_xattr_ctx_t *xctx;
 } posix_xattr_filler_t;
 
+/* entries of a readdirp are split in batches, filled in parallel by the
+ * readdirp threads and the thread of the fop itself
+ */
+struct posix_rdp_sync {
+        pthread_mutex_t         mutex;
+        pthread_cond_t          cond;
+        int                     pending;
+};
+
+typedef struct posix_rdp_batch {
+        struct list_head        list;
+        xlator_t               *this;
+        fd_t                   *fd;
+        dict_t                 *dict;
+        const char             *dir_path;
+        int                     dir_len;
+        gf_dirent_t           **entries;
+        int                     count;
+        struct posix_rdp_sync  *sync;
+} posix_rdp_batch_t;
+
 #define POSIX_BASE_PATH(this) (((struct posix_private *)this->private)->base_path)
 
 #define POSIX_BASE_PATH_LEN(this) (((struct posix_private *)this->private)->base_path_length)
@@ -253,6 +326,31 @@ void
 __posix_fd_set_odirect (fd_t *fd, struct posix_fd *pfd, int opflags,
 			off_t offset, size_t size);
 void posix_spawn_health_check_thread (xlator_t *this);
+int posix_spawn_readdirp_threads (xlator_t *this, uint32_t count);
+void posix_stop_readdirp_threads (xlator_t *this);
+void posix_readdirp_fill_batch (posix_rdp_batch_t *batch);
+
+int posix_xattr_cache_init (xlator_t *this, uint64_t limit);
+void posix_xattr_cache_set_limit (xlator_t *this, uint64_t limit);
+void posix_xattr_cache_destroy (xlator_t *this);
+void posix_xattr_cache_dump (xlator_t *this);
+posix_xattr_ctx_t *posix_xattr_ctx_get (xlator_t *this, inode_t *inode);
+void posix_xattr_ctx_release (xlator_t *this, uint64_t ctx);
+int posix_xattr_cache_fill (xlator_t *this, posix_xattr_ctx_t *xctx,
+                            const char *real_path, int fdnum);
+ssize_t posix_xattr_cache_list (xlator_t *this, posix_xattr_ctx_t *xctx,
+                                char *list, size_t size);
+int posix_xattr_cache_get (xlator_t *this, posix_xattr_ctx_t *xctx,
+                           const char *key, dict_t *dict);
+ssize_t posix_xattr_cache_read (xlator_t *this, posix_xattr_ctx_t *xctx,
+                                const char *key, void *value, size_t size);
+void posix_xattr_cache_update (xlator_t *this, posix_xattr_ctx_t *xctx,
+                               const char *key, const void *value,
+                               int32_t len);
+void posix_xattr_ctx_invalidate (xlator_t *this, posix_xattr_ctx_t *xctx);
+void posix_xattr_cache_invalidate (xlator_t *this, inode_t *inode);
+void posix_xattr_cache_invalidate_entry (xlator_t *this, loc_t *loc,
+                                         dict_t *xdata);
 
 void *posix_fsyncer (void *);
 int